@@ -14,7 +14,6 @@
 #include "CS1.h"
 #include "Keys.h"
 #include "KeyDebounce.h"
-#include "KIN1.h"
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
   #include "Shell.h"
@@ -112,59 +111,8 @@ void APP_EventHandler(EVNT_Handle event) {
 }
 #endif /* PL_CONFIG_HAS_EVENTS */
 
-static const KIN1_UID RoboIDs[] = {
-  /* 0: L20, V2 */ {{0x00,0x03,0x00,0x00,0x67,0xCD,0xB7,0x21,0x4E,0x45,0x32,0x15,0x30,0x02,0x00,0x13}},
-  /* 1: L21, V2 */ {{0x00,0x05,0x00,0x00,0x4E,0x45,0xB7,0x21,0x4E,0x45,0x32,0x15,0x30,0x02,0x00,0x13}},
-  /* 2: L4, V1  */ {{0x00,0x0B,0xFF,0xFF,0x4E,0x45,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x24}}, /* revert right motor */
-  /* 3: L23, V2 */ {{0x00,0x0A,0x00,0x00,0x67,0xCD,0xB8,0x21,0x4E,0x45,0x32,0x15,0x30,0x02,0x00,0x13}}, /* revert left & right motor */
-  /* 4: L11, V2 */ {{0x00,0x19,0x00,0x00,0x67,0xCD,0xB9,0x11,0x4E,0x45,0x32,0x15,0x30,0x02,0x00,0x13}}, /* revert right encoder, possible damaged motor driver? */
-  /* 5: L4, V1 */  {{0x00,0x0B,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x24}},
-  /* 6: L6, V1 */  {{0x00,0x17,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x06}},
-  /* 1: L1, V1 */  {{0x00,0x19,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x25}},
-};
-
 static void APP_AdoptToHardware(void) {
-  KIN1_UID id;
-  uint8_t res;
-
-  res = KIN1_UIDGet(&id);
-  if (res!=ERR_OK) {
-    for(;;); /* error */
-  }
-#if PL_CONFIG_HAS_MOTOR
-  if (KIN1_UIDSame(&id, &RoboIDs[2])) { /* L4 */
-    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE); /* revert left motor */
-    (void)Q4CLeft_SwapPins(TRUE);
-    (void)Q4CRight_SwapPins(TRUE);
-  } else if (KIN1_UIDSame(&id, &RoboIDs[0])) { /* L20 */
-    (void)Q4CRight_SwapPins(TRUE);
-    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE); /* revert left motor */
-    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), TRUE); /* revert left motor */
-  } else if (KIN1_UIDSame(&id, &RoboIDs[3])) { /* L23 */
-    (void)Q4CRight_SwapPins(TRUE);
-    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE); /* revert left motor */
-    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), TRUE); /* revert left motor */
-  } else if (KIN1_UIDSame(&id, &RoboIDs[4])) { /* L11 */
-    (void)Q4CRight_SwapPins(TRUE);
-  } else if (KIN1_UIDSame(&id, &RoboIDs[5])) { /* L4 */
-    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE); /* revert left motor */
-    (void)Q4CLeft_SwapPins(TRUE);
-    (void)Q4CRight_SwapPins(TRUE);
-
-    // Robot L1 und L6 of Team Herger & Kissling
-  } else if (KIN1_UIDSame(&id, &RoboIDs[6])) { /* L6 */
-      MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE); /* revert left motor */
-      MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), FALSE); /* revert right motor */
-      (void)Q4CLeft_SwapPins(TRUE);
-      (void)Q4CRight_SwapPins(TRUE);
-
-  } else if (KIN1_UIDSame(&id, &RoboIDs[7])) { /* L1 */
-	    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE); /* revert left motor */
-	    MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), FALSE); /* revert right motor */
-	    (void)Q4CLeft_SwapPins(TRUE);
-	    (void)Q4CRight_SwapPins(TRUE);
-  }
-#endif
+  /* motor and encoder wiring: see HwProfile.c */
 #if PL_CONFIG_HAS_QUADRATURE && PL_CONFIG_BOARD_IS_ROBO_V2
   /* pull-ups for Quadrature Encoder Pins */
   PORT_PDD_SetPinPullSelect(PORTC_BASE_PTR, 10, PORT_PDD_PULL_UP);
@@ -235,8 +183,7 @@ void APP_Start(void) {
 	  //KEY_Scan();
 
 	  //#Lab 18 Debouncing
-	  // Polling Key
-	  KEYDBNC_Process(); // Falls ein Button gedrckt wird, wird mit dieser Funktion entprellt
+	  // Keys werden im Timer Interrupt abgetastet und entprellt, siehe KEYDBNC_AddTick()
 
 	#else
 	  #error "One board type has to be defined in Platform_Local.h!"
@@ -0,0 +1,627 @@
+/**
+ * \file
+ * \brief Localisation of the robot on the sumo arena, see ArenaLoc.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The filter is computed with integers only: particle positions in 1/16 mm, angles as binary angles
+ * (65536 per turn) and sine/cosine as Q15 values, as in Obstacle.c. Each particle has its own error of the
+ * odometry (distance and turn scale), drawn at the start and inherited by resampling, so the particles
+ * which survive the edge events are the ones with the right calibration. The likelihood of a measurement
+ * is 256 up to a tolerance of the predicted position and drops linearly with the distance beyond it.
+ * The distances to the circle are approximated with (r^2-R^2)/(2R), which is exact enough close to the
+ * edge, where it matters, and needs no square root.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ARENA_LOC
+#include "ArenaLoc.h"
+#include "Reflectance.h"
+#include "FRTOS1.h"
+#include "CLS1.h"
+#include "UTIL1.h"
+#include "CS1.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_HAS_TOF_SENSOR
+  #include "Distance.h"
+  #include "VL6180X.h"
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+  #define ALOC_COUNTS_PER_M       ((int32_t)HWP_Get()->countsPerM)
+#else
+  #define ALOC_COUNTS_PER_M       ALOC_CONFIG_COUNTS_PER_M
+#endif
+
+#define ALOC_Q                    16  /* particle positions in 1/16 mm */
+#define ALOC_ANGLE_FROM_DEG(deg)  ((uint16_t)(((int32_t)(deg)*65536)/360))
+#define ALOC_ANGLE_TO_DEG(a)      ((int16_t)(((int32_t)(int16_t)(a)*360)/65536))
+#define ALOC_BORDER_RADIUS_MM     (ALOC_CONFIG_ARENA_RADIUS_MM-ALOC_CONFIG_BORDER_MM) /* start of the white border */
+#define ALOC_WHITE_VAL            0x60 /* calibrated values below it are white, as in REF_GetLineKind() */
+#define ALOC_REF_TOLERANCE_MM     8    /* sensor spot size and calibration: no penalty up to this distance */
+#define ALOC_REF_SLOPE            8    /* likelihood drop per mm beyond the tolerance */
+#define ALOC_REF_MIN_LIKELIHOOD   8    /* a single wrong sensor reading does not kill a particle */
+#define ALOC_TOF_MARGIN_MM        60   /* the target seen may be this much off the arena: opponent pushed over the edge, range noise */
+#define ALOC_TOF_SLOPE            2
+#define ALOC_TOF_MIN_LIKELIHOOD   64   /* ranges are repeated until the next measurement, so they count less */
+#define ALOC_ODO_ERROR            13   /* maximum odometry scale error of a particle in 1/128, about 10% */
+#define ALOC_STEP_NOISE_MM        2    /* random position error per update and driven 16 mm */
+#define ALOC_STEP_NOISE_ANGLE     ALOC_ANGLE_FROM_DEG(1) /* random heading error per update and driven 16 mm */
+#define ALOC_SLIP_NOISE           2    /* random position error per update in multiples of the slip */
+#define ALOC_LOST_LIKELIHOOD      32   /* mean likelihood below it: the particles are off, spread them again */
+#define ALOC_RECOVER_MM           40   /* spread of the particles added on a recovery */
+#define ALOC_RECOVER_DEG          20
+
+typedef struct {
+  int16_t x, y;         /* position of the robot center in 1/16 mm */
+  uint16_t theta;       /* heading as binary angle */
+  uint16_t w;           /* weight, the mean is 256 after each update */
+  int8_t distErr;       /* odometry scale error of the driven distance in 1/128 */
+  int8_t turnErr;       /* odometry scale error of the turn in 1/128 */
+} ALOC_Particle;
+
+static ALOC_Particle ALOC_Particles[ALOC_CONFIG_NOF_PARTICLES], ALOC_Resampled[ALOC_CONFIG_NOF_PARTICLES];
+static ALOC_Pose ALOC_Estimate; /* result of the last update */
+static bool ALOC_IsOn = FALSE, ALOC_StartRequest = FALSE;
+static int32_t ALOC_LastLeft, ALOC_LastRight; /* encoder counters of the last update */
+static int32_t ALOC_LastDs; /* distance the robot has moved in the last update */
+static uint32_t ALOC_Seed = 0x12345678;
+static int16_t ALOC_StartX = ALOC_CONFIG_START_X_MM, ALOC_StartY = 0, ALOC_StartDeg = ALOC_CONFIG_START_DEG;
+static uint16_t ALOC_NofResamples, ALOC_NofRecoveries;
+static struct {
+  bool seen;
+  int16_t x, y;         /* target in the frame of the arena, mm */
+  TickType_t tick;
+} ALOC_Opponent;
+
+/* sin(0..90 degree) in Q15, 64 steps */
+static const int16_t ALOC_SinTable[65] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512,
+  10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868,
+  19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811, 25329, 25832, 26319,
+  26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113,
+  31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767,
+};
+
+/* sine of a binary angle in Q15, linear interpolation of the table */
+static int32_t ALOC_Sin(uint16_t a) {
+  uint16_t q = a&0x3fff; /* angle in the quadrant */
+  int32_t idx, frac, val;
+
+  if (a&0x4000) { /* 2nd and 4th quadrant: mirrored */
+    q = (uint16_t)(0x4000-q);
+  }
+  idx = q>>8;
+  frac = q&0xff;
+  val = ALOC_SinTable[idx];
+  if (idx<64) {
+    val += ((ALOC_SinTable[idx+1]-val)*frac)/256;
+  }
+  return (a&0x8000) ? -val : val;
+}
+
+static int32_t ALOC_Cos(uint16_t a) {
+  return ALOC_Sin((uint16_t)(a+0x4000));
+}
+
+/* binary angle of a vector, see OBST_Atan2() */
+static uint16_t ALOC_Atan2(int32_t y, int32_t x) {
+  int32_t ax = x<0 ? -x : x, ay = y<0 ? -y : y, z;
+  uint16_t a;
+
+  if (ax==0 && ay==0) {
+    return 0;
+  }
+  if (ax>=ay) {
+    z = (ay*32768)/ax; /* Q15, 0..1 */
+    a = (uint16_t)((8192*z+2847*((z*(32768-z))/32768))/32768);
+  } else {
+    z = (ax*32768)/ay;
+    a = (uint16_t)(0x4000-(8192*z+2847*((z*(32768-z))/32768))/32768);
+  }
+  if (x<0) {
+    a = (uint16_t)(0x8000-a);
+  }
+  if (y<0) {
+    a = (uint16_t)(-a);
+  }
+  return a;
+}
+
+static uint16_t ALOC_Sqrt(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)res;
+}
+
+/* pseudo random number generator (LCG), 16 random bits */
+static uint16_t ALOC_Rand(void) {
+  ALOC_Seed = ALOC_Seed*1664525UL+1013904223UL;
+  return (uint16_t)(ALOC_Seed>>16);
+}
+
+/* random value in -range..range, triangular distribution */
+static int32_t ALOC_Noise(int32_t range) {
+  uint16_t r = ALOC_Rand();
+
+  return (((int32_t)(r&0xff)+(int32_t)(r>>8)-255)*range)/255;
+}
+
+/* likelihood 0..256 of a measurement which is errMm off the prediction */
+static int32_t ALOC_Likelihood(int32_t errMm, int32_t toleranceMm, int32_t slope, int32_t min) {
+  int32_t l;
+
+  if (errMm<=toleranceMm) {
+    return 256;
+  }
+  l = 256-(errMm-toleranceMm)*slope;
+  return l<min ? min : l;
+}
+
+/* signed distance of a point (1/16 mm) to a circle (mm), positive outside */
+static int32_t ALOC_CircleDistMm(int32_t x, int32_t y, int32_t radiusMm) {
+  return ((x*x+y*y)/(ALOC_Q*ALOC_Q)-radiusMm*radiusMm)/(2*radiusMm);
+}
+
+static void ALOC_Spread(ALOC_Particle *p, int32_t rangeMm, int32_t rangeDeg) {
+  p->x = (int16_t)(p->x+ALOC_Noise(rangeMm*ALOC_Q));
+  p->y = (int16_t)(p->y+ALOC_Noise(rangeMm*ALOC_Q));
+  p->theta = (uint16_t)(p->theta+ALOC_Noise(ALOC_ANGLE_FROM_DEG(rangeDeg)));
+}
+
+/* all particles around the start pose */
+static void ALOC_InitParticles(void) {
+  ALOC_Particle *p;
+  int i;
+
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    p = &ALOC_Particles[i];
+    p->x = (int16_t)(ALOC_StartX*ALOC_Q);
+    p->y = (int16_t)(ALOC_StartY*ALOC_Q);
+    p->theta = ALOC_ANGLE_FROM_DEG(ALOC_StartDeg);
+    p->w = 256;
+    p->distErr = (int8_t)ALOC_Noise(ALOC_ODO_ERROR);
+    p->turnErr = (int8_t)ALOC_Noise(ALOC_ODO_ERROR);
+    ALOC_Spread(p, ALOC_CONFIG_START_SPREAD_MM, ALOC_CONFIG_START_SPREAD_DEG);
+  }
+  ALOC_LastLeft = Q4CLeft_GetPos();
+  ALOC_LastRight = Q4CRight_GetPos();
+  ALOC_LastDs = 0;
+  ALOC_Opponent.seen = FALSE;
+  ALOC_NofResamples = 0;
+  ALOC_NofRecoveries = 0;
+}
+
+/* moves the particles with the odometry since the last update */
+static void ALOC_Move(void) {
+  int32_t left = Q4CLeft_GetPos(), right = Q4CRight_GetPos();
+  int32_t dl, dr, ds, dTheta, s, th, absS, noise, slip, maxStep;
+  uint16_t mid;
+  ALOC_Particle *p;
+  int i;
+
+  dl = left-ALOC_LastLeft;
+  dr = right-ALOC_LastRight;
+  ALOC_LastLeft = left;
+  ALOC_LastRight = right;
+  ds = ((dl+dr)*(500*ALOC_Q))/ALOC_COUNTS_PER_M; /* 1/16 mm */
+  /* the robot does not accelerate faster than the traction allows, the tracks slip (e.g. the shovel jerk, reversing at the edge) */
+  maxStep = (ALOC_CONFIG_MAX_ACCEL_MM_S2*ALOC_Q*ALOC_CONFIG_PERIOD_MS*ALOC_CONFIG_PERIOD_MS)/1000000;
+  slip = ds;
+  if (ds>ALOC_LastDs+maxStep) {
+    ds = ALOC_LastDs+maxStep;
+  } else if (ds<ALOC_LastDs-maxStep) {
+    ds = ALOC_LastDs-maxStep;
+  }
+  ALOC_LastDs = ds;
+  slip -= ds;
+  if (dl==0 && dr==0 && ds==0) {
+    return;
+  }
+  dTheta = ((dr-dl)*10430)/ALOC_CONFIG_TRACK_COUNTS; /* 65536/(2*pi) binary angle per radian */
+  absS = ds<0 ? -ds : ds;
+  noise = absS/ALOC_Q+1; /* random error grows with the driven distance and the slip */
+  slip = (slip<0 ? -slip : slip)*ALOC_SLIP_NOISE;
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    p = &ALOC_Particles[i];
+    s = ds+(ds*p->distErr)/128+ALOC_Noise((ALOC_STEP_NOISE_MM*noise*ALOC_Q)/16+slip+1);
+    th = dTheta+(dTheta*p->turnErr)/128+ALOC_Noise((ALOC_STEP_NOISE_ANGLE*noise)/16+1);
+    mid = (uint16_t)(p->theta+th/2); /* translation along the mean heading */
+    p->x = (int16_t)(p->x+(s*ALOC_Cos(mid))/32768);
+    p->y = (int16_t)(p->y+(s*ALOC_Sin(mid))/32768);
+    p->theta = (uint16_t)(p->theta+th);
+  }
+}
+
+/* multiplies the weights with the reflectance likelihood, returns the sum of the likelihoods */
+static int32_t ALOC_WeightReflectance(void) {
+  uint16_t val[REF_NOF_SENSORS];
+  int32_t c, s, sx, sy, err, worst, sum = 0, l, offs[REF_NOF_SENSORS];
+  ALOC_Particle *p;
+  int i, j;
+
+  REF_GetSensorValues(val, REF_NOF_SENSORS);
+  for(j=0;j<REF_NOF_SENSORS;j++) { /* IR1 is the left sensor */
+    offs[j] = ((REF_NOF_SENSORS-1-2*j)*ALOC_CONFIG_SENSOR_PITCH_UM*ALOC_Q)/2000;
+  }
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    p = &ALOC_Particles[i];
+    c = ALOC_Cos(p->theta);
+    s = ALOC_Sin(p->theta);
+    worst = 0;
+    for(j=0;j<REF_NOF_SENSORS;j++) {
+      sx = p->x+(ALOC_CONFIG_SENSOR_AHEAD_MM*ALOC_Q*c-offs[j]*s)/32768;
+      sy = p->y+(ALOC_CONFIG_SENSOR_AHEAD_MM*ALOC_Q*s+offs[j]*c)/32768;
+      err = ALOC_CircleDistMm(sx, sy, ALOC_BORDER_RADIUS_MM);
+      if (val[j]<ALOC_WHITE_VAL) { /* white: must be outside of the border, black inside */
+        err = -err;
+      }
+      if (err>worst) {
+        worst = err;
+      }
+    }
+    l = ALOC_Likelihood(worst, ALOC_REF_TOLERANCE_MM, ALOC_REF_SLOPE, ALOC_REF_MIN_LIKELIHOOD);
+    p->w = (uint16_t)((p->w*l)/256);
+    sum += l;
+  }
+  return sum;
+}
+
+#if PL_HAS_TOF_SENSOR
+/* multiplies the weights with the likelihood of a target of a ToF sensor: the opponent must be on the arena */
+static void ALOC_WeightRange(DIST_Sensor sensor) {
+  DIST_SensorMount mount;
+  VL6180X_Range range;
+  uint16_t heading;
+  int32_t tx, ty, c, s, l;
+  ALOC_Particle *p;
+  int i;
+  CS1_CriticalVariable()
+
+  if (DIST_GetSensorMount(sensor, &mount)!=ERR_OK || DIST_GetRange(sensor, &range)!=ERR_OK) {
+    return; /* not fitted or not ready */
+  }
+  if (range.status!=VL6180X_RANGE_STATUS_OK) {
+    return; /* no target: the opponent is somewhere else, the arena has no walls */
+  }
+  heading = ALOC_ANGLE_FROM_DEG(mount.headingDeg);
+  tx = (mount.xMm+(range.mm*ALOC_Cos(heading))/32768)*ALOC_Q; /* target relative to the robot */
+  ty = (mount.yMm+(range.mm*ALOC_Sin(heading))/32768)*ALOC_Q;
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    p = &ALOC_Particles[i];
+    c = ALOC_Cos(p->theta);
+    s = ALOC_Sin(p->theta);
+    l = ALOC_Likelihood(ALOC_CircleDistMm(p->x+(tx*c-ty*s)/32768, p->y+(tx*s+ty*c)/32768, ALOC_CONFIG_ARENA_RADIUS_MM),
+          ALOC_TOF_MARGIN_MM, ALOC_TOF_SLOPE, ALOC_TOF_MIN_LIKELIHOOD);
+    p->w = (uint16_t)((p->w*l)/256);
+  }
+  /* where the opponent is, with the pose of the last update */
+  c = ALOC_Cos(ALOC_ANGLE_FROM_DEG(ALOC_Estimate.headingDeg));
+  s = ALOC_Sin(ALOC_ANGLE_FROM_DEG(ALOC_Estimate.headingDeg));
+  CS1_EnterCritical();
+  ALOC_Opponent.x = (int16_t)(ALOC_Estimate.xMm+(tx*c-ty*s)/(32768*ALOC_Q));
+  ALOC_Opponent.y = (int16_t)(ALOC_Estimate.yMm+(tx*s+ty*c)/(32768*ALOC_Q));
+  ALOC_Opponent.tick = xTaskGetTickCount();
+  ALOC_Opponent.seen = TRUE;
+  CS1_ExitCritical();
+}
+#endif
+
+/* low variance resampling, with a random error added to the copies */
+static void ALOC_Resample(uint32_t sumW, int32_t spreadMm, int32_t spreadDeg) {
+  uint32_t step = sumW/ALOC_CONFIG_NOF_PARTICLES, pos, cum;
+  int i, j;
+
+  if (step==0) {
+    return;
+  }
+  pos = ALOC_Rand()%step;
+  cum = ALOC_Particles[0].w;
+  j = 0;
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    while (pos>=cum && j<ALOC_CONFIG_NOF_PARTICLES-1) {
+      j++;
+      cum += ALOC_Particles[j].w;
+    }
+    ALOC_Resampled[i] = ALOC_Particles[j];
+    ALOC_Resampled[i].w = 256;
+    ALOC_Spread(&ALOC_Resampled[i], spreadMm, spreadDeg);
+    pos += step;
+  }
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    ALOC_Particles[i] = ALOC_Resampled[i];
+  }
+}
+
+/* normalizes the weights to a mean of 256 and resamples if only a few particles carry the weight */
+static void ALOC_Normalize(int32_t sumLikelihood) {
+  uint32_t sumW = 0, sumSq = 0, w;
+  bool lost;
+  int i;
+
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    sumW += ALOC_Particles[i].w;
+  }
+  lost = sumLikelihood<ALOC_LOST_LIKELIHOOD*ALOC_CONFIG_NOF_PARTICLES;
+  if (sumW==0) { /* all particles off */
+    for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+      ALOC_Particles[i].w = 256;
+    }
+    sumW = 256*ALOC_CONFIG_NOF_PARTICLES;
+    lost = TRUE;
+  }
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    w = (ALOC_Particles[i].w*(256UL*ALOC_CONFIG_NOF_PARTICLES))/sumW;
+    ALOC_Particles[i].w = (uint16_t)w;
+    sumSq += w*w;
+  }
+  if (lost) { /* a pose far from all particles, e.g. pushed by the opponent */
+    ALOC_Resample(256UL*ALOC_CONFIG_NOF_PARTICLES, ALOC_RECOVER_MM, ALOC_RECOVER_DEG);
+    ALOC_NofRecoveries++;
+  } else if (sumSq>2*256UL*256UL*ALOC_CONFIG_NOF_PARTICLES) { /* effective number of particles (sum w)^2/sum(w^2) below the half */
+    ALOC_Resample(256UL*ALOC_CONFIG_NOF_PARTICLES, 1, 1);
+    ALOC_NofResamples++;
+  }
+}
+
+/* mean pose, spread and distances to the edge */
+static void ALOC_Evaluate(void) {
+  int32_t sumX = 0, sumY = 0, sumC = 0, sumS = 0, dx, dy, b, c, px, py, cs, sn;
+  uint32_t sumW = 0, sumSq = 0;
+  ALOC_Particle *p;
+  ALOC_Pose pose;
+  uint16_t theta;
+  int i;
+  CS1_CriticalVariable()
+
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    p = &ALOC_Particles[i];
+    sumW += p->w;
+    sumX += p->w*p->x;
+    sumY += p->w*p->y;
+    sumC += (p->w*ALOC_Cos(p->theta))/32768; /* small enough for ALOC_Atan2() */
+    sumS += (p->w*ALOC_Sin(p->theta))/32768;
+  }
+  pose.xMm = (int16_t)(sumX/(int32_t)sumW/ALOC_Q);
+  pose.yMm = (int16_t)(sumY/(int32_t)sumW/ALOC_Q);
+  theta = ALOC_Atan2(sumS, sumC);
+  pose.headingDeg = ALOC_ANGLE_TO_DEG(theta);
+  for(i=0;i<ALOC_CONFIG_NOF_PARTICLES;i++) {
+    p = &ALOC_Particles[i];
+    dx = p->x/ALOC_Q-pose.xMm;
+    dy = p->y/ALOC_Q-pose.yMm;
+    sumSq += ((uint32_t)(dx*dx+dy*dy)/16)*p->w;
+  }
+  pose.spreadMm = (int16_t)ALOC_Sqrt((sumSq/sumW)*16);
+  pose.edgeMm = (int16_t)(ALOC_CONFIG_ARENA_RADIUS_MM-ALOC_Sqrt((uint32_t)(pose.xMm*pose.xMm+pose.yMm*pose.yMm)));
+  /* reflectance array to the border straight ahead: |p+t*u|=R, t=-p*u+sqrt((p*u)^2-(|p|^2-R^2)) */
+  cs = ALOC_Cos(theta);
+  sn = ALOC_Sin(theta);
+  px = pose.xMm+(ALOC_CONFIG_SENSOR_AHEAD_MM*cs)/32768;
+  py = pose.yMm+(ALOC_CONFIG_SENSOR_AHEAD_MM*sn)/32768;
+  b = (px*cs+py*sn)/32768;
+  c = px*px+py*py-ALOC_BORDER_RADIUS_MM*ALOC_BORDER_RADIUS_MM;
+  pose.edgeAheadMm = c>=0 ? 0 : (int16_t)(-b+ALOC_Sqrt((uint32_t)(b*b-c)));
+  pose.centerDeg = ALOC_ANGLE_TO_DEG(ALOC_Atan2(-pose.yMm, -pose.xMm)-theta);
+  CS1_EnterCritical();
+  ALOC_Estimate = pose;
+  CS1_ExitCritical();
+}
+
+static void ALOC_Update(void) {
+  int32_t sumL;
+
+  ALOC_Move();
+  sumL = ALOC_WeightReflectance();
+#if PL_HAS_TOF_SENSOR
+  ALOC_WeightRange(DIST_SENSOR_FRONT);
+  ALOC_WeightRange(DIST_SENSOR_LEFT);
+  ALOC_WeightRange(DIST_SENSOR_RIGHT);
+  ALOC_WeightRange(DIST_SENSOR_REAR);
+#endif
+  ALOC_Normalize(sumL);
+  ALOC_Evaluate();
+}
+
+uint8_t ALOC_GetPose(ALOC_Pose *pose) {
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  *pose = ALOC_Estimate;
+  CS1_ExitCritical();
+  if (!ALOC_IsOn || ALOC_StartRequest) {
+    return ERR_DISABLED;
+  }
+  if (pose->spreadMm>ALOC_CONFIG_MAX_SPREAD_MM) {
+    return ERR_NOTAVAIL;
+  }
+  return ERR_OK;
+}
+
+uint8_t ALOC_GetOpponent(int16_t *xMm, int16_t *yMm, uint32_t *ageMs) {
+  CS1_CriticalVariable()
+
+  if (!ALOC_Opponent.seen) {
+    return ERR_NOTAVAIL;
+  }
+  CS1_EnterCritical();
+  *xMm = ALOC_Opponent.x;
+  *yMm = ALOC_Opponent.y;
+  *ageMs = (uint32_t)((xTaskGetTickCount()-ALOC_Opponent.tick)*portTICK_PERIOD_MS);
+  CS1_ExitCritical();
+  return ERR_OK;
+}
+
+bool ALOC_IsInCenter(void) {
+  ALOC_Pose pose;
+
+  return ALOC_GetPose(&pose)==ERR_OK && pose.edgeMm>=ALOC_CONFIG_ARENA_RADIUS_MM-ALOC_CONFIG_CENTER_MM;
+}
+
+void ALOC_Start(void) {
+  ALOC_StartRequest = TRUE; /* the task initializes the particles */
+  ALOC_IsOn = TRUE;
+}
+
+void ALOC_Stop(void) {
+  ALOC_IsOn = FALSE;
+}
+
+static void ALocTask(void *pvParameters) {
+  TickType_t xLastWakeTime;
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
+
+  (void)pvParameters;
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("ALoc", PROF_PERIOD_DELAY_UNTIL, ALOC_CONFIG_PERIOD_MS);
+#endif
+  xLastWakeTime = xTaskGetTickCount();
+  for(;;) {
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
+    if (ALOC_StartRequest) {
+      ALOC_InitParticles();
+      ALOC_Evaluate();
+      ALOC_StartRequest = FALSE;
+    } else if (ALOC_IsOn && REF_IsReady()) {
+      ALOC_Update();
+    }
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
+    FRTOS1_vTaskDelayUntil(&xLastWakeTime, ALOC_CONFIG_PERIOD_MS/portTICK_PERIOD_MS);
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void ALOC_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"loc", (unsigned char*)"Group of arena localisation commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Start the filter at the start pose, or stop it\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  pose <x> <y> <deg>", (unsigned char*)"Start pose in mm from the center, 0 deg is the x axis\r\n", io->stdOut);
+}
+
+static void ALOC_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  ALOC_Pose pose;
+  int16_t x, y;
+  uint32_t ageMs;
+  uint8_t res;
+
+  CLS1_SendStatusStr((unsigned char*)"loc", (unsigned char*)"\r\n", io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16s(buf, sizeof(buf), ALOC_StartX);
+  UTIL1_chcat(buf, sizeof(buf), ' ');
+  UTIL1_strcatNum16s(buf, sizeof(buf), ALOC_StartY);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, ");
+  UTIL1_strcatNum16s(buf, sizeof(buf), ALOC_StartDeg);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" deg\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  start", buf, io->stdOut);
+  res = ALOC_GetPose(&pose);
+  if (res==ERR_DISABLED) {
+    CLS1_SendStatusStr((unsigned char*)"  pose", (unsigned char*)"off\r\n", io->stdOut);
+    return;
+  }
+  buf[0] = '\0';
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.xMm);
+  UTIL1_chcat(buf, sizeof(buf), ' ');
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.yMm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, ");
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.headingDeg);
+  UTIL1_strcat(buf, sizeof(buf), res==ERR_OK ? (unsigned char*)" deg\r\n" : (unsigned char*)" deg (not sure)\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  pose", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.spreadMm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  spread", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.edgeMm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, ahead ");
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.edgeAheadMm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  edge", buf, io->stdOut);
+  if (ALOC_GetOpponent(&x, &y, &ageMs)==ERR_OK) {
+    buf[0] = '\0';
+    UTIL1_strcatNum16s(buf, sizeof(buf), x);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    UTIL1_strcatNum16s(buf, sizeof(buf), y);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), ageMs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms ago\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"not seen\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  opponent", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16u(buf, sizeof(buf), ALOC_NofResamples);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" resamples, ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), ALOC_NofRecoveries);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" recoveries\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  filter", buf, io->stdOut);
+}
+
+uint8_t ALOC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  const unsigned char *p;
+  int16_t x, y, deg;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"loc help")==0) {
+    ALOC_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"loc status")==0) {
+    ALOC_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"loc start")==0) {
+    ALOC_Start();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"loc stop")==0) {
+    ALOC_Stop();
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"loc pose ", sizeof("loc pose ")-1)==0) {
+    *handled = TRUE;
+    p = cmd+sizeof("loc pose ")-1;
+    if (UTIL1_ScanDecimal16sNumber(&p, &x)!=ERR_OK || UTIL1_ScanDecimal16sNumber(&p, &y)!=ERR_OK
+        || UTIL1_ScanDecimal16sNumber(&p, &deg)!=ERR_OK || x<-ALOC_CONFIG_ARENA_RADIUS_MM || x>ALOC_CONFIG_ARENA_RADIUS_MM
+        || y<-ALOC_CONFIG_ARENA_RADIUS_MM || y>ALOC_CONFIG_ARENA_RADIUS_MM) {
+      CLS1_SendStr((unsigned char*)"*** Wrong pose, e.g. 'loc pose -190 0 0'\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    ALOC_StartX = x;
+    ALOC_StartY = y;
+    ALOC_StartDeg = deg;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void ALOC_Deinit(void) {
+  /* nothing needed */
+}
+
+void ALOC_Init(void) {
+  ALOC_IsOn = FALSE;
+  ALOC_StartRequest = FALSE;
+  ALOC_Estimate.spreadMm = 0;
+  if (xTaskCreate(ALocTask, "ALoc", 600/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, NULL) != pdPASS) {
+    for(;;){} /* error case only, stay here! */
+  }
+}
+
+#endif /* PL_CONFIG_HAS_ARENA_LOC */
@@ -0,0 +1,131 @@
+/**
+ * \file
+ * \brief Interface of the localisation of the robot on the sumo arena.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * A small particle filter estimates the pose of the robot on the circular arena (dohyo): the origin is the
+ * center of the arena, the start pose defines the direction of the x axis (the arena looks the same in
+ * every direction, so only the start pose fixes the frame). Each particle is a pose hypothesis, the filter
+ *   moves them with the wheel encoders, with a random error proportional to the driven distance and turn,
+ *     and no faster than the traction allows: the wheels slip on a jerk or when reversing at the edge,
+ *   weights them with the reflectance sensors: a sensor seeing the white border must be outside
+ *     ALOC_CONFIG_ARENA_RADIUS_MM-ALOC_CONFIG_BORDER_MM, a sensor seeing black inside of it,
+ *   weights them with the ToF ranges: a target is the opponent, which must be on the arena. No target
+ *     means only that the opponent is somewhere else: the arena has no walls, so it tells nothing about the pose,
+ *   resamples them if only a few particles carry the weight.
+ * The result is the mean pose, its spread and the distances to the edge of the arena, which lets the
+ * sumo strategy drive at full speed far from the edge and brake before it.
+ */
+
+#ifndef ARENALOC_H_
+#define ARENALOC_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ARENA_LOC
+
+#ifndef ALOC_CONFIG_NOF_PARTICLES
+  #define ALOC_CONFIG_NOF_PARTICLES     (48)   /*!< number of pose hypotheses */
+#endif
+#ifndef ALOC_CONFIG_PERIOD_MS
+  #define ALOC_CONFIG_PERIOD_MS         (10)   /*!< update period of the filter */
+#endif
+#ifndef ALOC_CONFIG_ARENA_RADIUS_MM
+  #define ALOC_CONFIG_ARENA_RADIUS_MM   (385)  /*!< radius of the arena including the border, 77 cm mini sumo dohyo */
+#endif
+#ifndef ALOC_CONFIG_BORDER_MM
+  #define ALOC_CONFIG_BORDER_MM         (25)   /*!< width of the white border ring */
+#endif
+#ifndef ALOC_CONFIG_START_X_MM
+  #define ALOC_CONFIG_START_X_MM        (-190) /*!< default start position, behind the start line */
+#endif
+#ifndef ALOC_CONFIG_START_DEG
+  #define ALOC_CONFIG_START_DEG         (0)    /*!< default start heading, 0 is facing the center from ALOC_CONFIG_START_X_MM */
+#endif
+#ifndef ALOC_CONFIG_START_SPREAD_MM
+  #define ALOC_CONFIG_START_SPREAD_MM   (40)   /*!< uncertainty of the start position, in each direction */
+#endif
+#ifndef ALOC_CONFIG_START_SPREAD_DEG
+  #define ALOC_CONFIG_START_SPREAD_DEG  (10)   /*!< uncertainty of the start heading, in each direction */
+#endif
+#ifndef ALOC_CONFIG_MAX_SPREAD_MM
+  #define ALOC_CONFIG_MAX_SPREAD_MM     (80)   /*!< above this spread of the particles the pose is not known */
+#endif
+#ifndef ALOC_CONFIG_CENTER_MM
+  #define ALOC_CONFIG_CENTER_MM         (100)  /*!< the robot is in the center of the arena up to this distance */
+#endif
+#ifndef ALOC_CONFIG_COUNTS_PER_M
+  #define ALOC_CONFIG_COUNTS_PER_M      (7350) /*!< quadrature counts per meter of track, if there is no hardware profile */
+#endif
+#ifndef ALOC_CONFIG_TRACK_COUNTS
+  #define ALOC_CONFIG_TRACK_COUNTS      (875)  /*!< effective distance between the tracks in quadrature counts, including the skid (see TURN_STEPS_90) */
+#endif
+#ifndef ALOC_CONFIG_MAX_ACCEL_MM_S2
+  #define ALOC_CONFIG_MAX_ACCEL_MM_S2   (7800) /*!< traction limit of the acceleration, mu*g: faster changes of the wheel speed are slip */
+#endif
+#ifndef ALOC_CONFIG_SENSOR_AHEAD_MM
+  #define ALOC_CONFIG_SENSOR_AHEAD_MM   (45)   /*!< distance of the reflectance array ahead of the wheel axis */
+#endif
+#ifndef ALOC_CONFIG_SENSOR_PITCH_UM
+  #define ALOC_CONFIG_SENSOR_PITCH_UM   (9500) /*!< distance between two reflectance sensors */
+#endif
+
+/*! \brief Estimated pose of the robot */
+typedef struct {
+  int16_t xMm, yMm;     /*!< position of the robot center, the origin is the center of the arena */
+  int16_t headingDeg;   /*!< heading, -180..180, counter-clockwise */
+  int16_t spreadMm;     /*!< standard deviation of the particle positions */
+  int16_t edgeMm;       /*!< distance of the robot center to the outer edge of the arena, negative if off the arena */
+  int16_t edgeAheadMm;  /*!< distance of the reflectance array to the white border, straight ahead, 0 if on it */
+  int16_t centerDeg;    /*!< direction to the center of the arena relative to the heading, -180..180, counter-clockwise */
+} ALOC_Pose;
+
+/*!
+ * \brief Returns the estimated pose.
+ * \param pose Returns the pose, also if the filter is not sure about it.
+ * \return ERR_OK, ERR_DISABLED if the filter is not running, ERR_NOTAVAIL if the spread exceeds ALOC_CONFIG_MAX_SPREAD_MM.
+ */
+uint8_t ALOC_GetPose(ALOC_Pose *pose);
+
+/*!
+ * \brief Returns where the opponent has been seen last.
+ * \param xMm Returns the position of the target in the frame of the arena.
+ * \param yMm Returns the position of the target in the frame of the arena.
+ * \param ageMs Returns the time since it has been seen.
+ * \return ERR_OK, ERR_NOTAVAIL if it has not been seen since the start.
+ */
+uint8_t ALOC_GetOpponent(int16_t *xMm, int16_t *yMm, uint32_t *ageMs);
+
+/*!
+ * \brief Returns if the robot is in the center of the arena.
+ * \return TRUE if the pose is known and closer than ALOC_CONFIG_CENTER_MM to the center.
+ */
+bool ALOC_IsInCenter(void);
+
+/*! \brief Starts the filter at the start pose, call it when the robot is placed for a match */
+void ALOC_Start(void);
+
+/*! \brief Stops the filter */
+void ALOC_Stop(void);
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t ALOC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Driver de-initialization */
+void ALOC_Deinit(void);
+
+/*! \brief Driver initialization */
+void ALOC_Init(void);
+
+#endif /* PL_CONFIG_HAS_ARENA_LOC */
+
+#endif /* ARENALOC_H_ */
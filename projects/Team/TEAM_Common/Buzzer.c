@@ -12,100 +12,168 @@
 #include "BUZ1.h"
 #include "Trigger.h"
 #include "UTIL1.h"
+#include "CS1.h"
+#include <stddef.h> /* for NULL */
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
 #endif
 
-typedef struct {
-  uint16_t buzPeriodTicks; /*!< number of trigger ticks for a PWM period */
-  uint16_t buzIterationCntr; /*!< number of iterations */
-} BUZ_TrgInfo;
+static uint16_t buzPeriodTicks; /*!< number of trigger ticks for a half period */
 
-static volatile BUZ_TrgInfo trgInfo;
+static void BUZ_Toggle(void *dataPtr) {
+  (void)dataPtr;
+  BUZ1_NegVal();
+  (void)TRG_SetTrigger(TRG_BUZ_BEEP, buzPeriodTicks, BUZ_Toggle, NULL);
+}
 
-typedef struct {
-  int freq; /* frequency */
-  int ms; /* milliseconds */
-} BUZ_Tune;
+static void BUZ_ToneOn(uint16_t freqHz, uint8_t volume) {
+  (void)volume; /* no volume control without PWM */
+  buzPeriodTicks = (1000*TRG_TICKS_MS)/freqHz;
+  if (buzPeriodTicks==0) {
+    buzPeriodTicks = 1; /* highest possible frequency */
+  }
+  BUZ1_SetVal();
+  (void)TRG_SetTrigger(TRG_BUZ_BEEP, buzPeriodTicks, BUZ_Toggle, NULL);
+}
+
+static void BUZ_ToneOff(void) {
+  (void)TRG_SetTrigger(TRG_BUZ_BEEP, 0, NULL, NULL); /* NULL callback: cancel trigger */
+  BUZ1_ClrVal(); /* turn buzzer off */
+}
 
 //Fr eine Pause kann man freq = 0 setzen fr eine bestimme Anzahl ms
-//{0,1000} --> 1Sekunde Pause
-static const BUZ_Tune MelodyWelcome[] =
-{ /* freq, ms */
-    {300,500},
-    {500,200},
-    {300,100},
+//{0,1000,0} --> 1Sekunde Pause
+static const BUZ_Note MelodyWelcome[] =
+{ /* freq, ms, volume */
+    {300,500,100},
+    {500,200,100},
+    {300,100,100},
 };
 
-static const BUZ_Tune MelodyButton[] =
-{ /* freq, ms */
-    {200,100},
-    {600,100},
+static const BUZ_Note MelodyButton[] =
+{ /* freq, ms, volume */
+    {200,100,50},
+    {600,100,50},
 };
 
-static const BUZ_Tune MelodyButtonLong[] =
-{ /* freq, ms */
-    {500,50},
-    {100,100},
-    {300,50},
-    {150,50},
-    {450,50},
-    {500,50},
-    {250,200},
+static const BUZ_Note MelodyButtonLong[] =
+{ /* freq, ms, volume */
+    {500,50,100},
+    {100,100,100},
+    {300,50,100},
+    {150,50,100},
+    {450,50,100},
+    {500,50,100},
+    {250,200,100},
 };
 
 typedef struct {
-  int idx; /* current index */
-  int maxIdx; /* maximum index */
-  BUZ_TrgInfo trgInfo;
-  const BUZ_Tune *melody;
+  const BUZ_Note *melody;
+  uint8_t nofNotes;
+  BUZ_Priority prio;
 } MelodyDesc;
 
-static MelodyDesc BUZ_Melodies[] = {
-  {0, sizeof(MelodyWelcome)/sizeof(MelodyWelcome[0]),         {0, 0}, MelodyWelcome}, /* BUZ_TUNE_WELCOME */
-  {0, sizeof(MelodyButton)/sizeof(MelodyButton[0]),           {0, 0}, MelodyButton}, /* BUZ_TUNE_BUTTON */
-  {0, sizeof(MelodyButtonLong)/sizeof(MelodyButtonLong[0]),   {0, 0}, MelodyButtonLong}, /* BUZ_TUNE_BUTTON_LONG */
+static const MelodyDesc BUZ_Melodies[] = {
+  {MelodyWelcome,     sizeof(MelodyWelcome)/sizeof(MelodyWelcome[0]),       BUZ_PRIO_MELODY}, /* BUZ_TUNE_WELCOME */
+  {MelodyButton,      sizeof(MelodyButton)/sizeof(MelodyButton[0]),         BUZ_PRIO_CHIRP},  /* BUZ_TUNE_BUTTON */
+  {MelodyButtonLong,  sizeof(MelodyButtonLong)/sizeof(MelodyButtonLong[0]), BUZ_PRIO_CHIRP},  /* BUZ_TUNE_BUTTON_LONG */
 };
 
-static void BUZ_Toggle(void *dataPtr) {
-  BUZ_TrgInfo *trgInfo = (BUZ_TrgInfo *)dataPtr;
-
-  if (trgInfo->buzIterationCntr==0) {
-    BUZ1_ClrVal(); /* turn buzzer off */
-  } else {
-    trgInfo->buzIterationCntr--;
-    BUZ1_NegVal();
-    (void)TRG_SetTrigger(TRG_BUZ_BEEP, trgInfo->buzPeriodTicks, BUZ_Toggle, trgInfo);
+/*! \brief Sequencer voice, one for each priority */
+typedef struct {
+  const BUZ_Note *notes; /* notes to play, NULL if voice is idle */
+  uint8_t nofNotes; /* number of notes */
+  uint8_t idx; /* index of next note to play */
+} BUZ_Voice;
+
+static BUZ_Voice BUZ_Voices[BUZ_NOF_PRIOS];
+static BUZ_Note BUZ_BeepNote; /* note used by BUZ_Beep() */
+
+/*!
+ * \brief Sequencer step, called once per note: plays the next note of the voice with the highest priority.
+ * \param dataPtr Not used.
+ */
+static void BUZ_NextNote(void *dataPtr) {
+  int prio;
+  BUZ_Voice *voice;
+  const BUZ_Note *note;
+  CS1_CriticalVariable()
+
+  (void)dataPtr;
+  CS1_EnterCritical();
+  for(prio=BUZ_NOF_PRIOS-1;prio>=0;prio--) {
+    voice = &BUZ_Voices[prio];
+    if (voice->notes==NULL) {
+      continue; /* idle */
+    }
+    if (voice->idx>=voice->nofNotes) {
+      voice->notes = NULL; /* finished */
+      continue;
+    }
+    note = &voice->notes[voice->idx];
+    voice->idx++;
+    if (note->freq==0 || note->volume==0) {
+      BUZ_ToneOff(); /* pause */
+    } else {
+      BUZ_ToneOn(note->freq, note->volume);
+    }
+    (void)TRG_SetTrigger(TRG_BUZ_TUNE, note->ms/TRG_TICKS_MS, BUZ_NextNote, NULL);
+    CS1_ExitCritical();
+    return;
   }
+  BUZ_ToneOff(); /* nothing more to play */
+  CS1_ExitCritical();
 }
 
-uint8_t BUZ_Beep(uint16_t freq, uint16_t durationMs) {
-  if (trgInfo.buzIterationCntr==0) { /* only if buzzer is not running right now */
-    BUZ1_SetVal(); /* turn buzzer on */
-    trgInfo.buzPeriodTicks = (1000*TRG_TICKS_MS)/freq;
-    trgInfo.buzIterationCntr = durationMs/TRG_TICKS_MS/trgInfo.buzPeriodTicks;
-    return TRG_SetTrigger(TRG_BUZ_BEEP, trgInfo.buzPeriodTicks, BUZ_Toggle, (void*)&trgInfo);
-  } else {
-    return ERR_BUSY;
+uint8_t BUZ_PlayNotes(const BUZ_Note *notes, uint8_t nofNotes, BUZ_Priority prio) {
+  int i;
+  bool start;
+  CS1_CriticalVariable()
+
+  if (prio>=BUZ_NOF_PRIOS || notes==NULL) {
+    return ERR_FAILED;
   }
+  CS1_EnterCritical();
+  BUZ_Voices[prio].notes = notes;
+  BUZ_Voices[prio].nofNotes = nofNotes;
+  BUZ_Voices[prio].idx = 0;
+  start = TRUE;
+  for(i=prio+1;i<BUZ_NOF_PRIOS;i++) {
+    if (BUZ_Voices[i].notes!=NULL) {
+      start = FALSE; /* higher priority voice is playing, we continue afterwards */
+      break;
+    }
+  }
+  if (start) {
+    for(i=prio-1;i>=0;i--) {
+      if (BUZ_Voices[i].notes!=NULL) { /* lower priority voice gets interrupted: replay its current note afterwards */
+        if (BUZ_Voices[i].idx>0) {
+          BUZ_Voices[i].idx--;
+        }
+        break;
+      }
+    }
+    BUZ_NextNote(NULL); /* interrupts the current note of a lower priority voice */
+  }
+  CS1_ExitCritical();
+  return ERR_OK;
 }
 
-static void BUZ_Play(void *dataPtr) {
-  MelodyDesc *melody = (MelodyDesc*)dataPtr;
-
-  BUZ_Beep(melody->melody[melody->idx].freq, melody->melody[melody->idx].ms);
-  melody->idx++;
-  if (melody->idx<melody->maxIdx) {
-    TRG_SetTrigger(TRG_BUZ_TUNE, melody->melody[melody->idx-1].ms/TRG_TICKS_MS, BUZ_Play, (void*)melody);
+uint8_t BUZ_Beep(uint16_t freq, uint16_t durationMs) {
+  if (BUZ_Voices[BUZ_PRIO_CHIRP].notes!=NULL) { /* only if no chirp is running right now */
+    return ERR_BUSY;
   }
+  BUZ_BeepNote.freq = freq;
+  BUZ_BeepNote.ms = durationMs;
+  BUZ_BeepNote.volume = 100;
+  return BUZ_PlayNotes(&BUZ_BeepNote, 1, BUZ_PRIO_CHIRP);
 }
 
 uint8_t BUZ_PlayTune(BUZ_Tunes tune) {
   if (tune>=BUZ_TUNE_NOF_TUNES) {
     return ERR_OVERFLOW;
   }
-  BUZ_Melodies[tune].idx = 0; /* reset index */
-  return TRG_SetTrigger(TRG_BUZ_TUNE, 0, BUZ_Play, (void*)&BUZ_Melodies[tune]);
+  return BUZ_PlayNotes(BUZ_Melodies[tune].melody, BUZ_Melodies[tune].nofNotes, BUZ_Melodies[tune].prio);
 }
 
 
@@ -119,7 +187,9 @@ static uint8_t BUZ_PrintHelp(const CLS1_StdIOType *io) {
 }
 
 static uint8_t BUZ_PrintStatus(const CLS1_StdIOType *io) {
-  (void)io; /* not used */
+  CLS1_SendStatusStr((unsigned char*)"buzzer", (unsigned char*)"\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  melody", BUZ_Voices[BUZ_PRIO_MELODY].notes!=NULL?(unsigned char*)"playing\r\n":(unsigned char*)"idle\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  chirp", BUZ_Voices[BUZ_PRIO_CHIRP].notes!=NULL?(unsigned char*)"playing\r\n":(unsigned char*)"idle\r\n", io->stdOut);
   return ERR_OK;
 }
 
@@ -156,8 +226,13 @@ void BUZ_Deinit(void) {
 }
 
 void BUZ_Init(void) {
-  BUZ1_SetVal(); /* turn buzzer off */
-  trgInfo.buzPeriodTicks = 0;
-  trgInfo.buzIterationCntr = 0;
+  int i;
+
+  for(i=0;i<BUZ_NOF_PRIOS;i++) {
+    BUZ_Voices[i].notes = NULL;
+    BUZ_Voices[i].nofNotes = 0;
+    BUZ_Voices[i].idx = 0;
+  }
+  BUZ_ToneOff(); /* turn buzzer off */
 }
 #endif /* PL_CONFIG_HAS_BUZZER */
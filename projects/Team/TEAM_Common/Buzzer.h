@@ -39,6 +39,20 @@ typedef enum {
   BUZ_TUNE_NOF_TUNES
 } BUZ_Tunes;
 
+/*! \brief Priority of a tune. A tune with higher priority interrupts a tune with lower priority, which continues afterwards. */
+typedef enum {
+  BUZ_PRIO_MELODY, /*!< melodies, lowest priority */
+  BUZ_PRIO_CHIRP,  /*!< short status chirps and beeps */
+  BUZ_NOF_PRIOS    /*!< must be last */
+} BUZ_Priority;
+
+/*! \brief A note of a tune. */
+typedef struct {
+  uint16_t freq; /*!< frequency in Hz, 0 for a pause */
+  uint16_t ms;   /*!< duration in milliseconds */
+  uint8_t volume; /*!< volume in percent, zero for a pause; the pin is toggled, so other values are not audible */
+} BUZ_Note;
+
 /*!
  * \brief Plays a tune
  * \param tune Tune to play
@@ -46,6 +60,15 @@ typedef enum {
  */
 uint8_t BUZ_PlayTune(BUZ_Tunes tune);
 
+/*!
+ * \brief Plays a sequence of notes.
+ * \param notes Array of notes, must stay valid until the tune has been played.
+ * \param nofNotes Number of notes in the array.
+ * \param prio Priority of the tune. A tune already playing with the same priority gets replaced.
+ * \return ERR_OK or error code
+ */
+uint8_t BUZ_PlayNotes(const BUZ_Note *notes, uint8_t nofNotes, BUZ_Priority prio);
+
 /*!
  * \brief Initialization of the driver
  */
@@ -0,0 +1,263 @@
+/**
+ * \file
+ * \brief Timer paced control loop implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The timer interrupt stores the release time and gives a counting task notification, so the task knows
+ * how many releases it has missed while a cycle was still running. A cycle misses its deadline if it ends
+ * after the next release. The times are taken with a cycle counter, see CTRL_CONFIG_GET_TIME().
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_CONTROL_LOOP
+#include "ControlLoop.h"
+#include "FRTOS1.h"
+#include "CS1.h"
+#include "UTIL1.h"
+#include "Timer.h"
+#include "Reflectance.h"
+#include "Drive.h"
+#include "Motor.h"
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  #include "Tacho.h"
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  #include "LineFollow.h"
+#endif
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#include <string.h>
+
+#ifndef CTRL_CONFIG_GET_TIME
+  /* Cortex-M4 DWT cycle counter, as used by the profiler */
+  #define CTRL_DEMCR              (*((volatile uint32_t*)0xE000EDFC)) /* debug exception and monitor control register */
+  #define CTRL_DEMCR_TRCENA       (1UL<<24) /* enable DWT */
+  #define CTRL_DWT_CTRL           (*((volatile uint32_t*)0xE0001000)) /* DWT control register */
+  #define CTRL_DWT_CYCCNTENA      (1UL<<0)  /* enable cycle counter */
+  #define CTRL_DWT_CYCCNT         (*((volatile uint32_t*)0xE0001004)) /* DWT cycle counter */
+  #define CTRL_CONFIG_GET_TIME()  (CTRL_DWT_CYCCNT)
+  #define CTRL_CONFIG_TIME_HZ     (configCPU_CLOCK_HZ)
+#endif
+
+#define CTRL_PERIOD_TIME  ((uint32_t)(((uint64_t)CTRL_CONFIG_TIME_HZ*CTRL_PERIOD_MS)/1000)) /* period in cycle counter units */
+
+typedef enum {
+  CTRL_PHASE_ACQUIRE,  /* sensor frame */
+  CTRL_PHASE_ESTIMATE, /* wheel speeds */
+  CTRL_PHASE_CONTROL,  /* line and drive controllers */
+  CTRL_PHASE_ACTUATE,  /* motor outputs */
+  CTRL_PHASE_NOF       /* sentinel */
+} CTRL_Phase;
+
+static const char *const CTRL_PhaseNames[CTRL_PHASE_NOF] = {"acquire", "estimate", "control", "actuate"};
+
+typedef struct {
+  uint32_t nofCycles;
+  uint32_t nofMissed;     /* cycles which have ended after the next release */
+  uint32_t nofSkipped;    /* releases without a cycle, because the previous one was still running */
+  uint64_t latencySum, execSum;
+  uint32_t latencyMax;    /* from the timer interrupt to the start of the cycle */
+  uint32_t execMax;       /* from the start to the end of the cycle */
+  uint32_t periodDevMax;  /* maximum deviation of the time between two cycle starts from the period */
+  uint32_t phaseMax[CTRL_PHASE_NOF];
+} CTRL_Stats;
+
+static xTaskHandle CTRL_TaskHandle = NULL;
+static volatile uint32_t CTRL_ReleaseTime; /* time of the last release, set by the timer interrupt */
+static uint8_t CTRL_TimerCntr;
+static CTRL_Stats CTRL_Stat;
+static bool CTRL_ResetRequest = FALSE;
+
+void CTRL_OnTimerInterrupt(void) {
+  /* this one gets called from an interrupt!!!! */
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+  if (CTRL_TaskHandle==NULL) {
+    return; /* not initialized yet */
+  }
+  CTRL_TimerCntr++;
+  if (CTRL_TimerCntr<CTRL_CONFIG_TIMER_DIVIDER) {
+    return;
+  }
+  CTRL_TimerCntr = 0;
+  CTRL_ReleaseTime = CTRL_CONFIG_GET_TIME();
+  vTaskNotifyGiveFromISR(CTRL_TaskHandle, &higherPriorityTaskWoken);
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+static void RunPhase(CTRL_Phase phase) {
+  switch(phase) {
+    case CTRL_PHASE_ACQUIRE:
+      REF_Step();
+      break;
+    case CTRL_PHASE_ESTIMATE:
+#if PL_CONFIG_HAS_MOTOR_TACHO
+      TACHO_CalcSpeed();
+#endif
+      break;
+    case CTRL_PHASE_CONTROL:
+      MOT_HoldOutputs(); /* the controllers only compute the outputs */
+#if PL_CONFIG_HAS_LINE_FOLLOW
+      LF_ControlStep();
+#endif
+      DRV_Step();
+      break;
+    case CTRL_PHASE_ACTUATE:
+      MOT_ApplyOutputs();
+      break;
+    default:
+      break;
+  }
+}
+
+static void CtrlTask(void *pvParameters) {
+  uint32_t nofReleases, release, start, lastStart = 0, t, end, val;
+  CTRL_Phase phase;
+
+  (void)pvParameters; /* not used */
+  for(;;) {
+    nofReleases = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (nofReleases==0) {
+      continue;
+    }
+    start = CTRL_CONFIG_GET_TIME();
+    release = CTRL_ReleaseTime;
+    if (CTRL_ResetRequest) {
+      CTRL_ResetRequest = FALSE;
+      memset(&CTRL_Stat, 0, sizeof(CTRL_Stat));
+    } else {
+      CTRL_Stat.nofSkipped += nofReleases-1;
+    }
+    t = start;
+    for(phase=CTRL_PHASE_ACQUIRE; phase<CTRL_PHASE_NOF; phase++) {
+      RunPhase(phase);
+      end = CTRL_CONFIG_GET_TIME();
+      if (end-t>CTRL_Stat.phaseMax[phase]) {
+        CTRL_Stat.phaseMax[phase] = end-t;
+      }
+      t = end;
+    }
+    /* statistics: the time differences are correct across the wrap around of the counter */
+    val = start-release;
+    CTRL_Stat.latencySum += val;
+    if (val>CTRL_Stat.latencyMax) {
+      CTRL_Stat.latencyMax = val;
+    }
+    val = end-start;
+    CTRL_Stat.execSum += val;
+    if (val>CTRL_Stat.execMax) {
+      CTRL_Stat.execMax = val;
+    }
+    if (end-release>CTRL_PERIOD_TIME) {
+      CTRL_Stat.nofMissed++;
+    }
+    if (CTRL_Stat.nofCycles>0) {
+      val = start-lastStart;
+      val = val>CTRL_PERIOD_TIME ? val-CTRL_PERIOD_TIME : CTRL_PERIOD_TIME-val;
+      if (val>CTRL_Stat.periodDevMax) {
+        CTRL_Stat.periodDevMax = val;
+      }
+    }
+    lastStart = start;
+    CTRL_Stat.nofCycles++;
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static uint32_t TimeToUs(uint64_t time) {
+  return (uint32_t)((time*1000000UL)/CTRL_CONFIG_TIME_HZ);
+}
+
+static void PrintTimes(const unsigned char *title, uint64_t avg, uint32_t max, const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), TimeToUs(avg));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us avg, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), TimeToUs(max));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us max\r\n");
+  CLS1_SendStatusStr(title, buf, io->stdOut);
+}
+
+static void CTRL_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48], title[16];
+  CTRL_Stats stat;
+  int i;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  stat = CTRL_Stat; /* struct copy, consistent with itself */
+  CS1_ExitCritical();
+  CLS1_SendStatusStr((unsigned char*)"ctrl", (unsigned char*)"\r\n", io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16u(buf, sizeof(buf), 1000/CTRL_PERIOD_MS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" Hz, every ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), CTRL_CONFIG_TIMER_DIVIDER);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" timer interrupts\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  rate", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), stat.nofCycles);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), stat.nofMissed);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" missed, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), stat.nofSkipped);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" skipped\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  cycles", buf, io->stdOut);
+  if (stat.nofCycles==0) {
+    return;
+  }
+  PrintTimes((unsigned char*)"  latency", stat.latencySum/stat.nofCycles, stat.latencyMax, io);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), TimeToUs(stat.periodDevMax));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us max\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  jitter", buf, io->stdOut);
+  PrintTimes((unsigned char*)"  exec", stat.execSum/stat.nofCycles, stat.execMax, io);
+  for(i=0;i<CTRL_PHASE_NOF;i++) {
+    buf[0] = '\0';
+    UTIL1_strcatNum32u(buf, sizeof(buf), TimeToUs(stat.phaseMax[i]));
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us max\r\n");
+    UTIL1_strcpy(title, sizeof(title), (unsigned char*)"  ");
+    UTIL1_strcat(title, sizeof(title), (unsigned char*)CTRL_PhaseNames[i]);
+    CLS1_SendStatusStr(title, buf, io->stdOut);
+  }
+}
+
+static void CTRL_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"ctrl", (unsigned char*)"Group of control loop commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows control loop help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the timing statistics\r\n", io->stdOut);
+}
+
+uint8_t CTRL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"ctrl help")==0) {
+    CTRL_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"ctrl status")==0) {
+    CTRL_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"ctrl reset")==0) {
+    CTRL_ResetRequest = TRUE; /* done by the task, at the start of the next cycle */
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void CTRL_Deinit(void) {
+  /* nothing needed */
+}
+
+void CTRL_Init(void) {
+#ifdef CTRL_DWT_CYCCNT
+  CTRL_DEMCR |= CTRL_DEMCR_TRCENA; /* enable DWT */
+  CTRL_DWT_CTRL |= CTRL_DWT_CYCCNTENA; /* start cycle counter, not reset: the profiler uses it too */
+#endif
+  memset(&CTRL_Stat, 0, sizeof(CTRL_Stat));
+  CTRL_TimerCntr = 0;
+  if (xTaskCreate(CtrlTask, "Ctrl", 700/sizeof(StackType_t), NULL, CTRL_CONFIG_TASK_PRIORITY, &CTRL_TaskHandle) != pdPASS) {
+    for(;;){} /* error case only, stay here! */
+  }
+}
+
+#endif /* PL_CONFIG_HAS_CONTROL_LOOP */
@@ -0,0 +1,59 @@
+/**
+ * \file
+ * \brief Interface of the timer paced control loop.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * A single task runs the control of the robot in cycles released by the hardware timer (TI1, see Timer.h):
+ * every CTRL_CONFIG_TIMER_DIVIDER timer interrupts the task gets a notification and runs the phases in a fixed order:
+ *   acquisition: reflectance frame (REF_Step()),
+ *   estimation:  wheel speeds from the encoder samples (TACHO_CalcSpeed()),
+ *   control:     line controller (LF_ControlStep()) and speed/position PID (DRV_Step()),
+ *   actuation:   both motors get the new PWM and direction together (MOT_ApplyOutputs()).
+ * So the controllers act exactly once on each sensor frame, with no drift between the loops.
+ * The task measures the release latency (jitter) and execution time of the cycles and counts the deadline misses.
+ * With PL_LOCAL_CONFIG_HAS_CONTROL_LOOP_DISABLED the modules use their own tasks again (reflectance, drive and line).
+ */
+
+#ifndef CONTROLLOOP_H_
+#define CONTROLLOOP_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_CONTROL_LOOP
+#include "Timer.h"
+
+#ifndef CTRL_CONFIG_TIMER_DIVIDER
+  #define CTRL_CONFIG_TIMER_DIVIDER   (5)  /*!< timer interrupts (TMR_TICK_MS) per cycle: 5 is 200 Hz, as the PID gains are tuned for, 1 is 1 kHz */
+#endif
+#define CTRL_PERIOD_MS                (TMR_TICK_MS*CTRL_CONFIG_TIMER_DIVIDER) /*!< period of the cycles, so of the sensor frames */
+#ifndef CTRL_CONFIG_TASK_PRIORITY
+  #define CTRL_CONFIG_TASK_PRIORITY   (tskIDLE_PRIORITY+4) /*!< above all other tasks */
+#endif
+
+/*!
+ * \brief Called from the timer interrupt every TMR_TICK_MS, releases a cycle every CTRL_CONFIG_TIMER_DIVIDER calls.
+ * The interrupt priority must allow FreeRTOS API calls (at or below configMAX_SYSCALL_INTERRUPT_PRIORITY).
+ */
+void CTRL_OnTimerInterrupt(void);
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t CTRL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Driver de-initialization */
+void CTRL_Deinit(void);
+
+/*! \brief Driver initialization, call it after the modules of the phases have been initialized */
+void CTRL_Init(void);
+
+#endif /* PL_CONFIG_HAS_CONTROL_LOOP */
+
+#endif /* CONTROLLOOP_H_ */
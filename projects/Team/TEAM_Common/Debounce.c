@@ -3,91 +3,110 @@
  * \brief Implementation of push button debouncing.
  * \author Erich Styger, erich.styger@hslu.ch
  *
- * This module implements the debouncing of keys, using a state machine.
- * While this is a rather complex way of debouncing, it allows us to
- * detect both short and long key presses, which is a plus.
+ * This module implements the debouncing of keys, using vertical counters:
+ * every key has a 2bit counter, with the bits of all keys stored in two bytes.
+ * With this, all keys of a set get debounced in parallel with a few bitwise operations.
+ * A key change is accepted after DBNC_NOF_SAMPLES stable samples.
+ * Long key presses and repeats are derived from the debounced state. A key which repeats reports the
+ * press right away, the others on the release if it has not been a long press.
  */
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_DEBOUNCE
 #include <stddef.h> /* for NULL */
 #include "Debounce.h"
-#include "Trigger.h"
 
-/*! \brief Key scan routine which implements the state machine.
-\dot
-digraph example_api_graph {
-  node [shape=box];
-  DBNC_KEY_IDLE    [fillcolor=lightblue,style=filled,label="DBNC_KEY_IDLE" ];
-  DBNC_KEY_PRESSED [fillcolor=lightblue,style=filled,label="DBNC_KEY_PRESSED" ];
-  DBNC_KEY_RELEASE [fillcolor=lightblue,style=filled,label="DBNC_KEY_WAIT_RELEASE"];
-  DBNC_KEY_IDLE -> DBNC_KEY_PRESSED -> DBNC_KEY_RELEASE ;
-  DBNC_KEY_PRESSED -> DBNC_KEY_PRESSED ;
-  DBNC_KEY_IDLE -> DBNC_KEY_IDLE ;
+/*!
+ * \brief Handles the long press and repeat timing of the keys being pressed.
+ * \param data Debouncing data.
+ * \param longKeys Where to store the keys with a long press.
+ * \param repeatKeys Where to store the keys with a repeat.
+ */
+static void DBNC_HoldTiming(DBNC_Data *data, DBNC_KeySet *longKeys, DBNC_KeySet *repeatKeys) {
+  uint8_t i;
+  uint16_t ticks;
+  const DBNC_KeyTiming *timing;
+
+  for(i=0;i<data->nofKeys;i++) {
+    if ((data->state&(1<<i))==0) {
+      continue; /* not pressed */
+    }
+    if (data->holdTicks[i]<0xffff) {
+      data->holdTicks[i]++;
+    }
+    ticks = data->holdTicks[i];
+    timing = &data->timing[i];
+    if (timing->longKeyTicks!=0 && ticks==timing->longKeyTicks) {
+      *longKeys |= (1<<i);
+      data->longDone |= (1<<i);
+    }
+    if (timing->repeatTicks!=0 && ticks>=timing->repeatDelayTicks
+        && ((ticks-timing->repeatDelayTicks)%timing->repeatTicks)==0)
+    {
+      *repeatKeys |= (1<<i);
+      data->repeatDone |= (1<<i);
+    }
+  }
 }
-\enddot
-*/
 
-void DBNC_Process(DBNC_FSMData *data) {
-  DBNC_KeySet keys;
+void DBNC_Process(DBNC_Data *data) {
+  DBNC_KeySet changed, pressed, released, longKeys, repeatKeys, repeating;
+  uint8_t i;
 
-  for(;;) { /* for loop, will return */
-    switch(data->state) {
-      case DBNC_KEY_IDLE: /* idle, and now getting a key */
-        data->scanValue = data->getKeys();
-        data->longKeyCnt = 1; /* zero is a special value */
-#if 0 /* \todo call event if you want to be notified here */
-        data->onDebounceEvent(DBNC_EVENT_PRESSED, data->scanValue); /* we have a key press: call event handler  */
-#endif
-        data->state = DBNC_KEY_PRESSED; /* advance to next state */
-        (void)TRG_SetTrigger(data->trigger, data->debounceTicks, (TRG_Callback)DBNC_Process, (void*)data);
-        return;
-  
-      case DBNC_KEY_PRESSED:
-        keys = data->getKeys();
-        if (keys==data->scanValue) { /* still pressing the same keys */
-          /*! \todo See how it checks long or short press */
-          if (data->longKeyCnt>=data->longKeyTicks) {
-            /* yes, long key press detected */
-            data->longKeyCnt=0; /* zero is a special value to prevent counting */
-            data->onDebounceEvent(DBNC_EVENT_LONG_PRESSED, data->scanValue);
-          } else if (data->longKeyCnt>0) { /* zero is a special value to prevent counting */
-            data->longKeyCnt += data->debounceTicks; /* increment loop counter */
-          }
-          (void)TRG_SetTrigger(data->trigger, data->debounceTicks, (TRG_Callback)DBNC_Process, (void*)data); /* continue waiting */
-          return;
-        } else if (keys==0) { /* all keys are released */
-#if 1 /* \todo call event here if you want to be notified when button is released */
-          if (data->longKeyCnt!=0) { /* zero means we already issued the long button press message */
-            data->onDebounceEvent(DBNC_EVENT_PRESSED, data->scanValue); /* we have a key press: call event handler  */
-          }
-#endif
-          data->state = DBNC_KEY_RELEASE; /* advance to next state */
-          (void)TRG_SetTrigger(data->trigger, data->debounceTicks, (TRG_Callback)DBNC_Process, (void*)data);
-          return;
-        } else { /* we got another key set pressed */
-          /*! \todo Here it goes to the next state */
-          data->state = DBNC_KEY_RELEASE;
-        }
-        break;
-  
-      case DBNC_KEY_RELEASE: /* wait until keys are released */
-        keys = data->getKeys();
-        if (keys==0) { /* all keys released, go back to idle state. */
-          data->onDebounceEvent(DBNC_EVENT_RELEASED, data->scanValue);
-          data->state = DBNC_KEY_IDLE; /* go back to idle */
-          data->onDebounceEvent(DBNC_EVENT_END, data->scanValue); /* callback at the end of debouncing. */
-          return;
-        } else { /* continue waiting */
-          /* create events for the delta */
-          data->onDebounceEvent(DBNC_EVENT_RELEASED, (uint8_t)(data->scanValue&(~keys)));
-          data->scanValue = keys;
-          data->longKeyCnt = 1; /* zero is a special value */
-          data->state = DBNC_KEY_PRESSED;
+  /* vertical counters: count down for keys which differ from the debounced state, reset for all others */
+  changed = data->state ^ data->getKeys();
+  data->cnt0 = (DBNC_KeySet)~(data->cnt0 & changed);
+  data->cnt1 = (DBNC_KeySet)(data->cnt0 ^ (data->cnt1 & changed));
+  changed &= data->cnt0 & data->cnt1; /* counter rolled over: change is stable */
+  data->state ^= changed;
+  pressed = data->state & changed;
+  released = (DBNC_KeySet)(~data->state & changed);
+
+  if (pressed!=0) {
+    repeating = 0;
+    for(i=0;i<data->nofKeys;i++) {
+      if (pressed&(1<<i)) {
+        data->holdTicks[i] = 0;
+        if (data->timing[i].repeatTicks!=0) {
+          repeating |= (1<<i);
         }
-        break;
-    } /* switch */
-  } /* for */
+      }
+    }
+    data->longDone &= (DBNC_KeySet)~pressed;
+    data->repeatDone = (DBNC_KeySet)((data->repeatDone & ~pressed) | repeating);
+    if (repeating!=0) { /* the first step of a repeating key, not after the repeats */
+      data->onDebounceEvent(DBNC_EVENT_PRESSED, repeating);
+    }
+  }
+  longKeys = 0; repeatKeys = 0;
+  if (data->state!=0) {
+    DBNC_HoldTiming(data, &longKeys, &repeatKeys);
+  }
+  if (longKeys!=0) {
+    data->onDebounceEvent(DBNC_EVENT_LONG_PRESSED, longKeys);
+  }
+  if (repeatKeys!=0) {
+    data->onDebounceEvent(DBNC_EVENT_REPEAT, repeatKeys);
+  }
+  if (released!=0) {
+    if (released & ~(data->longDone|data->repeatDone)) { /* short key press: no long press, press or repeat event issued */
+      data->onDebounceEvent(DBNC_EVENT_PRESSED, (DBNC_KeySet)(released & ~(data->longDone|data->repeatDone)));
+    }
+    data->onDebounceEvent(DBNC_EVENT_RELEASED, released);
+  }
+}
+
+void DBNC_Reset(DBNC_Data *data) {
+  uint8_t i;
+
+  data->state = 0;
+  data->cnt0 = (DBNC_KeySet)~0; /* counters start at DBNC_NOF_SAMPLES-1 */
+  data->cnt1 = (DBNC_KeySet)~0;
+  data->longDone = 0;
+  data->repeatDone = 0;
+  for(i=0;i<DBNC_MAX_KEYS;i++) {
+    data->holdTicks[i] = 0;
+  }
 }
 
 void DBNC_Deinit(void) {
@@ -3,7 +3,8 @@
  * \brief Interface of the keyboard debouncing engine.
  * \author Erich Styger, erich.styger@hslu.ch
  *
- * This provides the interface to the debouncing state machine.
+ * This provides the interface to the debouncing engine. All keys of a port are
+ * debounced in parallel using vertical counters.
  */
 
 #ifndef __DEBOUNCE_H_
@@ -11,21 +12,16 @@
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_DEBOUNCE
-#include "Trigger.h"
 
-/*! \brief States of the key detection state machine. */
-typedef enum DBNC_KeyStateKinds {
-  DBNC_KEY_IDLE = 0, /*<! Initial idle state */
-  DBNC_KEY_PRESSED,  /*<! Key pressing detected, see if it is a long key */
-  DBNC_KEY_RELEASE   /*<! Got a key pressed, wait for key released */
-} DBNC_KeyStateKinds;
+#define DBNC_NOF_SAMPLES   4 /*!< number of stable samples needed to accept a key change (2bit vertical counter) */
+#define DBNC_MAX_KEYS      8 /*!< maximum number of keys handled in a set */
 
 /*! \brief Different kind of callback events. */
 typedef enum DBNC_EventKinds {
-  DBNC_EVENT_PRESSED,       /*<! Event for key(s) pressed */
+  DBNC_EVENT_PRESSED,       /*<! Event for key(s) pressed: on the press for repeating keys, else a short press reported on release */
   DBNC_EVENT_LONG_PRESSED,  /*<! Event for key(s) pressed for a long time */
-  DBNC_EVENT_RELEASED,      /*<! Event for key(s) released */
-  DBNC_EVENT_END            /*<! Debouncing end event. This one is called when the FSM finishes. */
+  DBNC_EVENT_REPEAT,        /*<! Event for key(s) held down, repeated periodically */
+  DBNC_EVENT_RELEASED       /*<! Event for key(s) released */
 } DBNC_EventKinds;
 
 /*! \brief we are handling up to 8 keys in a single port */
@@ -34,35 +30,52 @@ typedef uint8_t DBNC_KeySet;
 /*! \brief Type for a function pointer/callback to get the port data */
 typedef DBNC_KeySet (*DBNC_GetKeysFn)(void);
 
-/*! \brief Type for a function pointer/callback to be called in the event of a key pressed/released or at the end of debounce */
+/*! \brief Type for a function pointer/callback to be called in the event of key(s) pressed/released */
 typedef void (*DBNC_EventCallback)(DBNC_EventKinds event, DBNC_KeySet keys);
 
 /*!
- * \brief data structure which is used in the Finite State Machine
+ * \brief Per key timing, in number of samples. A value of zero disables the feature.
  */
-typedef struct DBNC_FSMData {
-  DBNC_GetKeysFn getKeys; /*!< Callback to get the keyboard port value, might be NULL */
+typedef struct DBNC_KeyTiming {
+  uint16_t longKeyTicks;     /*!< number of samples needed for long key press */
+  uint16_t repeatDelayTicks; /*!< number of samples before the first repeat event */
+  uint16_t repeatTicks;      /*!< number of samples between repeat events */
+} DBNC_KeyTiming;
+
+/*!
+ * \brief data structure used by the debouncing engine
+ */
+typedef struct DBNC_Data {
+  DBNC_GetKeysFn getKeys; /*!< Callback to get the keyboard port value, bit set means key pressed */
   DBNC_EventCallback onDebounceEvent; /*!< Event callback */
-  DBNC_KeyStateKinds state;  /*!< status of the state machine to detect long and short keys */
-  DBNC_KeySet scanValue;  /*!< value of keys scanned in */
-  uint16_t longKeyCnt; /*!< counting how long we press a key */
-  TRG_TriggerKind trigger; /*!< trigger to be used to iterate through state machine */
-  uint16_t debounceTicks; /*!< number of trigger ticks needed for debouncing */
-  uint16_t longKeyTicks; /*!< number of trigger ticks needed for long key press */
-} DBNC_FSMData;
+  const DBNC_KeyTiming *timing; /*!< array of timing data, one entry for each key of the set */
+  uint8_t nofKeys; /*!< number of keys in the set, at most DBNC_MAX_KEYS */
+  DBNC_KeySet state; /*!< debounced key state, bit set means key pressed */
+  DBNC_KeySet cnt0, cnt1; /*!< vertical counter bits, one counter per key */
+  DBNC_KeySet longDone; /*!< long press event already issued for the key */
+  DBNC_KeySet repeatDone; /*!< press or repeat event already issued while the key is held */
+  uint16_t holdTicks[DBNC_MAX_KEYS]; /*!< number of samples the key has been pressed */
+} DBNC_Data;
 
 /*!
- \brief The debounce state machine, called from the keyboard interrupt
-*/
-void DBNC_Process(DBNC_FSMData *data);
+ * \brief Samples the keys and debounces all of them in parallel. Needs to be called periodically.
+ * \param data Debouncing data.
+ */
+void DBNC_Process(DBNC_Data *data);
+
+/*!
+ * \brief Resets the debouncing data, all keys are considered as released.
+ * \param data Debouncing data.
+ */
+void DBNC_Reset(DBNC_Data *data);
 
 /*!
- \brief De-Initializes the debounce state machine
+ \brief De-Initializes the debounce engine
 */
 void DBNC_Deinit(void);
 
 /*!
- \brief Initializes the debounce state machine
+ \brief Initializes the debounce engine
 */
 void DBNC_Init(void);
 
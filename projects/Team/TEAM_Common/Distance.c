@@ -36,6 +36,16 @@
   #include "TofCE2.h"
   #include "TofCE3.h"
   #include "TofCE4.h"
+  #include "CS1.h"
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  #include "Obstacle.h"
+#endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  #include "ArenaLoc.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
 #endif
 
 #if PL_HAS_TOF_SENSOR
@@ -83,8 +93,43 @@ static void DIST_TOF_CEPinAction_4(VL6180X_PIN_ACTION action) {
   }
 }
 
+#define DIST_TOF_POWERUP_MS       2   /* supply ramp after the FET has been switched on in VL6180X_Init() */
+#define DIST_TOF_CE_LOW_MS        1   /* CE (GPIO0) low time to put a device into hardware standby (reset) */
+#define DIST_TOF_BOOT_TIMEOUT_MS  10  /* a device not answering on the default address in this time has failed (datasheet boot time: 1.4 ms) */
+#define DIST_TOF_RETRY_MS         100 /* time before a failed device gets reset and initialized again */
+
+/* range profiles: the precise profile is the configuration of VL6180X_InitAndConfigureDevice() */
+typedef struct {
+  const char *name; /* name in the shell */
+  VL6180X_RangeProfile vl; /* sensor settings */
+  uint8_t periodMs; /* period of the range measurements */
+} DIST_ToF_ProfileDesc;
+
+static const DIST_ToF_ProfileDesc DIST_ToF_Profiles[DIST_RANGE_PROFILE_NOF] = {
+  [DIST_RANGE_PROFILE_PRECISE] = {"precise", {.maxConvergenceMs=49, .averagingPeriod=0x30, .scaling=VL6180X_SCALING_FACTOR_3}, 50}, /* up to ~57 ms per range, 0-60 cm */
+  [DIST_RANGE_PROFILE_FAST]    = {"fast",    {.maxConvergenceMs=10, .averagingPeriod=0x08, .scaling=VL6180X_SCALING_FACTOR_2}, 10}, /* up to ~15 ms per range, 0-40 cm */
+};
+
+typedef enum {
+  DIST_TOF_STATE_OFF,       /* CE low (hardware standby) */
+  DIST_TOF_STATE_BOOTING,   /* CE high, waiting for the device on the default address */
+  DIST_TOF_STATE_ADDRESSED, /* device has its own I2C address, registers not configured yet */
+  DIST_TOF_STATE_READY,     /* configured and verified, ranging */
+  DIST_TOF_STATE_FAILED     /* bring-up failed, waiting for the retry */
+} DIST_ToF_State;
+
 typedef struct {
   int16_t mm; /* distance in mm, negative values are error values */
+  VL6180X_Range range; /* last measurement with status, signal and ambient rate */
+  DIST_RangeProfile profile; /* profile configured in the device */
+  DIST_RangeProfile profileReq; /* profile requested with DIST_SetRangeProfile() */
+  DIST_ToF_State state; /* bring-up state */
+  TickType_t stateTick; /* tick count when the state has been entered */
+  TickType_t initStartTick; /* tick count when the current bring-up has started */
+  TickType_t initTicks; /* duration of the last bring-up, from leaving reset to ready */
+  TickType_t firstRangeTick; /* tick count of the first range after boot, 0 if not yet available */
+  uint16_t nofInits; /* number of bring-ups */
+  uint16_t nofErrors; /* number of bring-up and range errors */
 } DIST_ToF_DeviceDesc;
 
 static DIST_ToF_DeviceDesc ToFDevice[VL_NOF_DEVICES]; /* ToF sensor distance in millimeters */
@@ -114,6 +159,18 @@ typedef enum {
   DIST_TOF_LEFT = 1
 } DIST_SensorPosition;
 
+static const DIST_SensorMount DIST_ToF_Mounts[] = { /* in the order of DIST_ToF_Devices */
+  /*
+  {.xMm=-45, .yMm=0, .headingDeg=180},
+  {.xMm=0, .yMm=-40, .headingDeg=-90},
+  {.xMm=45, .yMm=0, .headingDeg=0},
+  {.xMm=0, .yMm=40, .headingDeg=90},
+  */
+  //Fr Sumo Wettkampf mit nur 2 Frontsensoren, leicht nach aussen gedreht
+  {.xMm=45, .yMm=-30, .headingDeg=-5},
+  {.xMm=45, .yMm=30, .headingDeg=5},
+};
+
 #endif
 
 #if PL_HAS_FRONT_DISTANCE
@@ -151,6 +208,84 @@ static int16_t DIST_GetToFDistance(DIST_SensorPosition pos) {
   }
   return ToFDevice[pos].mm;
 }
+
+static int DIST_GetToFIndex(DIST_Sensor sensor) {
+  DIST_SensorPosition pos;
+
+  switch(sensor) {
+    case DIST_SENSOR_FRONT: pos = DIST_TOF_FRONT; break;
+    case DIST_SENSOR_REAR:  pos = DIST_TOF_REAR; break;
+    case DIST_SENSOR_LEFT:  pos = DIST_TOF_LEFT; break;
+    case DIST_SENSOR_RIGHT: pos = DIST_TOF_RIGHT; break;
+    default: return -1;
+  }
+  if (pos>=VL_NOF_DEVICES) {
+    return -1; /* sensor not fitted */
+  }
+  return (int)pos;
+}
+
+uint8_t DIST_GetRange(DIST_Sensor sensor, VL6180X_Range *range) {
+  int i = DIST_GetToFIndex(sensor);
+  CS1_CriticalVariable()
+
+  if (i<0 || ToFDevice[i].state!=DIST_TOF_STATE_READY) {
+    range->mm = -1;
+    range->status = VL6180X_RANGE_STATUS_NOT_AVAILABLE;
+    range->signalRateKcps = 0;
+    range->ambientRateKcps = 0;
+    return ERR_NOTAVAIL;
+  }
+  CS1_EnterCritical();
+  *range = ToFDevice[i].range;
+  CS1_ExitCritical();
+  return ERR_OK;
+}
+
+uint8_t DIST_GetSensorMount(DIST_Sensor sensor, DIST_SensorMount *mount) {
+  int i = DIST_GetToFIndex(sensor);
+
+  if (i<0) {
+    return ERR_NOTAVAIL;
+  }
+  *mount = DIST_ToF_Mounts[i];
+  return ERR_OK;
+}
+
+void DIST_SetRangeProfile(DIST_Sensor sensor, DIST_RangeProfile profile) {
+  int i = DIST_GetToFIndex(sensor);
+
+  if (i>=0 && profile<DIST_RANGE_PROFILE_NOF) {
+    ToFDevice[i].profileReq = profile; /* applied by the ToF task */
+  }
+}
+
+/*!
+ * \brief Checks for an obstacle in the range of a sensor, using the status of the measurement.
+ * \return TRUE if the target is closer than the distance, or if the sensor failed (fail safe). FALSE if there is no target.
+ */
+static bool DIST_ToFNearObstacle(DIST_Sensor sensor, int distance) {
+  VL6180X_Range range;
+
+  if (DIST_GetRange(sensor, &range)!=ERR_OK) {
+    return TRUE; /* sensor failure? */
+  }
+  switch(range.status) {
+    case VL6180X_RANGE_STATUS_OK:
+      return range.mm<=distance;
+    case VL6180X_RANGE_STATUS_EARLY_CONVERGENCE:
+    case VL6180X_RANGE_STATUS_MAX_CONVERGENCE:
+    case VL6180X_RANGE_STATUS_NO_TARGET_IGNORE:
+    case VL6180X_RANGE_STATUS_OVERFLOW:
+    case VL6180X_RANGE_STATUS_RAW_OVERFLOW:
+      return FALSE; /* no target in range */
+    case VL6180X_RANGE_STATUS_UNDERFLOW:
+    case VL6180X_RANGE_STATUS_RAW_UNDERFLOW:
+      return TRUE; /* target very close */
+    default:
+      return TRUE; /* hardware failure or too much ambient light: fail safe */
+  }
+}
 #endif
 
 int16_t DIST_GetDistance(DIST_Sensor sensor) {
@@ -271,13 +406,7 @@ bool DIST_RightOn(void){
 
 bool DIST_NearFrontObstacle(int16_t distance) {
 #if PL_HAS_TOF_SENSOR && VL_NOF_DEVICES>=1
-  int16_t val;
-
-  val = DIST_GetToFDistance(DIST_TOF_FRONT);
-  if (val<0) {
-    return TRUE; /* sensor failure? */
-  }
-  return val>=0 && val<=distance;
+  return DIST_ToFNearObstacle(DIST_SENSOR_FRONT, distance);
 #else
   (void)distance;
   return FALSE;
@@ -286,13 +415,7 @@ bool DIST_NearFrontObstacle(int16_t distance) {
 
 bool DIST_NearRearObstacle(int distance) {
 #if PL_HAS_TOF_SENSOR && VL_NOF_DEVICES>=3
-  int16_t val;
-
-  val = DIST_GetToFDistance(DIST_TOF_REAR);
-  if (val<0) {
-    return TRUE; /* sensor failure? */
-  }
-  return val>=0 && val<=distance;
+  return DIST_ToFNearObstacle(DIST_SENSOR_REAR, distance);
 #else
   (void)distance;
   return FALSE;
@@ -301,13 +424,7 @@ bool DIST_NearRearObstacle(int distance) {
 
 bool DIST_NearLeftObstacle(int distance) {
 #if PL_HAS_TOF_SENSOR && VL_NOF_DEVICES>=4
-  int16_t val;
-
-  val = DIST_GetToFDistance(DIST_TOF_LEFT);
-  if (val<0) {
-    return TRUE; /* sensor failure? */
-  }
-  return val>=0 && val<=distance;
+  return DIST_ToFNearObstacle(DIST_SENSOR_LEFT, distance);
 #else
   (void)distance;
   return FALSE;
@@ -316,13 +433,7 @@ bool DIST_NearLeftObstacle(int distance) {
 
 bool DIST_NearRightObstacle(int distance) {
 #if PL_HAS_TOF_SENSOR && VL_NOF_DEVICES>=4
-  int16_t val;
-
-  val = DIST_GetToFDistance(DIST_TOF_RIGHT);
-  if (val<0) {
-    return TRUE; /* sensor failure? */
-  }
-  return val>=0 && val<=distance;
+  return DIST_ToFNearObstacle(DIST_SENSOR_RIGHT, distance);
 #else
   (void)distance;
   return FALSE;
@@ -385,23 +496,42 @@ uint8_t DIST_MotorDrivingIntoObstacle(void) {
 #endif
 
 bool DIST_DriveToCenter(void) {
+#if PL_CONFIG_HAS_ARENA_LOC
+  ALOC_Pose pose;
+#endif
 #if PL_HAS_TOF_SENSOR
-  int16_t front, left, rear, right;
+  DIST_SensorMount mount;
+  int sensor, nofFitted = 0;
+#endif
 
-  front = ToFDevice[DIST_TOF_FRONT].mm;
-  left  = ToFDevice[DIST_TOF_LEFT].mm;
-  rear  = ToFDevice[DIST_TOF_REAR].mm;
-  right  = ToFDevice[DIST_TOF_RIGHT].mm;
-  if (front>150 && left>150 && right>150 && rear>150) {
+#if PL_CONFIG_HAS_ARENA_LOC
+  if (ALOC_GetPose(&pose)==ERR_OK) { /* the arena has no walls: the ranges only tell if the opponent is close */
+    return ALOC_IsInCenter();
+  }
+#endif
+#if PL_HAS_TOF_SENSOR
+  for(sensor=DIST_SENSOR_FRONT;sensor<=DIST_SENSOR_RIGHT;sensor++) { /* only the fitted sensors */
+    if (DIST_GetSensorMount((DIST_Sensor)sensor, &mount)!=ERR_OK) {
+      continue;
+    }
+    nofFitted++;
+    if (DIST_ToFNearObstacle((DIST_Sensor)sensor, 150)) {
+      return FALSE; /* close to something */
+    }
+  }
+  if (nofFitted>0) {
     return TRUE; /* in the middle */
   }
 #endif
-  return FALSE; /* found center */
+  return FALSE; /* unknown */
 }
 
 static void DIST_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"dist", (unsigned char*)"Group of distance commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows line help or status\r\n", io->stdOut);
+#if PL_HAS_TOF_SENSOR
+  CLS1_SendHelpStr((unsigned char*)"  profile <sensor> (precise|fast)", (unsigned char*)"Sets the ToF range profile of a sensor (front, rear, left, right or all)\r\n", io->stdOut);
+#endif
 #if PL_HAS_FRONT_DISTANCE
   CLS1_SendHelpStr((unsigned char*)"  (l|m|r) (on|off)", (unsigned char*)"Turn sensor (left, middle, right) on or off\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  test", (unsigned char*)"Test sensors\r\n", io->stdOut);
@@ -500,7 +630,8 @@ static void DIST_PrintStatus(const CLS1_StdIOType *io) {
     uint16_t ambient;
     int i;
 #endif
-    uint8_t buf[64];
+    uint8_t buf[80], name[16];
+    int i;
 
     buf[0] = '\0';
     UTIL1_strcat(buf, sizeof(buf), "front:");
@@ -513,6 +644,34 @@ static void DIST_PrintStatus(const CLS1_StdIOType *io) {
     UTIL1_strcatNum16s(buf, sizeof(buf), DIST_GetDistance(DIST_SENSOR_RIGHT));
     UTIL1_strcat(buf, sizeof(buf), " mm\r\n");
     CLS1_SendStatusStr((unsigned char*)"  range", buf, io->stdOut);
+    for(i=0;i<VL_NOF_DEVICES;i++) {
+      static const char *const stateNames[] = {"off", "booting", "addressed", "ready", "failed"};
+
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)stateNames[ToFDevice[i].state]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", init ");
+      UTIL1_strcatNum32u(buf, sizeof(buf), ToFDevice[i].initTicks*portTICK_PERIOD_MS);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, first range ");
+      UTIL1_strcatNum32u(buf, sizeof(buf), ToFDevice[i].firstRangeTick*portTICK_PERIOD_MS);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, #init ");
+      UTIL1_strcatNum16u(buf, sizeof(buf), ToFDevice[i].nofInits);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", #err ");
+      UTIL1_strcatNum16u(buf, sizeof(buf), ToFDevice[i].nofErrors);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+      name[0] = '\0';
+      UTIL1_strcat(name, sizeof(name), (unsigned char*)"  ToF ");
+      UTIL1_strcatNum8u(name, sizeof(name), i);
+      CLS1_SendStatusStr(name, buf, io->stdOut);
+
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)DIST_ToF_Profiles[ToFDevice[i].profile].name);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", status ");
+      UTIL1_strcatNum8u(buf, sizeof(buf), ToFDevice[i].range.status);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", signal ");
+      UTIL1_strcatNum16u(buf, sizeof(buf), ToFDevice[i].range.signalRateKcps);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" kcps, ambient ");
+      UTIL1_strcatNum16u(buf, sizeof(buf), ToFDevice[i].range.ambientRateKcps);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" kcps\r\n");
+      CLS1_SendStatusStr((unsigned char*)"", buf, io->stdOut);
+    }
 #if 0
     res = VL_ReadAmbientSingle(&ambient);
     if (res!=ERR_OK) {
@@ -539,6 +698,33 @@ uint8_t DIST_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
   } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"dist status")==0) {
     DIST_PrintStatus(io);
     *handled = TRUE;
+#if PL_HAS_TOF_SENSOR
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"dist profile ", sizeof("dist profile ")-1)==0) {
+    static const char *const sensorNames[] = {"front", "rear", "left", "right", "all"}; /* in the order of DIST_Sensor */
+    unsigned char buf[32];
+    int sensor, profile, i;
+
+    for(sensor=0;sensor<(int)(sizeof(sensorNames)/sizeof(sensorNames[0]));sensor++) {
+      for(profile=0;profile<DIST_RANGE_PROFILE_NOF;profile++) {
+        UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"dist profile ");
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)sensorNames[sensor]);
+        UTIL1_chcat(buf, sizeof(buf), ' ');
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)DIST_ToF_Profiles[profile].name);
+        if (UTIL1_strcmp((char*)cmd, (char*)buf)==0) {
+          for(i=0;i<=DIST_SENSOR_RIGHT;i++) {
+            if (i==sensor || sensor>DIST_SENSOR_RIGHT) {
+              DIST_SetRangeProfile((DIST_Sensor)i, (DIST_RangeProfile)profile);
+            }
+          }
+          *handled = TRUE;
+          return ERR_OK;
+        }
+      }
+    }
+    CLS1_SendStr((unsigned char*)"*** wrong sensor or profile\r\n", io->stdErr);
+    res = ERR_FAILED;
+    *handled = TRUE;
+#endif
 #if PL_HAS_FRONT_DISTANCE
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist l on")==0) {
     LEn_SetVal(); /* HIGH: enable sensor */
@@ -585,79 +771,179 @@ uint8_t DIST_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
 }
 
 #if PL_HAS_TOF_SENSOR
-static uint8_t InitToF(void) {
-  uint8_t res;
+static void DIST_ToFSetState(int i, DIST_ToF_State state) {
+  ToFDevice[i].state = state;
+  ToFDevice[i].stateTick = xTaskGetTickCount();
+}
+
+static void DIST_ToFFailed(int i, const char *msg) {
+  CLS1_SendStr((unsigned char*)msg, SHELL_GetStdio()->stdErr);
+  CLS1_SendNum8u(i, SHELL_GetStdio()->stdErr);
+  CLS1_SendStr((unsigned char*)"\r\n", SHELL_GetStdio()->stdErr);
+  ToFDevice[i].nofErrors++;
+  DIST_ToFSetState(i, DIST_TOF_STATE_FAILED);
+}
+
+/* puts a device into hardware standby, it gets initialized again by DIST_ToFService() */
+static void DIST_ToFReset(int i) {
+  ToFDevice[i].mm = 0;
+  (void)VL6180X_ChipEnable(&DIST_ToF_Devices[i], FALSE); /* disable device */
+  DIST_ToFSetState(i, DIST_TOF_STATE_OFF);
+}
+
+static bool DIST_ToFIsBooting(void) {
   int i;
 
-  /* initialize data structure */
-  for(i=0;i<VL_NOF_DEVICES;i++) {
-    ToFDevice[i].mm = 0;
-  }
-  /* disable all devices (CE pin LOW): we will bring them up later one by one.... */
   for(i=0;i<VL_NOF_DEVICES;i++) {
-    (void)VL6180X_ChipEnable(&DIST_ToF_Devices[i], FALSE); /* disable device */
-  }
-  for(i=0;i<VL_NOF_DEVICES;i++) {
-    (void)VL6180X_ChipEnable(&DIST_ToF_Devices[i], TRUE); /* enable device */
-    vTaskDelay(pdMS_TO_TICKS(100)); /* give some time to get it enabled */
-    res = VL6180X_SetI2CDeviceAddress(&DIST_ToF_Devices[i]); /* set hardware I2C address */
-    if (res!=ERR_OK) {
-      CLS1_SendStr("ERROR: Failed set i2C address of TOF device: ", SHELL_GetStdio()->stdErr);
-      CLS1_SendNum8u(i, SHELL_GetStdio()->stdErr);
-      CLS1_SendStr("\r\n", SHELL_GetStdio()->stdErr);
-      vTaskDelay(pdMS_TO_TICKS(1000)); /* delay for some time */
-      return res;
+    if (ToFDevice[i].state==DIST_TOF_STATE_BOOTING) {
+      return TRUE;
     }
   }
-  /* at this time all devices are enabled (CE pin HIGH) and have unique I2C addresses */
+  return FALSE;
+}
+
+/*!
+ * \brief Advances the bring-up of the devices which are not ready.
+ * Only one device at a time can boot, because all of them answer on the default address until they have got their own one.
+ * While the next device boots, the device addressed before is configured, so the boot times overlap with the I2C transfers.
+ * \return TRUE if a bring-up is in progress and the caller shall poll again after a tick.
+ */
+static bool DIST_ToFService(void) {
+  TickType_t now;
+  bool busy = FALSE;
+  uint8_t res;
+  int i;
+
   for(i=0;i<VL_NOF_DEVICES;i++) {
-    res = VL6180X_InitAndConfigureDevice(&DIST_ToF_Devices[i]);
-    if (res!=ERR_OK) {
-      CLS1_SendStr("ERROR: Failed init of TOF device: ", SHELL_GetStdio()->stdErr);
-      CLS1_SendNum8u(i, SHELL_GetStdio()->stdErr);
-      CLS1_SendStr("\r\n", SHELL_GetStdio()->stdErr);
-      return res;
+    now = xTaskGetTickCount();
+    switch(ToFDevice[i].state) {
+      case DIST_TOF_STATE_OFF:
+        busy = TRUE;
+        if (now-ToFDevice[i].stateTick>=pdMS_TO_TICKS(DIST_TOF_CE_LOW_MS) && !DIST_ToFIsBooting()) {
+          (void)VL6180X_ChipEnable(&DIST_ToF_Devices[i], TRUE); /* enable device: it boots and then answers on the default address */
+          ToFDevice[i].nofInits++;
+          ToFDevice[i].initStartTick = now;
+          DIST_ToFSetState(i, DIST_TOF_STATE_BOOTING);
+        }
+        break;
+      case DIST_TOF_STATE_BOOTING:
+        busy = TRUE;
+        if (VL6180X_CheckBooted()==ERR_OK) {
+          res = VL6180X_SetI2CDeviceAddress(&DIST_ToF_Devices[i]); /* set hardware I2C address */
+          if (res!=ERR_OK) {
+            DIST_ToFFailed(i, "ERROR: Failed set i2C address of TOF device: ");
+          } else {
+            DIST_ToFSetState(i, DIST_TOF_STATE_ADDRESSED);
+          }
+        } else if (now-ToFDevice[i].stateTick>pdMS_TO_TICKS(DIST_TOF_BOOT_TIMEOUT_MS)) {
+          DIST_ToFFailed(i, "ERROR: No boot of TOF device: ");
+        }
+        break;
+      case DIST_TOF_STATE_ADDRESSED:
+        busy = TRUE;
+        res = VL6180X_InitAndConfigureDevice(&DIST_ToF_Devices[i]);
+        if (res==ERR_OK) {
+          res = VL6180X_VerifyConfiguration(&DIST_ToF_Devices[i]);
+        }
+        if (res!=ERR_OK) {
+          DIST_ToFFailed(i, "ERROR: Failed init of TOF device: ");
+        } else {
+          ToFDevice[i].initTicks = xTaskGetTickCount()-ToFDevice[i].initStartTick;
+          ToFDevice[i].profile = DIST_RANGE_PROFILE_PRECISE; /* configured by VL6180X_InitAndConfigureDevice() */
+          DIST_ToFSetState(i, DIST_TOF_STATE_READY);
+        }
+        break;
+      case DIST_TOF_STATE_FAILED:
+        if (now-ToFDevice[i].stateTick>=pdMS_TO_TICKS(DIST_TOF_RETRY_MS)) {
+          DIST_ToFReset(i); /* only this device starts over, the others keep ranging */
+        }
+        break;
+      case DIST_TOF_STATE_READY:
+      default:
+        break;
     }
   }
-  return ERR_OK;
+  return busy;
 }
 
 static void TofTask(void *param) {
   uint8_t res;
-  int errCntr = 0;
   int i;
-  bool initDevices = TRUE;
+  bool busy, allReady, wasReady = FALSE;
+  uint8_t periodMs;
+  VL6180X_Range range;
+  CS1_CriticalVariable()
 
   (void)param;
-  vTaskDelay(pdMS_TO_TICKS(100)); /* wait to give sensor time to power up */
-  /* finished init, run the sensor task */
+  /* disable all devices (CE pin LOW): they are brought up one by one by DIST_ToFService() */
+  for(i=0;i<VL_NOF_DEVICES;i++) {
+    ToFDevice[i].mm = 0;
+    DIST_ToFReset(i);
+  }
+  vTaskDelay(pdMS_TO_TICKS(DIST_TOF_POWERUP_MS)); /* wait to give sensor time to power up */
   for(;;) {
-    if (initDevices) {
-      do {
-        res = InitToF();
-        if (res!=ERR_OK) {
-          CLS1_SendStr("ToF init failed, retry....!\r\n", SHELL_GetStdio()->stdErr);
-          vTaskDelay(pdMS_TO_TICKS(1000));
-        }
-      } while (res!=ERR_OK);
-      CLS1_SendStr("ToF enabled!\r\n", SHELL_GetStdio()->stdOut);
-      initDevices = FALSE;
-    }
+    busy = DIST_ToFService();
+    allReady = TRUE;
+    periodMs = DIST_ToF_Profiles[DIST_RANGE_PROFILE_PRECISE].periodMs;
     for(i=0;i<VL_NOF_DEVICES;i++) {
-      int16_t range;
-
-      range = 0;
-      res = VL6180X_ReadRangeSingle(&DIST_ToF_Devices[i], &range);
+      if (ToFDevice[i].state!=DIST_TOF_STATE_READY) {
+        allReady = FALSE;
+        continue;
+      }
+      if (busy) {
+        continue; /* a single range takes >8 ms: finish the bring-up first, it only takes a few ms */
+      }
+#if PL_CONFIG_HAS_RTOS_TRACE
+      RTRC_UserBegin(RTRC_EVT_TOF_READ);
+#endif
+      res = ERR_OK;
+      if (ToFDevice[i].profile!=ToFDevice[i].profileReq) {
+        res = VL6180X_SetRangeProfile(&DIST_ToF_Devices[i], &DIST_ToF_Profiles[ToFDevice[i].profileReq].vl);
+        if (res==ERR_OK) {
+          ToFDevice[i].profile = ToFDevice[i].profileReq;
+        }
+      }
+      if (res==ERR_OK) {
+        res = VL6180X_ReadRangeSingleExt(&DIST_ToF_Devices[i], &range);
+      }
+#if PL_CONFIG_HAS_RTOS_TRACE
+      RTRC_UserEnd(RTRC_EVT_TOF_READ, (uint16_t)i);
+#endif
       if (res!=ERR_OK) {
         CLS1_SendStr("ToF FAILED!\r\n", SHELL_GetStdio()->stdErr);
-        errCntr++;
+        ToFDevice[i].nofErrors++;
         GI2C1_Deinit();
         GI2C1_Init();
-        initDevices = TRUE; /* re-init devices */
+        DIST_ToFReset(i); /* re-init only this device */
+        allReady = FALSE;
+        continue;
+      }
+      if (ToFDevice[i].firstRangeTick==0) {
+        ToFDevice[i].firstRangeTick = xTaskGetTickCount();
+      }
+      CS1_EnterCritical();
+      ToFDevice[i].range = range;
+      ToFDevice[i].mm = range.mm;
+      CS1_ExitCritical();
+      if (DIST_ToF_Profiles[ToFDevice[i].profile].periodMs<periodMs) {
+        periodMs = DIST_ToF_Profiles[ToFDevice[i].profile].periodMs;
       }
-      ToFDevice[i].mm = range;
     } /* for */
-    vTaskDelay(pdMS_TO_TICKS(50));
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+    if (!busy) {
+      OBST_Update();
+    }
+#endif
+    allReady = allReady && !busy;
+    if (allReady && !wasReady) {
+      CLS1_SendStr("ToF enabled!\r\n", SHELL_GetStdio()->stdOut);
+    }
+    wasReady = allReady;
+    if (busy) {
+      vTaskDelay(1); /* poll the booting device */
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(periodMs)); /* the fastest profile sets the rate of all sensors */
+    }
   }
 }
 #endif /* PL_HAS_TOF_SENSOR */
@@ -23,6 +23,46 @@ typedef enum {
 
 int16_t DIST_GetDistance(DIST_Sensor sensor);
 
+#if PL_HAS_TOF_SENSOR
+#include "VL6180X.h"
+
+/*! \brief Range profiles, trading accuracy for update rate */
+typedef enum {
+  DIST_RANGE_PROFILE_PRECISE, /*!< long convergence and averaging, 0-60 cm, range every 50 ms (default) */
+  DIST_RANGE_PROFILE_FAST,    /*!< short convergence and averaging, noisier, 0-40 cm, range every 10 ms */
+  DIST_RANGE_PROFILE_NOF      /*!< sentinel, number of profiles */
+} DIST_RangeProfile;
+
+/*!
+ * \brief Returns the last measurement of a ToF sensor.
+ * \param sensor Sensor.
+ * \param range Range in mm with status, signal and ambient rate.
+ * \return ERR_OK if the sensor is ready, ERR_NOTAVAIL if it is not fitted or not (yet) initialized.
+ */
+uint8_t DIST_GetRange(DIST_Sensor sensor, VL6180X_Range *range);
+
+/*!
+ * \brief Selects the range profile of a ToF sensor, applied before its next measurement.
+ * \param sensor Sensor.
+ * \param profile Profile to use.
+ */
+void DIST_SetRangeProfile(DIST_Sensor sensor, DIST_RangeProfile profile);
+
+/*! \brief Position and direction of a ToF sensor on the robot */
+typedef struct {
+  int16_t xMm, yMm;   /*!< position relative to the robot center in mm, x forward, y left */
+  int16_t headingDeg; /*!< direction of the beam in degree, 0 is forward, positive to the left */
+} DIST_SensorMount;
+
+/*!
+ * \brief Returns where a ToF sensor is mounted.
+ * \param sensor Sensor.
+ * \param mount Position and direction of the sensor.
+ * \return ERR_OK, ERR_NOTAVAIL if the sensor is not fitted.
+ */
+uint8_t DIST_GetSensorMount(DIST_Sensor sensor, DIST_SensorMount *mount);
+#endif
+
 #if PL_HAS_SIDE_DISTANCE
 bool DIST_5cmLeftOn(void);
 bool DIST_5cmRightOn(void);
@@ -13,6 +13,12 @@
 #include "Tacho.h"
 #include "Pid.h"
 #include "Motor.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
 #endif
@@ -329,31 +335,55 @@ static uint8_t GetCmd(void) {
   return ERR_OK;
 }
 
+void DRV_Step(void) {
+  while (GetCmd()==ERR_OK) { /* returns ERR_RXEMPTY if queue is empty */
+    /* process incoming commands */
+  }
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserBegin(RTRC_EVT_DRIVE_PID);
+#endif
+  if (DRV_Status.mode==DRV_MODE_SPEED) {
+    PID_Speed(TACHO_GetSpeed(TRUE), DRV_Status.speed.left, TRUE);
+    PID_Speed(TACHO_GetSpeed(FALSE), DRV_Status.speed.right, FALSE);
+  } else if (DRV_Status.mode==DRV_MODE_STOP) {
+    PID_Speed(TACHO_GetSpeed(TRUE), 0, TRUE);
+    PID_Speed(TACHO_GetSpeed(FALSE), 0, FALSE);
+  } else if (DRV_Status.mode==DRV_MODE_POS) {
+    PID_Pos(Q4CLeft_GetPos(), DRV_Status.pos.left, TRUE);
+    PID_Pos(Q4CRight_GetPos(), DRV_Status.pos.right, FALSE);
+  } else if (DRV_Status.mode==DRV_MODE_NONE) {
+    /* do nothing */
+  }
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserEnd(RTRC_EVT_DRIVE_PID, (uint16_t)DRV_Status.mode);
+#endif
+}
+
+#if !PL_CONFIG_HAS_CONTROL_LOOP /* otherwise the control loop runs the PID */
 static void DriveTask(void *pvParameters) {
   portTickType xLastWakeTime;
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
 
   (void)pvParameters;
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("Drive", PROF_PERIOD_DELAY_UNTIL, 5);
+#endif
   xLastWakeTime = xTaskGetTickCount();
   for(;;) {
-    while (GetCmd()==ERR_OK) { /* returns ERR_RXEMPTY if queue is empty */
-      /* process incoming commands */
-    }
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
     TACHO_CalcSpeed();
-    if (DRV_Status.mode==DRV_MODE_SPEED) {
-      PID_Speed(TACHO_GetSpeed(TRUE), DRV_Status.speed.left, TRUE);
-      PID_Speed(TACHO_GetSpeed(FALSE), DRV_Status.speed.right, FALSE);
-    } else if (DRV_Status.mode==DRV_MODE_STOP) {
-      PID_Speed(TACHO_GetSpeed(TRUE), 0, TRUE);
-      PID_Speed(TACHO_GetSpeed(FALSE), 0, FALSE);
-    } else if (DRV_Status.mode==DRV_MODE_POS) {
-      PID_Pos(Q4CLeft_GetPos(), DRV_Status.pos.left, TRUE);
-      PID_Pos(Q4CRight_GetPos(), DRV_Status.pos.right, FALSE);
-    } else if (DRV_Status.mode==DRV_MODE_NONE) {
-      /* do nothing */
-    }
+    DRV_Step();
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
     FRTOS1_vTaskDelayUntil(&xLastWakeTime, 5/portTICK_PERIOD_MS);
   } /* for */
 }
+#endif
 
 void DRV_Deinit(void) {
   FRTOS1_vQueueDelete(DRV_Queue);
@@ -370,8 +400,10 @@ void DRV_Init(void) {
     for(;;){} /* out of memory? */
   }
   FRTOS1_vQueueAddToRegistry(DRV_Queue, "Drive");
+#if !PL_CONFIG_HAS_CONTROL_LOOP
   if (FRTOS1_xTaskCreate(DriveTask, "Drive", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY+3, NULL) != pdPASS) {
     for(;;){} /* error */
   }
+#endif
 }
 #endif /* PL_CONFIG_HAS_DRIVE */
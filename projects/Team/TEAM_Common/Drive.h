@@ -47,6 +47,13 @@ bool DRV_HasTurned(void);
  */
 uint8_t DRV_Stop(int32_t timeoutMs);
 
+/*!
+ * \brief Processes the pending drive commands and runs one step of the speed or position PID, with the
+ * speed of the last TACHO_CalcSpeed(). Called every cycle of the control loop (ControlLoop.h),
+ * or every 5 ms by the drive task if the control loop is disabled. The PID gains are tuned for 5 ms.
+ */
+void DRV_Step(void);
+
 /*!
  * \brief Driver initialization.
  */
@@ -55,16 +55,6 @@ typedef enum EVNT_Handle {
   EVNT_SW7_LPRESSED,
   #endif
 #endif
-#if PL_CONFIG_HAS_LCD
-  /* button press events */
-  EVNT_LCD_BTN_LEFT,
-  EVNT_LCD_BTN_RIGHT,
-  EVNT_LCD_BTN_UP,
-  EVNT_LCD_BTN_DOWN,
-  EVNT_LCD_BTN_CENTER,
-  EVNT_LCD_SIDE_BTN_UP,
-  EVNT_LCD_SIDE_BTN_DOWN,
-#endif
 #if PL_CONFIG_HAS_SNAKE_GAME
   /* button press events */
   EVNT_SNAKE_BTN_LEFT,
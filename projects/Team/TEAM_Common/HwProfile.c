@@ -0,0 +1,409 @@
+/**
+ * \file
+ * \brief Hardware profile of the robot, see HwProfile.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The self-test drives the robot with short pulses, each followed by a pulse back to the start:
+ * - one motor after the other: the own encoder has to count (else the encoders are crossed or broken),
+ * - both motors: if the front ToF range changes, the robot moved straight and the sign tells forward
+ *   or backward. If it has only turned, the motors are wired opposite to each other: the pulse is repeated
+ *   with the right motor reversed.
+ * The counting direction of each encoder against the motion of its track tells if the encoder is swapped,
+ * and the counts against the range change give the counts per meter.
+ * Without a target in front of the robot the motors are assumed to be wired like MOT_Init() expects.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_HW_PROFILE
+#include "HwProfile.h"
+#include "Motor.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#include "FRTOS1.h"
+#include "CLS1.h"
+#include "UTIL1.h"
+#include "Shell.h"
+#if PL_HAS_TOF_SENSOR
+  #include "Distance.h"
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  #include "NVM_Config.h"
+#endif
+#if PL_CONFIG_HAS_PID
+  #include "Pid.h"
+#endif
+
+#define HWP_MAGIC                0x4802 /* changes with the layout of HWP_Profile */
+#define HWP_PULSE_PERCENT        25   /* motor speed of the pulses */
+#define HWP_PULSE_MS             100  /* pulse of a single motor */
+#define HWP_STRAIGHT_MS          200  /* pulse of both motors, moves the robot about 4 cm */
+#define HWP_SETTLE_MS            150  /* until the robot stands still again */
+#define HWP_MIN_COUNTS           20   /* minimal encoder counts of a pulse */
+#define HWP_START_DELAY_MS       500  /* ToF sensors ready and hands off the robot */
+#if PL_HAS_TOF_SENSOR
+  #define HWP_RANGE_SAMPLES      3    /* averaged ToF measurements */
+  #define HWP_RANGE_SAMPLE_MS    60   /* longer than the ToF period */
+  #define HWP_MIN_RANGE_CHANGE   10   /* mm, minimal range change of a straight pulse, ToF noise is about 3 mm */
+  #define HWP_MAX_SENSOR_DEG     30   /* sensors looking forward */
+  #define HWP_NOF_SENSORS        (DIST_SENSOR_RIGHT+1)
+#endif
+
+static HWP_Profile HWP_Current; /* profile in use */
+static volatile bool HWP_CalibRequested = FALSE;
+static volatile bool HWP_Calibrating = FALSE;
+
+static uint16_t HWP_Checksum(const HWP_Profile *p) {
+  const uint8_t *b = (const uint8_t*)p;
+  uint16_t sum = 0;
+  size_t i;
+
+  for(i=0;i<sizeof(HWP_Profile)-sizeof(p->checksum);i++) {
+    sum += b[i];
+  }
+  return sum;
+}
+
+static void HWP_SetDefaults(HWP_Profile *p) {
+  p->magic = HWP_MAGIC;
+  p->flags = HWP_FLAG_MOTOR_LEFT_INVERTED; /* as in MOT_Init(): the left motor is mounted mirrored */
+  p->rfChannel = 0;
+  p->posPidSet = 0;
+  p->reserved = 0;
+  p->countsPerM = HWP_CONFIG_COUNTS_PER_M;
+  p->gainLeft = 0;
+  p->gainRight = 0;
+  p->checksum = HWP_Checksum(p);
+}
+
+static void HWP_Apply(const HWP_Profile *p) {
+  MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_LEFT), (p->flags&HWP_FLAG_MOTOR_LEFT_INVERTED)!=0);
+  MOT_Invert(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), (p->flags&HWP_FLAG_MOTOR_RIGHT_INVERTED)!=0);
+  (void)Q4CLeft_SwapPins((p->flags&HWP_FLAG_ENC_LEFT_SWAPPED)!=0);
+  (void)Q4CRight_SwapPins((p->flags&HWP_FLAG_ENC_RIGHT_SWAPPED)!=0);
+}
+
+static uint8_t HWP_Save(HWP_Profile *p) {
+  p->checksum = HWP_Checksum(p);
+#if PL_CONFIG_HAS_CONFIG_NVM
+  return NVMC_SaveHwProfileData(p, sizeof(HWP_Profile));
+#else
+  return ERR_OK; /* kept until the next reset */
+#endif
+}
+
+const HWP_Profile *HWP_Get(void) {
+  return &HWP_Current;
+}
+
+void HWP_StartCalibration(void) {
+  HWP_CalibRequested = TRUE;
+}
+
+bool HWP_IsCalibrating(void) {
+  return HWP_Calibrating || HWP_CalibRequested;
+}
+
+/* drives the motors for a time and waits until the robot stands still, returns the counts and the speed at the end of the pulse */
+static void HWP_Pulse(MOT_SpeedPercent left, MOT_SpeedPercent right, uint16_t ms, int32_t delta[2], int32_t countsPerSec[2]) {
+  int32_t l0, r0, lm, rm;
+
+  l0 = Q4CLeft_GetPos();
+  r0 = Q4CRight_GetPos();
+  MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), left);
+  MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), right);
+  vTaskDelay(pdMS_TO_TICKS(ms/2)); /* the motors speed up */
+  lm = Q4CLeft_GetPos();
+  rm = Q4CRight_GetPos();
+  vTaskDelay(pdMS_TO_TICKS(ms/2));
+  countsPerSec[MOT_MOTOR_LEFT] = ((Q4CLeft_GetPos()-lm)*1000)/(ms/2);
+  countsPerSec[MOT_MOTOR_RIGHT] = ((Q4CRight_GetPos()-rm)*1000)/(ms/2);
+  MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 0);
+  MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 0);
+  vTaskDelay(pdMS_TO_TICKS(HWP_SETTLE_MS));
+  delta[MOT_MOTOR_LEFT] = Q4CLeft_GetPos()-l0;
+  delta[MOT_MOTOR_RIGHT] = Q4CRight_GetPos()-r0;
+}
+
+#if PL_HAS_TOF_SENSOR
+/* averages the ranges of the sensors looking forward, -1 for sensors without a target in every measurement */
+static void HWP_ReadFront(int16_t mm[HWP_NOF_SENSORS]) {
+  int32_t sum[HWP_NOF_SENSORS] = {0};
+  int cnt[HWP_NOF_SENSORS] = {0};
+  DIST_SensorMount mount;
+  VL6180X_Range range;
+  int i, k;
+
+  for(k=0;k<HWP_RANGE_SAMPLES;k++) {
+    vTaskDelay(pdMS_TO_TICKS(HWP_RANGE_SAMPLE_MS));
+    for(i=0;i<HWP_NOF_SENSORS;i++) {
+      if (DIST_GetSensorMount((DIST_Sensor)i, &mount)==ERR_OK
+          && mount.headingDeg>=-HWP_MAX_SENSOR_DEG && mount.headingDeg<=HWP_MAX_SENSOR_DEG
+          && DIST_GetRange((DIST_Sensor)i, &range)==ERR_OK && range.status==VL6180X_RANGE_STATUS_OK)
+      {
+        sum[i] += range.mm;
+        cnt[i]++;
+      }
+    }
+  }
+  for(i=0;i<HWP_NOF_SENSORS;i++) {
+    mm[i] = (int16_t)(cnt[i]==HWP_RANGE_SAMPLES ? sum[i]/HWP_RANGE_SAMPLES : -1);
+  }
+}
+
+/* mean range change of the sensors which have seen the target before and after, returns FALSE if there are none */
+static bool HWP_RangeChange(const int16_t before[HWP_NOF_SENSORS], const int16_t after[HWP_NOF_SENSORS], int16_t *change) {
+  int32_t sum = 0;
+  int i, n = 0;
+
+  for(i=0;i<HWP_NOF_SENSORS;i++) {
+    if (before[i]>=0 && after[i]>=0) {
+      sum += after[i]-before[i];
+      n++;
+    }
+  }
+  if (n==0) {
+    return FALSE;
+  }
+  *change = (int16_t)(sum/n);
+  return TRUE;
+}
+#endif /* PL_HAS_TOF_SENSOR */
+
+#if PL_HAS_TOF_SENSOR
+/* drives both motors straight and back again, returns TRUE if the front range changed: the robot has not only turned */
+static bool HWP_StraightPulse(MOT_SpeedPercent left, MOT_SpeedPercent right, int32_t delta[2], int16_t *change) {
+  int16_t before[HWP_NOF_SENSORS], after[HWP_NOF_SENSORS];
+  int32_t back[2], rate[2];
+
+  HWP_ReadFront(before);
+  HWP_Pulse(left, right, HWP_STRAIGHT_MS, delta, rate);
+  HWP_ReadFront(after);
+  HWP_Pulse((MOT_SpeedPercent)-left, (MOT_SpeedPercent)-right, HWP_STRAIGHT_MS, back, rate); /* back to the start */
+  return HWP_RangeChange(before, after, change) && (*change<=-HWP_MIN_RANGE_CHANGE || *change>=HWP_MIN_RANGE_CHANGE);
+}
+#endif
+
+static uint8_t HWP_SelfTest(HWP_Profile *p, const CLS1_StdIOType *io) {
+  static const uint8_t invFlag[2] = {HWP_FLAG_MOTOR_LEFT_INVERTED, HWP_FLAG_MOTOR_RIGHT_INVERTED};
+  static const uint8_t swapFlag[2] = {HWP_FLAG_ENC_LEFT_SWAPPED, HWP_FLAG_ENC_RIGHT_SWAPPED};
+  static const char *const sideName[2] = {"left", "right"};
+  int32_t delta[2], back[2], rate[2], backRate[2], counts[2], own, other, gain;
+  int8_t fwd[2] = {1, 1}; /* physical direction of a positive speed, assumed forward */
+  bool dirKnown = FALSE;
+  int side;
+#if PL_HAS_TOF_SENSOR
+  int16_t change = 0;
+#endif
+
+  HWP_SetDefaults(p);
+  p->rfChannel = HWP_Current.rfChannel; /* not part of the self-test */
+  p->posPidSet = HWP_Current.posPidSet;
+  HWP_Apply(p); /* wiring as expected by MOT_Init(), encoders not swapped */
+  /* each motor alone: its own encoder has to count */
+  for(side=MOT_MOTOR_LEFT;side<=MOT_MOTOR_RIGHT;side++) {
+    HWP_Pulse(side==MOT_MOTOR_LEFT ? HWP_PULSE_PERCENT : 0, side==MOT_MOTOR_RIGHT ? HWP_PULSE_PERCENT : 0, HWP_PULSE_MS, delta, rate);
+    HWP_Pulse(side==MOT_MOTOR_LEFT ? -HWP_PULSE_PERCENT : 0, side==MOT_MOTOR_RIGHT ? -HWP_PULSE_PERCENT : 0, HWP_PULSE_MS, back, backRate); /* back to the start */
+    own = delta[side];
+    other = delta[1-side];
+    if (own>-HWP_MIN_COUNTS && own<HWP_MIN_COUNTS) {
+      CLS1_SendStr((unsigned char*)"hwp: no counts from the ", io->stdErr);
+      CLS1_SendStr((unsigned char*)sideName[side], io->stdErr);
+      CLS1_SendStr((unsigned char*)(other<=-HWP_MIN_COUNTS || other>=HWP_MIN_COUNTS ? " encoder, encoders crossed?\r\n" : " encoder, motor or encoder broken?\r\n"), io->stdErr);
+      return ERR_FAILED;
+    }
+    counts[side] = own;
+    gain = ((own<0 ? -rate[side] : rate[side])*100)/HWP_PULSE_PERCENT; /* speed at the end of the forward pulse, extrapolated to 100% */
+    if (gain<0) {
+      gain = 0; /* still coasting against the pulse: unknown */
+    } else if (gain>0xffff) {
+      gain = 0xffff;
+    }
+    if (side==MOT_MOTOR_LEFT) {
+      p->gainLeft = (uint16_t)gain;
+    } else {
+      p->gainRight = (uint16_t)gain;
+    }
+  }
+#if PL_HAS_TOF_SENSOR
+  /* both motors: if the target comes closer or goes away, the robot has moved straight, else it has turned */
+  if (HWP_StraightPulse(HWP_PULSE_PERCENT, HWP_PULSE_PERCENT, delta, &change)) {
+    dirKnown = TRUE;
+    fwd[MOT_MOTOR_LEFT] = fwd[MOT_MOTOR_RIGHT] = (int8_t)(change<0 ? 1 : -1);
+  } else if (HWP_StraightPulse(HWP_PULSE_PERCENT, -HWP_PULSE_PERCENT, delta, &change)) {
+    dirKnown = TRUE; /* the motors are wired the opposite way to each other */
+    fwd[MOT_MOTOR_LEFT] = (int8_t)(change<0 ? 1 : -1);
+    fwd[MOT_MOTOR_RIGHT] = (int8_t)-fwd[MOT_MOTOR_LEFT];
+  }
+#endif
+  for(side=MOT_MOTOR_LEFT;side<=MOT_MOTOR_RIGHT;side++) {
+    if (fwd[side]<0) {
+      p->flags ^= invFlag[side]; /* the motor drove backward */
+    }
+    if ((counts[side]<0)==(fwd[side]>0)) {
+      p->flags |= swapFlag[side]; /* the encoder counted against the motion */
+    }
+  }
+  HWP_Apply(p);
+  if (!dirKnown) {
+    CLS1_SendStr((unsigned char*)"hwp: no target in front, forward direction assumed\r\n", io->stdOut);
+    return ERR_OK;
+  }
+  p->flags |= HWP_FLAG_DIRECTION_MEASURED;
+#if PL_HAS_TOF_SENSOR
+  if (change<=-2*HWP_MIN_RANGE_CHANGE || change>=2*HWP_MIN_RANGE_CHANGE) {
+    own = (((delta[MOT_MOTOR_LEFT]<0 ? -delta[MOT_MOTOR_LEFT] : delta[MOT_MOTOR_LEFT])
+           +(delta[MOT_MOTOR_RIGHT]<0 ? -delta[MOT_MOTOR_RIGHT] : delta[MOT_MOTOR_RIGHT]))*1000)/(2*(change<0 ? -change : change));
+    if (own>=HWP_CONFIG_COUNTS_PER_M/2 && own<=2*HWP_CONFIG_COUNTS_PER_M) { /* plausible? */
+      p->countsPerM = (uint16_t)own;
+      p->flags |= HWP_FLAG_COUNTS_MEASURED;
+    }
+  }
+#endif
+  return ERR_OK;
+}
+
+static void HwpTask(void *param) {
+  HWP_Profile profile;
+  const CLS1_StdIOType *io = SHELL_GetStdio();
+
+  (void)param;
+  for(;;) {
+    if (HWP_CalibRequested) {
+      HWP_Calibrating = TRUE;
+      HWP_CalibRequested = FALSE;
+      vTaskDelay(pdMS_TO_TICKS(HWP_START_DELAY_MS));
+      CLS1_SendStr((unsigned char*)"hwp: self-test...\r\n", io->stdOut);
+      if (HWP_SelfTest(&profile, io)==ERR_OK) {
+        HWP_Current = profile;
+        if (HWP_Save(&HWP_Current)!=ERR_OK) {
+          CLS1_SendStr((unsigned char*)"hwp: saving profile failed!\r\n", io->stdErr);
+        }
+        CLS1_SendStr((unsigned char*)"hwp: ...done\r\n", io->stdOut);
+      } else {
+        HWP_Apply(&HWP_Current); /* keep the old profile */
+        CLS1_SendStr((unsigned char*)"hwp: ...FAILED!\r\n", io->stdErr);
+      }
+      HWP_Calibrating = FALSE;
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void HWP_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"hwp", (unsigned char*)"Group of hardware profile commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  calibrate", (unsigned char*)"Runs the motor self-test, robot on the floor with an obstacle 5-30 cm in front\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  channel <n>", (unsigned char*)"Sets the radio channel, 0 for the default\r\n", io->stdOut);
+#if PL_CONFIG_HAS_PID
+  CLS1_SendHelpStr((unsigned char*)"  pid <n>", (unsigned char*)"Sets the position PID gains of this robot (0: default/L6, 1: L1), after the next reset\r\n", io->stdOut);
+#endif
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Sets the default profile, keeps the radio channel and the PID gains\r\n", io->stdOut);
+}
+
+static void HWP_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  const HWP_Profile *p = &HWP_Current;
+
+  CLS1_SendStatusStr((unsigned char*)"hwp", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)(p->flags&HWP_FLAG_MOTOR_LEFT_INVERTED ? "left inverted" : "left normal"));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(p->flags&HWP_FLAG_MOTOR_RIGHT_INVERTED ? ", right inverted" : ", right normal"));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(p->flags&HWP_FLAG_DIRECTION_MEASURED ? "\r\n" : " (assumed)\r\n"));
+  CLS1_SendStatusStr((unsigned char*)"  motors", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)(p->flags&HWP_FLAG_ENC_LEFT_SWAPPED ? "left swapped" : "left normal"));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(p->flags&HWP_FLAG_ENC_RIGHT_SWAPPED ? ", right swapped\r\n" : ", right normal\r\n"));
+  CLS1_SendStatusStr((unsigned char*)"  encoders", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16u(buf, sizeof(buf), p->countsPerM);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(p->flags&HWP_FLAG_COUNTS_MEASURED ? "\r\n" : " (default)\r\n"));
+  CLS1_SendStatusStr((unsigned char*)"  counts/m", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"left ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), p->gainLeft);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", right ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), p->gainRight);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" counts/s at 100%\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  gain", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum8u(buf, sizeof(buf), p->rfChannel);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(p->rfChannel==0 ? " (default)\r\n" : "\r\n"));
+  CLS1_SendStatusStr((unsigned char*)"  channel", buf, io->stdOut);
+#if PL_CONFIG_HAS_PID
+  buf[0] = '\0';
+  UTIL1_strcatNum8u(buf, sizeof(buf), p->posPidSet);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(p->posPidSet==0 ? " (default)\r\n" : "\r\n"));
+  CLS1_SendStatusStr((unsigned char*)"  pid", buf, io->stdOut);
+#endif
+  CLS1_SendStatusStr((unsigned char*)"  self-test", (unsigned char*)(HWP_IsCalibrating() ? "running\r\n" : "idle\r\n"), io->stdOut);
+}
+
+uint8_t HWP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  const unsigned char *p;
+  uint8_t val, pidSet;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"hwp help")==0) {
+    HWP_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"hwp status")==0) {
+    HWP_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"hwp calibrate")==0) {
+    HWP_StartCalibration();
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"hwp channel ", sizeof("hwp channel ")-1)==0) {
+    p = cmd+sizeof("hwp channel ")-1;
+    *handled = TRUE;
+    if (UTIL1_ScanDecimal8uNumber(&p, &val)!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    HWP_Current.rfChannel = val; /* used after the next reset */
+    return HWP_Save(&HWP_Current);
+#if PL_CONFIG_HAS_PID
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"hwp pid ", sizeof("hwp pid ")-1)==0) {
+    p = cmd+sizeof("hwp pid ")-1;
+    *handled = TRUE;
+    if (UTIL1_ScanDecimal8uNumber(&p, &val)!=ERR_OK || val>=PID_NOF_POS_GAINS) {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    HWP_Current.posPidSet = val; /* used by PID_Init() after the next reset */
+    return HWP_Save(&HWP_Current);
+#endif
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"hwp reset")==0) {
+    val = HWP_Current.rfChannel; /* not part of the profile of the wiring */
+    pidSet = HWP_Current.posPidSet;
+    HWP_SetDefaults(&HWP_Current);
+    HWP_Current.rfChannel = val;
+    HWP_Current.posPidSet = pidSet;
+    HWP_Apply(&HWP_Current);
+    *handled = TRUE;
+    return HWP_Save(&HWP_Current);
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void HWP_Deinit(void) {
+  /* nothing needed */
+}
+
+void HWP_Init(void) {
+#if PL_CONFIG_HAS_CONFIG_NVM
+  const HWP_Profile *stored = (const HWP_Profile*)NVMC_GetHwProfileData();
+
+  if (stored!=NULL && stored->magic==HWP_MAGIC && stored->checksum==HWP_Checksum(stored)) {
+    HWP_Current = *stored;
+  } else {
+    HWP_SetDefaults(&HWP_Current);
+    HWP_CalibRequested = TRUE; /* new or repaired robot: self-test after the start */
+  }
+#else
+  HWP_SetDefaults(&HWP_Current);
+#endif
+  HWP_Apply(&HWP_Current);
+  if (xTaskCreate(HwpTask, "HwProfile", 800/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+1, NULL) != pdPASS) {
+    for(;;){} /* error */
+  }
+}
+
+#endif /* PL_CONFIG_HAS_HW_PROFILE */
@@ -0,0 +1,78 @@
+/**
+ * \file
+ * \brief Interface of the hardware profile of the robot.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The hardware profile describes how the motors and encoders of this robot are wired and how
+ * fast they are. It is determined by a self-test which pulses each motor briefly and watches the
+ * encoders and the front ToF sensors, and it is kept in the non-volatile memory.
+ * All modules read the robot specific values with HWP_Get() instead of comparing the UID of the robot.
+ */
+
+#ifndef HWPROFILE_H_
+#define HWPROFILE_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_HW_PROFILE
+
+#ifndef HWP_CONFIG_COUNTS_PER_M
+  #define HWP_CONFIG_COUNTS_PER_M  (7350) /*!< quadrature counts per meter of track if it cannot be measured */
+#endif
+
+#define HWP_FLAG_MOTOR_LEFT_INVERTED   (1<<0) /*!< MOT_Invert() for the left motor */
+#define HWP_FLAG_MOTOR_RIGHT_INVERTED  (1<<1) /*!< MOT_Invert() for the right motor */
+#define HWP_FLAG_ENC_LEFT_SWAPPED      (1<<2) /*!< Q4CLeft_SwapPins() */
+#define HWP_FLAG_ENC_RIGHT_SWAPPED     (1<<3) /*!< Q4CRight_SwapPins() */
+#define HWP_FLAG_DIRECTION_MEASURED    (1<<4) /*!< forward direction of the motors seen with the ToF sensors, else assumed */
+#define HWP_FLAG_COUNTS_MEASURED       (1<<5) /*!< counts per meter measured with the ToF sensors, else HWP_CONFIG_COUNTS_PER_M */
+
+/*! \brief Hardware profile record, as stored in the non-volatile memory */
+typedef struct {
+  uint16_t magic;       /*!< HWP_MAGIC for a valid record */
+  uint8_t flags;        /*!< HWP_FLAG_* */
+  uint8_t rfChannel;    /*!< radio channel, 0 for the default of the radio */
+  uint8_t posPidSet;    /*!< gains of the position PID tuned for this robot, see PID_Init(), 0 for the default */
+  uint8_t reserved;     /*!< keeps the 16bit members aligned, 0 */
+  uint16_t countsPerM;  /*!< quadrature counts per meter of track */
+  uint16_t gainLeft;    /*!< left motor speed in quadrature counts per second, extrapolated to 100% PWM */
+  uint16_t gainRight;   /*!< right motor speed in quadrature counts per second, extrapolated to 100% PWM */
+  uint16_t checksum;    /*!< 16bit sum of the other bytes */
+} HWP_Profile;
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t HWP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Returns the hardware profile of this robot.
+ * \return Pointer to the profile, the defaults if the robot has not been calibrated.
+ */
+const HWP_Profile *HWP_Get(void);
+
+/*!
+ * \brief Requests the self-test, which runs in its own task. The robot has to stand on the floor,
+ * with an obstacle 5-30 cm in front of it to find the forward direction and the counts per meter.
+ */
+void HWP_StartCalibration(void);
+
+/*! \brief Returns TRUE while the self-test is running */
+bool HWP_IsCalibrating(void);
+
+/*! \brief Driver de-initialization */
+void HWP_Deinit(void);
+
+/*! \brief Driver initialization, applies the stored profile to the motors and encoders */
+void HWP_Init(void);
+
+#endif /* PL_CONFIG_HAS_HW_PROFILE */
+
+#endif /* HWPROFILE_H_ */
@@ -3,7 +3,8 @@
  * \brief Key debouncing implementation.
  * \author Erich Styger, erich.styger@hslu.ch
  *
- * This module implements debouncing of up to 4 Keys.
+ * This module implements debouncing of up to 7 Keys.
+ * The keys are sampled every KEYDBNC_SAMPLE_MS and debounced all together.
  */
 
 #include "Platform.h"
@@ -11,8 +12,21 @@
 #include "KeyDebounce.h"
 #include "Keys.h"
 #include "Debounce.h"
-#include "Trigger.h"
+#include "Timer.h"
 #include "Event.h"
+#if PL_CONFIG_HAS_LCD
+  #include "LCD.h"
+#endif
+
+#define KEYDBNC_SAMPLE_MS           10 /* sampling period, debounce time is DBNC_NOF_SAMPLES times this value */
+#define KEYDBNC_LONG_TICKS          (5000/KEYDBNC_SAMPLE_MS) /* long key press time */
+#if PL_CONFIG_HAS_LCD || PL_CONFIG_HAS_SNAKE_GAME
+  #define KEYDBNC_REPEAT_DELAY_TICKS  (500/KEYDBNC_SAMPLE_MS) /* navigation keys: time until the first repeat */
+  #define KEYDBNC_REPEAT_TICKS        (150/KEYDBNC_SAMPLE_MS) /* navigation keys: time between repeats */
+#else
+  #define KEYDBNC_REPEAT_DELAY_TICKS  0 /* no repeat */
+  #define KEYDBNC_REPEAT_TICKS        0
+#endif
 
 
 /*!
@@ -73,7 +87,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<0)) {
         EVNT_SetEvent(EVNT_SW1_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_BTN_RIGHT);
+		LCD_SetEvent(LCD_BTN_RIGHT);
 	#endif
 	#if PL_CONFIG_HAS_SNAKE_GAME
 		EVNT_SetEvent(EVNT_SNAKE_BTN_RIGHT);
@@ -84,7 +98,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<1)) {
         EVNT_SetEvent(EVNT_SW2_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_BTN_LEFT);
+		LCD_SetEvent(LCD_BTN_LEFT);
 	#endif
 	#if PL_CONFIG_HAS_SNAKE_GAME
 		EVNT_SetEvent(EVNT_SNAKE_BTN_LEFT);
@@ -95,7 +109,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<2)) {
         EVNT_SetEvent(EVNT_SW3_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_BTN_DOWN);
+		LCD_SetEvent(LCD_BTN_DOWN);
 	#endif
 	#if PL_CONFIG_HAS_SNAKE_GAME
 		EVNT_SetEvent(EVNT_SNAKE_BTN_DOWN);
@@ -106,7 +120,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<3)) {
         EVNT_SetEvent(EVNT_SW4_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_BTN_CENTER);
+		LCD_SetEvent(LCD_BTN_CENTER);
 	#endif
 	#if PL_CONFIG_HAS_SNAKE_GAME
 		EVNT_SetEvent(EVNT_SNAKE_BTN_CENTER);
@@ -117,7 +131,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<4)) {
         EVNT_SetEvent(EVNT_SW5_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_BTN_UP);
+		LCD_SetEvent(LCD_BTN_UP);
 	#endif
 	#if PL_CONFIG_HAS_SNAKE_GAME
 		EVNT_SetEvent(EVNT_SNAKE_BTN_UP);
@@ -128,7 +142,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<5)) {
         EVNT_SetEvent(EVNT_SW6_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_SIDE_BTN_DOWN);
+		LCD_SetEvent(LCD_SIDE_BTN_DOWN);
 	#endif
       }
 #endif
@@ -136,7 +150,7 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       if (keys&(1<<6)) {
         EVNT_SetEvent(EVNT_SW7_PRESSED);
 	#if PL_CONFIG_HAS_LCD
-		EVNT_SetEvent(EVNT_LCD_SIDE_BTN_UP);
+		LCD_SetEvent(LCD_SIDE_BTN_UP);
 	#endif
       }
 #endif
@@ -219,49 +233,96 @@ static void KEYDBNC_OnDebounceEvent(DBNC_EventKinds event, DBNC_KeySet keys) {
       }
 #endif
       break;
-    case DBNC_EVENT_END:
-      /*! \todo Implement what you have to do at the end of the debouncing. Check if you have to re-enable interrupts! */
-    #if PL_CONFIG_HAS_KBI
-      KEY_EnableInterrupts();
-    #endif
+    /* held down: repeat navigation */
+    case DBNC_EVENT_REPEAT:
+#if PL_CONFIG_NOF_KEYS >= 1
+      if (keys&(1<<0)) {
+	#if PL_CONFIG_HAS_LCD
+		LCD_SetEvent(LCD_BTN_RIGHT);
+	#endif
+	#if PL_CONFIG_HAS_SNAKE_GAME
+		EVNT_SetEvent(EVNT_SNAKE_BTN_RIGHT);
+	#endif
+      }
+#endif
+#if PL_CONFIG_NOF_KEYS >= 2
+      if (keys&(1<<1)) {
+	#if PL_CONFIG_HAS_LCD
+		LCD_SetEvent(LCD_BTN_LEFT);
+	#endif
+	#if PL_CONFIG_HAS_SNAKE_GAME
+		EVNT_SetEvent(EVNT_SNAKE_BTN_LEFT);
+	#endif
+      }
+#endif
+#if PL_CONFIG_NOF_KEYS >= 3
+      if (keys&(1<<2)) {
+	#if PL_CONFIG_HAS_LCD
+		LCD_SetEvent(LCD_BTN_DOWN);
+	#endif
+	#if PL_CONFIG_HAS_SNAKE_GAME
+		EVNT_SetEvent(EVNT_SNAKE_BTN_DOWN);
+	#endif
+      }
+#endif
+#if PL_CONFIG_NOF_KEYS >= 5
+      if (keys&(1<<4)) {
+	#if PL_CONFIG_HAS_LCD
+		LCD_SetEvent(LCD_BTN_UP);
+	#endif
+	#if PL_CONFIG_HAS_SNAKE_GAME
+		EVNT_SetEvent(EVNT_SNAKE_BTN_UP);
+	#endif
+      }
+#endif
       break;
   } /* switch */
 }
 
-/*! \brief This struct contains all the data and pointers needed to have
- *         our debounce FSM reentrant and usable for multiple ISR's.
- */
-static DBNC_FSMData KEYDBNC_FSMdata = {
-  /* callbacks: */
+/*! \brief Per key timing, in KEYDBNC_SAMPLE_MS ticks. Only the navigation keys repeat. */
+static const DBNC_KeyTiming KEYDBNC_Timing[DBNC_MAX_KEYS] = {
+  /* long press,        repeat delay,               repeat */
+  {KEYDBNC_LONG_TICKS, KEYDBNC_REPEAT_DELAY_TICKS, KEYDBNC_REPEAT_TICKS}, /* SW1: right */
+  {KEYDBNC_LONG_TICKS, KEYDBNC_REPEAT_DELAY_TICKS, KEYDBNC_REPEAT_TICKS}, /* SW2: left */
+  {KEYDBNC_LONG_TICKS, KEYDBNC_REPEAT_DELAY_TICKS, KEYDBNC_REPEAT_TICKS}, /* SW3: down */
+  {KEYDBNC_LONG_TICKS, 0, 0},                                             /* SW4: center */
+  {KEYDBNC_LONG_TICKS, KEYDBNC_REPEAT_DELAY_TICKS, KEYDBNC_REPEAT_TICKS}, /* SW5: up */
+  {KEYDBNC_LONG_TICKS, 0, 0},                                             /* SW6: side down */
+  {KEYDBNC_LONG_TICKS, 0, 0},                                             /* SW7: side up */
+  {0, 0, 0},                                                              /* unused */
+};
+
+/*! \brief Debouncing data for all our keys. */
+static DBNC_Data KEYDBNC_Data = {
   KEYDBNC_GetKeys, /* returns bit set of pressed keys */
   KEYDBNC_OnDebounceEvent, /* event callback */
-  /* data: */
-  DBNC_KEY_IDLE, /* initial state machine state, here the state is stored */
-  0, /* key scan value */
-  0, /* long key count */
-  TRG_KEYPRESS, /* trigger to be used */
-  //(50/TRG_TICKS_MS), /*debounceTicks */
-  (40/TRG_TICKS_MS), /*debounceTicks --> fr Snake Game um Reaktionszeit der Schlange zu verkrzen */
-  //(500/TRG_TICKS_MS), /* longKeyTicks for x ms */
-  (5000/TRG_TICKS_MS), /* longKeyTicks for x ms */
+  KEYDBNC_Timing, /* per key timing */
+  PL_CONFIG_NOF_KEYS, /* number of keys */
 };
 
 void KEYDBNC_Process(void) {
-  /** \todo check/call DBNC_Process(&KEYDBNC_FSMdata);
-   * But be careful: only if we are not debouncing, and if we have a key press if we are polling.
-   * And you will need to disable the keyboard interrupts too!
-   */
-  /*! \todo Only debounce if you are not debouncing already */
-  if (KEYDBNC_FSMdata.state == DBNC_KEY_IDLE && KEYDBNC_GetKeys()!= 0) { /* a key is pressed and we are not debouncing */
-  #if PL_CONFIG_HAS_KBI
-    KEY_DisableInterrupts(); /* disable interrupts for all keys */
-  #endif
-    DBNC_Process(&KEYDBNC_FSMdata); /* starts the state machine */
+  DBNC_Process(&KEYDBNC_Data); /* sample and debounce all keys */
+}
+
+void KEYDBNC_AddTick(void) {
+  static uint8_t cntr = 0;
+
+  cntr++;
+  if (cntr>=KEYDBNC_SAMPLE_MS/TMR_TICK_MS) {
+    cntr = 0;
+    KEYDBNC_Process();
   }
 }
 
+bool KEYDBNC_IsIdle(void) {
+  return KEYDBNC_Data.state==0 && KEYDBNC_GetKeys()==0;
+}
+
 void KEYDBNC_Init(void) {
-  KEYDBNC_FSMdata.state = DBNC_KEY_IDLE;
+  DBNC_Reset(&KEYDBNC_Data);
+#if PL_CONFIG_HAS_KBI
+  KEY_DisableInterrupts(); /* keys are sampled periodically, no need for interrupts */
+#endif
 }
 
 void KEYDBNC_Deinit(void) {
@@ -269,4 +330,3 @@ void KEYDBNC_Deinit(void) {
 }
 
 #endif /* PL_CONFIG_HAS_DEBOUNCE */
-
@@ -12,10 +12,21 @@
 #include "Platform.h"
 #if PL_CONFIG_HAS_DEBOUNCE
 /*!
- * \brief Kicks the debouncing state machine.
+ * \brief Samples all keys and debounces them.
  */
 void KEYDBNC_Process(void);
 
+/*!
+ * \brief Called from the timer interrupt every TMR_TICK_MS, samples the keys with the debouncing period.
+ */
+void KEYDBNC_AddTick(void);
+
+/*!
+ * \brief Used to decide if the periodic key sampling can be suspended (e.g. for tickless idle mode).
+ * \return TRUE if no key is pressed and no debouncing is in progress.
+ */
+bool KEYDBNC_IsIdle(void);
+
 /*!
  * \brief Driver initialization.
  */
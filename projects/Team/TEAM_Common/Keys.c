@@ -16,6 +16,9 @@
 #if PL_CONFIG_HAS_DEBOUNCE
   #include "KeyDebounce.h"
 #endif
+#if PL_CONFIG_HAS_LCD
+  #include "LCD.h"
+#endif
 #if PL_CONFIG_BOARD_IS_ROBO_V2
   #include "PORT_PDD.h"
 #endif
@@ -31,7 +34,7 @@ void KEY_Scan(void) {
   if (KEY1_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW1_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_BTN_RIGHT);
+    LCD_SetEvent(LCD_BTN_RIGHT);
 #endif
   }
 #endif
@@ -40,7 +43,7 @@ void KEY_Scan(void) {
   if (KEY2_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW2_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_BTN_LEFT);
+    LCD_SetEvent(LCD_BTN_LEFT);
 #endif
   }
 #endif
@@ -48,7 +51,7 @@ void KEY_Scan(void) {
   if (KEY3_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW3_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_BTN_DOWN);
+    LCD_SetEvent(LCD_BTN_DOWN);
 #endif
   }
 #endif
@@ -56,7 +59,7 @@ void KEY_Scan(void) {
   if (KEY4_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW4_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_BTN_CENTER);
+    LCD_SetEvent(LCD_BTN_CENTER);
 #endif
   }
 #endif
@@ -64,7 +67,7 @@ void KEY_Scan(void) {
   if (KEY5_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW5_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_BTN_UP);
+    LCD_SetEvent(LCD_BTN_UP);
 #endif
   }
 #endif
@@ -72,7 +75,7 @@ void KEY_Scan(void) {
   if (KEY6_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW6_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_SIDE_BTN_DOWN);
+    LCD_SetEvent(LCD_SIDE_BTN_DOWN);
 #endif
   }
 #endif
@@ -80,7 +83,7 @@ void KEY_Scan(void) {
   if (KEY7_Get()) { /* key pressed */
     EVNT_SetEvent(EVNT_SW7_PRESSED);
 #if PL_CONFIG_HAS_LCD
-    EVNT_SetEvent(EVNT_LCD_SIDE_BTN_UP);
+    LCD_SetEvent(LCD_SIDE_BTN_UP);
 #endif
   }
 #endif
@@ -144,7 +147,7 @@ void KEY_OnInterrupt(KEY_Buttons button) {
   SYS1_RecordEnterISR();
 #endif
 #if PL_CONFIG_HAS_DEBOUNCE
-  KEYDBNC_Process(); /* debounce key(s) */
+  (void)button; /* keys are sampled periodically by the debouncing, see KEYDBNC_AddTick() */
 #else
   /* no debounce, only setting event */
   switch(button) {
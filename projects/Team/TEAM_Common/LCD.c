@@ -13,13 +13,24 @@
 #include "GDisp1.h"
 #include "GFONT1.h"
 #include "FDisp1.h"
+#include "LCDDirty.h"
 #include "Application.h"
 #include "UTIL1.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
 #include "LCD_LED.h"
 #include "Event.h"
 #include "FRTOS1.h"
 #if PL_CONFIG_HAS_RADIO  //Lab 28: at the moment there is no Radio-Module
   #include "RApp.h"
+  #include "RNet_App.h"
+#endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  #include "RadioLink.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
 #endif
 #endif
 #include "LCDMenu.h"
@@ -27,10 +38,17 @@
 #include "Snake.h"
 
 
+#define LCD_CONFIG_LIVE_REFRESH_MS  1000 /* refresh period of visible live menu items */
+
+/* direct task notification bits: the lower bits are the LCD_BTN_Events */
+#define LCD_NOTIFY_KEYS     ((1<<LCD_BTN_LEFT_RELEASE)-1) /* key press events */
+#define LCD_NOTIFY_REDRAW   (1<<16) /* display has been overwritten, repaint the menu */
+#define LCD_NOTIFY_VALUES   (1<<17) /* new live values are available */
+
 /* status variables */
 static bool LedBackLightisOn = TRUE;
 static bool remoteModeIsOn = FALSE;
-static bool requestLCDUpdate = FALSE;
+static TaskHandle_t lcdTaskHndl = NULL;
 
 #if PL_CONFIG_HAS_LCD_MENU
 typedef enum {
@@ -51,7 +69,12 @@ typedef enum {
   //fr remote befehle
   LCD_MENU_ID_SUMO_START_STOP,
   LCD_MENU_ID_BATTERY_VOLTAGE,
-  LCD_MENU_ID_MINT_TOF_SENSOR
+  LCD_MENU_ID_MINT_TOF_SENSOR,
+  LCD_MENU_ID_LINK_LOSS,
+  LCD_MENU_ID_LINK_RTT,
+  LCD_MENU_ID_LAPS,
+  LCD_MENU_ID_LAP_LAST,
+  LCD_MENU_ID_LAP_BEST
 } LCD_MenuIDs;
 
 //fr remote befehle
@@ -304,6 +327,13 @@ static LCDMenu_StatusFlags RobotRemoteMenuHandler(const struct LCDMenu_MenuItem_
       *dataP = remoteValues.battVoltage.str;
       flags |= LCDMENU_STATUS_FLAGS_HANDLED|LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
     }
+  } else if (event==LCDMENU_EVENT_REFRESH) { /* live item visible: ask the robot for a new value, keep showing the old one */
+    if (item->id==LCD_MENU_ID_BATTERY_VOLTAGE) {
+      (void)RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_QUERY_VALUE, RAPP_MSG_TYPE_DATA_ID_BATTERY_V, 0, RNWK_ADDR_BROADCAST, RPHY_PACKET_FLAGS_NONE);
+    } else if (item->id==LCD_MENU_ID_MINT_TOF_SENSOR) {
+      (void)RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_QUERY_VALUE, RAPP_MSG_TYPE_DATA_ID_TOF_VALUES, 0, RNWK_ADDR_BROADCAST, RPHY_PACKET_FLAGS_NONE);
+    }
+    flags |= LCDMENU_STATUS_FLAGS_HANDLED;
   } else if (event==LCDMENU_EVENT_ENTER || event==LCDMENU_EVENT_RIGHT) { /* force update */
     uint16_t dataID = RAPP_MSG_TYPE_DATA_ID_NONE; /* default value, will be overwritten below */
     uint8_t msgType = 0;
@@ -341,6 +371,49 @@ static LCDMenu_StatusFlags RobotRemoteMenuHandler(const struct LCDMenu_MenuItem_
   return flags;
 }
 #endif
+
+#if PL_CONFIG_HAS_RADIO_LINK
+static LCDMenu_StatusFlags RadioLinkMenuHandler(const struct LCDMenu_MenuItem_ *item, LCDMenu_EventType event, void **dataP) {
+  static uint8_t lossBuf[sizeof("Loss:100% fair")+1], rttBuf[sizeof("RTT:65535ms R2.55")+1];
+  LCDMenu_StatusFlags flags = LCDMENU_STATUS_FLAGS_NONE;
+
+  if (event==LCDMENU_EVENT_GET_TEXT && dataP!=NULL) {
+    if (item->id==LCD_MENU_ID_LINK_LOSS) {
+      RLINK_GetLinkString(RNETA_GetDestAddr(), lossBuf, sizeof(lossBuf), FALSE);
+      *dataP = lossBuf;
+    } else {
+      RLINK_GetLinkString(RNETA_GetDestAddr(), rttBuf, sizeof(rttBuf), TRUE);
+      *dataP = rttBuf;
+    }
+    flags |= LCDMENU_STATUS_FLAGS_HANDLED|LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
+  } else if (event==LCDMENU_EVENT_REFRESH) { /* statistics are local, the redraw picks up the new text */
+    flags |= LCDMENU_STATUS_FLAGS_HANDLED;
+  }
+  return flags;
+}
+#endif
+
+#if PL_CONFIG_HAS_LAP_TIME
+static LCDMenu_StatusFlags LapTimeMenuHandler(const struct LCDMenu_MenuItem_ *item, LCDMenu_EventType event, void **dataP) {
+  static uint8_t lastBuf[sizeof("L255 9999.999 +99.99")+1], bestBuf[sizeof("B9999.999 A9999.99")+1];
+  LCDMenu_StatusFlags flags = LCDMENU_STATUS_FLAGS_NONE;
+
+  if (event==LCDMENU_EVENT_GET_TEXT && dataP!=NULL) {
+    if (item->id==LCD_MENU_ID_LAP_LAST) {
+      LAPT_GetLapString(lastBuf, sizeof(lastBuf), FALSE);
+      *dataP = lastBuf;
+    } else {
+      LAPT_GetLapString(bestBuf, sizeof(bestBuf), TRUE);
+      *dataP = bestBuf;
+    }
+    flags |= LCDMENU_STATUS_FLAGS_HANDLED|LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
+  } else if (event==LCDMENU_EVENT_REFRESH) { /* the laps of the robot are received by the radio task */
+    flags |= LCDMENU_STATUS_FLAGS_HANDLED;
+  }
+  return flags;
+}
+#endif
+
 static const LCDMenu_MenuItem menus[] =
 {/* id,                                     grp, pos,   up,                       down,                             text,           callback                      flags                  */
     {LCD_MENU_ID_MAIN,                        0,   0,   LCD_MENU_ID_NONE,         LCD_MENU_ID_BACKLIGHT,            "General",      NULL,                         LCDMENU_MENU_FLAGS_NONE},
@@ -352,8 +425,12 @@ static const LCDMenu_MenuItem menus[] =
 	  //fr Remote Befehle
 #if PL_CONFIG_HAS_RADIO
       {LCD_MENU_ID_SUMO_START_STOP,           2,   1,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RobotRemoteMenuHandler,     LCDMENU_MENU_FLAGS_NONE},
-      {LCD_MENU_ID_BATTERY_VOLTAGE,           2,   2,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RobotRemoteMenuHandler,     LCDMENU_MENU_FLAGS_NONE},
-      {LCD_MENU_ID_MINT_TOF_SENSOR,           2,   3,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RobotRemoteMenuHandler,     LCDMENU_MENU_FLAGS_NONE},
+      {LCD_MENU_ID_BATTERY_VOLTAGE,           2,   2,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RobotRemoteMenuHandler,     LCDMENU_MENU_FLAGS_LIVE},
+      {LCD_MENU_ID_MINT_TOF_SENSOR,           2,   3,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RobotRemoteMenuHandler,     LCDMENU_MENU_FLAGS_LIVE},
+#endif
+#if PL_CONFIG_HAS_RADIO_LINK
+      {LCD_MENU_ID_LINK_LOSS,                 2,   4,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RadioLinkMenuHandler,       LCDMENU_MENU_FLAGS_LIVE},
+      {LCD_MENU_ID_LINK_RTT,                  2,   5,   LCD_MENU_ID_ROBOT,        LCD_MENU_ID_NONE,                 NULL,           RadioLinkMenuHandler,       LCDMENU_MENU_FLAGS_LIVE},
 #endif
 	  //PID und anti reset windup
 	  {LCD_MENU_ID_P_VALUE,                   3,  0,   LCD_MENU_ID_PID,           LCD_MENU_ID_NONE,            	    NULL,           PChangeHandler,               LCDMENU_MENU_FLAGS_EDITABLE},
@@ -363,15 +440,47 @@ static const LCDMenu_MenuItem menus[] =
 	  //fr snake game
 	  {LCD_MENU_ID_GAMES,                     0,  2,   LCD_MENU_ID_NONE,          LCD_MENU_ID_SNAKE,            	"Games",        NULL,     		  			  LCDMENU_MENU_FLAGS_NONE},
 	  {LCD_MENU_ID_SNAKE,                     4,  0,   LCD_MENU_ID_GAMES,         LCD_MENU_ID_NONE,            	    "Snake",        SnakeGameHandler,     		  LCDMENU_MENU_FLAGS_NONE},
+#if PL_CONFIG_HAS_LAP_TIME
+    {LCD_MENU_ID_LAPS,                        0,   3,   LCD_MENU_ID_NONE,         LCD_MENU_ID_LAP_LAST,             "Laps",         NULL,                         LCDMENU_MENU_FLAGS_NONE},
+      {LCD_MENU_ID_LAP_LAST,                  5,   0,   LCD_MENU_ID_LAPS,         LCD_MENU_ID_NONE,                 NULL,           LapTimeMenuHandler,           LCDMENU_MENU_FLAGS_LIVE},
+      {LCD_MENU_ID_LAP_BEST,                  5,   1,   LCD_MENU_ID_LAPS,         LCD_MENU_ID_NONE,                 NULL,           LapTimeMenuHandler,           LCDMENU_MENU_FLAGS_LIVE},
+#endif
 };
 
 // Lab 29: there is no Radio-Module at the moment (reason of comment the function)
 #if PL_CONFIG_HAS_RADIO
 uint8_t LCD_HandleRemoteRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet) {
+  uint16_t id;
+  uint32_t value;
+
   (void)size;
   (void)packet;
+  (void)srcAddr;
   switch(type) {
-     default:
+    case RAPP_MSG_TYPE_QUERY_VALUE_RESPONSE: /* id16:val32 */
+      id = UTIL1_GetValue16LE(data);
+      value = UTIL1_GetValue32LE(&data[2]);
+      if (id==RAPP_MSG_TYPE_DATA_ID_BATTERY_V) {
+        remoteValues.battVoltage.centiV = value;
+        remoteValues.battVoltage.dataValid = TRUE;
+        *handled = TRUE;
+      } else if (id==RAPP_MSG_TYPE_DATA_ID_START_STOP) {
+        remoteValues.sumo.isRunning = value!=0;
+        remoteValues.sumo.dataValid = TRUE;
+        *handled = TRUE;
+      } else if (id==RAPP_MSG_TYPE_DATA_ID_TOF_VALUES) { /* four 8bit values */
+        remoteValues.tof.mm[0] = value&0xff;
+        remoteValues.tof.mm[1] = (value>>8)&0xff;
+        remoteValues.tof.mm[2] = (value>>16)&0xff;
+        remoteValues.tof.mm[3] = (value>>24)&0xff;
+        remoteValues.tof.dataValid = TRUE;
+        *handled = TRUE;
+      }
+      if (*handled && lcdTaskHndl!=NULL) {
+        (void)xTaskNotify(lcdTaskHndl, LCD_NOTIFY_VALUES, eSetBits); /* repaint if the text has changed */
+      }
+      break;
+    default:
       break;
   } /* switch */
   return ERR_OK;
@@ -384,12 +493,12 @@ uint8_t LCD_HandleRemoteRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *dat
 static void ShowTextOnLCD(unsigned char *text) {
   FDisp1_PixelDim x, y;
 
-  GDisp1_Clear();
-  GDisp1_UpdateFull();
+  LCDDIRTY_Clear();
+  LCDDIRTY_Flush();
   x = 0;
   y = 10;
-  FDisp1_WriteString(text, GDisp1_COLOR_BLACK, &x, &y, GFONT1_GetFont());
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString(text, GDisp1_COLOR_BLACK, &x, &y, GFONT1_GetFont());
+  LCDDIRTY_Flush();
   vTaskDelay(pdMS_TO_TICKS(1000));
 
 }
@@ -397,24 +506,24 @@ static void ShowTextOnLCD(unsigned char *text) {
 static void DrawFont(void) {
   FDisp1_PixelDim x, y;
 
-  GDisp1_Clear();
-  GDisp1_UpdateFull();
+  LCDDIRTY_Clear();
+  LCDDIRTY_Flush();
 
   x = 0;
   y = 10;
-  FDisp1_WriteString("TextOnDisplay!", GDisp1_COLOR_BLACK, &x, &y, GFONT1_GetFont());
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString("TextOnDisplay!", GDisp1_COLOR_BLACK, &x, &y, GFONT1_GetFont());
+  LCDDIRTY_Flush();
   vTaskDelay(pdMS_TO_TICKS(500));
   x = 0;
   y += GFONT1_GetBoxHeight();
-  FDisp1_WriteString("Lab 29!", GDisp1_COLOR_BLACK, &x, &y, GFONT1_GetFont());
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString("Lab 29!", GDisp1_COLOR_BLACK, &x, &y, GFONT1_GetFont());
+  LCDDIRTY_Flush();
   WAIT1_Waitms(1000);
 }
 
 static void DrawText(void) {
-  GDisp1_Clear();
-  GDisp1_UpdateFull();
+  LCDDIRTY_Clear();
+  LCDDIRTY_Flush();
   /*PDC1_WriteLineStr(1, "Segment_1");
   vTaskDelay(pdMS_TO_TICKS(2000));
   PDC1_WriteLineStr(2, "Segment_2");
@@ -426,10 +535,46 @@ static void DrawText(void) {
 }
 
 void updateLCD(void) {
-	requestLCDUpdate = TRUE;
+  if (lcdTaskHndl!=NULL) {
+    (void)xTaskNotify(lcdTaskHndl, LCD_NOTIFY_REDRAW, eSetBits);
+  }
+}
+
+void LCD_SetEvent(LCD_BTN_Events event) {
+  /* called by the key debouncing from the timer interrupt */
+  if (lcdTaskHndl!=NULL && event<LCD_BTN_LEFT_RELEASE) {
+    (void)xTaskNotifyFromISR(lcdTaskHndl, (1<<event), eSetBits, NULL);
+  }
+}
+
+#if PL_CONFIG_HAS_LCD_MENU
+static void LCD_HandleKeys(uint32_t keys) {
+  if (keys&(1<<LCD_BTN_LEFT)) { /* left */
+    LCDMenu_OnEvent(LCDMENU_EVENT_LEFT, NULL);
+  }
+  if (keys&(1<<LCD_BTN_RIGHT)) { /* right */
+    LCDMenu_OnEvent(LCDMENU_EVENT_RIGHT, NULL);
+  }
+  if (keys&((1<<LCD_BTN_UP)|(1<<LCD_SIDE_BTN_UP))) { /* up and side up */
+    LCDMenu_OnEvent(LCDMENU_EVENT_UP, NULL);
+  }
+  if (keys&((1<<LCD_BTN_DOWN)|(1<<LCD_SIDE_BTN_DOWN))) { /* down and side down */
+    LCDMenu_OnEvent(LCDMENU_EVENT_DOWN, NULL);
+  }
+  if (keys&(1<<LCD_BTN_CENTER)) { /* center */
+    LCDMenu_OnEvent(LCDMENU_EVENT_ENTER, NULL);
+  }
 }
+#endif
 
 static void LCD_Task(void *param) {
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
+  uint32_t notificationValue;
+  BaseType_t notified;
+  TickType_t timeout;
+
   (void)param; /* not used */
 #if 1
   //ShowTextOnLCD("Press a key!");
@@ -455,55 +600,54 @@ static void LCD_Task(void *param) {
   //DrawCircles();
 #endif
 #if PL_CONFIG_HAS_LCD_MENU
-  LCDMenu_InitMenu(menus, sizeof(menus)/sizeof(menus[0]), 1);
+  if (LCDMenu_InitMenu(menus, sizeof(menus)/sizeof(menus[0]), 1)!=ERR_OK) {
+    for(;;){} /* error in the menu table */
+  }
   LCDMenu_OnEvent(LCDMENU_EVENT_DRAW, NULL);
+  timeout = LCDMenu_Refresh()?pdMS_TO_TICKS(LCD_CONFIG_LIVE_REFRESH_MS):portMAX_DELAY;
+#else
+  timeout = portMAX_DELAY;
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("LCD", PROF_PERIOD_NONE, 0);
 #endif
   for(;;) {
+    /* block until a key, a redraw request or new values arrive, or until live values need a refresh */
+    notified = xTaskNotifyWait(0UL, 0xffffffffUL, &notificationValue, timeout);
+    if (notified==pdFALSE) { /* timeout */
+      notificationValue = 0;
+    }
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
+#if PL_CONFIG_HAS_LCD_MENU
+    //LCD Menu Events nur handeln falls Snake Game noch nicht gestartet wurde
+    if (snakeGameStarted()==0) {
+      if (notificationValue&LCD_NOTIFY_REDRAW) {
+        LCDMenu_InvalidateView(); /* display has been overwritten, e.g. by the snake game */
+        LCDMenu_OnEvent(LCDMENU_EVENT_DRAW, NULL);
+      }
+      if (notificationValue&LCD_NOTIFY_KEYS) {
+        LCD_HandleKeys(notificationValue);
+      }
+      if (notificationValue&LCD_NOTIFY_VALUES) {
+        LCDMenu_OnEvent(LCDMENU_EVENT_DRAW, NULL); /* only changed lines get repainted */
+      }
+      if (notified==pdFALSE || (notificationValue&(LCD_NOTIFY_KEYS|LCD_NOTIFY_REDRAW))) { /* refresh period over or view might have changed */
+        timeout = LCDMenu_Refresh()?pdMS_TO_TICKS(LCD_CONFIG_LIVE_REFRESH_MS):portMAX_DELAY;
+      }
+    } else {
+      timeout = portMAX_DELAY; /* snake game owns the display, updateLCD() wakes us up afterwards */
+    }
+#endif /* PL_CONFIG_HAS_LCD_MENU */
     if (LedBackLightisOn) {
       LCD_LED_On(); /* LCD backlight on */
     } else {
       LCD_LED_Off(); /* LCD backlight off */
     }
-#if PL_CONFIG_HAS_LCD_MENU
-    if (requestLCDUpdate) {
-      requestLCDUpdate = FALSE;
-      LCDMenu_OnEvent(LCDMENU_EVENT_DRAW, NULL);
-    }
-#if 1 /*! \todo Change this to for your own needs, or use direct task notification */
-    //LCD Menu Events nur handeln falls Snake Game noch nicht gestartet wurde
-    if (snakeGameStarted() == 0) {
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_BTN_LEFT)) { /* left */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_LEFT, NULL);
-		  //ShowTextOnLCD("left");
-		}
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_BTN_RIGHT)) { /* right */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_RIGHT, NULL);
-		  //ShowTextOnLCD("right");
-		}
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_BTN_UP)) { /* up */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_UP, NULL);
-		  //ShowTextOnLCD("up");
-		}
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_BTN_DOWN)) { /* down */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_DOWN, NULL);
-		  //ShowTextOnLCD("down");
-		}
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_BTN_CENTER)) { /* center */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_ENTER, NULL);
-		  //ShowTextOnLCD("center");
-		}
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_SIDE_BTN_UP)) { /* side up */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_UP, NULL);
-		  //ShowTextOnLCD("side up");
-		}
-		if (EVNT_EventIsSetAutoClear(EVNT_LCD_SIDE_BTN_DOWN)) { /* side down */
-		  LCDMenu_OnEvent(LCDMENU_EVENT_DOWN, NULL);
-		  //ShowTextOnLCD("side down");
-		}
-    }
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
 #endif
-#endif /* PL_CONFIG_HAS_LCD_MENU */
-    vTaskDelay(pdMS_TO_TICKS(20));
   }
 }
 
@@ -511,11 +655,13 @@ void LCD_Deinit(void) {
 #if PL_CONFIG_HAS_LCD_MENU
   LCDMenu_Deinit();
 #endif
+  LCDDIRTY_Deinit();
 }
 
 void LCD_Init(void) {
   LedBackLightisOn =  TRUE;
-  if (xTaskCreate(LCD_Task, "LCD", configMINIMAL_STACK_SIZE+100, NULL, tskIDLE_PRIORITY, NULL) != pdPASS) {
+  LCDDIRTY_Init();
+  if (xTaskCreate(LCD_Task, "LCD", configMINIMAL_STACK_SIZE+100, NULL, tskIDLE_PRIORITY, &lcdTaskHndl) != pdPASS) {
     for(;;){} /* error! probably out of memory */
   }
 #if PL_CONFIG_HAS_LCD_MENU
@@ -41,12 +41,15 @@ typedef enum {
 } LCD_BTN_Events;
 
 /*!
- * \brief Sets an LCD button event.
- * \param event Event to be set.
+ * \brief Sets an LCD button event and wakes up the LCD task. Can be called from an interrupt.
+ * \param event Event to be set, only the button press events are used.
  */
 void LCD_SetEvent(LCD_BTN_Events event);
 #endif
 
+/*!
+ * \brief Requests a full repaint of the menu, e.g. after something else has used the display.
+ */
 void updateLCD(void);
 
 /*!
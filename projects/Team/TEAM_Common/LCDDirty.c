@@ -0,0 +1,323 @@
+/**
+ * \file
+ * \brief Implementation of the LCD damage tracking.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The display controller is organized in pages of 8 pixel rows, with one byte per column and page.
+ * For every page the range of modified columns is recorded. A flush transfers only these ranges.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LCD
+#include "LCDDirty.h"
+#include "GDisp1.h"
+#include "FDisp1.h"
+#include "GFONT1.h"
+#include "CS1.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define LCDDIRTY_CONFIG_PARTIAL_UPDATE  (1) /* 1: transfer only modified pages/columns, 0: always transfer the full frame buffer */
+#define LCDDIRTY_PAGE_HEIGHT            (8) /* number of pixel rows in a display page */
+#define LCDDIRTY_MAX_PAGES              (8) /* maximum number of pages supported (up to 64 pixel rows) */
+#define LCDDIRTY_COL_NONE               (0xff) /* marker for a clean page */
+
+/*! \brief Modified column range of a page */
+typedef struct {
+  uint8_t minCol, maxCol; /*!< range of modified columns, minCol is LCDDIRTY_COL_NONE if not modified */
+} LCDDIRTY_PageRange;
+
+static LCDDIRTY_PageRange LCDDIRTY_Pages[LCDDIRTY_MAX_PAGES];
+static uint8_t LCDDIRTY_FrameNesting = 0; /* >0 while inside a frame */
+
+/*! \brief Transfer statistics */
+static struct {
+  TickType_t startTick; /*!< tick count when the statistics have been reset */
+  uint32_t nofFrames;   /*!< number of flushes which transferred data */
+  uint32_t nofBytes;    /*!< number of bytes transferred to the display */
+#if PL_CONFIG_HAS_PROFILER
+  uint32_t maxFlushCycles; /*!< worst case duration of a flush */
+  uint64_t sumFlushCycles; /*!< sum of all flush durations */
+#endif
+} LCDDIRTY_Stats;
+
+static uint8_t LCDDIRTY_NofPages(void) {
+  uint8_t nofPages;
+
+  nofPages = (uint8_t)((GDisp1_GetHeight()+LCDDIRTY_PAGE_HEIGHT-1)/LCDDIRTY_PAGE_HEIGHT);
+  if (nofPages>LCDDIRTY_MAX_PAGES) {
+    nofPages = LCDDIRTY_MAX_PAGES;
+  }
+  return nofPages;
+}
+
+void LCDDIRTY_MarkRegion(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h) {
+  uint8_t page, firstPage, lastPage, lastCol;
+  GDisp1_PixelDim width, height;
+  CS1_CriticalVariable()
+
+  width = GDisp1_GetWidth();
+  height = GDisp1_GetHeight();
+  if (w==0 || h==0 || x>=width || y>=height) {
+    return; /* nothing visible */
+  }
+  if (x+w>width) { /* clip */
+    w = width-x;
+  }
+  if (y+h>height) { /* clip */
+    h = height-y;
+  }
+  firstPage = (uint8_t)(y/LCDDIRTY_PAGE_HEIGHT);
+  lastPage = (uint8_t)((y+h-1)/LCDDIRTY_PAGE_HEIGHT);
+  if (lastPage>=LCDDIRTY_MAX_PAGES) {
+    lastPage = LCDDIRTY_MAX_PAGES-1;
+  }
+  lastCol = (uint8_t)(x+w-1);
+  CS1_EnterCritical();
+  for(page=firstPage;page<=lastPage;page++) {
+    if (LCDDIRTY_Pages[page].minCol==LCDDIRTY_COL_NONE || x<LCDDIRTY_Pages[page].minCol) {
+      LCDDIRTY_Pages[page].minCol = (uint8_t)x;
+    }
+    if (LCDDIRTY_Pages[page].maxCol==LCDDIRTY_COL_NONE || lastCol>LCDDIRTY_Pages[page].maxCol) {
+      LCDDIRTY_Pages[page].maxCol = lastCol;
+    }
+  }
+  CS1_ExitCritical();
+}
+
+void LCDDIRTY_MarkAll(void) {
+  LCDDIRTY_MarkRegion(0, 0, GDisp1_GetWidth(), GDisp1_GetHeight());
+}
+
+void LCDDIRTY_Clear(void) {
+  GDisp1_Clear();
+  LCDDIRTY_MarkAll();
+}
+
+void LCDDIRTY_ClearRegion(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h) {
+  GDisp1_DrawFilledBox(x, y, w, h, GDisp1_COLOR_WHITE);
+  LCDDIRTY_MarkRegion(x, y, w, h);
+}
+
+void LCDDIRTY_SetPixel(GDisp1_PixelDim x, GDisp1_PixelDim y) {
+  GDisp1_SetPixel(x, y);
+  LCDDIRTY_MarkRegion(x, y, 1, 1);
+}
+
+void LCDDIRTY_ClrPixel(GDisp1_PixelDim x, GDisp1_PixelDim y) {
+  GDisp1_ClrPixel(x, y);
+  LCDDIRTY_MarkRegion(x, y, 1, 1);
+}
+
+void LCDDIRTY_DrawBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelDim lineWidth, GDisp1_PixelColor color) {
+  GDisp1_DrawBox(x, y, w, h, lineWidth, color);
+  LCDDIRTY_MarkRegion(x, y, w, h);
+}
+
+void LCDDIRTY_DrawFilledBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelColor color) {
+  GDisp1_DrawFilledBox(x, y, w, h, color);
+  LCDDIRTY_MarkRegion(x, y, w, h);
+}
+
+void LCDDIRTY_DrawLine(GDisp1_PixelDim x0, GDisp1_PixelDim y0, GDisp1_PixelDim x1, GDisp1_PixelDim y1, GDisp1_PixelColor color) {
+  GDisp1_DrawLine(x0, y0, x1, y1, color);
+  LCDDIRTY_MarkRegion(x0<x1?x0:x1, y0<y1?y0:y1, (x0<x1?x1-x0:x0-x1)+1, (y0<y1?y1-y0:y0-y1)+1);
+}
+
+void LCDDIRTY_DrawCircle(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim radius, GDisp1_PixelColor color) {
+  GDisp1_DrawCircle(x, y, radius, color);
+  LCDDIRTY_MarkRegion(x>radius?x-radius:0, y>radius?y-radius:0, 2*radius+1, 2*radius+1);
+}
+
+void LCDDIRTY_WriteString(unsigned char *str, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font) {
+  FDisp1_PixelDim x0, y0, charHeight, totalHeight;
+
+  x0 = *x;
+  y0 = *y;
+  FDisp1_WriteString(str, color, x, y, font);
+  FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
+  if (*y==y0) { /* single line: the glyphs cover charHeight rows, the space below is not drawn */
+    LCDDIRTY_MarkRegion(x0, y0, *x-x0, charHeight);
+  } else { /* text contained a new line: mark the full width of all lines */
+    LCDDIRTY_MarkRegion(0, y0, GDisp1_GetWidth(), *y-y0+charHeight);
+  }
+}
+
+void LCDDIRTY_WriteChar(uint8_t ch, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font) {
+  FDisp1_PixelDim x0, y0, charHeight, totalHeight;
+
+  x0 = *x;
+  y0 = *y;
+  FDisp1_WriteChar(ch, color, x, y, font);
+  FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
+  if (*y==y0) {
+    LCDDIRTY_MarkRegion(x0, y0, *x-x0, charHeight);
+  } else {
+    LCDDIRTY_MarkRegion(0, y0, GDisp1_GetWidth(), *y-y0+charHeight);
+  }
+}
+
+void LCDDIRTY_BeginFrame(void) {
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  LCDDIRTY_FrameNesting++;
+  CS1_ExitCritical();
+}
+
+void LCDDIRTY_Commit(void) {
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  if (LCDDIRTY_FrameNesting>0) {
+    LCDDIRTY_FrameNesting--;
+  }
+  CS1_ExitCritical();
+  LCDDIRTY_Flush();
+}
+
+void LCDDIRTY_Flush(void) {
+  LCDDIRTY_PageRange pages[LCDDIRTY_MAX_PAGES];
+  uint8_t page, nofPages;
+  uint32_t nofBytes = 0;
+#if PL_CONFIG_HAS_PROFILER
+  uint32_t cycles;
+#endif
+  CS1_CriticalVariable()
+
+  nofPages = LCDDIRTY_NofPages();
+  CS1_EnterCritical();
+  if (LCDDIRTY_FrameNesting>0) { /* inside a frame: commit will flush */
+    CS1_ExitCritical();
+    return;
+  }
+  for(page=0;page<nofPages;page++) { /* take a snapshot and mark everything clean */
+    pages[page] = LCDDIRTY_Pages[page];
+    LCDDIRTY_Pages[page].minCol = LCDDIRTY_COL_NONE;
+    LCDDIRTY_Pages[page].maxCol = LCDDIRTY_COL_NONE;
+  }
+  CS1_ExitCritical();
+#if PL_CONFIG_HAS_PROFILER
+  cycles = PROF_GetCycles();
+#endif
+#if LCDDIRTY_CONFIG_PARTIAL_UPDATE
+  for(page=0;page<nofPages;page++) {
+    if (pages[page].minCol!=LCDDIRTY_COL_NONE) {
+      GDisp1_UpdateRegion(pages[page].minCol, page*LCDDIRTY_PAGE_HEIGHT, pages[page].maxCol-pages[page].minCol+1, LCDDIRTY_PAGE_HEIGHT);
+      nofBytes += pages[page].maxCol-pages[page].minCol+1;
+    }
+  }
+#else
+  for(page=0;page<nofPages;page++) {
+    if (pages[page].minCol!=LCDDIRTY_COL_NONE) {
+      GDisp1_UpdateFull();
+      nofBytes = (uint32_t)nofPages*GDisp1_GetWidth();
+      break;
+    }
+  }
+#endif
+  if (nofBytes==0) {
+    return; /* nothing has been modified */
+  }
+#if PL_CONFIG_HAS_PROFILER
+  cycles = PROF_GetCycles()-cycles;
+  if (cycles>LCDDIRTY_Stats.maxFlushCycles) {
+    LCDDIRTY_Stats.maxFlushCycles = cycles;
+  }
+  LCDDIRTY_Stats.sumFlushCycles += cycles;
+#endif
+  LCDDIRTY_Stats.nofFrames++;
+  LCDDIRTY_Stats.nofBytes += nofBytes;
+}
+
+static void LCDDIRTY_ResetStats(void) {
+  LCDDIRTY_Stats.startTick = xTaskGetTickCount();
+  LCDDIRTY_Stats.nofFrames = 0;
+  LCDDIRTY_Stats.nofBytes = 0;
+#if PL_CONFIG_HAS_PROFILER
+  LCDDIRTY_Stats.maxFlushCycles = 0;
+  LCDDIRTY_Stats.sumFlushCycles = 0;
+#endif
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void LCDDIRTY_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+  uint32_t ms;
+
+  ms = (xTaskGetTickCount()-LCDDIRTY_Stats.startTick)*portTICK_PERIOD_MS;
+  CLS1_SendStatusStr((unsigned char*)"lcd", (unsigned char*)"\r\n", io->stdOut);
+#if LCDDIRTY_CONFIG_PARTIAL_UPDATE
+  CLS1_SendStatusStr((unsigned char*)"  update", (unsigned char*)"partial\r\n", io->stdOut);
+#else
+  CLS1_SendStatusStr((unsigned char*)"  update", (unsigned char*)"full\r\n", io->stdOut);
+#endif
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), LCDDIRTY_Stats.nofFrames);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" in ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), ms);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  frames", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), ms!=0?(LCDDIRTY_Stats.nofFrames*1000)/ms:0);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  fps", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), LCDDIRTY_Stats.nofFrames!=0?LCDDIRTY_Stats.nofBytes/LCDDIRTY_Stats.nofFrames:0);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (full: ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), (uint32_t)LCDDIRTY_NofPages()*GDisp1_GetWidth());
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)")\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  bytes/frame", buf, io->stdOut);
+#if PL_CONFIG_HAS_PROFILER
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), LCDDIRTY_Stats.nofFrames!=0?(uint32_t)(LCDDIRTY_Stats.sumFlushCycles/LCDDIRTY_Stats.nofFrames/(configCPU_CLOCK_HZ/1000000)):0);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us (max ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), LCDDIRTY_Stats.maxFlushCycles/(configCPU_CLOCK_HZ/1000000));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us)\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  flush", buf, io->stdOut);
+#endif
+}
+
+static void LCDDIRTY_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"lcd", (unsigned char*)"Group of LCD commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows LCD help or refresh statistics\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the refresh statistics\r\n", io->stdOut);
+}
+
+uint8_t LCDDIRTY_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"lcd help")==0) {
+    LCDDIRTY_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"lcd status")==0) {
+    LCDDIRTY_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lcd reset")==0) {
+    LCDDIRTY_ResetStats();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void LCDDIRTY_Deinit(void) {
+  /* nothing to do */
+}
+
+void LCDDIRTY_Init(void) {
+  uint8_t page;
+
+  for(page=0;page<LCDDIRTY_MAX_PAGES;page++) {
+    LCDDIRTY_Pages[page].minCol = LCDDIRTY_COL_NONE;
+    LCDDIRTY_Pages[page].maxCol = LCDDIRTY_COL_NONE;
+  }
+  LCDDIRTY_FrameNesting = 0;
+  LCDDIRTY_ResetStats();
+}
+
+#endif /* PL_CONFIG_HAS_LCD */
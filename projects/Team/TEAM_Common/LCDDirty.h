@@ -0,0 +1,85 @@
+/**
+ * \file
+ * \brief Interface for the LCD damage tracking.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Drawing through this module records which display pages and columns have been modified.
+ * A flush only transfers the modified regions instead of the full frame buffer.
+ */
+
+#ifndef SOURCES_LCDDIRTY_H_
+#define SOURCES_LCDDIRTY_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LCD
+#include "GDisp1.h"
+#include "FDisp1.h"
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t LCDDIRTY_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Marks a rectangular region of the display as modified.
+ * \param x Left column of the region.
+ * \param y Top row of the region.
+ * \param w Width of the region in pixels.
+ * \param h Height of the region in pixels.
+ */
+void LCDDIRTY_MarkRegion(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h);
+
+/*!
+ * \brief Marks the whole display as modified.
+ */
+void LCDDIRTY_MarkAll(void);
+
+/*! \brief Clears the whole display buffer. */
+void LCDDIRTY_Clear(void);
+
+/*! \brief Clears a region of the display buffer, see LCDDIRTY_MarkRegion() for the parameters. */
+void LCDDIRTY_ClearRegion(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h);
+
+/* drawing functions, same parameters as the GDisp1 and FDisp1 counterparts */
+void LCDDIRTY_SetPixel(GDisp1_PixelDim x, GDisp1_PixelDim y);
+void LCDDIRTY_ClrPixel(GDisp1_PixelDim x, GDisp1_PixelDim y);
+void LCDDIRTY_DrawBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelDim lineWidth, GDisp1_PixelColor color);
+void LCDDIRTY_DrawFilledBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelColor color);
+void LCDDIRTY_DrawLine(GDisp1_PixelDim x0, GDisp1_PixelDim y0, GDisp1_PixelDim x1, GDisp1_PixelDim y1, GDisp1_PixelColor color);
+void LCDDIRTY_DrawCircle(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim radius, GDisp1_PixelColor color);
+void LCDDIRTY_WriteString(unsigned char *str, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font);
+void LCDDIRTY_WriteChar(uint8_t ch, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font);
+
+/*!
+ * \brief Starts a frame: flushes are deferred until the matching LCDDIRTY_Commit().
+ * Frames can be nested.
+ */
+void LCDDIRTY_BeginFrame(void);
+
+/*!
+ * \brief Ends a frame started with LCDDIRTY_BeginFrame(). The outermost commit flushes all modifications at once.
+ */
+void LCDDIRTY_Commit(void);
+
+/*!
+ * \brief Transfers the modified regions to the display, unless inside a frame.
+ */
+void LCDDIRTY_Flush(void);
+
+/*! \brief Driver de-initialization */
+void LCDDIRTY_Deinit(void);
+
+/*! \brief Driver initialization */
+void LCDDIRTY_Init(void);
+
+#endif /* PL_CONFIG_HAS_LCD */
+
+#endif /* SOURCES_LCDDIRTY_H_ */
@@ -11,13 +11,23 @@
 #include "GDisp1.h"
 #include "FDisp1.h"
 #include "GFONT1.h"
+#include "LCDDirty.h"
+#include "UTIL1.h"
 
 /* LCD specific constants */
-#define LCDMENU_NOF_MENU_LINES            4  /* number of lines on display */
 #define LCDMENU_SUBMENU_INDICATOR_CHAR    '>' /* sub-menu indicator */
 #define LCDMENU_UPMENU_INDICATOR_CHAR     '<' /* up-menu indicator */
 #define LCDMENU_V_SCROLLBAR_WIDTH         1   /* vertical scroll bar width */
 
+/* menu index and view cache sizes */
+#define LCDMENU_CONFIG_MAX_ITEMS          32  /* maximum number of menu items */
+#define LCDMENU_CONFIG_MAX_ID             32  /* maximum menu item ID */
+#define LCDMENU_CONFIG_MAX_GROUPS         16  /* maximum number of menu groups */
+#define LCDMENU_CONFIG_MAX_LINES          8   /* maximum number of text lines on the display */
+#define LCDMENU_CONFIG_LINE_TEXT_SIZE     20  /* cached characters per line, enough for the display width */
+
+#define LCDMENU_INDEX_NONE                0xff /* special value for 'no item' in the index */
+
 typedef struct {
   const LCDMenu_MenuItem *menus; /* pointer to array of menu items */
   uint16_t nofMenuItems;   /* number of menu items */
@@ -28,54 +38,144 @@ typedef struct {
 
 static LCDMenu_Status menuStatus;
 
-void LCDMenu_InitMenu(const LCDMenu_MenuItem *menus, uint8_t nofMenuItems, uint8_t selectedID) {
+/* Index built by LCDMenu_InitMenu(), so navigation does not need to search the menu table. */
+typedef struct {
+  uint8_t idToIdx[LCDMENU_CONFIG_MAX_ID+1]; /* menu ID -> index into menus[] */
+  uint8_t groupFirst[LCDMENU_CONFIG_MAX_GROUPS]; /* first entry of each group in byGroup[] */
+  uint8_t groupCount[LCDMENU_CONFIG_MAX_GROUPS]; /* number of items in each group */
+  uint8_t byGroup[LCDMENU_CONFIG_MAX_ITEMS]; /* menu indices, sorted by group and position */
+} LCDMenu_Index;
+
+static LCDMenu_Index menuIndex;
+
+/* What is currently shown on a display line, used to repaint only the lines which have changed. */
+typedef struct {
+  uint8_t itemIdx; /* index of the item shown, or LCDMENU_INDEX_NONE for an empty line */
+  bool selected; /* item is shown as selected */
+  bool edit; /* item is shown in edit mode */
+  uint8_t text[LCDMENU_CONFIG_LINE_TEXT_SIZE]; /* text shown */
+} LCDMenu_LineCache;
+
+static struct {
+  bool valid; /* FALSE if the display content is unknown and needs a full repaint */
+  FDisp1_PixelDim scrollBarY, scrollBarH; /* scroll bar shown, height is zero if none */
+  LCDMenu_LineCache lines[LCDMENU_CONFIG_MAX_LINES];
+} menuView;
+
+/* empty index: no item is found, also for a menu table which has been rejected */
+static void LCDMenu_ClearIndex(void) {
+  uint8_t i;
+
+  for(i=0; i<sizeof(menuIndex.idToIdx); i++) {
+    menuIndex.idToIdx[i] = LCDMENU_INDEX_NONE;
+  }
+  for(i=0; i<LCDMENU_CONFIG_MAX_GROUPS; i++) {
+    menuIndex.groupCount[i] = 0;
+  }
+  for(i=0; i<LCDMENU_CONFIG_MAX_ITEMS; i++) {
+    menuIndex.byGroup[i] = LCDMENU_INDEX_NONE;
+  }
+}
+
+uint8_t LCDMenu_InitMenu(const LCDMenu_MenuItem *menus, uint8_t nofMenuItems, uint8_t selectedID) {
+  const LCDMenu_MenuItem *item;
+  uint8_t i, first, slot;
+
+  menuStatus.menus = NULL; /* not initialized until the index is complete */
+  menuStatus.nofMenuItems = 0;
+  LCDMenu_ClearIndex();
+  if (nofMenuItems>LCDMENU_CONFIG_MAX_ITEMS) {
+    return ERR_OVERFLOW;
+  }
+  /* map the IDs and count the items per group */
+  for(i=0; i<nofMenuItems; i++) {
+    item = &menus[i];
+    if (item->id==LCDMENU_ID_NONE || item->id>LCDMENU_CONFIG_MAX_ID || item->group>=LCDMENU_CONFIG_MAX_GROUPS
+        || menuIndex.idToIdx[item->id]!=LCDMENU_INDEX_NONE) {
+      LCDMenu_ClearIndex();
+      return ERR_FAILED; /* invalid or duplicate ID, or too many groups */
+    }
+    menuIndex.idToIdx[item->id] = i;
+    menuIndex.groupCount[item->group]++;
+  }
+  first = 0;
+  for(i=0; i<LCDMENU_CONFIG_MAX_GROUPS; i++) {
+    menuIndex.groupFirst[i] = first;
+    first += menuIndex.groupCount[i];
+  }
+  /* sort the items by group and position: positions inside a group have to be 0, 1, 2, ... */
+  for(i=0; i<nofMenuItems; i++) {
+    item = &menus[i];
+    slot = menuIndex.groupFirst[item->group]+item->pos;
+    if (item->pos>=menuIndex.groupCount[item->group] || menuIndex.byGroup[slot]!=LCDMENU_INDEX_NONE) {
+      LCDMenu_ClearIndex();
+      return ERR_FAILED; /* gap or duplicate position in group */
+    }
+    menuIndex.byGroup[slot] = i;
+  }
   menuStatus.menus = menus;
   menuStatus.nofMenuItems = nofMenuItems;
   menuStatus.selectedID = selectedID;
   menuStatus.editID = LCDMENU_ID_NONE;
   menuStatus.topGroup = LCDMENU_GROUP_ROOT;
   menuStatus.topPos = 0;
+  menuView.valid = FALSE;
+  return ERR_OK;
 }
 
 static const LCDMenu_MenuItem *LCDMenu_GetGroupPosMenuItem(uint8_t group, uint8_t pos) {
-  int i;
-
-  i = 0;
-  while(i<menuStatus.nofMenuItems) {
-    if (menuStatus.menus[i].group==group && menuStatus.menus[i].pos==pos) { /* match */
-      return &menuStatus.menus[i];
-    }
-    i++;
+  if (group>=LCDMENU_CONFIG_MAX_GROUPS || pos>=menuIndex.groupCount[group]) {
+    return NULL; /* not found */
   }
-  return NULL; /* not found */
+  return &menuStatus.menus[menuIndex.byGroup[menuIndex.groupFirst[group]+pos]];
 }
 
 static const LCDMenu_MenuItem *LCDMenu_GeIdMenuItem(uint8_t id) {
-  int i;
-
-  i = 0;
-  while(i<menuStatus.nofMenuItems) {
-    if (menuStatus.menus[i].id==id) { /* match */
-      return &menuStatus.menus[i];
-    }
-    i++;
+  if (id>LCDMENU_CONFIG_MAX_ID || menuIndex.idToIdx[id]==LCDMENU_INDEX_NONE) {
+    return NULL; /* not found */
   }
-  return NULL; /* not found */
+  return &menuStatus.menus[menuIndex.idToIdx[id]];
 }
 
 static uint16_t LCDMenu_NofMenuItemsInGroup(uint8_t group) {
-  int i;
-  uint16_t cntr;
-
-  i = 0;
-  cntr = 0;
-  while(i<menuStatus.nofMenuItems) {
-    if (menuStatus.menus[i].group==group) { /* match */
-      cntr++;
-    }
-    i++;
+  if (group>=LCDMENU_CONFIG_MAX_GROUPS) {
+    return 0;
   }
-  return cntr; /* return number of items found */
+  return menuIndex.groupCount[group]; /* return number of items found */
+}
+
+static uint8_t *LCDMenu_GetItemText(const LCDMenu_MenuItem *item) {
+  uint8_t *text;
+
+  text = (uint8_t*)item->menuText;
+  if (text==NULL && item->handler!=NULL) {
+     if (item->id==menuStatus.editID) { /* it's for the item in edit mode */
+       (void)item->handler(item, LCDMENU_EVENT_GET_EDIT_TEXT, (void**)&text);
+     } else {
+       (void)item->handler(item, LCDMENU_EVENT_GET_TEXT, (void**)&text);
+     }
+  }
+  if (text==NULL) {
+    text = (uint8_t*)"";
+  }
+  return text;
+}
+
+void LCDMenu_InvalidateView(void) {
+  menuView.valid = FALSE;
+}
+
+/* number of text lines on the display with the current font, the lines drawn and refreshed */
+static uint8_t LCDMenu_NofLines(void) {
+  FDisp1_PixelDim charHeight, fontHeight;
+  uint8_t nofLines;
+
+  FDisp1_GetFontHeight(GFONT1_GetFont(), &charHeight, &fontHeight);
+  nofLines = (uint8_t)(GDisp1_GetHeight()/fontHeight);
+  if (nofLines>LCDMENU_CONFIG_MAX_LINES) {
+    nofLines = LCDMENU_CONFIG_MAX_LINES;
+  }
+  return nofLines;
 }
 
 static void LCDMenu_Draw(void) {
@@ -84,80 +184,135 @@ static void LCDMenu_Draw(void) {
   FDisp1_PixelDim charHeight, fontHeight;
   int i, nofMaxMenuItems;
   const LCDMenu_MenuItem *item;
-  uint8_t group, pos;
+  LCDMenu_LineCache *line;
+  uint8_t group, pos, itemIdx;
   uint8_t *text;
+  bool selected, edit;
   GDisp1_PixelColor textColor;
   FDisp1_PixelDim charWidth, totalWidth;
-  FDisp1_PixelDim scrollBarWidth;
+  FDisp1_PixelDim scrollBarWidth, scrollBarY, scrollBarH;
   uint16_t nofTotalMenusOnLevel;
 
   font = GFONT1_GetFont();
   FDisp1_GetFontHeight(font, &charHeight, &fontHeight);
-  nofMaxMenuItems = GDisp1_GetHeight()/fontHeight;
-  GDisp1_Clear(); /* clear display */
+  nofMaxMenuItems = LCDMenu_NofLines();
+  LCDDIRTY_BeginFrame(); /* all changes below go to the display with one flush */
+  if (!menuView.valid) { /* unknown content: repaint everything */
+    LCDDIRTY_Clear(); /* clear display */
+    menuView.scrollBarY = 0;
+    menuView.scrollBarH = 0;
+    for(i=0; i<LCDMENU_CONFIG_MAX_LINES; i++) {
+      menuView.lines[i].itemIdx = LCDMENU_INDEX_NONE;
+      menuView.lines[i].text[0] = '\0';
+    }
+    menuView.valid = TRUE;
+  }
   group = menuStatus.topGroup;
   pos = menuStatus.topPos;
   nofTotalMenusOnLevel = LCDMenu_NofMenuItemsInGroup(group);
-  if (nofTotalMenusOnLevel>LCDMENU_NOF_MENU_LINES) { /* show scrollbar only if needed */
-    FDisp1_PixelDim h;
-
+  if (nofTotalMenusOnLevel>nofMaxMenuItems) { /* show scrollbar only if needed */
     scrollBarWidth = LCDMENU_V_SCROLLBAR_WIDTH+1; /* plus one for a border to the left */
-    x = GDisp1_GetWidth()-LCDMENU_V_SCROLLBAR_WIDTH;
-    y = (GDisp1_GetHeight()*menuStatus.topPos)/nofTotalMenusOnLevel;
-    h = (GDisp1_GetHeight()*LCDMENU_NOF_MENU_LINES)/nofTotalMenusOnLevel; /* h proportional to the items visible */
-    GDisp1_DrawFilledBox(x, y, LCDMENU_V_SCROLLBAR_WIDTH, h, GDisp1_COLOR_BLACK);
+    scrollBarY = (GDisp1_GetHeight()*menuStatus.topPos)/nofTotalMenusOnLevel;
+    scrollBarH = (GDisp1_GetHeight()*nofMaxMenuItems)/nofTotalMenusOnLevel; /* h proportional to the items visible */
   } else {
     scrollBarWidth = 0; /* no scrollbar */
+    scrollBarY = 0;
+    scrollBarH = 0;
+  }
+  if (scrollBarY!=menuView.scrollBarY || scrollBarH!=menuView.scrollBarH) { /* scroll bar has changed */
+    x = GDisp1_GetWidth()-LCDMENU_V_SCROLLBAR_WIDTH;
+    if ((scrollBarH==0) != (menuView.scrollBarH==0)) { /* scroll bar appears or disappears: line width changes */
+      for(i=0; i<LCDMENU_CONFIG_MAX_LINES; i++) {
+        menuView.lines[i].itemIdx = LCDMENU_INDEX_NONE;
+        menuView.lines[i].text[0] = '\0';
+      }
+      LCDDIRTY_Clear();
+    } else {
+      LCDDIRTY_ClearRegion(x, 0, LCDMENU_V_SCROLLBAR_WIDTH, GDisp1_GetHeight());
+    }
+    if (scrollBarH!=0) {
+      LCDDIRTY_DrawFilledBox(x, scrollBarY, LCDMENU_V_SCROLLBAR_WIDTH, scrollBarH, GDisp1_COLOR_BLACK);
+    }
+    menuView.scrollBarY = scrollBarY;
+    menuView.scrollBarH = scrollBarH;
   }
-  x = 0;
   y = 1; /* have a small border on top of the text */
   for(i=0; i<nofMaxMenuItems; i++) {
+    line = &menuView.lines[i];
     item = LCDMenu_GetGroupPosMenuItem(group, pos);
     if (item!=NULL) {
-      x = 0;
-      text = (uint8_t*)item->menuText;
-      if (text==NULL && item->handler!=NULL) {
-         text = NULL;
-         if (item->id==menuStatus.editID) { /* it's for the item in edit mode */
-           (void)item->handler(item, LCDMENU_EVENT_GET_EDIT_TEXT, (void**)&text);
-         } else {
-           (void)item->handler(item, LCDMENU_EVENT_GET_TEXT, (void**)&text);
-         }
-         if (text==NULL) {
-           text = (uint8_t*)"";
-         }
-      }
-      if (item->id == menuStatus.selectedID) { /* selected item */
-        GDisp1_DrawFilledBox(x, y-1, GDisp1_GetWidth()-scrollBarWidth, fontHeight, GDisp1_COLOR_BLACK); /* -1 because of small border */
-        textColor = GDisp1_COLOR_WHITE; /* selection is white text on black background */
-      } else {
-        textColor = GDisp1_COLOR_BLACK;
-      }
-      /* level up menu indicator */
-      if (item->lvlUpID!=LCDMENU_ID_NONE) { /* there is a upper level menu: write up indicator */
-        if (menuStatus.editID==item->id) { /* currently editing the item */
-          /* for edited item, do not write indicator: skip space for it */
+      itemIdx = menuIndex.idToIdx[item->id];
+      text = LCDMenu_GetItemText(item);
+      selected = item->id==menuStatus.selectedID;
+      edit = item->id==menuStatus.editID;
+      if (line->itemIdx!=itemIdx || line->selected!=selected || line->edit!=edit
+          || UTIL1_strncmp((char*)line->text, (char*)text, sizeof(line->text)-1)!=0) { /* line has changed */
+        LCDDIRTY_ClearRegion(0, y-1, GDisp1_GetWidth()-scrollBarWidth, fontHeight); /* -1 because of small border */
+        x = 0;
+        if (selected) { /* selected item */
+          LCDDIRTY_DrawFilledBox(x, y-1, GDisp1_GetWidth()-scrollBarWidth, fontHeight, GDisp1_COLOR_BLACK); /* -1 because of small border */
+          textColor = GDisp1_COLOR_WHITE; /* selection is white text on black background */
+        } else {
+          textColor = GDisp1_COLOR_BLACK;
+        }
+        /* level up menu indicator */
+        if (item->lvlUpID!=LCDMENU_ID_NONE) { /* there is a upper level menu: write up indicator */
+          if (edit) { /* currently editing the item */
+            /* for edited item, do not write indicator: skip space for it */
+            FDisp1_GetCharWidth(LCDMENU_UPMENU_INDICATOR_CHAR, &charWidth, &totalWidth, font);
+            x += totalWidth;
+          } else {
+            LCDDIRTY_WriteChar(LCDMENU_UPMENU_INDICATOR_CHAR, textColor, &x, &y, font);
+          }
+        } else if (item->group!=LCDMENU_GROUP_ROOT) { /* skip space, but not for root menu */
           FDisp1_GetCharWidth(LCDMENU_UPMENU_INDICATOR_CHAR, &charWidth, &totalWidth, font);
           x += totalWidth;
-        } else {
-          FDisp1_WriteChar(LCDMENU_UPMENU_INDICATOR_CHAR, textColor, &x, &y, font);
         }
-      } else if (item->group!=LCDMENU_GROUP_ROOT) { /* skip space, but not for root menu */
-        FDisp1_GetCharWidth(LCDMENU_UPMENU_INDICATOR_CHAR, &charWidth, &totalWidth, font);
-        x += totalWidth;
-      }
-      FDisp1_WriteString(text, textColor, &x, &y, font); /* write menu text */
-      if (item->lvlDownID!=LCDMENU_ID_NONE) { /* menu entry with a sub-menu entry: write sub-menu indicator */
-        /* sub-menu indicator */
-        FDisp1_GetCharWidth(LCDMENU_SUBMENU_INDICATOR_CHAR, &charWidth, &totalWidth, font);
-        x = GDisp1_GetWidth()-charWidth-scrollBarWidth; /* display width */
-        FDisp1_WriteChar(LCDMENU_SUBMENU_INDICATOR_CHAR, textColor, &x, &y, font);
+        UTIL1_strcpy(line->text, sizeof(line->text), text); /* remember what is shown, before drawing moves on */
+        LCDDIRTY_WriteString(text, textColor, &x, &y, font); /* write menu text */
+        if (item->lvlDownID!=LCDMENU_ID_NONE) { /* menu entry with a sub-menu entry: write sub-menu indicator */
+          /* sub-menu indicator */
+          FDisp1_GetCharWidth(LCDMENU_SUBMENU_INDICATOR_CHAR, &charWidth, &totalWidth, font);
+          x = GDisp1_GetWidth()-charWidth-scrollBarWidth; /* display width */
+          LCDDIRTY_WriteChar(LCDMENU_SUBMENU_INDICATOR_CHAR, textColor, &x, &y, font);
+        }
+        line->itemIdx = itemIdx;
+        line->selected = selected;
+        line->edit = edit;
       }
-      y += fontHeight;
+    } else if (line->itemIdx!=LCDMENU_INDEX_NONE) { /* line was used before: clear it */
+      LCDDIRTY_ClearRegion(0, y-1, GDisp1_GetWidth()-scrollBarWidth, fontHeight);
+      line->itemIdx = LCDMENU_INDEX_NONE;
+      line->text[0] = '\0';
     }
+    y += fontHeight;
     pos++;
   }
-  GDisp1_UpdateFull();
+  LCDDIRTY_Commit();
+}
+
+bool LCDMenu_Refresh(void) {
+  const LCDMenu_MenuItem *item;
+  uint8_t i, pos, nofLines;
+  bool live = FALSE;
+
+  if (menuStatus.menus==NULL) {
+    return FALSE; /* menu not initialized yet */
+  }
+  pos = menuStatus.topPos;
+  nofLines = LCDMenu_NofLines(); /* the same lines as LCDMenu_Draw() */
+  for(i=0; i<nofLines; i++) {
+    item = LCDMenu_GetGroupPosMenuItem(menuStatus.topGroup, pos);
+    if (item!=NULL && (item->flags&LCDMENU_MENU_FLAGS_LIVE) && item->handler!=NULL) {
+      (void)item->handler(item, LCDMENU_EVENT_REFRESH, NULL); /* let it update its value */
+      live = TRUE;
+    }
+    pos++;
+  }
+  if (live) {
+    LCDMenu_Draw(); /* only lines with a changed text get repainted */
+  }
+  return live;
 }
 
 static void LCDMenu_CursorUp(void) {
@@ -208,8 +363,8 @@ static void LCDMenu_CursorDown(void) {
       /* returns NULL if not found */
       if (item!=NULL) { /* yes, it exists */
         menuStatus.selectedID = item->id;
-        if (item->pos>=LCDMENU_NOF_MENU_LINES) { /* check if outside visible area */
-          menuStatus.topPos = item->pos-LCDMENU_NOF_MENU_LINES+1;
+        if (item->pos>=LCDMenu_NofLines()) { /* check if outside visible area */
+          menuStatus.topPos = item->pos-LCDMenu_NofLines()+1;
         }
         flags |= LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
       }
@@ -261,8 +416,8 @@ static void LCDMenu_CursorLeft(void) {
       item = LCDMenu_GeIdMenuItem(item->lvlUpID); /* get target item */
       menuStatus.selectedID = item->id;
       menuStatus.topGroup = item->group;
-      if (item->pos>=LCDMENU_NOF_MENU_LINES) { /* check if outside visible area */
-        menuStatus.topPos = item->pos-LCDMENU_NOF_MENU_LINES+1;
+      if (item->pos>=LCDMenu_NofLines()) { /* check if outside visible area */
+        menuStatus.topPos = item->pos-LCDMenu_NofLines()+1;
       } else {
         menuStatus.topPos = 0;
       }
@@ -332,10 +487,18 @@ void LCDMenu_OnEvent(LCDMenu_EventType event, const LCDMenu_MenuItem *menu) {
   }
 }
 
+void LCDMenu_Deinit(void) {
+  menuStatus.menus = NULL;
+  menuStatus.nofMenuItems = 0;
+}
+
 void LCDMenu_Init(void) {
+  menuStatus.menus = NULL;
+  menuStatus.nofMenuItems = 0;
   menuStatus.topGroup = 0;
   menuStatus.topPos = 0;
   menuStatus.selectedID = 1;
+  menuView.valid = FALSE;
 }
 
 #endif /* PL_CONFIG_HAS_LCD_MENU */
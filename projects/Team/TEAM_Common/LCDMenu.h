@@ -25,7 +25,8 @@ typedef enum {
   LCDMENU_EVENT_ENTER_EDIT,  /* entering edit mode */
   LCDMENU_EVENT_EXIT_EDIT,   /* exiting edit mode */
   LCDMENU_EVENT_INCREMENT,
-  LCDMENU_EVENT_DECREMENT
+  LCDMENU_EVENT_DECREMENT,
+  LCDMENU_EVENT_REFRESH      /* live item is visible: update the value, e.g. request it from the robot */
 } LCDMenu_EventType;
 
 typedef enum {
@@ -38,6 +39,7 @@ typedef enum {
 typedef enum {
   LCDMENU_MENU_FLAGS_NONE         = 0,      /* default/initialization value */
   LCDMENU_MENU_FLAGS_EDITABLE     = (1<<0), /* editable data value */
+  LCDMENU_MENU_FLAGS_LIVE         = (1<<1), /* value changes on its own, refreshed with LCDMenu_Refresh() while visible */
 } LCDMenu_MenuFlags;
 
 #define LCDMENU_ID_NONE     0   /* special menu ID for 'no' id */
@@ -56,7 +58,25 @@ typedef struct LCDMenu_MenuItem_{
 
 void LCDMenu_OnEvent(LCDMenu_EventType event, const LCDMenu_MenuItem *menu);
 
-void LCDMenu_InitMenu(const LCDMenu_MenuItem *menus, uint8_t nofMenuItems, uint8_t selectedID);
+/*!
+ * \brief Sets the menu to be used and builds the navigation index for it.
+ * \param menus Array of menu items. IDs have to be unique, positions inside a group have to be 0, 1, 2, ...
+ * \param nofMenuItems Number of items in the array.
+ * \param selectedID ID of the item to be selected initially.
+ * \return Error code, ERR_OK if the menu table is consistent. Otherwise no menu is set, as before the first call.
+ */
+uint8_t LCDMenu_InitMenu(const LCDMenu_MenuItem *menus, uint8_t nofMenuItems, uint8_t selectedID);
+
+/*!
+ * \brief Tells the menu that the display content has been overwritten, so the next draw repaints everything.
+ */
+void LCDMenu_InvalidateView(void);
+
+/*!
+ * \brief Sends LCDMENU_EVENT_REFRESH to the visible live items and repaints the lines whose text has changed.
+ * \return TRUE if live items are visible and the menu should be refreshed periodically.
+ */
+bool LCDMenu_Refresh(void);
 
 /*!
  * \brief Driver de-initialization
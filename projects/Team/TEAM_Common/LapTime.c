@@ -0,0 +1,661 @@
+/**
+ * \file
+ * \brief Lap and segment timing service, see LapTime.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The events are handled right away in a critical section: they only move the time stamps of the current
+ * run into the history, so the control loop can add them. Printing and sending the laps is done later
+ * by LAPT_Process() in the radio task. A repeated start of the same source, and a split, lap or finish
+ * closer than LAPT_CONFIG_MIN_SEGMENT_MS to the last event, is ignored: a light barrier triggers several
+ * times while the robot passes it.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LAP_TIME
+#include "LapTime.h"
+#include "FRTOS1.h"
+#include "CS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if PL_CONFIG_HAS_RADIO
+  #include "RApp.h"
+  #include "RNet_App.h"
+  #include "RNet_AppConfig.h"
+  #if PL_CONFIG_HAS_SHELL
+    #include "Shell.h"
+  #endif
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  #include "TimeSync.h"
+#endif
+
+#define LAPT_LAP_MSG_SIZE   (13) /* RAPP_MSG_TYPE_LAP_RESULT: run, lap, source, tag, splits, time32, error32 */
+
+static struct {
+  bool running;         /* a run has been started and not finished yet */
+  uint8_t run;          /* number of the current or last run */
+  uint8_t lap;          /* laps finished in the run */
+  uint8_t nofSplits;    /* split times of the current lap */
+  uint8_t lastKind;     /* LAPT_EventKind of the last accepted event */
+  uint8_t lastSource;   /* LAPT_Source of the last accepted event */
+  uint32_t lastUs;      /* time of the last accepted event */
+  uint32_t lapStartUs;  /* start of the current lap */
+  uint32_t lapStartErrUs; /* error bound of lapStartUs */
+  uint32_t splitUs[LAPT_CONFIG_NOF_SPLITS]; /* split times of the current lap, from its start */
+  uint16_t nofIgnored;  /* repeated events */
+  uint16_t nofAborted;  /* runs which did not finish */
+} LAPT_Run;
+
+static LAPT_Lap LAPT_Laps[LAPT_CONFIG_NOF_LAPS]; /* ring buffer of the finished laps */
+static uint16_t LAPT_NofLaps;   /* laps added to LAPT_Laps */
+static uint16_t LAPT_SentLaps;  /* laps printed and sent to the other nodes */
+
+uint32_t LAPT_GetTimeUs(void) {
+#if defined(LAPT_CONFIG_GET_TIME_US)
+  return LAPT_CONFIG_GET_TIME_US();
+#elif PL_CONFIG_HAS_TIME_SYNC
+  return TSYNC_GetLocalUs(); /* RTOS tick count and the SysTick counter */
+#else
+  return (uint32_t)(FRTOS1_xTaskGetTickCount()*portTICK_PERIOD_MS*1000UL); /* resolution of the RTOS tick */
+#endif
+}
+
+/* adds a lap to the history, called in a critical section */
+static void AddLap(const LAPT_Lap *lap) {
+  LAPT_Laps[LAPT_NofLaps%LAPT_CONFIG_NOF_LAPS] = *lap;
+  LAPT_NofLaps++;
+}
+
+void LAPT_OnEventAt(LAPT_EventKind kind, LAPT_Source source, uint8_t tag, uint32_t us, uint32_t errUs) {
+  LAPT_Lap lap;
+  uint8_t i;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  if (kind==LAPT_EVENT_START) {
+    if (LAPT_Run.running && LAPT_Run.lastKind==LAPT_EVENT_START && LAPT_Run.lastSource==source) {
+      LAPT_Run.nofIgnored++; /* repeated start, the first one counts */
+    } else {
+      if (LAPT_Run.running) {
+        LAPT_Run.nofAborted++; /* started again without a finish */
+      }
+      LAPT_Run.running = TRUE;
+      LAPT_Run.run++;
+      LAPT_Run.lap = 0;
+      LAPT_Run.nofSplits = 0;
+      LAPT_Run.lapStartUs = us;
+      LAPT_Run.lapStartErrUs = errUs;
+      LAPT_Run.lastKind = (uint8_t)kind;
+      LAPT_Run.lastSource = (uint8_t)source;
+      LAPT_Run.lastUs = us;
+    }
+  } else if (!LAPT_Run.running) {
+    LAPT_Run.nofIgnored++; /* no run, e.g. a repeated finish */
+  } else if (kind==LAPT_EVENT_ABORT) {
+    LAPT_Run.running = FALSE;
+    LAPT_Run.nofAborted++;
+  } else if ((int32_t)(us-LAPT_Run.lastUs)<(int32_t)(LAPT_CONFIG_MIN_SEGMENT_MS*1000UL)) {
+    LAPT_Run.nofIgnored++; /* repetition */
+  } else {
+    if (kind==LAPT_EVENT_SPLIT) {
+      if (LAPT_Run.nofSplits<LAPT_CONFIG_NOF_SPLITS) {
+        LAPT_Run.splitUs[LAPT_Run.nofSplits] = us-LAPT_Run.lapStartUs;
+        LAPT_Run.nofSplits++;
+      }
+    } else { /* lap or finish */
+      LAPT_Run.lap++;
+      lap.run = LAPT_Run.run;
+      lap.lap = LAPT_Run.lap;
+      lap.source = (uint8_t)source;
+      lap.tag = tag;
+      lap.nofSplits = LAPT_Run.nofSplits;
+      lap.remote = FALSE;
+      lap.node = 0;
+      lap.us = us-LAPT_Run.lapStartUs;
+      if (errUs==LAPT_ERR_UNKNOWN || LAPT_Run.lapStartErrUs==LAPT_ERR_UNKNOWN) {
+        lap.errUs = LAPT_ERR_UNKNOWN;
+      } else {
+        lap.errUs = errUs+LAPT_Run.lapStartErrUs;
+      }
+      for(i=0;i<LAPT_Run.nofSplits;i++) {
+        lap.splitUs[i] = LAPT_Run.splitUs[i];
+      }
+      AddLap(&lap);
+      LAPT_Run.nofSplits = 0;
+      LAPT_Run.lapStartUs = us;
+      LAPT_Run.lapStartErrUs = errUs;
+      if (kind==LAPT_EVENT_FINISH) {
+        LAPT_Run.running = FALSE;
+      }
+    }
+    LAPT_Run.lastKind = (uint8_t)kind;
+    LAPT_Run.lastSource = (uint8_t)source;
+    LAPT_Run.lastUs = us;
+  }
+  CS1_ExitCritical();
+}
+
+void LAPT_OnEvent(LAPT_EventKind kind, LAPT_Source source, uint8_t tag) {
+  LAPT_OnEventAt(kind, source, tag, LAPT_GetTimeUs(), 0);
+}
+
+uint8_t LAPT_GetLap(uint8_t idx, LAPT_Lap *lap) {
+  CS1_CriticalVariable()
+
+  if (idx>=LAPT_NofLaps || idx>=LAPT_CONFIG_NOF_LAPS) {
+    return ERR_RANGE;
+  }
+  CS1_EnterCritical();
+  *lap = LAPT_Laps[(LAPT_NofLaps-1-idx)%LAPT_CONFIG_NOF_LAPS];
+  CS1_ExitCritical();
+  return ERR_OK;
+}
+
+/* TRUE if both laps are of the same run, timed by the same node: the run numbers of the nodes are independent */
+static bool IsSameRun(const LAPT_Lap *a, const LAPT_Lap *b) {
+  return a->run==b->run && a->remote==b->remote && a->node==b->node;
+}
+
+/* summary of the laps in the history of the same run as a lap, the last lap is the latest one of the run */
+static void GetRunSummary(const LAPT_Lap *of, LAPT_Summary *summary) {
+  LAPT_Lap lap;
+  uint64_t sum = 0;
+  uint8_t i;
+
+  summary->nofLaps = 0;
+  summary->lastUs = summary->bestUs = summary->avgUs = 0;
+  for(i=0;LAPT_GetLap(i, &lap)==ERR_OK;i++) {
+    if (!IsSameRun(&lap, of)) {
+      continue;
+    }
+    if (summary->nofLaps==0) {
+      summary->lastUs = lap.us;
+      summary->bestUs = lap.us;
+    } else if (lap.us<summary->bestUs) {
+      summary->bestUs = lap.us;
+    }
+    sum += lap.us;
+    summary->nofLaps++;
+  }
+  if (summary->nofLaps>0) {
+    summary->avgUs = (uint32_t)(sum/summary->nofLaps);
+  }
+}
+
+uint8_t LAPT_GetSummary(LAPT_Summary *summary) {
+  LAPT_Lap lap;
+
+  if (LAPT_GetLap(0, &lap)!=ERR_OK) {
+    summary->nofLaps = 0;
+    summary->lastUs = summary->bestUs = summary->avgUs = 0;
+    return ERR_NOTAVAIL;
+  }
+  GetRunSummary(&lap, summary);
+  return ERR_OK;
+}
+
+/* finds the best lap of the same run as a lap with the same number of splits, so its segments can be compared */
+static uint8_t FindBestLap(const LAPT_Lap *of, LAPT_Lap *best) {
+  LAPT_Lap lap;
+  uint8_t i, res = ERR_NOTAVAIL;
+
+  best->nofSplits = 0;
+  best->us = 0;
+  for(i=0;LAPT_GetLap(i, &lap)==ERR_OK;i++) {
+    if (IsSameRun(&lap, of) && lap.nofSplits==of->nofSplits && (res!=ERR_OK || lap.us<best->us)) {
+      *best = lap;
+      res = ERR_OK;
+    }
+  }
+  return res;
+}
+
+/* time of a segment of a lap, the last one ends with the lap */
+static uint32_t SegmentUs(const LAPT_Lap *lap, uint8_t seg) {
+  uint32_t start, end;
+
+  start = seg==0 ? 0 : lap->splitUs[seg-1];
+  end = seg<lap->nofSplits ? lap->splitUs[seg] : lap->us;
+  return end-start;
+}
+
+/* appends a time as seconds with 2 or 3 decimals, negative times with a sign */
+static void StrcatSec(uint8_t *buf, size_t bufSize, int32_t us, uint8_t decimals, bool withSign) {
+  uint32_t val;
+
+  if (us<0) {
+    UTIL1_chcat(buf, bufSize, '-');
+    val = (uint32_t)-us;
+  } else {
+    if (withSign) {
+      UTIL1_chcat(buf, bufSize, '+');
+    }
+    val = (uint32_t)us;
+  }
+  UTIL1_strcatNum32u(buf, bufSize, val/1000000);
+  UTIL1_chcat(buf, bufSize, '.');
+  if (decimals==2) {
+    UTIL1_strcatNum16uFormatted(buf, bufSize, (uint16_t)((val%1000000)/10000), '0', 2);
+  } else {
+    UTIL1_strcatNum16uFormatted(buf, bufSize, (uint16_t)((val%1000000)/1000), '0', 3);
+  }
+}
+
+void LAPT_GetLapString(uint8_t *buf, size_t bufSize, bool best) {
+  LAPT_Summary summary;
+  LAPT_Lap lap;
+
+  if (LAPT_GetSummary(&summary)!=ERR_OK || LAPT_GetLap(0, &lap)!=ERR_OK) {
+    UTIL1_strcpy(buf, bufSize, best ? (unsigned char*)"B- A-" : (unsigned char*)"L- no lap");
+    return;
+  }
+  if (best) {
+    UTIL1_strcpy(buf, bufSize, (unsigned char*)"B");
+    StrcatSec(buf, bufSize, (int32_t)summary.bestUs, 3, FALSE);
+    UTIL1_strcat(buf, bufSize, (unsigned char*)" A");
+    StrcatSec(buf, bufSize, (int32_t)summary.avgUs, 2, FALSE);
+  } else {
+    UTIL1_strcpy(buf, bufSize, (unsigned char*)"L");
+    UTIL1_strcatNum8u(buf, bufSize, lap.lap);
+    UTIL1_chcat(buf, bufSize, ' ');
+    StrcatSec(buf, bufSize, (int32_t)lap.us, 3, FALSE);
+    UTIL1_chcat(buf, bufSize, ' ');
+    StrcatSec(buf, bufSize, (int32_t)(lap.us-summary.bestUs), 2, TRUE);
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static const unsigned char *SourceStr(uint8_t source) {
+  switch(source) {
+    case LAPT_SOURCE_LINE:  return (const unsigned char*)"line";
+    case LAPT_SOURCE_TRACK: return (const unsigned char*)"track";
+    case LAPT_SOURCE_RADIO: return (const unsigned char*)"radio";
+    case LAPT_SOURCE_SHELL: return (const unsigned char*)"shell";
+    default:                return (const unsigned char*)"?";
+  }
+}
+
+/* appends a time as '1234.567' milliseconds, negative times with a sign */
+static void StrcatMs(uint8_t *buf, size_t bufSize, int32_t us, bool withSign) {
+  uint32_t val;
+
+  if (us<0) {
+    UTIL1_chcat(buf, bufSize, '-');
+    val = (uint32_t)-us;
+  } else {
+    if (withSign) {
+      UTIL1_chcat(buf, bufSize, '+');
+    }
+    val = (uint32_t)us;
+  }
+  UTIL1_strcatNum32u(buf, bufSize, val/1000);
+  UTIL1_chcat(buf, bufSize, '.');
+  UTIL1_strcatNum16uFormatted(buf, bufSize, (uint16_t)(val%1000), '0', 3);
+}
+
+/* appends the node of a lap, '-' for this node */
+static void StrcatNode(uint8_t *buf, size_t bufSize, const LAPT_Lap *lap) {
+  if (lap->remote) {
+    UTIL1_strcatNum16u(buf, bufSize, lap->node);
+  } else {
+    UTIL1_chcat(buf, bufSize, '-');
+  }
+}
+
+/* appends a lap as 'run 2 lap 3 track 1: 12345.678 ms +/-0.800 ms', of another node as 'node 5 run 2 ...' */
+static void StrcatLap(uint8_t *buf, size_t bufSize, const LAPT_Lap *lap) {
+  if (lap->remote) {
+    UTIL1_strcat(buf, bufSize, (unsigned char*)"node ");
+    StrcatNode(buf, bufSize, lap);
+    UTIL1_chcat(buf, bufSize, ' ');
+  }
+  UTIL1_strcat(buf, bufSize, (unsigned char*)"run ");
+  UTIL1_strcatNum8u(buf, bufSize, lap->run);
+  UTIL1_strcat(buf, bufSize, (unsigned char*)" lap ");
+  UTIL1_strcatNum8u(buf, bufSize, lap->lap);
+  UTIL1_chcat(buf, bufSize, ' ');
+  UTIL1_strcat(buf, bufSize, SourceStr(lap->source));
+  UTIL1_chcat(buf, bufSize, ' ');
+  UTIL1_strcatNum8u(buf, bufSize, lap->tag);
+  UTIL1_strcat(buf, bufSize, (unsigned char*)": ");
+  StrcatMs(buf, bufSize, (int32_t)lap->us, FALSE);
+  UTIL1_strcat(buf, bufSize, (unsigned char*)" ms");
+  if (lap->errUs==LAPT_ERR_UNKNOWN) {
+    UTIL1_strcat(buf, bufSize, (unsigned char*)" +/-? ms");
+  } else if (lap->errUs!=0) {
+    UTIL1_strcat(buf, bufSize, (unsigned char*)" +/-");
+    StrcatMs(buf, bufSize, (int32_t)lap->errUs, FALSE);
+    UTIL1_strcat(buf, bufSize, (unsigned char*)" ms");
+  }
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+#if PL_CONFIG_HAS_RADIO
+static uint8_t LAPT_HandleRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet) {
+  LAPT_EventKind kind;
+  LAPT_Lap lap;
+  uint32_t us, errUs;
+#if PL_CONFIG_HAS_SHELL
+  uint8_t buf[40];
+#endif
+  CS1_CriticalVariable()
+
+  (void)packet;
+  switch(type) {
+    case RAPP_MSG_TYPE_LAP_POINT: /* group:event, or group:event:time32:error32 if time stamped at the source */
+      if (size!=2 && size!=10) {
+        break;
+      }
+      *handled = TRUE;
+      us = LAPT_GetTimeUs(); /* on reception */
+      errUs = LAPT_ERR_UNKNOWN; /* the radio latency is unknown */
+#if PL_CONFIG_HAS_TIME_SYNC
+      if (size==10 && UTIL1_GetValue32LE(&data[6])!=TSYNC_ERR_UNKNOWN) { /* synchronised time stamp of the source */
+        uint32_t sharedUs, sharedErrUs;
+
+        if (TSYNC_GetSharedUs(&sharedUs, &sharedErrUs)) {
+          us -= sharedUs-UTIL1_GetValue32LE(&data[2]); /* minus the age of the time stamp */
+          errUs = UTIL1_GetValue32LE(&data[6])+sharedErrUs;
+        }
+      }
+#endif
+#if PL_CONFIG_HAS_SHELL
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Lap point: group ");
+      UTIL1_strcatNum8u(buf, sizeof(buf), data[0]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" event ");
+      UTIL1_chcat(buf, sizeof(buf), data[1]); /* 'A', 'B', 'C', 'X' or 'T' */
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+      SHELL_SendString(buf); /* queued, the radio task does not wait for the console */
+#endif
+      switch(data[1]) {
+        case 'A': kind = LAPT_EVENT_START; break;  /* start point */
+        case 'B': kind = LAPT_EVENT_SPLIT; break;  /* intermediate point */
+        case 'C': kind = LAPT_EVENT_FINISH; break; /* finish point */
+        case 'X': kind = LAPT_EVENT_ABORT; break;  /* did not finish */
+        default:  return ERR_OK;                   /* 'T' is a test */
+      }
+      LAPT_OnEventAt(kind, LAPT_SOURCE_RADIO, data[0], us, errUs);
+      break;
+
+    case RAPP_MSG_TYPE_LAP_RESULT: /* lap of another node, see LAPT_Process() */
+      if (size!=LAPT_LAP_MSG_SIZE) {
+        break;
+      }
+      *handled = TRUE;
+      lap.run = data[0];
+      lap.lap = data[1];
+      lap.source = data[2];
+      lap.tag = data[3];
+      lap.nofSplits = 0; /* the split times are not sent */
+      lap.remote = TRUE;
+      lap.node = (uint16_t)srcAddr;
+      lap.us = UTIL1_GetValue32LE(&data[5]);
+      lap.errUs = UTIL1_GetValue32LE(&data[9]);
+      CS1_EnterCritical();
+      AddLap(&lap);
+      CS1_ExitCritical();
+      break;
+
+    default:
+      break;
+  } /* switch */
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_RADIO */
+
+void LAPT_Process(void) {
+  LAPT_Lap lap;
+#if PL_CONFIG_HAS_RADIO
+  uint8_t data[LAPT_LAP_MSG_SIZE];
+#endif
+#if PL_CONFIG_HAS_SHELL && PL_CONFIG_HAS_RADIO
+  uint8_t buf[64];
+#endif
+  CS1_CriticalVariable()
+
+  while (LAPT_SentLaps!=LAPT_NofLaps) {
+    CS1_EnterCritical();
+    if ((uint16_t)(LAPT_NofLaps-LAPT_SentLaps)>LAPT_CONFIG_NOF_LAPS) {
+      LAPT_SentLaps = LAPT_NofLaps-LAPT_CONFIG_NOF_LAPS; /* older ones are overwritten */
+    }
+    lap = LAPT_Laps[LAPT_SentLaps%LAPT_CONFIG_NOF_LAPS];
+    CS1_ExitCritical();
+#if PL_CONFIG_HAS_RADIO
+    if (!lap.remote && lap.source!=LAPT_SOURCE_RADIO) { /* the other nodes have received the lap points of the light barrier too */
+      data[0] = lap.run;
+      data[1] = lap.lap;
+      data[2] = lap.source;
+      data[3] = lap.tag;
+      data[4] = lap.nofSplits;
+      UTIL1_SetValue32LE(lap.us, &data[5]);
+      UTIL1_SetValue32LE(lap.errUs, &data[9]);
+      if (RAPP_SendPayloadDataBlock(data, sizeof(data), RAPP_MSG_TYPE_LAP_RESULT, RNWK_ADDR_BROADCAST, RPHY_PACKET_FLAGS_NONE)!=ERR_OK) {
+        break; /* try again next time */
+      }
+    }
+  #if PL_CONFIG_HAS_SHELL
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Lap: ");
+    StrcatLap(buf, sizeof(buf), &lap);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    SHELL_SendString(buf); /* queued, the radio task does not wait for the console */
+  #endif
+#else
+    (void)lap;
+#endif
+    LAPT_SentLaps++;
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void PrintTime(const unsigned char *title, int32_t us, bool withSign, const unsigned char *suffix, const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+
+  buf[0] = '\0';
+  StrcatMs(buf, sizeof(buf), us, withSign);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms");
+  UTIL1_strcat(buf, sizeof(buf), suffix);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr(title, buf, io->stdOut);
+}
+
+static void LAPT_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  LAPT_Summary summary;
+  LAPT_Lap lap, best;
+  uint8_t i;
+  bool running;
+  uint32_t lapUs;
+  CS1_CriticalVariable()
+
+  CLS1_SendStatusStr((unsigned char*)"lap", (unsigned char*)"\r\n", io->stdOut);
+#if defined(LAPT_CONFIG_GET_TIME_US)
+  CLS1_SendStatusStr((unsigned char*)"  timebase", (unsigned char*)"platform timer, us\r\n", io->stdOut);
+#elif PL_CONFIG_HAS_TIME_SYNC
+  CLS1_SendStatusStr((unsigned char*)"  timebase", (unsigned char*)"SysTick, us\r\n", io->stdOut);
+#else
+  CLS1_SendStatusStr((unsigned char*)"  timebase", (unsigned char*)"RTOS tick\r\n", io->stdOut);
+#endif
+  CS1_EnterCritical();
+  running = LAPT_Run.running;
+  lapUs = LAPT_GetTimeUs()-LAPT_Run.lapStartUs;
+  CS1_ExitCritical();
+  if (running) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"run ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), LAPT_Run.run);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", lap ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), (uint8_t)(LAPT_Run.lap+1));
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" since ");
+    StrcatMs(buf, sizeof(buf), (int32_t)lapUs, FALSE);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"idle\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  state", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), LAPT_Run.nofAborted);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" not finished, ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), LAPT_Run.nofIgnored);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" events ignored\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  runs", buf, io->stdOut);
+  if (LAPT_GetSummary(&summary)!=ERR_OK || LAPT_GetLap(0, &lap)!=ERR_OK) {
+    CLS1_SendStatusStr((unsigned char*)"  laps", (unsigned char*)"none\r\n", io->stdOut);
+    return;
+  }
+  UTIL1_Num8uToStr(buf, sizeof(buf), summary.nofLaps);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" in the run of the last lap\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  laps", buf, io->stdOut);
+  buf[0] = '\0';
+  StrcatLap(buf, sizeof(buf), &lap);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  last", buf, io->stdOut);
+  PrintTime((unsigned char*)"  best", (int32_t)summary.bestUs, FALSE, (unsigned char*)"", io);
+  PrintTime((unsigned char*)"  average", (int32_t)summary.avgUs, FALSE, (unsigned char*)"", io);
+  PrintTime((unsigned char*)"  last-best", (int32_t)(summary.lastUs-summary.bestUs), TRUE, (unsigned char*)"", io);
+  if (lap.nofSplits>0 && FindBestLap(&lap, &best)==ERR_OK) { /* segments of the last lap against the best lap with the same splits */
+    for(i=0;i<=lap.nofSplits;i++) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"  segment ");
+      UTIL1_strcatNum8u(buf, sizeof(buf), (uint8_t)(i+1));
+      PrintTime(buf, (int32_t)SegmentUs(&lap, i), FALSE, (unsigned char*)"", io);
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)" to the best, ");
+      StrcatMs(buf, sizeof(buf), (int32_t)SegmentUs(&best, i), FALSE);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms");
+      PrintTime((unsigned char*)"", (int32_t)(SegmentUs(&lap, i)-SegmentUs(&best, i)), TRUE, buf, io);
+    }
+  }
+}
+
+/* prints the history as a table, oldest lap first: the lap and the segment times in ms, then the best and average of each run */
+static void LAPT_PrintLog(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  LAPT_Summary summary;
+  LAPT_Lap lap, newer;
+  uint8_t i, j;
+
+  CLS1_SendStr((unsigned char*)"node\trun\tlap\tsource\ttag\tlap(ms)\terr(ms)\tsegments(ms)\r\n", io->stdOut);
+  for(i=LAPT_CONFIG_NOF_LAPS;i>0;i--) {
+    if (LAPT_GetLap((uint8_t)(i-1), &lap)!=ERR_OK) {
+      continue;
+    }
+    buf[0] = '\0';
+    StrcatNode(buf, sizeof(buf), &lap);
+    UTIL1_chcat(buf, sizeof(buf), '\t');
+    UTIL1_strcatNum8u(buf, sizeof(buf), lap.run);
+    UTIL1_chcat(buf, sizeof(buf), '\t');
+    UTIL1_strcatNum8u(buf, sizeof(buf), lap.lap);
+    UTIL1_chcat(buf, sizeof(buf), '\t');
+    UTIL1_strcat(buf, sizeof(buf), SourceStr(lap.source));
+    UTIL1_chcat(buf, sizeof(buf), '\t');
+    UTIL1_strcatNum8u(buf, sizeof(buf), lap.tag);
+    UTIL1_chcat(buf, sizeof(buf), '\t');
+    StrcatMs(buf, sizeof(buf), (int32_t)lap.us, FALSE);
+    UTIL1_chcat(buf, sizeof(buf), '\t');
+    if (lap.errUs==LAPT_ERR_UNKNOWN) {
+      UTIL1_chcat(buf, sizeof(buf), '?');
+    } else {
+      StrcatMs(buf, sizeof(buf), (int32_t)lap.errUs, FALSE);
+    }
+    CLS1_SendStr(buf, io->stdOut);
+    for(j=0;j<=lap.nofSplits && lap.nofSplits>0;j++) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"\t");
+      StrcatMs(buf, sizeof(buf), (int32_t)SegmentUs(&lap, j), FALSE);
+      CLS1_SendStr(buf, io->stdOut);
+    }
+    CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+  }
+  for(i=LAPT_CONFIG_NOF_LAPS;i>0;i--) { /* a summary line for each run, in the order of their last lap */
+    if (LAPT_GetLap((uint8_t)(i-1), &lap)!=ERR_OK) {
+      continue;
+    }
+    for(j=0;j<i-1 && LAPT_GetLap(j, &newer)==ERR_OK && !IsSameRun(&newer, &lap);j++) {
+      /* search a newer lap of the run */
+    }
+    if (j<i-1) {
+      continue; /* not the last lap of its run */
+    }
+    GetRunSummary(&lap, &summary);
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"# node ");
+    StrcatNode(buf, sizeof(buf), &lap);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" run ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), lap.run);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": best ");
+    StrcatMs(buf, sizeof(buf), (int32_t)summary.bestUs, FALSE);
+    CLS1_SendStr(buf, io->stdOut);
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)" average ");
+    StrcatMs(buf, sizeof(buf), (int32_t)summary.avgUs, FALSE);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" of ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), summary.nofLaps);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" laps\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
+static void LAPT_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"lap", (unsigned char*)"Group of lap timing commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows lap help or status with the segments of the last lap\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|split|next", (unsigned char*)"Starts a run, ends a segment, ends the lap and starts the next one\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  finish|abort", (unsigned char*)"Ends the run with or without the current lap\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  log", (unsigned char*)"Prints the laps as a tab separated table\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Clears the history\r\n", io->stdOut);
+}
+
+uint8_t LAPT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  CS1_CriticalVariable()
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"lap help")==0) {
+    LAPT_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"lap status")==0) {
+    LAPT_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap start")==0) {
+    LAPT_OnEvent(LAPT_EVENT_START, LAPT_SOURCE_SHELL, 0);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap split")==0) {
+    LAPT_OnEvent(LAPT_EVENT_SPLIT, LAPT_SOURCE_SHELL, 0);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap next")==0) {
+    LAPT_OnEvent(LAPT_EVENT_LAP, LAPT_SOURCE_SHELL, 0);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap finish")==0) {
+    LAPT_OnEvent(LAPT_EVENT_FINISH, LAPT_SOURCE_SHELL, 0);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap abort")==0) {
+    LAPT_OnEvent(LAPT_EVENT_ABORT, LAPT_SOURCE_SHELL, 0);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap log")==0) {
+    LAPT_PrintLog(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap clear")==0) {
+    CS1_EnterCritical();
+    LAPT_NofLaps = LAPT_SentLaps = 0;
+    LAPT_Run.nofAborted = LAPT_Run.nofIgnored = 0;
+    CS1_ExitCritical();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void LAPT_Deinit(void) {
+  /* nothing needed */
+}
+
+void LAPT_Init(void) {
+  LAPT_Run.running = FALSE;
+  LAPT_Run.run = 0;
+  LAPT_Run.lap = 0;
+  LAPT_Run.nofSplits = 0;
+  LAPT_Run.nofIgnored = LAPT_Run.nofAborted = 0;
+  LAPT_NofLaps = LAPT_SentLaps = 0;
+#if PL_CONFIG_HAS_RADIO
+  if (RNETA_RegisterMsgHandler(RAPP_MSG_TYPE_LAP_POINT, LAPT_HandleRxMessage)!=ERR_OK) {
+    for(;;){} /* error */
+  }
+  if (RNETA_RegisterMsgHandler(RAPP_MSG_TYPE_LAP_RESULT, LAPT_HandleRxMessage)!=ERR_OK) {
+    for(;;){} /* error */
+  }
+#endif
+}
+
+#endif /* PL_CONFIG_HAS_LAP_TIME */
@@ -0,0 +1,150 @@
+/**
+ * \file
+ * \brief Interface of the lap and segment timing service.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Start, split, lap and finish events are time stamped with a free-running microsecond timebase: the
+ * local clock of the clock synchronisation (SysTick based, see TSYNC_GetLocalUs()), or LAPT_CONFIG_GET_TIME_US()
+ * if the platform provides its own timer. Without both, the time has only the resolution of the RTOS tick.
+ * The events come from the line following (start, intersections, finish), from the learned track map (end
+ * of a lap on the start line) and from the radio (RAPP_MSG_TYPE_LAP_POINT of a light barrier or another node).
+ * Radio events time stamped at the source in the shared time are converted into the local time.
+ * A run is the time from a start to the finish: it consists of laps, and each lap of segments between
+ * the splits. The last laps are kept with their split times, for the best, average and last lap and the
+ * difference of each segment to the best lap, each within a run of a node. Finished laps are sent to the other
+ * nodes (without the split times), the remote shows them on its LCD. Laps of a light barrier are not sent:
+ * every node receives its lap points itself. 'lap log' prints the history as a table for comparing the runs
+ * of different settings.
+ */
+
+#ifndef LAPTIME_H_
+#define LAPTIME_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LAP_TIME
+
+#ifndef LAPT_CONFIG_NOF_LAPS
+  #define LAPT_CONFIG_NOF_LAPS        (16)  /*!< laps kept in the history */
+#endif
+#ifndef LAPT_CONFIG_NOF_SPLITS
+  #define LAPT_CONFIG_NOF_SPLITS      (8)   /*!< split times kept per lap, the later splits are ignored */
+#endif
+#ifndef LAPT_CONFIG_MIN_SEGMENT_MS
+  #define LAPT_CONFIG_MIN_SEGMENT_MS  (200) /*!< a split or lap event closer to the last one is a repetition, e.g. of the light barrier */
+#endif
+
+#define LAPT_ERR_UNKNOWN   (0xffffffffUL) /*!< error bound of a time stamp taken on reception of a radio message */
+
+/*! \brief Timing events */
+typedef enum {
+  LAPT_EVENT_START,   /*!< starts a run with its first lap */
+  LAPT_EVENT_SPLIT,   /*!< ends a segment of the lap */
+  LAPT_EVENT_LAP,     /*!< ends the lap and starts the next one */
+  LAPT_EVENT_FINISH,  /*!< ends the lap and the run */
+  LAPT_EVENT_ABORT    /*!< ends the run, the current lap did not finish */
+} LAPT_EventKind;
+
+/*! \brief Where an event comes from */
+typedef enum {
+  LAPT_SOURCE_LINE,   /*!< line following: start, intersection or end of the line */
+  LAPT_SOURCE_TRACK,  /*!< learned track map, the tag is the TMAP_LapMode */
+  LAPT_SOURCE_RADIO,  /*!< radio, the tag is the group */
+  LAPT_SOURCE_SHELL   /*!< shell command */
+} LAPT_Source;
+
+/*! \brief A finished lap */
+typedef struct {
+  uint8_t run;          /*!< run number, counted up with each start */
+  uint8_t lap;          /*!< lap in the run, 1 is the first one */
+  uint8_t source;       /*!< LAPT_Source of the event which ended the lap */
+  uint8_t tag;          /*!< tag of that event */
+  uint8_t nofSplits;    /*!< number of split times, the lap has one segment more */
+  bool remote;          /*!< received from another node */
+  uint16_t node;        /*!< short address of that node, 0 for a lap of this node */
+  uint32_t us;          /*!< lap time */
+  uint32_t errUs;       /*!< error bound of the lap time, LAPT_ERR_UNKNOWN if not known */
+  uint32_t splitUs[LAPT_CONFIG_NOF_SPLITS]; /*!< time from the start of the lap to the end of each segment but the last */
+} LAPT_Lap;
+
+/*! \brief Summary of the laps of a run in the history */
+typedef struct {
+  uint8_t nofLaps;      /*!< finished laps of the run in the history */
+  uint32_t lastUs;      /*!< last lap */
+  uint32_t bestUs;      /*!< best lap */
+  uint32_t avgUs;       /*!< average of the laps */
+} LAPT_Summary;
+
+/*!
+ * \brief Returns the current time of the timebase.
+ * \return Time in microseconds, wraps around after about 71 minutes.
+ */
+uint32_t LAPT_GetTimeUs(void);
+
+/*!
+ * \brief Adds an event, time stamped now. Can be called from the control loop.
+ * \param kind Kind of the event.
+ * \param source Where the event comes from.
+ * \param tag Information of the source, stored with the lap.
+ */
+void LAPT_OnEvent(LAPT_EventKind kind, LAPT_Source source, uint8_t tag);
+
+/*!
+ * \brief Adds an event which has been time stamped already, e.g. at the source of a radio message.
+ * \param kind Kind of the event.
+ * \param source Where the event comes from.
+ * \param tag Information of the source, stored with the lap.
+ * \param us Time of the event, see LAPT_GetTimeUs().
+ * \param errUs Error bound of the time, 0 for the local clock, LAPT_ERR_UNKNOWN if not known.
+ */
+void LAPT_OnEventAt(LAPT_EventKind kind, LAPT_Source source, uint8_t tag, uint32_t us, uint32_t errUs);
+
+/*!
+ * \brief Returns a lap of the history.
+ * \param idx Index, 0 is the latest lap.
+ * \param lap Where to store the lap.
+ * \return ERR_OK, ERR_RANGE if there is no such lap.
+ */
+uint8_t LAPT_GetLap(uint8_t idx, LAPT_Lap *lap);
+
+/*!
+ * \brief Returns the best, average and last lap of the run of the latest lap in the history, only
+ * with the laps of the node which has timed it.
+ * \param summary Where to store the summary.
+ * \return ERR_OK, ERR_NOTAVAIL if there is no finished lap.
+ */
+uint8_t LAPT_GetSummary(LAPT_Summary *summary);
+
+/*!
+ * \brief Writes a display line: the last lap with the difference to the best one, e.g. 'L3 12.345 +0.21',
+ * or the best and the average lap, e.g. 'B12.124 A12.40'.
+ * \param buf Buffer for the text.
+ * \param bufSize Size of the buffer.
+ * \param best FALSE for the last lap, TRUE for the best and the average.
+ */
+void LAPT_GetLapString(uint8_t *buf, size_t bufSize, bool best);
+
+/*! \brief Prints the new laps and sends them to the other nodes, called from the radio task */
+void LAPT_Process(void);
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t LAPT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Driver de-initialization */
+void LAPT_Deinit(void);
+
+/*! \brief Driver initialization, after the radio */
+void LAPT_Init(void);
+
+#endif /* PL_CONFIG_HAS_LAP_TIME */
+
+#endif /* LAPTIME_H_ */
@@ -14,6 +14,12 @@
 #include "Shell.h"
 #include "Motor.h"
 #include "Reflectance.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
 #if PL_CONFIG_HAS_TURN
   #include "Turn.h"
 #endif
@@ -27,9 +33,18 @@
 #if PL_CONFIG_HAS_DRIVE
   #include "Drive.h"
 #endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  #include "SpeedPlan.h"
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
 
-#if 1 /*! \todo */
-#include "RNet_App.h"
+#if PL_CONFIG_HAS_RADIO
+  #include "RNet_App.h"
 #endif
 
 typedef enum {
@@ -43,9 +58,13 @@ typedef enum {
 /* task notification bits */
 #define LF_START_FOLLOWING (1<<0)  /* start line following */
 #define LF_STOP_FOLLOWING  (1<<1)  /* stop line following */
+#define LF_SEGMENT_END     (1<<2)  /* control loop: end of the segment, decide what to do */
 
 static volatile StateType LF_currState = STATE_IDLE;
 static xTaskHandle LFTaskHandle;
+#if PL_CONFIG_HAS_LAP_TIME
+static uint32_t LF_segmentEndUs; /* time at the end of the segment, for the lap timing */
+#endif
 
 void LF_StartFollowing(void) {
   (void)xTaskNotify(LFTaskHandle, LF_START_FOLLOWING, eSetBits);
@@ -95,17 +114,29 @@ static void StateMachine(void) {
       if (!FollowSegment()) {
         //SHELL_SendString((unsigned char*)"No line, stopped!\r\n");
         //LF_currState = STATE_STOP; /* stop if we do not have a line any more */
+#if PL_CONFIG_HAS_LAP_TIME
+        LF_segmentEndUs = LAPT_GetTimeUs();
+#endif
         LF_currState = STATE_TURN;
       }
       break;
 
     case STATE_TURN:
+#if PL_CONFIG_HAS_TRACK_MAP
+      TMAP_OnSegmentEnd(); /* the map is for a closed line without intersections */
+#endif
       lineKind = REF_GetLineKind();
       if (lineKind==REF_LINE_FULL) {
         LF_currState = STATE_FINISHED;
-      } if (lineKind==REF_LINE_NONE) {
+      } else if (lineKind==REF_LINE_NONE) {
+#if PL_CONFIG_HAS_LAP_TIME
+        LAPT_OnEventAt(LAPT_EVENT_SPLIT, LAPT_SOURCE_LINE, 0, LF_segmentEndUs, 0); /* end of the segment */
+#endif
         TURN_Turn(TURN_LEFT180, NULL);
         DRV_SetMode(DRV_MODE_NONE); /* disable position mode */
+#if PL_CONFIG_HAS_SPEED_PLAN
+        SPLAN_Reset(); /* start slow on the new segment */
+#endif
         LF_currState = STATE_FOLLOW_SEGMENT;
       } else {
         LF_currState = STATE_STOP;
@@ -113,13 +144,22 @@ static void StateMachine(void) {
       break;
 
     case STATE_FINISHED:
+#if PL_CONFIG_HAS_LAP_TIME
+      LAPT_OnEventAt(LAPT_EVENT_FINISH, LAPT_SOURCE_LINE, 0, LF_segmentEndUs, 0); /* reached the finish area */
+#endif
       SHELL_SendString("Finished!\r\n");
       LF_currState = STATE_STOP;
       break;
 
     case STATE_STOP:
-#if 1
+#if PL_CONFIG_HAS_TRACK_MAP
+      TMAP_OnSegmentEnd();
+#endif
+#if PL_CONFIG_HAS_RADIO
       RNETA_SendSignal('C'); /*! \todo */
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+      LAPT_OnEvent(LAPT_EVENT_ABORT, LAPT_SOURCE_LINE, 0); /* no effect after the finish */
 #endif
       SHELL_SendString("Stopped!\r\n");
       TURN_Turn(TURN_STOP, NULL);
@@ -132,25 +172,92 @@ bool LF_IsFollowing(void) {
   return LF_currState!=STATE_IDLE;
 }
 
+#if PL_CONFIG_HAS_CONTROL_LOOP
+void LF_ControlStep(void) {
+  if (LF_currState!=STATE_FOLLOW_SEGMENT) {
+    return; /* the line task is busy with the decisions, or we are not following */
+  }
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserBegin(RTRC_EVT_LINE_DECISION);
+#endif
+  if (!FollowSegment()) {
+#if PL_CONFIG_HAS_LAP_TIME
+    LF_segmentEndUs = LAPT_GetTimeUs(); /* in the control loop, the decision follows in the line task */
+#endif
+    LF_currState = STATE_TURN;
+    (void)xTaskNotify(LFTaskHandle, LF_SEGMENT_END, eSetBits);
+  }
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserEnd(RTRC_EVT_LINE_DECISION, (uint16_t)LF_currState);
+#endif
+}
+#endif
+
 static void LineTask (void *pvParameters) {
   uint32_t notifcationValue;
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
 
   (void)pvParameters; /* not used */
+#if PL_CONFIG_HAS_PROFILER
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  profId = PROF_Register("Line", PROF_PERIOD_NONE, 0);
+#else
+  profId = PROF_Register("Line", PROF_PERIOD_DELAY, 5);
+#endif
+#endif
   for(;;) {
+#if PL_CONFIG_HAS_CONTROL_LOOP
+    (void)xTaskNotifyWait(0UL, LF_START_FOLLOWING|LF_STOP_FOLLOWING|LF_SEGMENT_END, &notifcationValue, portMAX_DELAY);
+#endif
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
+#if !PL_CONFIG_HAS_CONTROL_LOOP
     (void)xTaskNotifyWait(0UL, LF_START_FOLLOWING|LF_STOP_FOLLOWING, &notifcationValue, 0); /* check flags */
+#endif
     if (notifcationValue&LF_START_FOLLOWING) {
-#if 1
+#if PL_CONFIG_HAS_RADIO
       RNETA_SendSignal('B'); /*! \todo */
 #endif
       DRV_SetMode(DRV_MODE_NONE); /* disable any drive mode */
       PID_Start();
+#if PL_CONFIG_HAS_LAP_TIME
+      LAPT_OnEvent(LAPT_EVENT_START, LAPT_SOURCE_LINE, 0);
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+      SPLAN_Reset();
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+      TMAP_OnStart(); /* learns the track on the first lap, or drives the learned one */
+#endif
       LF_currState = STATE_FOLLOW_SEGMENT;
     }
     if (notifcationValue&LF_STOP_FOLLOWING) {
       LF_currState = STATE_STOP;
     }
+#if PL_CONFIG_HAS_CONTROL_LOOP
+    /* the segment is followed by LF_ControlStep(), here are only the decisions between the segments */
+    while (LF_currState!=STATE_IDLE && LF_currState!=STATE_FOLLOW_SEGMENT) {
+      StateMachine();
+    }
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
+#else
+#if PL_CONFIG_HAS_RTOS_TRACE
+    RTRC_UserBegin(RTRC_EVT_LINE_DECISION);
+#endif
     StateMachine();
+#if PL_CONFIG_HAS_RTOS_TRACE
+    RTRC_UserEnd(RTRC_EVT_LINE_DECISION, (uint16_t)LF_currState);
+#endif
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
     FRTOS1_vTaskDelay(5/portTICK_PERIOD_MS);
+#endif
   }
 }
 
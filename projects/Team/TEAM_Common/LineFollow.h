@@ -46,6 +46,14 @@ void LF_StartStopFollowing(void);
  */
 bool LF_IsFollowing(void);
 
+#if PL_CONFIG_HAS_CONTROL_LOOP
+/*!
+ * \brief Runs the line controller on the reflectance frame of the current control cycle, called by the control loop.
+ * At the end of a segment the decision (turn, finish, stop) is passed to the line task, as turning blocks.
+ */
+void LF_ControlStep(void);
+#endif
+
 /*!
  * \brief Module initialization.
  */
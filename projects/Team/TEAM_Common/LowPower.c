@@ -0,0 +1,333 @@
+/**
+ * \file
+ * \brief Low power mode implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module puts the microcontroller into low power mode out of the RTOS idle task.
+ * Without tickless idle mode the CPU waits in the idle hook (WFI) for the next interrupt,
+ * which is at the latest the next RTOS tick.
+ * With tickless idle mode (configUSE_TICKLESS_IDLE) the RTOS suppresses the tick interrupts
+ * for the expected idle time and calls the pre- and post-sleep hooks of this module. As
+ * the application time base (Timer, Trigger and TmDt1) is driven by the RTOS tick hook,
+ * the ticks suppressed are added afterwards.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LOW_POWER
+#include "LowPower.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if PL_CONFIG_HAS_TIMER
+  #include "Timer.h"
+#endif
+#if PL_CONFIG_HAS_TRIGGER
+  #include "Trigger.h"
+#endif
+#if PL_CONFIG_HAS_DEBOUNCE
+  #include "KeyDebounce.h"
+#endif
+#if PL_CONFIG_HAS_KBI
+  #include "Keys.h"
+#endif
+#include "TmDt1.h"
+
+#define LP_CONFIG_TIME_ON_RTOS_TICK   (PL_CONFIG_BOARD_IS_REMOTE)
+  /*!< 1: TMR_OnInterrupt() and TmDt1_AddTick() are called from the RTOS tick hook (see Events.c), 0: they are using their own hardware timer */
+
+/* Cortex-M core registers */
+#define LP_SYST_RVR   (*((volatile uint32_t*)0xE000E014)) /* SysTick reload value register */
+#define LP_SYST_CVR   (*((volatile uint32_t*)0xE000E018)) /* SysTick current value register */
+#define LP_SCB_ICSR   (*((volatile uint32_t*)0xE000ED04)) /* interrupt control and state register */
+#define LP_ICSR_VECTPENDING(icsr)   (((icsr)>>12)&0x1FF) /* exception number of the highest priority pending exception */
+
+#define LP_EXC_SYSTICK          (15) /* exception number of the SysTick interrupt */
+#define LP_EXC_IRQ0             (16) /* exception number of the first device interrupt */
+#define LP_NOF_WAKEUP_SOURCES   (8)  /* number of different wake-up sources we keep statistics for */
+
+/*! \brief Statistics for a wake-up source */
+typedef struct {
+  uint16_t exception; /*!< exception number, 0 for unused entry */
+  uint32_t cnt;       /*!< number of wake-ups */
+} LP_WakeupSource;
+
+/*! \brief Power mode statistics */
+typedef struct {
+  TickType_t startTick;     /*!< tick count when the statistics have been reset */
+  uint32_t nofWaits;        /*!< number of times we entered wait mode from the idle hook */
+  uint64_t waitCycles;      /*!< SysTick cycles spent in wait mode */
+  uint32_t nofTickless;     /*!< number of times we entered tickless idle mode */
+  uint32_t ticklessTicks;   /*!< RTOS ticks suppressed by tickless idle mode */
+  uint32_t nofVetoes;       /*!< number of times tickless idle mode has been denied by the decision hook */
+  uint32_t wakeupOther;     /*!< wake-ups not fitting into the wakeups[] table */
+  LP_WakeupSource wakeups[LP_NOF_WAKEUP_SOURCES]; /*!< wake-up sources */
+} LP_StatsType;
+
+static LP_StatsType LP_Stats;
+static volatile uint32_t LP_HookTicks = 0; /* number of ticks seen by the tick hook */
+#if configUSE_TICKLESS_IDLE
+static volatile bool LP_TicklessPending = FALSE; /* set after tickless idle mode, until the ticks have been compensated */
+static TickType_t LP_SleepTickCount; /* RTOS tick count when entering tickless idle mode */
+static uint32_t LP_SleepHookTicks; /* LP_HookTicks when entering tickless idle mode */
+#endif
+
+/*!
+ * \brief Records the source of a wake-up. Called with interrupts disabled.
+ * \param exception Exception number of the pending exception, 0 if none.
+ */
+static void LP_RecordWakeup(uint16_t exception) {
+  int i;
+
+  for(i=0;i<LP_NOF_WAKEUP_SOURCES;i++) {
+    if (LP_Stats.wakeups[i].exception==exception) {
+      LP_Stats.wakeups[i].cnt++;
+      return;
+    }
+    if (LP_Stats.wakeups[i].exception==0) { /* free entry */
+      LP_Stats.wakeups[i].exception = exception;
+      LP_Stats.wakeups[i].cnt = 1;
+      return;
+    }
+  }
+  LP_Stats.wakeupOther++; /* table full */
+}
+
+#if configUSE_TICKLESS_IDLE
+/*!
+ * \brief Adds the ticks suppressed by tickless idle mode to the application time base.
+ * Called from the idle task, as the RTOS has stepped its tick count after the tick hook could see it.
+ */
+static void LP_CompensateTicks(void) {
+  int32_t missed;
+
+  taskENTER_CRITICAL();
+  if (!LP_TicklessPending) {
+    taskEXIT_CRITICAL();
+    return;
+  }
+  LP_TicklessPending = FALSE;
+  /* ticks counted by the RTOS, but not seen by the tick hook */
+  missed = (int32_t)((xTaskGetTickCount()-LP_SleepTickCount)-(LP_HookTicks-LP_SleepHookTicks));
+  if (missed<=0) {
+    taskEXIT_CRITICAL();
+    return;
+  }
+  LP_Stats.ticklessTicks += missed;
+#if LP_CONFIG_TIME_ON_RTOS_TICK
+  {
+    int32_t i;
+
+    for(i=0;i<missed;i++) {
+      TmDt1_AddTick();
+    }
+  }
+#endif
+  taskEXIT_CRITICAL();
+#if LP_CONFIG_TIME_ON_RTOS_TICK && PL_CONFIG_HAS_TIMER
+  TMR_AddTicks((uint32_t)missed);
+#endif
+}
+
+BaseType_t xEnterTicklessIdle(void) {
+  /* called with the scheduler suspended */
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  /* the tacho needs every tick to sample the quadrature encoders */
+  LP_Stats.nofVetoes++;
+  return pdFALSE;
+#else
+  #if PL_CONFIG_HAS_TRIGGER
+  if (TRG_TicksToNextTrigger()!=0) { /* a trigger needs the tick to fire on time */
+    LP_Stats.nofVetoes++;
+    return pdFALSE;
+  }
+  #endif
+  #if PL_CONFIG_HAS_DEBOUNCE
+  if (!KEYDBNC_IsIdle()) { /* keys are pressed or getting debounced */
+    LP_Stats.nofVetoes++;
+    return pdFALSE;
+  }
+  #endif
+  return pdTRUE;
+#endif
+}
+
+void LP_PreSleepProcessing(TickType_t expectedIdleTicks) {
+  (void)expectedIdleTicks;
+  LP_SleepTickCount = xTaskGetTickCount();
+  LP_SleepHookTicks = LP_HookTicks;
+  LP_TicklessPending = TRUE;
+  LP_Stats.nofTickless++;
+#if PL_CONFIG_HAS_KBI
+  KEY_EnableInterrupts(); /* a key press shall wake us up */
+#endif
+  __asm volatile("dsb");
+  __asm volatile("wfi"); /* interrupts are disabled: we get woken up by any pending interrupt, but it is not served yet */
+  __asm volatile("isb");
+}
+
+void LP_PostSleepProcessing(TickType_t expectedIdleTicks) {
+  (void)expectedIdleTicks;
+  LP_RecordWakeup(LP_ICSR_VECTPENDING(LP_SCB_ICSR));
+#if PL_CONFIG_HAS_KBI
+  KEY_DisableInterrupts(); /* keys are sampled periodically again */
+#endif
+}
+#endif /* configUSE_TICKLESS_IDLE */
+
+void LP_OnTick(void) {
+  LP_HookTicks++;
+}
+
+void LP_EnterLowPower(void) {
+  uint32_t start, end, cycles;
+
+#if configUSE_TICKLESS_IDLE
+  LP_CompensateTicks(); /* catch up with the ticks from the last tickless sleep */
+#endif
+  __asm volatile("cpsid i"); /* with interrupts disabled, the wake-up source remains pending */
+  start = LP_SYST_CVR;
+  __asm volatile("dsb");
+  __asm volatile("wfi");
+  __asm volatile("isb");
+  end = LP_SYST_CVR;
+  LP_RecordWakeup(LP_ICSR_VECTPENDING(LP_SCB_ICSR));
+  /* SysTick is counting down and wakes us up at the latest after one period */
+  if (start>=end) {
+    cycles = start-end;
+  } else {
+    cycles = start+(LP_SYST_RVR+1)-end;
+  }
+  LP_Stats.waitCycles += cycles;
+  LP_Stats.nofWaits++;
+  __asm volatile("cpsie i"); /* serve the interrupt which woke us up */
+}
+
+/*!
+ * \brief Resets the power mode statistics.
+ */
+static void LP_ResetStats(void) {
+  int i;
+
+  taskENTER_CRITICAL();
+  LP_Stats.startTick = xTaskGetTickCount();
+  LP_Stats.nofWaits = 0;
+  LP_Stats.waitCycles = 0;
+  LP_Stats.nofTickless = 0;
+  LP_Stats.ticklessTicks = 0;
+  LP_Stats.nofVetoes = 0;
+  LP_Stats.wakeupOther = 0;
+  for(i=0;i<LP_NOF_WAKEUP_SOURCES;i++) {
+    LP_Stats.wakeups[i].exception = 0;
+    LP_Stats.wakeups[i].cnt = 0;
+  }
+  taskEXIT_CRITICAL();
+}
+
+#if PL_CONFIG_HAS_SHELL
+/*!
+ * \brief Prints a time in ms with its share of the total time.
+ * \param title Status title
+ * \param ms Time in milliseconds
+ * \param totalMs Total time in milliseconds
+ * \param nofEntries Number of times the mode has been entered
+ * \param io I/O channel to use
+ */
+static void LP_PrintMode(const unsigned char *title, uint32_t ms, uint32_t totalMs, uint32_t nofEntries, const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), ms);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms (");
+  UTIL1_strcatNum32u(buf, sizeof(buf), totalMs!=0?(uint32_t)(((uint64_t)ms*100)/totalMs):0);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%), ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), nofEntries);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" entries\r\n");
+  CLS1_SendStatusStr(title, buf, io->stdOut);
+}
+
+static void LP_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+  uint32_t totalMs, waitMs, ticklessMs, runMs;
+  int i;
+
+  totalMs = (xTaskGetTickCount()-LP_Stats.startTick)*portTICK_PERIOD_MS;
+  waitMs = (uint32_t)(LP_Stats.waitCycles/(configSYSTICK_CLOCK_HZ/1000));
+  ticklessMs = LP_Stats.ticklessTicks*portTICK_PERIOD_MS;
+  if (waitMs+ticklessMs<totalMs) {
+    runMs = totalMs-waitMs-ticklessMs;
+  } else {
+    runMs = 0;
+  }
+  CLS1_SendStatusStr((unsigned char*)"power", (unsigned char*)"\r\n", io->stdOut);
+#if configUSE_TICKLESS_IDLE
+  CLS1_SendStatusStr((unsigned char*)"  idle mode", (unsigned char*)"wait, tickless\r\n", io->stdOut);
+#else
+  CLS1_SendStatusStr((unsigned char*)"  idle mode", (unsigned char*)"wait\r\n", io->stdOut);
+#endif
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), totalMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  elapsed", buf, io->stdOut);
+  LP_PrintMode((unsigned char*)"  run", runMs, totalMs, 0, io);
+  LP_PrintMode((unsigned char*)"  wait", waitMs, totalMs, LP_Stats.nofWaits, io);
+  LP_PrintMode((unsigned char*)"  tickless", ticklessMs, totalMs, LP_Stats.nofTickless, io);
+#if configUSE_TICKLESS_IDLE
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), LP_Stats.nofVetoes);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  vetoes", buf, io->stdOut);
+#endif
+  CLS1_SendStatusStr((unsigned char*)"  wake-ups", (unsigned char*)"", io->stdOut);
+  for(i=0;i<LP_NOF_WAKEUP_SOURCES && LP_Stats.wakeups[i].exception!=0;i++) {
+    if (LP_Stats.wakeups[i].exception==LP_EXC_SYSTICK) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"SysTick");
+    } else if (LP_Stats.wakeups[i].exception>=LP_EXC_IRQ0) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"IRQ");
+      UTIL1_strcatNum16u(buf, sizeof(buf), LP_Stats.wakeups[i].exception-LP_EXC_IRQ0);
+    } else {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Exc");
+      UTIL1_strcatNum16u(buf, sizeof(buf), LP_Stats.wakeups[i].exception);
+    }
+    UTIL1_chcat(buf, sizeof(buf), ':');
+    UTIL1_strcatNum32u(buf, sizeof(buf), LP_Stats.wakeups[i].cnt);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"other:");
+  UTIL1_strcatNum32u(buf, sizeof(buf), LP_Stats.wakeupOther);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+}
+
+static void LP_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"power", (unsigned char*)"Group of low power commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows power help or power mode statistics\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the power mode statistics\r\n", io->stdOut);
+}
+
+uint8_t LP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"power help")==0) {
+    LP_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"power status")==0) {
+    LP_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"power reset")==0) {
+    LP_ResetStats();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void LP_Deinit(void) {
+  /* nothing to do */
+}
+
+void LP_Init(void) {
+  LP_ResetStats();
+}
+
+#endif /* PL_CONFIG_HAS_LOW_POWER */
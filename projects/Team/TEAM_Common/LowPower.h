@@ -0,0 +1,71 @@
+/**
+ * \file
+ * \brief Low power mode interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module puts the microcontroller into low power mode out of the RTOS idle task.
+ * Depending on the FreeRTOS configuration it either simply waits for the next interrupt,
+ * or is used by the RTOS tickless idle mode to suppress the tick interrupts.
+ * It keeps statistics about the time spent in each power mode and about the wake-up sources.
+ */
+
+#ifndef LOWPOWER_H_
+#define LOWPOWER_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LOW_POWER
+#include "FRTOS1.h"
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t LP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Enters wait mode until the next interrupt. Called from the RTOS idle hook.
+ * This also catches up the application time base after the RTOS has been in tickless idle mode.
+ */
+void LP_EnterLowPower(void);
+
+#if configUSE_TICKLESS_IDLE
+/*!
+ * \brief Tickless idle decision hook, called by the RTOS before suppressing the tick interrupts.
+ * \return pdTRUE if the RTOS is allowed to enter tickless idle mode, pdFALSE otherwise.
+ */
+BaseType_t xEnterTicklessIdle(void);
+
+/*!
+ * \brief Called by the RTOS with interrupts disabled and the tick suppressed. Enters wait mode.
+ * \param expectedIdleTicks Number of ticks the RTOS expects to be idle.
+ */
+void LP_PreSleepProcessing(TickType_t expectedIdleTicks);
+
+/*!
+ * \brief Called by the RTOS after waking up from tickless idle mode, still with interrupts disabled.
+ * \param expectedIdleTicks Number of ticks the RTOS expected to be idle.
+ */
+void LP_PostSleepProcessing(TickType_t expectedIdleTicks);
+#endif
+
+/*!
+ * \brief Called from the RTOS tick hook: counts the ticks seen by the application.
+ */
+void LP_OnTick(void);
+
+/*! \brief De-initializes the module. */
+void LP_Deinit(void);
+
+/*! \brief Initializes the module. */
+void LP_Init(void);
+
+#endif /* PL_CONFIG_HAS_LOW_POWER */
+
+#endif /* LOWPOWER_H_ */
@@ -0,0 +1,259 @@
+/**
+ * \file
+ * \brief Fixed block memory pools.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Each size class is a static array of blocks with a free list linked through the free blocks,
+ * so allocating and freeing is constant time and the memory never fragments.
+ * An allocation is served by the smallest class with a free block; if its own class is exhausted
+ * it spills into the next larger one. The statistics show how well the classes are dimensioned.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MEM_POOL
+#include "MemPool.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if PL_CONFIG_HAS_SHELL_QUEUE && !PL_CONFIG_SQUEUE_SINGLE_CHAR
+  #include "ShellQueue.h"
+#endif
+
+#ifndef MPOOL_CONFIG_HOST
+  #define MPOOL_CONFIG_HOST   (0) /* 1: built for the host, without critical sections */
+#endif
+
+#if MPOOL_CONFIG_HOST
+  #define CS1_CriticalVariable()  /* nothing */
+  #define CS1_EnterCritical()     /* nothing */
+  #define CS1_ExitCritical()      /* nothing */
+#else
+  #include "CS1.h"
+#endif
+
+/* Size classes, from the lengths of the shell messages in this application:
+ * - 48 bytes: status lines, e.g. the radio receive messages built in RNet_App.c
+ * - 96 bytes: the longest shell messages (warnings, around 70 characters), longer ones are split
+ */
+#define MPOOL_SMALL_SIZE      48
+#define MPOOL_SMALL_BLOCKS    12
+#define MPOOL_LARGE_SIZE      96
+#define MPOOL_LARGE_BLOCKS    4
+
+#define MPOOL_NOF_CLASSES     2
+#define MPOOL_MAX_BLOCKS      32 /* blocks per class, one bit each in the allocation mask */
+
+/*! \brief Free blocks are linked through their first word */
+typedef struct MPOOL_FreeBlock_ {
+  struct MPOOL_FreeBlock_ *next;
+} MPOOL_FreeBlock;
+
+/*! \brief A size class */
+typedef struct {
+  uint16_t blockSize;         /*!< size of a block, multiple of 4 */
+  uint8_t nofBlocks;          /*!< number of blocks */
+  uint8_t *mem;               /*!< memory of the blocks */
+  MPOOL_FreeBlock *freeList;  /*!< list of free blocks */
+  uint32_t allocated;         /*!< bit set for each allocated block, to catch double and invalid frees */
+  uint8_t nofFree;            /*!< number of free blocks */
+  uint8_t minFree;            /*!< low-water mark of the free blocks */
+  uint32_t nofAllocs;         /*!< number of blocks handed out */
+  uint32_t nofSpills;         /*!< requests for this class served by a larger class */
+  uint32_t nofFails;          /*!< requests for this class which could not be served at all */
+} MPOOL_Pool;
+
+/* uint32_t arrays to have the blocks word aligned */
+static uint32_t MPOOL_SmallMem[MPOOL_SMALL_BLOCKS*MPOOL_SMALL_SIZE/sizeof(uint32_t)];
+static uint32_t MPOOL_LargeMem[MPOOL_LARGE_BLOCKS*MPOOL_LARGE_SIZE/sizeof(uint32_t)];
+
+static MPOOL_Pool MPOOL_Pools[MPOOL_NOF_CLASSES] = { /* sorted by block size, the free list and the counters are set by MPOOL_Init() */
+  {MPOOL_SMALL_SIZE,  MPOOL_SMALL_BLOCKS,  (uint8_t*)MPOOL_SmallMem, NULL, 0, 0, 0, 0, 0, 0},
+  {MPOOL_LARGE_SIZE,  MPOOL_LARGE_BLOCKS,  (uint8_t*)MPOOL_LargeMem, NULL, 0, 0, 0, 0, 0, 0},
+};
+
+static uint32_t MPOOL_nofTooLarge;    /* requests larger than the largest class */
+static uint32_t MPOOL_nofInvalidFree; /* frees of foreign or already freed blocks */
+
+void *MPOOL_Alloc(size_t size) {
+  uint8_t i, requested = MPOOL_NOF_CLASSES;
+  MPOOL_Pool *pool;
+  MPOOL_FreeBlock *block;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=0; i<MPOOL_NOF_CLASSES; i++) {
+    pool = &MPOOL_Pools[i];
+    if (size<=pool->blockSize) {
+      if (requested==MPOOL_NOF_CLASSES) {
+        requested = i; /* class which should serve the request */
+      }
+      block = pool->freeList;
+      if (block!=NULL) {
+        pool->freeList = block->next;
+        pool->allocated |= 1UL<<(((uint8_t*)block-pool->mem)/pool->blockSize);
+        pool->nofFree--;
+        if (pool->nofFree<pool->minFree) {
+          pool->minFree = pool->nofFree;
+        }
+        pool->nofAllocs++;
+        if (i!=requested) {
+          MPOOL_Pools[requested].nofSpills++;
+        }
+        CS1_ExitCritical();
+        return block;
+      }
+    }
+  }
+  if (requested==MPOOL_NOF_CLASSES) {
+    MPOOL_nofTooLarge++;
+  } else {
+    MPOOL_Pools[requested].nofFails++; /* all classes which could serve it are exhausted */
+  }
+  CS1_ExitCritical();
+  return NULL;
+}
+
+uint8_t MPOOL_Free(void *p) {
+  uint8_t i;
+  MPOOL_Pool *pool;
+  size_t offset;
+  uint32_t mask;
+  CS1_CriticalVariable()
+
+  if (p==NULL) {
+    return ERR_OK;
+  }
+  for(i=0; i<MPOOL_NOF_CLASSES; i++) {
+    pool = &MPOOL_Pools[i];
+    if ((uint8_t*)p>=pool->mem && (uint8_t*)p<pool->mem+pool->nofBlocks*pool->blockSize) {
+      offset = (uint8_t*)p-pool->mem;
+      mask = 1UL<<(offset/pool->blockSize);
+      CS1_EnterCritical();
+      if ((offset%pool->blockSize)!=0 || (pool->allocated&mask)==0) { /* not the start of a block, or not allocated */
+        MPOOL_nofInvalidFree++;
+        CS1_ExitCritical();
+        return ERR_FAILED;
+      }
+      pool->allocated &= ~mask;
+      ((MPOOL_FreeBlock*)p)->next = pool->freeList;
+      pool->freeList = (MPOOL_FreeBlock*)p;
+      pool->nofFree++;
+      CS1_ExitCritical();
+      return ERR_OK;
+    }
+  }
+  MPOOL_nofInvalidFree++; /* not from a pool */
+  return ERR_FAILED;
+}
+
+size_t MPOOL_GetMaxBlockSize(void) {
+  return MPOOL_Pools[MPOOL_NOF_CLASSES-1].blockSize;
+}
+
+static void MPOOL_ResetStatistics(void) {
+  uint8_t i;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=0; i<MPOOL_NOF_CLASSES; i++) {
+    MPOOL_Pools[i].minFree = MPOOL_Pools[i].nofFree;
+    MPOOL_Pools[i].nofAllocs = 0;
+    MPOOL_Pools[i].nofSpills = 0;
+    MPOOL_Pools[i].nofFails = 0;
+  }
+  MPOOL_nofTooLarge = 0;
+  MPOOL_nofInvalidFree = 0;
+  CS1_ExitCritical();
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void MPOOL_PrintStatus(const CLS1_StdIOType *io) {
+  uint8_t i;
+  MPOOL_Pool *pool;
+  unsigned char label[16];
+  unsigned char buf[64];
+
+  CLS1_SendStatusStr((unsigned char*)"mpool", (unsigned char*)"\r\n", io->stdOut);
+  for(i=0; i<MPOOL_NOF_CLASSES; i++) {
+    pool = &MPOOL_Pools[i];
+    UTIL1_strcpy(label, sizeof(label), (unsigned char*)"  ");
+    UTIL1_strcatNum16u(label, sizeof(label), pool->blockSize);
+    UTIL1_strcat(label, sizeof(label), (unsigned char*)" bytes");
+    buf[0] = '\0';
+    UTIL1_strcatNum8u(buf, sizeof(buf), pool->nofFree);
+    UTIL1_chcat(buf, sizeof(buf), '/');
+    UTIL1_strcatNum8u(buf, sizeof(buf), pool->nofBlocks);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" free, min ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), pool->minFree);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", allocs ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), pool->nofAllocs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", spills ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), pool->nofSpills);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", fails ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), pool->nofFails);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr(label, buf, io->stdOut);
+  }
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), MPOOL_nofTooLarge);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" too large, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), MPOOL_nofInvalidFree);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" invalid free\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  errors", buf, io->stdOut);
+#if PL_CONFIG_HAS_SHELL_QUEUE && !PL_CONFIG_SQUEUE_SINGLE_CHAR
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), SQUEUE_GetNofDropped());
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" shell messages\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  dropped", buf, io->stdOut);
+#endif
+}
+
+static void MPOOL_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"mpool", (unsigned char*)"Group of memory pool commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows memory pool help or usage statistics\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the statistics\r\n", io->stdOut);
+}
+
+uint8_t MPOOL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"mpool help")==0) {
+    MPOOL_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"mpool status")==0) {
+    MPOOL_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"mpool reset")==0) {
+    MPOOL_ResetStatistics();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void MPOOL_Deinit(void) {
+  /* nothing to do, memory is static */
+}
+
+void MPOOL_Init(void) {
+  uint8_t i, j;
+  MPOOL_Pool *pool;
+  MPOOL_FreeBlock *block;
+
+  for(i=0; i<MPOOL_NOF_CLASSES; i++) {
+    pool = &MPOOL_Pools[i];
+    if (pool->nofBlocks>MPOOL_MAX_BLOCKS || (pool->blockSize%sizeof(uint32_t))!=0) {
+      for(;;){} /* wrong configuration */
+    }
+    pool->freeList = NULL;
+    for(j=pool->nofBlocks; j>0; j--) { /* link all blocks, lowest address first */
+      block = (MPOOL_FreeBlock*)(pool->mem+(j-1)*pool->blockSize);
+      block->next = pool->freeList;
+      pool->freeList = block;
+    }
+    pool->allocated = 0;
+    pool->nofFree = pool->nofBlocks;
+  }
+  MPOOL_ResetStatistics();
+}
+
+#endif /* PL_CONFIG_HAS_MEM_POOL */
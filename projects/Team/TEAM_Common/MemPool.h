@@ -0,0 +1,59 @@
+/**
+ * \file
+ * \brief Interface of the fixed block memory pools.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Static pools of fixed size blocks, used for the shell messages (see ShellQueue.c)
+ * instead of the RTOS heap: no fragmentation and constant time allocation.
+ */
+
+#ifndef MEMPOOL_H_
+#define MEMPOOL_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MEM_POOL
+#include <stddef.h>
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t MPOOL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Allocates a block from the smallest size class which fits and has a free block.
+ * Can be called from tasks and interrupts.
+ * \param size Number of bytes needed.
+ * \return Pointer to the block, or NULL if no block is available.
+ */
+void *MPOOL_Alloc(size_t size);
+
+/*!
+ * \brief Returns a block to its pool. Can be called from tasks and interrupts.
+ * \param p Pointer returned by MPOOL_Alloc(), NULL is ignored.
+ * \return ERR_OK, or ERR_FAILED if the pointer does not belong to a pool or has been freed already.
+ */
+uint8_t MPOOL_Free(void *p);
+
+/*!
+ * \brief Returns the size of the largest block which can be allocated.
+ * \return Size in bytes.
+ */
+size_t MPOOL_GetMaxBlockSize(void);
+
+/*! \brief De-initializes the module. */
+void MPOOL_Deinit(void);
+
+/*! \brief Initializes the module, all blocks are free afterwards. */
+void MPOOL_Init(void);
+
+#endif /* PL_CONFIG_HAS_MEM_POOL */
+
+#endif /* MEMPOOL_H_ */
@@ -16,6 +16,8 @@
 #include "UTIL1.h"
 
 static MOT_MotorDevice motorL, motorR;
+static bool MOT_Held = FALSE; /* outputs are held back until MOT_ApplyOutputs() */
+static bool MOT_Pending = FALSE; /* values have been stored while held */
 
 MOT_MotorDevice *MOT_GetMotorHandle(MOT_MotorSide side) {
   if (side==MOT_MOTOR_LEFT) {
@@ -43,9 +45,22 @@ static void DirRPutVal(bool val) {
   DIRR_PutVal(val);
 }
 
+static void MOT_PutDirVal(MOT_MotorDevice *motor, bool val) {
+  motor->currDirVal = val;
+  if (MOT_Held) {
+    MOT_Pending = TRUE;
+  } else {
+    motor->DirPutVal(val);
+  }
+}
+
 void MOT_SetVal(MOT_MotorDevice *motor, uint16_t val) {
   motor->currPWMvalue = val;
-  motor->SetRatio16(val);
+  if (MOT_Held) {
+    MOT_Pending = TRUE;
+  } else {
+    motor->SetRatio16(val);
+  }
 }
 
 uint16_t MOT_GetVal(MOT_MotorDevice *motor) {
@@ -99,18 +114,18 @@ void MOT_ChangeSpeedPercent(MOT_MotorDevice *motor, MOT_SpeedPercent relPercent)
 void MOT_SetDirection(MOT_MotorDevice *motor, MOT_Direction dir) {
   if (dir==MOT_DIR_FORWARD ) {
 #if MOTOR_HAS_INVERT
-    motor->DirPutVal(motor->inverted?0:1);
+    MOT_PutDirVal(motor, motor->inverted?0:1);
 #else
-    motor->DirPutVal(1);
+    MOT_PutDirVal(motor, 1);
 #endif
     if (motor->currSpeedPercent<0) {
       motor->currSpeedPercent = -motor->currSpeedPercent;
     }
   } else if (dir==MOT_DIR_BACKWARD) {
 #if MOTOR_HAS_INVERT
-    motor->DirPutVal(motor->inverted?1:0);
+    MOT_PutDirVal(motor, motor->inverted?1:0);
 #else
-    motor->DirPutVal(0);
+    MOT_PutDirVal(motor, 0);
 #endif
     if (motor->currSpeedPercent>0) {
       motor->currSpeedPercent = -motor->currSpeedPercent;
@@ -126,6 +141,21 @@ MOT_Direction MOT_GetDirection(MOT_MotorDevice *motor) {
   }
 }
 
+void MOT_HoldOutputs(void) {
+  MOT_Held = TRUE;
+}
+
+void MOT_ApplyOutputs(void) {
+  MOT_Held = FALSE;
+  if (MOT_Pending) {
+    MOT_Pending = FALSE;
+    motorL.DirPutVal(motorL.currDirVal);
+    motorR.DirPutVal(motorR.currDirVal);
+    (void)motorL.SetRatio16(motorL.currPWMvalue);
+    (void)motorR.SetRatio16(motorR.currPWMvalue);
+  }
+}
+
 #if PL_CONFIG_HAS_SHELL
 static void MOT_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"motor", (unsigned char*)"Group of motor commands\r\n", io->stdOut);
@@ -27,6 +27,7 @@ typedef struct MOT_MotorDevice_ {
 #endif
   MOT_SpeedPercent currSpeedPercent; /*!< our current speed in %, negative percent means backward */
   uint16_t currPWMvalue; /*!< current PWM value used */
+  bool currDirVal; /*!< current value of the direction bit */
   uint8_t (*SetRatio16)(uint16_t); /*!< function to set the ratio */
   void (*DirPutVal)(bool); /*!< function to set direction bit */
 } MOT_MotorDevice;
@@ -102,6 +103,17 @@ void MOT_SetDirection(MOT_MotorDevice *motor, MOT_Direction dir);
  */
 MOT_Direction MOT_GetDirection(MOT_MotorDevice *motor);
 
+/*!
+ * \brief Holds back the motor outputs: until MOT_ApplyOutputs(), MOT_SetVal() and MOT_SetDirection()
+ * only store the new values. Used by the control loop, so both motors get updated together at the end of a cycle.
+ */
+void MOT_HoldOutputs(void);
+
+/*!
+ * \brief Writes the PWM and direction values stored while the outputs were held to both motors, and releases the hold.
+ */
+void MOT_ApplyOutputs(void);
+
 #if PL_CONFIG_HAS_SHELL
 #include "CLS1.h"
 /*!
@@ -37,6 +37,34 @@ void *NVMC_GetReflectanceData(void) {
   return (void*)NVMC_REFLECTANCE_DATA_START_ADDR;
 }
 
+uint8_t NVMC_SaveHwProfileData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_HWPROFILE_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_HWPROFILE_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetHwProfileData(void) {
+  if (isErased((uint8_t*)NVMC_HWPROFILE_DATA_START_ADDR, NVMC_HWPROFILE_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_HWPROFILE_DATA_START_ADDR;
+}
+
+uint8_t NVMC_SaveTrackData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_TRACK_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_TRACK_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetTrackData(void) {
+  if (isErased((uint8_t*)NVMC_TRACK_DATA_START_ADDR, NVMC_TRACK_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_TRACK_DATA_START_ADDR;
+}
+
 void NVMC_Init(void) {
   /* nothing needed */
 }
@@ -17,6 +17,7 @@
   /*!< NVRM_Config, start address of configuration data in flash */
   /*! \todo add flash base address for NVMC */
   #define NVMC_FLASH_START_ADDR    0x1FC00
+  #define NVMC_FLASH_BLOCK_SIZE    0x400     /* last sector of the 128 KByte flash */
 #elif PL_CONFIG_BOARD_IS_ROBO
   #define NVMC_FLASH_START_ADDR    0x10000000 /* DFLASH, NVRM_Config, start address of configuration data in flash */
   #define NVMC_FLASH_BLOCK_SIZE    0x1000     /* IntFlashLdd1_BLOCK0_ERASABLE_UNIT_SIZE */
@@ -38,6 +39,23 @@
 #define NVMC_REFLECTANCE_DATA_SIZE        (6*2*2) /* maximum of 6 sensors (min and max) values with 16 bits */
 #define NVMC_REFLECTANCE_END_ADDR         (NVMC_REFLECTANCE_DATA_START_ADDR+NVMC_REFLECTANCE_DATA_SIZE)
 
+#define NVMC_HWPROFILE_DATA_START_ADDR    (NVMC_REFLECTANCE_END_ADDR)
+#define NVMC_HWPROFILE_DATA_SIZE          (16) /* HWP_Profile */
+#define NVMC_HWPROFILE_END_ADDR           (NVMC_HWPROFILE_DATA_START_ADDR+NVMC_HWPROFILE_DATA_SIZE)
+
+#define NVMC_TRACK_DATA_START_ADDR        (NVMC_HWPROFILE_END_ADDR)
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+  #define NVMC_TRACK_DATA_SIZE            (2*2+TMAP_CONFIG_NOF_BINS*2) /* TMAP_Data: header and TMAP_CONFIG_NOF_BINS curvatures */
+#else
+  #define NVMC_TRACK_DATA_SIZE            (0)
+#endif
+#define NVMC_TRACK_END_ADDR               (NVMC_TRACK_DATA_START_ADDR+NVMC_TRACK_DATA_SIZE)
+
+#if NVMC_TRACK_END_ADDR>NVMC_FLASH_START_ADDR+NVMC_FLASH_BLOCK_SIZE
+  #error "configuration data does not fit into the flash block, reduce TMAP_CONFIG_NOF_BINS"
+#endif
+
 /*!
  * \brief Saves the reflectance calibration data
  * \param data Pointer to the data
@@ -52,6 +70,34 @@ uint8_t NVMC_SaveReflectanceData(void *data, uint16_t dataSize);
  */
 void *NVMC_GetReflectanceData(void);
 
+/*!
+ * \brief Saves the hardware profile of the robot
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveHwProfileData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the hardware profile of the robot
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetHwProfileData(void);
+
+/*!
+ * \brief Saves the learned track map
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveTrackData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the learned track map
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetTrackData(void);
+
 /*! \brief Driver initialization  */
 void NVMC_Init(void);
 
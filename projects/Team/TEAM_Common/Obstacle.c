@@ -0,0 +1,380 @@
+/**
+ * \file
+ * \brief Obstacle map around the robot, see Obstacle.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The map is computed with integers only: points in mm, angles as binary angles (65536 per turn)
+ * and sine/cosine as Q15 values. Each update first moves the points with the odometry since the
+ * last update (translation along the mean heading, then rotation), sorts them into the sectors of
+ * their new bearing (the nearest point wins) and ages them. Then each ToF measurement removes the
+ * points it would have seen in front of its target (or up to OBST_CLEAR_MM if there is no target),
+ * and adds its target.
+ * The update and the queries work on a copy of the map: only copying the map in or out is done in a
+ * critical section, so the interrupts are blocked for a short time only.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+#include "Obstacle.h"
+#include "Distance.h"
+#include "VL6180X.h"
+#include "FRTOS1.h"
+#include "CLS1.h"
+#include "UTIL1.h"
+#include "CS1.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+  #define OBST_COUNTS_PER_M       ((int32_t)HWP_Get()->countsPerM)
+#else
+  #define OBST_COUNTS_PER_M       OBST_CONFIG_COUNTS_PER_M
+#endif
+
+#define OBST_ANGLE_FROM_DEG(deg)  ((uint16_t)(((int32_t)(deg)*65536)/360))
+#define OBST_ANGLE_TO_DEG(a)      ((int16_t)(((int32_t)(int16_t)(a)*360)/65536))
+#define OBST_SECTOR_ANGLE         ((uint16_t)(65536/OBST_CONFIG_NOF_SECTORS))
+#define OBST_FOV_HALF_ANGLE       OBST_ANGLE_FROM_DEG(12) /* VL6180X field of view is about 25 degree */
+#define OBST_TOLERANCE_MM         20  /* points this much in front of a target are not removed: range noise */
+#define OBST_CLEAR_MM             200 /* no target: the beam is free at least up to this range (1x scaling) */
+#define OBST_SAME_POINT_MM        30  /* a farther target this close to the point in the sector is the same obstacle */
+
+typedef struct {
+  int16_t x, y;   /* obstacle point relative to the robot center in mm, x forward, y left */
+  uint16_t ttlMs; /* remaining time in the map, 0: sector is empty */
+} OBST_Cell;
+
+static OBST_Cell OBST_Map[OBST_CONFIG_NOF_SECTORS];
+static OBST_Cell OBST_Work[OBST_CONFIG_NOF_SECTORS]; /* map being updated by OBST_Update() */
+static uint8_t OBST_ClearCntr; /* incremented by OBST_Clear(), an update started before is dropped */
+static int32_t OBST_LastLeft, OBST_LastRight; /* encoder counters of the last update */
+static TickType_t OBST_LastTick;
+static bool OBST_HaveLast = FALSE;
+static int16_t OBST_SpeedMmS; /* forward speed of the robot from the odometry */
+
+/* sin(0..90 degree) in Q15, 64 steps */
+static const int16_t OBST_SinTable[65] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512,
+  10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868,
+  19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811, 25329, 25832, 26319,
+  26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113,
+  31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767,
+};
+
+/* sine of a binary angle in Q15, linear interpolation of the table */
+static int32_t OBST_Sin(uint16_t a) {
+  uint16_t q = a&0x3fff; /* angle in the quadrant */
+  int32_t idx, frac, val;
+
+  if (a&0x4000) { /* 2nd and 4th quadrant: mirrored */
+    q = (uint16_t)(0x4000-q);
+  }
+  idx = q>>8;
+  frac = q&0xff;
+  val = OBST_SinTable[idx];
+  if (idx<64) {
+    val += ((OBST_SinTable[idx+1]-val)*frac)/256;
+  }
+  return (a&0x8000) ? -val : val;
+}
+
+static int32_t OBST_Cos(uint16_t a) {
+  return OBST_Sin((uint16_t)(a+0x4000));
+}
+
+/* binary angle of a vector, atan(z) approximated with z*pi/4+0.273*z*(1-z), error below 0.3 degree */
+static uint16_t OBST_Atan2(int32_t y, int32_t x) {
+  int32_t ax = x<0 ? -x : x, ay = y<0 ? -y : y, z;
+  uint16_t a;
+
+  if (ax==0 && ay==0) {
+    return 0;
+  }
+  if (ax>=ay) {
+    z = (ay*32768)/ax; /* Q15, 0..1 */
+    a = (uint16_t)((8192*z+2847*((z*(32768-z))/32768))/32768);
+  } else {
+    z = (ax*32768)/ay;
+    a = (uint16_t)(0x4000-(8192*z+2847*((z*(32768-z))/32768))/32768);
+  }
+  if (x<0) {
+    a = (uint16_t)(0x8000-a);
+  }
+  if (y<0) {
+    a = (uint16_t)(-a);
+  }
+  return a;
+}
+
+static uint16_t OBST_Sqrt(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)res;
+}
+
+static int16_t OBST_Dist(int32_t x, int32_t y) {
+  return (int16_t)OBST_Sqrt((uint32_t)(x*x+y*y));
+}
+
+static int OBST_Sector(int32_t x, int32_t y) {
+  return (int)(((uint32_t)(uint16_t)(OBST_Atan2(y, x)+OBST_SECTOR_ANGLE/2)*OBST_CONFIG_NOF_SECTORS)>>16);
+}
+
+/* puts a point into its sector: the nearest point of a sector is kept, a point near the one in the sector replaces it */
+static void OBST_Put(OBST_Cell *map, int16_t x, int16_t y, uint16_t ttlMs, bool refresh) {
+  OBST_Cell *c = &map[OBST_Sector(x, y)];
+
+  if (c->ttlMs==0) {
+    c->x = x;
+    c->y = y;
+    c->ttlMs = ttlMs;
+  } else if (OBST_Dist(x, y)<OBST_Dist(c->x, c->y) || OBST_Dist(x-c->x, y-c->y)<=OBST_SAME_POINT_MM) {
+    c->x = x;
+    c->y = y;
+    if (refresh) { /* seen again: stays longer */
+      c->ttlMs = (uint16_t)(c->ttlMs+ttlMs>OBST_CONFIG_PERSISTENCE_MS ? OBST_CONFIG_PERSISTENCE_MS : c->ttlMs+ttlMs);
+    } else if (ttlMs>c->ttlMs) {
+      c->ttlMs = ttlMs;
+    }
+  }
+}
+
+/* copies the map in a critical section, returns the clear counter of the copy */
+static uint8_t OBST_GetMap(OBST_Cell *map) {
+  uint8_t cntr;
+  int i;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    map[i] = OBST_Map[i];
+  }
+  cntr = OBST_ClearCntr;
+  CS1_ExitCritical();
+  return cntr;
+}
+
+/* moves the points with the odometry and ages them */
+static void OBST_Move(OBST_Cell *map, int32_t dsMm, uint16_t dTheta, uint16_t dtMs) {
+  static OBST_Cell moved[OBST_CONFIG_NOF_SECTORS];
+  int32_t dx, dy, c, s, px, py;
+  int i;
+
+  dx = (dsMm*OBST_Cos((uint16_t)((int16_t)dTheta/2)))/32768; /* translation along the mean heading */
+  dy = (dsMm*OBST_Sin((uint16_t)((int16_t)dTheta/2)))/32768;
+  c = OBST_Cos(dTheta);
+  s = OBST_Sin(dTheta);
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    moved[i].ttlMs = 0;
+  }
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    if (map[i].ttlMs<=dtMs) {
+      continue; /* expired */
+    }
+    px = map[i].x-dx;
+    py = map[i].y-dy;
+    if (px<-INT16_MAX/2 || px>INT16_MAX/2 || py<-INT16_MAX/2 || py>INT16_MAX/2) {
+      continue; /* far away, should not happen with the range of the sensors */
+    }
+    OBST_Put(moved, (int16_t)((px*c+py*s)/32768), (int16_t)((py*c-px*s)/32768), (uint16_t)(map[i].ttlMs-dtMs), FALSE);
+  }
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    map[i] = moved[i];
+  }
+}
+
+/* removes the points a sensor would have seen closer than the limit */
+static void OBST_ClearBeam(OBST_Cell *map, const DIST_SensorMount *mount, int16_t limitMm) {
+  uint16_t heading = OBST_ANGLE_FROM_DEG(mount->headingDeg);
+  int32_t vx, vy;
+  int i;
+
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    if (map[i].ttlMs==0) {
+      continue;
+    }
+    vx = map[i].x-mount->xMm;
+    vy = map[i].y-mount->yMm;
+    if ((uint16_t)(OBST_Atan2(vy, vx)-heading+OBST_FOV_HALF_ANGLE)<=2*OBST_FOV_HALF_ANGLE && OBST_Dist(vx, vy)<limitMm) {
+      map[i].ttlMs = 0;
+    }
+  }
+}
+
+/* adds the last measurement of a sensor */
+static void OBST_AddRange(OBST_Cell *map, DIST_Sensor sensor) {
+  DIST_SensorMount mount;
+  VL6180X_Range range;
+  uint16_t heading;
+
+  if (DIST_GetSensorMount(sensor, &mount)!=ERR_OK || DIST_GetRange(sensor, &range)!=ERR_OK) {
+    return; /* not fitted or not ready */
+  }
+  switch(range.status) {
+    case VL6180X_RANGE_STATUS_OK:
+      OBST_ClearBeam(map, &mount, (int16_t)(range.mm-OBST_TOLERANCE_MM));
+      heading = OBST_ANGLE_FROM_DEG(mount.headingDeg);
+      OBST_Put(map,
+          (int16_t)(mount.xMm+(range.mm*OBST_Cos(heading))/32768),
+          (int16_t)(mount.yMm+(range.mm*OBST_Sin(heading))/32768),
+          OBST_CONFIG_PERSISTENCE_MS/2, TRUE);
+      break;
+    case VL6180X_RANGE_STATUS_EARLY_CONVERGENCE:
+    case VL6180X_RANGE_STATUS_MAX_CONVERGENCE:
+    case VL6180X_RANGE_STATUS_NO_TARGET_IGNORE:
+    case VL6180X_RANGE_STATUS_OVERFLOW:
+    case VL6180X_RANGE_STATUS_RAW_OVERFLOW:
+      OBST_ClearBeam(map, &mount, OBST_CLEAR_MM); /* no target */
+      break;
+    default:
+      break; /* no information */
+  }
+}
+
+void OBST_Update(void) {
+  TickType_t now = xTaskGetTickCount();
+  int32_t left = Q4CLeft_GetPos(), right = Q4CRight_GetPos();
+  int32_t dl, dr, dsMm;
+  uint16_t dtMs, dTheta;
+  uint8_t cntr;
+  int sensor, i;
+  CS1_CriticalVariable()
+
+  if (!OBST_HaveLast) {
+    OBST_LastLeft = left;
+    OBST_LastRight = right;
+    OBST_LastTick = now;
+    OBST_HaveLast = TRUE;
+  }
+  dl = left-OBST_LastLeft;
+  dr = right-OBST_LastRight;
+  dtMs = (uint16_t)((now-OBST_LastTick)*portTICK_PERIOD_MS);
+  OBST_LastLeft = left;
+  OBST_LastRight = right;
+  OBST_LastTick = now;
+  dsMm = ((dl+dr)*500+(dl+dr>=0 ? OBST_COUNTS_PER_M/2 : -OBST_COUNTS_PER_M/2))/OBST_COUNTS_PER_M; /* rounded */
+  dTheta = (uint16_t)(((dr-dl)*10430)/OBST_CONFIG_TRACK_COUNTS); /* 65536/(2*pi) binary angle per radian */
+  if (dtMs>0) {
+    OBST_SpeedMmS = (int16_t)((dsMm*1000)/dtMs);
+  }
+  cntr = OBST_GetMap(OBST_Work);
+  OBST_Move(OBST_Work, dsMm, dTheta, dtMs);
+  for(sensor=DIST_SENSOR_FRONT;sensor<=DIST_SENSOR_RIGHT;sensor++) {
+    OBST_AddRange(OBST_Work, (DIST_Sensor)sensor);
+  }
+  CS1_EnterCritical();
+  if (cntr==OBST_ClearCntr) { /* not cleared in the meantime */
+    for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+      OBST_Map[i] = OBST_Work[i];
+    }
+  }
+  CS1_ExitCritical();
+}
+
+void OBST_Clear(void) {
+  int i;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    OBST_Map[i].ttlMs = 0;
+  }
+  OBST_ClearCntr++;
+  CS1_ExitCritical();
+}
+
+int16_t OBST_GetNearest(int16_t fromDeg, int16_t toDeg) {
+  uint16_t from = OBST_ANGLE_FROM_DEG(fromDeg), width = (uint16_t)(OBST_ANGLE_FROM_DEG(toDeg)-from);
+  int16_t dist, nearest = OBST_NO_OBSTACLE;
+  OBST_Cell map[OBST_CONFIG_NOF_SECTORS];
+  int i;
+
+  (void)OBST_GetMap(map);
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    if (map[i].ttlMs!=0 && (uint16_t)(OBST_Atan2(map[i].y, map[i].x)-from)<=width) {
+      dist = OBST_Dist(map[i].x, map[i].y);
+      if (nearest==OBST_NO_OBSTACLE || dist<nearest) {
+        nearest = dist;
+      }
+    }
+  }
+  return nearest;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void OBST_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"obst", (unsigned char*)"Group of obstacle map commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Removes all obstacles from the map\r\n", io->stdOut);
+}
+
+static void OBST_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48], name[16];
+  OBST_Cell map[OBST_CONFIG_NOF_SECTORS], cell;
+  int i;
+
+  CLS1_SendStatusStr((unsigned char*)"obst", (unsigned char*)"\r\n", io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16s(buf, sizeof(buf), OBST_SpeedMmS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm/s\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  speed", buf, io->stdOut);
+  (void)OBST_GetMap(map);
+  for(i=0;i<OBST_CONFIG_NOF_SECTORS;i++) {
+    cell = map[i];
+    if (cell.ttlMs==0) {
+      continue;
+    }
+    UTIL1_strcpy(name, sizeof(name), (unsigned char*)"  ");
+    UTIL1_strcatNum16s(name, sizeof(name), OBST_ANGLE_TO_DEG(i*OBST_SECTOR_ANGLE));
+    UTIL1_strcat(name, sizeof(name), (unsigned char*)" deg");
+    buf[0] = '\0';
+    UTIL1_strcatNum16s(buf, sizeof(buf), OBST_Dist(cell.x, cell.y));
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm (x ");
+    UTIL1_strcatNum16s(buf, sizeof(buf), cell.x);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", y ");
+    UTIL1_strcatNum16s(buf, sizeof(buf), cell.y);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"), ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), cell.ttlMs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+    CLS1_SendStatusStr(name, buf, io->stdOut);
+  }
+}
+
+uint8_t OBST_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"obst help")==0) {
+    OBST_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"obst status")==0) {
+    OBST_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"obst clear")==0) {
+    OBST_Clear();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void OBST_Deinit(void) {
+  /* nothing needed */
+}
+
+void OBST_Init(void) {
+  OBST_Clear();
+  OBST_HaveLast = FALSE;
+  OBST_SpeedMmS = 0;
+}
+
+#endif /* PL_CONFIG_HAS_OBSTACLE_MAP */
@@ -0,0 +1,72 @@
+/**
+ * \file
+ * \brief Interface of the obstacle map around the robot.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The obstacle map keeps the targets seen by the ToF sensors in a polar map around the robot:
+ * each sector holds the nearest obstacle point in robot coordinates (mm, x forward, y left).
+ * Between the ToF frames the points are moved with the quadrature encoder odometry, so they stay
+ * in place while the robot moves or turns, and they disappear after OBST_CONFIG_PERSISTENCE_MS
+ * if they are not seen again.
+ */
+
+#ifndef OBSTACLE_H_
+#define OBSTACLE_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+
+#ifndef OBST_CONFIG_NOF_SECTORS
+  #define OBST_CONFIG_NOF_SECTORS      (32)   /*!< number of sectors of the map, 11.25 degree each */
+#endif
+#ifndef OBST_CONFIG_PERSISTENCE_MS
+  #define OBST_CONFIG_PERSISTENCE_MS   (1000) /*!< time an obstacle seen repeatedly stays in the map, a single sighting stays half of it */
+#endif
+#ifndef OBST_CONFIG_COUNTS_PER_M
+  #define OBST_CONFIG_COUNTS_PER_M     (7350) /*!< quadrature counts per meter of track, if there is no hardware profile */
+#endif
+#ifndef OBST_CONFIG_TRACK_COUNTS
+  #define OBST_CONFIG_TRACK_COUNTS     (875)  /*!< effective distance between the tracks in quadrature counts, including the skid of a turn (see TURN_STEPS_90) */
+#endif
+
+#define OBST_NO_OBSTACLE    (-1)  /*!< no obstacle in the sector */
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t OBST_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Moves the map with the odometry since the last call and adds the last ToF measurements.
+ * Called by the ToF task after each set of measurements.
+ */
+void OBST_Update(void);
+
+/*! \brief Removes all obstacles from the map */
+void OBST_Clear(void);
+
+/*!
+ * \brief Returns the nearest obstacle in a sector around the robot.
+ * \param fromDeg Start of the sector in degree, 0 is forward, positive to the left.
+ * \param toDeg End of the sector in degree, counter clockwise from fromDeg.
+ * \return Distance from the robot center in mm, OBST_NO_OBSTACLE if there is none.
+ */
+int16_t OBST_GetNearest(int16_t fromDeg, int16_t toDeg);
+
+/*! \brief Driver de-initialization */
+void OBST_Deinit(void);
+
+/*! \brief Driver initialization */
+void OBST_Init(void);
+
+#endif /* PL_CONFIG_HAS_OBSTACLE_MAP */
+
+#endif /* OBSTACLE_H_ */
@@ -9,23 +9,29 @@
 #include "Pid.h"
 #include "Motor.h"
 #include "UTIL1.h"
-#include "KIN1.h" // data type for RoboIDs
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
 #endif
 #include "Reflectance.h"
-
-/* RobotID's of L1 and L6 */
-static const KIN1_UID RoboIDs[] = {
-  /* 6: L6, V1 */  {{0x00,0x17,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x06}},
-  /* 1: L1, V1 */  {{0x00,0x19,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x25}},
-};
+#if PL_CONFIG_HAS_SPEED_PLAN
+  #include "SpeedPlan.h"
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+#endif
 
 /*! \todo Add your own additional configurations as needed */
 static PID_Config lineFwConfig;
 static PID_Config speedLeftConfig, speedRightConfig;
 static PID_Config posLeftConfig, posRightConfig;
 
+/* position PID gains as tuned on the robots, the hardware profile tells which one this robot uses */
+static const PID_Config PID_PosGains[PID_NOF_POS_GAINS] = {
+  /* p,  i,  d, windup, max speed % */
+  {400,  2, 50, 150, 70}, /* 0: default, tuned on L6 */
+  {350,  5, 20,  50, 70}, /* 1: tuned on L1 */
+};
+
 uint8_t PID_GetPIDConfig(PID_ConfigType config, PID_Config **confP) {
   switch(config) {
     case PID_CONFIG_LINE_FW:
@@ -121,16 +127,26 @@ static uint8_t errorWithinPercent(int32_t error) {
 }
 
 static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config) {
-  int32_t pid, speed, speedL, speedR;
+  int32_t pid, speed, speedL, speedR, maxSpeed;
   uint8_t errorPercent;
   MOT_Direction directionL=MOT_DIR_FORWARD, directionR=MOT_DIR_FORWARD;
 
   pid = PID(currLine, setLine, config);
   errorPercent = errorWithinPercent(currLine-setLine);
+#if PL_CONFIG_HAS_SPEED_PLAN
+  if (SPLAN_IsOn()) {
+    maxSpeed = SPLAN_Step(currLine-setLine); /* planned for the curvature of the track */
+    pid += SPLAN_GetSteer(); /* feedforward for the curvature of the learned track */
+  } else {
+    maxSpeed = ((int32_t)config->maxSpeedPercent)*(0xffff/100);
+  }
+#else
+  maxSpeed = ((int32_t)config->maxSpeedPercent)*(0xffff/100);
+#endif
 
   /* transform into different speed for motors. The PID is used as difference value to the motor PWM */
   if (errorPercent <= 20) { /* pretty on center: move forward both motors with base speed */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100); /* 100% */
+    speed = maxSpeed; /* 100% */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = speed;
@@ -141,7 +157,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     }
   } else if (errorPercent <= 40) {
     /* outside left/right halve position from center, slow down one motor and speed up the other */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*8/10; /* 80% */
+    speed = maxSpeed*8/10; /* 80% */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = speed+pid; /* decrease speed */
@@ -151,7 +167,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
       speedL = speed-pid; /* decrease speed */
     }
   } else if (errorPercent <= 70) {
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*6/10; /* %60 */
+    speed = maxSpeed*6/10; /* %60 */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = 0 /*maxSpeed+pid*/; /* decrease speed */
@@ -162,7 +178,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     }
   } else  {
     /* line is far to the left or right: use backward motor motion */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*10/10; /* %80 */
+    speed = maxSpeed*10/10; /* %80 */
     if (pid<0) { /* turn right */
       speedR = -speed+pid; /* decrease speed */
       speedL = speed-pid; /* increase speed */
@@ -420,20 +436,9 @@ void PID_Deinit(void) {
   /* nothing needed */
 }
 
-/* Number of TURN_STEPS_90 for L1 or L6 */
-static void PID_AdoptToHardware(void) {
-  KIN1_UID id;
-  uint8_t res;
-
-  res = KIN1_UIDGet(&id);
-  if (res!=ERR_OK) {
-    for(;;); /* error */
-  }
+void PID_Init(void) {
+  const PID_Config *posGains = &PID_PosGains[0];
 
-	#if PL_CONFIG_HAS_PID
-  /* Robot L6 */
-  if (KIN1_UIDSame(&id, &RoboIDs[0]))
-  {
 	/*! \todo determine your PID values */
 	#if 0
 	  speedLeftConfig.pFactor100 = 0;
@@ -499,133 +504,21 @@ static void PID_AdoptToHardware(void) {
 	  posRightConfig.maxSpeedPercent = 50;
 	  */
 
-	  // Eigene Werte
-	  posLeftConfig.pFactor100 = 400;
-	  posLeftConfig.iFactor100 = 2;
-	  posLeftConfig.dFactor100 = 50;
-	  posLeftConfig.iAntiWindup = 150;
-	  posLeftConfig.maxSpeedPercent = 70;
-	  posRightConfig.pFactor100 = 400;
-	  posRightConfig.iFactor100 = 2;
-	  posRightConfig.dFactor100 = 50;
-	  posRightConfig.iAntiWindup = 150;
-	  posRightConfig.maxSpeedPercent = 70;
-
-	#endif
-	  posLeftConfig.lastError = 0;
-	  posLeftConfig.integral = 0;
-	  posRightConfig.lastError = posLeftConfig.lastError;
-	  posRightConfig.integral = posLeftConfig.integral;
-  }
-
-
-	/* Robot L1 */
-	else if (KIN1_UIDSame(&id, &RoboIDs[1]))
-	{
-	/*! \todo determine your PID values */
-	#if 0
-	  speedLeftConfig.pFactor100 = 0;
-	  speedLeftConfig.iFactor100 = 0;
-	  speedLeftConfig.dFactor100 = 0;
-	  speedLeftConfig.iAntiWindup = 0;
-	  speedLeftConfig.lastError = 0;
-	  speedLeftConfig.integral = 0;
-
-	  speedRightConfig.pFactor100 = 0;
-	  speedRightConfig.iFactor100 = 0;
-	  speedRightConfig.dFactor100 = 0;
-	  speedRightConfig.iAntiWindup = 0;
-	  speedRightConfig.lastError = 0;
-	  speedRightConfig.integral = 0;
-	#else
-	  //eigene Werte
-	  speedLeftConfig.pFactor100 = 2100;
-	  speedLeftConfig.iFactor100 = 60;
-	  speedLeftConfig.dFactor100 = 0;
-	  speedLeftConfig.iAntiWindup = 35000;
-	  speedLeftConfig.lastError = 0;
-	  speedLeftConfig.integral = 0;
-
-	  speedRightConfig.pFactor100 = 2100;
-	  speedRightConfig.iFactor100 = 60;
-	  speedRightConfig.dFactor100 = 0;
-	  speedRightConfig.iAntiWindup = 35000;
-	  speedRightConfig.lastError = 0;
-	  speedRightConfig.integral = 0;
-	#endif
-	  lineFwConfig.pFactor100 = 0;
-	  lineFwConfig.iFactor100 = 0;
-	  lineFwConfig.dFactor100 = 0;
-	  lineFwConfig.iAntiWindup = 0;
-	  lineFwConfig.maxSpeedPercent = 0;
-	  lineFwConfig.lastError = 0;
-	  lineFwConfig.integral = 0;
-
-	#if 0
-	  posLeftConfig.pFactor100 = 0;
-	  posLeftConfig.iFactor100 = 0;
-	  posLeftConfig.dFactor100 = 0;
-	  posLeftConfig.iAntiWindup = 0;
-	  posLeftConfig.maxSpeedPercent = 0;
-	  posRightConfig.pFactor100 = 0;
-	  posRightConfig.iFactor100 = 0;
-	  posRightConfig.dFactor100 = 0;
-	  posRightConfig.iAntiWindup = 0;
-	  posRightConfig.maxSpeedPercent = 0;
-	#else
-	  // Werte von Herr Styger fr Position PID
-	  /*
-	  posLeftConfig.pFactor100 = 1000;
-	  posLeftConfig.iFactor100 = 2;
-	  posLeftConfig.dFactor100 = 50;
-	  posLeftConfig.iAntiWindup = 200;
-	  posLeftConfig.maxSpeedPercent = 50;
-	  posRightConfig.pFactor100 = 1000;
-	  posRightConfig.iFactor100 = 2;
-	  posRightConfig.dFactor100 = 50;
-	  posRightConfig.iAntiWindup = 200;
-	  posRightConfig.maxSpeedPercent = 50;
-	  */
+	  // Eigene Werte, je nach Roboter (hwp pid <n>)
+#if PL_CONFIG_HAS_HW_PROFILE
+	  if (HWP_Get()->posPidSet<PID_NOF_POS_GAINS) {
+	    posGains = &PID_PosGains[HWP_Get()->posPidSet];
+	  }
+#endif
+	  posLeftConfig = *posGains;
+	  posRightConfig = *posGains;
 
-	  // Eigene Werte
-	  /*posLeftConfig.pFactor100 = 400;
-	  posLeftConfig.iFactor100 = 2;
-	  posLeftConfig.dFactor100 = 50;
-	  posLeftConfig.iAntiWindup = 150;
-	  posLeftConfig.maxSpeedPercent = 40;
-	  posRightConfig.pFactor100 = 400;
-	  posRightConfig.iFactor100 = 2;
-	  posRightConfig.dFactor100 = 50;
-	  posRightConfig.iAntiWindup = 150;
-	  posRightConfig.maxSpeedPercent = 40;*/
-
-	  //Test fuer optimierte Werte
-	  posLeftConfig.pFactor100 = 350;
-	  posLeftConfig.iFactor100 = 5;
-	  posLeftConfig.dFactor100 = 20;
-	  posLeftConfig.iAntiWindup = 50;
-	  posLeftConfig.maxSpeedPercent = 70;
-	  //posLeftConfig.maxSpeedPercent = 20;
-	  posRightConfig.pFactor100 = 350;
-	  posRightConfig.iFactor100 = 5;
-	  posRightConfig.dFactor100 = 20;
-	  posRightConfig.iAntiWindup = 50;
-	  posRightConfig.maxSpeedPercent = 70;
-	  //posRightConfig.maxSpeedPercent = 20;
 	#endif
 	  posLeftConfig.lastError = 0;
 	  posLeftConfig.integral = 0;
 	  posRightConfig.lastError = posLeftConfig.lastError;
 	  posRightConfig.integral = posLeftConfig.integral;
 
-	}
-#endif
-}
-
-void PID_Init(void) {
-	// pid values based on L1 oder L6
-	PID_AdoptToHardware();
-
   /*! \todo determine your PID values */
 	/*
 #if 0
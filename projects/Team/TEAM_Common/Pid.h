@@ -19,6 +19,8 @@ typedef enum {
   PID_CONFIG_SPEED_RIGHT
 } PID_ConfigType;
 
+#define PID_NOF_POS_GAINS  (2) /*!< sets of position PID gains, one per tuned robot, selected with HWP_Profile.posPidSet */
+
 typedef struct {
   int32_t pFactor100;
   int32_t iFactor100;
@@ -30,6 +30,18 @@
 #if PL_CONFIG_HAS_RTOS
   #include "RTOS.h"
 #endif
+#if PL_CONFIG_HAS_LOW_POWER
+  #include "LowPower.h"
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
+#if PL_CONFIG_HAS_MEM_POOL
+  #include "MemPool.h"
+#endif
 #if PL_CONFIG_HAS_SHELL
   #include "Shell.h"
 #endif
@@ -45,6 +57,9 @@
 #if PL_CONFIG_HAS_MOTOR
   #include "Motor.h"
 #endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+#endif
 #if PL_CONFIG_HAS_MOTOR_TACHO
   #include "Tacho.h"
 #endif
@@ -60,6 +75,15 @@
 #if PL_CONFIG_HAS_RADIO
   #include "RNet_App.h"
 #endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  #include "RadioLink.h"
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  #include "TimeSync.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
 #if PL_CONFIG_HAS_REMOTE
   #include "Remote.h"
 #endif
@@ -72,6 +96,21 @@
 #if PL_CONFIG_HAS_LINE_MAZE
   #include "Maze.h"
 #endif
+#if PL_CONFIG_HAS_RECORDER
+  #include "Recorder.h"
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  #include "SpeedPlan.h"
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  #include "Obstacle.h"
+#endif
 #if PL_CONFIG_HAS_LCD
   #include "LCD.h"
 #endif
@@ -89,6 +128,9 @@
 #if PL_CONFIG_HAS_SUMO /*! \todo */
   #include "Sumo.h"
 #endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  #include "ArenaLoc.h"
+#endif
 
 void PL_Init(void) {
 #if PL_CONFIG_HAS_LEDS
@@ -115,6 +157,18 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_RTOS
   RTOS_Init();
 #endif
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_Init();
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Init();
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_Init();
+#endif
+#if PL_CONFIG_HAS_MEM_POOL
+  MPOOL_Init();
+#endif
 #if PL_CONFIG_HAS_SHELL
   SHELL_Init();
 #endif
@@ -130,6 +184,9 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_MOTOR
   MOT_Init();
 #endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  HWP_Init(); /* after MOT_Init(): sets the motor and encoder wiring */
+#endif
 #if PL_CONFIG_HAS_MOTOR_TACHO
   TACHO_Init();
 #endif
@@ -142,9 +199,27 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_Init();
 #endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  SPLAN_Init();
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  TMAP_Init(); /* after the planner, which plans the profile of a stored map */
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  CTRL_Init(); /* after the modules of its phases */
+#endif
 #if PL_CONFIG_HAS_RADIO
   RNETA_Init();
 #endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  RLINK_Init();
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  TSYNC_Init();
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  LAPT_Init(); /* after the radio and the clock synchronisation */
+#endif
 #if PL_CONFIG_HAS_REMOTE
   REMOTE_Init();
 #endif
@@ -157,6 +232,9 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_LINE_MAZE
   MAZE_Init();
 #endif
+#if PL_CONFIG_HAS_RECORDER
+  REC_Init();
+#endif
 #if PL_CONFIG_HAS_LCD
   LCD_Init();
 #endif
@@ -170,18 +248,30 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_SUMO
   SUMO_Init();
 #endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  ALOC_Init();
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  OBST_Init();
+#endif
 #if PL_HAS_DISTANCE_SENSOR
   DIST_Init();
 #endif
 }
 
 void PL_Deinit(void) {
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  OBST_Deinit();
+#endif
 #if PL_CONFIG_HAS_BATTERY_ADC
   BATT_Deinit();
 #endif
 #if PL_CONFIG_HAS_LCD
   LCD_Deinit();
 #endif
+#if PL_CONFIG_HAS_RECORDER
+  REC_Deinit();
+#endif
 #if PL_CONFIG_HAS_LINE_MAZE
   MAZE_Deinit();
 #endif
@@ -194,9 +284,27 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_REMOTE
   REMOTE_Deinit();
 #endif
+#if PL_CONFIG_HAS_LAP_TIME
+  LAPT_Deinit();
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  TSYNC_Deinit();
+#endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  RLINK_Deinit();
+#endif
 #if PL_CONFIG_HAS_RADIO
   RNETA_Deinit();
 #endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  CTRL_Deinit();
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  TMAP_Deinit();
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  SPLAN_Deinit();
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_Deinit();
 #endif
@@ -209,6 +317,9 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_MOTOR_TACHO
   TACHO_Deinit();
 #endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  HWP_Deinit();
+#endif
 #if PL_CONFIG_HAS_MOTOR
   MOT_Deinit();
 #endif
@@ -221,6 +332,18 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_SHELL_QUEUE
   SQUEUE_Deinit();
 #endif
+#if PL_CONFIG_HAS_MEM_POOL
+  MPOOL_Deinit();
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_Deinit();
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Deinit();
+#endif
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_Deinit();
+#endif
 #if PL_CONFIG_HAS_RTOS
   RTOS_Deinit();
 #endif
@@ -249,6 +372,9 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_SNAKE_GAME
 SNAKE_Deinit();
 #endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  ALOC_Deinit();
+#endif
 #if PL_CONFIG_HAS_SUMO
 SUMO_Deinit();
 #endif
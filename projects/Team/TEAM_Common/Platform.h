@@ -69,7 +69,14 @@
 #define PL_CONFIG_HAS_SEMAPHORE         (1 && !defined(PL_LOCAL_CONFIG_HAS_SEMAPHORE_DISABLED)) /* semaphore tests */
 #define PL_CONFIG_HAS_CONFIG_NVM        (1 && !defined(PL_LOCAL_CONFIG_HAS_CONFIG_NVM_DISABLED))
 #define PL_CONFIG_HAS_RADIO             (1 && !defined(PL_LOCAL_CONFIG_HAS_RADIO_DISABLED))
+#define PL_CONFIG_HAS_RADIO_LINK        (1 && !defined(PL_LOCAL_CONFIG_HAS_RADIO_LINK_DISABLED) && PL_CONFIG_HAS_RADIO) /* radio link quality monitor */
+#define PL_CONFIG_HAS_TIME_SYNC         (1 && !defined(PL_LOCAL_CONFIG_HAS_TIME_SYNC_DISABLED) && (PL_CONFIG_HAS_RADIO || defined(TSYNC_CONFIG_HOST))) /* clock synchronisation over the radio, or only its estimator on the host */
 #define PL_CONFIG_HAS_USB_CDC           (1 && !defined(PL_LOCAL_CONFIG_HAS_USB_CDC_DISABLED))
+#define PL_CONFIG_HAS_LOW_POWER         (1 && !defined(PL_LOCAL_CONFIG_HAS_LOW_POWER_DISABLED) && PL_CONFIG_HAS_RTOS) /* low power mode in RTOS idle task */
+#define PL_CONFIG_HAS_PROFILER          (1 && !defined(PL_LOCAL_CONFIG_HAS_PROFILER_DISABLED) && PL_CONFIG_HAS_RTOS) /* task profiler */
+#define PL_CONFIG_HAS_RTOS_TRACE        (1 && !defined(PL_LOCAL_CONFIG_HAS_RTOS_TRACE_DISABLED) && PL_CONFIG_HAS_RTOS) /* streaming trace of tasks, interrupts and control loops */
+#define PL_CONFIG_HAS_MEM_POOL          (1 && !defined(PL_LOCAL_CONFIG_HAS_MEM_POOL_DISABLED)) /* fixed block memory pools for messages */
+#define PL_CONFIG_HAS_LAP_TIME          (1 && !defined(PL_LOCAL_CONFIG_HAS_LAP_TIME_DISABLED)) /* lap and segment timing */
 
 /* remote controller specific features */
 #define PL_CONFIG_HAS_LCD               (1 && !defined(PL_LOCAL_CONFIG_HAS_LCD_DISABLED))
@@ -83,6 +90,7 @@
 #define PL_CONFIG_HAS_BLUETOOTH         (1 && !defined(PL_LOCAL_CONFIG_HAS_BLUETOOTH_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_MOTOR             (1 && !defined(PL_LOCAL_CONFIG_HAS_MOTOR_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_QUADRATURE        (1 && !defined(PL_LOCAL_CONFIG_HAS_QUADRATURE_DISABLED) && PL_CONFIG_HAS_MOTOR)
+#define PL_CONFIG_HAS_HW_PROFILE        (1 && !defined(PL_LOCAL_CONFIG_HAS_HW_PROFILE_DISABLED) && PL_CONFIG_HAS_QUADRATURE) /* motor and encoder wiring from a self-test */
 #define PL_CONFIG_HAS_MOTOR_TACHO       (1 && !defined(PL_LOCAL_CONFIG_HAS_MOTOR_TACHO_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
 #define PL_CONFIG_HAS_MCP4728           (1 && !defined(PL_LOCAL_CONFIG_HAS_MPC4728_DISABLED) && PL_CONFIG_BOARD_IS_ROBO && PL_CONFIG_BOARD_IS_ROBO_V1) /* only for V1 robot */
 #define PL_CONFIG_HAS_QUAD_CALIBRATION  (1 && !defined(PL_LOCAL_CONFIG_HAS_QUAD_CALIBRATION_DISABLED) && PL_CONFIG_HAS_MCP4728)
@@ -90,11 +98,16 @@
 #define PL_CONFIG_HAS_DRIVE             (1 && !defined(PL_LOCAL_CONFIG_HAS_DRIVE_DISABLED) && PL_CONFIG_HAS_PID)
 #define PL_CONFIG_HAS_REFLECTANCE       (1 && !defined(PL_LOCAL_CONFIG_HAS_REFLECTANCE_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_LINE_FOLLOW       (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_FOLLOW_DISABLED) && PL_CONFIG_HAS_DRIVE)
+#define PL_CONFIG_HAS_SPEED_PLAN        (1 && !defined(PL_LOCAL_CONFIG_HAS_SPEED_PLAN_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW) /* line following speed from the curvature of the track */
+#define PL_CONFIG_HAS_TRACK_MAP         (1 && !defined(PL_LOCAL_CONFIG_HAS_TRACK_MAP_DISABLED) && PL_CONFIG_HAS_SPEED_PLAN) /* learned track map with speed profile and lap times */
+#define PL_CONFIG_HAS_CONTROL_LOOP      (1 && !defined(PL_LOCAL_CONFIG_HAS_CONTROL_LOOP_DISABLED) && PL_CONFIG_HAS_DRIVE && PL_CONFIG_HAS_REFLECTANCE && PL_CONFIG_HAS_TIMER) /* timer paced control task instead of the reflectance, drive and line loops */
 #define PL_CONFIG_HAS_TURN              (1 && !defined(PL_LOCAL_CONFIG_HAS_TURN_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
 #define PL_CONFIG_HAS_LINE_MAZE         (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_MAZE_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW)
+#define PL_CONFIG_HAS_RECORDER          (1 && !defined(PL_LOCAL_CONFIG_HAS_RECORDER_DISABLED) && PL_CONFIG_HAS_REFLECTANCE && PL_CONFIG_HAS_QUADRATURE) /* sensor frame recorder for the replay */
 //added for ToF sensors
 #define PL_HAS_DISTANCE_SENSOR          (1 && !defined(PL_LOCAL_CONFIG_HAS_DISTANCE_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_HAS_TOF_SENSOR               (1 && !defined(PL_LOCAL_CONFIG_HAS_TOF_SENSOR_DISABLED) && PL_HAS_DISTANCE_SENSOR)
+#define PL_CONFIG_HAS_OBSTACLE_MAP      (1 && !defined(PL_LOCAL_CONFIG_HAS_OBSTACLE_MAP_DISABLED) && PL_HAS_TOF_SENSOR && PL_CONFIG_HAS_QUADRATURE) /* ToF obstacles moved with the odometry */
 #define PL_HAS_SIDE_DISTANCE            (0)
 #define PL_HAS_FRONT_DISTANCE           (0)
 
@@ -104,6 +117,7 @@
 #define PL_CONFIG_HAS_SNAKE_GAME        (1 && !defined(PL_LOCAL_CONFIG_HAS_SNAKE_GAME_DISABLED) && PL_CONFIG_HAS_LCD)
 
 #define PL_CONFIG_HAS_SUMO     			(1 && !defined(PL_LOCAL_PL_CONFIG_HAS_SUMO_DISABLED) && PL_LOCAL_CONFIG_BOARD_IS_ROBO)
+#define PL_CONFIG_HAS_ARENA_LOC         (1 && !defined(PL_LOCAL_CONFIG_HAS_ARENA_LOC_DISABLED) && PL_CONFIG_HAS_SUMO && PL_CONFIG_HAS_REFLECTANCE && PL_CONFIG_HAS_QUADRATURE) /* pose on the sumo arena from odometry, edges and ToF */
 /*!
  * \brief Driver de-initialization
  */
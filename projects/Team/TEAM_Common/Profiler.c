@@ -0,0 +1,298 @@
+/**
+ * \file
+ * \brief Task profiler implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module profiles the RTOS tasks. The runtime share and the stack high-water mark of all tasks
+ * come from the RTOS. Task loops instrumented with PROF_LoopBegin()/PROF_LoopEnd() are measured with
+ * the cycle counter: number of iterations, average and worst case execution time, CPU load and
+ * the wake-up jitter against the intended period of the task.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_PROFILER
+#include "Profiler.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#ifndef PROF_CONFIG_HOST
+  #define PROF_CONFIG_HOST   (0) /* 1: built for the host, using clock_gettime() instead of the DWT cycle counter */
+#endif
+
+#if PROF_CONFIG_HOST
+  #include <time.h>
+  #define PROF_CYCLES_PER_US   (1000) /* host 'cycles' are nanoseconds */
+#else
+  /* Cortex-M4 DWT cycle counter */
+  #define PROF_DEMCR           (*((volatile uint32_t*)0xE000EDFC)) /* debug exception and monitor control register */
+  #define PROF_DEMCR_TRCENA    (1UL<<24) /* enable DWT */
+  #define PROF_DWT_CTRL        (*((volatile uint32_t*)0xE0001000)) /* DWT control register */
+  #define PROF_DWT_CYCCNTENA   (1UL<<0)  /* enable cycle counter */
+  #define PROF_DWT_CYCCNT      (*((volatile uint32_t*)0xE0001004)) /* DWT cycle counter */
+  #define PROF_CYCLES_PER_US   (configCPU_CLOCK_HZ/1000000)
+#endif
+
+#define PROF_STACK_WARN_BYTES  (64) /* stack high-water marks below this are flagged */
+
+/*! \brief Profiling data of a task loop */
+typedef struct {
+  const char *name;        /*!< name of the loop */
+  PROF_PeriodKind kind;    /*!< how the loop is paced */
+  uint32_t periodCycles;   /*!< intended period in cycles */
+  uint32_t beginCycles;    /*!< cycle counter at the start of the current iteration */
+  uint32_t endCycles;      /*!< cycle counter at the end of the last iteration */
+  uint32_t expectedCycles; /*!< expected wake-up for PROF_PERIOD_DELAY_UNTIL */
+  uint32_t nofLoops;       /*!< number of completed iterations */
+  uint32_t wcetCycles;     /*!< worst case execution time of an iteration */
+  uint64_t busyCycles;     /*!< sum of all execution times */
+  uint32_t maxLateCycles;  /*!< maximum wake-up after the intended time */
+  uint32_t maxEarlyCycles; /*!< maximum wake-up before the intended time */
+} PROF_Loop;
+
+static PROF_Loop PROF_Loops[PROF_MAX_LOOPS];
+static uint8_t PROF_NofLoops = 0;
+static TickType_t PROF_ResetTick; /* tick count when the statistics have been reset */
+
+uint32_t PROF_GetCycles(void) {
+#if PROF_CONFIG_HOST
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec*1000000000ULL+(uint64_t)ts.tv_nsec);
+#else
+  return PROF_DWT_CYCCNT;
+#endif
+}
+
+PROF_Id PROF_Register(const char *name, PROF_PeriodKind kind, uint16_t periodMs) {
+  PROF_Id id;
+  PROF_Loop *p;
+
+  taskENTER_CRITICAL();
+  if (PROF_NofLoops>=PROF_MAX_LOOPS) {
+    taskEXIT_CRITICAL();
+    return PROF_ID_NONE;
+  }
+  id = PROF_NofLoops;
+  PROF_NofLoops++;
+  p = &PROF_Loops[id];
+  p->name = name;
+  p->kind = kind;
+  p->periodCycles = (uint32_t)periodMs*1000*PROF_CYCLES_PER_US;
+  p->beginCycles = p->endCycles = p->expectedCycles = 0;
+  p->nofLoops = 0;
+  p->wcetCycles = 0;
+  p->busyCycles = 0;
+  p->maxLateCycles = p->maxEarlyCycles = 0;
+  taskEXIT_CRITICAL();
+  return id;
+}
+
+void PROF_LoopBegin(PROF_Id id) {
+  uint32_t now, intended;
+  int32_t diff;
+  PROF_Loop *p;
+
+  if (id>=PROF_NofLoops) {
+    return;
+  }
+  now = PROF_GetCycles();
+  p = &PROF_Loops[id];
+  if (p->nofLoops>0 && p->kind!=PROF_PERIOD_NONE) {
+    if (p->kind==PROF_PERIOD_DELAY) {
+      intended = p->endCycles+p->periodCycles;
+    } else { /* fixed rate */
+      p->expectedCycles += p->periodCycles;
+      intended = p->expectedCycles;
+    }
+    diff = (int32_t)(now-intended);
+    if (diff>0 && (uint32_t)diff>p->maxLateCycles) {
+      p->maxLateCycles = (uint32_t)diff;
+    } else if (diff<0 && (uint32_t)(-diff)>p->maxEarlyCycles) {
+      p->maxEarlyCycles = (uint32_t)(-diff);
+    }
+  } else {
+    p->expectedCycles = now; /* first wake-up defines the phase */
+  }
+  p->beginCycles = now;
+}
+
+void PROF_LoopEnd(PROF_Id id) {
+  uint32_t now, exec;
+  PROF_Loop *p;
+
+  if (id>=PROF_NofLoops) {
+    return;
+  }
+  now = PROF_GetCycles();
+  p = &PROF_Loops[id];
+  exec = now-p->beginCycles;
+  if (exec>p->wcetCycles) {
+    p->wcetCycles = exec;
+  }
+  p->busyCycles += exec;
+  p->nofLoops++;
+  p->endCycles = now;
+}
+
+/*!
+ * \brief Resets the statistics of all loops, but keeps the registrations.
+ */
+static void PROF_Reset(void) {
+  uint8_t i;
+
+  taskENTER_CRITICAL();
+  for(i=0;i<PROF_NofLoops;i++) {
+    PROF_Loops[i].nofLoops = 0;
+    PROF_Loops[i].wcetCycles = 0;
+    PROF_Loops[i].busyCycles = 0;
+    PROF_Loops[i].maxLateCycles = 0;
+    PROF_Loops[i].maxEarlyCycles = 0;
+  }
+  PROF_ResetTick = xTaskGetTickCount();
+  taskEXIT_CRITICAL();
+}
+
+#if PL_CONFIG_HAS_SHELL
+/*!
+ * \brief Pads a string with spaces up to a column.
+ * \param buf Buffer with the string
+ * \param bufSize Size of the buffer
+ * \param col Column to pad to
+ */
+static void PROF_PadTo(unsigned char *buf, size_t bufSize, size_t col) {
+  while(UTIL1_strlen((char*)buf)<col && UTIL1_strlen((char*)buf)<bufSize-1) {
+    UTIL1_chcat(buf, bufSize, ' ');
+  }
+}
+
+static void PROF_PrintTasks(const CLS1_StdIOType *io) {
+  TaskStatus_t *tasks;
+  UBaseType_t nofTasks, i;
+  uint32_t totalRunTime;
+  unsigned char buf[64];
+
+  nofTasks = uxTaskGetNumberOfTasks();
+  tasks = pvPortMalloc(nofTasks*sizeof(TaskStatus_t));
+  if (tasks==NULL) {
+    CLS1_SendStr((unsigned char*)"*** failed to allocate task list\r\n", io->stdErr);
+    return;
+  }
+  nofTasks = uxTaskGetSystemState(tasks, nofTasks, &totalRunTime);
+  totalRunTime /= 100; /* for percentage */
+  CLS1_SendStr((unsigned char*)"  task        prio  stack free  runtime\r\n", io->stdOut);
+  for(i=0;i<nofTasks;i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"  ");
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)tasks[i].pcTaskName);
+    PROF_PadTo(buf, sizeof(buf), 14);
+    UTIL1_strcatNum32u(buf, sizeof(buf), tasks[i].uxCurrentPriority);
+    PROF_PadTo(buf, sizeof(buf), 20);
+    UTIL1_strcatNum32u(buf, sizeof(buf), tasks[i].usStackHighWaterMark*sizeof(StackType_t));
+    if (tasks[i].usStackHighWaterMark*sizeof(StackType_t)<PROF_STACK_WARN_BYTES) {
+      UTIL1_chcat(buf, sizeof(buf), '!');
+    }
+    PROF_PadTo(buf, sizeof(buf), 32);
+    if (totalRunTime>0) {
+      UTIL1_strcatNum32u(buf, sizeof(buf), tasks[i].ulRunTimeCounter/totalRunTime);
+      UTIL1_chcat(buf, sizeof(buf), '%');
+    } else {
+      UTIL1_chcat(buf, sizeof(buf), '-');
+    }
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  vPortFree(tasks);
+}
+
+static void PROF_PrintLoops(const CLS1_StdIOType *io) {
+  uint8_t i;
+  PROF_Loop *p;
+  unsigned char buf[80];
+  uint64_t elapsedCycles;
+
+  elapsedCycles = (uint64_t)(xTaskGetTickCount()-PROF_ResetTick)*portTICK_PERIOD_MS*1000*PROF_CYCLES_PER_US;
+  CLS1_SendStr((unsigned char*)"  loop        loops   avg us  wcet us  load  late us  early us\r\n", io->stdOut);
+  for(i=0;i<PROF_NofLoops;i++) {
+    p = &PROF_Loops[i];
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"  ");
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)p->name);
+    PROF_PadTo(buf, sizeof(buf), 14);
+    UTIL1_strcatNum32u(buf, sizeof(buf), p->nofLoops);
+    PROF_PadTo(buf, sizeof(buf), 22);
+    UTIL1_strcatNum32u(buf, sizeof(buf), p->nofLoops!=0?(uint32_t)(p->busyCycles/p->nofLoops/PROF_CYCLES_PER_US):0);
+    PROF_PadTo(buf, sizeof(buf), 30);
+    UTIL1_strcatNum32u(buf, sizeof(buf), p->wcetCycles/PROF_CYCLES_PER_US);
+    PROF_PadTo(buf, sizeof(buf), 39);
+    UTIL1_strcatNum32u(buf, sizeof(buf), elapsedCycles!=0?(uint32_t)((p->busyCycles*100)/elapsedCycles):0);
+    UTIL1_chcat(buf, sizeof(buf), '%');
+    PROF_PadTo(buf, sizeof(buf), 45);
+    if (p->kind!=PROF_PERIOD_NONE) {
+      UTIL1_strcatNum32u(buf, sizeof(buf), p->maxLateCycles/PROF_CYCLES_PER_US);
+      PROF_PadTo(buf, sizeof(buf), 54);
+      UTIL1_strcatNum32u(buf, sizeof(buf), p->maxEarlyCycles/PROF_CYCLES_PER_US);
+    } else {
+      UTIL1_chcat(buf, sizeof(buf), '-');
+      PROF_PadTo(buf, sizeof(buf), 54);
+      UTIL1_chcat(buf, sizeof(buf), '-');
+    }
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
+static void PROF_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  CLS1_SendStatusStr((unsigned char*)"prof", (unsigned char*)"\r\n", io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), PROF_CYCLES_PER_US);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" cycles/us\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  clock", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), (xTaskGetTickCount()-PROF_ResetTick)*portTICK_PERIOD_MS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  elapsed", buf, io->stdOut);
+  PROF_PrintTasks(io);
+  PROF_PrintLoops(io);
+}
+
+static void PROF_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"prof", (unsigned char*)"Group of task profiler commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows profiler help or task and loop statistics\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the loop statistics\r\n", io->stdOut);
+}
+
+uint8_t PROF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"prof help")==0) {
+    PROF_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"prof status")==0) {
+    /* not part of the global 'status', as the task list is long */
+    PROF_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"prof reset")==0) {
+    PROF_Reset();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void PROF_Deinit(void) {
+  /* nothing to do */
+}
+
+void PROF_Init(void) {
+#if !PROF_CONFIG_HOST
+  PROF_DEMCR |= PROF_DEMCR_TRCENA; /* enable DWT */
+  PROF_DWT_CYCCNT = 0;
+  PROF_DWT_CTRL |= PROF_DWT_CYCCNTENA; /* start cycle counter */
+#endif
+  PROF_NofLoops = 0;
+  PROF_ResetTick = 0;
+}
+
+#endif /* PL_CONFIG_HAS_PROFILER */
@@ -0,0 +1,77 @@
+/**
+ * \file
+ * \brief Task profiler interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module profiles the RTOS tasks: runtime share and stack high-water mark of all tasks,
+ * plus execution time and wake-up jitter of the instrumented task loops, measured with a cycle counter.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_PROFILER
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t PROF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+#define PROF_MAX_LOOPS   (12) /*!< maximum number of task loops which can be registered */
+#define PROF_ID_NONE     (0xff) /*!< invalid profiling id, returned if registration failed */
+
+/*! \brief How a task loop is paced */
+typedef enum {
+  PROF_PERIOD_NONE,        /*!< event driven or variable period, no jitter measurement */
+  PROF_PERIOD_DELAY,       /*!< vTaskDelay() at the end of the loop: period starts at the end of the loop */
+  PROF_PERIOD_DELAY_UNTIL  /*!< vTaskDelayUntil(): fixed rate, period starts with the previous wake-up */
+} PROF_PeriodKind;
+
+/*! \brief Handle of a profiled task loop */
+typedef uint8_t PROF_Id;
+
+/*!
+ * \brief Registers a task loop for profiling. Call it from the task before entering the loop.
+ * \param name Name of the loop, usually the task name. Must stay valid (string literal).
+ * \param kind How the loop gets paced.
+ * \param periodMs Intended period in milliseconds, ignored for PROF_PERIOD_NONE.
+ * \return Profiling id, or PROF_ID_NONE if there is no space left.
+ */
+PROF_Id PROF_Register(const char *name, PROF_PeriodKind kind, uint16_t periodMs);
+
+/*!
+ * \brief Marks the start of a loop iteration, right after the task has been woken up.
+ * \param id Profiling id returned by PROF_Register().
+ */
+void PROF_LoopBegin(PROF_Id id);
+
+/*!
+ * \brief Marks the end of a loop iteration, right before the task blocks.
+ * \param id Profiling id returned by PROF_Register().
+ */
+void PROF_LoopEnd(PROF_Id id);
+
+/*!
+ * \brief Returns the current value of the free running cycle counter.
+ * \return Cycle counter value.
+ */
+uint32_t PROF_GetCycles(void);
+
+/*! \brief De-initializes the module. */
+void PROF_Deinit(void);
+
+/*! \brief Initializes the module. */
+void PROF_Init(void);
+
+#endif /* PL_CONFIG_HAS_PROFILER */
+
+#endif /* PROFILER_H_ */
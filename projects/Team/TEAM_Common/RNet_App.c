@@ -18,18 +18,35 @@
 #include "Radio.h"
 #include "RStack.h"
 #include "RApp.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
 #include "FRTOS1.h"
 #include "RPHY.h"
 #include "Shell.h"
 #include "Motor.h"
-#include "TmDt1.h"
 #if PL_CONFIG_HAS_REMOTE
   #include "Remote.h"
 #endif
 #if PL_CONFIG_HAS_LCD
   #include "LCD.h"
 #endif
-#include "KIN1.h" // data type for RoboIDs
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+#endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  #include "RadioLink.h"
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  #include "TimeSync.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
+
+#if PL_CONFIG_HAS_PROFILER
+  #define RNETA_CYCLES_PER_US   (configCPU_CLOCK_HZ/1000000) /* message handler times are measured in CPU cycles */
+#endif
 
 static RNWK_ShortAddrType APP_dstAddr = RNWK_ADDR_BROADCAST; /* destination node address */
 
@@ -41,43 +58,36 @@ typedef enum {
 
 static RNETA_State appState = RNETA_NONE;
 
-/* RobotID's of L1 and L6 */
-static const KIN1_UID RoboIDs[] = {
-  /* 6: L6, V1 */  {{0x00,0x17,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x06}},
-  /* 1: L1, V1 */  {{0x00,0x19,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x25}},
-};
-
-//Channel Number for L1 & L6
-uint8_t channelRobot6 = 45;
-uint8_t channelRobot1 = 46;
-
-/* Channel Number for L1 or L6 */
+#if PL_CONFIG_HAS_HW_PROFILE
+/* radio channel of this robot, so robots of different teams do not disturb each other */
 static void RNETA_AdoptToHardware(void) {
-  KIN1_UID id;
-  uint8_t res;
+  uint8_t channel = HWP_Get()->rfChannel;
 
-  res = KIN1_UIDGet(&id);
-  if (res!=ERR_OK) {
-    for(;;); /* error */
-  }
-  /* Robot L6 */
-  if (KIN1_UIDSame(&id, &RoboIDs[0]))
-  {
-	RNET1_SetChannel(channelRobot6);
-  }
-  /* Robot L1 */
-  else if (KIN1_UIDSame(&id, &RoboIDs[1]))
-  {
-    RNET1_SetChannel(channelRobot1);
+  if (channel!=0) {
+#if PL_CONFIG_HAS_RADIO_LINK
+    RLINK_SetChannel(channel); /* the link monitor reports it and returns to it after a scan */
+#else
+    (void)RNET1_SetChannel(channel);
+#endif
   }
 }
+#endif
 
 RNWK_ShortAddrType RNETA_GetDestAddr(void) {
   return APP_dstAddr;
 }
 
 void RNETA_SendSignal(uint8_t signal) {
+#if PL_CONFIG_HAS_TIME_SYNC
+  uint8_t data[10];
+  uint32_t us, errUs;
+
+  (void)TSYNC_GetSharedUs(&us, &errUs); /* time stamp at the source, independent of the radio latency */
+  UTIL1_SetValue32LE(us, &data[2]);
+  UTIL1_SetValue32LE(errUs, &data[6]);
+#else
   uint8_t data[2];
+#endif
 
   data[0] = 0; /* group */
   data[1] = signal;
@@ -97,107 +107,29 @@ uint8_t RNETA_SendIdValuePairMessage(uint8_t msgType, uint16_t id, uint32_t valu
   }
 }
 
-static TickType_t timeA=0, timeB=0, timeC=0;
-
 static uint8_t HandleDataRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet) {
 #if PL_CONFIG_HAS_SHELL
-  uint8_t buf[48];
-  CLS1_ConstStdIOTypePtr io = CLS1_GetStdio();
+  uint8_t buf[64];
 #endif
   uint8_t val;
   
   (void)size;
   (void)packet;
   switch(type) {
-#if 1
-    case RAPP_MSG_TYPE_LAP_POINT:
-      if (size==2) {
-        *handled = TRUE;
-    #if PL_CONFIG_HAS_SHELL
-        UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Group: ");
-        UTIL1_strcatNum8u(buf, sizeof(buf), *(data)); /* group number */
-        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" Event: ");
-        UTIL1_chcat(buf, sizeof(buf), *(data+1)); /* event: 'A', 'B', 'C', 'X' or 'T' */
-        if (*(data+1)=='A' && timeA==0) {
-          timeA = xTaskGetTickCount();
-        } else if (*(data+1)=='A' && timeA!=0 && timeB==0 && timeC==0) { /* repeat A */
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" repeat A");
-        } else if (*(data+1)=='B' && timeA!=0 && timeB==0 && timeC==0) {
-          timeB = xTaskGetTickCount();
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" timeAB: ");
-          UTIL1_strcatNum32u(buf, sizeof(buf), timeB-timeA); /* time */
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms");
-        } else if (*(data+1)=='B' && timeA!=0 && timeB!=0 && timeC==0) { /* repeat B */
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" repeat B");
-        } else if (*(data+1)=='C' && timeA!=0 && timeB!=0 && timeC==0) {
-          timeC = xTaskGetTickCount();
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" timeAC: ");
-          UTIL1_strcatNum32u(buf, sizeof(buf), timeC-timeA); /* time */
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms");
-        } else if (*(data+1)=='C' && timeA==0 && timeB==0 && timeC==0) { /* repeat C */
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" repeat C");
-        } else if (*(data+1)=='T') { /* test */
-          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" TEST");
-        } else {
-          if (*(data+1)=='X') { /* did not finish */
-            UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" DNF");
-          } else {
-            UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ERROR");
-          }
-          if (timeA==0) {
-            timeB = 5*60*1000;
-            timeC = timeB+5*60*1000;
-          } else if (timeB==0) {
-            timeB = timeA+5*60*1000;
-            timeC = timeB+5*60*1000;
-          } else { /* DNF for time C */
-            timeC = timeB+5*60*1000;
-          }
-        }
-        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
-        CLS1_SendStr(buf, io->stdOut);
-        if (timeC!=0) {
-          DATEREC date;
-          TIMEREC time;
-
-          CLS1_SendStr((unsigned char*)"---------------------------------------\r\n", io->stdOut);
-          CLS1_SendStr((unsigned char*)"Date\tTime\tGroup\ttimeAB(ms)\ttimeAC(ms)\r\n", io->stdOut);
-          CLS1_SendStr((unsigned char*)"---------------------------------------\r\n", io->stdOut);
-          buf[0] = '\0';
-          (void)TmDt1_GetDate(&date);
-          (void)TmDt1_GetTime(&time);
-          (void)TmDt1_AddDateString(buf, sizeof(buf), &date, TmDt1_DEFAULT_DATE_FORMAT_STR);
-          UTIL1_chcat(buf, sizeof(buf), '\t');
-          (void)TmDt1_AddTimeString(buf, sizeof(buf), &time, TmDt1_DEFAULT_TIME_FORMAT_STR);
-          UTIL1_chcat(buf, sizeof(buf), '\t');
-          UTIL1_strcatNum8u(buf, sizeof(buf), *(data)); /* group number */
-          UTIL1_chcat(buf, sizeof(buf), '\t');
-          UTIL1_strcatNum32u(buf, sizeof(buf), timeB-timeA); /* time A to B */
-          UTIL1_chcat(buf, sizeof(buf), '\t');
-          UTIL1_strcatNum32u(buf, sizeof(buf), timeC-timeA); /* time A to C */
-          CLS1_SendStr(buf, io->stdOut);
-          CLS1_SendStr((unsigned char*)"\r\n---------------------------------------\r\n", io->stdOut);
-          timeA = timeB = timeC = 0;
-        }
-    #endif
-      }
-      break;
-#endif
     case RAPP_MSG_TYPE_DATA: /* generic data message */
       *handled = TRUE;
       val = *data; /* get data value */
 #if PL_CONFIG_HAS_SHELL
-      CLS1_SendStr((unsigned char*)"Data: ", io->stdOut);
-      CLS1_SendNum8u(val, io->stdOut);
-      CLS1_SendStr((unsigned char*)" from addr 0x", io->stdOut);
-      buf[0] = '\0';
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Data: ");
+      UTIL1_strcatNum8u(buf, sizeof(buf), val);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" from addr 0x");
 #if RNWK_SHORT_ADDR_SIZE==1
       UTIL1_strcatNum8Hex(buf, sizeof(buf), srcAddr);
 #else
       UTIL1_strcatNum16Hex(buf, sizeof(buf), srcAddr);
 #endif
       UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
-      CLS1_SendStr(buf, io->stdOut);
+      SHELL_SendString(buf); /* queued, the radio task does not wait for the console */
 #endif /* PL_HAS_SHELL */      
       return ERR_OK;
     default: /*! \todo Handle your own messages here */
@@ -206,18 +138,142 @@ static uint8_t HandleDataRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *da
   return ERR_OK;
 }
 
-static const RAPP_MsgHandler handlerTable[] = 
-{
+/* message dispatching: a direct lookup from the message type to its handler and statistics */
+#define RNETA_CONFIG_MAX_MSG_TYPES  (16) /* number of message types with a handler or statistics */
+
+typedef struct {
+  RAPP_MSG_Type type;       /* message type */
+  RAPP_MsgHandler handler;  /* registered handler, NULL if none */
+  uint32_t nofRx;           /* number of received messages */
+  uint32_t nofHandled;      /* number of messages the handler has accepted */
+  uint32_t nofDropped;      /* number of messages without handler or not accepted by the handler */
+  uint32_t sumCycles;       /* accumulated processing time of the handler */
+  uint32_t maxCycles;       /* worst case processing time of the handler */
+} RNETA_MsgSlot;
+
+static RNETA_MsgSlot RNETA_MsgSlots[RNETA_CONFIG_MAX_MSG_TYPES];
+static uint8_t RNETA_NofMsgSlots = 0;
+static uint8_t RNETA_MsgTypeToSlot[256]; /* slot index+1 for each message type, 0 for none */
+static uint32_t RNETA_NofRxOverflow = 0; /* received messages without a free statistics slot */
+
+typedef struct {
+  RAPP_MSG_Type type;
+  RAPP_MsgHandler handler;
+} RNETA_MsgHandlerDesc;
+
+/* message handlers of this application */
+static const RNETA_MsgHandlerDesc RNETA_AppHandlers[] = {
 #if RNET_CONFIG_REMOTE_STDIO
-  RSTDIO_HandleStdioRxMessage,
+  {RAPP_MSG_TYPE_STDIN, RSTDIO_HandleStdioRxMessage},
+  {RAPP_MSG_TYPE_STDOUT, RSTDIO_HandleStdioRxMessage},
+  {RAPP_MSG_TYPE_STDERR, RSTDIO_HandleStdioRxMessage},
 #endif
-  HandleDataRxMessage,
+  {RAPP_MSG_TYPE_DATA, HandleDataRxMessage},
 #if PL_CONFIG_HAS_REMOTE
-  REMOTE_HandleRemoteRxMessage,
+  {RAPP_MSG_TYPE_JOYSTICK_XY, REMOTE_HandleRemoteRxMessage},
+  {RAPP_MSG_TYPE_JOYSTICK_BTN, REMOTE_HandleRemoteRxMessage},
+  {RAPP_MSG_TYPE_REQUEST_SET_VALUE, REMOTE_HandleRemoteRxMessage},
+  {RAPP_MSG_TYPE_NOTIFY_VALUE, REMOTE_HandleRemoteRxMessage},
+  {RAPP_MSG_TYPE_QUERY_VALUE, REMOTE_HandleRemoteRxMessage},
 #endif
 #if PL_CONFIG_HAS_LCD
-  LCD_HandleRemoteRxMessage,
+  {RAPP_MSG_TYPE_QUERY_VALUE_RESPONSE, LCD_HandleRemoteRxMessage},
+#endif
+};
+
+/*!
+ * \brief Returns the slot of a message type.
+ * \param type Message type.
+ * \param create If TRUE, a new slot gets assigned if the type does not have one yet.
+ * \return Pointer to the slot, or NULL if not found or no slot is free.
+ */
+static RNETA_MsgSlot *GetMsgSlot(RAPP_MSG_Type type, bool create) {
+  RNETA_MsgSlot *slot;
+  uint8_t idx;
+
+  idx = RNETA_MsgTypeToSlot[(uint8_t)type];
+  if (idx!=0) {
+    return &RNETA_MsgSlots[idx-1];
+  }
+  if (!create || RNETA_NofMsgSlots>=RNETA_CONFIG_MAX_MSG_TYPES) {
+    return NULL;
+  }
+  slot = &RNETA_MsgSlots[RNETA_NofMsgSlots];
+  slot->type = type;
+  slot->handler = NULL;
+  slot->nofRx = slot->nofHandled = slot->nofDropped = 0;
+  slot->sumCycles = slot->maxCycles = 0;
+  RNETA_NofMsgSlots++;
+  RNETA_MsgTypeToSlot[(uint8_t)type] = RNETA_NofMsgSlots; /* publish the slot after it has been set up */
+  return slot;
+}
+
+uint8_t RNETA_RegisterMsgHandler(RAPP_MSG_Type type, RAPP_MsgHandler handler) {
+  RNETA_MsgSlot *slot;
+  uint8_t res = ERR_OK;
+
+  taskENTER_CRITICAL();
+  slot = GetMsgSlot(type, TRUE);
+  if (slot==NULL) {
+    res = ERR_OVERFLOW;
+  } else if (slot->handler!=NULL && slot->handler!=handler) {
+    res = ERR_FAILED; /* only one handler per message type */
+  } else {
+    slot->handler = handler;
+  }
+  taskEXIT_CRITICAL();
+  return res;
+}
+
+/*!
+ * \brief The only handler known to the RNet application layer: it forwards the message to the handler
+ * registered for the message type and updates the message statistics.
+ */
+static uint8_t DispatchRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet) {
+  RNETA_MsgSlot *slot;
+  uint8_t res = ERR_OK;
+#if PL_CONFIG_HAS_PROFILER
+  uint32_t cycles;
+#endif
+
+#if PL_CONFIG_HAS_RADIO_LINK
+  RLINK_OnRxMessage(srcAddr);
+#endif
+  slot = GetMsgSlot(type, FALSE);
+  if (slot==NULL) { /* unknown types get a slot too, so they show up in the statistics */
+    taskENTER_CRITICAL();
+    slot = GetMsgSlot(type, TRUE);
+    taskEXIT_CRITICAL();
+  }
+  if (slot==NULL) {
+    RNETA_NofRxOverflow++;
+    return ERR_OK;
+  }
+  slot->nofRx++;
+  if (slot->handler!=NULL) {
+#if PL_CONFIG_HAS_PROFILER
+    cycles = PROF_GetCycles();
+#endif
+    res = slot->handler(type, size, data, srcAddr, handled, packet);
+#if PL_CONFIG_HAS_PROFILER
+    cycles = PROF_GetCycles()-cycles;
+    slot->sumCycles += cycles;
+    if (cycles>slot->maxCycles) {
+      slot->maxCycles = cycles;
+    }
 #endif
+  }
+  if (*handled) {
+    slot->nofHandled++;
+  } else {
+    slot->nofDropped++;
+  }
+  return res;
+}
+
+static const RAPP_MsgHandler handlerTable[] = 
+{
+  DispatchRxMessage,
   NULL /* sentinel */
 };
 
@@ -272,12 +328,37 @@ static void Init(void) {
 }
 
 static void RadioTask(void *pvParameters) {
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
+
   (void)pvParameters; /* not used */
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("Radio", PROF_PERIOD_DELAY, 2);
+#endif
   Init(); /* initialize address */
   appState = RNETA_NONE; /* set state machine state */
   configASSERT(portTICK_PERIOD_MS<=2); /* otherwise  vTaskDelay() below will not delay and starve lower prio tasks */
   for(;;) {
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
     Process(); /* process state machine and radio in/out queues */
+#if PL_CONFIG_HAS_RADIO_LINK
+    RLINK_Process(); /* acknowledge timeouts and channel scan */
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+    TSYNC_Process(); /* clock synchronisation requests */
+#endif
+#if PL_CONFIG_HAS_REMOTE
+    REMOTE_Process(); /* joystick fail safe */
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+    LAPT_Process(); /* lap times to the other nodes, not sent from the control loop */
+#endif
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
     FRTOS1_vTaskDelay(2/portTICK_PERIOD_MS); /* \todo This will only work properly if having a <= 2ms tick period */
   }
 }
@@ -287,11 +368,20 @@ void RNETA_Deinit(void) {
 }
 
 void RNETA_Init(void) {
+  uint8_t i;
+
   RNET1_Init(); /* initialize stack */
+  for(i=0;i<sizeof(RNETA_AppHandlers)/sizeof(RNETA_AppHandlers[0]);i++) {
+    if (RNETA_RegisterMsgHandler(RNETA_AppHandlers[i].type, RNETA_AppHandlers[i].handler)!=ERR_OK) {
+      for(;;){} /* error: duplicate message type or RNETA_CONFIG_MAX_MSG_TYPES too small */
+    }
+  }
   if (RAPP_SetMessageHandlerTable(handlerTable)!=ERR_OK) { /* assign application message handler */
     //APP_DebugPrint((unsigned char*)"ERR: failed setting message handler!\r\n");
   }
-  //RNETA_AdoptToHardware();	//Channel abhngig des Roboters einstellen
+#if PL_CONFIG_HAS_HW_PROFILE
+  RNETA_AdoptToHardware(); /* channel from the hardware profile, set with 'hwp channel' */
+#endif
   if (FRTOS1_xTaskCreate(
         RadioTask,  /* pointer to the task */
         "Radio", /* task name for kernel awareness debugging */
@@ -324,6 +414,67 @@ static uint8_t PrintStatus(const CLS1_StdIOType *io) {
   return ERR_OK;
 }
 
+/*!
+ * \brief Resets the message statistics, but keeps the registered handlers.
+ */
+static void ResetMsgStats(void) {
+  uint8_t i;
+
+  taskENTER_CRITICAL();
+  for(i=0;i<RNETA_NofMsgSlots;i++) {
+    RNETA_MsgSlots[i].nofRx = 0;
+    RNETA_MsgSlots[i].nofHandled = 0;
+    RNETA_MsgSlots[i].nofDropped = 0;
+    RNETA_MsgSlots[i].sumCycles = 0;
+    RNETA_MsgSlots[i].maxCycles = 0;
+  }
+  RNETA_NofRxOverflow = 0;
+  taskEXIT_CRITICAL();
+}
+
+static void PadTo(unsigned char *buf, size_t bufSize, size_t col) {
+  while(UTIL1_strlen((char*)buf)<col && UTIL1_strlen((char*)buf)+1<bufSize) {
+    UTIL1_chcat(buf, bufSize, ' ');
+  }
+}
+
+static void PrintMsgStats(const CLS1_StdIOType *io) {
+  uint8_t buf[64];
+  uint8_t i;
+  RNETA_MsgSlot *slot;
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), RNETA_NofRxOverflow);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (no statistics slot)\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  rx overflow", buf, io->stdOut);
+#if PL_CONFIG_HAS_PROFILER
+  CLS1_SendStr((unsigned char*)"type handler rx        handled   dropped   avg us max us\r\n", io->stdOut);
+#else
+  CLS1_SendStr((unsigned char*)"type handler rx        handled   dropped\r\n", io->stdOut);
+#endif
+  for(i=0;i<RNETA_NofMsgSlots;i++) {
+    slot = &RNETA_MsgSlots[i];
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"0x");
+    UTIL1_strcatNum8Hex(buf, sizeof(buf), (uint8_t)slot->type);
+    PadTo(buf, sizeof(buf), 5);
+    UTIL1_strcat(buf, sizeof(buf), slot->handler!=NULL?(unsigned char*)"yes":(unsigned char*)"no");
+    PadTo(buf, sizeof(buf), 13);
+    UTIL1_strcatNum32u(buf, sizeof(buf), slot->nofRx);
+    PadTo(buf, sizeof(buf), 23);
+    UTIL1_strcatNum32u(buf, sizeof(buf), slot->nofHandled);
+    PadTo(buf, sizeof(buf), 33);
+    UTIL1_strcatNum32u(buf, sizeof(buf), slot->nofDropped);
+#if PL_CONFIG_HAS_PROFILER
+    PadTo(buf, sizeof(buf), 43);
+    UTIL1_strcatNum32u(buf, sizeof(buf), slot->nofRx!=0?slot->sumCycles/slot->nofRx/RNETA_CYCLES_PER_US:0);
+    PadTo(buf, sizeof(buf), 50);
+    UTIL1_strcatNum32u(buf, sizeof(buf), slot->maxCycles/RNETA_CYCLES_PER_US);
+#endif
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
 static void PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"app", (unsigned char*)"Group of application commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help", (unsigned char*)"Shows radio help or status\r\n", io->stdOut);
@@ -333,7 +484,7 @@ static void PrintHelp(const CLS1_StdIOType *io) {
 #if RNET_CONFIG_REMOTE_STDIO
   CLS1_SendHelpStr((unsigned char*)"  send (in/out/err)", (unsigned char*)"Send a string to stdio using the wireless transceiver\r\n", io->stdOut);
 #endif
-  CLS1_SendHelpStr((unsigned char*)"  reset labtime", (unsigned char*)"reset lab time\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  msg status|reset", (unsigned char*)"Shows or resets the received message statistics per type\r\n", io->stdOut);
 }
 
 uint8_t RNETA_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
@@ -348,6 +499,13 @@ uint8_t RNETA_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_S
   } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"app status")==0) {
     *handled = TRUE;
     return PrintStatus(io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"app msg status")==0) {
+    *handled = TRUE;
+    CLS1_SendStatusStr((unsigned char*)"app msg", (unsigned char*)"\r\n", io->stdOut);
+    PrintMsgStats(io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"app msg reset")==0) {
+    *handled = TRUE;
+    ResetMsgStats();
   } else if (UTIL1_strncmp((char*)cmd, (char*)"app saddr", sizeof("app saddr")-1)==0) {
     p = cmd + sizeof("app saddr")-1;
     *handled = TRUE;
@@ -400,9 +558,6 @@ uint8_t RNETA_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_S
     }
     *handled = TRUE;
 #endif
-  } else if (UTIL1_strcmp((char*)cmd, (char*)"reset labtime")==0) {
-    timeA=0, timeB=0, timeC=0;
-    *handled = TRUE;
   }
   return res;
 }
@@ -40,6 +40,14 @@ uint8_t RNETA_SendIdValuePairMessage(uint8_t msgType, uint16_t id, uint32_t valu
  */
 RNWK_ShortAddrType RNETA_GetDestAddr(void);
 
+/*!
+ * \brief Registers the handler for a message type. Received messages are forwarded to it with a direct table lookup.
+ * \param type Message type.
+ * \param handler Message handler, called from the radio task.
+ * \return ERR_OK, ERR_FAILED if another handler is registered for the type, or ERR_OVERFLOW if no slot is left.
+ */
+uint8_t RNETA_RegisterMsgHandler(RAPP_MSG_Type type, RAPP_MsgHandler handler);
+
 /*! \breif send a special signal to the other system */
 void RNETA_SendSignal(uint8_t signal);
 
@@ -25,7 +25,10 @@ typedef enum {
   RAPP_MSG_TYPE_NOTIFY_VALUE = 0x56,            /* id16:val32, notification about a value: 16bit ID followed by 32bit value */
   RAPP_MSG_TYPE_QUERY_VALUE = 0x57,             /* id16, request to query for a value: data ID is a 16bit ID */
   RAPP_MSG_TYPE_QUERY_VALUE_RESPONSE = 0x58,    /* id16:val32, response for RAPP_MSG_TYPE_QUERY_VALUE request: 16bit ID followed by 32bit value */
-  RAPP_MSG_TYPE_LAP_POINT = 0xAC,
+  RAPP_MSG_TYPE_TIME_SYNC_REQ = 0x59,           /* t1, clock synchronisation request: 32bit local send time of the client in us */
+  RAPP_MSG_TYPE_TIME_SYNC_RESP = 0x5A,          /* t1:t2:t3, response: request send time, receive and send time of the master in us */
+  RAPP_MSG_TYPE_LAP_RESULT = 0x5B,              /* run:lap:source:tag:splits:time32:error32, lap finished on a node, see LapTime.h */
+  RAPP_MSG_TYPE_LAP_POINT = 0xAC,               /* group:event, optionally followed by the 32bit shared time in us and its 32bit error bound */
   /* \todo extend with your own messages */
 } RAPP_MSG_Type;
 
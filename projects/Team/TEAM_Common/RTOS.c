@@ -74,7 +74,6 @@ static void MainTask(void *pvParameters) {
 		//vTaskDelay(200/portTICK_PERIOD_MS);		//200ms Blinkperiode
 		//Lab 28 Key Polling mit Debounce fr LCD Anzeige
 		//KEY_Scan();
-		KEYDBNC_Process(); // Falls ein Button gedrckt wird, wird mit dieser Funktion entprellt
 		vTaskDelay(400/portTICK_PERIOD_MS);		//200ms Blinkperiode
 
 		EVNT_HandleEvent(APP_EventHandler, TRUE);	//Eventhandler aufrufen
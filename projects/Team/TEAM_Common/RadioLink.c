@@ -0,0 +1,562 @@
+/**
+ * \file
+ * \brief Radio link quality monitor implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * For each peer node this module records the signal strength of received messages (the nRF24L01+
+ * only reports if the signal was above -64 dBm), and for messages sent with an acknowledge the
+ * round trip time, the number of retries and the losses over a sliding window.
+ * Periodic messages (joystick) use the link quality to select the send period and how often an
+ * acknowledge is requested: old joystick values are not worth retrying, so on a good link only every
+ * few messages probe the link. On a poor link the rate gets reduced and every message is retried.
+ * Optionally the channels can be scanned for the one with the least traffic.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_RADIO_LINK
+#include "RadioLink.h"
+#include "RNetConf.h"
+#include "RPHY.h"
+#include "RF1.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#include <string.h>
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define RLINK_CONFIG_NOF_PEERS          (4)   /* number of nodes with statistics */
+#define RLINK_CONFIG_WINDOW             (32)  /* number of acknowledge requests in the sliding window, max 32 */
+#define RLINK_CONFIG_MIN_SAMPLES        (8)   /* acknowledge requests in the window needed to rate the link */
+#define RLINK_CONFIG_ACK_TIMEOUT_MS     (500) /* no acknowledge or failure reported within this time: give up waiting */
+#define RLINK_CONFIG_SCAN_AT_STARTUP    (0)   /* 1: scan at startup and use the quietest channel. All nodes need the same setting! */
+#define RLINK_CONFIG_SCAN_FIRST_CHANNEL (0)   /* first channel to scan */
+#define RLINK_CONFIG_SCAN_LAST_CHANNEL  (125) /* last channel to scan */
+#define RLINK_CONFIG_SCAN_CHANNEL_STEP  (5)   /* channel distance between scanned channels */
+#define RLINK_CONFIG_SCAN_SAMPLES       (16)  /* carrier samples per channel, one tick apart */
+#ifdef RNET_CONFIG_TRANSCEIVER_CHANNEL
+  #define RLINK_CONFIG_DEFAULT_CHANNEL  RNET_CONFIG_TRANSCEIVER_CHANNEL
+#else
+  #define RLINK_CONFIG_DEFAULT_CHANNEL  (0)
+#endif
+
+#define RLINK_NOF_SCAN_CHANNELS  ((RLINK_CONFIG_SCAN_LAST_CHANNEL-RLINK_CONFIG_SCAN_FIRST_CHANNEL)/RLINK_CONFIG_SCAN_CHANNEL_STEP+1)
+
+#ifndef RF1_RPD
+  #define RF1_RPD  (0x09) /* nRF24L01+ received power detector register */
+#endif
+
+/* send policy for periodic messages, indexed by RLINK_Quality */
+static const struct {
+  uint16_t periodMs; /* send period */
+  uint8_t ackEvery;  /* request an acknowledge for every n-th message */
+} RLINK_Policy[] = {
+  {200, 1}, /* RLINK_QUALITY_UNKNOWN: same as without link monitor */
+  { 50, 4}, /* RLINK_QUALITY_GOOD */
+  {100, 2}, /* RLINK_QUALITY_FAIR */
+  {200, 1}, /* RLINK_QUALITY_POOR: less air time, every message retried */
+};
+
+/*! \brief Statistics of a peer node */
+typedef struct {
+  bool inUse;                   /*!< entry is used */
+  RNWK_ShortAddrType addr;      /*!< node address */
+  /* receiving */
+  uint32_t nofRx;               /*!< number of received messages */
+  uint32_t rxStrongBits;        /*!< one bit per received message, 1 if the signal was above -64 dBm */
+  uint8_t nofRxWin;             /*!< number of valid bits in rxStrongBits */
+  TickType_t lastRxTick;        /*!< time of the last received message */
+  /* sending */
+  uint32_t nofTx;               /*!< number of periodic messages sent */
+  uint32_t nofAckReq;           /*!< number of messages with acknowledge request */
+  uint32_t nofAck;              /*!< number of acknowledges received */
+  uint32_t nofLost;             /*!< number of messages lost after all retries */
+  uint32_t nofRetries;          /*!< total number of retries */
+  uint32_t txOkBits;            /*!< one bit per acknowledge request in the window, 1 if acknowledged */
+  uint8_t retries[RLINK_CONFIG_WINDOW]; /*!< retries per acknowledge request in the window */
+  uint16_t retrySum;            /*!< sum of retries[] */
+  uint8_t nofTxWin;             /*!< number of valid entries in the window */
+  uint8_t winIdx;               /*!< next entry in retries[] */
+  uint16_t rttAvgMs8;           /*!< smoothed round trip time, in 1/8 ms */
+  uint16_t rttMaxMs;            /*!< maximum round trip time */
+  uint8_t ackCntr;              /*!< periodic messages until the next acknowledge request */
+} RLINK_Peer;
+
+static RLINK_Peer RLINK_Peers[RLINK_CONFIG_NOF_PEERS];
+static uint32_t RLINK_NofNoPeer; /* messages from or to nodes without a free entry */
+static bool RLINK_HaveRadioEvents; /* TRUE once RNet has reported an acknowledge, retry or timeout */
+
+/* the one message waiting for its acknowledge */
+static struct {
+  RLINK_Peer *peer; /* NULL if none */
+  TickType_t txTick; /* time the message has been queued */
+  uint8_t retries; /* retries so far */
+} RLINK_Pending;
+
+static uint8_t RLINK_Channel = RLINK_CONFIG_DEFAULT_CHANNEL; /* channel in use */
+static bool RLINK_ChannelChanged = FALSE; /* RLINK_Channel to be set by the radio task */
+
+static struct {
+  bool requested; /* scan to be done by the radio task */
+  bool apply;     /* switch to the quietest channel after the scan */
+  bool valid;     /* results are available */
+  uint8_t busy[RLINK_NOF_SCAN_CHANNELS]; /* samples with a carrier, per scanned channel */
+  uint8_t quietest; /* quietest channel of the last scan */
+} RLINK_Scan;
+
+/*!
+ * \brief Reads the received power detector of the transceiver. Only called from the radio task.
+ * \return TRUE if a signal above -64 dBm has been detected.
+ */
+static bool ReadPowerDetector(void) {
+  return (RF1_ReadRegister(RF1_RPD)&1)!=0;
+}
+
+static RLINK_Peer *GetPeer(RNWK_ShortAddrType addr, bool create) {
+  int i;
+  RLINK_Peer *free = NULL;
+
+  for(i=0;i<RLINK_CONFIG_NOF_PEERS;i++) {
+    if (RLINK_Peers[i].inUse) {
+      if (RLINK_Peers[i].addr==addr) {
+        return &RLINK_Peers[i];
+      }
+    } else if (free==NULL) {
+      free = &RLINK_Peers[i];
+    }
+  }
+  if (create && free!=NULL) {
+    (void)memset(free, 0, sizeof(*free)); /* start with empty statistics */
+    free->inUse = TRUE;
+    free->addr = addr;
+    return free;
+  }
+  return NULL;
+}
+
+static uint8_t GetLossPercent(const RLINK_Peer *peer) {
+  uint32_t bits;
+  uint8_t i, nofOk;
+
+  if (peer->nofTxWin==0) {
+    return 0;
+  }
+  bits = peer->txOkBits;
+  nofOk = 0;
+  for(i=0;i<peer->nofTxWin;i++) {
+    if (bits&1) {
+      nofOk++;
+    }
+    bits >>= 1;
+  }
+  return (uint8_t)(((peer->nofTxWin-nofOk)*100)/peer->nofTxWin);
+}
+
+static uint8_t GetStrongPercent(const RLINK_Peer *peer) {
+  uint32_t bits;
+  uint8_t i, nofStrong;
+
+  if (peer->nofRxWin==0) {
+    return 0;
+  }
+  bits = peer->rxStrongBits;
+  nofStrong = 0;
+  for(i=0;i<peer->nofRxWin;i++) {
+    if (bits&1) {
+      nofStrong++;
+    }
+    bits >>= 1;
+  }
+  return (uint8_t)((nofStrong*100)/peer->nofRxWin);
+}
+
+static RLINK_Quality GetPeerQuality(const RLINK_Peer *peer) {
+  uint8_t lossPct;
+  uint16_t retries10;
+
+  if (peer==NULL || peer->nofTxWin<RLINK_CONFIG_MIN_SAMPLES) {
+    return RLINK_QUALITY_UNKNOWN;
+  }
+  lossPct = GetLossPercent(peer);
+  retries10 = (peer->retrySum*10)/peer->nofTxWin; /* average retries per message, times 10 */
+  if (lossPct<=5 && retries10<=5) {
+    return RLINK_QUALITY_GOOD;
+  } else if (lossPct<=20) {
+    return RLINK_QUALITY_FAIR;
+  }
+  return RLINK_QUALITY_POOR;
+}
+
+/*!
+ * \brief Adds the outcome of the pending acknowledge request to the window and clears it. Called inside a critical section.
+ * \param acked TRUE if the acknowledge has been received, FALSE if the message got lost.
+ */
+static void FinishPending(bool acked) {
+  RLINK_Peer *peer = RLINK_Pending.peer;
+  uint16_t rttMs;
+
+  if (peer==NULL) {
+    return;
+  }
+  peer->txOkBits = (peer->txOkBits<<1)|(acked?1:0);
+  peer->retrySum -= peer->retries[peer->winIdx];
+  peer->retries[peer->winIdx] = RLINK_Pending.retries;
+  peer->retrySum += RLINK_Pending.retries;
+  peer->winIdx = (uint8_t)((peer->winIdx+1)%RLINK_CONFIG_WINDOW);
+  if (peer->nofTxWin<RLINK_CONFIG_WINDOW) {
+    peer->nofTxWin++;
+  }
+  peer->nofRetries += RLINK_Pending.retries;
+  if (acked) {
+    peer->nofAck++;
+    rttMs = (uint16_t)((xTaskGetTickCount()-RLINK_Pending.txTick)*portTICK_PERIOD_MS);
+    if (peer->rttAvgMs8==0) {
+      peer->rttAvgMs8 = (uint16_t)(rttMs*8);
+    } else { /* exponential moving average, 1/8 weight for the new value */
+      peer->rttAvgMs8 = (uint16_t)(peer->rttAvgMs8-(peer->rttAvgMs8/8)+rttMs);
+    }
+    if (rttMs>peer->rttMaxMs) {
+      peer->rttMaxMs = rttMs;
+    }
+  } else {
+    peer->nofLost++;
+  }
+  RLINK_Pending.peer = NULL;
+}
+
+uint8_t RLINK_SendPeriodic(uint8_t *data, uint8_t size, RAPP_MSG_Type type, RNWK_ShortAddrType addr) {
+  RLINK_Peer *peer;
+  RAPP_FlagsType flags = RPHY_PACKET_FLAGS_NONE;
+  uint8_t res;
+
+  taskENTER_CRITICAL();
+  peer = GetPeer(addr, TRUE);
+  if (peer==NULL) {
+    RLINK_NofNoPeer++;
+    flags = RPHY_PACKET_FLAGS_REQ_ACK; /* no statistics: always ask for an acknowledge */
+  } else {
+    peer->nofTx++;
+    if (peer->ackCntr>0) {
+      peer->ackCntr--;
+    }
+    if (peer->ackCntr==0 && RLINK_Pending.peer==NULL) { /* time for a probe, and no other one outstanding */
+      flags = RPHY_PACKET_FLAGS_REQ_ACK;
+      peer->nofAckReq++;
+      peer->ackCntr = RLINK_Policy[GetPeerQuality(peer)].ackEvery;
+      /* set before queuing it, as the radio task could report the acknowledge before we return */
+      RLINK_Pending.peer = peer;
+      RLINK_Pending.txTick = xTaskGetTickCount();
+      RLINK_Pending.retries = 0;
+    }
+  }
+  taskEXIT_CRITICAL();
+  res = RAPP_SendPayloadDataBlock(data, size, type, addr, flags);
+  if (res!=ERR_OK && peer!=NULL && (flags&RPHY_PACKET_FLAGS_REQ_ACK)) { /* not queued: nothing to wait for */
+    taskENTER_CRITICAL();
+    if (RLINK_Pending.peer==peer) {
+      RLINK_Pending.peer = NULL;
+    }
+    peer->nofAckReq--;
+    peer->ackCntr = 0; /* probe with the next message */
+    taskEXIT_CRITICAL();
+  }
+  return res;
+}
+
+uint16_t RLINK_GetPeriodMs(RNWK_ShortAddrType addr) {
+  return RLINK_Policy[RLINK_GetQuality(addr)].periodMs;
+}
+
+RLINK_Quality RLINK_GetQuality(RNWK_ShortAddrType addr) {
+  return GetPeerQuality(GetPeer(addr, FALSE));
+}
+
+static const unsigned char *QualityStr(RLINK_Quality quality) {
+  switch(quality) {
+    case RLINK_QUALITY_GOOD: return (const unsigned char*)"good";
+    case RLINK_QUALITY_FAIR: return (const unsigned char*)"fair";
+    case RLINK_QUALITY_POOR: return (const unsigned char*)"poor";
+    default: return (const unsigned char*)"?";
+  }
+}
+
+void RLINK_GetLinkString(RNWK_ShortAddrType addr, uint8_t *buf, size_t bufSize, bool showRtt) {
+  RLINK_Peer *peer;
+
+  peer = GetPeer(addr, FALSE);
+  if (showRtt) {
+    UTIL1_strcpy(buf, bufSize, (unsigned char*)"RTT:");
+    if (peer!=NULL && peer->nofAck!=0) {
+      UTIL1_strcatNum16u(buf, bufSize, (uint16_t)(peer->rttAvgMs8/8));
+      UTIL1_strcat(buf, bufSize, (unsigned char*)"ms R");
+      UTIL1_strcatNum32sDotValue100(buf, bufSize, peer->nofTxWin!=0?(int32_t)((peer->retrySum*100)/peer->nofTxWin):0);
+    } else {
+      UTIL1_strcat(buf, bufSize, (unsigned char*)"--");
+    }
+  } else {
+    UTIL1_strcpy(buf, bufSize, (unsigned char*)"Loss:");
+    if (peer!=NULL && peer->nofTxWin!=0) {
+      UTIL1_strcatNum8u(buf, bufSize, GetLossPercent(peer));
+      UTIL1_chcat(buf, bufSize, '%');
+    } else {
+      UTIL1_strcat(buf, bufSize, (unsigned char*)"--");
+    }
+    UTIL1_chcat(buf, bufSize, ' ');
+    UTIL1_strcat(buf, bufSize, QualityStr(GetPeerQuality(peer)));
+  }
+}
+
+void RLINK_OnRxMessage(RNWK_ShortAddrType srcAddr) {
+  RLINK_Peer *peer;
+  bool strong;
+
+  strong = ReadPowerDetector(); /* latched with the address match of the last received packet */
+  taskENTER_CRITICAL();
+  peer = GetPeer(srcAddr, TRUE);
+  if (peer==NULL) {
+    RLINK_NofNoPeer++;
+  } else {
+    peer->nofRx++;
+    peer->rxStrongBits = (peer->rxStrongBits<<1)|(strong?1:0);
+    if (peer->nofRxWin<32) {
+      peer->nofRxWin++;
+    }
+    peer->lastRxTick = xTaskGetTickCount();
+  }
+  taskEXIT_CRITICAL();
+}
+
+void RLINK_OnRadioEvent(RNET1_RadioEvent event) {
+  taskENTER_CRITICAL();
+  switch(event) {
+    case RNET1_RADIO_RETRY:
+      RLINK_HaveRadioEvents = TRUE;
+      if (RLINK_Pending.peer!=NULL && RLINK_Pending.retries<0xff) {
+        RLINK_Pending.retries++;
+      }
+      break;
+    case RNET1_RADIO_ACK_RECEIVED:
+      RLINK_HaveRadioEvents = TRUE;
+      FinishPending(TRUE);
+      break;
+    case RNET1_RADIO_TIMEOUT: /* no acknowledge after all retries */
+    case RNET1_RADIO_RETRY_MSG_FAILED:
+      RLINK_HaveRadioEvents = TRUE;
+      FinishPending(FALSE);
+      break;
+    default:
+      break;
+  }
+  taskEXIT_CRITICAL();
+}
+
+void RLINK_SetChannel(uint8_t channel) {
+  RLINK_Channel = channel;
+  (void)RNET1_SetChannel(channel);
+}
+
+static void ScanChannels(bool apply) {
+  uint8_t i, j, busy, ch, active;
+
+  active = RLINK_Channel; /* channel before the scan */
+
+  for(i=0;i<RLINK_NOF_SCAN_CHANNELS;i++) {
+    ch = (uint8_t)(RLINK_CONFIG_SCAN_FIRST_CHANNEL+i*RLINK_CONFIG_SCAN_CHANNEL_STEP);
+    (void)RNET1_SetChannel(ch);
+    busy = 0;
+    for(j=0;j<RLINK_CONFIG_SCAN_SAMPLES;j++) {
+      vTaskDelay(1); /* let the receiver settle and listen */
+      if (ReadPowerDetector()) {
+        busy++;
+      }
+    }
+    RLINK_Scan.busy[i] = busy;
+  }
+  RLINK_Scan.quietest = RLINK_CONFIG_SCAN_FIRST_CHANNEL;
+  for(i=1;i<RLINK_NOF_SCAN_CHANNELS;i++) {
+    if (RLINK_Scan.busy[i]<RLINK_Scan.busy[(RLINK_Scan.quietest-RLINK_CONFIG_SCAN_FIRST_CHANNEL)/RLINK_CONFIG_SCAN_CHANNEL_STEP]) {
+      RLINK_Scan.quietest = (uint8_t)(RLINK_CONFIG_SCAN_FIRST_CHANNEL+i*RLINK_CONFIG_SCAN_CHANNEL_STEP);
+    }
+  }
+  RLINK_Scan.valid = TRUE;
+  RLINK_SetChannel(apply ? RLINK_Scan.quietest : active); /* the quietest one, or back to the channel in use */
+}
+
+void RLINK_Process(void) {
+  taskENTER_CRITICAL();
+  if (RLINK_Pending.peer!=NULL && (xTaskGetTickCount()-RLINK_Pending.txTick)*portTICK_PERIOD_MS>RLINK_CONFIG_ACK_TIMEOUT_MS) {
+    if (RLINK_HaveRadioEvents) {
+      FinishPending(FALSE); /* neither acknowledge nor timeout reported: count as lost */
+    } else {
+      RLINK_Pending.peer = NULL; /* radio events not enabled in RNet: no way to tell */
+    }
+  }
+  taskEXIT_CRITICAL();
+  if (RLINK_ChannelChanged) {
+    RLINK_ChannelChanged = FALSE;
+    (void)RNET1_SetChannel(RLINK_Channel);
+  }
+  if (RLINK_Scan.requested) {
+    ScanChannels(RLINK_Scan.apply);
+    RLINK_Scan.requested = FALSE;
+  }
+}
+
+/*!
+ * \brief Resets the statistics of all nodes.
+ */
+static void RLINK_Reset(void) {
+  int i;
+
+  taskENTER_CRITICAL();
+  for(i=0;i<RLINK_CONFIG_NOF_PEERS;i++) {
+    RLINK_Peers[i].inUse = FALSE;
+  }
+  RLINK_NofNoPeer = 0;
+  RLINK_Pending.peer = NULL;
+  taskEXIT_CRITICAL();
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void PadTo(unsigned char *buf, size_t bufSize, size_t col) {
+  while(UTIL1_strlen((char*)buf)<col && UTIL1_strlen((char*)buf)+1<bufSize) {
+    UTIL1_chcat(buf, bufSize, ' ');
+  }
+}
+
+static void RLINK_PrintPeers(const CLS1_StdIOType *io) {
+  unsigned char buf[72];
+  RLINK_Peer *peer;
+  int i;
+
+  CLS1_SendStr((unsigned char*)"addr rx       sig% tx       ack req  loss% retry rtt ms max ms quality\r\n", io->stdOut);
+  for(i=0;i<RLINK_CONFIG_NOF_PEERS;i++) {
+    peer = &RLINK_Peers[i];
+    if (!peer->inUse) {
+      continue;
+    }
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"0x");
+#if RNWK_SHORT_ADDR_SIZE==1
+    UTIL1_strcatNum8Hex(buf, sizeof(buf), peer->addr);
+#else
+    UTIL1_strcatNum16Hex(buf, sizeof(buf), peer->addr);
+#endif
+    PadTo(buf, sizeof(buf), 5);
+    UTIL1_strcatNum32u(buf, sizeof(buf), peer->nofRx);
+    PadTo(buf, sizeof(buf), 14);
+    UTIL1_strcatNum8u(buf, sizeof(buf), GetStrongPercent(peer));
+    PadTo(buf, sizeof(buf), 19);
+    UTIL1_strcatNum32u(buf, sizeof(buf), peer->nofTx);
+    PadTo(buf, sizeof(buf), 28);
+    UTIL1_strcatNum32u(buf, sizeof(buf), peer->nofAckReq);
+    PadTo(buf, sizeof(buf), 37);
+    UTIL1_strcatNum8u(buf, sizeof(buf), GetLossPercent(peer));
+    PadTo(buf, sizeof(buf), 43);
+    UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), peer->nofTxWin!=0?(int32_t)((peer->retrySum*100)/peer->nofTxWin):0);
+    PadTo(buf, sizeof(buf), 49);
+    UTIL1_strcatNum16u(buf, sizeof(buf), (uint16_t)(peer->rttAvgMs8/8));
+    PadTo(buf, sizeof(buf), 56);
+    UTIL1_strcatNum16u(buf, sizeof(buf), peer->rttMaxMs);
+    PadTo(buf, sizeof(buf), 63);
+    UTIL1_strcat(buf, sizeof(buf), QualityStr(GetPeerQuality(peer)));
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
+static void RLINK_PrintScan(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  uint8_t i;
+
+  buf[0] = '\0';
+  for(i=0;i<RLINK_NOF_SCAN_CHANNELS;i++) {
+    UTIL1_strcatNum8u(buf, sizeof(buf), (uint8_t)(RLINK_CONFIG_SCAN_FIRST_CHANNEL+i*RLINK_CONFIG_SCAN_CHANNEL_STEP));
+    UTIL1_chcat(buf, sizeof(buf), ':');
+    UTIL1_strcatNum8u(buf, sizeof(buf), RLINK_Scan.busy[i]);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    if ((i%6)==5 || i==RLINK_NOF_SCAN_CHANNELS-1) { /* six channels per line */
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+      CLS1_SendStatusStr((i<6)?(unsigned char*)"  scan busy":(unsigned char*)"", buf, io->stdOut);
+      buf[0] = '\0';
+    }
+  }
+}
+
+static void RLINK_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  CLS1_SendStatusStr((unsigned char*)"rlink", (unsigned char*)"\r\n", io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum8u(buf, sizeof(buf), RLINK_Channel);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  channel", buf, io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  radio events", RLINK_HaveRadioEvents?(unsigned char*)"yes\r\n":(unsigned char*)"none yet\r\n", io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), RLINK_NofNoPeer);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  no peer slot", buf, io->stdOut);
+  if (RLINK_Scan.valid) {
+    buf[0] = '\0';
+    UTIL1_strcatNum8u(buf, sizeof(buf), RLINK_Scan.quietest);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  scan quietest", buf, io->stdOut);
+    RLINK_PrintScan(io);
+  }
+  RLINK_PrintPeers(io);
+}
+
+static void RLINK_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"rlink", (unsigned char*)"Group of radio link commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows radio link help or statistics\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the statistics\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  scan", (unsigned char*)"Measures the traffic on the channels\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  scan use", (unsigned char*)"Scans and switches to the quietest channel\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  channel <ch>", (unsigned char*)"Switches to a channel (0..125)\r\n", io->stdOut);
+}
+
+uint8_t RLINK_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  const unsigned char *p;
+  uint8_t val8;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"rlink help")==0) {
+    RLINK_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"rlink status")==0) {
+    RLINK_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"rlink reset")==0) {
+    RLINK_Reset();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"rlink scan")==0 || UTIL1_strcmp((char*)cmd, (char*)"rlink scan use")==0) {
+    /* the radio task owns the transceiver, it does the scan */
+    RLINK_Scan.apply = UTIL1_strcmp((char*)cmd, (char*)"rlink scan use")==0;
+    RLINK_Scan.requested = TRUE;
+    CLS1_SendStr((unsigned char*)"scan started, see 'rlink status'\r\n", io->stdOut);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"rlink channel ", sizeof("rlink channel ")-1)==0) {
+    p = cmd+sizeof("rlink channel ")-1;
+    *handled = TRUE;
+    if (UTIL1_ScanDecimal8uNumber(&p, &val8)!=ERR_OK || val8>125) {
+      CLS1_SendStr((unsigned char*)"ERR: wrong channel\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    RLINK_Channel = val8;
+    RLINK_ChannelChanged = TRUE; /* the radio task switches the channel */
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void RLINK_Deinit(void) {
+  /* nothing to do */
+}
+
+void RLINK_Init(void) {
+  RLINK_Reset();
+  RLINK_HaveRadioEvents = FALSE;
+  RLINK_Scan.valid = FALSE;
+  RLINK_Scan.apply = RLINK_CONFIG_SCAN_AT_STARTUP;
+  RLINK_Scan.requested = RLINK_CONFIG_SCAN_AT_STARTUP; /* done by the radio task after the power-up */
+}
+
+#endif /* PL_CONFIG_HAS_RADIO_LINK */
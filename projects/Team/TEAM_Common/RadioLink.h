@@ -0,0 +1,106 @@
+/**
+ * \file
+ * \brief Interface of the radio link quality monitor.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Keeps per peer statistics of the radio link (signal strength, acknowledge round trip time,
+ * retries and losses over a sliding window) and derives the acknowledge policy and the send
+ * rate for periodic messages from it.
+ */
+
+#ifndef RADIOLINK_H_
+#define RADIOLINK_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_RADIO_LINK
+#include "RNWK.h"
+#include "RApp.h"
+#include "RNET1.h"
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t RLINK_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Link quality, derived from the sliding window statistics */
+typedef enum {
+  RLINK_QUALITY_UNKNOWN, /*!< not enough acknowledged messages yet */
+  RLINK_QUALITY_GOOD,    /*!< (almost) no losses or retries */
+  RLINK_QUALITY_FAIR,    /*!< some losses or retries */
+  RLINK_QUALITY_POOR     /*!< many losses */
+} RLINK_Quality;
+
+/*!
+ * \brief Sends a periodic message, e.g. the joystick position, using the acknowledge policy of the link:
+ * on a good link only every few messages request an acknowledge to probe the link, so stale data is not retried.
+ * \param data Pointer to the payload.
+ * \param size Size of the payload in bytes.
+ * \param type Message type.
+ * \param addr Destination node address.
+ * \return Error code, ERR_OK if the message has been queued.
+ */
+uint8_t RLINK_SendPeriodic(uint8_t *data, uint8_t size, RAPP_MSG_Type type, RNWK_ShortAddrType addr);
+
+/*!
+ * \brief Returns the period to use for periodic messages to a node.
+ * \param addr Destination node address.
+ * \return Period in milliseconds.
+ */
+uint16_t RLINK_GetPeriodMs(RNWK_ShortAddrType addr);
+
+/*!
+ * \brief Returns the link quality to a node.
+ * \param addr Node address.
+ * \return Link quality.
+ */
+RLINK_Quality RLINK_GetQuality(RNWK_ShortAddrType addr);
+
+/*!
+ * \brief Builds a short, one line description of the link to a node, e.g. for the LCD.
+ * \param addr Node address.
+ * \param buf Buffer for the text.
+ * \param bufSize Size of the buffer in bytes.
+ * \param showRtt TRUE for the round trip time and retries, FALSE for the loss and quality.
+ */
+void RLINK_GetLinkString(RNWK_ShortAddrType addr, uint8_t *buf, size_t bufSize, bool showRtt);
+
+/*!
+ * \brief Called for each received message from the radio task, records the signal strength of the sender.
+ * \param srcAddr Address of the sender.
+ */
+void RLINK_OnRxMessage(RNWK_ShortAddrType srcAddr);
+
+/*!
+ * \brief Called from the RNet radio event (RNET1_OnRadioEvent()) to track retries and acknowledges.
+ * \param event Radio event.
+ */
+void RLINK_OnRadioEvent(RNET1_RadioEvent event);
+
+/*!
+ * \brief Sets the radio channel in use, instead of RNET1_SetChannel(): a channel scan returns to it.
+ * \param channel Transceiver channel.
+ */
+void RLINK_SetChannel(uint8_t channel);
+
+/*!
+ * \brief Called periodically from the radio task: checks for lost acknowledges and runs a requested channel scan.
+ */
+void RLINK_Process(void);
+
+/*! \brief De-initializes the module. */
+void RLINK_Deinit(void);
+
+/*! \brief Initializes the module. */
+void RLINK_Init(void);
+
+#endif /* PL_CONFIG_HAS_RADIO_LINK */
+
+#endif /* RADIOLINK_H_ */
@@ -0,0 +1,280 @@
+/**
+ * \file
+ * \brief Sensor frame recorder, see Recorder.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * REF_Step() calls REC_Sample() after each measurement (every REF_PERIOD_MS), so a frame holds the
+ * raw values the line detection of that cycle has been computed from. The ring buffer keeps the
+ * last REC_CONFIG_NOF_FRAMES frames, so the end of a run (where things usually go wrong) is always present.
+ * The dump starts with the reflectance timer frequency and the calibration at the start of the
+ * recording, which are needed to reproduce the calibrated values in the replay.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_RECORDER
+#include "Recorder.h"
+#include "Reflectance.h"
+#include "FRTOS1.h"
+#include "CLS1.h"
+#include "UTIL1.h"
+#include "RefCnt.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_HAS_DISTANCE_SENSOR
+  #include "Distance.h"
+#endif
+#if PL_CONFIG_HAS_BATTERY_ADC
+  #include "Battery.h"
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  #include "LineFollow.h"
+#endif
+#if PL_CONFIG_HAS_SUMO
+  #include "Sumo.h"
+#endif
+
+#define REC_FORMAT_VERSION  1 /* version of the dump format, first header line */
+
+static REC_Frame REC_Frames[REC_CONFIG_NOF_FRAMES]; /* ring buffer */
+static uint16_t REC_Head;      /* index of the next frame to write */
+static uint16_t REC_Count;     /* number of valid frames */
+static uint8_t REC_Every = 1;  /* record every n-th measurement */
+static uint8_t REC_EveryCntr;
+static uint16_t REC_BattCv;    /* battery voltage, measured at the start of the recording */
+static uint16_t REC_CalibMin[REC_NOF_IR], REC_CalibMax[REC_NOF_IR]; /* reflectance calibration at the start, the continuous calibration changes it later */
+static volatile bool REC_Recording = FALSE;
+static volatile bool REC_Armed = FALSE;
+static bool REC_ByRun = FALSE;  /* recording has been started by an armed run, stop it with the run */
+
+/* returns TRUE while line following or sumo is running */
+static bool IsRunning(void) {
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  if (LF_IsFollowing()) {
+    return TRUE;
+  }
+#endif
+#if PL_CONFIG_HAS_SUMO
+  if (SUMO_IsRunningSumo()) {
+    return TRUE;
+  }
+#endif
+  return FALSE;
+}
+
+void REC_Start(void) {
+  REC_Recording = FALSE;
+  REC_Head = 0;
+  REC_Count = 0;
+  REC_EveryCntr = 0;
+  REC_BattCv = 0;
+  REF_GetCalibration(REC_CalibMin, REC_CalibMax, REC_NOF_IR);
+#if PL_CONFIG_HAS_BATTERY_ADC
+  /* the measurement blocks for about 1 ms, too long for the reflectance task: measure once, the voltage changes slowly */
+  (void)BATT_MeasureBatteryVoltage(&REC_BattCv);
+#endif
+  REC_ByRun = FALSE;
+  REC_Recording = TRUE;
+}
+
+void REC_Stop(void) {
+  REC_Recording = FALSE;
+  REC_ByRun = FALSE;
+}
+
+void REC_Arm(bool arm) {
+  REC_Armed = arm;
+}
+
+bool REC_IsRecording(void) {
+  return REC_Recording;
+}
+
+uint16_t REC_NofFrames(void) {
+  return REC_Count;
+}
+
+const REC_Frame *REC_GetFrame(uint16_t idx) {
+  if (idx>=REC_Count) {
+    return NULL;
+  }
+  return &REC_Frames[(REC_Head+REC_CONFIG_NOF_FRAMES-REC_Count+idx)%REC_CONFIG_NOF_FRAMES];
+}
+
+void REC_Sample(void) {
+  REC_Frame *f;
+
+  if (REC_Armed && !REC_Recording && IsRunning()) {
+    REC_Start();
+    REC_ByRun = TRUE;
+    REC_Armed = FALSE;
+  } else if (REC_ByRun && REC_Recording && !IsRunning()) {
+    REC_Stop();
+  }
+  if (!REC_Recording) {
+    return;
+  }
+  if (REC_EveryCntr>0) {
+    REC_EveryCntr--;
+    return;
+  }
+  REC_EveryCntr = REC_Every-1;
+  f = &REC_Frames[REC_Head];
+  f->timeMs = FRTOS1_xTaskGetTickCount()*portTICK_PERIOD_MS;
+  REF_GetRawValues(f->ir, REC_NOF_IR);
+  f->encLeft = (int32_t)Q4CLeft_GetPos();
+  f->encRight = (int32_t)Q4CRight_GetPos();
+#if PL_HAS_DISTANCE_SENSOR
+  f->tof[0] = DIST_GetDistance(DIST_SENSOR_FRONT);
+  f->tof[1] = DIST_GetDistance(DIST_SENSOR_REAR);
+  f->tof[2] = DIST_GetDistance(DIST_SENSOR_LEFT);
+  f->tof[3] = DIST_GetDistance(DIST_SENSOR_RIGHT);
+#else
+  f->tof[0] = f->tof[1] = f->tof[2] = f->tof[3] = 0;
+#endif
+  f->battCv = REC_BattCv;
+  REC_Head = (REC_Head+1)%REC_CONFIG_NOF_FRAMES;
+  if (REC_Count<REC_CONFIG_NOF_FRAMES) {
+    REC_Count++;
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void SendValues(const unsigned char *title, const uint16_t *vals, const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  int i;
+
+  UTIL1_strcpy(buf, sizeof(buf), title);
+  for(i=0;i<REC_NOF_IR;i++) {
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    UTIL1_strcatNum16u(buf, sizeof(buf), vals[i]);
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+}
+
+/* prints the frames as CSV, with the replay parameters as comment lines in front */
+static void REC_Dump(const CLS1_StdIOType *io) {
+  unsigned char buf[96];
+  const REC_Frame *f;
+  uint16_t i;
+  int j;
+
+  REC_Stop();
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"# rec ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), REC_FORMAT_VERSION);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n# refcnt_hz ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), RefCnt_CNT_INP_FREQ_U_0);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+  SendValues((unsigned char*)"# calib_min", REC_CalibMin, io);
+  SendValues((unsigned char*)"# calib_max", REC_CalibMax, io);
+  CLS1_SendStr((unsigned char*)"# time_ms,ir1,ir2,ir3,ir4,ir5,ir6,enc_l,enc_r,tof_front,tof_rear,tof_left,tof_right,batt_cv\r\n", io->stdOut);
+  for(i=0;i<REC_Count;i++) {
+    f = REC_GetFrame(i);
+    buf[0] = '\0';
+    UTIL1_strcatNum32u(buf, sizeof(buf), f->timeMs);
+    for(j=0;j<REC_NOF_IR;j++) {
+      UTIL1_chcat(buf, sizeof(buf), ',');
+      UTIL1_strcatNum16u(buf, sizeof(buf), f->ir[j]);
+    }
+    UTIL1_chcat(buf, sizeof(buf), ',');
+    UTIL1_strcatNum32s(buf, sizeof(buf), f->encLeft);
+    UTIL1_chcat(buf, sizeof(buf), ',');
+    UTIL1_strcatNum32s(buf, sizeof(buf), f->encRight);
+    for(j=0;j<REC_NOF_TOF;j++) {
+      UTIL1_chcat(buf, sizeof(buf), ',');
+      UTIL1_strcatNum16s(buf, sizeof(buf), f->tof[j]);
+    }
+    UTIL1_chcat(buf, sizeof(buf), ',');
+    UTIL1_strcatNum16u(buf, sizeof(buf), f->battCv);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
+static void REC_PrintHelp(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+
+  CLS1_SendHelpStr((unsigned char*)"rec", (unsigned char*)"Group of sensor recorder commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Start (clears the buffer) or stop recording\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  arm", (unsigned char*)"Record the next line following or sumo run\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Record every n-th measurement (n*");
+  UTIL1_strcatNum16u(buf, sizeof(buf), REF_PERIOD_MS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms)\r\n");
+  CLS1_SendHelpStr((unsigned char*)"  every <n>", buf, io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  dump", (unsigned char*)"Stop recording and print the frames as CSV\r\n", io->stdOut);
+}
+
+static void REC_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  CLS1_SendStatusStr((unsigned char*)"rec", (unsigned char*)"\r\n", io->stdOut);
+  if (REC_Recording) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"recording\r\n");
+  } else if (REC_Armed) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"armed\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"stopped\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  state", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16u(buf, sizeof(buf), REC_Count);
+  UTIL1_chcat(buf, sizeof(buf), '/');
+  UTIL1_strcatNum16u(buf, sizeof(buf), REC_CONFIG_NOF_FRAMES);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  frames", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16u(buf, sizeof(buf), REC_Every*REF_PERIOD_MS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  period", buf, io->stdOut);
+}
+
+uint8_t REC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  const unsigned char *p;
+  uint8_t val8;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"rec help")==0) {
+    REC_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"rec status")==0) {
+    REC_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"rec start")==0) {
+    REC_Start();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"rec stop")==0) {
+    REC_Stop();
+    REC_Arm(FALSE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"rec arm")==0) {
+    REC_Arm(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"rec dump")==0) {
+    REC_Dump(io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"rec every ", sizeof("rec every ")-1)==0) {
+    p = cmd+sizeof("rec every ")-1;
+    *handled = TRUE;
+    if (UTIL1_ScanDecimal8uNumber(&p, &val8)!=ERR_OK || val8==0 || val8>100) {
+      CLS1_SendStr((unsigned char*)"ERR: wrong value, 1..100\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    REC_Every = val8;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void REC_Deinit(void) {
+  REC_Stop();
+}
+
+void REC_Init(void) {
+  REC_Recording = FALSE;
+  REC_Armed = FALSE;
+  REC_ByRun = FALSE;
+  REC_Head = 0;
+  REC_Count = 0;
+}
+#endif /* PL_CONFIG_HAS_RECORDER */
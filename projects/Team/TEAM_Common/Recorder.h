@@ -0,0 +1,85 @@
+/**
+ * \file
+ * \brief Interface of the sensor frame recorder.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The recorder captures the raw sensor inputs of a run (reflectance discharge times, encoder counts,
+ * ToF ranges and battery voltage) as timestamped frames into a RAM ring buffer.
+ * The frames are exported with 'rec dump' and can be replayed on the host with the simulator (sim -r),
+ * which feeds them into the unchanged line following and sumo code.
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_RECORDER
+
+#ifndef REC_CONFIG_NOF_FRAMES
+  #define REC_CONFIG_NOF_FRAMES (256) /*!< number of frames in the ring buffer, 256*REF_PERIOD_MS: the last 1.28 s with the 5 ms control loop */
+#endif
+#define REC_NOF_IR          (6)   /*!< reflectance sensors per frame */
+#define REC_NOF_TOF         (4)   /*!< ToF ranges per frame, in the order of DIST_Sensor */
+
+/*! \brief One sample of the raw sensor inputs */
+typedef struct {
+  uint32_t timeMs;          /*!< RTOS time of the sample */
+  uint16_t ir[REC_NOF_IR];  /*!< raw reflectance values (timer ticks), IR1 first */
+  int32_t encLeft;          /*!< left quadrature counter */
+  int32_t encRight;         /*!< right quadrature counter */
+  int16_t tof[REC_NOF_TOF]; /*!< ToF ranges in mm, front, rear, left and right */
+  uint16_t battCv;          /*!< battery voltage in centivolts, 0 if not measured */
+} REC_Frame;
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t REC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Clears the buffer and starts recording */
+void REC_Start(void);
+
+/*! \brief Stops recording, the frames are kept until the next start */
+void REC_Stop(void);
+
+/*!
+ * \brief Arms the recorder: the recording starts with the next line following or sumo run and stops at its end.
+ * \param arm TRUE to arm, FALSE to disarm.
+ */
+void REC_Arm(bool arm);
+
+/*! \brief Returns TRUE while frames are recorded */
+bool REC_IsRecording(void);
+
+/*!
+ * \brief Returns a recorded frame.
+ * \param idx Frame index, 0 is the oldest frame.
+ * \return Pointer to the frame, NULL if idx is not below the number of frames.
+ */
+const REC_Frame *REC_GetFrame(uint16_t idx);
+
+/*! \brief Returns the number of recorded frames */
+uint16_t REC_NofFrames(void);
+
+/*!
+ * \brief Samples the sensors into the buffer, called by the reflectance task after each measurement.
+ */
+void REC_Sample(void);
+
+/*! \brief Driver de-initialization */
+void REC_Deinit(void);
+
+/*! \brief Driver initialization */
+void REC_Init(void);
+
+#endif /* PL_CONFIG_HAS_RECORDER */
+
+#endif /* RECORDER_H_ */
@@ -19,6 +19,12 @@
 #include "IR5.h"
 #include "IR6.h"
 #include "UTIL1.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
 #include "FRTOS1.h"
 #include "Application.h"
 #include "Event.h"
@@ -29,6 +35,9 @@
 #if PL_CONFIG_HAS_CONFIG_NVM
   #include "NVM_Config.h"
 #endif
+#if PL_CONFIG_HAS_RECORDER
+  #include "Recorder.h"
+#endif
 
 #define REF_NOF_SENSORS       6 /* number of sensors */
 #define REF_SENSOR1_IS_LEFT   1 /* sensor number one is on the left side */
@@ -40,6 +49,25 @@
   static xSemaphoreHandle REF_StartStopSem = NULL;
 #endif
 
+#define REF_SENSOR_TIMEOUT_US     1500 /* timeout for a sensor measurement */
+#define REF_SENSOR_TIMEOUT_TICKS  (((RefCnt_CNT_INP_FREQ_U_0/1000)*REF_SENSOR_TIMEOUT_US)/1000) /* REF_SENSOR_TIMEOUT_US translated into timeout ticks */
+
+#define REF_AUTO_CALIB            1 /* continuous calibration: track black/white level drift while driving */
+#if REF_AUTO_CALIB
+  #define REF_AC_NOF_BINS         16 /* number of histogram bins per sensor, spread over 0..REF_SENSOR_TIMEOUT_TICKS */
+  #define REF_AC_MAX_TICKS        ((int32_t)REF_SENSOR_TIMEOUT_TICKS) /* signed, as the raw values in the calculations */
+  #define REF_AC_DECAY_LIMIT      0x4000 /* if a bin reaches this count, all bins of the sensor get halved (forgetting old samples) */
+  #define REF_AC_EVAL_MS          500 /* time between histogram evaluations */
+  #define REF_AC_EVAL_PERIOD      (REF_AC_EVAL_MS/REF_PERIOD_MS) /* number of measurements between histogram evaluations */
+  #define REF_AC_MIN_HITS         8  /* a histogram peak needs at least this number of hits to be used */
+  #define REF_AC_ADAPT_DIV        8  /* a level moves 1/8 of the distance to the histogram estimate per evaluation */
+  #define REF_AC_OUTLIER_DIV      2  /* samples more than span/2 outside of min/max are outliers */
+  #define REF_AC_SHIFT_PERCENT    25 /* more outliers than this, most of them close together: a shift of the levels, not noise */
+  #define REF_AC_SHIFT_CLUSTER_PERCENT 75 /* share of the outliers within three neighbouring bins for a shift */
+  #define REF_AC_DEGRADED_SPAN_DIV 4 /* sensor is degraded if min/max span shrinks below 1/4 of the calibrated span */
+  #define REF_AC_DEGRADED_OUTLIER_PERCENT 25 /* sensor is degraded if more than 25% of the samples are outliers */
+#endif
+
 /*! \todo added semaphore */
 static xSemaphoreHandle mutexHandle;
 
@@ -75,6 +103,22 @@ static int16_t refCenterLineVal=0; /* 0 means no line, >0 means line is below se
 static SensorCalibT SensorCalibMinMax; /* min/max calibration data in SRAM */
 static SensorTimeType SensorRaw[REF_NOF_SENSORS]; /* raw sensor values */
 static SensorTimeType SensorCalibrated[REF_NOF_SENSORS]; /* 0 means white/min value, 1000 means black/max value */
+static uint8_t SensorTimeoutMask; /* bit set for each sensor which had a timeout in the last measurement */
+
+#if REF_AUTO_CALIB
+typedef struct RefAutoCalibT_ {
+  uint16_t bins[REF_AC_NOF_BINS]; /* histogram of raw values */
+  uint16_t outlierBins[REF_AC_NOF_BINS]; /* histogram of the outliers in current evaluation period (at most REF_AC_EVAL_PERIOD) */
+  uint16_t nofSamples; /* number of samples in current evaluation period */
+  uint16_t nofOutliers; /* number of rejected samples in current evaluation period */
+} RefAutoCalibT;
+
+static RefAutoCalibT refAutoCalib[REF_NOF_SENSORS]; /* per sensor histogram data */
+static SensorCalibT SensorCalibBase; /* min/max values of the last manual calibration, used as reference for degraded sensors */
+static bool refAutoCalibOn = TRUE; /* if auto calibration is enabled */
+static uint16_t refAutoCalibCntr = 0; /* counts measurements up to REF_AC_EVAL_PERIOD */
+static uint8_t refDegradedMask = 0; /* bit set for each degraded sensor */
+#endif
 
 /* Functions as wrapper around macro. */
 static void S1_SetOutput(void) { IR1_SetOutput(); }
@@ -126,6 +170,23 @@ void REF_GetSensorValues(uint16_t *values, int nofValues) {
 }
 #endif
 
+void REF_GetRawValues(uint16_t *values, int nofValues) {
+  int i;
+
+  for(i=0;i<nofValues && i<REF_NOF_SENSORS;i++) {
+    values[i] = SensorRaw[i];
+  }
+}
+
+void REF_GetCalibration(uint16_t *minVals, uint16_t *maxVals, int nofValues) {
+  int i;
+
+  for(i=0;i<nofValues && i<REF_NOF_SENSORS;i++) {
+    minVals[i] = SensorCalibMinMax.minVal[i];
+    maxVals[i] = SensorCalibMinMax.maxVal[i];
+  }
+}
+
 #if REF_START_STOP_CALIB
 void REF_CalibrateStartStop(void) {
   if (refState==REF_STATE_NOT_CALIBRATED || refState==REF_STATE_CALIBRATING || refState==REF_STATE_READY) {
@@ -145,12 +206,12 @@ static void REF_MeasureRaw(SensorTimeType raw[REF_NOF_SENSORS]) {
   RefCnt_TValueType timerVal;
   /*! \todo Consider reentrancy and mutual exclusion! */
 #if 1 /*! \todo added timout */
-  #define REF_SENSOR_TIMEOUT_US  1500
-  const RefCnt_TValueType timeoutCntVal = ((RefCnt_CNT_INP_FREQ_U_0/1000)*REF_SENSOR_TIMEOUT_US)/1000 /* REF_SENSOR_TIMEOUT_US translated into timeout ticks */;
+  const RefCnt_TValueType timeoutCntVal = REF_SENSOR_TIMEOUT_TICKS;
   bool isTimeout = FALSE;
 #endif
 
   (void)xSemaphoreTake(mutexHandle, portMAX_DELAY);
+  SensorTimeoutMask = 0;
   LED_IR_On(); /* IR LED's on */
   WAIT1_Waitus(200);
   taskENTER_CRITICAL();
@@ -190,6 +251,7 @@ static void REF_MeasureRaw(SensorTimeType raw[REF_NOF_SENSORS]) {
     for(i=0;i<REF_NOF_SENSORS;i++) {
       if (raw[i]==MAX_SENSOR_VALUE) { /* not measured yet? */
         raw[i] = SensorCalibMinMax.maxVal[i]; /* use calibrated max value */
+        SensorTimeoutMask |= (1<<i);
       }
     } /* for */
   }
@@ -231,6 +293,195 @@ static void ReadCalibrated(SensorTimeType calib[REF_NOF_SENSORS], SensorTimeType
   }
 }
 
+#if REF_AUTO_CALIB
+static uint8_t REF_AutoCalibBin(int32_t val) {
+  if (val<0) {
+    return 0;
+  } else if (val>REF_AC_MAX_TICKS) {
+    return REF_AC_NOF_BINS-1;
+  }
+  return (uint8_t)((val*REF_AC_NOF_BINS)/(REF_AC_MAX_TICKS+1));
+}
+
+static int32_t REF_AutoCalibBinCenter(uint8_t bin) {
+  return (((int32_t)bin*2+1)*(REF_AC_MAX_TICKS+1))/(2*REF_AC_NOF_BINS);
+}
+
+static void REF_AutoCalibReset(void) {
+  int i, j;
+
+  for(i=0;i<REF_NOF_SENSORS;i++) {
+    for(j=0;j<REF_AC_NOF_BINS;j++) {
+      refAutoCalib[i].bins[j] = 0;
+      refAutoCalib[i].outlierBins[j] = 0;
+    }
+    refAutoCalib[i].nofSamples = 0;
+    refAutoCalib[i].nofOutliers = 0;
+  }
+  refAutoCalibCntr = 0;
+  refDegradedMask = 0;
+}
+
+/*!
+ * \brief Finds the peak in the histogram bins [from..to[ and returns the weighted center of the peak and its neighbors.
+ * \param data Histogram data of the sensor.
+ * \param from First bin to be considered.
+ * \param to Bin after the last one to be considered.
+ * \param levelP Where to store the estimated level.
+ * \return TRUE if a peak with enough hits has been found, FALSE otherwise.
+ */
+static bool REF_AutoCalibFindPeak(const RefAutoCalibT *data, int from, int to, int32_t *levelP) {
+  int i, peak;
+  int32_t sum, cnt;
+
+  if (from>=to) {
+    return FALSE; /* empty range */
+  }
+  peak = from;
+  for(i=from+1;i<to;i++) {
+    if (data->bins[i]>data->bins[peak]) {
+      peak = i;
+    }
+  }
+  if (data->bins[peak]<REF_AC_MIN_HITS) {
+    return FALSE; /* only a few sporadic samples */
+  }
+  sum = 0; cnt = 0;
+  for(i=peak-1;i<=peak+1;i++) {
+    if (i>=from && i<to) {
+      sum += (int32_t)data->bins[i]*REF_AutoCalibBinCenter(i);
+      cnt += data->bins[i];
+    }
+  }
+  *levelP = sum/cnt;
+  return TRUE;
+}
+
+/*!
+ * \brief Checks if the outliers of the evaluation period are a consistent shift of a level (ambient light, other floor).
+ * \param data Histogram data of the sensor.
+ * \return TRUE if there are many outliers and most of them are close together.
+ */
+static bool REF_AutoCalibIsShift(const RefAutoCalibT *data) {
+  int i, peak;
+  uint16_t cnt;
+
+  if ((uint32_t)data->nofOutliers*100 <= (uint32_t)data->nofSamples*REF_AC_SHIFT_PERCENT) {
+    return FALSE; /* sporadic outliers */
+  }
+  peak = 0;
+  for(i=1;i<REF_AC_NOF_BINS;i++) {
+    if (data->outlierBins[i]>data->outlierBins[peak]) {
+      peak = i;
+    }
+  }
+  cnt = 0;
+  for(i=peak-1;i<=peak+1;i++) {
+    if (i>=0 && i<REF_AC_NOF_BINS) {
+      cnt += data->outlierBins[i];
+    }
+  }
+  return (uint32_t)cnt*100 >= (uint32_t)data->nofOutliers*REF_AC_SHIFT_CLUSTER_PERCENT;
+}
+
+/*!
+ * \brief Moves the white (min) and black (max) levels slowly towards the two histogram peaks and checks for degraded sensors.
+ * Outliers which are a consistent shift are added to the histogram, and the older samples get halved to follow the shift.
+ */
+static void REF_AutoCalibEvaluate(void) {
+  int i, j;
+  int32_t level, min, max, baseSpan;
+  uint8_t thresholdBin, degraded;
+  RefAutoCalibT *data;
+
+  degraded = 0;
+  for(i=0;i<REF_NOF_SENSORS;i++) {
+    data = &refAutoCalib[i];
+    if (REF_AutoCalibIsShift(data)) {
+      for(j=0;j<REF_AC_NOF_BINS;j++) {
+        data->bins[j] = (uint16_t)(data->bins[j]/2+data->outlierBins[j]);
+      }
+      data->nofOutliers = 0; /* accepted, not a sign of a degraded sensor */
+    }
+    for(j=0;j<REF_AC_NOF_BINS;j++) {
+      data->outlierBins[j] = 0;
+    }
+    min = SensorCalibMinMax.minVal[i];
+    max = SensorCalibMinMax.maxVal[i];
+    thresholdBin = REF_AutoCalibBin((min+max)/2); /* bin with the threshold is ambiguous and not used */
+    if (REF_AutoCalibFindPeak(data, 0, thresholdBin, &level)) { /* white peak */
+      min += (level-min)/REF_AC_ADAPT_DIV;
+    }
+    if (REF_AutoCalibFindPeak(data, thresholdBin+1, REF_AC_NOF_BINS, &level)) { /* black peak */
+      max += (level-max)/REF_AC_ADAPT_DIV;
+    }
+    if (min<max) { /* only accept consistent values */
+      SensorCalibMinMax.minVal[i] = (SensorTimeType)min;
+      SensorCalibMinMax.maxVal[i] = (SensorTimeType)max;
+    }
+    baseSpan = (int32_t)SensorCalibBase.maxVal[i]-SensorCalibBase.minVal[i];
+    if (   (int32_t)SensorCalibMinMax.maxVal[i]-SensorCalibMinMax.minVal[i] < baseSpan/REF_AC_DEGRADED_SPAN_DIV
+        || (uint32_t)data->nofOutliers*100 > (uint32_t)data->nofSamples*REF_AC_DEGRADED_OUTLIER_PERCENT
+       )
+    {
+      degraded |= (1<<i);
+    }
+    data->nofSamples = 0;
+    data->nofOutliers = 0;
+  } /* for */
+  if (degraded & ~refDegradedMask) {
+    SHELL_SendString((unsigned char*)"WARNING: reflectance sensor degraded, recalibration recommended.\r\n");
+  }
+  refDegradedMask = degraded;
+}
+
+/*!
+ * \brief Adds the raw values of a measurement to the histograms, outliers are kept apart until the evaluation.
+ * \param raw Raw sensor values.
+ */
+static void REF_AutoCalibSample(const SensorTimeType raw[REF_NOF_SENSORS]) {
+  int i, j;
+  int32_t margin, val;
+  uint8_t bin;
+  RefAutoCalibT *data;
+
+  for(i=0;i<REF_NOF_SENSORS;i++) {
+    if (SensorTimeoutMask&(1<<i)) {
+      val = REF_AC_MAX_TICKS; /* no discharge within the timeout: saturated black */
+    } else {
+      val = raw[i];
+    }
+    data = &refAutoCalib[i];
+    data->nofSamples++;
+    margin = ((int32_t)SensorCalibMinMax.maxVal[i]-SensorCalibMinMax.minVal[i])/REF_AC_OUTLIER_DIV;
+    bin = REF_AutoCalibBin(val);
+    if (   val < (int32_t)SensorCalibMinMax.minVal[i]-margin
+        || val > (int32_t)SensorCalibMinMax.maxVal[i]+margin
+       )
+    {
+      data->nofOutliers++;
+      data->outlierBins[bin]++;
+      continue;
+    }
+    data->bins[bin]++;
+    if (data->bins[bin]>=REF_AC_DECAY_LIMIT) { /* forget old samples */
+      for(j=0;j<REF_AC_NOF_BINS;j++) {
+        data->bins[j] /= 2;
+      }
+    }
+  } /* for */
+  refAutoCalibCntr++;
+  if (refAutoCalibCntr>=REF_AC_EVAL_PERIOD) {
+    refAutoCalibCntr = 0;
+    REF_AutoCalibEvaluate();
+  }
+}
+
+uint8_t REF_GetDegradedSensors(void) {
+  return refDegradedMask;
+}
+#endif /* REF_AUTO_CALIB */
+
 /*
  * Operates the same as read calibrated, but also returns an
  * estimated position of the robot with respect to a line. The
@@ -280,6 +531,9 @@ static int ReadLine(SensorTimeType calib[REF_NOF_SENSORS], SensorTimeType raw[RE
     }
     mul += 1000;
   }
+  if (sum==0) { /* all sensors below the noise level: no line */
+    return 0;
+  }
   return avg/sum;
 }
 
@@ -363,6 +617,11 @@ REF_LineKind REF_GetLineKind(void) {
 
 static void REF_Measure(void) {
   ReadCalibrated(SensorCalibrated, SensorRaw);
+#if REF_AUTO_CALIB
+  if (refAutoCalibOn) {
+    REF_AutoCalibSample(SensorRaw);
+  }
+#endif
   refCenterLineVal = ReadLine(SensorCalibrated, SensorRaw, REF_USE_WHITE_LINE);
 #if 1 || PL_CONFIG_HAS_LINE_FOLLOW
   refLineKind = ReadLineKind(SensorCalibrated);
@@ -374,6 +633,9 @@ static uint8_t PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
 #if REF_START_STOP_CALIB
   CLS1_SendHelpStr((unsigned char*)"  calib (start|stop)", (unsigned char*)"Start/Stop calibrating while moving sensor over line\r\n", io->stdOut);
+#endif
+#if REF_AUTO_CALIB
+  CLS1_SendHelpStr((unsigned char*)"  autocalib (on|off)", (unsigned char*)"Turn continuous calibration while driving on or off\r\n", io->stdOut);
 #endif
   return ERR_OK;
 }
@@ -481,6 +743,23 @@ static uint8_t PrintStatus(const CLS1_StdIOType *io) {
   CLS1_SendStatusStr((unsigned char*)"  line kind", REF_LineKindStr(refLineKind), io->stdOut);
   CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
 #endif
+
+#if REF_AUTO_CALIB
+  CLS1_SendStatusStr((unsigned char*)"  auto calib", refAutoCalibOn?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  degraded", (unsigned char*)"", io->stdOut);
+  if (refDegradedMask==0) {
+    CLS1_SendStr((unsigned char*)"none", io->stdOut);
+  } else {
+    for (i=0;i<REF_NOF_SENSORS;i++) {
+      if (refDegradedMask&(1<<i)) {
+        buf[0] = '\0'; UTIL1_strcatNum8u(buf, sizeof(buf), i+1);
+        UTIL1_chcat(buf, sizeof(buf), ' ');
+        CLS1_SendStr(buf, io->stdOut);
+      }
+    }
+  }
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+#endif
 return ERR_OK;
 }
 
@@ -510,6 +789,19 @@ byte REF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOT
     }
     *handled = TRUE;
     return ERR_OK;
+#endif
+#if REF_AUTO_CALIB
+  } else if (UTIL1_strcmp((char*)cmd, "ref autocalib on")==0) {
+    if (!refAutoCalibOn) {
+      REF_AutoCalibReset();
+      refAutoCalibOn = TRUE;
+    }
+    *handled = TRUE;
+    return ERR_OK;
+  } else if (UTIL1_strcmp((char*)cmd, "ref autocalib off")==0) {
+    refAutoCalibOn = FALSE;
+    *handled = TRUE;
+    return ERR_OK;
 #endif
   }
   return ERR_OK;
@@ -527,6 +819,10 @@ static void REF_StateMachine(void) {
       ptr = (SensorCalibT*)NVMC_GetReflectanceData();
       if (ptr!=NULL) { /* valid data */
         SensorCalibMinMax = *ptr; /* struct copy */
+#if REF_AUTO_CALIB
+        SensorCalibBase = SensorCalibMinMax; /* struct copy */
+        REF_AutoCalibReset();
+#endif
         refState = REF_STATE_READY;
       } else {
         refState = REF_STATE_NOT_CALIBRATED;
@@ -578,6 +874,10 @@ static void REF_StateMachine(void) {
       } else {
         SHELL_SendString((unsigned char*)"Stored calibration data.\r\n");
       }
+#endif
+#if REF_AUTO_CALIB
+      SensorCalibBase = SensorCalibMinMax; /* struct copy */
+      REF_AutoCalibReset();
 #endif
       refState = REF_STATE_READY;
       break;
@@ -593,17 +893,61 @@ static void REF_StateMachine(void) {
   } /* switch */
 }
 
+void REF_SetCalibration(const uint16_t *minVals, const uint16_t *maxVals, int nofValues) {
+  int i;
+
+  for(i=0;i<nofValues && i<REF_NOF_SENSORS;i++) {
+    SensorCalibMinMax.minVal[i] = minVals[i];
+    SensorCalibMinMax.maxVal[i] = maxVals[i];
+  }
+#if REF_AUTO_CALIB
+  SensorCalibBase = SensorCalibMinMax; /* struct copy */
+  REF_AutoCalibReset();
+#endif
+  refState = REF_STATE_READY;
+}
+
 bool REF_IsReady(void) {
   return refState==REF_STATE_READY;
 }
 
+void REF_Step(void) {
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserBegin(RTRC_EVT_REFL_FRAME);
+#endif
+  REF_StateMachine();
+#if PL_CONFIG_HAS_RECORDER
+  if (refState==REF_STATE_READY) {
+    REC_Sample(); /* record the raw values this measurement has been computed from */
+  }
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserEnd(RTRC_EVT_REFL_FRAME, (uint16_t)refState);
+#endif
+}
+
+#if !PL_CONFIG_HAS_CONTROL_LOOP /* otherwise the control loop runs the frames */
 static void ReflTask (void *pvParameters) {
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
+
   (void)pvParameters; /* not used */
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("Refl", PROF_PERIOD_DELAY, REF_PERIOD_MS);
+#endif
   for(;;) {
-    REF_StateMachine();
-    FRTOS1_vTaskDelay(10/portTICK_PERIOD_MS);
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
+    REF_Step();
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
+    FRTOS1_vTaskDelay(REF_PERIOD_MS/portTICK_PERIOD_MS);
   }
 }
+#endif
 
 void REF_Deinit(void) {
 }
@@ -628,8 +972,10 @@ void REF_Init(void) {
   timerHandle = RefCnt_Init(NULL);
   /*! \todo You might need to adjust priority or other task settings */
   //Dieser Task muss hohe Prioritt haben, da er nur kurz ausgefhrt wird und wichtig ist
+#if !PL_CONFIG_HAS_CONTROL_LOOP
   if (xTaskCreate(ReflTask, "Refl", 700/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+4, NULL) != pdPASS) {
     for(;;){} /* error */
   }
+#endif
 }
 #endif /* PL_HAS_REFLECTANCE */
@@ -16,6 +16,13 @@
 #define REF_MIDDLE_LINE_VALUE  ((REF_NOF_SENSORS+1)*1000/2)
 #define REF_MAX_LINE_VALUE     ((REF_NOF_SENSORS-1)*1000) /* maximum value for REF_GetLine() */
 
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+  #define REF_PERIOD_MS        CTRL_PERIOD_MS /* a measurement in every cycle of the control loop */
+#else
+  #define REF_PERIOD_MS        (10) /* period of the reflectance task */
+#endif
+
 typedef enum {
   REF_LINE_NONE=0,     /* no line, sensors do not see a line */
   REF_LINE_STRAIGHT=1, /* forward line |, sensors see a line underneath */
@@ -29,6 +36,29 @@ REF_LineKind REF_GetLineKind(void);
 
 void REF_GetSensorValues(uint16_t *values, int nofValues);
 
+/*!
+ * \brief Returns the raw values of the last measurement.
+ * \param values Array for the values, discharge time in timer ticks, IR1 first.
+ * \param nofValues Number of entries in values.
+ */
+void REF_GetRawValues(uint16_t *values, int nofValues);
+
+/*!
+ * \brief Returns the calibration (raw values of white and black).
+ * \param minVals Array for the minimum (white) values.
+ * \param maxVals Array for the maximum (black) values.
+ * \param nofValues Number of entries in the arrays.
+ */
+void REF_GetCalibration(uint16_t *minVals, uint16_t *maxVals, int nofValues);
+
+/*!
+ * \brief Sets the calibration, as if loaded from the NVM, and starts measuring. Used by the replay of recorded runs.
+ * \param minVals Minimum (white) values.
+ * \param maxVals Maximum (black) values.
+ * \param nofValues Number of entries in the arrays.
+ */
+void REF_SetCalibration(const uint16_t *minVals, const uint16_t *maxVals, int nofValues);
+
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
   
@@ -56,12 +86,24 @@ void REF_CalibrateStartStop(void);
  */
 uint16_t REF_GetLineValue(void);
 
+/*!
+ * \brief Returns the sensors flagged as degraded by the continuous calibration.
+ * \return Bit set for each degraded sensor, bit 0 for sensor 1, 0 if all sensors are fine.
+ */
+uint8_t REF_GetDegradedSensors(void);
+
 /*!
  * \brief Determines if the line sensor is calibrated or not
  * \return TRUE if calibrated.
  */
 bool REF_IsReady(void);
 
+/*!
+ * \brief Runs one measurement frame of the sensor state machine. Called by the control loop (ControlLoop.h),
+ * or by the reflectance task if the control loop is disabled.
+ */
+void REF_Step(void);
+
 /*!
  * \brief Driver Deinitialization.
  */
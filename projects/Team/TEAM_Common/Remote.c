@@ -4,6 +4,10 @@
  * \author Erich Styger, erich.styger@hslu.ch
  *
  * Module to handle accelerometer values passed over the Radio.
+ * The joystick is sampled at a high rate. Significant changes are sent immediately without
+ * acknowledge, so stale positions are never retried; at rest only a slow keep-alive is sent.
+ * Each update carries a sequence number: the receiver drops stale or reordered updates and
+ * stops the motors if no update arrives for REMOTE_CONFIG_FAILSAFE_MS.
  */
 
 #include "Platform.h" /* interface to the platform */
@@ -13,6 +17,7 @@
 #include "CLS1.h"
 #include "UTIL1.h"
 #include "Shell.h"
+#include <string.h>
 #if PL_CONFIG_HAS_PID
   #include "PID.h"
 #endif
@@ -51,6 +56,16 @@
 #if PL_CONFIG_HAS_SUMO
   #include "Sumo.h"
 #endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  #include "RadioLink.h"
+#endif
+
+#define REMOTE_CONFIG_SAMPLE_MS      (10)  /* joystick sampling period */
+#define REMOTE_CONFIG_DEADBAND       (5)   /* filtered values closer than this to the mid position are sent as zero */
+#define REMOTE_CONFIG_MIN_DELTA      (3)   /* change against the last sent value which is sent immediately */
+#define REMOTE_CONFIG_MIN_TX_MS      (20)  /* minimum time between two updates */
+#define REMOTE_CONFIG_KEEPALIVE_MS   (250) /* update period if the joystick does not move */
+#define REMOTE_CONFIG_FAILSAFE_MS    (3*REMOTE_CONFIG_KEEPALIVE_MS) /* the receiver stops the motors without updates */
 
 static bool REMOTE_isOn = FALSE;
 static bool REMOTE_isVerbose = FALSE;
@@ -59,6 +74,31 @@ static bool REMOTE_useJoystick = TRUE;
 static uint16_t midPointX, midPointY;
 #endif
 
+#if PL_CONFIG_CONTROL_SENDER && PL_CONFIG_HAS_JOYSTICK
+static struct {
+  int16_t filtX, filtY;  /* filtered position, 4 fractional bits */
+  bool adcStarted;       /* a conversion has been started */
+  int8_t x, y;           /* last sent position */
+  uint8_t seq;           /* sequence number of the next update */
+  TickType_t lastTick;   /* time of the last update */
+  uint32_t nofUpdates;   /* updates sent because of a change */
+  uint32_t nofKeepAlive; /* updates sent as keep-alive */
+} REMOTE_Tx;
+#endif
+
+#if PL_CONFIG_HAS_MOTOR
+static struct {
+  bool haveSeq;          /* a sequence number has been received, otherwise any is accepted */
+  uint8_t seq;           /* last accepted sequence number */
+  bool active;           /* motors are driven by the joystick, the fail safe timeout is armed */
+  TickType_t lastTick;   /* time of the last accepted update */
+  uint32_t nofRx;        /* accepted updates */
+  uint32_t nofStale;     /* dropped stale or reordered updates */
+  uint32_t nofLost;      /* updates missing in the sequence */
+  uint32_t nofFailSafe;  /* motor stops because of missing updates */
+} REMOTE_Rx;
+#endif
+
 #if PL_CONFIG_CONTROL_SENDER
 static int8_t ToSigned8Bit(uint16_t val, bool isX) {
   int32_t tmp;
@@ -110,47 +150,123 @@ static uint8_t REMOTE_GetXY(uint16_t *x, uint16_t *y, int8_t *x8, int8_t *y8) {
   return ERR_OK;
 }
 
+#if PL_CONFIG_HAS_JOYSTICK
+/*!
+ * \brief Reads the result of the previous conversion and starts the next one, so the task does not wait for the ADC.
+ * The values are low pass filtered and a dead-band is applied around the mid position.
+ * \return ERR_OK if a new position is available.
+ */
+static uint8_t REMOTE_SampleXY(int8_t *x8, int8_t *y8) {
+  uint8_t res;
+  uint16_t values[2];
+  int8_t x, y;
+
+  res = ERR_NOTAVAIL;
+  if (REMOTE_Tx.adcStarted) {
+    res = AD1_GetValue16(&values[0]);
+  }
+  REMOTE_Tx.adcStarted = AD1_Measure(FALSE)==ERR_OK;
+  if (res!=ERR_OK) {
+    return res;
+  }
+  /* first order low pass with a time constant of about two sample periods */
+  REMOTE_Tx.filtX += (ToSigned8Bit(values[0], TRUE)*16-REMOTE_Tx.filtX)/2;
+  REMOTE_Tx.filtY += (ToSigned8Bit(values[1], FALSE)*16-REMOTE_Tx.filtY)/2;
+  x = (int8_t)(REMOTE_Tx.filtX/16);
+  y = (int8_t)(REMOTE_Tx.filtY/16);
+  if (x>-REMOTE_CONFIG_DEADBAND && x<REMOTE_CONFIG_DEADBAND) {
+    x = 0;
+  }
+  if (y>-REMOTE_CONFIG_DEADBAND && y<REMOTE_CONFIG_DEADBAND) {
+    y = 0;
+  }
+  *x8 = x;
+  *y8 = y;
+  return ERR_OK;
+}
+
+/*!
+ * \brief Samples the joystick and sends an update on a significant change or as keep-alive.
+ */
+static void REMOTE_StreamJoystick(void) {
+  uint8_t buf[3];
+  int8_t x8, y8;
+  uint32_t sinceMs, minTxMs;
+  bool changed;
+
+  if (REMOTE_SampleXY(&x8, &y8)!=ERR_OK) {
+    return;
+  }
+  sinceMs = (xTaskGetTickCount()-REMOTE_Tx.lastTick)*portTICK_PERIOD_MS;
+  changed = x8-REMOTE_Tx.x>=REMOTE_CONFIG_MIN_DELTA || REMOTE_Tx.x-x8>=REMOTE_CONFIG_MIN_DELTA
+         || y8-REMOTE_Tx.y>=REMOTE_CONFIG_MIN_DELTA || REMOTE_Tx.y-y8>=REMOTE_CONFIG_MIN_DELTA
+         || (x8==0 && y8==0 && (REMOTE_Tx.x!=0 || REMOTE_Tx.y!=0)); /* stop is always significant */
+  minTxMs = REMOTE_CONFIG_MIN_TX_MS;
+#if PL_CONFIG_HAS_RADIO_LINK
+  if (RLINK_GetPeriodMs(RNETA_GetDestAddr())/4>minTxMs) {
+    minTxMs = RLINK_GetPeriodMs(RNETA_GetDestAddr())/4; /* less air time on a poor link */
+  }
+#endif
+  if (!(changed && sinceMs>=minTxMs) && sinceMs<REMOTE_CONFIG_KEEPALIVE_MS) {
+    return;
+  }
+  buf[0] = (uint8_t)x8;
+  buf[1] = (uint8_t)y8;
+  buf[2] = REMOTE_Tx.seq++;
+  REMOTE_Tx.x = x8;
+  REMOTE_Tx.y = y8;
+  REMOTE_Tx.lastTick = xTaskGetTickCount();
+  if (REMOTE_isVerbose) {
+    uint8_t txtBuf[48];
+
+    UTIL1_strcpy(txtBuf, sizeof(txtBuf), (unsigned char*)"TX: x: ");
+    UTIL1_strcatNum8s(txtBuf, sizeof(txtBuf), x8);
+    UTIL1_strcat(txtBuf, sizeof(txtBuf), (unsigned char*)" y: ");
+    UTIL1_strcatNum8s(txtBuf, sizeof(txtBuf), y8);
+    UTIL1_strcat(txtBuf, sizeof(txtBuf), (unsigned char*)" to addr 0x");
+  #if RNWK_SHORT_ADDR_SIZE==1
+    UTIL1_strcatNum8Hex(txtBuf, sizeof(txtBuf), RNETA_GetDestAddr());
+  #else
+    UTIL1_strcatNum16Hex(txtBuf, sizeof(txtBuf), RNETA_GetDestAddr());
+  #endif
+    UTIL1_strcat(txtBuf, sizeof(txtBuf), (unsigned char*)"\r\n");
+    SHELL_SendString(txtBuf);
+  }
+  if (changed) { /* no acknowledge: a newer update is better than a retry */
+    REMOTE_Tx.nofUpdates++;
+    (void)RAPP_SendPayloadDataBlock(buf, sizeof(buf), RAPP_MSG_TYPE_JOYSTICK_XY, RNETA_GetDestAddr(), RPHY_PACKET_FLAGS_NONE);
+  } else {
+    REMOTE_Tx.nofKeepAlive++;
+#if PL_CONFIG_HAS_RADIO_LINK
+    (void)RLINK_SendPeriodic(buf, sizeof(buf), RAPP_MSG_TYPE_JOYSTICK_XY, RNETA_GetDestAddr()); /* probes the link with acknowledges */
+#else
+    (void)RAPP_SendPayloadDataBlock(buf, sizeof(buf), RAPP_MSG_TYPE_JOYSTICK_XY, RNETA_GetDestAddr(), RPHY_PACKET_FLAGS_NONE);
+#endif
+  }
+  LED1_Neg();
+}
+#endif
+
 static void RemoteTask (void *pvParameters) {
+  TickType_t xLastWakeTime;
+
   (void)pvParameters;
 #if PL_CONFIG_HAS_JOYSTICK
   (void)REMOTE_GetXY(&midPointX, &midPointY, NULL, NULL);
 #endif
   FRTOS1_vTaskDelay(1000/portTICK_PERIOD_MS);
+  xLastWakeTime = xTaskGetTickCount();
   for(;;) {
     if (REMOTE_isOn) {
 #if PL_CONFIG_HAS_JOYSTICK
       if (REMOTE_useJoystick) {
-        uint8_t buf[2];
-        int16_t x, y;
-        int8_t x8, y8;
-
-        /* send periodically messages */
-        REMOTE_GetXY(&x, &y, &x8, &y8);
-        buf[0] = x8;
-        buf[1] = y8;
-        if (REMOTE_isVerbose) {
-          uint8_t txtBuf[48];
-
-          UTIL1_strcpy(txtBuf, sizeof(txtBuf), (unsigned char*)"TX: x: ");
-          UTIL1_strcatNum8s(txtBuf, sizeof(txtBuf), x8);
-          UTIL1_strcat(txtBuf, sizeof(txtBuf), (unsigned char*)" y: ");
-          UTIL1_strcatNum8s(txtBuf, sizeof(txtBuf), y8);
-          UTIL1_strcat(txtBuf, sizeof(txtBuf), (unsigned char*)" to addr 0x");
-    #if RNWK_SHORT_ADDR_SIZE==1
-          UTIL1_strcatNum8Hex(txtBuf, sizeof(txtBuf), RNETA_GetDestAddr());
-    #else
-          UTIL1_strcatNum16Hex(txtBuf, sizeof(txtBuf), RNETA_GetDestAddr());
-    #endif
-          UTIL1_strcat(txtBuf, sizeof(txtBuf), (unsigned char*)"\r\n");
-          SHELL_SendString(txtBuf);
-        }
-        (void)RAPP_SendPayloadDataBlock(buf, sizeof(buf), RAPP_MSG_TYPE_JOYSTICK_XY, RNETA_GetDestAddr(), RPHY_PACKET_FLAGS_REQ_ACK);
-        LED1_Neg();
+        REMOTE_StreamJoystick();
       }
 #endif
-      FRTOS1_vTaskDelay(200/portTICK_PERIOD_MS);
+      FRTOS1_vTaskDelayUntil(&xLastWakeTime, REMOTE_CONFIG_SAMPLE_MS/portTICK_PERIOD_MS);
     } else {
       FRTOS1_vTaskDelay(1000/portTICK_PERIOD_MS);
+      xLastWakeTime = xTaskGetTickCount();
     }
   } /* for */
 }
@@ -254,12 +370,25 @@ uint8_t REMOTE_HandleRemoteRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *
   (void)packet;
   switch(type) {
 #if PL_CONFIG_HAS_MOTOR
-    case RAPP_MSG_TYPE_JOYSTICK_XY: /* values are -128...127 */
+    case RAPP_MSG_TYPE_JOYSTICK_XY: /* x8:y8 or x8:y8:seq8, values are -128...127 */
       {
         int8_t x, y;
         int16_t x1000, y1000;
 
         *handled = TRUE;
+        if (size>=3) { /* with sequence number */
+          if (REMOTE_Rx.haveSeq && (int8_t)(data[2]-REMOTE_Rx.seq)<=0) {
+            REMOTE_Rx.nofStale++; /* duplicate or overtaken by a newer update */
+            break;
+          }
+          if (REMOTE_Rx.haveSeq) {
+            REMOTE_Rx.nofLost += (uint8_t)(data[2]-REMOTE_Rx.seq-1);
+          }
+          REMOTE_Rx.seq = data[2];
+          REMOTE_Rx.haveSeq = TRUE;
+        }
+        REMOTE_Rx.nofRx++;
+        REMOTE_Rx.lastTick = xTaskGetTickCount();
         x = *data; /* get x data value */
         y = *(data+1); /* get y data value */
         if (REMOTE_isVerbose) {
@@ -289,6 +418,7 @@ uint8_t REMOTE_HandleRemoteRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *
         y1000 = scaleJoystickTo1K(y);
         if (REMOTE_useJoystick) {
           REMOTE_HandleMotorMsg(y1000, x1000, 0); /* first param is forward/backward speed, second param is direction */
+          REMOTE_Rx.active = REMOTE_isOn;
         }
       }
       break;
@@ -404,6 +534,34 @@ static void REMOTE_PrintStatus(const CLS1_StdIOType *io) {
 #if PL_CONFIG_HAS_JOYSTICK
   StatusPrintXY(io);
 #endif
+#if PL_CONFIG_CONTROL_SENDER && PL_CONFIG_HAS_JOYSTICK
+  {
+    uint8_t buf[48];
+
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"updates ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), REMOTE_Tx.nofUpdates);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", keep-alive ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), REMOTE_Tx.nofKeepAlive);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  tx", buf, io->stdOut);
+  }
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  {
+    uint8_t buf[64];
+
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"accepted ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), REMOTE_Rx.nofRx);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", stale ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), REMOTE_Rx.nofStale);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", lost ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), REMOTE_Rx.nofLost);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", fail safe ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), REMOTE_Rx.nofFailSafe);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  rx", buf, io->stdOut);
+  }
+#endif
 }
 
 uint8_t REMOTE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
@@ -449,6 +607,19 @@ void REMOTE_SetOnOff(bool on) {
   REMOTE_isOn = on;
 }
 
+void REMOTE_Process(void) {
+#if PL_CONFIG_HAS_MOTOR
+  if (REMOTE_Rx.active && (xTaskGetTickCount()-REMOTE_Rx.lastTick)*portTICK_PERIOD_MS>REMOTE_CONFIG_FAILSAFE_MS) {
+    REMOTE_Rx.active = FALSE;
+    REMOTE_Rx.haveSeq = FALSE; /* the sender might have restarted: accept any sequence number */
+    REMOTE_Rx.nofFailSafe++;
+    if (REMOTE_useJoystick) {
+      REMOTE_HandleMotorMsg(0, 0, 0); /* stop */
+    }
+  }
+#endif
+}
+
 void REMOTE_Deinit(void) {
   /* nothing to do */
 }
@@ -458,6 +629,12 @@ void REMOTE_Init(void) {
   REMOTE_isOn = TRUE;
   REMOTE_isVerbose = FALSE;
   REMOTE_useJoystick = TRUE;
+#if PL_CONFIG_CONTROL_SENDER && PL_CONFIG_HAS_JOYSTICK
+  (void)memset(&REMOTE_Tx, 0, sizeof(REMOTE_Tx));
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  (void)memset(&REMOTE_Rx, 0, sizeof(REMOTE_Rx));
+#endif
 #if PL_CONFIG_CONTROL_SENDER
   if (FRTOS1_xTaskCreate(RemoteTask, "Remote", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL) != pdPASS) {
     for(;;){} /* error */
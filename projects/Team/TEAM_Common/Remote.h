@@ -37,6 +37,11 @@ void REMOTE_SetOnOff(bool on);
  */
 uint8_t REMOTE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
 
+/*!
+ * \brief Called periodically from the radio task: stops the motors if no joystick update has been received in time.
+ */
+void REMOTE_Process(void);
+
 /*! \brief De-initialization of the module */
 void REMOTE_Deinit(void);
 
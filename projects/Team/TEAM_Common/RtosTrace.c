@@ -0,0 +1,411 @@
+/**
+ * \file
+ * \brief Streaming RTOS trace implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The records are written into a ring buffer by tasks and interrupts (inside a short critical section,
+ * so any interrupt priority can record), and read by the trace task, which writes them in chunks into
+ * the RTT up buffer in no-block-skip mode: if the host does not read fast enough, the records stay in the ring
+ * buffer, and once that is full new records are dropped. The first record after a gap is a RTRC_REC_DROPPED,
+ * so the host sees where and how many records are missing. The overhead is therefore bounded by the ring
+ * buffer and the rate of the events, and the application never waits for the debug probe.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_RTOS_TRACE
+#include "RtosTrace.h"
+#include "FRTOS1.h"
+#include "CS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if RTRC_CONFIG_HOST
+  #include <stdio.h>
+#else
+  #include "SEGGER_RTT.h"
+#endif
+
+#if !RTRC_CONFIG_HOST /* on the host, SimRtos.c calls RTRC_OnTaskSwitchedIn() */
+  #ifndef RTOSTRACEHOOKS_H_
+    #error "task switches are not traced: include RtosTraceHooks.h with the C compiler option -include"
+  #endif
+  #if configUSE_TRACE_HOOKS || configUSE_SEGGER_SYSTEM_VIEWER_HOOKS
+    #error "RtosTrace uses the same FreeRTOS hooks: disable the Percepio and SystemView hooks in the FRTOS1 component"
+  #endif
+  #if !configUSE_TRACE_FACILITY
+    #error "RtosTrace needs configUSE_TRACE_FACILITY for the task numbers"
+  #endif
+#endif
+
+#ifndef RTRC_CONFIG_GET_TIME
+  /* Cortex-M4 DWT cycle counter, as used by the profiler */
+  #define RTRC_DEMCR              (*((volatile uint32_t*)0xE000EDFC)) /* debug exception and monitor control register */
+  #define RTRC_DEMCR_TRCENA       (1UL<<24) /* enable DWT */
+  #define RTRC_DWT_CTRL           (*((volatile uint32_t*)0xE0001000)) /* DWT control register */
+  #define RTRC_DWT_CYCCNTENA      (1UL<<0)  /* enable cycle counter */
+  #define RTRC_DWT_CYCCNT         (*((volatile uint32_t*)0xE0001004)) /* DWT cycle counter */
+  #define RTRC_CONFIG_GET_TIME()  (RTRC_DWT_CYCCNT)
+  #define RTRC_CONFIG_TIME_HZ     (configCPU_CLOCK_HZ)
+#endif
+
+#define RTRC_DRAIN_MS           (5)   /* period of the trace task */
+#define RTRC_NAME_TIMEOUT_MS    (200) /* time to wait for the host to read the names */
+#define RTRC_MAX_NAME_LEN       (15)  /* longer names are cut */
+#define RTRC_MAX_TASKS          (16)  /* tasks which get a name */
+#if !RTRC_CONFIG_HOST
+  #define RTRC_RTT_BUF_SIZE     (1024) /* RTT up buffer, 128 records */
+#endif
+
+static const char *const RTRC_EventNames[RTRC_EVT_NOF] = {"Refl", "DrivePID", "LineDecision", "ToFRead", "Radio"};
+static const char *const RTRC_IsrNames[RTRC_ISR_NOF] = {"QuadInt", "TI1"};
+static const uint8_t RTRC_IsrDivider[RTRC_ISR_NOF] = {RTRC_CONFIG_QUAD_ISR_DIVIDER, 1};
+
+static RTRC_Record RTRC_Ring[RTRC_CONFIG_NOF_RECORDS];
+static volatile uint16_t RTRC_Head, RTRC_Tail; /* next record to write and to read */
+static volatile bool RTRC_Enabled = FALSE;
+static volatile bool RTRC_StartRequest = FALSE, RTRC_StopRequest = FALSE;
+static uint16_t RTRC_NofDropped;  /* dropped since the last successful record */
+static uint8_t RTRC_IsrCount[RTRC_ISR_NOF]; /* 0: the current interrupt is recorded */
+static uint32_t RTRC_TotalSent, RTRC_TotalDropped;
+static uint16_t RTRC_MaxUsed;     /* high-water mark of the ring buffer */
+#if RTRC_CONFIG_HOST
+  static const char *RTRC_HostFileName = NULL;
+  static FILE *RTRC_HostFile = NULL;
+#else
+  static char RTRC_RttBuf[RTRC_RTT_BUF_SIZE];
+#endif
+static TaskStatus_t RTRC_Tasks[RTRC_MAX_TASKS];
+
+static void RTRC_Put(uint8_t type, uint8_t id, uint16_t arg) {
+  uint16_t head, used;
+  RTRC_Record *r;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  head = RTRC_Head;
+  used = (uint16_t)((head+RTRC_CONFIG_NOF_RECORDS-RTRC_Tail)%RTRC_CONFIG_NOF_RECORDS);
+  if (used+(RTRC_NofDropped!=0 ? 2 : 1)>=RTRC_CONFIG_NOF_RECORDS) { /* one entry stays free */
+    if (RTRC_NofDropped<0xffff) {
+      RTRC_NofDropped++;
+    }
+    RTRC_TotalDropped++;
+    CS1_ExitCritical();
+    return;
+  }
+  if (RTRC_NofDropped!=0) { /* mark the gap */
+    r = &RTRC_Ring[head];
+    r->time = RTRC_CONFIG_GET_TIME();
+    r->type = RTRC_REC_DROPPED;
+    r->id = 0;
+    r->arg = RTRC_NofDropped;
+    RTRC_NofDropped = 0;
+    head = (uint16_t)((head+1)%RTRC_CONFIG_NOF_RECORDS);
+    used++;
+  }
+  r = &RTRC_Ring[head];
+  r->time = RTRC_CONFIG_GET_TIME();
+  r->type = type;
+  r->id = id;
+  r->arg = arg;
+  RTRC_Head = (uint16_t)((head+1)%RTRC_CONFIG_NOF_RECORDS);
+  if (used+1>RTRC_MaxUsed) {
+    RTRC_MaxUsed = (uint16_t)(used+1);
+  }
+  CS1_ExitCritical();
+}
+
+void RTRC_UserBegin(RTRC_Event evt) {
+  if (RTRC_Enabled) {
+    RTRC_Put(RTRC_REC_USER_BEGIN, (uint8_t)evt, 0);
+  }
+}
+
+void RTRC_UserEnd(RTRC_Event evt, uint16_t arg) {
+  if (RTRC_Enabled) {
+    RTRC_Put(RTRC_REC_USER_END, (uint8_t)evt, arg);
+  }
+}
+
+void RTRC_UserMark(RTRC_Event evt, uint16_t arg) {
+  if (RTRC_Enabled) {
+    RTRC_Put(RTRC_REC_USER_MARK, (uint8_t)evt, arg);
+  }
+}
+
+void RTRC_IsrEnter(RTRC_Isr isr) {
+  if (!RTRC_Enabled) {
+    return;
+  }
+  RTRC_IsrCount[isr]++;
+  if (RTRC_IsrCount[isr]>=RTRC_IsrDivider[isr]) {
+    RTRC_IsrCount[isr] = 0;
+    RTRC_Put(RTRC_REC_ISR_ENTER, (uint8_t)isr, RTRC_IsrDivider[isr]);
+  }
+}
+
+void RTRC_IsrExit(RTRC_Isr isr) {
+  if (RTRC_Enabled && RTRC_IsrCount[isr]==0) {
+    RTRC_Put(RTRC_REC_ISR_EXIT, (uint8_t)isr, RTRC_IsrDivider[isr]);
+  }
+}
+
+void RTRC_OnTick(void) {
+  if (RTRC_Enabled) {
+    RTRC_Put(RTRC_REC_TICK, 0, (uint16_t)xTaskGetTickCountFromISR());
+  }
+}
+
+void RTRC_OnTaskSwitchedIn(uint8_t taskNumber) {
+  if (RTRC_Enabled) {
+    RTRC_Put(RTRC_REC_TASK, taskNumber, 0);
+  }
+}
+
+/* writes all or nothing of the data into the stream */
+static bool RTRC_Write(const void *data, unsigned size) {
+#if RTRC_CONFIG_HOST
+  if (RTRC_HostFile==NULL) {
+    return TRUE; /* no file: discard */
+  }
+  return fwrite(data, 1, size, RTRC_HostFile)==size;
+#else
+  return SEGGER_RTT_Write(RTRC_CONFIG_RTT_CHANNEL, data, size)==size;
+#endif
+}
+
+/* writes the data, waits for the host to read the stream */
+static bool RTRC_WriteWait(const void *data, unsigned size) {
+  TickType_t start = xTaskGetTickCount();
+
+  while (!RTRC_Write(data, size)) {
+    if (xTaskGetTickCount()-start>=pdMS_TO_TICKS(RTRC_NAME_TIMEOUT_MS)) {
+      return FALSE;
+    }
+    vTaskDelay(1);
+  }
+  return TRUE;
+}
+
+static bool RTRC_SendName(uint8_t kind, uint8_t id, const char *name) {
+  RTRC_Record recs[1+(RTRC_MAX_NAME_LEN+sizeof(RTRC_Record))/sizeof(RTRC_Record)];
+  uint8_t *p = (uint8_t*)&recs[1];
+  unsigned len = 0;
+
+  while (name[len]!='\0' && len<RTRC_MAX_NAME_LEN) {
+    p[len] = (uint8_t)name[len];
+    len++;
+  }
+  recs[0].time = RTRC_CONFIG_GET_TIME();
+  recs[0].type = RTRC_REC_NAME;
+  recs[0].id = id;
+  recs[0].arg = (uint16_t)((kind<<8)|len);
+  while (len%sizeof(RTRC_Record)!=0) {
+    p[len++] = 0; /* pad to a full record */
+  }
+  return RTRC_WriteWait(recs, (unsigned)(sizeof(RTRC_Record)+len));
+}
+
+/* sends the header and the names, numbers the tasks for the task switch records */
+static bool RTRC_SendNames(void) {
+  RTRC_Record header;
+  UBaseType_t nofTasks, i;
+
+  header.time = RTRC_CONFIG_TIME_HZ;
+  header.type = RTRC_REC_HEADER;
+  header.id = RTRC_FORMAT_VERSION;
+  header.arg = RTRC_HEADER_MAGIC;
+  if (!RTRC_WriteWait(&header, sizeof(header))) {
+    return FALSE;
+  }
+  for(i=0;i<RTRC_EVT_NOF;i++) {
+    if (!RTRC_SendName(RTRC_NAME_EVENT, (uint8_t)i, RTRC_EventNames[i])) {
+      return FALSE;
+    }
+  }
+  for(i=0;i<RTRC_ISR_NOF;i++) {
+    if (!RTRC_SendName(RTRC_NAME_ISR, (uint8_t)i, RTRC_IsrNames[i])) {
+      return FALSE;
+    }
+  }
+  nofTasks = 0;
+  if (uxTaskGetNumberOfTasks()<=RTRC_MAX_TASKS) { /* else uxTaskGetSystemState() returns nothing */
+    nofTasks = uxTaskGetSystemState(RTRC_Tasks, RTRC_MAX_TASKS, NULL);
+  }
+  for(i=0;i<nofTasks;i++) {
+    vTaskSetTaskNumber(RTRC_Tasks[i].xHandle, i+1); /* 0: task created after the start of the trace */
+    if (!RTRC_SendName(RTRC_NAME_TASK, (uint8_t)(i+1), RTRC_Tasks[i].pcTaskName)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/* moves the records from the ring buffer into the stream, as long as there is space */
+static void RTRC_Drain(void) {
+  uint16_t head, tail, n;
+
+  for(;;) {
+    head = RTRC_Head;
+    tail = RTRC_Tail;
+    if (head==tail) {
+      return;
+    }
+    n = (uint16_t)(head>tail ? head-tail : RTRC_CONFIG_NOF_RECORDS-tail); /* contiguous part */
+    if (!RTRC_Write(&RTRC_Ring[tail], n*sizeof(RTRC_Record))) {
+      if (n==1 || !RTRC_Write(&RTRC_Ring[tail], sizeof(RTRC_Record))) {
+        return; /* stream full: try again later */
+      }
+      n = 1;
+    }
+    RTRC_Tail = (uint16_t)((tail+n)%RTRC_CONFIG_NOF_RECORDS);
+    RTRC_TotalSent += n;
+  }
+}
+
+static void RTRC_OpenStream(void) {
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  RTRC_Head = RTRC_Tail = 0;
+  RTRC_NofDropped = 0;
+  RTRC_TotalSent = RTRC_TotalDropped = 0;
+  RTRC_MaxUsed = 0;
+  CS1_ExitCritical();
+#if RTRC_CONFIG_HOST
+  if (RTRC_HostFile==NULL && RTRC_HostFileName!=NULL) {
+    RTRC_HostFile = fopen(RTRC_HostFileName, "wb");
+  }
+#endif
+  (void)RTRC_SendNames(); /* without the names the host shows the numbers */
+}
+
+static void RTRC_CloseStream(void) {
+  RTRC_Drain();
+#if RTRC_CONFIG_HOST
+  if (RTRC_HostFile!=NULL) {
+    (void)fclose(RTRC_HostFile);
+    RTRC_HostFile = NULL;
+  }
+#endif
+}
+
+static void RtrcTask(void *pvParameters) {
+  (void)pvParameters; /* not used */
+  for(;;) {
+    if (RTRC_StartRequest) {
+      RTRC_StartRequest = FALSE;
+      RTRC_OpenStream();
+      RTRC_Enabled = TRUE;
+    }
+    RTRC_Drain();
+    if (RTRC_StopRequest) {
+      RTRC_StopRequest = FALSE;
+      RTRC_CloseStream();
+    }
+    vTaskDelay(pdMS_TO_TICKS(RTRC_DRAIN_MS));
+  }
+}
+
+void RTRC_Start(void) {
+  RTRC_Enabled = FALSE; /* restart: the names come first */
+  RTRC_StopRequest = FALSE;
+  RTRC_StartRequest = TRUE;
+}
+
+void RTRC_Stop(void) {
+  RTRC_Enabled = FALSE;
+  RTRC_StartRequest = FALSE;
+  RTRC_StopRequest = TRUE;
+}
+
+#if RTRC_CONFIG_HOST
+void RTRC_SetHostFile(const char *fileName) {
+  RTRC_HostFileName = fileName;
+}
+#endif
+
+#if PL_CONFIG_HAS_SHELL
+static void RTRC_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+
+  CLS1_SendStatusStr((unsigned char*)"trace", (unsigned char*)"\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  state", RTRC_Enabled ? (unsigned char*)"running\r\n" : (unsigned char*)"stopped\r\n", io->stdOut);
+#if RTRC_CONFIG_HOST
+  CLS1_SendStatusStr((unsigned char*)"  output", RTRC_HostFileName!=NULL ? (unsigned char*)RTRC_HostFileName : (unsigned char*)"none", io->stdOut);
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+#else
+  buf[0] = '\0';
+  UTIL1_strcatNum8u(buf, sizeof(buf), RTRC_CONFIG_RTT_CHANNEL);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  RTT channel", buf, io->stdOut);
+#endif
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), RTRC_TotalSent);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" sent, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), RTRC_TotalDropped);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" dropped\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  records", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum16u(buf, sizeof(buf), RTRC_MaxUsed);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" of ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), RTRC_CONFIG_NOF_RECORDS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" records max\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  buffer", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"1/");
+  UTIL1_strcatNum8u(buf, sizeof(buf), RTRC_CONFIG_QUAD_ISR_DIVIDER);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" of the quadrature ISRs\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  sampling", buf, io->stdOut);
+}
+
+static void RTRC_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"trace", (unsigned char*)"Group of RTOS trace commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows trace help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Starts or stops streaming the trace\r\n", io->stdOut);
+}
+
+uint8_t RTRC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"trace help")==0) {
+    RTRC_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"trace status")==0) {
+    RTRC_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"trace start")==0) {
+    RTRC_Start();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"trace stop")==0) {
+    RTRC_Stop();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void RTRC_Deinit(void) {
+  RTRC_Enabled = FALSE;
+  RTRC_CloseStream();
+}
+
+void RTRC_Init(void) {
+#ifdef RTRC_DWT_CYCCNT
+  RTRC_DEMCR |= RTRC_DEMCR_TRCENA; /* enable DWT */
+  RTRC_DWT_CTRL |= RTRC_DWT_CYCCNTENA; /* start cycle counter, not reset: the profiler uses it too */
+#endif
+#if !RTRC_CONFIG_HOST
+  (void)SEGGER_RTT_ConfigUpBuffer(RTRC_CONFIG_RTT_CHANNEL, "Trace", RTRC_RttBuf, sizeof(RTRC_RttBuf), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+  RTRC_Enabled = FALSE;
+  RTRC_StartRequest = RTRC_StopRequest = FALSE;
+  RTRC_Head = RTRC_Tail = 0;
+  if (xTaskCreate(RtrcTask, "Trace", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+1, NULL) != pdPASS) {
+    for(;;){} /* error case only, stay here! */
+  }
+}
+
+#elif defined(RTOSTRACEHOOKS_H_) /* hooks included by the build, but the trace is disabled */
+void RTRC_OnTaskSwitchedIn(unsigned char taskNumber) {
+  (void)taskNumber;
+}
+#endif /* PL_CONFIG_HAS_RTOS_TRACE */
@@ -0,0 +1,140 @@
+/**
+ * \file
+ * \brief Interface of the streaming RTOS trace.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The trace records task switches, interrupts and user events of the control loops as fixed size
+ * records into a RAM ring buffer, and a low priority task streams them over RTT (channel RTRC_CONFIG_RTT_CHANNEL),
+ * or into a file on the host. Recording a record is a few instructions in a critical section and never blocks:
+ * if the ring buffer is full, the record is dropped and counted. The fast quadrature interrupt is only recorded
+ * every RTRC_CONFIG_QUAD_ISR_DIVIDER times. The stream is evaluated on the host with 'sim -a <file>',
+ * on the target it is captured with e.g. JLinkRTTLogger -RTTChannel 2 <file>.
+ *
+ * Stream format: little endian records of 8 bytes (RTRC_Record). It starts with a RTRC_REC_HEADER
+ * and the RTRC_REC_NAME records of the tasks, user events and interrupts, then the events follow.
+ * Task switches need the hooks in RtosTraceHooks.h.
+ */
+
+#ifndef RTOSTRACE_H_
+#define RTOSTRACE_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_RTOS_TRACE
+
+#ifndef RTRC_CONFIG_HOST
+  #define RTRC_CONFIG_HOST              (0)    /*!< 1: built for the host, the stream goes into a file (RTRC_SetHostFile()) */
+#endif
+#ifndef RTRC_CONFIG_NOF_RECORDS
+  #define RTRC_CONFIG_NOF_RECORDS       (256)  /*!< records in the ring buffer, 8 bytes each */
+#endif
+#ifndef RTRC_CONFIG_QUAD_ISR_DIVIDER
+  #define RTRC_CONFIG_QUAD_ISR_DIVIDER  (16)   /*!< record every n-th quadrature interrupt (every 80 us) */
+#endif
+#ifndef RTRC_CONFIG_RTT_CHANNEL
+  #define RTRC_CONFIG_RTT_CHANNEL       (2)    /*!< RTT up channel, 0 is the shell and 1 is kept for SystemView */
+#endif
+
+/*! \brief User events, each one a begin/end pair (or a single mark) in the control loops */
+typedef enum {
+  RTRC_EVT_REFL_FRAME,    /*!< REF_Step(): one measurement frame, end argument is the state */
+  RTRC_EVT_DRIVE_PID,     /*!< DRV_Step(): speed or position PID step, end argument is the mode */
+  RTRC_EVT_LINE_DECISION, /*!< line follow state machine or control step, end argument is the state */
+  RTRC_EVT_TOF_READ,      /*!< ToF task: range of one sensor, end argument is the sensor */
+  RTRC_EVT_RADIO,         /*!< mark: radio event, argument is the RNET1_RadioEvent */
+  RTRC_EVT_NOF            /*!< sentinel, number of user events */
+} RTRC_Event;
+
+/*! \brief Traced interrupts */
+typedef enum {
+  RTRC_ISR_QUAD,          /*!< quadrature sampling timer (QuadInt) */
+  RTRC_ISR_TIMER,         /*!< application timer (TI1) */
+  RTRC_ISR_NOF            /*!< sentinel, number of interrupts */
+} RTRC_Isr;
+
+/* record types of the stream */
+#define RTRC_REC_HEADER      (0) /*!< time is the clock in Hz, id the format version, arg RTRC_HEADER_MAGIC */
+#define RTRC_REC_NAME        (1) /*!< id is the object, arg (kind<<8)|length, followed by the name padded to 8 bytes */
+#define RTRC_REC_TASK        (2) /*!< id is the task number which has been switched in */
+#define RTRC_REC_ISR_ENTER   (3) /*!< id is the RTRC_Isr, arg the divider */
+#define RTRC_REC_ISR_EXIT    (4) /*!< id is the RTRC_Isr, arg the divider */
+#define RTRC_REC_USER_BEGIN  (5) /*!< id is the RTRC_Event */
+#define RTRC_REC_USER_END    (6) /*!< id is the RTRC_Event, arg the value */
+#define RTRC_REC_USER_MARK   (7) /*!< id is the RTRC_Event, arg the value */
+#define RTRC_REC_TICK        (8) /*!< arg is the RTOS tick count (lower 16 bits) */
+#define RTRC_REC_DROPPED     (9) /*!< arg is the number of records dropped before this one */
+
+#define RTRC_NAME_TASK       (0) /*!< name kinds of RTRC_REC_NAME */
+#define RTRC_NAME_EVENT      (1)
+#define RTRC_NAME_ISR        (2)
+
+#define RTRC_FORMAT_VERSION  (1)
+#define RTRC_HEADER_MAGIC    (0x5254) /*!< 'RT' */
+
+/*! \brief Record of the stream */
+typedef struct {
+  uint32_t time; /*!< time stamp in clock cycles (see RTRC_REC_HEADER), wraps around */
+  uint8_t type;  /*!< RTRC_REC_* */
+  uint8_t id;    /*!< task, event or interrupt */
+  uint16_t arg;  /*!< depends on the type */
+} RTRC_Record;
+
+/*! \brief Marks the start of a user event */
+void RTRC_UserBegin(RTRC_Event evt);
+
+/*! \brief Marks the end of a user event, with a value (e.g. a state) */
+void RTRC_UserEnd(RTRC_Event evt, uint16_t arg);
+
+/*! \brief Records a single user event, with a value */
+void RTRC_UserMark(RTRC_Event evt, uint16_t arg);
+
+/*! \brief Called at the start of an interrupt service routine */
+void RTRC_IsrEnter(RTRC_Isr isr);
+
+/*! \brief Called at the end of an interrupt service routine */
+void RTRC_IsrExit(RTRC_Isr isr);
+
+/*! \brief Called from the RTOS tick hook */
+void RTRC_OnTick(void);
+
+/*!
+ * \brief Called by the RTOS when a task gets the CPU, see RtosTraceHooks.h.
+ * \param taskNumber Task number, assigned when the trace starts.
+ */
+void RTRC_OnTaskSwitchedIn(uint8_t taskNumber);
+
+/*! \brief Starts the trace: the names are sent first, then the records */
+void RTRC_Start(void);
+
+/*! \brief Stops the trace */
+void RTRC_Stop(void);
+
+#if RTRC_CONFIG_HOST
+/*!
+ * \brief Sets the file the stream is written to, on the host.
+ * \param fileName Path of the file, it is created when the trace starts.
+ */
+void RTRC_SetHostFile(const char *fileName);
+#endif
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t RTRC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Driver de-initialization */
+void RTRC_Deinit(void);
+
+/*! \brief Driver initialization */
+void RTRC_Init(void);
+
+#endif /* PL_CONFIG_HAS_RTOS_TRACE */
+
+#endif /* RTOSTRACE_H_ */
@@ -0,0 +1,19 @@
+/**
+ * \file
+ * \brief FreeRTOS trace hooks of the streaming RTOS trace (RtosTrace.h).
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The robot project includes this file in front of every C source file (C compiler option 'Include files (-include)'),
+ * so the hooks are defined before FreeRTOS.h provides its empty defaults. The Percepio and SystemView hooks in the
+ * FRTOS1 component use the same hooks and are disabled, RtosTrace.c checks this together with configUSE_TRACE_FACILITY
+ * which is needed for the task numbers. This file is included before any other header: it only uses plain C types.
+ */
+
+#ifndef RTOSTRACEHOOKS_H_
+#define RTOSTRACEHOOKS_H_
+
+extern void RTRC_OnTaskSwitchedIn(unsigned char taskNumber);
+
+#define traceTASK_SWITCHED_IN()   RTRC_OnTaskSwitchedIn((unsigned char)pxCurrentTCB->uxTaskNumber)
+
+#endif /* RTOSTRACEHOOKS_H_ */
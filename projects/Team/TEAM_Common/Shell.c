@@ -32,6 +32,9 @@
 #if PL_CONFIG_HAS_MOTOR
   #include "Motor.h"
 #endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+#endif
 #if PL_CONFIG_HAS_MCP4728
   #include "MCP4728.h"
 #endif
@@ -60,14 +63,35 @@
 #if PL_CONFIG_HAS_SUMO
   #include "Sumo.h"
 #endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  #include "ArenaLoc.h"
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   #include "LineFollow.h"
 #endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  #include "SpeedPlan.h"
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+#endif
 #if PL_CONFIG_HAS_RADIO
   #include "RApp.h"
   #include "RNet_App.h"
   #include "RNetConf.h"
 #endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  #include "RadioLink.h"
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  #include "TimeSync.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
 #if RNET_CONFIG_REMOTE_STDIO
   #include "RStdIO.h"
 #endif
@@ -77,12 +101,33 @@
 #if PL_CONFIG_HAS_LINE_MAZE
   #include "Maze.h"
 #endif
+#if PL_CONFIG_HAS_RECORDER
+  #include "Recorder.h"
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  #include "Obstacle.h"
+#endif
 #if PL_CONFIG_HAS_USB_CDC
   #include "CDC1.h"
 #endif
 #if PL_CONFIG_HAS_BATTERY_ADC
   #include "Battery.h"
 #endif
+#if PL_CONFIG_HAS_LCD
+  #include "LCDDirty.h"
+#endif
+#if PL_CONFIG_HAS_LOW_POWER
+  #include "LowPower.h"
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
+#if PL_CONFIG_HAS_MEM_POOL
+  #include "MemPool.h"
+#endif
 #if PL_HAS_DISTANCE_SENSOR
   #include "Distance.h"
 #endif
@@ -242,6 +287,9 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_MOTOR
   MOT_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  HWP_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_MCP4728
    MCP4728_ParseCommand,
 #endif
@@ -276,26 +324,68 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_SUMO
   SUMO_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  ALOC_ParseCommand,
+#endif
 #if PL_HAS_DISTANCE_SENSOR
   DIST_ParseCommand,
 #endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  SPLAN_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  TMAP_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  CTRL_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_RADIO
 #if RNET1_PARSE_COMMAND_ENABLED
   RNET1_ParseCommand,
 #endif
   RNETA_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  RLINK_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  TSYNC_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  LAPT_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_REMOTE
   REMOTE_ParseCommand,
 #endif
 #if PL_CONFIG_HAS_LINE_MAZE
   MAZE_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_RECORDER
+  REC_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  OBST_ParseCommand,
+#endif
 #if TmDt1_PARSE_COMMAND_ENABLED
   TmDt1_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LCD
+  LCDDIRTY_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  PROF_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_MEM_POOL
+  MPOOL_ParseCommand,
 #endif
   NULL /* Sentinel */
 };
@@ -367,6 +457,9 @@ void SHELL_ParseCmd(uint8_t *cmd) {
 #if PL_CONFIG_HAS_RTOS
 static void ShellTask(void *pvParameters) {
   int i;
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
   /* \todo Extend as needed */
 
   (void)pvParameters; /* not used */
@@ -377,8 +470,14 @@ static void ShellTask(void *pvParameters) {
   SHELL_SendString("Shell task started!\r\n");
 #if CLS1_DEFAULT_SERIAL
   (void)CLS1_ParseWithCommandTable((unsigned char*)CLS1_CMD_HELP, ios[0].stdio, CmdParserTable);
+#endif
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("Shell", PROF_PERIOD_DELAY, 10);
 #endif
   for(;;) {
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
     /* process all I/Os */
     for(i=0;i<sizeof(ios)/sizeof(ios[0]);i++) {
       (void)CLS1_ReadAndParseWithCommandTable(ios[i].buf, ios[i].bufSize, ios[i].stdio, CmdParserTable);
@@ -403,10 +502,13 @@ static void ShellTask(void *pvParameters) {
       msg = SQUEUE_ReceiveMessage();
       if (msg!=NULL) {
         CLS1_SendStr(msg, SHELL_stdio.stdOut);
-        vPortFree((void*)msg);
+        SQUEUE_FreeMessage((unsigned char*)msg);
       }
     }
 #endif /* PL_CONFIG_HAS_SHELL_QUEUE */
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
     vTaskDelay(pdMS_TO_TICKS(10));
   } /* for */
 }
@@ -10,6 +10,10 @@
 #if PL_CONFIG_HAS_SHELL_QUEUE
 #include "ShellQueue.h"
 #include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_MEM_POOL
+  #include "MemPool.h"
+#endif
 
 static xQueueHandle SQUEUE_Queue;
 
@@ -18,7 +22,11 @@ static xQueueHandle SQUEUE_Queue;
   #define SQUEUE_ITEM_SIZE   1  /* each item is a single character */
 #else
   #define SQUEUE_LENGTH      5 /* items in queue */
-  #define SQUEUE_ITEM_SIZE   sizeof(char_t*) /* each item is a char pointer to a string, allocated in the heap */
+  #define SQUEUE_ITEM_SIZE   sizeof(char_t*) /* each item is a char pointer to a string, allocated in a memory pool or the heap */
+#endif
+
+#if !PL_CONFIG_SQUEUE_SINGLE_CHAR
+static uint32_t SQUEUE_nofDropped = 0; /* messages lost because no memory was available */
 #endif
 
 void SQUEUE_SendString(const unsigned char *str) {
@@ -33,14 +41,40 @@ void SQUEUE_SendString(const unsigned char *str) {
 #else
   unsigned char *ptr;
   size_t bufSize;
+#if PL_CONFIG_HAS_MEM_POOL
+  size_t len;
 
+  len = UTIL1_strlen(str);
+  do { /* a message longer than the largest block is sent in several parts */
+    bufSize = len+1;
+    if (bufSize>MPOOL_GetMaxBlockSize()) {
+      bufSize = MPOOL_GetMaxBlockSize();
+    }
+    ptr = MPOOL_Alloc(bufSize);
+    if (ptr==NULL) { /* out of memory: drop the (rest of the) message instead of blocking the sender */
+      SQUEUE_nofDropped++;
+      return;
+    }
+    UTIL1_strcpy(ptr, bufSize, str); /* copies bufSize-1 characters at most */
+    if (xQueueSendToBack(SQUEUE_Queue, &ptr, portMAX_DELAY)!=pdPASS) {
+      for(;;){} /* ups? */
+    }
+    str += bufSize-1;
+    len -= bufSize-1;
+  } while(len>0);
+#else
   bufSize = UTIL1_strlen(str)+1; //Buffer Grsse ist um 1 erhht, da bei jeder Message (String) am Ende ein \0
   ptr = pvPortMalloc(bufSize);	//Alloziert Speicher auf dem Heap in Grsse der Buffer Size
+  if (ptr==NULL) { /* out of memory: drop the message instead of blocking the sender */
+    SQUEUE_nofDropped++;
+    return;
+  }
   UTIL1_strcpy(ptr, bufSize, str); //Inhalt des Strings wird in Pointer geschrieben --> copy the message
   if (xQueueSendToBack(SQUEUE_Queue, &ptr, portMAX_DELAY)!=pdPASS) {
     for(;;){} /* ups? */
   }
 #endif
+#endif
 }
 
 #if PL_CONFIG_SQUEUE_SINGLE_CHAR
@@ -68,6 +102,18 @@ unsigned char *SQUEUE_ReceiveMessage(void) {
     return ptr;
   }
 }
+
+void SQUEUE_FreeMessage(unsigned char *msg) {
+#if PL_CONFIG_HAS_MEM_POOL
+  (void)MPOOL_Free(msg);
+#else
+  vPortFree(msg);
+#endif
+}
+
+uint32_t SQUEUE_GetNofDropped(void) {
+  return SQUEUE_nofDropped;
+}
 #endif /* QUEUE_SINGLE_CHAR */
 
 unsigned short SQUEUE_NofElements(void) {
@@ -31,7 +31,23 @@ unsigned short SQUEUE_NofElements(void);
  */
 unsigned char SQUEUE_ReceiveChar(void);
 #else
+/*!
+ * \brief Receives a message from the queue, and returns immediately if the queue is empty.
+ * \return Message string, or NULL if there was no message. Release it with SQUEUE_FreeMessage().
+ */
 unsigned char *SQUEUE_ReceiveMessage(void);
+
+/*!
+ * \brief Releases a message returned by SQUEUE_ReceiveMessage().
+ * \param msg Message to be released.
+ */
+void SQUEUE_FreeMessage(unsigned char *msg);
+
+/*!
+ * \brief Returns the number of messages dropped because no memory was available.
+ * \return Number of dropped messages.
+ */
+uint32_t SQUEUE_GetNofDropped(void);
 #endif
 
 /*! \brief Initializes the queue module */
@@ -22,6 +22,7 @@
 #include "GDisp1.h"
 #include "FDisp1.h"
 #include "GFONT1.h"
+#include "LCDDirty.h"
 #include "Snake.h"
 #include "UTIL1.h"
 #include "FRTOS1.h"
@@ -29,6 +30,10 @@
 
 #include "LED.h"
 #include "LCD.h"
+#include "KIN1.h"
+#if PL_CONFIG_HAS_BATTERY_ADC
+  #include "Battery.h"
+#endif
 
 /* constants */
 #define UP    1
@@ -36,23 +41,35 @@
 #define DOWN  3
 #define LEFT  4
 
+/* play field: a grid of cells inside a one pixel border */
+#define SNAKE_CELL_SIZE     3  /* cell size in pixels */
+#define SNAKE_GRID_COLS     27 /* (84-2)/SNAKE_CELL_SIZE, for the 84x48 Nokia display */
+#define SNAKE_GRID_ROWS     15 /* (48-2)/SNAKE_CELL_SIZE */
+#define SNAKE_NOF_CELLS     (SNAKE_GRID_COLS*SNAKE_GRID_ROWS)
+
 /* frame size */
 #define MAX_WIDTH  GDisp1_GetWidth()
 #define MAX_HEIGHT GDisp1_GetHeight()
 
 /* defaults */
-//#define SNAKE_LEN   10 /* initial snake len */
-#define SNAKE_LEN   20 /* initial snake len */
-//#define SNAKE_SPEED 20 /* initial delay in ms */
-#define SNAKE_SPEED 50 /* initial delay in ms */
+#define SNAKE_LEN       5   /* initial snake len, in cells */
+#define SNAKE_GROW      2   /* cells the snake grows for each food */
+#define SNAKE_SPEED     150 /* initial delay per step in ms */
+#define SNAKE_MIN_SPEED 20  /* fastest delay per step in ms */
+#define SNAKE_FOOD_TRIES 8  /* random tries for a free food cell before counting the free cells */
+
+#define SNAKE_MAX_LEN   SNAKE_NOF_CELLS /* maximum length of snake: it can fill the whole grid */
+
+/* SysTick current value, used as a source of entropy for the random number generator */
+#define SNAKE_SYST_CVR  (*((volatile uint32_t*)0xE000E018))
 
 /* snake length */
-static int snakeLen = SNAKE_LEN;
+static uint16_t snakeLen = SNAKE_LEN;
+static uint8_t snakeGrow = 0; /* number of steps the tail stays in place */
 static int point    = 0, points = 10;
 static int level    = 0, time   = SNAKE_SPEED;
 
-static GDisp1_PixelDim xSnake,    ySnake; /* snake face */
-static GDisp1_PixelDim xFood = 0, yFood  = 0; /* location of food */
+static uint16_t foodCell; /* cell with the food */
 
 /* directions */
 static int dr = 0, dc = 1;
@@ -65,17 +82,53 @@ static SemaphoreHandle_t xSemaphoreSnakeGame;
 
 static TaskHandle_t xHandleSnakeTask = NULL;
 
+/* ring buffer with the cells of the snake, snakeBody[snakeHead] is the head, snakeBody[snakeTail] the tail */
+static uint16_t snakeBody[SNAKE_MAX_LEN];
+static uint16_t snakeHead, snakeTail;
 
-#define SNAKE_MAX_LEN   48 /* maximum length of snake */
+/* one bit for each cell, set if the snake occupies it. Bits past the last cell are set too. */
+static uint8_t snakeOccupied[(SNAKE_NOF_CELLS+7)/8];
 
-/* vector containing the coordinates of the individual parts */
-/* of the snake {cols[0], row[0]}, corresponding to the head */
-static GDisp1_PixelDim snakeCols[SNAKE_MAX_LEN];
+static uint32_t snakeRandom; /* xorshift32 state, never zero */
+
+static void mixRandom(uint32_t val) {
+  snakeRandom ^= val;
+  snakeRandom *= 0x9E3779B1u; /* spread the bits */
+  if (snakeRandom==0) {
+    snakeRandom = 0x12345678u;
+  }
+}
 
-/* Vector containing the coordinates of the individual parts */
-/* of the snake {cols [snake_lenght], row [snake_lenght]} correspond to the tail */
-static GDisp1_PixelDim snakeRow[SNAKE_MAX_LEN];
+static uint32_t nextRandom(void) {
+  /* Marsaglia xorshift32 */
+  snakeRandom ^= snakeRandom<<13;
+  snakeRandom ^= snakeRandom>>17;
+  snakeRandom ^= snakeRandom<<5;
+  return snakeRandom;
+}
 
+static void seedRandom(void) {
+  KIN1_UID id;
+  unsigned int i;
+  uint32_t hash = 2166136261u; /* FNV-1a over the unique chip ID */
+
+  if (KIN1_UIDGet(&id)==ERR_OK) {
+    for(i=0; i<sizeof(id.id); i++) {
+      hash = (hash^id.id[i])*16777619u;
+    }
+  }
+  mixRandom(hash);
+#if PL_CONFIG_HAS_BATTERY_ADC
+  {
+    uint16_t centiV;
+
+    if (BATT_MeasureBatteryVoltage(&centiV)==ERR_OK) {
+      mixRandom(centiV); /* noise in the lower digits */
+    }
+  }
+#endif
+  mixRandom(SNAKE_SYST_CVR);
+}
 
 static void waitAnyButton(void) {
   /*! \todo Wait for any button pressed */
@@ -90,29 +143,103 @@ static void waitAnyButton(void) {
 		LED1_Neg();
 		vTaskDelay(time/portTICK_RATE_MS); 	//ein Task Delay, damit dieser Task nicht alle CPU Zeit beansprucht
 	}
+	mixRandom(SNAKE_SYST_CVR); /* the moment of the key press is random */
 }
 
 static void delay(int ms) {
   WAIT1_WaitOSms(ms);
 }
 
-static int random(int min, int max) {
-  TickType_t cnt;
-  
-  cnt = xTaskGetTickCount();
-  cnt &= 0xff; /* reduce to 8 bits */
-  if (max>64) {
-    cnt >>= 1;
+static bool isOccupied(uint16_t cell) {
+  return (snakeOccupied[cell/8]&(1<<(cell%8)))!=0;
+}
+
+static void setOccupied(uint16_t cell) {
+  snakeOccupied[cell/8] |= (1<<(cell%8));
+}
+
+static void clrOccupied(uint16_t cell) {
+  snakeOccupied[cell/8] &= ~(1<<(cell%8));
+}
+
+#define SNAKE_CELL_EMPTY  0
+#define SNAKE_CELL_BODY   1
+#define SNAKE_CELL_FOOD   2
+
+static void drawCell(uint16_t cell, uint8_t kind) {
+  GDisp1_PixelDim x, y;
+
+  x = 1+(cell%SNAKE_GRID_COLS)*SNAKE_CELL_SIZE;
+  y = 1+(cell/SNAKE_GRID_COLS)*SNAKE_CELL_SIZE;
+  if (kind==SNAKE_CELL_BODY) {
+    LCDDIRTY_ClearRegion(x, y, SNAKE_CELL_SIZE, SNAKE_CELL_SIZE); /* head might move onto the food */
+    LCDDIRTY_DrawCircle(x+1, y+1, 1, GDisp1_COLOR_BLACK);
+  } else if (kind==SNAKE_CELL_FOOD) {
+    LCDDIRTY_DrawFilledBox(x, y, SNAKE_CELL_SIZE, SNAKE_CELL_SIZE, GDisp1_COLOR_BLACK);
   } else {
-    cnt >>= 2;
+    LCDDIRTY_ClearRegion(x, y, SNAKE_CELL_SIZE, SNAKE_CELL_SIZE);
   }
-  if (cnt<min) {
-    cnt = min;
+}
+
+/* draws the complete play field, e.g. after the pause screen */
+static void drawField(void) {
+  uint16_t i;
+
+  LCDDIRTY_Clear();
+  LCDDIRTY_DrawBox(0, 0, MAX_WIDTH, MAX_HEIGHT, 1, GDisp1_COLOR_BLACK);
+  i = snakeTail;
+  for(;;) {
+    drawCell(snakeBody[i], SNAKE_CELL_BODY);
+    if (i==snakeHead) {
+      break;
+    }
+    i = (i+1)%SNAKE_MAX_LEN;
   }
-  if (cnt>max) {
-    cnt = max/2;
+  drawCell(foodCell, SNAKE_CELL_FOOD);
+  LCDDIRTY_Flush();
+}
+
+/* number of cleared bits in a byte */
+static uint8_t nofFreeBits(uint8_t bits) {
+  static const uint8_t nofSet[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
+
+  return 8-nofSet[bits&0xf]-nofSet[bits>>4];
+}
+
+static bool placeFood(void) {
+  uint16_t nofFree, cell, n, i;
+  uint8_t bit;
+
+  nofFree = SNAKE_NOF_CELLS-snakeLen;
+  if (nofFree==0) {
+    return FALSE; /* no space left: snake fills the whole grid */
+  }
+  for(i=0; i<SNAKE_FOOD_TRIES; i++) { /* usually there are plenty of free cells */
+    cell = nextRandom()%SNAKE_NOF_CELLS;
+    if (!isOccupied(cell)) {
+      foodCell = cell;
+      drawCell(foodCell, SNAKE_CELL_FOOD);
+      return TRUE;
+    }
+  }
+  /* crowded grid: pick the n-th free cell */
+  n = nextRandom()%nofFree;
+  for(i=0; i<sizeof(snakeOccupied); i++) {
+    if (n<nofFreeBits(snakeOccupied[i])) {
+      for(bit=0; bit<8; bit++) {
+        if ((snakeOccupied[i]&(1<<bit))==0) {
+          if (n==0) {
+            foodCell = i*8+bit;
+            drawCell(foodCell, SNAKE_CELL_FOOD);
+            return TRUE;
+          }
+          n--;
+        }
+      }
+    }
+    n -= nofFreeBits(snakeOccupied[i]);
   }
-  return cnt;
+  return FALSE; /* not expected */
 }
 
 static void showPause(void) {
@@ -122,75 +249,77 @@ static void showPause(void) {
   uint8_t buf[16];
 
   FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
-  GDisp1_Clear();
+  LCDDIRTY_Clear();
   
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"Pause", font, NULL))/2; /* center text */
   y = 0;
-  FDisp1_WriteString((unsigned char*)"Pause", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Pause", GDisp1_COLOR_BLACK, &x, &y, font);
 
   x = 0;
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"Level: ", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Level: ", GDisp1_COLOR_BLACK, &x, &y, font);
   UTIL1_Num16sToStr(buf, sizeof(buf), level);
-  FDisp1_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
 
   x = 0;
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"Points: ", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Points: ", GDisp1_COLOR_BLACK, &x, &y, font);
   UTIL1_Num16sToStr(buf, sizeof(buf), point-1);
-  FDisp1_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
   
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"(Press Button)", font, NULL))/2; /* center text */
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"(Press Button)", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"(Press Button)", GDisp1_COLOR_BLACK, &x, &y, font);
 
-  GDisp1_UpdateFull();
+  LCDDIRTY_Flush();
   
   waitAnyButton();
-  GDisp1_Clear();
-  GDisp1_UpdateFull();
+  drawField();
 }
 
 static void resetGame(void) {
-  int i;
+  uint16_t i;
   FDisp1_PixelDim x, y;
   FDisp1_PixelDim charHeight, totalHeight;
   GFONT_Callbacks *font = GFONT1_GetFont();
   
-  GDisp1_Clear();
+  LCDDIRTY_Clear();
   FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
   
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"Ready?", font, NULL))/2; /* center text */
   y = totalHeight;
-  FDisp1_WriteString((unsigned char*)"Ready?", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Ready?", GDisp1_COLOR_BLACK, &x, &y, font);
   
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"(Press Button)", font, NULL))/2; /* center text */
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"(Press Button)", GDisp1_COLOR_BLACK, &x, &y, font);
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString((unsigned char*)"(Press Button)", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_Flush();
   waitAnyButton();
   
-  GDisp1_Clear();
+  LCDDIRTY_Clear();
   FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"Go!", font, NULL))/2; /* center text */
   y = GDisp1_GetHeight()/2 - totalHeight/2;
-  FDisp1_WriteString((unsigned char*)"Go!", GDisp1_COLOR_BLACK, &x, &y, font);
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString((unsigned char*)"Go!", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_Flush();
   delay(1000);
-  GDisp1_Clear();
-  GDisp1_UpdateFull();
   
+  /* all cells free, the padding bits after the last cell count as occupied */
+  for(i=0; i<sizeof(snakeOccupied); i++) {
+    snakeOccupied[i] = 0;
+  }
+  for(i=SNAKE_NOF_CELLS; i<sizeof(snakeOccupied)*8; i++) {
+    setOccupied(i);
+  }
+  /* snake in the middle row, head on the right */
   snakeLen = SNAKE_LEN;
-  for(i=0; i < (snakeLen-1) && i<SNAKE_MAX_LEN; i++) {
-    snakeCols[i] = i;
-    snakeRow[i]  = (MAX_HEIGHT / 2);
+  snakeGrow = 0;
+  for(i=0; i<snakeLen; i++) {
+    snakeBody[i] = (SNAKE_GRID_ROWS/2)*SNAKE_GRID_COLS+i;
+    setOccupied(snakeBody[i]);
   }
- 
-  xSnake = 0;
-  ySnake = (MAX_WIDTH/2);
- 
-  xFood = (GDisp1_GetWidth()/2);
-  yFood = (GDisp1_GetHeight()/2);
+  snakeTail = 0;
+  snakeHead = snakeLen-1;
  
   level  = 0;  
   point  = 0;
@@ -203,37 +332,9 @@ static void resetGame(void) {
   left  = FALSE;
   dr    = 0;
   dc    = 1;
-}
 
-static void drawSnake(void) {
-  int i;
-  
-  GDisp1_DrawBox(0, 0, MAX_WIDTH, MAX_HEIGHT, 1, GDisp1_COLOR_BLACK);
-  for(i = snakeLen; i > 0; i--) {
-    GDisp1_DrawCircle(snakeCols[i], snakeRow[i], 1, GDisp1_COLOR_BLACK);
-  }
-  GDisp1_DrawFilledBox(xFood, yFood, 3, 3, GDisp1_COLOR_BLACK);
-  GDisp1_UpdateFull();
-  for(i = snakeLen; i > 0; i--) {
-    snakeRow[i]  = snakeRow[i - 1];
-    snakeCols[i] = snakeCols[i - 1];
-  }
-  snakeRow[0]  += dr;
-  snakeCols[0] += dc;
-}
-
-static void eatFood(void) {
-  /* increase the point and snake length */
-  point++;
-  snakeLen += 2;
-  if(snakeLen > SNAKE_MAX_LEN-1)
-  {
-	  snakeLen = SNAKE_MAX_LEN-1;
-  }
-  /* new coordinates food randomly */
-  xFood = random(1, MAX_WIDTH-3);
-  yFood = random(1, MAX_HEIGHT-3);
-  drawSnake();  
+  (void)placeFood();
+  drawField();
 }
 
 static void upLevel(void) {
@@ -241,7 +342,10 @@ static void upLevel(void) {
   point   = 1;
   points += 10;
   if(level > 1) {
-    time -= 4;
+    time -= 10;
+    if (time<SNAKE_MIN_SPEED) {
+      time = SNAKE_MIN_SPEED;
+    }
   }
 }
 
@@ -256,32 +360,23 @@ static void direc(int d) {
 
 static void moveSnake(void) {
   /* LEFT */
-  /*! \todo handle events */
   if(EVNT_EventIsSetAutoClear(EVNT_SNAKE_BTN_LEFT) && !right) {
-    if((xSnake > 0 || xSnake <= GDisp1_GetWidth() - xSnake)) {
-      direc(LEFT);
-    }
+    direc(LEFT);
     return;
   }
   /* RIGHT */
   if(EVNT_EventIsSetAutoClear(EVNT_SNAKE_BTN_RIGHT)  && !left) {
-    if((xSnake > 0 || xSnake <= GDisp1_GetWidth() - xSnake)) {
-      direc(RIGHT);
-    }
+    direc(RIGHT);
     return;
   }
   /* UP */
   if(EVNT_EventIsSetAutoClear(EVNT_SNAKE_BTN_UP)  && !down) {
-    if((ySnake > 0 || ySnake <= GDisp1_GetHeight() - ySnake)) {
-      direc(UP);
-    }
+    direc(UP);
     return;
   }
   /* DOWN */
   if(EVNT_EventIsSetAutoClear(EVNT_SNAKE_BTN_DOWN)  && !up) {
-    if((ySnake > 0 || ySnake <= GDisp1_GetHeight() - ySnake)) {
-      direc(DOWN);
-    }
+    direc(DOWN);
     return;
   }
   /* START/PAUSE */
@@ -296,29 +391,29 @@ static void gameover(void) {
   GFONT_Callbacks *font = GFONT1_GetFont();
   uint8_t buf[16];
 
-  GDisp1_Clear();
+  LCDDIRTY_Clear();
   FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
 
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"End of Game", font, NULL))/2; /* center text */
   y = 0;
-  FDisp1_WriteString((unsigned char*)"End of Game", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"End of Game", GDisp1_COLOR_BLACK, &x, &y, font);
 
   x = 0;
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"Level: ", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Level: ", GDisp1_COLOR_BLACK, &x, &y, font);
   UTIL1_Num16sToStr(buf, sizeof(buf), level);
-  FDisp1_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
 
   x = 0;
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"Points: ", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Points: ", GDisp1_COLOR_BLACK, &x, &y, font);
   UTIL1_Num16sToStr(buf, sizeof(buf), point-1);
-  FDisp1_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString(buf, GDisp1_COLOR_BLACK, &x, &y, font);
 
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"(Press Button)", font, NULL))/2; /* center text */
   y += totalHeight;
-  FDisp1_WriteString((unsigned char*)"(Press Button)", GDisp1_COLOR_BLACK, &x, &y, font);
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString((unsigned char*)"(Press Button)", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_Flush();
   //delay(4000);
   waitAnyButton();
  
@@ -342,72 +437,48 @@ static void gameover(void) {
 }
 
 static void snake(void) {
-  int i;
-  
-  xSnake = snakeCols[0];
-  ySnake = snakeRow[0];
+  uint16_t head;
+  int col, row;
+
   if(point == 0 || point >= points) {
     upLevel();
   }  
-  GDisp1_Clear();
-  /* GDisp1_UpdateFull(); */
   moveSnake();
-  /* the snake has eaten the food (right or left) */
-  for(i=0; i < 3; i++) {
-    /* control the snake's head (x) with x-coordinates of the food */
-    if((xSnake+1 == xFood) || (xSnake == xFood+1))  {
-      /* control the snake's head (y) with y-coordinates of the food */
-      if((ySnake == yFood) || (ySnake+1 == yFood) || (ySnake == yFood+1)) {
-        eatFood();
-      }
-    }
-    /* the snake has eaten the food (from above or from below) */
-    if((ySnake == yFood) || (ySnake == yFood+i)) {
-      if((xSnake == xFood) || (xSnake+i == xFood) || (xSnake == xFood+i)) {
-        eatFood();
-      }
-    }    
-  }
-  /* LEFT */
-  if(left) {
-    /* snake touches the left wall */
-    if(xSnake == 1) {
-      gameover();
-    }
-    if(xSnake  > 1) {
-      drawSnake();
-    }
+  head = snakeBody[snakeHead];
+  col = head%SNAKE_GRID_COLS + dc;
+  row = head/SNAKE_GRID_COLS + dr;
+  if (col<0 || col>=SNAKE_GRID_COLS || row<0 || row>=SNAKE_GRID_ROWS) {
+    gameover(); /* snake touches the wall */
+    return;
   }
-  /* RIGHT */
-  if(right) {
-    /* snake touches the top wall */
-    if(xSnake == MAX_WIDTH-1) {
-      gameover();
-    }
-    if(xSnake  < MAX_WIDTH-1) {
-      drawSnake();
-    }
+  head = row*SNAKE_GRID_COLS+col;
+  /* move the tail first, so the head can follow into the cell just left by the tail */
+  if (snakeGrow>0) {
+    snakeGrow--;
+  } else {
+    clrOccupied(snakeBody[snakeTail]);
+    drawCell(snakeBody[snakeTail], SNAKE_CELL_EMPTY);
+    snakeTail = (snakeTail+1)%SNAKE_MAX_LEN;
+    snakeLen--;
   }
-  /* UP */
-  if(up) {
-    /* snake touches the above wall */
-    if(ySnake == 1) {
-      gameover();
-    }
-    if(ySnake > 1) {
-      drawSnake();
-    }
+  if (isOccupied(head)) {
+    gameover(); /* snake bites itself */
+    return;
   }
-  /* DOWN */
-  if(down) {
-    /* snake touches the ground */
-    if(ySnake == MAX_HEIGHT-1) {
-      gameover();
-    }
-    if(ySnake  < MAX_HEIGHT-1) {
-      drawSnake();
+  snakeHead = (snakeHead+1)%SNAKE_MAX_LEN;
+  snakeBody[snakeHead] = head;
+  snakeLen++;
+  setOccupied(head);
+  drawCell(head, SNAKE_CELL_BODY);
+  if (head==foodCell) { /* the snake has eaten the food */
+    /* increase the point and snake length */
+    point++;
+    snakeGrow += SNAKE_GROW;
+    if (!placeFood()) {
+      gameover(); /* grid is full */
     }
   }
+  LCDDIRTY_Flush(); /* only the head, tail and food cells have changed */
 }
 
 static void intro(void) {
@@ -415,15 +486,15 @@ static void intro(void) {
   FDisp1_PixelDim charHeight, totalHeight;
   GFONT_Callbacks *font = GFONT1_GetFont();
   
-  GDisp1_Clear();
+  LCDDIRTY_Clear();
   FDisp1_GetFontHeight(font, &charHeight, &totalHeight);
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"Snake Game", font, NULL))/2; /* center text */
   y = totalHeight;
-  FDisp1_WriteString((unsigned char*)"Snake Game", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_WriteString((unsigned char*)"Snake Game", GDisp1_COLOR_BLACK, &x, &y, font);
   y += totalHeight;
   x = (GDisp1_GetWidth()-FDisp1_GetStringWidth((unsigned char*)"McuOnEclipse", font, NULL))/2; /* center text */
-  FDisp1_WriteString((unsigned char*)"McuOnEclipse", GDisp1_COLOR_BLACK, &x, &y, font);
-  GDisp1_UpdateFull();
+  LCDDIRTY_WriteString((unsigned char*)"McuOnEclipse", GDisp1_COLOR_BLACK, &x, &y, font);
+  LCDDIRTY_Flush();
   WAIT1_WaitOSms(3000);
 }
 
@@ -453,6 +524,7 @@ static void SnakeTask(void *pvParameters) {
   //}
   //Snake Game noch nicht gestartet wurde ber das Menu blockt der Task auf einen Semaphore
   if (xSemaphoreTake(xSemaphoreSnakeGame, portMAX_DELAY)==pdPASS) { /* block on semaphore */
+	  seedRandom();
 	  intro();
 	  resetGame();
 	  for(;;) {
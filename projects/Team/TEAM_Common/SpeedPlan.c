@@ -0,0 +1,361 @@
+/**
+ * \file
+ * \brief Speed planner for line following, see SpeedPlan.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Curvatures are in 1/km (1000 is a radius of 1 m), speeds in mm/s and accelerations in mm/s^2.
+ * Encoder curvature of a sample: heading change (dr-dl)/track over the driven distance (dl+dr)/2.
+ * Line curvature: the arc through the wheel axis, tangent to the heading, which meets the line at the array
+ * has the curvature 2*offset/ahead^2. It is low pass filtered, as the line position is noisy.
+ * The acceleration limits use v^2 = v0^2 + 2*a*s, so they do not depend on the rate of the control steps.
+ * The feedforward steering is the wheel speed difference for the curvature of the map: v*curvature*track.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_SPEED_PLAN
+#include "SpeedPlan.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+  #define SPLAN_COUNTS_PER_M      ((int32_t)HWP_Get()->countsPerM)
+#else
+  #define SPLAN_COUNTS_PER_M      SPLAN_CONFIG_COUNTS_PER_M
+#endif
+
+#define SPLAN_LINE_FILTER   (4) /* low pass of the line curvature: 1/4 of the new value each step */
+
+typedef struct {
+  bool on;              /* planner sets the speed, else 'pid fw speed' */
+  uint16_t minMmS;      /* speed in the tightest curves and at the start */
+  uint16_t maxMmS;      /* speed on straights */
+  uint16_t latMmS2;     /* lateral acceleration limit */
+  uint16_t accMmS2;     /* acceleration limit */
+  uint16_t decMmS2;     /* deceleration limit */
+} SPLAN_Config;
+
+static SPLAN_Config SPLAN_Cfg;
+
+static struct {
+  bool haveLast;
+  int32_t lastLeft, lastRight;   /* encoder positions of the last step */
+  int32_t left, right;           /* counts of the current sample */
+  int32_t curv[SPLAN_CONFIG_NOF_SAMPLES]; /* absolute encoder curvature of the last samples */
+  uint8_t idx;                   /* next sample in curv[] */
+  int32_t lineCurv;              /* filtered line curvature, signed */
+  int32_t estCurv;               /* curvature the speed is planned for */
+  int32_t speedMmS;              /* planned speed */
+  int32_t steer;                 /* feedforward steering from the map, PWM */
+} SPLAN_State;
+
+/* integer square root */
+static uint32_t SqrtU32(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+/* speed at 100% PWM */
+static int32_t FullSpeedMmS(void) {
+#if PL_CONFIG_HAS_HW_PROFILE
+  const HWP_Profile *p = HWP_Get();
+
+  if (p->gainLeft!=0 && p->gainRight!=0 && p->countsPerM!=0) {
+    return (((int32_t)p->gainLeft+p->gainRight)*500)/p->countsPerM; /* average of both motors */
+  }
+#endif
+  return SPLAN_CONFIG_FULL_SPEED_MM_S;
+}
+
+/* highest speed which keeps the lateral acceleration below the limit */
+static int32_t CurveSpeedMmS(int32_t curv) {
+  uint32_t q;
+
+  if (curv<=0) {
+    return SPLAN_Cfg.maxMmS;
+  }
+  q = ((uint32_t)SPLAN_Cfg.latMmS2*1000U)/(uint32_t)curv; /* v^2/1000 */
+  if (q>=((uint32_t)SPLAN_Cfg.maxMmS*SPLAN_Cfg.maxMmS)/1000U) {
+    return SPLAN_Cfg.maxMmS;
+  }
+  return (int32_t)SqrtU32(q*1000U);
+}
+
+/* adds the driven counts to the current sample, and closes it after SPLAN_CONFIG_SAMPLE_MM */
+static void AddDistance(int32_t dl, int32_t dr) {
+  int32_t ds, curv;
+
+  SPLAN_State.left += dl;
+  SPLAN_State.right += dr;
+  ds = (SPLAN_State.left+SPLAN_State.right)/2;
+  if (ds<0) {
+    ds = -ds;
+  }
+  if (ds*1000<SPLAN_CONFIG_SAMPLE_MM*SPLAN_COUNTS_PER_M) {
+    return; /* sample not complete yet */
+  }
+  curv = ((SPLAN_State.right-SPLAN_State.left)*SPLAN_COUNTS_PER_M)/SPLAN_CONFIG_TRACK_COUNTS; /* heading change (rad) times counts per m */
+  curv = (curv*1000)/ds;
+  SPLAN_State.curv[SPLAN_State.idx] = curv<0 ? -curv : curv;
+  SPLAN_State.idx++;
+  if (SPLAN_State.idx>=SPLAN_CONFIG_NOF_SAMPLES) {
+    SPLAN_State.idx = 0;
+  }
+  SPLAN_State.left = SPLAN_State.right = 0;
+}
+
+bool SPLAN_IsOn(void) {
+  return SPLAN_Cfg.on;
+}
+
+int32_t SPLAN_Step(int32_t lineError) {
+  int32_t left = Q4CLeft_GetPos(), right = Q4CRight_GetPos();
+  int32_t dl, dr, dsUm, curv, target, speed, full;
+  uint32_t vSq, dvSq;
+  int i;
+
+  if (!SPLAN_State.haveLast) {
+    SPLAN_State.lastLeft = left;
+    SPLAN_State.lastRight = right;
+    SPLAN_State.haveLast = TRUE;
+  }
+  dl = left-SPLAN_State.lastLeft;
+  dr = right-SPLAN_State.lastRight;
+  SPLAN_State.lastLeft = left;
+  SPLAN_State.lastRight = right;
+  AddDistance(dl, dr);
+#if PL_CONFIG_HAS_TRACK_MAP
+  TMAP_AddDistance(dl, dr);
+#endif
+  /* line curvature: offset in um is lineError*pitch/1000, curvature in 1/km is 2000*offset/ahead^2 */
+  curv = (lineError*(SPLAN_CONFIG_SENSOR_PITCH_UM/10))/(SPLAN_CONFIG_SENSOR_AHEAD_MM*SPLAN_CONFIG_SENSOR_AHEAD_MM/20);
+  SPLAN_State.lineCurv += (curv-SPLAN_State.lineCurv)/SPLAN_LINE_FILTER;
+  curv = SPLAN_State.lineCurv<0 ? -SPLAN_State.lineCurv : SPLAN_State.lineCurv;
+  for(i=0;i<SPLAN_CONFIG_NOF_SAMPLES;i++) {
+    if (SPLAN_State.curv[i]>curv) {
+      curv = SPLAN_State.curv[i];
+    }
+  }
+  SPLAN_State.estCurv = curv;
+  target = CurveSpeedMmS(curv);
+  if (target<SPLAN_Cfg.minMmS) {
+    target = SPLAN_Cfg.minMmS;
+  }
+#if PL_CONFIG_HAS_TRACK_MAP
+  speed = TMAP_GetSpeedMmS(lineError);
+  if (speed!=0) {
+    target = speed; /* the profile of the map brakes before the curves */
+  }
+#endif
+  /* limit the change of the speed over the driven distance */
+  dsUm = ((dl+dr>=0 ? dl+dr : -(dl+dr))*500000)/SPLAN_COUNTS_PER_M;
+  speed = SPLAN_State.speedMmS;
+  vSq = (uint32_t)speed*(uint32_t)speed;
+  if (target>speed) {
+    dvSq = (2U*SPLAN_Cfg.accMmS2*(uint32_t)dsUm)/1000U;
+    if ((uint32_t)target*(uint32_t)target<vSq+dvSq) {
+      speed = target;
+    } else {
+      speed = (int32_t)SqrtU32(vSq+dvSq);
+    }
+  } else if (target<speed) {
+    dvSq = (2U*SPLAN_Cfg.decMmS2*(uint32_t)dsUm)/1000U;
+    if ((uint32_t)target*(uint32_t)target+dvSq>vSq) {
+      speed = target;
+    } else {
+      speed = (int32_t)SqrtU32(vSq-dvSq);
+    }
+  }
+  SPLAN_State.speedMmS = speed;
+  full = FullSpeedMmS();
+#if PL_CONFIG_HAS_TRACK_MAP
+  SPLAN_State.steer = (((((speed*TMAP_GetCurvature())/1000)*SPLAN_CONFIG_TRACK_COUNTS)/SPLAN_COUNTS_PER_M)*0xffff)/full;
+#endif
+  if (speed>=full) {
+    return 0xffff;
+  }
+  return (speed*0xffff)/full;
+}
+
+int32_t SPLAN_GetSteer(void) {
+  return SPLAN_State.steer;
+}
+
+void SPLAN_PlanProfile(const int16_t *curv, uint16_t *speed, uint16_t nofBins, uint16_t binMm) {
+  uint16_t i, j, pass;
+  int32_t c, maxCurv, v;
+  uint32_t vSq, limitSq;
+
+  if (nofBins==0) {
+    return;
+  }
+  /* speed for the tightest curvature of the bin and its neighbours, the robot is longer than a bin */
+  for(i=0;i<nofBins;i++) {
+    maxCurv = 0;
+    for(j=0;j<3;j++) {
+      c = curv[(i+nofBins+j-1)%nofBins];
+      if (c<0) {
+        c = -c;
+      }
+      if (c>maxCurv) {
+        maxCurv = c;
+      }
+    }
+    v = CurveSpeedMmS(maxCurv);
+    if (v<SPLAN_Cfg.minMmS) {
+      v = SPLAN_Cfg.minMmS;
+    }
+    speed[i] = (uint16_t)v;
+  }
+  /* braking before the curves: backwards over the lap, twice for the curves at the start of the lap */
+  for(pass=0;pass<2;pass++) {
+    for(i=nofBins;i>0;i--) {
+      v = speed[i%nofBins];
+      limitSq = (uint32_t)v*(uint32_t)v+2U*SPLAN_Cfg.decMmS2*(uint32_t)binMm;
+      vSq = (uint32_t)speed[i-1]*speed[i-1];
+      if (vSq>limitSq) {
+        speed[i-1] = (uint16_t)SqrtU32(limitSq);
+      }
+    }
+  }
+  /* accelerating after the curves: forward over the lap */
+  for(pass=0;pass<2;pass++) {
+    for(i=0;i<nofBins;i++) {
+      v = speed[i];
+      limitSq = (uint32_t)v*(uint32_t)v+2U*SPLAN_Cfg.accMmS2*(uint32_t)binMm;
+      j = (i+1)%nofBins;
+      vSq = (uint32_t)speed[j]*speed[j];
+      if (vSq>limitSq) {
+        speed[j] = (uint16_t)SqrtU32(limitSq);
+      }
+    }
+  }
+}
+
+void SPLAN_Reset(void) {
+  int i;
+
+  SPLAN_State.haveLast = FALSE;
+  SPLAN_State.left = SPLAN_State.right = 0;
+  for(i=0;i<SPLAN_CONFIG_NOF_SAMPLES;i++) {
+    SPLAN_State.curv[i] = 0;
+  }
+  SPLAN_State.idx = 0;
+  SPLAN_State.lineCurv = 0;
+  SPLAN_State.estCurv = 0;
+  SPLAN_State.speedMmS = SPLAN_Cfg.minMmS;
+  SPLAN_State.steer = 0;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void PrintValue(const unsigned char *title, int32_t val, const unsigned char *unit, const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), val);
+  UTIL1_strcat(buf, sizeof(buf), unit);
+  CLS1_SendStatusStr(title, buf, io->stdOut);
+}
+
+static void SPLAN_PrintStatus(const CLS1_StdIOType *io) {
+  CLS1_SendStatusStr((unsigned char*)"plan", SPLAN_Cfg.on ? (unsigned char*)"on\r\n" : (unsigned char*)"off\r\n", io->stdOut);
+  PrintValue((unsigned char*)"  min", SPLAN_Cfg.minMmS, (unsigned char*)" mm/s\r\n", io);
+  PrintValue((unsigned char*)"  max", SPLAN_Cfg.maxMmS, (unsigned char*)" mm/s\r\n", io);
+  PrintValue((unsigned char*)"  lat", SPLAN_Cfg.latMmS2, (unsigned char*)" mm/s^2\r\n", io);
+  PrintValue((unsigned char*)"  acc", SPLAN_Cfg.accMmS2, (unsigned char*)" mm/s^2\r\n", io);
+  PrintValue((unsigned char*)"  dec", SPLAN_Cfg.decMmS2, (unsigned char*)" mm/s^2\r\n", io);
+  PrintValue((unsigned char*)"  full", FullSpeedMmS(), (unsigned char*)" mm/s at 100% PWM\r\n", io);
+  PrintValue((unsigned char*)"  curvature", SPLAN_State.estCurv, (unsigned char*)" 1/km\r\n", io);
+  PrintValue((unsigned char*)"  speed", SPLAN_State.speedMmS, (unsigned char*)" mm/s\r\n", io);
+}
+
+static void SPLAN_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"plan", (unsigned char*)"Group of line following speed planner commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows planner help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  on|off", (unsigned char*)"Planned speed, or the fixed speed of 'pid fw speed'\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  (min|max) <mm/s>", (unsigned char*)"Speed in the tightest curves and on straights\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  lat <mm/s^2>", (unsigned char*)"Lateral acceleration limit in curves\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  (acc|dec) <mm/s^2>", (unsigned char*)"Acceleration and deceleration limits\r\n", io->stdOut);
+}
+
+static uint8_t ParseValue(const unsigned char *cmd, size_t cmdLen, uint16_t *val, bool *handled, const CLS1_StdIOType *io) {
+  const unsigned char *p = cmd+cmdLen;
+  uint16_t val16u;
+
+  *handled = TRUE;
+  if (UTIL1_ScanDecimal16uNumber(&p, &val16u)!=ERR_OK || val16u==0) {
+    CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  *val = val16u;
+  return ERR_OK;
+}
+
+uint8_t SPLAN_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"plan help")==0) {
+    SPLAN_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"plan status")==0) {
+    SPLAN_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"plan on")==0) {
+    SPLAN_Cfg.on = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"plan off")==0) {
+    SPLAN_Cfg.on = FALSE;
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"plan min ", sizeof("plan min ")-1)==0) {
+    res = ParseValue(cmd, sizeof("plan min ")-1, &SPLAN_Cfg.minMmS, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"plan max ", sizeof("plan max ")-1)==0) {
+    res = ParseValue(cmd, sizeof("plan max ")-1, &SPLAN_Cfg.maxMmS, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"plan lat ", sizeof("plan lat ")-1)==0) {
+    res = ParseValue(cmd, sizeof("plan lat ")-1, &SPLAN_Cfg.latMmS2, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"plan acc ", sizeof("plan acc ")-1)==0) {
+    res = ParseValue(cmd, sizeof("plan acc ")-1, &SPLAN_Cfg.accMmS2, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"plan dec ", sizeof("plan dec ")-1)==0) {
+    res = ParseValue(cmd, sizeof("plan dec ")-1, &SPLAN_Cfg.decMmS2, handled, io);
+  }
+#if PL_CONFIG_HAS_TRACK_MAP
+  if (*handled && res==ERR_OK && UTIL1_strncmp((char*)cmd, (char*)"plan ", sizeof("plan ")-1)==0) {
+    TMAP_Plan(); /* the profile of the map depends on the limits */
+  }
+#endif
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void SPLAN_Deinit(void) {
+  /* nothing needed */
+}
+
+void SPLAN_Init(void) {
+  SPLAN_Cfg.on = TRUE;
+  SPLAN_Cfg.minMmS = 300;
+  SPLAN_Cfg.maxMmS = 800;
+  SPLAN_Cfg.latMmS2 = 3000;
+  SPLAN_Cfg.accMmS2 = 4000;
+  SPLAN_Cfg.decMmS2 = 5000;
+  SPLAN_Reset();
+}
+
+#endif /* PL_CONFIG_HAS_SPEED_PLAN */
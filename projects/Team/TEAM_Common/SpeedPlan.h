@@ -0,0 +1,99 @@
+/**
+ * \file
+ * \brief Interface of the speed planner for line following.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Instead of the fixed speed of 'pid fw speed', the line controller gets its base speed from the planner.
+ * The planner estimates the curvature of the track from
+ *   the wheel encoders: heading change per driven distance, kept for the last SPLAN_CONFIG_NOF_SAMPLES
+ *     samples of SPLAN_CONFIG_SAMPLE_MM each, so the robot stays slow until it has left the curve,
+ *   the line position: the offset of the line at the sensor array, ahead of the wheels, which grows
+ *     as soon as the array enters a curve, so the robot brakes before it is far off the line.
+ * The speed is the one which keeps the lateral acceleration in the curve below the limit, between a minimum
+ * and a maximum speed, and it changes at most with the acceleration and deceleration limits over the driven distance.
+ * The speeds are converted to PWM with the motor gains of the hardware profile.
+ * With a learned track map (see TrackMap.h) the speed comes from the profile of the map, and the map curvature
+ * gives a feedforward steering, as long as the robot is in sync with the map.
+ */
+
+#ifndef SPEEDPLAN_H_
+#define SPEEDPLAN_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_SPEED_PLAN
+
+#ifndef SPLAN_CONFIG_COUNTS_PER_M
+  #define SPLAN_CONFIG_COUNTS_PER_M     (7350) /*!< quadrature counts per meter of track, if there is no hardware profile */
+#endif
+#ifndef SPLAN_CONFIG_FULL_SPEED_MM_S
+  #define SPLAN_CONFIG_FULL_SPEED_MM_S  (1000) /*!< speed at 100% PWM, if the hardware profile has no motor gains */
+#endif
+#ifndef SPLAN_CONFIG_TRACK_COUNTS
+  #define SPLAN_CONFIG_TRACK_COUNTS     (875)  /*!< effective distance between the tracks in quadrature counts, including the skid (see TURN_STEPS_90) */
+#endif
+#ifndef SPLAN_CONFIG_SENSOR_AHEAD_MM
+  #define SPLAN_CONFIG_SENSOR_AHEAD_MM  (45)   /*!< distance of the reflectance array ahead of the wheel axis */
+#endif
+#ifndef SPLAN_CONFIG_SENSOR_PITCH_UM
+  #define SPLAN_CONFIG_SENSOR_PITCH_UM  (9500) /*!< distance between two reflectance sensors, 1000 line units */
+#endif
+#ifndef SPLAN_CONFIG_SAMPLE_MM
+  #define SPLAN_CONFIG_SAMPLE_MM        (10)   /*!< driven distance of a curvature sample */
+#endif
+#ifndef SPLAN_CONFIG_NOF_SAMPLES
+  #define SPLAN_CONFIG_NOF_SAMPLES      (8)    /*!< curvature samples kept, the distance over which a curve slows the robot */
+#endif
+
+/*!
+ * \brief Returns if the planner sets the speed of the line controller.
+ * \return TRUE if on, FALSE if the line controller uses its fixed speed.
+ */
+bool SPLAN_IsOn(void);
+
+/*!
+ * \brief Plans the speed for the next control step of the line controller, call it once for each step.
+ * \param lineError Line position minus the middle position, see REF_GetLineValue().
+ * \return Base speed for both motors as PWM value, 0xffff is full speed.
+ */
+int32_t SPLAN_Step(int32_t lineError);
+
+/*!
+ * \brief Returns the feedforward steering for the curvature of the track map, computed by SPLAN_Step().
+ * \return PWM difference of the right minus the left motor, 0 without a map.
+ */
+int32_t SPLAN_GetSteer(void);
+
+/*! \brief Forgets the curvature and starts with the minimum speed, call it at the start of a line segment */
+void SPLAN_Reset(void);
+
+/*!
+ * \brief Plans the speed profile of a closed track with the limits of the planner.
+ * \param curv Curvature of the bins in 1/km.
+ * \param speed Returns the speed of the bins in mm/s.
+ * \param nofBins Number of bins of the lap.
+ * \param binMm Length of a bin.
+ */
+void SPLAN_PlanProfile(const int16_t *curv, uint16_t *speed, uint16_t nofBins, uint16_t binMm);
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t SPLAN_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Driver de-initialization */
+void SPLAN_Deinit(void);
+
+/*! \brief Driver initialization */
+void SPLAN_Init(void);
+
+#endif /* PL_CONFIG_HAS_SPEED_PLAN */
+
+#endif /* SPEEDPLAN_H_ */
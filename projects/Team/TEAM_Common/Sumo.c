@@ -12,6 +12,9 @@
 #include "Drive.h"
 #include "Reflectance.h"
 #include "Turn.h"
+#if PL_CONFIG_HAS_PROFILER
+  #include "Profiler.h"
+#endif
 #include "CLS1.h"
 #include "Drive.h"
 #include "Q4CLeft.h"
@@ -19,6 +22,12 @@
 #include "Buzzer.h"
 #include "Distance.h"
 #include "LED.h"
+#if PL_CONFIG_HAS_ARENA_LOC
+  #include "ArenaLoc.h"
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  #include "Obstacle.h"
+#endif
 
 typedef enum {
   SUMO_STATE_IDLE,
@@ -44,8 +53,13 @@ static int32_t turningSpeed = 1750;
 static int32_t backwardSpeed = 10000;
 // set drive attack speed
 static int32_t attackSpeed = 5000;
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+// half angle of the sector in front of the robot where an obstacle is the opponent
+static int16_t sightDeg = 20;
+#else
 // difference of ToF Sensor values to decide for attack
 static int32_t distanceSensorMM = 100;
+#endif
 // time for a turn in millisec
 static int32_t timeForATurnMS = 2000;
 static TickType_t timeBegin;
@@ -57,6 +71,14 @@ static int32_t counterRandomMode = 0;
 static bool doRandom = FALSE;
 //
 static int32_t count10MS = 30;
+#if PL_CONFIG_HAS_ARENA_LOC
+// set drive speed far from the edge, if the localisation knows where the robot is
+static int32_t fullSpeed = 7000;
+// distance to the border ahead over which the speed goes down from fullSpeed to the normal speed
+static int32_t brakeDistanceMM = 150;
+// last speed set while driving or attacking
+static int32_t edgeSpeed = 0;
+#endif
 
 /* direct task notification bits */
 #define SUMO_START_SUMO (1<<0)  /* start sumo mode */
@@ -92,6 +114,75 @@ void SUMO_StartStopSumo(void) {
   }
 }
 
+#if PL_HAS_DISTANCE_SENSOR
+/* returns TRUE if the opponent is in front of the robot */
+static bool SUMO_OpponentInSight(void) {
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  /* the map keeps a target of the last frames in place while the robot turns to search */
+  return OBST_GetNearest((int16_t)-sightDeg, sightDeg)!=OBST_NO_OBSTACLE;
+#elif PL_HAS_TOF_SENSOR
+  VL6180X_Range left, right;
+
+  /* only valid ranges count: a no-target or ambient overload result is not a target at 255 mm */
+  if (DIST_GetRange(DIST_SENSOR_LEFT, &left)!=ERR_OK || left.status!=VL6180X_RANGE_STATUS_OK) {
+    return FALSE;
+  }
+  if (DIST_GetRange(DIST_SENSOR_RIGHT, &right)!=ERR_OK || right.status!=VL6180X_RANGE_STATUS_OK) {
+    return FALSE;
+  }
+  return (right.mm-left.mm)<=distanceSensorMM || (left.mm-right.mm)<=distanceSensorMM;
+#else
+  return ((DIST_GetDistance(DIST_SENSOR_RIGHT)-DIST_GetDistance(DIST_SENSOR_LEFT))<=distanceSensorMM ||
+          (DIST_GetDistance(DIST_SENSOR_LEFT)-DIST_GetDistance(DIST_SENSOR_RIGHT))<=distanceSensorMM) &&
+          DIST_GetDistance(DIST_SENSOR_RIGHT)!=-1 && DIST_GetDistance(DIST_SENSOR_LEFT)!=-1;
+#endif
+}
+
+/* precise ranging to find the opponent, fast ranging while attacking it */
+static void SUMO_SetRangeProfile(bool attack) {
+#if PL_HAS_TOF_SENSOR
+  DIST_RangeProfile profile = attack ? DIST_RANGE_PROFILE_FAST : DIST_RANGE_PROFILE_PRECISE;
+
+  DIST_SetRangeProfile(DIST_SENSOR_LEFT, profile);
+  DIST_SetRangeProfile(DIST_SENSOR_RIGHT, profile);
+#else
+  (void)attack;
+#endif
+}
+#endif
+
+#if PL_CONFIG_HAS_ARENA_LOC
+/* full speed far from the edge, the normal speed when the border ahead is closer than brakeDistanceMM */
+static void SUMO_SetEdgeSpeed(int32_t normalSpeed) {
+  ALOC_Pose pose;
+  int32_t dist, v = normalSpeed;
+
+  if (ALOC_GetPose(&pose)==ERR_OK) { /* otherwise the pose is not known: normal speed */
+    dist = pose.edgeAheadMm-pose.spreadMm;
+    if (dist>=brakeDistanceMM) {
+      v = fullSpeed;
+    } else if (dist>0) {
+      v = normalSpeed+((fullSpeed-normalSpeed)*dist)/brakeDistanceMM;
+    }
+  }
+  if (v!=edgeSpeed) {
+    edgeSpeed = v;
+    DRV_SetSpeed(v, v);
+  }
+}
+
+/* turns toward the center of the arena, returns FALSE if the pose is not known */
+static bool SUMO_TurnToCenter(void) {
+  ALOC_Pose pose;
+
+  if (ALOC_GetPose(&pose)!=ERR_OK) {
+    return FALSE;
+  }
+  TURN_TurnAngle((int16_t)-pose.centerDeg, NULL); /* positive angle is a right turn */
+  return TRUE;
+}
+#endif
+
 static void SumoRun(void) {
   uint32_t notifcationValue;
 
@@ -106,6 +197,10 @@ static void SumoRun(void) {
 #endif
 	  	    FRTOS1_vTaskDelay(1000/portTICK_PERIOD_MS);	//insgesamt wird etwas ber 5 Sekunden gewartet nach Start
           }
+#if PL_CONFIG_HAS_ARENA_LOC
+          ALOC_Start(); /* robot is on the start pose */
+          edgeSpeed = 0;
+#endif
           sumoState = SUMO_STATE_SHOVEL;	//beim Start einen Ruck geben
           break; /* handle next state */
         }
@@ -138,6 +233,9 @@ static void SumoRun(void) {
     	  //Logik einbauen dass Gegner gesucht wird und anschliessend in State "Gegner attackieren" wechseln
           if (notifcationValue&SUMO_STOP_SUMO) {
              DRV_SetMode(DRV_MODE_STOP);
+#if PL_CONFIG_HAS_ARENA_LOC
+             ALOC_Stop();
+#endif
              sumoState = SUMO_STATE_IDLE;
              break; /* handle next state */
           }
@@ -147,14 +245,13 @@ static void SumoRun(void) {
         	  break; /* handle next state */
           }
           //Wenn Gegner gefunden --> attackieren! / ansonsten drehen und suchen
-          if (((DIST_GetDistance(DIST_SENSOR_RIGHT)-DIST_GetDistance(DIST_SENSOR_LEFT))<=distanceSensorMM ||
-          (DIST_GetDistance(DIST_SENSOR_LEFT)-DIST_GetDistance(DIST_SENSOR_RIGHT))<=distanceSensorMM) &&
-          DIST_GetDistance(DIST_SENSOR_RIGHT)!=-1 && DIST_GetDistance(DIST_SENSOR_LEFT)!=-1) {
+          if (SUMO_OpponentInSight()) {
         	 LEDPin1_NegVal();	//Anzeigen dass Gegner erkannt wurde
         	 counterRandomMode = 0;	//Counter zurcksetzen da Gegner gefunden
              //Gegner attackieren
              DRV_SetMode(DRV_MODE_SPEED);
              DRV_SetSpeed(attackSpeed,attackSpeed);
+             SUMO_SetRangeProfile(TRUE);
         	 sumoState = SUMO_STATE_ATTACK_OPPONENT;
         	 break; /* handle next state */
           }
@@ -195,6 +292,10 @@ static void SumoRun(void) {
     	  //der Gegner genau vor einem ist, nicht dass man ber das Ziel hinausschiesst
           if (notifcationValue&SUMO_STOP_SUMO) {
             DRV_SetMode(DRV_MODE_STOP);
+            SUMO_SetRangeProfile(FALSE);
+#if PL_CONFIG_HAS_ARENA_LOC
+            ALOC_Stop();
+#endif
             sumoState = SUMO_STATE_IDLE;
             break; /* handle next state */
           }
@@ -202,12 +303,18 @@ static void SumoRun(void) {
             sumoState = SUMO_STATE_TURNING;
             break; /* handle next state */
           }
+#if PL_CONFIG_HAS_ARENA_LOC
+          SUMO_SetEdgeSpeed(attackSpeed); /* push at full speed, but not over the edge */
+#endif
     	  break; /* handle next state */
     	  return;
 #endif
       case SUMO_STATE_DRIVING:
         if (notifcationValue&SUMO_STOP_SUMO) {
            DRV_SetMode(DRV_MODE_STOP);
+#if PL_CONFIG_HAS_ARENA_LOC
+           ALOC_Stop();
+#endif
            sumoState = SUMO_STATE_IDLE;
            break; /* handle next state */
         }
@@ -215,6 +322,9 @@ static void SumoRun(void) {
           sumoState = SUMO_STATE_TURNING;
           break; /* handle next state */
         }
+#if PL_CONFIG_HAS_ARENA_LOC
+        SUMO_SetEdgeSpeed(speed);
+#endif
         break;
         return;
       case SUMO_STATE_TURNING:
@@ -223,10 +333,17 @@ static void SumoRun(void) {
         DRV_SetMode(DRV_MODE_SPEED);
         DRV_SetSpeed(-backwardSpeed,-backwardSpeed);
         vTaskDelay(250/portTICK_PERIOD_MS);
-        //Drehen
-        TURN_Turn(TURN_RIGHT180, NULL);
+        //Drehen: zur Mitte der Arena, falls die Position bekannt ist
+#if PL_CONFIG_HAS_ARENA_LOC
+        edgeSpeed = 0; /* speed is set again after the turn */
+        if (!SUMO_TurnToCenter())
+#endif
+        {
+          TURN_Turn(TURN_RIGHT180, NULL);
+        }
 #if PL_HAS_DISTANCE_SENSOR
         if (!doRandom) {
+          SUMO_SetRangeProfile(FALSE);
           sumoState = SUMO_STATE_SEARCH_OPPONENT;	//in Status "Gegner suchen" wechseln
           break; /* handle next state */
         }
@@ -251,9 +368,22 @@ static void SumoRun(void) {
 }
 
 static void SumoTask(void* param) {
+#if PL_CONFIG_HAS_PROFILER
+  PROF_Id profId;
+#endif
+
   sumoState = SUMO_STATE_IDLE;
+#if PL_CONFIG_HAS_PROFILER
+  profId = PROF_Register("Sumo", PROF_PERIOD_DELAY, 10);
+#endif
   for(;;) {
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopBegin(profId);
+#endif
     SumoRun();
+#if PL_CONFIG_HAS_PROFILER
+    PROF_LoopEnd(profId);
+#endif
     FRTOS1_vTaskDelay(10/portTICK_PERIOD_MS);
   }
 }
@@ -0,0 +1,384 @@
+/**
+ * \file
+ * \brief Clock synchronisation between the nodes.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The master (the remote or the time keeping system) provides the shared time: its local microsecond clock.
+ * A client periodically sends a request with its local time t1, the master answers with the receive
+ * time t2 and the send time t3, and the client takes t4 on reception. As with NTP:
+ *   offset = ((t2-t1)+(t3-t4))/2, delay = (t4-t1)-(t3-t2), with an offset error of at most delay/2.
+ * Radio retries and the scheduling of the radio task only increase the delay, so a clock filter
+ * keeps the sample with the smallest delay out of the last few. The drift is the slope of a least
+ * squares fit through the filtered offsets.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TIME_SYNC
+#include "TimeSync.h"
+#if !TSYNC_CONFIG_HOST
+  #include "FRTOS1.h"
+  #include "UTIL1.h"
+  #include "RApp.h"
+  #include "RNet_App.h"
+  #include "RNet_AppConfig.h"
+  #if PL_CONFIG_HAS_SHELL
+    #include "CLS1.h"
+  #endif
+#endif
+
+#define TSYNC_CONFIG_MAX_DELAY_US       (50000)    /* samples with a larger round trip delay are ignored */
+#define TSYNC_CONFIG_POINT_INTERVAL_US  (4000000)  /* minimum distance of the points for the drift estimation */
+#define TSYNC_CONFIG_MAX_DRIFT_PPB      (500000)   /* limit of the drift estimation (500 ppm) */
+#define TSYNC_CONFIG_USE_DRIFT_ERR_PPB  (100000)   /* the drift estimation is used once its error is below this (100 ppm) */
+#define TSYNC_CONFIG_RESOLUTION_US      (2)        /* resolution of the time stamps */
+
+void TSYNC_EstimatorReset(TSYNC_Estimator *est) {
+  est->nofSamples = 0;
+  est->sampleIdx = 0;
+  est->nofPoints = 0;
+  est->pointIdx = 0;
+  est->synced = FALSE;
+  est->haveDrift = FALSE;
+  est->driftPpb = 0;
+  est->driftErrPpb = TSYNC_CONFIG_MAX_DRIFT_PPB; /* without estimation the drift can be anything up to the limit */
+}
+
+/*!
+ * \brief Estimates the drift with a least squares fit through the points.
+ * The offset of each point is off by at most half of its delay, which bounds the error of the slope.
+ */
+static void EstimateDrift(TSYNC_Estimator *est) {
+  const TSYNC_Sample *first;
+  int64_t x, y, sumX, sumY, sumXY, sumXX, num, den, sumAbsX;
+  int32_t drift, driftErr;
+  uint32_t maxErr;
+  uint8_t i;
+
+  if (est->nofPoints<2) {
+    return;
+  }
+  first = &est->points[(est->pointIdx+TSYNC_NOF_POINTS-est->nofPoints)%TSYNC_NOF_POINTS]; /* oldest point */
+  sumX = sumY = sumXY = sumXX = 0;
+  maxErr = 0;
+  for(i=0;i<est->nofPoints;i++) {
+    x = (int32_t)(est->points[i].localUs-first->localUs); /* relative to the oldest point to keep the numbers small */
+    y = (int32_t)((uint32_t)est->points[i].offsetUs-(uint32_t)first->offsetUs);
+    sumX += x;
+    sumY += y;
+    sumXY += x*y;
+    sumXX += x*x;
+    if (est->points[i].delayUs/2>maxErr) {
+      maxErr = est->points[i].delayUs/2;
+    }
+  }
+  num = est->nofPoints*sumXY-sumX*sumY;
+  den = est->nofPoints*sumXX-sumX*sumX;
+  if (den/1000000<=0) {
+    return; /* points too close */
+  }
+  sumAbsX = 0; /* sum of |x-mean(x)|, scaled by the number of points as num and den */
+  for(i=0;i<est->nofPoints;i++) {
+    x = est->nofPoints*(int64_t)(int32_t)(est->points[i].localUs-first->localUs)-sumX;
+    sumAbsX += x<0?-x:x;
+  }
+  driftErr = (int32_t)(((int64_t)(maxErr+TSYNC_CONFIG_RESOLUTION_US)*sumAbsX*1000)/(den/1000000))+1000; /* plus 1 ppm for the rounding */
+  if (driftErr>=TSYNC_CONFIG_USE_DRIFT_ERR_PPB) {
+    return; /* too inaccurate, wait for more points */
+  }
+  drift = (int32_t)((num*1000)/(den/1000000)); /* slope in parts per billion */
+  if (drift>TSYNC_CONFIG_MAX_DRIFT_PPB) {
+    drift = TSYNC_CONFIG_MAX_DRIFT_PPB;
+  } else if (drift<-TSYNC_CONFIG_MAX_DRIFT_PPB) {
+    drift = -TSYNC_CONFIG_MAX_DRIFT_PPB;
+  }
+  est->driftPpb = drift;
+  est->driftErrPpb = driftErr;
+  est->haveDrift = TRUE;
+}
+
+uint8_t TSYNC_EstimatorAddSample(TSYNC_Estimator *est, uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4) {
+  TSYNC_Sample *sample, *best;
+  TSYNC_Sample *last;
+  int32_t delay;
+  uint8_t i;
+
+  delay = (int32_t)(t4-t1)-(int32_t)(t3-t2);
+  if (delay<0) {
+    delay = 0; /* clocks drifted during the exchange */
+  }
+  if ((int32_t)(t4-t1)<0 || delay>TSYNC_CONFIG_MAX_DELAY_US) {
+    return ERR_FAILED;
+  }
+  sample = &est->samples[est->sampleIdx];
+  sample->localUs = t4;
+  sample->offsetUs = ((int32_t)(t2-t1)+(int32_t)(t3-t4))/2;
+  sample->delayUs = (uint32_t)delay;
+  est->sampleIdx = (uint8_t)((est->sampleIdx+1)%TSYNC_FILTER_SIZE);
+  if (est->nofSamples<TSYNC_FILTER_SIZE) {
+    est->nofSamples++;
+  }
+  /* clock filter: the sample with the smallest delay has the smallest error */
+  best = &est->samples[0];
+  for(i=1;i<est->nofSamples;i++) {
+    if (est->samples[i].delayUs<best->delayUs) {
+      best = &est->samples[i];
+    }
+  }
+  if (est->synced && best->localUs==est->ref.localUs) {
+    return ERR_OK; /* no better reference */
+  }
+  est->ref = *best;
+  est->synced = TRUE;
+  /* drift estimation with points at least TSYNC_CONFIG_POINT_INTERVAL_US apart */
+  last = &est->points[(est->pointIdx+TSYNC_NOF_POINTS-1)%TSYNC_NOF_POINTS];
+  if (est->nofPoints==0 || (int32_t)(best->localUs-last->localUs)>=TSYNC_CONFIG_POINT_INTERVAL_US) {
+    est->points[est->pointIdx] = *best;
+    est->pointIdx = (uint8_t)((est->pointIdx+1)%TSYNC_NOF_POINTS);
+    if (est->nofPoints<TSYNC_NOF_POINTS) {
+      est->nofPoints++;
+    }
+    EstimateDrift(est);
+  } else if ((int32_t)(best->localUs-last->localUs)>0 && best->delayUs<last->delayUs) {
+    *last = *best; /* better point within the interval */
+    EstimateDrift(est);
+  }
+  return ERR_OK;
+}
+
+bool TSYNC_EstimatorToShared(const TSYNC_Estimator *est, uint32_t localUs, uint32_t *sharedUs, uint32_t *errUs) {
+  int32_t dt;
+  uint32_t absDt;
+
+  if (!est->synced) {
+    *sharedUs = localUs;
+    *errUs = TSYNC_ERR_UNKNOWN;
+    return FALSE;
+  }
+  dt = (int32_t)(localUs-est->ref.localUs);
+  absDt = (uint32_t)(dt<0?-dt:dt);
+  *sharedUs = localUs+(uint32_t)est->ref.offsetUs+(uint32_t)(int32_t)(((int64_t)est->driftPpb*dt)/1000000000);
+  *errUs = est->ref.delayUs/2+TSYNC_CONFIG_RESOLUTION_US
+         +(uint32_t)(((uint64_t)absDt*est->driftErrPpb)/1000000000);
+  return TRUE;
+}
+
+#if !TSYNC_CONFIG_HOST
+#ifndef TSYNC_CONFIG_IS_MASTER
+  #define TSYNC_CONFIG_IS_MASTER  (!PL_CONFIG_BOARD_IS_ROBO) /* the remote or time keeping system provides the shared time */
+#endif
+#define TSYNC_CONFIG_PERIOD_MS        (1000) /* request period until the drift is known */
+#define TSYNC_CONFIG_PERIOD_SLOW_MS   (4000) /* request period afterwards */
+
+/* SysTick registers for the time within the current tick */
+#define TSYNC_SYST_RVR        (*((volatile uint32_t*)0xE000E014)) /* reload value */
+#define TSYNC_SYST_CVR        (*((volatile uint32_t*)0xE000E018)) /* current value, counts down */
+#define TSYNC_ICSR            (*((volatile uint32_t*)0xE000ED04)) /* interrupt control and state */
+#define TSYNC_ICSR_PENDSTSET  (1UL<<26) /* SysTick interrupt pending */
+
+static TSYNC_Estimator TSYNC_Est;
+static struct {
+  bool pending;          /* waiting for a response */
+  uint32_t t1;           /* local time of the last request */
+  TickType_t lastTick;   /* time of the last request */
+  uint32_t nofReq;       /* requests sent (client) or received (master) */
+  uint32_t nofResp;      /* responses received (client) */
+  uint32_t nofLost;      /* requests without a response (client) */
+  uint32_t nofRejected;  /* responses with a too large delay (client) */
+} TSYNC_Stat;
+
+uint32_t TSYNC_GetLocalUs(void) {
+  TickType_t ticks;
+  uint32_t cvr, load;
+
+  taskENTER_CRITICAL();
+  ticks = xTaskGetTickCount();
+  cvr = TSYNC_SYST_CVR;
+  if (TSYNC_ICSR&TSYNC_ICSR_PENDSTSET) { /* counter has been reloaded, but the tick count not incremented yet */
+    ticks++;
+    cvr = TSYNC_SYST_CVR;
+  }
+  load = TSYNC_SYST_RVR+1;
+  taskEXIT_CRITICAL();
+  return (uint32_t)ticks*(portTICK_PERIOD_MS*1000)+((load-1-cvr)*(portTICK_PERIOD_MS*1000))/load;
+}
+
+bool TSYNC_GetSharedUs(uint32_t *us, uint32_t *errUs) {
+  bool synced;
+  uint32_t local;
+
+  local = TSYNC_GetLocalUs();
+#if TSYNC_CONFIG_IS_MASTER
+  *us = local;
+  *errUs = 0;
+  synced = TRUE;
+#else
+  taskENTER_CRITICAL();
+  synced = TSYNC_EstimatorToShared(&TSYNC_Est, local, us, errUs);
+  taskEXIT_CRITICAL();
+#endif
+  return synced;
+}
+
+static uint8_t TSYNC_HandleRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet) {
+  uint32_t t4;
+#if TSYNC_CONFIG_IS_MASTER
+  uint32_t t2;
+  uint8_t buf[12];
+#endif
+
+  (void)packet;
+  (void)srcAddr; /* only used by the master */
+  t4 = TSYNC_GetLocalUs(); /* as early as possible */
+  switch(type) {
+#if TSYNC_CONFIG_IS_MASTER
+    case RAPP_MSG_TYPE_TIME_SYNC_REQ: /* t1 */
+      if (size==4) {
+        *handled = TRUE;
+        t2 = t4; /* receive time */
+        TSYNC_Stat.nofReq++;
+        buf[0] = data[0]; buf[1] = data[1]; buf[2] = data[2]; buf[3] = data[3]; /* t1 */
+        UTIL1_SetValue32LE(t2, &buf[4]);
+        UTIL1_SetValue32LE(TSYNC_GetLocalUs(), &buf[8]); /* t3 */
+        (void)RAPP_SendPayloadDataBlock(buf, sizeof(buf), RAPP_MSG_TYPE_TIME_SYNC_RESP, srcAddr, RPHY_PACKET_FLAGS_NONE);
+      }
+      break;
+#else
+    case RAPP_MSG_TYPE_TIME_SYNC_RESP: /* t1:t2:t3 */
+      if (size==12) {
+        *handled = TRUE;
+        if (TSYNC_Stat.pending && UTIL1_GetValue32LE(&data[0])==TSYNC_Stat.t1) { /* response to our last request */
+          TSYNC_Stat.pending = FALSE;
+          TSYNC_Stat.nofResp++;
+          taskENTER_CRITICAL();
+          if (TSYNC_EstimatorAddSample(&TSYNC_Est, TSYNC_Stat.t1, UTIL1_GetValue32LE(&data[4]), UTIL1_GetValue32LE(&data[8]), t4)!=ERR_OK) {
+            TSYNC_Stat.nofRejected++;
+          }
+          taskEXIT_CRITICAL();
+        }
+      }
+      break;
+#endif
+    default:
+      break;
+  }
+  return ERR_OK;
+}
+
+void TSYNC_Process(void) {
+#if !TSYNC_CONFIG_IS_MASTER
+  uint8_t buf[4];
+  TickType_t now;
+
+  now = xTaskGetTickCount();
+  if ((now-TSYNC_Stat.lastTick)*portTICK_PERIOD_MS < (TSYNC_Est.haveDrift?TSYNC_CONFIG_PERIOD_SLOW_MS:TSYNC_CONFIG_PERIOD_MS)) {
+    return;
+  }
+  TSYNC_Stat.lastTick = now;
+  if (TSYNC_Stat.pending) {
+    TSYNC_Stat.nofLost++; /* request or response got lost */
+  }
+  TSYNC_Stat.t1 = TSYNC_GetLocalUs();
+  UTIL1_SetValue32LE(TSYNC_Stat.t1, buf);
+  TSYNC_Stat.pending = RAPP_SendPayloadDataBlock(buf, sizeof(buf), RAPP_MSG_TYPE_TIME_SYNC_REQ, APP_RNET_ADDR_TIME_SYSTEM, RPHY_PACKET_FLAGS_NONE)==ERR_OK;
+  TSYNC_Stat.nofReq++;
+#endif
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void TSYNC_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[40];
+  uint32_t us, errUs;
+  bool synced;
+
+  CLS1_SendStatusStr((unsigned char*)"tsync", (unsigned char*)"\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  role", TSYNC_CONFIG_IS_MASTER?(unsigned char*)"master\r\n":(unsigned char*)"client\r\n", io->stdOut);
+  synced = TSYNC_GetSharedUs(&us, &errUs);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), us);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us");
+  if (synced) {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" +/-");
+    UTIL1_strcatNum32u(buf, sizeof(buf), errUs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  } else {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (not synchronised)\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  shared time", buf, io->stdOut);
+#if !TSYNC_CONFIG_IS_MASTER
+  buf[0] = '\0';
+  UTIL1_strcatNum32s(buf, sizeof(buf), TSYNC_Est.ref.offsetUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us, delay ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), TSYNC_Est.ref.delayUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  offset", buf, io->stdOut);
+  buf[0] = '\0';
+  if (TSYNC_Est.haveDrift) {
+    UTIL1_strcatNum32s(buf, sizeof(buf), TSYNC_Est.driftPpb);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ppb\r\n");
+  } else {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"unknown\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  drift", buf, io->stdOut);
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), TSYNC_Stat.nofResp);
+  UTIL1_chcat(buf, sizeof(buf), '/');
+  UTIL1_strcatNum32u(buf, sizeof(buf), TSYNC_Stat.nofReq);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", lost ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), TSYNC_Stat.nofLost);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", rejected ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), TSYNC_Stat.nofRejected);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  responses", buf, io->stdOut);
+#else
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), TSYNC_Stat.nofReq);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  requests", buf, io->stdOut);
+#endif
+}
+
+static void TSYNC_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"tsync", (unsigned char*)"Group of clock synchronisation commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows time sync help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Restarts the synchronisation\r\n", io->stdOut);
+}
+
+uint8_t TSYNC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"tsync help")==0) {
+    TSYNC_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"tsync status")==0) {
+    TSYNC_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"tsync reset")==0) {
+    taskENTER_CRITICAL();
+    TSYNC_EstimatorReset(&TSYNC_Est);
+    taskEXIT_CRITICAL();
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void TSYNC_Deinit(void) {
+  /* nothing to do */
+}
+
+void TSYNC_Init(void) {
+  TSYNC_EstimatorReset(&TSYNC_Est);
+  TSYNC_Stat.pending = FALSE;
+  TSYNC_Stat.lastTick = 0;
+  TSYNC_Stat.nofReq = TSYNC_Stat.nofResp = TSYNC_Stat.nofLost = TSYNC_Stat.nofRejected = 0;
+#if TSYNC_CONFIG_IS_MASTER
+  if (RNETA_RegisterMsgHandler(RAPP_MSG_TYPE_TIME_SYNC_REQ, TSYNC_HandleRxMessage)!=ERR_OK) {
+    for(;;){} /* error */
+  }
+#else
+  if (RNETA_RegisterMsgHandler(RAPP_MSG_TYPE_TIME_SYNC_RESP, TSYNC_HandleRxMessage)!=ERR_OK) {
+    for(;;){} /* error */
+  }
+#endif
+}
+#endif /* !TSYNC_CONFIG_HOST */
+
+#endif /* PL_CONFIG_HAS_TIME_SYNC */
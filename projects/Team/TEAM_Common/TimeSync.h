@@ -0,0 +1,116 @@
+/**
+ * \file
+ * \brief Interface of the clock synchronisation between the nodes.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * All nodes share a microsecond timebase, which is the local clock of the master node.
+ * The other nodes estimate offset and drift to it with NTP style round trip measurements over the radio.
+ */
+
+#ifndef TIMESYNC_H_
+#define TIMESYNC_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TIME_SYNC
+
+#ifndef TSYNC_CONFIG_HOST
+  #define TSYNC_CONFIG_HOST   (0) /* 1: built for the host, only the estimator without RTOS and radio */
+#endif
+
+#if PL_CONFIG_HAS_SHELL && !TSYNC_CONFIG_HOST
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t TSYNC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+#define TSYNC_ERR_UNKNOWN   (0xffffffffUL) /*!< error bound if the time is not synchronised */
+
+#define TSYNC_FILTER_SIZE   (8) /*!< round trip samples in the clock filter */
+#define TSYNC_NOF_POINTS    (8) /*!< filtered offsets used to estimate the drift */
+
+/*! \brief One round trip measurement */
+typedef struct {
+  uint32_t localUs;  /*!< local time when the response has been received */
+  int32_t offsetUs;  /*!< estimated offset of the shared time against the local time */
+  uint32_t delayUs;  /*!< round trip delay without the processing time on the master */
+} TSYNC_Sample;
+
+/*! \brief Offset and drift estimator, a clock filter followed by a least squares fit */
+typedef struct {
+  TSYNC_Sample samples[TSYNC_FILTER_SIZE]; /*!< last round trip samples */
+  uint8_t nofSamples;        /*!< number of valid samples */
+  uint8_t sampleIdx;         /*!< next entry in samples[] */
+  TSYNC_Sample points[TSYNC_NOF_POINTS]; /*!< filtered samples for the drift estimation */
+  uint8_t nofPoints;         /*!< number of valid points */
+  uint8_t pointIdx;          /*!< next entry in points[] */
+  bool synced;               /*!< TRUE if a reference is available */
+  bool haveDrift;            /*!< TRUE if the drift has been estimated */
+  TSYNC_Sample ref;          /*!< reference: best sample of the clock filter */
+  int32_t driftPpb;          /*!< drift of the shared time against the local time, in parts per billion */
+  int32_t driftErrPpb;       /*!< error bound of the drift, in parts per billion */
+} TSYNC_Estimator;
+
+/*!
+ * \brief Resets an estimator, it is not synchronised afterwards.
+ * \param est Estimator.
+ */
+void TSYNC_EstimatorReset(TSYNC_Estimator *est);
+
+/*!
+ * \brief Adds a round trip measurement.
+ * \param est Estimator.
+ * \param t1 Local time when the request has been sent.
+ * \param t2 Master time when the request has been received.
+ * \param t3 Master time when the response has been sent.
+ * \param t4 Local time when the response has been received.
+ * \return ERR_OK if the sample has been used, ERR_FAILED if it has been rejected.
+ */
+uint8_t TSYNC_EstimatorAddSample(TSYNC_Estimator *est, uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4);
+
+/*!
+ * \brief Converts a local time into the shared time.
+ * \param est Estimator.
+ * \param localUs Local time.
+ * \param sharedUs Where to store the shared time.
+ * \param errUs Where to store the error bound, TSYNC_ERR_UNKNOWN if not synchronised.
+ * \return TRUE if synchronised, otherwise the local time is returned.
+ */
+bool TSYNC_EstimatorToShared(const TSYNC_Estimator *est, uint32_t localUs, uint32_t *sharedUs, uint32_t *errUs);
+
+#if !TSYNC_CONFIG_HOST
+/*!
+ * \brief Returns the local time, based on the RTOS tick counter and the SysTick timer.
+ * \return Local time in microseconds, wraps around after about 71 minutes.
+ */
+uint32_t TSYNC_GetLocalUs(void);
+
+/*!
+ * \brief Returns the current shared time. Used to time stamp events at the source.
+ * \param us Where to store the shared time in microseconds.
+ * \param errUs Where to store the error bound in microseconds, TSYNC_ERR_UNKNOWN if not synchronised.
+ * \return TRUE if synchronised (or the master), FALSE otherwise.
+ */
+bool TSYNC_GetSharedUs(uint32_t *us, uint32_t *errUs);
+
+/*!
+ * \brief Called periodically from the radio task, sends the synchronisation requests.
+ */
+void TSYNC_Process(void);
+
+/*! \brief De-initializes the module. */
+void TSYNC_Deinit(void);
+
+/*! \brief Initializes the module. */
+void TSYNC_Init(void);
+#endif /* !TSYNC_CONFIG_HOST */
+
+#endif /* PL_CONFIG_HAS_TIME_SYNC */
+
+#endif /* TIMESYNC_H_ */
@@ -18,6 +18,12 @@
 #if PL_CONFIG_HAS_MOTOR_TACHO
   #include "Tacho.h"
 #endif
+#if PL_CONFIG_HAS_DEBOUNCE
+  #include "KeyDebounce.h"
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+#endif
 #include "TMOUT1.h"
 
 void TMR_OnInterrupt(void) {
@@ -38,9 +44,27 @@ void TMR_OnInterrupt(void) {
 #if PL_CONFIG_HAS_TRIGGER
 	TRG_AddTick();		//Dem Trigger einen Tick hinzufgen
 #endif
+#if PL_CONFIG_HAS_DEBOUNCE
+	KEYDBNC_AddTick();	/* sample and debounce keys */
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+	CTRL_OnTimerInterrupt(); /* releases the control cycles */
+#endif
 
 }
 
+void TMR_AddTicks(uint32_t nofTicks) {
+  /* called from the idle task (LP_CompensateTicks()) with the ticks missed during tickless idle, not from an interrupt */
+#if PL_CONFIG_HAS_TRIGGER
+  while(nofTicks>0xffff) { /* trigger time is only 16bit */
+    TRG_AddTicks(0xffff);
+    nofTicks -= 0xffff;
+  }
+  TRG_AddTicks((TRG_TriggerTime)nofTicks);
+#endif
+  /* keys are not sampled while sleeping: tickless idle is only entered with all keys released (see KEYDBNC_IsIdle()) */
+}
+
 void TMR_Init(void) {
 }
 
@@ -20,6 +20,12 @@
 /*! \brief Function called from timer interrupt every TMR_TICK_MS. */
 void TMR_OnInterrupt(void);
 
+/*!
+ * \brief Catches up with ticks which have been suppressed by the RTOS tickless idle mode.
+ * \param nofTicks Number of TMR_TICK_MS ticks which have been missed.
+ */
+void TMR_AddTicks(uint32_t nofTicks);
+
 /*! \brief Timer driver initialization */
 void TMR_Init(void);
 
@@ -0,0 +1,547 @@
+/**
+ * \file
+ * \brief Learned track map for line following, see TrackMap.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Curvatures are in 1/km, as in SpeedPlan.c: heading change (dr-dl)/track over the driven distance of the bin.
+ * Matching compares curvatures with the sum of the absolute differences. A lap is closed after the heading
+ * has turned by 2*pi: the end of the lap is searched around this bin, comparing the curvature from
+ * TMAP_CLOSE_START on with the one a lap later, so the lap ends on the start line of the first lap.
+ * While replaying, the bins driven last are compared with the map around the position the distance gives,
+ * and the position is moved towards the best match. Straights have no curvature, so they keep the position.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TRACK_MAP
+#include "TrackMap.h"
+#include "SpeedPlan.h"
+#include "FRTOS1.h"
+#include "CS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  #include "LineFollow.h"
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  #include "NVM_Config.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+  #define TMAP_COUNTS_PER_M      ((int32_t)HWP_Get()->countsPerM)
+#else
+  #define TMAP_COUNTS_PER_M      SPLAN_CONFIG_COUNTS_PER_M
+#endif
+
+#define TMAP_MAGIC              (0x4D54) /* 'TM' in the stored map, if valid */
+#define TMAP_FULL_CIRCLE        ((SPLAN_CONFIG_TRACK_COUNTS*6283)/1000) /* difference of the wheel counts for a heading change of 2*pi */
+#define TMAP_CLOSE_START        (8)    /* bins at the start not used to close the lap, the robot settles on the line */
+#define TMAP_CLOSE_MAX_WINDOW   (32)   /* search for the end of the lap at most this number of bins around the full circle */
+#if PL_CONFIG_HAS_LAP_TIME
+  #define TMAP_NOF_BIN_TIMES    (128)  /* times of the last bins, to time the first lap: more than the bins driven to close it */
+#endif
+#define TMAP_SPEED_LEAD_BINS    (2)    /* speed of the map ahead of the position, for the delay of the motors */
+#define TMAP_STEER_LEAD_BINS    (2)    /* curvature of the map ahead of the position, for the feedforward steering */
+#define TMAP_MAX_LINE_ERROR     (2000) /* line error up to which the map sets the speed: 2 sensor distances */
+#define TMAP_SYNC_MIN_CURV      (500)  /* mean absolute curvature of the last bins needed to find the position on the whole map */
+#define TMAP_STRAIGHT_CURV      (500)  /* below this curvature a bin counts as straight, for 'track map' */
+
+typedef enum {
+  TMAP_STATE_IDLE,      /* not following, or no map */
+  TMAP_STATE_LEARN,     /* learning the curvature of the first lap */
+  TMAP_STATE_CLOSE,     /* heading has turned a full circle, learning the bins to find the end of the lap */
+  TMAP_STATE_REPLAY     /* driving with the map */
+} TMAP_StateKind;
+
+/* map as stored in flash, see NVMC_TRACK_DATA_SIZE */
+typedef struct {
+  uint16_t magic;       /* TMAP_MAGIC if the map is valid */
+  uint16_t nofBins;     /* bins of the lap */
+  int16_t curv[TMAP_CONFIG_NOF_BINS]; /* curvature of the bins, positive to the left */
+} TMAP_Data;
+
+static TMAP_Data TMAP_Map;
+static uint16_t TMAP_Speed[TMAP_CONFIG_NOF_BINS]; /* speed profile of the map in mm/s, see SPLAN_PlanProfile() */
+
+static struct {
+  bool on;              /* use the map, learn it if there is none */
+  bool learn;           /* learn a new map at the next start */
+  uint8_t ffPercent;    /* gain of the feedforward steering */
+} TMAP_Cfg;
+
+static struct {
+  TMAP_StateKind state;
+  bool synced;          /* replay: position on the map is known */
+  int32_t left, right;  /* counts of the current bin */
+  int32_t heading;      /* learning: sum of dr-dl since the start */
+  uint16_t bin;         /* learning: number of learned bins, replay: current bin on the map */
+  uint16_t closeBin;    /* learning: bin where the heading has turned a full circle */
+  uint16_t binsInLap;   /* replay: bins driven since the start of the lap */
+  int16_t recent[TMAP_CONFIG_SYNC_BINS]; /* replay: curvature of the last bins */
+  uint8_t recentIdx;    /* next entry in recent[] */
+  uint8_t nofRecent;    /* valid entries in recent[] */
+#if PL_CONFIG_HAS_LAP_TIME
+  uint32_t binUs[TMAP_NOF_BIN_TIMES]; /* learning: time at the end of the bins, see LAPT_GetTimeUs() */
+#endif
+  bool lapLost;         /* lost the sync in the current lap */
+} TMAP_State;
+
+static int32_t BinCounts(void) {
+  return (TMAP_CONFIG_BIN_MM*TMAP_COUNTS_PER_M)/1000;
+}
+
+static bool HaveMap(void) {
+  return TMAP_Map.magic==TMAP_MAGIC && TMAP_Map.nofBins>0 && TMAP_Map.nofBins<=TMAP_CONFIG_NOF_BINS;
+}
+
+/* wraps a bin index onto the map */
+static uint16_t MapBin(int32_t bin) {
+  bin %= (int32_t)TMAP_Map.nofBins;
+  if (bin<0) {
+    bin += TMAP_Map.nofBins;
+  }
+  return (uint16_t)bin;
+}
+
+/* sum of the absolute differences between the last bins and the map, the newest bin compared with 'bin' */
+static int32_t SyncError(int32_t bin) {
+  int32_t err = 0, diff;
+  uint8_t i, idx;
+
+  idx = TMAP_State.recentIdx; /* oldest entry */
+  bin -= TMAP_CONFIG_SYNC_BINS-1;
+  for(i=0;i<TMAP_CONFIG_SYNC_BINS;i++) {
+    diff = TMAP_State.recent[idx]-TMAP_Map.curv[MapBin(bin+i)];
+    err += diff<0 ? -diff : diff;
+    idx++;
+    if (idx>=TMAP_CONFIG_SYNC_BINS) {
+      idx = 0;
+    }
+  }
+  return err;
+}
+
+/* corrects the position on the map with the curvature of the last bins, 'bin' is the bin just driven */
+static void Sync(uint16_t bin) {
+  int32_t err, err0, bestErr, sumAbs;
+  int32_t offset, best;
+  uint8_t i;
+
+  if (TMAP_State.nofRecent<TMAP_CONFIG_SYNC_BINS) {
+    return; /* not enough bins driven yet */
+  }
+  sumAbs = 0;
+  for(i=0;i<TMAP_CONFIG_SYNC_BINS;i++) {
+    sumAbs += TMAP_State.recent[i]<0 ? -TMAP_State.recent[i] : TMAP_State.recent[i];
+  }
+  best = 0;
+  if (TMAP_State.synced) { /* search around the position, on equal errors the nearest offset wins */
+    err0 = SyncError(bin);
+    bestErr = err0;
+    for(offset=1;offset<=TMAP_CONFIG_SYNC_SEARCH_BINS;offset++) {
+      err = SyncError(bin+offset);
+      if (err<bestErr) {
+        bestErr = err;
+        best = offset;
+      }
+      err = SyncError(bin-offset);
+      if (err<bestErr) {
+        bestErr = err;
+        best = -offset;
+      }
+    }
+    if (bestErr>sumAbs/2+TMAP_CONFIG_SYNC_BINS*TMAP_STRAIGHT_CURV) { /* does not look like the map any more */
+      TMAP_State.synced = FALSE;
+      TMAP_State.lapLost = TRUE;
+      return;
+    }
+    /* the curvature of the path changes with the speed: move by one bin, and only for a clearly better match */
+    if (bestErr>err0-err0/4) {
+      best = 0;
+    } else if (best>0) {
+      best = 1;
+    } else {
+      best = -1;
+    }
+  } else { /* search on the whole map, only with curves in the last bins */
+    if (sumAbs<TMAP_CONFIG_SYNC_BINS*TMAP_SYNC_MIN_CURV) {
+      return;
+    }
+    bestErr = SyncError(bin);
+    for(offset=1;offset<TMAP_Map.nofBins;offset++) {
+      err = SyncError(bin+offset);
+      if (err<bestErr) {
+        bestErr = err;
+        best = offset;
+      }
+    }
+    if (bestErr>sumAbs/4) {
+      return; /* no good match */
+    }
+    TMAP_State.synced = TRUE;
+  }
+  TMAP_State.bin = MapBin((int32_t)TMAP_State.bin+best);
+}
+
+/* learning: the heading has turned a full circle and enough bins are learned, find the end of the lap */
+static void CloseLap(void) {
+  int32_t err, bestErr, diff, window;
+  uint16_t len, bestLen, i, driven;
+
+  window = TMAP_State.closeBin/8;
+  if (window>TMAP_CLOSE_MAX_WINDOW) {
+    window = TMAP_CLOSE_MAX_WINDOW;
+  }
+  bestErr = -1;
+  bestLen = TMAP_State.closeBin;
+  for(len=TMAP_State.closeBin-window;len<=TMAP_State.closeBin+window;len++) {
+    err = 0;
+    for(i=TMAP_CLOSE_START;i<TMAP_CLOSE_START+TMAP_CONFIG_CLOSE_BINS;i++) {
+      diff = TMAP_Map.curv[i]-TMAP_Map.curv[len+i];
+      err += diff<0 ? -diff : diff;
+    }
+    if (bestErr<0 || err<bestErr) {
+      bestErr = err;
+      bestLen = len;
+    }
+  }
+  driven = TMAP_State.bin-bestLen;
+#if PL_CONFIG_HAS_LAP_TIME
+  /* the first lap ended at the end of bin bestLen-1 */
+  LAPT_OnEventAt(LAPT_EVENT_LAP, LAPT_SOURCE_TRACK, TMAP_LAP_LEARN, TMAP_State.binUs[(bestLen-1)%TMAP_NOF_BIN_TIMES], 0);
+#endif
+  /* the bins after the lap are the start of the next one */
+  TMAP_Map.nofBins = bestLen;
+  TMAP_Map.magic = TMAP_MAGIC;
+  TMAP_Plan();
+  TMAP_State.nofRecent = 0;
+  TMAP_State.recentIdx = 0;
+  for(i=TMAP_State.bin-TMAP_CONFIG_SYNC_BINS;i<TMAP_State.bin;i++) {
+    TMAP_State.recent[TMAP_State.recentIdx++] = TMAP_Map.curv[i];
+  }
+  TMAP_State.recentIdx = 0;
+  TMAP_State.nofRecent = TMAP_CONFIG_SYNC_BINS;
+  TMAP_State.bin = MapBin(driven);
+  TMAP_State.binsInLap = driven;
+  TMAP_State.synced = TRUE;
+  TMAP_State.lapLost = FALSE;
+  TMAP_State.state = TMAP_STATE_REPLAY;
+}
+
+/* a bin has been driven */
+static void AddBin(int32_t curv) {
+  uint16_t bin;
+
+  if (curv>0x7fff) {
+    curv = 0x7fff;
+  } else if (curv<-0x7fff) {
+    curv = -0x7fff;
+  }
+  if (TMAP_State.state==TMAP_STATE_LEARN || TMAP_State.state==TMAP_STATE_CLOSE) {
+    if (TMAP_State.bin>=TMAP_CONFIG_NOF_BINS) {
+      TMAP_State.state = TMAP_STATE_IDLE; /* lap too long, or no closed line */
+      return;
+    }
+    TMAP_Map.curv[TMAP_State.bin] = (int16_t)curv;
+#if PL_CONFIG_HAS_LAP_TIME
+    TMAP_State.binUs[TMAP_State.bin%TMAP_NOF_BIN_TIMES] = LAPT_GetTimeUs();
+#endif
+    TMAP_State.bin++;
+    if (TMAP_State.state==TMAP_STATE_LEARN) {
+      if ((TMAP_State.heading>=TMAP_FULL_CIRCLE || TMAP_State.heading<=-TMAP_FULL_CIRCLE)
+          && TMAP_State.bin>TMAP_CLOSE_START+TMAP_CONFIG_CLOSE_BINS)
+      {
+        TMAP_State.closeBin = TMAP_State.bin;
+        TMAP_State.state = TMAP_STATE_CLOSE;
+      }
+    } else {
+      bin = TMAP_State.closeBin+TMAP_State.closeBin/8+TMAP_CLOSE_START+TMAP_CONFIG_CLOSE_BINS;
+      if (TMAP_State.closeBin/8>TMAP_CLOSE_MAX_WINDOW) {
+        bin = TMAP_State.closeBin+TMAP_CLOSE_MAX_WINDOW+TMAP_CLOSE_START+TMAP_CONFIG_CLOSE_BINS;
+      }
+      if (TMAP_State.bin>=bin) {
+        CloseLap();
+      }
+    }
+  } else if (TMAP_State.state==TMAP_STATE_REPLAY) {
+    bin = TMAP_State.bin;
+    TMAP_State.recent[TMAP_State.recentIdx] = (int16_t)curv;
+    TMAP_State.recentIdx++;
+    if (TMAP_State.recentIdx>=TMAP_CONFIG_SYNC_BINS) {
+      TMAP_State.recentIdx = 0;
+    }
+    if (TMAP_State.nofRecent<TMAP_CONFIG_SYNC_BINS) {
+      TMAP_State.nofRecent++;
+    }
+    TMAP_State.bin = MapBin(bin+1);
+    Sync(bin);
+    TMAP_State.binsInLap++;
+    if (TMAP_State.bin<bin && TMAP_State.binsInLap>TMAP_Map.nofBins/2) { /* passed the end of the lap */
+#if PL_CONFIG_HAS_LAP_TIME
+      LAPT_OnEvent(LAPT_EVENT_LAP, LAPT_SOURCE_TRACK, TMAP_State.lapLost ? TMAP_LAP_LOST : TMAP_LAP_MAP);
+#endif
+      TMAP_State.binsInLap = 0;
+      TMAP_State.lapLost = !TMAP_State.synced;
+    }
+    if (!TMAP_State.synced) {
+      TMAP_State.lapLost = TRUE;
+    }
+  }
+}
+
+void TMAP_AddDistance(int32_t dl, int32_t dr) {
+  int32_t ds, curv;
+
+  if (TMAP_State.state==TMAP_STATE_IDLE) {
+    return;
+  }
+  TMAP_State.heading += dr-dl;
+  TMAP_State.left += dl;
+  TMAP_State.right += dr;
+  ds = (TMAP_State.left+TMAP_State.right)/2;
+  if (ds<BinCounts()) {
+    return; /* bin not complete yet */
+  }
+  curv = ((TMAP_State.right-TMAP_State.left)*TMAP_COUNTS_PER_M)/SPLAN_CONFIG_TRACK_COUNTS; /* heading change (rad) times counts per m */
+  curv = (curv*1000)/ds;
+  TMAP_State.left = TMAP_State.right = 0;
+  AddBin(curv);
+}
+
+int32_t TMAP_GetSpeedMmS(int32_t lineError) {
+  if (TMAP_State.state!=TMAP_STATE_REPLAY || !TMAP_State.synced) {
+    return 0;
+  }
+  if (lineError>TMAP_MAX_LINE_ERROR || lineError<-TMAP_MAX_LINE_ERROR) {
+    return 0; /* far off the line: the planner knows better */
+  }
+  return TMAP_Speed[MapBin(TMAP_State.bin+TMAP_SPEED_LEAD_BINS)];
+}
+
+int32_t TMAP_GetCurvature(void) {
+  int32_t curv;
+
+  if (TMAP_State.state!=TMAP_STATE_REPLAY || !TMAP_State.synced) {
+    return 0;
+  }
+  curv = TMAP_Map.curv[MapBin(TMAP_State.bin+TMAP_STEER_LEAD_BINS-1)]; /* mean of three bins, the learned curvature is noisy */
+  curv += TMAP_Map.curv[MapBin(TMAP_State.bin+TMAP_STEER_LEAD_BINS)];
+  curv += TMAP_Map.curv[MapBin(TMAP_State.bin+TMAP_STEER_LEAD_BINS+1)];
+  return (curv*(int32_t)TMAP_Cfg.ffPercent)/300;
+}
+
+void TMAP_Plan(void) {
+  if (HaveMap()) {
+    SPLAN_PlanProfile(TMAP_Map.curv, TMAP_Speed, TMAP_Map.nofBins, TMAP_CONFIG_BIN_MM);
+  }
+}
+
+void TMAP_OnStart(void) {
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  TMAP_State.lapLost = FALSE;
+  TMAP_State.left = TMAP_State.right = 0;
+  TMAP_State.heading = 0;
+  TMAP_State.bin = 0;
+  TMAP_State.binsInLap = 0;
+  TMAP_State.nofRecent = 0;
+  TMAP_State.recentIdx = 0;
+  if (!TMAP_Cfg.on) {
+    TMAP_State.state = TMAP_STATE_IDLE;
+  } else if (TMAP_Cfg.learn || !HaveMap()) {
+    TMAP_Cfg.learn = FALSE;
+    TMAP_Map.magic = 0; /* invalid until the lap is closed */
+    TMAP_State.state = TMAP_STATE_LEARN;
+  } else {
+    TMAP_State.synced = TRUE; /* starts on the start line of the map */
+    TMAP_State.state = TMAP_STATE_REPLAY;
+  }
+  CS1_ExitCritical();
+}
+
+void TMAP_OnSegmentEnd(void) {
+  TMAP_State.state = TMAP_STATE_IDLE;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void PrintValue(const unsigned char *title, int32_t val, const unsigned char *unit, const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), val);
+  UTIL1_strcat(buf, sizeof(buf), unit);
+  CLS1_SendStatusStr(title, buf, io->stdOut);
+}
+
+static void TMAP_PrintStatus(const CLS1_StdIOType *io) {
+  const unsigned char *state;
+
+  CLS1_SendStatusStr((unsigned char*)"track", TMAP_Cfg.on ? (unsigned char*)"on\r\n" : (unsigned char*)"off\r\n", io->stdOut);
+  switch(TMAP_State.state) {
+    case TMAP_STATE_IDLE:   state = (const unsigned char*)"idle\r\n"; break;
+    case TMAP_STATE_LEARN:  state = (const unsigned char*)"learning\r\n"; break;
+    case TMAP_STATE_CLOSE:  state = (const unsigned char*)"closing the lap\r\n"; break;
+    case TMAP_STATE_REPLAY: state = TMAP_State.synced ? (const unsigned char*)"replay, in sync\r\n" : (const unsigned char*)"replay, lost\r\n"; break;
+    default:                state = (const unsigned char*)"?\r\n"; break;
+  }
+  CLS1_SendStatusStr((unsigned char*)"  state", state, io->stdOut);
+  if (HaveMap()) {
+    PrintValue((unsigned char*)"  map", (int32_t)TMAP_Map.nofBins*TMAP_CONFIG_BIN_MM, (unsigned char*)" mm\r\n", io);
+  } else {
+    CLS1_SendStatusStr((unsigned char*)"  map", TMAP_Cfg.on ? (unsigned char*)"none, learns at the next start\r\n" : (unsigned char*)"none\r\n", io->stdOut);
+  }
+  if (TMAP_Cfg.learn) {
+    CLS1_SendStatusStr((unsigned char*)"  learn", (unsigned char*)"at the next start\r\n", io->stdOut);
+  }
+  PrintValue((unsigned char*)"  position", (int32_t)TMAP_State.bin*TMAP_CONFIG_BIN_MM, (unsigned char*)" mm\r\n", io);
+  PrintValue((unsigned char*)"  feedforward", TMAP_Cfg.ffPercent, (unsigned char*)"%\r\n", io);
+}
+
+/* prints the map as segments: straights, left and right curves with their length and tightest radius */
+static void TMAP_PrintMap(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  uint16_t i, start;
+  int32_t curv, maxCurv;
+  int kind, segKind;
+
+  if (!HaveMap()) {
+    CLS1_SendStr((unsigned char*)"no map\r\n", io->stdErr);
+    return;
+  }
+  start = 0;
+  maxCurv = 0;
+  segKind = 0;
+  for(i=0;i<=TMAP_Map.nofBins;i++) {
+    if (i<TMAP_Map.nofBins) {
+      curv = TMAP_Map.curv[i];
+      kind = curv>TMAP_STRAIGHT_CURV ? 1 : (curv<-TMAP_STRAIGHT_CURV ? -1 : 0);
+    } else {
+      curv = 0;
+      kind = 2; /* end of the map */
+    }
+    if (i==0) {
+      segKind = kind;
+    } else if (kind!=segKind) {
+      UTIL1_Num32uToStr(buf, sizeof(buf), (uint32_t)start*TMAP_CONFIG_BIN_MM);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm: ");
+      UTIL1_strcat(buf, sizeof(buf), segKind==0 ? (unsigned char*)"straight " : (segKind>0 ? (unsigned char*)"left " : (unsigned char*)"right "));
+      UTIL1_strcatNum32u(buf, sizeof(buf), (uint32_t)(i-start)*TMAP_CONFIG_BIN_MM);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm");
+      if (segKind!=0) {
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", radius ");
+        UTIL1_strcatNum32u(buf, sizeof(buf), 1000000UL/(uint32_t)maxCurv);
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm");
+      }
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+      CLS1_SendStr(buf, io->stdOut);
+      start = i;
+      maxCurv = 0;
+      segKind = kind;
+    }
+    if (curv<0) {
+      curv = -curv;
+    }
+    if (curv>maxCurv) {
+      maxCurv = curv;
+    }
+  }
+}
+
+static void TMAP_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"track", (unsigned char*)"Group of learned track map commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows track help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  on|off", (unsigned char*)"Drive with the map and learn it on the first lap, or only with the planner\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  learn", (unsigned char*)"Learns a new map at the next start\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  ff <percent>", (unsigned char*)"Gain of the feedforward steering from the map\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  map", (unsigned char*)"Prints the segments of the map\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Forgets the map\r\n", io->stdOut);
+#if PL_CONFIG_HAS_CONFIG_NVM
+  CLS1_SendHelpStr((unsigned char*)"  save", (unsigned char*)"Stores the map in flash, without a map it removes the stored one\r\n", io->stdOut);
+#endif
+}
+
+uint8_t TMAP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+  const unsigned char *p;
+  uint8_t val8u;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"track help")==0) {
+    TMAP_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"track status")==0) {
+    TMAP_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"track on")==0) {
+    TMAP_Cfg.on = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"track off")==0) {
+    TMAP_Cfg.on = FALSE;
+    TMAP_State.state = TMAP_STATE_IDLE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"track learn")==0) {
+    TMAP_Cfg.learn = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"track ff ", sizeof("track ff ")-1)==0) {
+    p = cmd+sizeof("track ff ")-1;
+    *handled = TRUE;
+    if (UTIL1_ScanDecimal8uNumber(&p, &val8u)!=ERR_OK || val8u>200) {
+      CLS1_SendStr((unsigned char*)"Wrong argument, must be 0..200\r\n", io->stdErr);
+      res = ERR_FAILED;
+    } else {
+      TMAP_Cfg.ffPercent = val8u;
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"track map")==0) {
+    TMAP_PrintMap(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"track clear")==0) {
+    TMAP_State.state = TMAP_STATE_IDLE;
+    TMAP_Map.magic = 0;
+    TMAP_Map.nofBins = 0;
+    *handled = TRUE;
+#if PL_CONFIG_HAS_CONFIG_NVM
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"track save")==0) {
+    *handled = TRUE;
+#if PL_CONFIG_HAS_LINE_FOLLOW
+    if (LF_IsFollowing()) {
+      CLS1_SendStr((unsigned char*)"Stop line following first\r\n", io->stdErr);
+      return ERR_BUSY;
+    }
+#endif
+    res = NVMC_SaveTrackData(&TMAP_Map, sizeof(TMAP_Map));
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Failed storing the map\r\n", io->stdErr);
+    }
+#endif
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void TMAP_Deinit(void) {
+  /* nothing needed */
+}
+
+void TMAP_Init(void) {
+#if PL_CONFIG_HAS_CONFIG_NVM
+  const TMAP_Data *stored = (const TMAP_Data*)NVMC_GetTrackData();
+#endif
+
+  TMAP_Cfg.on = TRUE;
+  TMAP_Cfg.learn = FALSE;
+  TMAP_Cfg.ffPercent = 40;
+  TMAP_State.state = TMAP_STATE_IDLE;
+  TMAP_Map.magic = 0;
+  TMAP_Map.nofBins = 0;
+#if PL_CONFIG_HAS_CONFIG_NVM
+  if (stored!=NULL && stored->magic==TMAP_MAGIC && stored->nofBins>0 && stored->nofBins<=TMAP_CONFIG_NOF_BINS) {
+    TMAP_Map = *stored;
+  }
+#endif
+  TMAP_Plan(); /* the planner has been initialized before */
+}
+
+#endif /* PL_CONFIG_HAS_TRACK_MAP */
@@ -0,0 +1,98 @@
+/**
+ * \file
+ * \brief Interface of the learned track map for line following.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * On the first lap of a run the robot learns the track: the curvature of the driven path from the wheel
+ * encoders, in bins of TMAP_CONFIG_BIN_MM against the driven distance. The lap is closed when the heading
+ * has turned a full circle, and its length is refined by matching the curvature at the start with the one
+ * driven after it. The speed planner (see SpeedPlan.h) turns the map into a speed profile, which brakes
+ * before the curves instead of in them, and into a feedforward steering for the line controller.
+ * On the following laps the position on the map is the driven distance, corrected by matching the curvature
+ * of the last bins with the map. While the robot is not in sync with the map, or the line sensor sees it far
+ * off the line, the planner falls back to its own curvature estimation.
+ * The map needs a closed line without intersections: every intersection ends the segment in LineFollow.c.
+ * Each lap is reported to the lap timing (see LapTime.h), tagged with how it has been driven. The map can
+ * be stored in flash.
+ */
+
+#ifndef TRACKMAP_H_
+#define TRACKMAP_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TRACK_MAP
+
+#ifndef TMAP_CONFIG_BIN_MM
+  #define TMAP_CONFIG_BIN_MM          (25)  /*!< driven distance of a map bin */
+#endif
+#ifndef TMAP_CONFIG_NOF_BINS
+  #define TMAP_CONFIG_NOF_BINS        (400) /*!< bins of the map, the lap plus the distance to close it must fit */
+#endif
+#ifndef TMAP_CONFIG_CLOSE_BINS
+  #define TMAP_CONFIG_CLOSE_BINS      (48)  /*!< bins compared to find the end of the lap */
+#endif
+#ifndef TMAP_CONFIG_SYNC_BINS
+  #define TMAP_CONFIG_SYNC_BINS       (24)  /*!< last driven bins compared with the map to correct the position */
+#endif
+#ifndef TMAP_CONFIG_SYNC_SEARCH_BINS
+  #define TMAP_CONFIG_SYNC_SEARCH_BINS (4)  /*!< position correction in bins, in each direction */
+#endif
+
+/*! \brief How a lap has been driven, the tag of the lap timing events */
+typedef enum {
+  TMAP_LAP_LEARN,   /*!< learning the map, with the speed of the planner */
+  TMAP_LAP_MAP,     /*!< with the profile of the map */
+  TMAP_LAP_LOST     /*!< with the map, but not in sync for a part of the lap */
+} TMAP_LapMode;
+
+/*! \brief Starts a run of line following on the start line: learns the map if needed, else drives the map from its start */
+void TMAP_OnStart(void);
+
+/*! \brief The robot has left the mapped line (end of the segment or stop): no learning or replay until the next start */
+void TMAP_OnSegmentEnd(void);
+
+/*!
+ * \brief Adds the distance driven in a control step, call it from SPLAN_Step().
+ * \param dl Counts of the left wheel.
+ * \param dr Counts of the right wheel.
+ */
+void TMAP_AddDistance(int32_t dl, int32_t dr);
+
+/*!
+ * \brief Returns the speed of the map at the current position.
+ * \param lineError Line position minus the middle position, the map is not used if the robot is too far off the line.
+ * \return Speed in mm/s, 0 if the map is not used.
+ */
+int32_t TMAP_GetSpeedMmS(int32_t lineError);
+
+/*!
+ * \brief Returns the curvature of the map for the feedforward steering.
+ * \return Curvature in 1/km, positive for a left curve, 0 if the map is not used.
+ */
+int32_t TMAP_GetCurvature(void);
+
+/*! \brief Plans the speed profile of the map again, call it if the limits of the planner have changed */
+void TMAP_Plan(void);
+
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+
+/*!
+ * \brief Shell parser routine.
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t TMAP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Driver de-initialization */
+void TMAP_Deinit(void);
+
+/*! \brief Driver initialization, loads a stored map */
+void TMAP_Init(void);
+
+#endif /* PL_CONFIG_HAS_TRACK_MAP */
+
+#endif /* TRACKMAP_H_ */
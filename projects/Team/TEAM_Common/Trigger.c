@@ -77,6 +77,43 @@ void TRG_AddTick(void) {
   } while(res);
 }
 
+void TRG_AddTicks(TRG_TriggerTime nofTicks) {
+  TRG_TriggerKind i;
+  uint8_t res;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=(TRG_TriggerKind)0;i<TRG_NOF_TRIGGERS;i++) {
+    if (TRG_Triggers[i].ticks>nofTicks) {
+      TRG_Triggers[i].ticks -= nofTicks;
+    } else { /* expired while we were sleeping */
+      TRG_Triggers[i].ticks = 0;
+    }
+  } /* for */
+  CS1_ExitCritical();
+  do {
+    res = CheckCallbacks(); /* while there are callbacks, re-iterate */
+  } while(res);
+}
+
+TRG_TriggerTime TRG_TicksToNextTrigger(void) {
+  TRG_TriggerKind i;
+  TRG_TriggerTime min = 0;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=(TRG_TriggerKind)0;i<TRG_NOF_TRIGGERS;i++) {
+    if (TRG_Triggers[i].callback!=NULL && (min==0 || TRG_Triggers[i].ticks<min)) {
+      min = TRG_Triggers[i].ticks;
+      if (min==0) { /* fires with the next tick */
+        min = 1;
+      }
+    }
+  } /* for */
+  CS1_ExitCritical();
+  return min;
+}
+
 void TRG_Deinit(void) {
   /* nothing to do */
 }
@@ -48,6 +48,18 @@ uint8_t TRG_SetTrigger(TRG_TriggerKind trigger, TRG_TriggerTime ticks, TRG_Callb
 /*! \brief Called from interrupt service routine with a period of TRG_TICKS_MS. */
 void TRG_AddTick(void);
 
+/*!
+ * \brief Advances all triggers by a number of ticks at once, e.g. after the RTOS has been in tickless idle mode.
+ * \param nofTicks Number of ticks passed.
+ */
+void TRG_AddTicks(TRG_TriggerTime nofTicks);
+
+/*!
+ * \brief Returns the number of ticks until the next trigger fires.
+ * \return Ticks until the next pending trigger, or 0 if no trigger is pending.
+ */
+TRG_TriggerTime TRG_TicksToNextTrigger(void);
+
 /*!\brief De-initializes the module. */
 void TRG_Deinit(void);
 
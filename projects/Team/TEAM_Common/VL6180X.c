@@ -70,19 +70,19 @@ uint8_t VL6180X_ReadReg16(VL6180X_Device *device, uint16_t reg, uint16_t *valP)
   return GI2C1_ReadAddress(device->deviceAddr, &tmp[0], sizeof(tmp), (uint8_t*)valP, 2);
 }
 
-static uint8_t readRangeContinuous(VL6180X_Device *device, int16_t *valP) {
-  uint8_t range;
+static uint8_t readAmbientContinuous(VL6180X_Device *device, uint16_t *valP) {
+  uint16_t ambient;
   uint8_t res, val;
   uint16_t timeoutMs = 100;
 
   *valP = 0; /* init */
-  do { /* breaks */
+  do {
    res = VL6180X_ReadReg8(device, RESULT__INTERRUPT_STATUS_GPIO, &val);
    if (res!=ERR_OK) {
      break;
    }
-   if ((val&0x4)!=0) {
-     break; /* 4: New Sample Ready threshold event */
+   if ((val&0x20)!=0) {
+     break; /* new value available */
    }
    if (timeoutMs==0) { /* timeout */
      break;
@@ -94,74 +94,85 @@ static uint8_t readRangeContinuous(VL6180X_Device *device, int16_t *valP) {
     return ERR_NOTAVAIL; /* timeout */
   }
 
-  res = VL6180X_ReadReg8(device, RESULT__RANGE_VAL, &range); /* read range in millimeters */
+  res = VL6180X_ReadReg16(device, RESULT__ALS_VAL, &ambient); /* read ambient value */
   if (res!=ERR_OK) {
     return res;
   }
-  res = VL6180X_WriteReg8(device, SYSTEM__INTERRUPT_CLEAR, 0x01); /* clear interrupt flag */
+  res = VL6180X_WriteReg8(device, SYSTEM__INTERRUPT_CLEAR, 0x02); /* clear interrupt flag */
   if (res!=ERR_OK) {
     return res;
   }
-  *valP = range;
+
+  *valP = ambient;
   return ERR_OK;
 }
 
-static uint8_t readAmbientContinuous(VL6180X_Device *device, uint16_t *valP) {
-  uint16_t ambient;
-  uint8_t res, val;
+uint8_t VL6180X_ReadRangeSingleExt(VL6180X_Device *device, VL6180X_Range *range) {
+  uint8_t r[2], status[RESULT__INTERRUPT_STATUS_GPIO-RESULT__RANGE_STATUS+1];
+  uint8_t data[RESULT__RANGE_RETURN_CONV_TIME+4-RESULT__RANGE_VAL]; /* RESULT__RANGE_VAL up to RESULT__RANGE_RETURN_CONV_TIME */
+  uint8_t res;
   uint16_t timeoutMs = 100;
+  uint32_t ambCount, convTimeUs;
 
-  *valP = 0; /* init */
-  do {
-   res = VL6180X_ReadReg8(device, RESULT__INTERRUPT_STATUS_GPIO, &val);
-   if (res!=ERR_OK) {
-     break;
-   }
-   if ((val&0x20)!=0) {
-     break; /* new value available */
-   }
-   if (timeoutMs==0) { /* timeout */
-     break;
-   }
-   WAIT1_WaitOSms(1);
-   timeoutMs--;
-  } while(1);
-  if (timeoutMs==0) {
-    return ERR_NOTAVAIL; /* timeout */
+  range->mm = -1;
+  range->status = VL6180X_RANGE_STATUS_NOT_AVAILABLE;
+  range->signalRateKcps = 0;
+  range->ambientRateKcps = 0;
+  res = VL6180X_WriteReg8(device, SYSRANGE__START, 0x01);
+  if (res!=ERR_OK) {
+    return res;
   }
-
-  res = VL6180X_ReadReg16(device, RESULT__ALS_VAL, &ambient); /* read ambient value */
+  /* poll the range status and the interrupt status with one transfer */
+  r[0] = RESULT__RANGE_STATUS>>8;
+  r[1] = RESULT__RANGE_STATUS&0xff;
+  for(;;) {
+    res = GI2C1_ReadAddress(device->deviceAddr, &r[0], sizeof(r), &status[0], sizeof(status));
+    if (res!=ERR_OK) {
+      return res;
+    }
+    if ((status[RESULT__INTERRUPT_STATUS_GPIO-RESULT__RANGE_STATUS]&0x4)!=0) {
+      break; /* 4: New Sample Ready threshold event */
+    }
+    if (timeoutMs==0) {
+      return ERR_NOTAVAIL; /* timeout */
+    }
+    WAIT1_WaitOSms(1);
+    timeoutMs--;
+  }
+  /* range, return rate, ambient count and conversion time with one transfer */
+  r[0] = RESULT__RANGE_VAL>>8;
+  r[1] = RESULT__RANGE_VAL&0xff;
+  res = GI2C1_ReadAddress(device->deviceAddr, &r[0], sizeof(r), &data[0], sizeof(data));
   if (res!=ERR_OK) {
     return res;
   }
-  res = VL6180X_WriteReg8(device, SYSTEM__INTERRUPT_CLEAR, 0x02); /* clear interrupt flag */
+  res = VL6180X_WriteReg8(device, SYSTEM__INTERRUPT_CLEAR, 0x01); /* clear interrupt flag */
   if (res!=ERR_OK) {
     return res;
   }
-
-  *valP = ambient;
+  range->status = (VL6180X_RangeStatus)(status[0]>>4);
+  /* return rate in MCPS, 9.7 fixed point */
+  range->signalRateKcps = (uint16_t)(((uint32_t)((data[RESULT__RANGE_RETURN_RATE-RESULT__RANGE_VAL]<<8)|data[RESULT__RANGE_RETURN_RATE-RESULT__RANGE_VAL+1])*1000)/128);
+  ambCount = ((uint32_t)data[RESULT__RANGE_RETURN_AMB_COUNT-RESULT__RANGE_VAL]<<24)|((uint32_t)data[RESULT__RANGE_RETURN_AMB_COUNT-RESULT__RANGE_VAL+1]<<16)
+           | ((uint32_t)data[RESULT__RANGE_RETURN_AMB_COUNT-RESULT__RANGE_VAL+2]<<8)|data[RESULT__RANGE_RETURN_AMB_COUNT-RESULT__RANGE_VAL+3];
+  convTimeUs = ((uint32_t)data[RESULT__RANGE_RETURN_CONV_TIME-RESULT__RANGE_VAL]<<24)|((uint32_t)data[RESULT__RANGE_RETURN_CONV_TIME-RESULT__RANGE_VAL+1]<<16)
+           | ((uint32_t)data[RESULT__RANGE_RETURN_CONV_TIME-RESULT__RANGE_VAL+2]<<8)|data[RESULT__RANGE_RETURN_CONV_TIME-RESULT__RANGE_VAL+3];
+  if (convTimeUs!=0) {
+    range->ambientRateKcps = (uint16_t)((ambCount*1000)/convTimeUs); /* counts per us are MCPS */
+  }
+  if (range->status==VL6180X_RANGE_STATUS_OK && data[0]!=255) {
+    range->mm = data[0]*device->scale;
+  }
   return ERR_OK;
 }
 
 uint8_t VL6180X_ReadRangeSingle(VL6180X_Device *device, int16_t *rangeP) {
+  VL6180X_Range range;
   uint8_t res;
-  int16_t val;
 
-  VL6180X_WriteReg8(device, SYSRANGE__START, 0x01);
-  res = readRangeContinuous(device, &val);
-  if (res!=ERR_OK) {
-    *rangeP = -1;
-    return res; /* error */
-  }
-  if (val==255) { /* no object measured? */
-    *rangeP = -1;
-    return ERR_OK;
-  } else if (val>=0 && val<255) {
-    *rangeP = val*device->scale; /* store value */
-    return ERR_OK;
-  }
-  *rangeP = -2; /* error */
-  return ERR_FAILED;
+  res = VL6180X_ReadRangeSingleExt(device, &range);
+  *rangeP = range.mm; /* -1: no object measured */
+  return res;
 }
 
 uint8_t VL6180X_ReadAmbientSingle(VL6180X_Device *device, uint16_t *ambientP) {
@@ -319,76 +330,191 @@ uint8_t VL6180X_setScaling(VL6180X_Device *device, uint8_t new_scaling) {
 }
 #endif
 
-
-/* Configure some settings for the sensor's default behavior from AN4545 -
- * "Recommended : Public registers" and "Optional: Public registers"
- */
-static uint8_t VL6180X_ConfigureDefaults(VL6180X_Device *device) {
+uint8_t VL6180X_SetRangeProfile(VL6180X_Device *device, const VL6180X_RangeProfile *profile) {
   uint8_t res;
 
-  /* "Recommended : Public registers" */
-  /* Set the averaging sample period (compromise between lower noise and increased execution time) */
-  res = VL6180X_WriteReg8(device, READOUT__AVERAGING_SAMPLE_PERIOD, 0x30);
+  if (profile->maxConvergenceMs<1 || profile->maxConvergenceMs>63) {
+    return ERR_RANGE;
+  }
+  res = VL6180X_WriteReg8(device, SYSRANGE__MAX_CONVERGENCE_TIME, profile->maxConvergenceMs);
   if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
     return res;
   }
-
-  /* sysals__analogue_gain_light = 6 (ALS gain = 1 nominal, actually 1.01 according to Table 14 in datasheet)
-   * Sets the light and dark gain (upper nibble). Dark gain should not be changed.  */
-  res = VL6180X_WriteReg8(device, SYSALS__ANALOGUE_GAIN, 0x46);
+  res = VL6180X_WriteReg8(device, READOUT__AVERAGING_SAMPLE_PERIOD, profile->averagingPeriod);
   if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
     return res;
   }
+#if VL6180X_CONFIG_SUPPORT_SCALING
+  if (profile->scaling!=device->scale) {
+    res = VL6180X_setScaling(device, profile->scaling);
+  }
+#endif
+  return res;
+}
 
-  // sysrange__vhv_repeat_rate = 255 (auto Very High Voltage temperature recalibration after every 255 range measurements)
-  /* sets the # of range measurements after which auto calibration of system is which auto calibration of system is performed */
-  res = VL6180X_WriteReg8(device, SYSRANGE__VHV_REPEAT_RATE, 0xFF);
-  if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-    return res;
+
+/* register/value pair of a configuration table */
+typedef struct {
+  uint16_t reg;   /* register address */
+  uint8_t val;    /* value to write */
+  uint8_t verify; /* 1: value is read back for the configuration checksum; 0: register clears itself or is not readable */
+} VL6180X_RegVal;
+
+#define VL6180X_BURST_MAX   8 /* maximum number of registers written or read in a single I2C transfer */
+
+/* AN4545 section 9, "Mandatory : private registers", in the order of the application note.
+ * SYSTEM__FRESH_OUT_OF_RESET is cleared at the end, so a re-init without power cycle skips the table. */
+static const VL6180X_RegVal VL6180X_PrivateRegs[] = {
+  {0x207, 0x01, 0}, {0x208, 0x01, 0},
+  {0x096, 0x00, 0}, {0x097, 0xFD, 0}, /* RANGE_SCALER = 253, set again by VL6180X_setScaling() */
+  {0x0E3, 0x00, 0}, {0x0E4, 0x04, 0}, {0x0E5, 0x02, 0}, {0x0E6, 0x01, 0}, {0x0E7, 0x03, 0},
+  {0x0F5, 0x02, 0},
+  {0x0D9, 0x05, 0},
+  {0x0DB, 0xCE, 0}, {0x0DC, 0x03, 0}, {0x0DD, 0xF8, 0},
+  {0x09F, 0x00, 0},
+  {0x0A3, 0x3C, 0},
+  {0x0B7, 0x00, 0},
+  {0x0BB, 0x3C, 0},
+  {0x0B2, 0x09, 0},
+  {0x0CA, 0x09, 0},
+  {0x198, 0x01, 0},
+  {0x1B0, 0x17, 0},
+  {0x1AD, 0x00, 0},
+  {0x0FF, 0x05, 0}, {0x100, 0x05, 0},
+  {0x199, 0x05, 0},
+  {0x1A6, 0x1B, 0},
+  {0x1AC, 0x3E, 0},
+  {0x1A7, 0x1F, 0},
+  {0x030, 0x00, 0},
+  {SYSTEM__FRESH_OUT_OF_RESET, 0x00, 1},
+};
+
+/* AN4545 "Recommended : Public registers" and "Optional: Public registers", sorted by address so
+ * adjacent registers go into one transfer. The VHV recalibration is triggered last, with all settings in place. */
+static const VL6180X_RegVal VL6180X_PublicRegs[] = {
+  {SYSTEM__INTERRUPT_CONFIG_GPIO, 0x24, 1},          /* interrupt on 'New Sample Ready threshold event' */
+  {SYSRANGE__INTERMEASUREMENT_PERIOD, 0x09, 1},      /* ranging inter-measurement period 100 ms */
+  {SYSRANGE__VHV_REPEAT_RATE, 0xFF, 1},              /* VHV temperature recalibration after every 255 range measurements */
+  {SYSALS__INTERMEASUREMENT_PERIOD, 0x31, 1},        /* ALS inter-measurement period 500 ms */
+  {SYSALS__ANALOGUE_GAIN, 0x46, 1},                  /* ALS gain 1 (upper nibble: dark gain, not to be changed) */
+  {SYSALS__INTEGRATION_PERIOD, 0x00, 1},             /* ALS integration period 100 ms (99), high byte... */
+  {SYSALS__INTEGRATION_PERIOD+1, 0x63, 1},           /* ...and low byte: AN4545 incorrectly uses 0x040 for the value */
+  {READOUT__AVERAGING_SAMPLE_PERIOD, 0x30, 1},       /* compromise between lower noise and increased execution time */
+  {SYSRANGE__VHV_RECALIBRATE, 0x01, 0},              /* single temperature calibration of the ranging sensor, clears itself */
+};
+
+/* writes a configuration table, consecutive registers with one transfer (the device auto-increments the index) */
+static uint8_t VL6180X_WriteRegTable(VL6180X_Device *device, const VL6180X_RegVal *table, size_t nofEntries) {
+  uint8_t r[2], data[VL6180X_BURST_MAX], res;
+  size_t i, n;
+
+  for(i=0;i<nofEntries;i+=n) {
+    data[0] = table[i].val;
+    n = 1;
+    while (i+n<nofEntries && n<VL6180X_BURST_MAX && table[i+n].reg==table[i].reg+n) {
+      data[n] = table[i+n].val;
+      n++;
+    }
+    r[0] = table[i].reg>>8;
+    r[1] = table[i].reg&0xff;
+    res = GI2C1_WriteAddress(device->deviceAddr, &r[0], sizeof(r), &data[0], (uint16_t)n);
+    if (res!=ERR_OK) {
+      return res;
+    }
   }
+  return ERR_OK;
+}
 
-  /* sysals__integration_period = 99 (100 ms) */
-  /* AN4545 incorrectly recommends writing to register 0x040; 0x63 should go in the lower byte, which is register 0x041. */
-  /* Set ALS integration time to 100ms */
-  res = VL6180X_WriteReg16(device, SYSALS__INTEGRATION_PERIOD, 0x0063);
-  if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-    return res;
+/* CRC-8 (polynomial 0x07) over a byte */
+static uint8_t VL6180X_Crc8(uint8_t crc, uint8_t data) {
+  int i;
+
+  crc ^= data;
+  for(i=0;i<8;i++) {
+    crc = (crc&0x80) ? (uint8_t)((crc<<1)^0x07) : (uint8_t)(crc<<1);
   }
+  return crc;
+}
 
-  /* sysrange__vhv_recalibrate = 1 (manually trigger a VHV recalibration) */
-  /* perform a single temperature calibration of the ranging sensor */
-  res = VL6180X_WriteReg8(device, SYSRANGE__VHV_RECALIBRATE, 0x01);
+/* reads back the registers of a table marked with verify, updates the CRC of the expected and of the read values */
+static uint8_t VL6180X_ReadBackTable(VL6180X_Device *device, const VL6180X_RegVal *table, size_t nofEntries, uint8_t *crcExpected, uint8_t *crcRead) {
+  uint8_t r[2], data[VL6180X_BURST_MAX], res;
+  size_t i, j, n;
+
+  for(i=0;i<nofEntries;i+=n) {
+    n = 1;
+    if (!table[i].verify) {
+      continue;
+    }
+    while (i+n<nofEntries && n<VL6180X_BURST_MAX && table[i+n].verify && table[i+n].reg==table[i].reg+n) {
+      n++;
+    }
+    r[0] = table[i].reg>>8;
+    r[1] = table[i].reg&0xff;
+    res = GI2C1_ReadAddress(device->deviceAddr, &r[0], sizeof(r), &data[0], (uint16_t)n);
+    if (res!=ERR_OK) {
+      return res;
+    }
+    for(j=0;j<n;j++) {
+      *crcExpected = VL6180X_Crc8(*crcExpected, table[i+j].val);
+      *crcRead = VL6180X_Crc8(*crcRead, data[j]);
+    }
+  }
+  return ERR_OK;
+}
+
+uint8_t VL6180X_VerifyConfiguration(VL6180X_Device *device) {
+  uint8_t crcExpected = 0xff, crcRead = 0xff, res;
+#if VL6180X_CONFIG_SUPPORT_SCALING
+  uint16_t scaler;
+#endif
+
+  res = VL6180X_ReadBackTable(device, VL6180X_PrivateRegs, sizeof(VL6180X_PrivateRegs)/sizeof(VL6180X_PrivateRegs[0]), &crcExpected, &crcRead);
   if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
     return res;
   }
-
-  /* Optional: Public registers, see data sheet for more detail */
-  /* Set default ranging inter-measurement period to 100ms */
-  res = VL6180X_WriteReg8(device, SYSRANGE__INTERMEASUREMENT_PERIOD, 0x09);
+  res = VL6180X_ReadBackTable(device, VL6180X_PublicRegs, sizeof(VL6180X_PublicRegs)/sizeof(VL6180X_PublicRegs[0]), &crcExpected, &crcRead);
   if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
     return res;
   }
-
-  /* Set default ALS inter-measurement period to 500ms */
-  res = VL6180X_WriteReg8(device, SYSALS__INTERMEASUREMENT_PERIOD, 0x31);
+#if VL6180X_CONFIG_SUPPORT_SCALING
+  res = VL6180X_ReadReg16(device, RANGE_SCALER, &scaler);
   if (res!=ERR_OK) {
-    VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
     return res;
   }
+  scaler = (uint16_t)((((uint8_t*)&scaler)[0]<<8) | ((uint8_t*)&scaler)[1]); /* big endian on the bus */
+  if (scaler!=ScalerValues[device->scale]) {
+    return ERR_CRC;
+  }
+#endif
+  if (crcRead!=crcExpected) {
+    return ERR_CRC;
+  }
+  return ERR_OK;
+}
+
+uint8_t VL6180X_CheckBooted(void) {
+  uint8_t res, val;
+
+  /* while the firmware boots, the device does not acknowledge; afterwards SYSTEM__FRESH_OUT_OF_RESET is 1 */
+  res = VL6180X_ReadReg8((VL6180X_Device*)&VL6180X_DefaultDevice, SYSTEM__FRESH_OUT_OF_RESET, &val);
+  if (res!=ERR_OK || val!=1) {
+    return ERR_BUSY;
+  }
+  return ERR_OK;
+}
+
+/* Configure some settings for the sensor's default behavior from AN4545 -
+ * "Recommended : Public registers" and "Optional: Public registers"
+ */
+static uint8_t VL6180X_ConfigureDefaults(VL6180X_Device *device) {
+  uint8_t res;
 
-  /* Configures interrupt on 'New Sample Ready threshold event' */
-  res = VL6180X_WriteReg8(device, SYSTEM__INTERRUPT_CONFIG_GPIO, 0x24);
+  res = VL6180X_WriteRegTable(device, VL6180X_PublicRegs, sizeof(VL6180X_PublicRegs)/sizeof(VL6180X_PublicRegs[0]));
   if (res!=ERR_OK) {
     VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
     return res;
   }
-
   scaling = 1;
   return ERR_OK;
 }
@@ -412,153 +538,7 @@ static uint8_t VL6180X_InitDevice(VL6180X_Device *device) {
   }
   if (val==1)  {
     scaling = 1;
-
-    res = VL6180X_WriteReg8(device, 0x207, 0x01);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x208, 0x01);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x096, 0x00);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x097, 0xFD); /* RANGE_SCALER = 253 */
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0E3, 0x00);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0E4, 0x04);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0E5, 0x02);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0E6, 0x01);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0E7, 0x03);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0F5, 0x02);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0D9, 0x05);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0DB, 0xCE);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0DC, 0x03);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0DD, 0xF8);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x09F, 0x00);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0A3, 0x3C);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0B7, 0x00);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0BB, 0x3C);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0B2, 0x09);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0CA, 0x09);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x198, 0x01);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x1B0, 0x17);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x1AD, 0x00);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x0FF, 0x05);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x100, 0x05);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x199, 0x05);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x1A6, 0x1B);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x1AC, 0x3E);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x1A7, 0x1F);
-    if (res!=ERR_OK) {
-      VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
-      return res;
-    }
-    res = VL6180X_WriteReg8(device, 0x030, 0x00);
+    res = VL6180X_WriteRegTable(device, VL6180X_PrivateRegs, sizeof(VL6180X_PrivateRegs)/sizeof(VL6180X_PrivateRegs[0]));
     if (res!=ERR_OK) {
       VL6180X_OnError(VL6180X_ON_ERROR_INIT_DEVICE);
       return res;
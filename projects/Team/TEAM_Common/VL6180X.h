@@ -150,6 +150,40 @@ typedef struct {
 #endif
 } VL6180X_Device;
 
+/* range error codes, RESULT__RANGE_STATUS bits 7:4 */
+typedef enum {
+  VL6180X_RANGE_STATUS_OK                   = 0,  /* valid range */
+  VL6180X_RANGE_STATUS_VCSEL_CONTINUITY     = 1,  /* 1..5: hardware failure */
+  VL6180X_RANGE_STATUS_VCSEL_WATCHDOG       = 2,
+  VL6180X_RANGE_STATUS_VCSEL_WATCHDOG_2     = 3,
+  VL6180X_RANGE_STATUS_PLL1_LOCK            = 4,
+  VL6180X_RANGE_STATUS_PLL2_LOCK            = 5,
+  VL6180X_RANGE_STATUS_EARLY_CONVERGENCE    = 6,  /* too little return signal to converge in time */
+  VL6180X_RANGE_STATUS_MAX_CONVERGENCE      = 7,  /* no target: max convergence time reached */
+  VL6180X_RANGE_STATUS_NO_TARGET_IGNORE     = 8,  /* ignored by the range ignore threshold */
+  VL6180X_RANGE_STATUS_MAX_SNR              = 11, /* ambient light too high for the return signal */
+  VL6180X_RANGE_STATUS_RAW_UNDERFLOW        = 12,
+  VL6180X_RANGE_STATUS_RAW_OVERFLOW         = 13,
+  VL6180X_RANGE_STATUS_UNDERFLOW            = 14, /* target closer than the range (offset calibration) */
+  VL6180X_RANGE_STATUS_OVERFLOW             = 15, /* target farther than the range of the scaling */
+  VL6180X_RANGE_STATUS_NOT_AVAILABLE        = 16  /* driver: no measurement (I2C error or timeout) */
+} VL6180X_RangeStatus;
+
+/* result of a range measurement */
+typedef struct {
+  int16_t mm;               /* range in mm, -1 if status is not VL6180X_RANGE_STATUS_OK */
+  VL6180X_RangeStatus status; /* range error code */
+  uint16_t signalRateKcps;  /* return signal rate, the lower the rate, the noisier the range */
+  uint16_t ambientRateKcps; /* return ambient rate */
+} VL6180X_Range;
+
+/* settings trading the accuracy of a range measurement for its duration */
+typedef struct {
+  uint8_t maxConvergenceMs; /* SYSRANGE__MAX_CONVERGENCE_TIME, 1..63 ms: shorter loses weak (far, dark) targets */
+  uint8_t averagingPeriod;  /* READOUT__AVERAGING_SAMPLE_PERIOD, 1.3 ms + n*64.5 us: shorter is noisier */
+  uint8_t scaling;          /* VL6180X_SCALING_FACTOR_x, ignored without VL6180X_CONFIG_SUPPORT_SCALING */
+} VL6180X_RangeProfile;
+
 #if VL6180X_CONFIG_SUPPORT_SCALING
   uint8_t VL6180X_setScaling(VL6180X_Device *device, uint8_t new_scaling);
 #endif
@@ -167,6 +201,22 @@ uint8_t VL6180X_ReadReg16(VL6180X_Device *device, uint16_t reg, uint16_t *valP);
 uint8_t VL6180X_readLux(VL6180X_Device *device, VL6180X_ALS_GAIN gain, float *pLux);
 
 uint8_t VL6180X_ReadRangeSingle(VL6180X_Device *device, int16_t *rangeP);
+
+/*!
+ * \brief Performs a single range measurement.
+ * \param device Pointer to device.
+ * \param range Range, status, signal and ambient rate of the measurement.
+ * \return Error code, ERR_OK if the device has delivered a measurement (check range->status for its validity).
+ */
+uint8_t VL6180X_ReadRangeSingleExt(VL6180X_Device *device, VL6180X_Range *range);
+
+/*!
+ * \brief Configures the convergence time, averaging period and scaling of the range measurements.
+ * \param device Pointer to device.
+ * \param profile Settings to apply.
+ * \return Error code, ERR_OK if everything is ok.
+ */
+uint8_t VL6180X_SetRangeProfile(VL6180X_Device *device, const VL6180X_RangeProfile *profile);
 uint8_t VL6180X_ReadAmbientSingle(VL6180X_Device *device, uint16_t *ambientP);
 
 uint8_t VL6180X_ChipEnable(VL6180X_Device *device, bool on);
@@ -185,6 +235,19 @@ uint8_t VL6180X_SetI2CDeviceAddress(VL6180X_Device *device);
  */
 uint8_t VL6180X_InitAndConfigureDevice(VL6180X_Device *device);
 
+/*!
+ * \brief Checks if a device released from reset has finished booting (datasheet: max 1.4 ms after GPIO0/CE goes high).
+ * \return ERR_OK if a device answers on the default address with SYSTEM__FRESH_OUT_OF_RESET set, ERR_BUSY otherwise.
+ */
+uint8_t VL6180X_CheckBooted(void);
+
+/*!
+ * \brief Reads back the configured registers and compares their checksum with the configuration tables.
+ * \param device Pointer to device to be checked.
+ * \return Error code, ERR_OK if the configuration matches, ERR_CRC if not.
+ */
+uint8_t VL6180X_VerifyConfiguration(VL6180X_Device *device);
+
 /*!
  * \brief Driver de-initalization
  * \return Error code, ERR_OK if everything is ok.
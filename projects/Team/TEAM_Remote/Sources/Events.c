@@ -37,6 +37,8 @@ extern "C" {
 /* User includes (#include below this line is not maintained by Processor Expert) */
 #include "Timer.h"
 #include "Keys.h"
+#include "LowPower.h"
+#include "RadioLink.h"
 /*
 ** ===================================================================
 **     Event       :  Cpu_OnNMIINT (module Events)
@@ -214,6 +216,9 @@ void FRTOS1_vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName)
 void FRTOS1_vApplicationTickHook(void)
 {
   /* Called for every RTOS tick. */
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_OnTick(); /* ticks suppressed in tickless idle mode get compensated in LP_EnterLowPower() */
+#endif
 #if PL_CONFIG_HAS_TIMER
   TMR_OnInterrupt();
 #endif
@@ -236,7 +241,9 @@ void FRTOS1_vApplicationIdleHook(void)
 {
   /* Called whenever the RTOS is idle (from the IDLE task).
      Here would be a good place to put the CPU into low power mode. */
-  /* Write your code here ... */
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_EnterLowPower();
+#endif
 }
 
 /*
@@ -286,6 +293,80 @@ void PTRC1_OnTraceWrap(void)
 #endif
 }
 
+/*
+** ===================================================================
+**     Event       :  FRTOS1_vOnPreSleepProcessing (module Events)
+**
+**     Component   :  FRTOS1 [FreeRTOS]
+**     Description :
+**         Used in tickless idle mode only, but required in this mode.
+**         Hook for the application to enter low power mode.
+**     Parameters  :
+**         NAME            - DESCRIPTION
+**         expectedIdleTicks - expected idle
+**                           time, in ticks
+**     Returns     : Nothing
+** ===================================================================
+*/
+void FRTOS1_vOnPreSleepProcessing(TickType_t expectedIdleTicks)
+{
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_PreSleepProcessing(expectedIdleTicks); /* enters wait mode */
+#else
+  (void)expectedIdleTicks;
+  __asm volatile("dsb");
+  __asm volatile("wfi");
+  __asm volatile("isb");
+#endif
+}
+
+/*
+** ===================================================================
+**     Event       :  FRTOS1_vOnPostSleepProcessing (module Events)
+**
+**     Component   :  FRTOS1 [FreeRTOS]
+**     Description :
+**         Event called after the CPU woke up after low power mode.
+**         This event is optional.
+**     Parameters  :
+**         NAME            - DESCRIPTION
+**         expectedIdleTicks - expected idle
+**                           time, in ticks
+**     Returns     : Nothing
+** ===================================================================
+*/
+void FRTOS1_vOnPostSleepProcessing(TickType_t expectedIdleTicks)
+{
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_PostSleepProcessing(expectedIdleTicks);
+#else
+  (void)expectedIdleTicks;
+#endif
+}
+
+/*
+** ===================================================================
+**     Event       :  RNET1_OnRadioEvent (module Events)
+**
+**     Component   :  RNET1 [RNet]
+**     Description :
+**         Event created for various radio states, like timeout, ack
+**         received, data sent, ...
+**     Parameters  :
+**         NAME            - DESCRIPTION
+**         event           - 
+**     Returns     : Nothing
+** ===================================================================
+*/
+void RNET1_OnRadioEvent(RNET1_RadioEvent event)
+{
+#if PL_CONFIG_HAS_RADIO_LINK
+  RLINK_OnRadioEvent(event);
+#else
+  (void)event;
+#endif
+}
+
 /* END Events */
 
 #ifdef __cplusplus
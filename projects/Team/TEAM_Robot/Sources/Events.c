@@ -39,6 +39,9 @@ extern "C" {
 #include "Timer.h"
 #include "Keys.h"
 #include "Tacho.h"
+#include "LowPower.h"
+#include "RadioLink.h"
+#include "RtosTrace.h"
 
 /*
 ** ===================================================================
@@ -74,10 +77,16 @@ void Cpu_OnNMIINT(void)
 */
 void TI1_OnInterrupt(void)
 {
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_IsrEnter(RTRC_ISR_TIMER);
+#endif
 #if PL_CONFIG_HAS_TIMER
   TMR_OnInterrupt();
 #endif
   TmDt1_AddTick();
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_IsrExit(RTRC_ISR_TIMER);
+#endif
 }
 
 /*
@@ -129,6 +138,12 @@ void FRTOS1_vApplicationTickHook(void)
 #if PL_CONFIG_HAS_MOTOR_TACHO
   TACHO_Sample();
 #endif
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_OnTick();
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_OnTick();
+#endif
 }
 
 /*
@@ -147,7 +162,9 @@ void FRTOS1_vApplicationIdleHook(void)
 {
   /* Called whenever the RTOS is idle (from the IDLE task).
      Here would be a good place to put the CPU into low power mode. */
-  /* Write your code here ... */
+#if PL_CONFIG_HAS_LOW_POWER
+  LP_EnterLowPower();
+#endif
 }
 
 /*
@@ -213,17 +230,15 @@ void PTRC1_OnTraceWrap(void)
 */
 void QuadInt_OnInterrupt(void)
 {
-#if 0 && configUSE_SEGGER_SYSTEM_VIEWER_HOOKS
-  //SEGGER_SYSVIEW_OnUserStart(0);
-  SYS1_RecordEnterISR(); /* cannot use this, as it would use RTOS API calls above max syscall level! */
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_IsrEnter(RTRC_ISR_QUAD); /* no RTOS API calls: usable above the max syscall level, unlike SYS1_RecordEnterISR() */
 #endif
 #if PL_CONFIG_HAS_QUADRATURE
   Q4CLeft_Sample();
   Q4CRight_Sample();
 #endif
-#if 0 && configUSE_SEGGER_SYSTEM_VIEWER_HOOKS
-  //SEGGER_SYSVIEW_OnUserStop(0);
-  SYS1_RecordExitISR();
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_IsrExit(RTRC_ISR_QUAD);
 #endif
 }
 
@@ -293,7 +308,14 @@ void RF1_OnDeactivate(void)
 */
 void RNET1_OnRadioEvent(RNET1_RadioEvent event)
 {
-  /* Write your code here ... */
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_UserMark(RTRC_EVT_RADIO, (uint16_t)event); /* the nRF24L01 interrupt itself is handled inside the RF1 component */
+#endif
+#if PL_CONFIG_HAS_RADIO_LINK
+  RLINK_OnRadioEvent(event);
+#else
+  (void)event;
+#endif
 }
 
 /*
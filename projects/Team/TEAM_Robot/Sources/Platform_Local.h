@@ -43,9 +43,16 @@
 #define PL_LOCAL_CONFIG_HAS_SQUEUE_SINGLE_CHAR_DISABLED   /* disable single character support in shell queue */
 //#define PL_LOCAL_CONFIG_HAS_SEMAPHORE_DISABLED            /* disable semaphore test module */
 //#define PL_LOCAL_CONFIG_HAS_CONFIG_NVM_DISABLED           /* disable NVM storage */
+//#define PL_LOCAL_CONFIG_HAS_LOW_POWER_DISABLED            /* disable low power mode in idle task */
+//#define PL_LOCAL_CONFIG_HAS_PROFILER_DISABLED             /* disable task profiler */
+//#define PL_LOCAL_CONFIG_HAS_RTOS_TRACE_DISABLED           /* disable streaming RTOS trace */
+//#define PL_LOCAL_CONFIG_HAS_MEM_POOL_DISABLED             /* disable memory pools, use the RTOS heap */
+//#define PL_LOCAL_CONFIG_HAS_LAP_TIME_DISABLED             /* disable lap and segment timing */
 
 /* remote controller hardware functionality */
 //#define PL_LOCAL_CONFIG_HAS_RADIO_DISABLED                /* disable Radio transceiver */
+//#define PL_LOCAL_CONFIG_HAS_RADIO_LINK_DISABLED           /* disable radio link quality monitor */
+//#define PL_LOCAL_CONFIG_HAS_TIME_SYNC_DISABLED            /* disable clock synchronisation */
 //#define PL_LOCAL_CONFIG_HAS_REMOTE_STDIO_DISABLED         /* disable Std I/O over radio */
 //#define PL_LOCAL_CONFIG_HAS_REMOTE_DISABLED               /* disable remote controller (sender and receiver) */
 #define PL_LOCAL_CONFIG_HAS_CONTROL_SENDER_DISABLED       /* disable that we are the sender (otherwise we are the receiver) */
@@ -59,20 +66,27 @@
 #define PL_LOCAL_CONFIG_HAS_BLUETOOTH_DISABLED            /* disable Bluetooth */
 //#define PL_LOCAL_CONFIG_HAS_MOTOR_DISABLED                /* disable motor */
 //#define PL_LOCAL_CONFIG_HAS_QUADRATURE_DISABLED           /* disable quadrature encoder */
+//#define PL_LOCAL_CONFIG_HAS_HW_PROFILE_DISABLED           /* disable hardware profile self-test */
 #define PL_LOCAL_CONFIG_HAS_MPC4728_DISABLED              /* disable MPC4728 (only for V1 robot; just for calibration) */
 #define PL_LOCAL_CONFIG_HAS_QUAD_CALIBRATION_DISABLED     /* disable quadrature calibration (only for V1 robot, just for calibration) */
 //#define PL_LOCAL_CONFIG_HAS_MOTOR_TACHO_DISABLED          /* disable tacho */
 //#define PL_LOCAL_CONFIG_HAS_PID_DISABLED                  /* disable PID */
 //#define PL_LOCAL_CONFIG_HAS_DRIVE_DISABLED                /* disable drive module */
 #define PL_LOCAL_CONFIG_HAS_LINE_FOLLOW_DISABLED          /* disable line following */
+//#define PL_LOCAL_CONFIG_HAS_SPEED_PLAN_DISABLED           /* disable line following speed planner */
+//#define PL_LOCAL_CONFIG_HAS_TRACK_MAP_DISABLED            /* disable learned track map */
+//#define PL_LOCAL_CONFIG_HAS_CONTROL_LOOP_DISABLED         /* disable timer paced control loop, use the module tasks */
 
 //#define PL_LOCAL_CONFIG_HAS_DISTANCE_DISABLED             /* disabling distance sensors */
 //#define PL_LOCAL_CONFIG_HAS_TOF_SENSOR_DISABLED           /* disabling ToF sensors */
+//#define PL_LOCAL_CONFIG_HAS_OBSTACLE_MAP_DISABLED         /* disable obstacle map */
+//#define PL_LOCAL_CONFIG_HAS_ARENA_LOC_DISABLED            /* disable sumo arena localisation */
 
 //#define PL_LOCAL_PL_CONFIG_HAS_SUMO_DISABLED			  /* disable sumo
 
 //#define PL_LOCAL_CONFIG_HAS_TURN_DISABLED                 /* disable turning module */
 #define PL_LOCAL_CONFIG_HAS_LINE_MAZE_DISABLED            /* disable maze solving */
+//#define PL_LOCAL_CONFIG_HAS_RECORDER_DISABLED             /* disable sensor frame recorder */
 //#define PL_LOCAL_CONFIG_HAS_BATTERY_ADC_DISABLED          /* disable battery ADC */
 
 #endif /* SOURCES_PLATFORM_LOCAL_H_ */
@@ -0,0 +1,51 @@
+/**
+ * \file
+ * \brief Host replacement of the console/shell component (subset used by the robot modules).
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef CLS1_H_
+#define CLS1_H_
+
+#include "PE_Types.h"
+#include "UTIL1.h" /* as the component */
+
+#define CLS1_CMD_HELP    "help"
+#define CLS1_CMD_STATUS  "status"
+
+typedef void (*CLS1_StdIO_OutErr_FctType)(uint8_t ch);
+typedef void (*CLS1_StdIO_In_FctType)(uint8_t *ch);
+typedef bool (*CLS1_StdIO_KeyPressed_FctType)(void);
+
+typedef struct {
+  CLS1_StdIO_In_FctType stdIn;
+  CLS1_StdIO_OutErr_FctType stdOut;
+  CLS1_StdIO_OutErr_FctType stdErr;
+  CLS1_StdIO_KeyPressed_FctType keyPressed;
+} CLS1_StdIOType;
+
+typedef const CLS1_StdIOType CLS1_ConstStdIOType;
+
+typedef uint8_t (*CLS1_ParseCommandCallback)(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+
+void CLS1_SendCh(uint8_t ch, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendStr(const uint8_t *str, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendHelpStr(const uint8_t *strCmd, const uint8_t *strHelp, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendStatusStr(const uint8_t *strItem, const uint8_t *strStatus, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendNum8u(uint8_t val, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendNum16u(uint16_t val, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendNum16s(int16_t val, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendNum32u(uint32_t val, CLS1_StdIO_OutErr_FctType io);
+void CLS1_SendNum32s(int32_t val, CLS1_StdIO_OutErr_FctType io);
+
+/*!
+ * \brief Passes a command to a table of parsers, the same way as the shell component does.
+ * \param cmd Command string.
+ * \param handled Set to TRUE if a parser has handled the command.
+ * \param io I/O channel.
+ * \param parserTable NULL terminated table of parsers.
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t CLS1_IterateTable(const uint8_t *cmd, bool *handled, CLS1_ConstStdIOType *io, const CLS1_ParseCommandCallback *parserTable);
+
+#endif /* CLS1_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the CS1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef CS1_H_
+#define CS1_H_
+
+#include "SimHw.h"
+
+#endif /* CS1_H_ */
@@ -0,0 +1,16 @@
+/**
+ * \file
+ * \brief Host replacement of the Processor Expert CPU component.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The simulator models the V2 robot.
+ */
+
+#ifndef CPU_H_
+#define CPU_H_
+
+#include "PE_Types.h"
+
+#define PEcfg_RoboV2  1 /* configuration of the V2 robot */
+
+#endif /* CPU_H_ */
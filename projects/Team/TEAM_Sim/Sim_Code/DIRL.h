@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the DIRL component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef DIRL_H_
+#define DIRL_H_
+
+#include "SimHw.h"
+
+#endif /* DIRL_H_ */
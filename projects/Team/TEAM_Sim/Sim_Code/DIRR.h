@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the DIRR component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef DIRR_H_
+#define DIRR_H_
+
+#include "SimHw.h"
+
+#endif /* DIRR_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the FDisp1 component, see SimLcd.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef FDISP1_H_
+#define FDISP1_H_
+
+#include "SimLcd.h"
+
+#endif /* FDISP1_H_ */
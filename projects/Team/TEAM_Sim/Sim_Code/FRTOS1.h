@@ -0,0 +1,157 @@
+/**
+ * \file
+ * \brief Host replacement of the FreeRTOS component (subset used by the robot modules).
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Tasks are host threads, but only one of them runs at a time: a task runs until it blocks
+ * (delay, queue, semaphore or notification wait), then the scheduler picks the next ready task
+ * with the highest priority. If all tasks are blocked, the simulated time advances by one tick
+ * and the tick hook runs. Blocking calls with a timeout re-check their condition on every tick.
+ * This gives deterministic runs which are much faster than real time.
+ */
+
+#ifndef FRTOS1_H_
+#define FRTOS1_H_
+
+#include "PE_Types.h"
+
+#define configTICK_RATE_HZ        1000
+#define configMINIMAL_STACK_SIZE  200
+#define configMAX_PRIORITIES      6
+
+#define portTICK_PERIOD_MS        (1000/configTICK_RATE_HZ)
+#define portTICK_RATE_MS          portTICK_PERIOD_MS
+#define portMAX_DELAY             ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)         ((TickType_t)(((TickType_t)(ms)*configTICK_RATE_HZ)/1000))
+
+#define pdFALSE   0
+#define pdTRUE    1
+#define pdPASS    pdTRUE
+#define pdFAIL    pdFALSE
+#define errQUEUE_FULL  0
+#define errQUEUE_EMPTY 0
+
+#define tskIDLE_PRIORITY  0
+
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef BaseType_t portBASE_TYPE;
+typedef uint32_t StackType_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct SIMRTOS_Task *TaskHandle_t;
+typedef TaskHandle_t xTaskHandle;
+typedef struct SIMRTOS_Queue *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+typedef QueueHandle_t SemaphoreHandle_t;
+typedef QueueHandle_t xSemaphoreHandle;
+
+/*! \brief Task information of uxTaskGetSystemState(), only the fields the robot modules use */
+typedef struct {
+  TaskHandle_t xHandle;
+  const char *pcTaskName;
+  UBaseType_t xTaskNumber;
+  UBaseType_t uxCurrentPriority;
+} TaskStatus_t;
+
+typedef enum {
+  eNoAction = 0,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite
+} eNotifyAction;
+
+/* tasks */
+BaseType_t SIMRTOS_TaskCreate(TaskFunction_t fn, const char *name, uint16_t stackDepth, void *param, UBaseType_t prio, TaskHandle_t *handle);
+void SIMRTOS_TaskDelay(TickType_t ticks);
+void SIMRTOS_TaskDelayUntil(TickType_t *prevWakeTime, TickType_t increment);
+void SIMRTOS_TaskYield(void);
+TickType_t SIMRTOS_GetTickCount(void);
+BaseType_t SIMRTOS_TaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t SIMRTOS_TaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *valueP, TickType_t ticksToWait);
+uint32_t SIMRTOS_TaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+UBaseType_t SIMRTOS_TaskGetNumberOfTasks(void);
+UBaseType_t SIMRTOS_TaskGetSystemState(TaskStatus_t *tasks, UBaseType_t arraySize, uint32_t *totalRunTime);
+void SIMRTOS_TaskSetTaskNumber(TaskHandle_t task, UBaseType_t number);
+
+/* queues and semaphores (a semaphore is a queue with zero size items) */
+QueueHandle_t SIMRTOS_QueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void SIMRTOS_QueueDelete(QueueHandle_t queue);
+BaseType_t SIMRTOS_QueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait, bool toFront);
+BaseType_t SIMRTOS_QueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait, bool peek);
+UBaseType_t SIMRTOS_QueueMessagesWaiting(QueueHandle_t queue);
+void SIMRTOS_QueueAddToRegistry(QueueHandle_t queue, const char *name);
+QueueHandle_t SIMRTOS_SemaphoreCreateMutex(void);
+QueueHandle_t SIMRTOS_SemaphoreCreateBinary(void);
+
+#define xTaskCreate(fn, name, depth, param, prio, handle) SIMRTOS_TaskCreate(fn, name, depth, param, prio, handle)
+#define vTaskDelay(ticks)                      SIMRTOS_TaskDelay(ticks)
+#define vTaskDelayUntil(prev, incr)            SIMRTOS_TaskDelayUntil(prev, incr)
+#define taskYIELD()                            SIMRTOS_TaskYield()
+#define xTaskGetTickCount()                    SIMRTOS_GetTickCount()
+#define xTaskGetTickCountFromISR()             SIMRTOS_GetTickCount()
+#define xTaskNotify(task, val, action)         SIMRTOS_TaskNotify(task, val, action)
+#define xTaskNotifyWait(entry, exit, valP, to) SIMRTOS_TaskNotifyWait(entry, exit, valP, to)
+#define ulTaskNotifyTake(clear, to)            SIMRTOS_TaskNotifyTake(clear, to)
+#define vTaskNotifyGiveFromISR(task, wokenP)   do { (void)SIMRTOS_TaskNotify(task, 0, eIncrement); *(wokenP) = pdFALSE; } while(0)
+#define portYIELD_FROM_ISR(woken)              do { (void)(woken); } while(0) /* the scheduler runs after the tick hook anyway */
+#define uxTaskGetNumberOfTasks()               SIMRTOS_TaskGetNumberOfTasks()
+#define uxTaskGetSystemState(tasks, size, rt)  SIMRTOS_TaskGetSystemState(tasks, size, rt)
+#define vTaskSetTaskNumber(task, number)       SIMRTOS_TaskSetTaskNumber(task, number)
+#define taskENTER_CRITICAL()                   do {} while(0)
+#define taskEXIT_CRITICAL()                    do {} while(0)
+
+#define xQueueCreate(len, size)                SIMRTOS_QueueCreate(len, size)
+#define vQueueDelete(q)                        SIMRTOS_QueueDelete(q)
+#define xQueueSendToBack(q, item, to)          SIMRTOS_QueueSend(q, item, to, FALSE)
+#define xQueueSendToFront(q, item, to)         SIMRTOS_QueueSend(q, item, to, TRUE)
+#define xQueueSend(q, item, to)                SIMRTOS_QueueSend(q, item, to, FALSE)
+#define xQueueReceive(q, item, to)             SIMRTOS_QueueReceive(q, item, to, FALSE)
+#define xQueuePeek(q, item, to)                SIMRTOS_QueueReceive(q, item, to, TRUE)
+#define uxQueueMessagesWaiting(q)              SIMRTOS_QueueMessagesWaiting(q)
+#define vQueueAddToRegistry(q, name)           SIMRTOS_QueueAddToRegistry(q, name)
+
+#define xSemaphoreCreateMutex()                SIMRTOS_SemaphoreCreateMutex()
+#define xSemaphoreCreateRecursiveMutex()       SIMRTOS_SemaphoreCreateMutex()
+#define xSemaphoreCreateBinary()               SIMRTOS_SemaphoreCreateBinary()
+#define vSemaphoreCreateBinary(sem)            do { (sem) = SIMRTOS_SemaphoreCreateBinary(); if ((sem)!=NULL) { (void)SIMRTOS_QueueSend(sem, NULL, 0, FALSE); } } while(0)
+#define xSemaphoreTake(sem, to)                SIMRTOS_QueueReceive(sem, NULL, to, FALSE)
+#define xSemaphoreGive(sem)                    SIMRTOS_QueueSend(sem, NULL, 0, FALSE)
+#define xSemaphoreTakeRecursive(sem, to)       SIMRTOS_QueueReceive(sem, NULL, to, FALSE)
+#define xSemaphoreGiveRecursive(sem)           SIMRTOS_QueueSend(sem, NULL, 0, FALSE)
+
+/* component (FRTOS1_) names */
+#define FRTOS1_xTaskCreate               xTaskCreate
+#define FRTOS1_vTaskDelay                vTaskDelay
+#define FRTOS1_vTaskDelayUntil           vTaskDelayUntil
+#define FRTOS1_taskYIELD                 taskYIELD
+#define FRTOS1_xTaskGetTickCount         xTaskGetTickCount
+#define FRTOS1_xTaskNotify               xTaskNotify
+#define FRTOS1_xTaskNotifyWait           xTaskNotifyWait
+#define FRTOS1_taskENTER_CRITICAL        taskENTER_CRITICAL
+#define FRTOS1_taskEXIT_CRITICAL         taskEXIT_CRITICAL
+#define FRTOS1_xQueueCreate              xQueueCreate
+#define FRTOS1_vQueueDelete              vQueueDelete
+#define FRTOS1_xQueueSendToBack          xQueueSendToBack
+#define FRTOS1_xQueueSendToFront         xQueueSendToFront
+#define FRTOS1_xQueueReceive             xQueueReceive
+#define FRTOS1_xQueuePeek                xQueuePeek
+#define FRTOS1_uxQueueMessagesWaiting    uxQueueMessagesWaiting
+#define FRTOS1_vQueueAddToRegistry       vQueueAddToRegistry
+#define FRTOS1_xSemaphoreCreateMutex     xSemaphoreCreateMutex
+#define FRTOS1_xSemaphoreTake            xSemaphoreTake
+#define FRTOS1_xSemaphoreGive            xSemaphoreGive
+
+/*!
+ * \brief Runs the scheduler until the simulated time reaches the given tick count.
+ * \param endTick Tick count to run to.
+ * \param stopP If not NULL, the run ends early once this flag is set (checked on every tick).
+ */
+void SIMRTOS_RunUntil(TickType_t endTick, volatile bool *stopP);
+
+/*! \brief Tick hook, called by the scheduler for every simulated tick (see Events.c) */
+void FRTOS1_vApplicationTickHook(void);
+
+#endif /* FRTOS1_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the GDisp1 component, see SimLcd.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef GDISP1_H_
+#define GDISP1_H_
+
+#include "SimLcd.h"
+
+#endif /* GDISP1_H_ */
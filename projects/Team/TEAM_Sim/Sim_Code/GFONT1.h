@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the GFONT1 component, see SimLcd.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef GFONT1_H_
+#define GFONT1_H_
+
+#include "SimLcd.h"
+
+#endif /* GFONT1_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the GI2C1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef GI2C1_H_
+#define GI2C1_H_
+
+#include "SimHw.h"
+
+#endif /* GI2C1_H_ */
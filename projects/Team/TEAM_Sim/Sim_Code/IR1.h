@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the IR1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef IR1_H_
+#define IR1_H_
+
+#include "SimHw.h"
+
+#endif /* IR1_H_ */
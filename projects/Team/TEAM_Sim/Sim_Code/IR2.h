@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the IR2 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef IR2_H_
+#define IR2_H_
+
+#include "SimHw.h"
+
+#endif /* IR2_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the IR3 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef IR3_H_
+#define IR3_H_
+
+#include "SimHw.h"
+
+#endif /* IR3_H_ */
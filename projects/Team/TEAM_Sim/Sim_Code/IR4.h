@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the IR4 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef IR4_H_
+#define IR4_H_
+
+#include "SimHw.h"
+
+#endif /* IR4_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the IR5 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef IR5_H_
+#define IR5_H_
+
+#include "SimHw.h"
+
+#endif /* IR5_H_ */
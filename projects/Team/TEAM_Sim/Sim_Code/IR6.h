@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the IR6 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef IR6_H_
+#define IR6_H_
+
+#include "SimHw.h"
+
+#endif /* IR6_H_ */
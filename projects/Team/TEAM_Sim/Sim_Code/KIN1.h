@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the KIN1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef KIN1_H_
+#define KIN1_H_
+
+#include "SimHw.h"
+
+#endif /* KIN1_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the LEDPin1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef LEDPIN1_H_
+#define LEDPIN1_H_
+
+#include "SimHw.h"
+
+#endif /* LEDPIN1_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the LEDPin2 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef LEDPIN2_H_
+#define LEDPIN2_H_
+
+#include "SimHw.h"
+
+#endif /* LEDPIN2_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the LED_IR component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef LED_IR_H_
+#define LED_IR_H_
+
+#include "SimHw.h"
+
+#endif /* LED_IR_H_ */
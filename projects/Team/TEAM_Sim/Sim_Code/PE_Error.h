@@ -0,0 +1,42 @@
+/**
+ * \file
+ * \brief Host replacement of the Processor Expert error codes.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Same values as the generated PE_Error.h, so the common modules behave identical on the host.
+ */
+
+#ifndef PE_ERROR_H_
+#define PE_ERROR_H_
+
+#define ERR_OK           0x00U /* OK */
+#define ERR_SPEED        0x01U /* This device does not work in the active speed mode. */
+#define ERR_RANGE        0x02U /* Parameter out of range. */
+#define ERR_VALUE        0x03U /* Parameter of incorrect value. */
+#define ERR_OVERFLOW     0x04U /* Timer overflow. */
+#define ERR_MATH         0x05U /* Overflow during evaluation. */
+#define ERR_ENABLED      0x06U /* Device is enabled. */
+#define ERR_DISABLED     0x07U /* Device is disabled. */
+#define ERR_BUSY         0x08U /* Device is busy. */
+#define ERR_NOTAVAIL     0x09U /* Requested value or method not available. */
+#define ERR_RXEMPTY      0x0AU /* No data in receiver. */
+#define ERR_TXFULL       0x0BU /* Transmitter is full. */
+#define ERR_BUSOFF       0x0CU /* Bus not available. */
+#define ERR_OVERRUN      0x0DU /* Overrun error is detected. */
+#define ERR_FRAMING      0x0EU /* Framing error is detected. */
+#define ERR_PARITY       0x0FU /* Parity error is detected. */
+#define ERR_NOISE        0x10U /* Noise error is detected. */
+#define ERR_IDLE         0x11U /* Idle error is detected. */
+#define ERR_FAULT        0x12U /* Fault error is detected. */
+#define ERR_BREAK        0x13U /* Break char is received during communication. */
+#define ERR_CRC          0x14U /* CRC error is detected. */
+#define ERR_ARBITR       0x15U /* A node losts arbitration. */
+#define ERR_PROTECT      0x16U /* Protection error is detected. */
+#define ERR_UNDERFLOW    0x17U /* Underflow error is detected. */
+#define ERR_UNDERRUN     0x18U /* Underrun error is detected. */
+#define ERR_COMMON       0x19U /* Common error of a device. */
+#define ERR_LINSYNC      0x1AU /* LIN synchronization error is detected. */
+#define ERR_FAILED       0x1BU /* Requested functionality or process failed. */
+#define ERR_QFULL        0x1CU /* Queue is full. */
+
+#endif /* PE_ERROR_H_ */
@@ -0,0 +1,34 @@
+/**
+ * \file
+ * \brief Host replacement of the Processor Expert common types.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef PE_TYPES_H_
+#define PE_TYPES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "PE_Error.h"
+
+#ifndef TRUE
+  #define TRUE  true
+#endif
+#ifndef FALSE
+  #define FALSE false
+#endif
+
+typedef uint8_t  byte;
+typedef uint16_t word;
+typedef uint32_t dword;
+
+typedef void     LDD_TDeviceData;  /* device data of a logical device driver */
+typedef void     LDD_TUserData;    /* user data of a logical device driver */
+typedef uint16_t LDD_TError;       /* error code of a logical device driver */
+
+/* interrupts do not exist on the host: the simulated RTOS runs one task at a time */
+#define EnterCritical()   do {} while(0)
+#define ExitCritical()    do {} while(0)
+
+#endif /* PE_TYPES_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the PWML component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef PWML_H_
+#define PWML_H_
+
+#include "SimHw.h"
+
+#endif /* PWML_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the PWMR component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef PWMR_H_
+#define PWMR_H_
+
+#include "SimHw.h"
+
+#endif /* PWMR_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the Q4CLeft component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef Q4CLEFT_H_
+#define Q4CLEFT_H_
+
+#include "SimHw.h"
+
+#endif /* Q4CLEFT_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the Q4CRight component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef Q4CRIGHT_H_
+#define Q4CRIGHT_H_
+
+#include "SimHw.h"
+
+#endif /* Q4CRIGHT_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the RefCnt component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef REFCNT_H_
+#define REFCNT_H_
+
+#include "SimHw.h"
+
+#endif /* REFCNT_H_ */
@@ -0,0 +1,419 @@
+/**
+ * \file
+ * \brief Host emulation of the robot hardware components, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Time below one RTOS tick is modeled with a nanosecond clock: busy waiting (WAIT1_Waitus())
+ * and polling the reflectance timer advance it, so REF_MeasureRaw() sees the sensor pins
+ * discharge in the same order and with the same timer values as on the target.
+ */
+
+#include "SimHw.h"
+#include "FRTOS1.h"
+#include <string.h>
+
+#define SIMHW_POLL_NS            500  /* time for one iteration of a polling loop reading the timer */
+#define SIMHW_IR_DARK_US         3000 /* discharge time with the IR LEDs off: no reflection at all */
+#define SIMHW_TOF_DEFAULT_ADDR   0x29 /* VL6180X I2C address after reset */
+#define SIMHW_TOF_NOF_REGS       0x300
+#define SIMHW_TOF_PRECAL_NS      (3200*1000UL)    /* range measurement: pre-calibration before the convergence... */
+#define SIMHW_TOF_READOUT_NS     (1300*1000UL)    /* ...and readout averaging, plus 64.5 us per READOUT__AVERAGING_SAMPLE_PERIOD */
+#define SIMHW_TOF_CONV_100MM_US  500 /* convergence time for a target at 100 mm, growing with the square of the distance */
+#define SIMHW_TOF_RATE_100MM     (10*128) /* return signal rate at 100 mm (10 MCPS, 9.7 fixed point), falling with the square of the distance */
+#define SIMHW_TOF_ALS_NS         (50*1000*1000UL) /* duration of a single ambient light measurement */
+#define SIMHW_TOF_MAX_RANGE_MM   200 /* specified range without scaling */
+#define SIMHW_TOF_BOOT_NS        (1200*1000UL)    /* firmware boot after leaving hardware standby, datasheet: max 1.4 ms */
+
+/* VL6180X registers with side effects */
+#define VL_REG_INTERRUPT_CLEAR     0x015
+#define VL_REG_FRESH_OUT_OF_RESET  0x016
+#define VL_REG_SYSRANGE_START      0x018
+#define VL_REG_MAX_CONVERGENCE     0x01C
+#define VL_REG_SYSALS_START        0x038
+#define VL_REG_RANGE_STATUS        0x04D
+#define VL_REG_INTERRUPT_STATUS    0x04F
+#define VL_REG_ALS_VAL             0x050
+#define VL_REG_RANGE_VAL           0x062
+#define VL_REG_RETURN_RATE         0x066
+#define VL_REG_RETURN_AMB_COUNT    0x074
+#define VL_REG_RETURN_CONV_TIME    0x07C
+#define VL_REG_RANGE_SCALER        0x096
+#define VL_REG_AVERAGING_PERIOD    0x10A
+#define VL_REG_DEVICE_ADDRESS      0x212
+
+static uint64_t SIMHW_TimeNs = 0; /* simulated time */
+
+/* motors */
+static uint16_t SIMHW_PwmRatio[2] = {0xffff, 0xffff};
+static bool SIMHW_PwmEnabled[2];
+static bool SIMHW_Dir[2];
+static int32_t SIMHW_QuadOffset[2];
+static bool SIMHW_QuadSwapped[2]; /* A and B swapped: counting reversed */
+
+/* reflectance sensors */
+static bool SIMHW_IrLedOn;
+static bool SIMHW_IrIsInput[SIMHW_NOF_IR];
+static uint64_t SIMHW_IrInputNs[SIMHW_NOF_IR];      /* time when the pin has been switched to input */
+static uint32_t SIMHW_IrDischargeNs[SIMHW_NOF_IR];  /* discharge time, sampled when switched to input */
+static uint64_t SIMHW_RefCntStartNs;
+
+/* ToF sensors */
+typedef struct {
+  bool enabled;     /* CE pin high */
+  uint8_t addr;     /* current I2C address */
+  bool rangeBusy, alsBusy;
+  uint64_t rangeReadyNs, alsReadyNs;
+  uint8_t rangeVal, rangeStatus; /* result of the running range measurement */
+  uint16_t rangeRate;
+  uint32_t rangeAmbCount, rangeConvUs;
+  uint64_t bootReadyNs; /* no acknowledge until the firmware has booted */
+  uint8_t regs[SIMHW_TOF_NOF_REGS];
+} SIMHW_TofDevice;
+
+static bool SIMHW_TofPowered = TRUE; /* the pin component initializes the FET pin LOW: powered */
+static SIMHW_TofDevice SIMHW_Tof[SIMHW_NOF_TOF];
+
+bool SIMHW_LedPin[2] = {TRUE, TRUE}; /* LEDs are low active: off */
+
+/* ------------------------------------ time ------------------------------------ */
+void SIMHW_OnTick(uint32_t tick) {
+  uint64_t tickNs = (uint64_t)tick*(1000000000UL/configTICK_RATE_HZ);
+
+  if (SIMHW_TimeNs<tickNs) {
+    SIMHW_TimeNs = tickNs;
+  }
+}
+
+uint64_t SIMHW_GetTimeUs(void) {
+  return SIMHW_TimeNs/1000;
+}
+
+void WAIT1_Waitus(uint16_t us) {
+  SIMHW_TimeNs += (uint64_t)us*1000;
+}
+
+void WAIT1_Waitms(uint16_t ms) {
+  SIMHW_TimeNs += (uint64_t)ms*1000*1000;
+}
+
+void WAIT1_WaitOSms(uint16_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+/* ------------------------------------ motors ------------------------------------ */
+uint8_t SIMHW_PwmSetRatio16(uint8_t motor, uint16_t ratio) {
+  SIMHW_PwmRatio[motor] = ratio;
+  return ERR_OK;
+}
+
+uint8_t SIMHW_PwmEnable(uint8_t motor) {
+  SIMHW_PwmEnabled[motor] = TRUE;
+  return ERR_OK;
+}
+
+void SIMHW_DirPutVal(uint8_t motor, bool val) {
+  SIMHW_Dir[motor] = val;
+}
+
+float SIMHW_GetMotorInput(uint8_t motor) {
+  float duty;
+
+  if (!SIMHW_PwmEnabled[motor]) {
+    return 0.0f;
+  }
+  duty = (float)(0xffff-SIMHW_PwmRatio[motor])/(float)0xffff; /* PWM is low active */
+  /* the left motor is mounted mirrored: DIR low drives it forward, for the right motor DIR high */
+  if ((motor==SIMHW_LEFT && SIMHW_Dir[motor]) || (motor==SIMHW_RIGHT && !SIMHW_Dir[motor])) {
+    duty = -duty;
+  }
+  return duty;
+}
+
+static int32_t SIMHW_QuadGetCounter(uint8_t motor) {
+  int32_t cnt = (int32_t)SIM_GetEncoderCounts(motor);
+
+  return SIMHW_QuadSwapped[motor] ? -cnt : cnt;
+}
+
+int32_t SIMHW_QuadGetPos(uint8_t motor) {
+  return SIMHW_QuadGetCounter(motor)-SIMHW_QuadOffset[motor];
+}
+
+void SIMHW_QuadSetPos(uint8_t motor, int32_t pos) {
+  SIMHW_QuadOffset[motor] = SIMHW_QuadGetCounter(motor)-pos;
+}
+
+uint8_t SIMHW_QuadSwapPins(uint8_t motor, bool swap) {
+  int32_t pos = SIMHW_QuadGetPos(motor);
+
+  SIMHW_QuadSwapped[motor] = swap;
+  SIMHW_QuadSetPos(motor, pos); /* the position continues from here */
+  return ERR_OK;
+}
+
+/* ------------------------------- reflectance sensors ------------------------------- */
+void SIMHW_IrSetOutput(uint8_t sensor) {
+  SIMHW_IrIsInput[sensor] = FALSE;
+}
+
+void SIMHW_IrSetInput(uint8_t sensor) {
+  SIMHW_IrIsInput[sensor] = TRUE;
+  SIMHW_IrInputNs[sensor] = SIMHW_TimeNs;
+  if (SIMHW_IrLedOn) {
+    SIMHW_IrDischargeNs[sensor] = SIM_GetIrDischargeNs(sensor);
+  } else {
+    SIMHW_IrDischargeNs[sensor] = SIMHW_IR_DARK_US*1000;
+  }
+}
+
+void SIMHW_IrSetVal(uint8_t sensor) {
+  (void)sensor; /* charging the capacitor: nothing to model */
+}
+
+bool SIMHW_IrGetVal(uint8_t sensor) {
+  if (!SIMHW_IrIsInput[sensor]) {
+    return TRUE; /* driven high */
+  }
+  return (SIMHW_TimeNs-SIMHW_IrInputNs[sensor]) < SIMHW_IrDischargeNs[sensor];
+}
+
+void SIMHW_IrLed(bool on) {
+  SIMHW_IrLedOn = on;
+}
+
+LDD_TDeviceData *RefCnt_Init(LDD_TUserData *userData) {
+  (void)userData;
+  return (LDD_TDeviceData*)&SIMHW_RefCntStartNs; /* any non-NULL handle */
+}
+
+LDD_TError RefCnt_ResetCounter(LDD_TDeviceData *deviceData) {
+  (void)deviceData;
+  SIMHW_RefCntStartNs = SIMHW_TimeNs;
+  return ERR_OK;
+}
+
+RefCnt_TValueType RefCnt_GetCounterValue(LDD_TDeviceData *deviceData) {
+  uint64_t cnt;
+
+  (void)deviceData;
+  SIMHW_TimeNs += SIMHW_POLL_NS; /* the caller polls the counter in a loop */
+  cnt = ((SIMHW_TimeNs-SIMHW_RefCntStartNs)*(RefCnt_CNT_INP_FREQ_U_0/1000))/(1000*1000);
+  return (RefCnt_TValueType)cnt; /* free running 16bit counter */
+}
+
+/* ---------------------------- I2C bus and ToF sensors ---------------------------- */
+static void TofReset(SIMHW_TofDevice *dev) {
+  memset(dev->regs, 0, sizeof(dev->regs));
+  dev->addr = SIMHW_TOF_DEFAULT_ADDR;
+  dev->regs[VL_REG_DEVICE_ADDRESS] = SIMHW_TOF_DEFAULT_ADDR;
+  dev->regs[VL_REG_FRESH_OUT_OF_RESET] = 1;
+  dev->regs[VL_REG_RANGE_SCALER] = 0;
+  dev->regs[VL_REG_RANGE_SCALER+1] = 253; /* scaling factor 1 */
+  dev->regs[VL_REG_MAX_CONVERGENCE] = 0x31; /* 49 ms */
+  dev->regs[VL_REG_AVERAGING_PERIOD] = 0x30;
+  dev->rangeBusy = FALSE;
+  dev->alsBusy = FALSE;
+  dev->bootReadyNs = SIMHW_TimeNs+SIMHW_TOF_BOOT_NS;
+}
+
+void SIMHW_TofCE(uint8_t ce, bool output, bool high) {
+  bool enabled = !output || high;
+
+  if (enabled && !SIMHW_Tof[ce].enabled) {
+    TofReset(&SIMHW_Tof[ce]); /* leaving hardware standby */
+  }
+  SIMHW_Tof[ce].enabled = enabled;
+}
+
+void SIMHW_TofPower(bool on) {
+  int i;
+
+  if (on && !SIMHW_TofPowered) {
+    for(i=0;i<SIMHW_NOF_TOF;i++) {
+      TofReset(&SIMHW_Tof[i]);
+    }
+  }
+  SIMHW_TofPowered = on;
+}
+
+static SIMHW_TofDevice *TofFind(uint8_t i2cAddr) {
+  int i;
+
+  if (!SIMHW_TofPowered) {
+    return NULL;
+  }
+  for(i=0;i<SIMHW_NOF_TOF;i++) {
+    if (SIMHW_Tof[i].enabled && SIMHW_Tof[i].addr==i2cAddr && SIMHW_TimeNs>=SIMHW_Tof[i].bootReadyNs && SIM_GetTofRangeMm(i)!=SIM_TOF_NOT_FITTED) {
+      return &SIMHW_Tof[i];
+    }
+  }
+  return NULL; /* no acknowledge */
+}
+
+static uint8_t TofScaling(const SIMHW_TofDevice *dev) {
+  switch(dev->regs[VL_REG_RANGE_SCALER+1]) {
+    case 127: return 2;
+    case 84:  return 3;
+    default:  return 1;
+  }
+}
+
+static void TofSetReg32(SIMHW_TofDevice *dev, uint16_t reg, uint32_t val) {
+  dev->regs[reg] = (uint8_t)(val>>24);
+  dev->regs[reg+1] = (uint8_t)(val>>16);
+  dev->regs[reg+2] = (uint8_t)(val>>8);
+  dev->regs[reg+3] = (uint8_t)val;
+}
+
+/* starts a range measurement: the result is sampled now, its duration depends on the target and the settings */
+static void TofStartRange(SIMHW_TofDevice *dev) {
+  uint8_t slot = (uint8_t)(dev-&SIMHW_Tof[0]);
+  uint8_t avg = dev->regs[VL_REG_AVERAGING_PERIOD];
+  uint32_t maxConvUs = (dev->regs[VL_REG_MAX_CONVERGENCE]&0x3f)*1000UL;
+  int i, n, mm, sum = 0;
+  double d;
+
+  n = 1+avg/16; /* the averaging reduces the noise of the samples */
+  for(i=0;i<n;i++) {
+    mm = SIM_GetTofRangeMm(slot);
+    if (mm<0) {
+      break;
+    }
+    sum += mm;
+  }
+  if (mm<0) { /* no target: no convergence */
+    dev->rangeStatus = 7;
+    dev->rangeVal = 255;
+    dev->rangeRate = 0;
+    dev->rangeConvUs = maxConvUs;
+  } else {
+    mm = sum/n;
+    d = (mm<10 ? 10 : mm)/100.0;
+    dev->rangeRate = (uint16_t)(SIMHW_TOF_RATE_100MM/(d*d));
+    dev->rangeConvUs = (uint32_t)(SIMHW_TOF_CONV_100MM_US*d*d);
+    if (dev->rangeConvUs>maxConvUs) { /* return signal too weak for the convergence time */
+      dev->rangeStatus = 7;
+      dev->rangeVal = 255;
+      dev->rangeConvUs = maxConvUs;
+    } else if (mm>SIMHW_TOF_MAX_RANGE_MM*TofScaling(dev)) {
+      dev->rangeStatus = 15; /* range overflow */
+      dev->rangeVal = 255;
+    } else {
+      dev->rangeStatus = 0;
+      dev->rangeVal = (uint8_t)(mm/TofScaling(dev)>254 ? 254 : mm/TofScaling(dev));
+    }
+  }
+  dev->rangeAmbCount = (SIM_GetTofAmbient(slot)*dev->rangeConvUs)/1000; /* ambient value as rate in kcps */
+  dev->rangeBusy = TRUE;
+  dev->rangeReadyNs = SIMHW_TimeNs+SIMHW_TOF_PRECAL_NS+dev->rangeConvUs*1000ULL+SIMHW_TOF_READOUT_NS+avg*64500ULL;
+}
+
+/* completes the running measurements */
+static void TofUpdate(SIMHW_TofDevice *dev) {
+  uint8_t slot = (uint8_t)(dev-&SIMHW_Tof[0]);
+  uint16_t als;
+
+  if (dev->rangeBusy && SIMHW_TimeNs>=dev->rangeReadyNs) {
+    dev->rangeBusy = FALSE;
+    dev->regs[VL_REG_RANGE_VAL] = dev->rangeVal;
+    dev->regs[VL_REG_RANGE_STATUS] = (uint8_t)((dev->rangeStatus<<4)|0x01); /* error code, device ready */
+    dev->regs[VL_REG_RETURN_RATE] = dev->rangeRate>>8;
+    dev->regs[VL_REG_RETURN_RATE+1] = dev->rangeRate&0xff;
+    TofSetReg32(dev, VL_REG_RETURN_AMB_COUNT, dev->rangeAmbCount);
+    TofSetReg32(dev, VL_REG_RETURN_CONV_TIME, dev->rangeConvUs);
+    dev->regs[VL_REG_INTERRUPT_STATUS] = (dev->regs[VL_REG_INTERRUPT_STATUS]&~0x07)|0x04; /* new sample ready */
+  }
+  if (dev->alsBusy && SIMHW_TimeNs>=dev->alsReadyNs) {
+    dev->alsBusy = FALSE;
+    als = SIM_GetTofAmbient(slot);
+    dev->regs[VL_REG_ALS_VAL] = als>>8;
+    dev->regs[VL_REG_ALS_VAL+1] = als&0xff;
+    dev->regs[VL_REG_INTERRUPT_STATUS] = (dev->regs[VL_REG_INTERRUPT_STATUS]&~0x38)|0x20; /* new sample ready */
+  }
+}
+
+static void TofWrite(SIMHW_TofDevice *dev, uint16_t reg, uint8_t val) {
+  switch(reg) {
+    case VL_REG_SYSRANGE_START:
+      if (val&0x01) {
+        TofStartRange(dev);
+      }
+      break;
+    case VL_REG_SYSALS_START:
+      if (val&0x01) {
+        dev->alsBusy = TRUE;
+        dev->alsReadyNs = SIMHW_TimeNs+SIMHW_TOF_ALS_NS;
+      }
+      break;
+    case VL_REG_INTERRUPT_CLEAR:
+      if (val&0x01) {
+        dev->regs[VL_REG_INTERRUPT_STATUS] &= ~0x07;
+      }
+      if (val&0x02) {
+        dev->regs[VL_REG_INTERRUPT_STATUS] &= ~0x38;
+      }
+      if (val&0x04) {
+        dev->regs[VL_REG_INTERRUPT_STATUS] &= ~0xC0;
+      }
+      break;
+    case VL_REG_DEVICE_ADDRESS:
+      dev->addr = val&0x7f;
+      dev->regs[reg] = dev->addr;
+      break;
+    default:
+      dev->regs[reg] = val;
+      break;
+  }
+}
+
+uint8_t GI2C1_ReadAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize) {
+  SIMHW_TofDevice *dev;
+  uint16_t reg, i;
+
+  dev = TofFind(i2cAddr);
+  if (dev==NULL || memAddrSize!=2) {
+    return ERR_FAILED;
+  }
+  TofUpdate(dev);
+  reg = (memAddr[0]<<8)|memAddr[1];
+  for(i=0;i<dataSize;i++) {
+    data[i] = (reg+i<SIMHW_TOF_NOF_REGS) ? dev->regs[reg+i] : 0;
+  }
+  return ERR_OK;
+}
+
+uint8_t GI2C1_WriteAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize) {
+  SIMHW_TofDevice *dev;
+  uint16_t reg, i;
+
+  dev = TofFind(i2cAddr);
+  if (dev==NULL || memAddrSize!=2) {
+    return ERR_FAILED;
+  }
+  TofUpdate(dev);
+  reg = (memAddr[0]<<8)|memAddr[1];
+  for(i=0;i<dataSize;i++) {
+    if (reg+i<SIMHW_TOF_NOF_REGS) {
+      TofWrite(dev, reg+i, data[i]);
+    }
+  }
+  return ERR_OK;
+}
+
+void GI2C1_Init(void) {
+  /* nothing needed */
+}
+
+void GI2C1_Deinit(void) {
+  /* nothing needed */
+}
+
+/* ------------------------------ CPU and utility components ------------------------------ */
+uint8_t KIN1_UIDGet(KIN1_UID *uid) {
+  SIM_GetRobotUID(uid);
+  return ERR_OK;
+}
+
+bool KIN1_UIDSame(const KIN1_UID *src, const KIN1_UID *dst) {
+  return memcmp(src->id, dst->id, sizeof(src->id))==0;
+}
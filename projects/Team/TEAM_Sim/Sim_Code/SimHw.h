@@ -0,0 +1,177 @@
+/**
+ * \file
+ * \brief Host emulation of the robot hardware components.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Replaces the Processor Expert components used by the common robot modules (motor PWM and direction,
+ * quadrature counters, reflectance sensor pins and timer, I2C bus with the VL6180X ToF sensors, LEDs).
+ * The component headers (PWML.h, Q4CLeft.h, IR1.h, ...) only include this file.
+ * The physical values (motor inputs, encoder counts, sensor discharge times and ranges) are
+ * exchanged with the robot and world model through the SIMHW_ interface at the end of this file.
+ */
+
+#ifndef SIMHW_H_
+#define SIMHW_H_
+
+#include "PE_Types.h"
+
+/* ------------------------------------ motors ------------------------------------ */
+uint8_t SIMHW_PwmSetRatio16(uint8_t motor, uint16_t ratio);
+uint8_t SIMHW_PwmEnable(uint8_t motor);
+void SIMHW_DirPutVal(uint8_t motor, bool val);
+
+#define PWML_SetRatio16(ratio)  SIMHW_PwmSetRatio16(SIMHW_LEFT, ratio)
+#define PWML_Enable()           SIMHW_PwmEnable(SIMHW_LEFT)
+#define PWMR_SetRatio16(ratio)  SIMHW_PwmSetRatio16(SIMHW_RIGHT, ratio)
+#define PWMR_Enable()           SIMHW_PwmEnable(SIMHW_RIGHT)
+#define DIRL_PutVal(val)        SIMHW_DirPutVal(SIMHW_LEFT, val)
+#define DIRR_PutVal(val)        SIMHW_DirPutVal(SIMHW_RIGHT, val)
+
+/* ------------------------------- quadrature counters ------------------------------- */
+typedef int32_t Q4CLeft_QuadCntrType;
+typedef int32_t Q4CRight_QuadCntrType;
+
+int32_t SIMHW_QuadGetPos(uint8_t motor);
+void SIMHW_QuadSetPos(uint8_t motor, int32_t pos);
+uint8_t SIMHW_QuadSwapPins(uint8_t motor, bool swap);
+
+#define Q4CLeft_GetPos()        SIMHW_QuadGetPos(SIMHW_LEFT)
+#define Q4CLeft_SetPos(pos)     SIMHW_QuadSetPos(SIMHW_LEFT, pos)
+#define Q4CLeft_NofErrors()     ((uint16_t)0)
+#define Q4CLeft_SwapPins(swap)  SIMHW_QuadSwapPins(SIMHW_LEFT, swap)
+#define Q4CRight_GetPos()       SIMHW_QuadGetPos(SIMHW_RIGHT)
+#define Q4CRight_SetPos(pos)    SIMHW_QuadSetPos(SIMHW_RIGHT, pos)
+#define Q4CRight_NofErrors()    ((uint16_t)0)
+#define Q4CRight_SwapPins(swap) SIMHW_QuadSwapPins(SIMHW_RIGHT, swap)
+
+/* ------------------------------- reflectance sensors ------------------------------- */
+typedef uint16_t RefCnt_TValueType;
+#define RefCnt_CNT_INP_FREQ_U_0  12000000UL /* counter input frequency in Hz */
+
+void SIMHW_IrSetOutput(uint8_t sensor);
+void SIMHW_IrSetInput(uint8_t sensor);
+void SIMHW_IrSetVal(uint8_t sensor);
+bool SIMHW_IrGetVal(uint8_t sensor);
+void SIMHW_IrLed(bool on);
+LDD_TDeviceData *RefCnt_Init(LDD_TUserData *userData);
+LDD_TError RefCnt_ResetCounter(LDD_TDeviceData *deviceData);
+RefCnt_TValueType RefCnt_GetCounterValue(LDD_TDeviceData *deviceData);
+
+#define IR1_SetOutput()  SIMHW_IrSetOutput(0)
+#define IR1_SetInput()   SIMHW_IrSetInput(0)
+#define IR1_SetVal()     SIMHW_IrSetVal(0)
+#define IR1_GetVal()     SIMHW_IrGetVal(0)
+#define IR2_SetOutput()  SIMHW_IrSetOutput(1)
+#define IR2_SetInput()   SIMHW_IrSetInput(1)
+#define IR2_SetVal()     SIMHW_IrSetVal(1)
+#define IR2_GetVal()     SIMHW_IrGetVal(1)
+#define IR3_SetOutput()  SIMHW_IrSetOutput(2)
+#define IR3_SetInput()   SIMHW_IrSetInput(2)
+#define IR3_SetVal()     SIMHW_IrSetVal(2)
+#define IR3_GetVal()     SIMHW_IrGetVal(2)
+#define IR4_SetOutput()  SIMHW_IrSetOutput(3)
+#define IR4_SetInput()   SIMHW_IrSetInput(3)
+#define IR4_SetVal()     SIMHW_IrSetVal(3)
+#define IR4_GetVal()     SIMHW_IrGetVal(3)
+#define IR5_SetOutput()  SIMHW_IrSetOutput(4)
+#define IR5_SetInput()   SIMHW_IrSetInput(4)
+#define IR5_SetVal()     SIMHW_IrSetVal(4)
+#define IR5_GetVal()     SIMHW_IrGetVal(4)
+#define IR6_SetOutput()  SIMHW_IrSetOutput(5)
+#define IR6_SetInput()   SIMHW_IrSetInput(5)
+#define IR6_SetVal()     SIMHW_IrSetVal(5)
+#define IR6_GetVal()     SIMHW_IrGetVal(5)
+#define LED_IR_On()      SIMHW_IrLed(TRUE)
+#define LED_IR_Off()     SIMHW_IrLed(FALSE)
+
+/* ---------------------------- I2C bus and ToF sensors ---------------------------- */
+uint8_t GI2C1_ReadAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize);
+uint8_t GI2C1_WriteAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize);
+void GI2C1_Init(void);
+void GI2C1_Deinit(void);
+
+void SIMHW_TofCE(uint8_t ce, bool output, bool high);
+void SIMHW_TofPower(bool on);
+
+/* CE pin: input means pulled high by the board (chip enabled), output low means chip disabled */
+#define TofCE1_SetInput()   SIMHW_TofCE(0, FALSE, TRUE)
+#define TofCE1_SetOutput()  SIMHW_TofCE(0, TRUE, FALSE)
+#define TofCE1_ClrVal()     SIMHW_TofCE(0, TRUE, FALSE)
+#define TofCE1_SetVal()     SIMHW_TofCE(0, TRUE, TRUE)
+#define TofCE2_SetInput()   SIMHW_TofCE(1, FALSE, TRUE)
+#define TofCE2_SetOutput()  SIMHW_TofCE(1, TRUE, FALSE)
+#define TofCE2_ClrVal()     SIMHW_TofCE(1, TRUE, FALSE)
+#define TofCE2_SetVal()     SIMHW_TofCE(1, TRUE, TRUE)
+#define TofCE3_SetInput()   SIMHW_TofCE(2, FALSE, TRUE)
+#define TofCE3_SetOutput()  SIMHW_TofCE(2, TRUE, FALSE)
+#define TofCE3_ClrVal()     SIMHW_TofCE(2, TRUE, FALSE)
+#define TofCE3_SetVal()     SIMHW_TofCE(2, TRUE, TRUE)
+#define TofCE4_SetInput()   SIMHW_TofCE(3, FALSE, TRUE)
+#define TofCE4_SetOutput()  SIMHW_TofCE(3, TRUE, FALSE)
+#define TofCE4_ClrVal()     SIMHW_TofCE(3, TRUE, FALSE)
+#define TofCE4_SetVal()     SIMHW_TofCE(3, TRUE, TRUE)
+#define TofPwr_ClrVal()     SIMHW_TofPower(TRUE)  /* low active */
+#define TofPwr_SetVal()     SIMHW_TofPower(FALSE)
+
+/* ------------------------------------- LEDs ------------------------------------- */
+extern bool SIMHW_LedPin[2];
+
+#define LEDPin1_ClrVal()     (SIMHW_LedPin[0] = FALSE)
+#define LEDPin1_SetVal()     (SIMHW_LedPin[0] = TRUE)
+#define LEDPin1_NegVal()     (SIMHW_LedPin[0] = !SIMHW_LedPin[0])
+#define LEDPin1_GetVal()     (SIMHW_LedPin[0])
+#define LEDPin1_PutVal(val)  (SIMHW_LedPin[0] = (val))
+#define LEDPin2_ClrVal()     (SIMHW_LedPin[1] = FALSE)
+#define LEDPin2_SetVal()     (SIMHW_LedPin[1] = TRUE)
+#define LEDPin2_NegVal()     (SIMHW_LedPin[1] = !SIMHW_LedPin[1])
+#define LEDPin2_GetVal()     (SIMHW_LedPin[1])
+#define LEDPin2_PutVal(val)  (SIMHW_LedPin[1] = (val))
+
+/* ------------------------------ CPU and utility components ------------------------------ */
+typedef struct {
+  uint8_t id[16];
+} KIN1_UID;
+
+uint8_t KIN1_UIDGet(KIN1_UID *uid);
+bool KIN1_UIDSame(const KIN1_UID *src, const KIN1_UID *dst);
+
+void WAIT1_Waitus(uint16_t us);
+void WAIT1_Waitms(uint16_t ms);
+void WAIT1_WaitOSms(uint16_t ms);
+
+#define CS1_CriticalVariable()  /* nothing needed: only one task runs at a time */
+#define CS1_EnterCritical()     do {} while(0)
+#define CS1_ExitCritical()      do {} while(0)
+
+/* --------------------- interface to the robot and world model --------------------- */
+#define SIMHW_LEFT    0
+#define SIMHW_RIGHT   1
+#define SIMHW_NOF_IR  6 /* reflectance sensors, IR1 is the left one */
+#define SIMHW_NOF_TOF 4 /* ToF sensor slots, one for each CE pin */
+
+/*!
+ * \brief Returns the motor input.
+ * \param motor SIMHW_LEFT or SIMHW_RIGHT.
+ * \return Duty cycle -1.0..+1.0, positive values drive the robot forward.
+ */
+float SIMHW_GetMotorInput(uint8_t motor);
+
+/*!
+ * \brief Advances the microsecond clock to the start of the current RTOS tick, called by the tick hook.
+ * \param tick Current tick count.
+ */
+void SIMHW_OnTick(uint32_t tick);
+
+/*! \brief Returns the simulated time in microseconds */
+uint64_t SIMHW_GetTimeUs(void);
+
+/* implemented by the robot and world model (Sim.c) */
+double SIM_GetEncoderCounts(uint8_t motor);  /*!< quadrature counts since start, increasing for forward motion unless the encoder is wired reversed */
+uint32_t SIM_GetIrDischargeNs(uint8_t sensor); /*!< discharge time of a reflectance sensor at the current pose, in ns */
+int SIM_GetTofRangeMm(uint8_t slot);          /*!< ToF range at the current pose, <0 if no target in range, SIM_TOF_NOT_FITTED if the slot is empty */
+uint16_t SIM_GetTofAmbient(uint8_t slot);     /*!< ambient light value of a ToF sensor */
+void SIM_GetRobotUID(KIN1_UID *uid);          /*!< unique ID of the simulated robot */
+
+#define SIM_TOF_NOT_FITTED  (-1000)
+
+#endif /* SIMHW_H_ */
@@ -0,0 +1,228 @@
+/**
+ * \file
+ * \brief Host emulation of the Nokia LCD components, see SimLcd.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#include "SimLcd.h"
+#include <string.h>
+
+#define SIMLCD_WIDTH        84
+#define SIMLCD_HEIGHT       48
+#define SIMLCD_PAGE_HEIGHT  8
+#define SIMLCD_NOF_PAGES    (SIMLCD_HEIGHT/SIMLCD_PAGE_HEIGHT)
+#define SIMLCD_CMD_BYTES    2  /* set X and set Y address before the data of a page run */
+#define SIMLCD_FONT_BOX     10 /* pixel rows of a character */
+#define SIMLCD_FONT_LINE    12 /* pixel rows of a text line, 4 lines on the display as on the remote */
+#define SIMLCD_FONT_WIDTH   5  /* pixel columns of most characters, plus one column of space */
+
+static uint8_t SIMLCD_FrameBuf[SIMLCD_NOF_PAGES][SIMLCD_WIDTH]; /* RAM frame buffer, drawn into */
+static uint8_t SIMLCD_DisplayRam[SIMLCD_NOF_PAGES][SIMLCD_WIDTH]; /* controller RAM, what is shown */
+static SIMLCD_Transfers SIMLCD_Stats;
+static GFONT_Callbacks SIMLCD_Font = {SIMLCD_FONT_BOX, SIMLCD_FONT_LINE};
+
+/* ------------------------------------ GDisp1 ------------------------------------ */
+GDisp1_PixelDim GDisp1_GetWidth(void) {
+  return SIMLCD_WIDTH;
+}
+
+GDisp1_PixelDim GDisp1_GetHeight(void) {
+  return SIMLCD_HEIGHT;
+}
+
+void GDisp1_Clear(void) {
+  memset(SIMLCD_FrameBuf, 0, sizeof(SIMLCD_FrameBuf));
+}
+
+static void SIMLCD_PutPixel(int x, int y, GDisp1_PixelColor color) {
+  if (x<0 || y<0 || x>=SIMLCD_WIDTH || y>=SIMLCD_HEIGHT) {
+    return; /* clipped */
+  }
+  if (color==GDisp1_COLOR_BLACK) {
+    SIMLCD_FrameBuf[y/SIMLCD_PAGE_HEIGHT][x] |= (uint8_t)(1<<(y%SIMLCD_PAGE_HEIGHT));
+  } else {
+    SIMLCD_FrameBuf[y/SIMLCD_PAGE_HEIGHT][x] &= (uint8_t)~(1<<(y%SIMLCD_PAGE_HEIGHT));
+  }
+}
+
+void GDisp1_SetPixel(GDisp1_PixelDim x, GDisp1_PixelDim y) {
+  SIMLCD_PutPixel(x, y, GDisp1_COLOR_BLACK);
+}
+
+void GDisp1_ClrPixel(GDisp1_PixelDim x, GDisp1_PixelDim y) {
+  SIMLCD_PutPixel(x, y, GDisp1_COLOR_WHITE);
+}
+
+void GDisp1_DrawFilledBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelColor color) {
+  int i, j;
+
+  for(j=y;j<y+h;j++) {
+    for(i=x;i<x+w;i++) {
+      SIMLCD_PutPixel(i, j, color);
+    }
+  }
+}
+
+void GDisp1_DrawBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelDim lineWidth, GDisp1_PixelColor color) {
+  if (w==0 || h==0) {
+    return;
+  }
+  if (2*lineWidth>=w || 2*lineWidth>=h) { /* no inside left */
+    GDisp1_DrawFilledBox(x, y, w, h, color);
+    return;
+  }
+  GDisp1_DrawFilledBox(x, y, w, lineWidth, color); /* top */
+  GDisp1_DrawFilledBox(x, (GDisp1_PixelDim)(y+h-lineWidth), w, lineWidth, color); /* bottom */
+  GDisp1_DrawFilledBox(x, y, lineWidth, h, color); /* left */
+  GDisp1_DrawFilledBox((GDisp1_PixelDim)(x+w-lineWidth), y, lineWidth, h, color); /* right */
+}
+
+void GDisp1_DrawLine(GDisp1_PixelDim x0, GDisp1_PixelDim y0, GDisp1_PixelDim x1, GDisp1_PixelDim y1, GDisp1_PixelColor color) {
+  int x = x0, y = y0, dx, dy, sx, sy, err, e2;
+
+  dx = x1>x0 ? x1-x0 : x0-x1;
+  dy = y1>y0 ? y0-y1 : y1-y0; /* negative */
+  sx = x0<x1 ? 1 : -1;
+  sy = y0<y1 ? 1 : -1;
+  err = dx+dy;
+  for(;;) { /* Bresenham */
+    SIMLCD_PutPixel(x, y, color);
+    if (x==x1 && y==y1) {
+      break;
+    }
+    e2 = 2*err;
+    if (e2>=dy) {
+      err += dy;
+      x += sx;
+    }
+    if (e2<=dx) {
+      err += dx;
+      y += sy;
+    }
+  }
+}
+
+void GDisp1_DrawCircle(GDisp1_PixelDim x0, GDisp1_PixelDim y0, GDisp1_PixelDim radius, GDisp1_PixelColor color) {
+  int x = radius, y = 0, err = 1-radius;
+
+  while (x>=y) { /* midpoint circle, eight octants */
+    SIMLCD_PutPixel(x0+x, y0+y, color);
+    SIMLCD_PutPixel(x0+y, y0+x, color);
+    SIMLCD_PutPixel(x0-y, y0+x, color);
+    SIMLCD_PutPixel(x0-x, y0+y, color);
+    SIMLCD_PutPixel(x0-x, y0-y, color);
+    SIMLCD_PutPixel(x0-y, y0-x, color);
+    SIMLCD_PutPixel(x0+y, y0-x, color);
+    SIMLCD_PutPixel(x0+x, y0-y, color);
+    y++;
+    if (err<0) {
+      err += 2*y+1;
+    } else {
+      x--;
+      err += 2*(y-x)+1;
+    }
+  }
+}
+
+void GDisp1_UpdateRegion(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h) {
+  int page, lastPage, width;
+
+  if (w==0 || h==0 || x>=SIMLCD_WIDTH || y>=SIMLCD_HEIGHT) {
+    return;
+  }
+  width = x+w>SIMLCD_WIDTH ? SIMLCD_WIDTH-x : w;
+  lastPage = (y+h-1)/SIMLCD_PAGE_HEIGHT;
+  if (lastPage>=SIMLCD_NOF_PAGES) {
+    lastPage = SIMLCD_NOF_PAGES-1;
+  }
+  SIMLCD_Stats.nofUpdates++;
+  for(page=y/SIMLCD_PAGE_HEIGHT;page<=lastPage;page++) {
+    memcpy(&SIMLCD_DisplayRam[page][x], &SIMLCD_FrameBuf[page][x], (size_t)width);
+    SIMLCD_Stats.nofBytes += (uint32_t)width;
+    SIMLCD_Stats.nofCmdBytes += SIMLCD_CMD_BYTES;
+  }
+}
+
+void GDisp1_UpdateFull(void) {
+  memcpy(SIMLCD_DisplayRam, SIMLCD_FrameBuf, sizeof(SIMLCD_DisplayRam));
+  SIMLCD_Stats.nofUpdates++;
+  SIMLCD_Stats.nofBytes += sizeof(SIMLCD_DisplayRam);
+  SIMLCD_Stats.nofCmdBytes += SIMLCD_CMD_BYTES; /* the address wraps to the next page */
+}
+
+/* ------------------------------------ GFONT1 ------------------------------------ */
+PGFONT_Callbacks GFONT1_GetFont(void) {
+  return &SIMLCD_Font;
+}
+
+uint8_t GFONT1_GetBoxHeight(void) {
+  return SIMLCD_FONT_LINE;
+}
+
+/* ------------------------------------ FDisp1 ------------------------------------ */
+void FDisp1_GetFontHeight(GFONT_Callbacks *font, FDisp1_PixelDim *charHeight, FDisp1_PixelDim *totalHeight) {
+  *charHeight = font->boxHeight;
+  *totalHeight = font->lineHeight;
+}
+
+void FDisp1_GetCharWidth(uint8_t ch, FDisp1_PixelDim *charWidth, FDisp1_PixelDim *totalWidth, GFONT_Callbacks *font) {
+  (void)font;
+  if (ch==' ') {
+    *charWidth = 2;
+  } else if (strchr("il.:!|'", ch)!=NULL) { /* narrow characters of a proportional font */
+    *charWidth = 1;
+  } else {
+    *charWidth = SIMLCD_FONT_WIDTH;
+  }
+  *totalWidth = (FDisp1_PixelDim)(*charWidth+1);
+}
+
+void FDisp1_WriteChar(uint8_t ch, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font) {
+  FDisp1_PixelDim charWidth, totalWidth;
+  uint32_t bits;
+  int col, row;
+
+  if (ch=='\n') {
+    *x = 0;
+    *y = (FDisp1_PixelDim)(*y+font->lineHeight);
+    return;
+  }
+  FDisp1_GetCharWidth(ch, &charWidth, &totalWidth, font);
+  if (ch!=' ') {
+    for(col=0;col<charWidth;col++) { /* pattern of the character code, the background stays */
+      bits = ((uint32_t)ch*2654435761UL)>>(col*3);
+      for(row=1;row<font->boxHeight-1;row++) {
+        if (bits&(1UL<<(row%8))) {
+          SIMLCD_PutPixel(*x+col, *y+row, color);
+        }
+      }
+    }
+  }
+  *x = (FDisp1_PixelDim)(*x+totalWidth);
+}
+
+void FDisp1_WriteString(unsigned char *str, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font) {
+  while (*str!='\0') {
+    FDisp1_WriteChar(*str, color, x, y, font);
+    str++;
+  }
+}
+
+/* ------------------------------ interface to the benchmarks ------------------------------ */
+void SIMLCD_Reset(void) {
+  memset(SIMLCD_FrameBuf, 0, sizeof(SIMLCD_FrameBuf));
+  memset(SIMLCD_DisplayRam, 0, sizeof(SIMLCD_DisplayRam));
+  SIMLCD_ResetTransfers();
+}
+
+void SIMLCD_ResetTransfers(void) {
+  memset(&SIMLCD_Stats, 0, sizeof(SIMLCD_Stats));
+}
+
+void SIMLCD_GetTransfers(SIMLCD_Transfers *transfers) {
+  *transfers = SIMLCD_Stats;
+}
+
+bool SIMLCD_IsDisplayUpToDate(void) {
+  return memcmp(SIMLCD_FrameBuf, SIMLCD_DisplayRam, sizeof(SIMLCD_DisplayRam))==0;
+}
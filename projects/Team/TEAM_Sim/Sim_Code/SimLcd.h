@@ -0,0 +1,79 @@
+/**
+ * \file
+ * \brief Host emulation of the Nokia LCD components (GDisp1, FDisp1, GFONT1).
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The 84x48 display is organized like the PCD8544 controller: pages of 8 pixel rows with one byte per column.
+ * Drawing goes into the RAM frame buffer, GDisp1_UpdateRegion() and GDisp1_UpdateFull() copy it to the
+ * controller RAM and count the transferred bytes, as the SPI transfers on the remote.
+ * The font is a stand-in with the cell size of the remote font: the glyphs are a pattern derived from
+ * the character code, only their extent matters for the transfers.
+ * The component headers (GDisp1.h, FDisp1.h, GFONT1.h) only include this file.
+ */
+
+#ifndef SIMLCD_H_
+#define SIMLCD_H_
+
+#include "PE_Types.h"
+
+/* ------------------------------------ GDisp1 ------------------------------------ */
+typedef uint8_t GDisp1_PixelDim;
+typedef uint8_t GDisp1_PixelColor;
+
+#define GDisp1_COLOR_WHITE  ((GDisp1_PixelColor)0)
+#define GDisp1_COLOR_BLACK  ((GDisp1_PixelColor)1)
+
+GDisp1_PixelDim GDisp1_GetWidth(void);
+GDisp1_PixelDim GDisp1_GetHeight(void);
+void GDisp1_Clear(void);
+void GDisp1_SetPixel(GDisp1_PixelDim x, GDisp1_PixelDim y);
+void GDisp1_ClrPixel(GDisp1_PixelDim x, GDisp1_PixelDim y);
+void GDisp1_DrawBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelDim lineWidth, GDisp1_PixelColor color);
+void GDisp1_DrawFilledBox(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h, GDisp1_PixelColor color);
+void GDisp1_DrawLine(GDisp1_PixelDim x0, GDisp1_PixelDim y0, GDisp1_PixelDim x1, GDisp1_PixelDim y1, GDisp1_PixelColor color);
+void GDisp1_DrawCircle(GDisp1_PixelDim x0, GDisp1_PixelDim y0, GDisp1_PixelDim radius, GDisp1_PixelColor color);
+void GDisp1_UpdateRegion(GDisp1_PixelDim x, GDisp1_PixelDim y, GDisp1_PixelDim w, GDisp1_PixelDim h);
+void GDisp1_UpdateFull(void);
+
+/* ------------------------------------ GFONT1 ------------------------------------ */
+typedef struct {
+  uint8_t boxHeight;  /* pixel rows of a character cell */
+  uint8_t lineHeight; /* pixel rows from one text line to the next */
+} GFONT_Callbacks;
+typedef GFONT_Callbacks *PGFONT_Callbacks;
+
+PGFONT_Callbacks GFONT1_GetFont(void);
+uint8_t GFONT1_GetBoxHeight(void);
+
+/* ------------------------------------ FDisp1 ------------------------------------ */
+typedef uint8_t FDisp1_PixelDim;
+
+void FDisp1_GetFontHeight(GFONT_Callbacks *font, FDisp1_PixelDim *charHeight, FDisp1_PixelDim *totalHeight);
+void FDisp1_GetCharWidth(uint8_t ch, FDisp1_PixelDim *charWidth, FDisp1_PixelDim *totalWidth, GFONT_Callbacks *font);
+void FDisp1_WriteChar(uint8_t ch, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font);
+void FDisp1_WriteString(unsigned char *str, GDisp1_PixelColor color, FDisp1_PixelDim *x, FDisp1_PixelDim *y, GFONT_Callbacks *font);
+
+/* ------------------------------ interface to the benchmarks ------------------------------ */
+/*! \brief Transfers to the display controller since the last SIMLCD_ResetTransfers() */
+typedef struct {
+  uint32_t nofUpdates;  /*!< calls of GDisp1_UpdateRegion() and GDisp1_UpdateFull() */
+  uint32_t nofBytes;    /*!< display data bytes */
+  uint32_t nofCmdBytes; /*!< command bytes, two to set the address of each page run */
+} SIMLCD_Transfers;
+
+/*! \brief Clears the frame buffer and the controller RAM and resets the transfer counters */
+void SIMLCD_Reset(void);
+
+/*! \brief Resets the transfer counters */
+void SIMLCD_ResetTransfers(void);
+
+/*! \brief Returns the transfer counters */
+void SIMLCD_GetTransfers(SIMLCD_Transfers *transfers);
+
+/*!
+ * \brief Compares the controller RAM with the frame buffer.
+ * \return TRUE if the display shows what has been drawn.
+ */
+bool SIMLCD_IsDisplayUpToDate(void);
+
+#endif /* SIMLCD_H_ */
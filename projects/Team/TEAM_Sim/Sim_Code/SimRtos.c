@@ -0,0 +1,484 @@
+/**
+ * \file
+ * \brief Host implementation of the FreeRTOS subset, see FRTOS1.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Each task is a thread, but a task only runs while the scheduler has handed control to it,
+ * so the robot modules see the same mutual exclusion as on the single core target.
+ * A task which does not block within SIMRTOS_SLICE_US of host CPU time (a polling loop) gets preempted
+ * with a signal: it has used up the current tick, and tasks with a lower priority starve until it blocks,
+ * as they would on the target.
+ */
+
+#include "Platform.h"
+#include "FRTOS1.h"
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIMRTOS_MAX_DISPATCH_PER_TICK  100000 /* a task yielding more often without time passing is a livelock */
+#define SIMRTOS_SLICE_US               2000   /* host CPU time after which a task which does not block gets preempted */
+#define SIMRTOS_SPIN_SLICE_US          200    /* same, for a task which has been preempted and not blocked since */
+#define SIMRTOS_PREEMPT_SIGNAL         SIGUSR1
+
+struct SIMRTOS_Task {
+  pthread_t thread;
+  pthread_cond_t cond;      /* signaled when the task gets dispatched */
+  TaskFunction_t fn;
+  void *param;
+  UBaseType_t prio;
+  char name[16];
+  TickType_t wakeTick;      /* task is ready if the tick count has reached this value */
+  const void *blockedOn;    /* queue or task (notification) the task waits for, NULL otherwise */
+  uint32_t lastRun;         /* dispatch sequence number, for round robin between equal priorities */
+  UBaseType_t taskNumber;   /* vTaskSetTaskNumber(), for the trace */
+  uint32_t notifyValue;
+  bool notifyPending;
+  volatile bool preemptRequest; /* set by the scheduler before it sends the preemption signal */
+  bool spinning;            /* preempted: ready, but has used up the current tick */
+  struct SIMRTOS_Task *next;
+};
+
+struct SIMRTOS_Queue {
+  uint8_t *buf;
+  UBaseType_t length, itemSize;
+  UBaseType_t count, head;
+  const char *name;
+};
+
+static pthread_mutex_t SIMRTOS_Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t SIMRTOS_SchedCond = PTHREAD_COND_INITIALIZER;
+static struct SIMRTOS_Task *SIMRTOS_Tasks = NULL;    /* list of all tasks */
+static struct SIMRTOS_Task *SIMRTOS_Running = NULL;  /* task which has the CPU, NULL if the scheduler has it */
+static volatile TickType_t SIMRTOS_TickCount = 0;
+static uint32_t SIMRTOS_DispatchSeq = 0;
+
+static void PreemptSignal(bool enable) {
+  sigset_t set;
+
+  sigemptyset(&set);
+  sigaddset(&set, SIMRTOS_PREEMPT_SIGNAL);
+  pthread_sigmask(enable ? SIG_UNBLOCK : SIG_BLOCK, &set, NULL);
+}
+
+static void *TaskThread(void *arg) {
+  struct SIMRTOS_Task *task = (struct SIMRTOS_Task*)arg;
+
+  PreemptSignal(FALSE);
+  pthread_mutex_lock(&SIMRTOS_Lock);
+  while (SIMRTOS_Running!=task) {
+    pthread_cond_wait(&task->cond, &SIMRTOS_Lock);
+  }
+  pthread_mutex_unlock(&SIMRTOS_Lock);
+  PreemptSignal(TRUE);
+  task->fn(task->param);
+  fprintf(stderr, "ERROR: task '%s' returned\n", task->name);
+  exit(EXIT_FAILURE);
+  return NULL;
+}
+
+/* gives the CPU back to the scheduler, returns when the task gets dispatched again */
+static void Switch(struct SIMRTOS_Task *task, TickType_t wakeTick, const void *blockedOn) {
+  task->wakeTick = wakeTick;
+  task->blockedOn = blockedOn;
+  pthread_mutex_lock(&SIMRTOS_Lock);
+  SIMRTOS_Running = NULL;
+  pthread_cond_signal(&SIMRTOS_SchedCond);
+  while (SIMRTOS_Running!=task) {
+    pthread_cond_wait(&task->cond, &SIMRTOS_Lock);
+  }
+  task->preemptRequest = FALSE; /* a late signal must not preempt the task again */
+  pthread_mutex_unlock(&SIMRTOS_Lock);
+  task->blockedOn = NULL;
+}
+
+static void Block(TickType_t wakeTick, const void *blockedOn) {
+  struct SIMRTOS_Task *task = SIMRTOS_Running;
+
+  if (task==NULL) {
+    return; /* called from main() before the scheduler runs: nothing to wait for */
+  }
+  PreemptSignal(FALSE);
+  task->spinning = FALSE;
+  Switch(task, wakeTick, blockedOn);
+  PreemptSignal(TRUE);
+}
+
+/* signal handler, runs in the thread of the task to preempt */
+static void PreemptHandler(int sig) {
+  struct SIMRTOS_Task *task = SIMRTOS_Running;
+
+  (void)sig;
+  if (task==NULL || !pthread_equal(task->thread, pthread_self()) || !task->preemptRequest) {
+    return;
+  }
+  task->spinning = TRUE;
+  Switch(task, SIMRTOS_TickCount+1, NULL); /* the signal is blocked while the handler runs */
+}
+
+static TickType_t TimeoutTick(TickType_t ticksToWait) {
+  if (ticksToWait==portMAX_DELAY) {
+    return portMAX_DELAY;
+  }
+  return SIMRTOS_TickCount+ticksToWait;
+}
+
+/* makes the tasks waiting for an object ready */
+static void WakeWaiters(const void *obj) {
+  struct SIMRTOS_Task *t;
+
+  for(t=SIMRTOS_Tasks; t!=NULL; t=t->next) {
+    if (t->blockedOn==obj) {
+      t->wakeTick = SIMRTOS_TickCount;
+    }
+  }
+}
+
+static struct SIMRTOS_Task *PickReady(void) {
+  struct SIMRTOS_Task *t, *best = NULL;
+  UBaseType_t minPrio = 0;
+
+  for(t=SIMRTOS_Tasks; t!=NULL; t=t->next) {
+    if (t->spinning && t->prio>minPrio) {
+      minPrio = t->prio; /* lower priorities do not get the CPU while this task polls */
+    }
+  }
+  for(t=SIMRTOS_Tasks; t!=NULL; t=t->next) {
+    if (t->wakeTick==portMAX_DELAY || t->wakeTick>SIMRTOS_TickCount || t->prio<minPrio) {
+      continue; /* blocked */
+    }
+    if (best==NULL || t->prio>best->prio || (t->prio==best->prio && t->lastRun<best->lastRun)) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+static uint64_t CpuTimeUs(clockid_t clock) {
+  struct timespec ts;
+
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec*1000000ULL+ts.tv_nsec/1000;
+}
+
+static void Dispatch(struct SIMRTOS_Task *task) {
+  struct timespec deadline;
+  clockid_t cpuClock;
+  uint64_t cpuStart, slice = task->spinning ? SIMRTOS_SPIN_SLICE_US : SIMRTOS_SLICE_US;
+
+  task->lastRun = ++SIMRTOS_DispatchSeq;
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_OnTaskSwitchedIn((uint8_t)task->taskNumber); /* traceTASK_SWITCHED_IN() on the target, see RtosTraceHooks.h */
+#endif
+  pthread_getcpuclockid(task->thread, &cpuClock);
+  cpuStart = CpuTimeUs(cpuClock);
+  pthread_mutex_lock(&SIMRTOS_Lock);
+  SIMRTOS_Running = task;
+  pthread_cond_signal(&task->cond);
+  while (SIMRTOS_Running!=NULL) {
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)slice*1000L;
+    if (deadline.tv_nsec>=1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    if (pthread_cond_timedwait(&SIMRTOS_SchedCond, &SIMRTOS_Lock, &deadline)!=0 && SIMRTOS_Running==task
+        && CpuTimeUs(cpuClock)-cpuStart>=slice) /* CPU time: a loaded host does not cause preemptions */
+    {
+      task->preemptRequest = TRUE; /* polling: preempt it, then wait without a time limit */
+      pthread_kill(task->thread, SIMRTOS_PREEMPT_SIGNAL);
+      while (SIMRTOS_Running!=NULL) {
+        pthread_cond_wait(&SIMRTOS_SchedCond, &SIMRTOS_Lock);
+      }
+    }
+  }
+  pthread_mutex_unlock(&SIMRTOS_Lock);
+}
+
+void SIMRTOS_RunUntil(TickType_t endTick, volatile bool *stopP) {
+  static bool handlerInstalled = FALSE;
+  struct SIMRTOS_Task *task;
+  uint32_t nofDispatch = 0;
+
+  if (!handlerInstalled) {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = PreemptHandler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIMRTOS_PREEMPT_SIGNAL, &sa, NULL);
+    handlerInstalled = TRUE;
+  }
+
+  while (SIMRTOS_TickCount<endTick && (stopP==NULL || !*stopP)) {
+    task = PickReady();
+    if (task!=NULL && nofDispatch<SIMRTOS_MAX_DISPATCH_PER_TICK) {
+      nofDispatch++;
+      Dispatch(task);
+    } else {
+      if (task!=NULL) {
+        fprintf(stderr, "WARNING: task '%s' does not block, forcing a tick\n", task->name);
+      }
+      nofDispatch = 0;
+      SIMRTOS_TickCount++;
+      FRTOS1_vApplicationTickHook();
+    }
+  }
+}
+
+BaseType_t SIMRTOS_TaskCreate(TaskFunction_t fn, const char *name, uint16_t stackDepth, void *param, UBaseType_t prio, TaskHandle_t *handle) {
+  struct SIMRTOS_Task *task, **pp;
+
+  (void)stackDepth; /* host threads use the default stack size */
+  task = calloc(1, sizeof(*task));
+  if (task==NULL) {
+    return pdFAIL;
+  }
+  task->fn = fn;
+  task->param = param;
+  task->prio = prio;
+  strncpy(task->name, name, sizeof(task->name)-1);
+  task->wakeTick = SIMRTOS_TickCount;
+  pthread_cond_init(&task->cond, NULL);
+  for(pp=&SIMRTOS_Tasks; *pp!=NULL; pp=&(*pp)->next) {} /* append, keeps the creation order */
+  *pp = task;
+  if (pthread_create(&task->thread, NULL, TaskThread, task)!=0) {
+    return pdFAIL;
+  }
+  if (handle!=NULL) {
+    *handle = task;
+  }
+  return pdPASS;
+}
+
+void SIMRTOS_TaskDelay(TickType_t ticks) {
+  Block(SIMRTOS_TickCount+ticks, NULL);
+}
+
+void SIMRTOS_TaskDelayUntil(TickType_t *prevWakeTime, TickType_t increment) {
+  TickType_t wake = *prevWakeTime+increment;
+
+  *prevWakeTime = wake;
+  if ((int32_t)(wake-SIMRTOS_TickCount)>0) {
+    Block(wake, NULL);
+  } else {
+    Block(SIMRTOS_TickCount, NULL); /* overrun: only yield */
+  }
+}
+
+void SIMRTOS_TaskYield(void) {
+  Block(SIMRTOS_TickCount, NULL);
+}
+
+TickType_t SIMRTOS_GetTickCount(void) {
+  return SIMRTOS_TickCount;
+}
+
+UBaseType_t SIMRTOS_TaskGetNumberOfTasks(void) {
+  struct SIMRTOS_Task *t;
+  UBaseType_t n = 0;
+
+  for(t=SIMRTOS_Tasks; t!=NULL; t=t->next) {
+    n++;
+  }
+  return n;
+}
+
+UBaseType_t SIMRTOS_TaskGetSystemState(TaskStatus_t *tasks, UBaseType_t arraySize, uint32_t *totalRunTime) {
+  struct SIMRTOS_Task *t;
+  UBaseType_t n = 0;
+
+  if (totalRunTime!=NULL) {
+    *totalRunTime = 0; /* no run time statistics */
+  }
+  if (arraySize<SIMRTOS_TaskGetNumberOfTasks()) {
+    return 0; /* as FreeRTOS: all or nothing */
+  }
+  for(t=SIMRTOS_Tasks; t!=NULL; t=t->next) {
+    tasks[n].xHandle = t;
+    tasks[n].pcTaskName = t->name;
+    tasks[n].xTaskNumber = n+1;
+    tasks[n].uxCurrentPriority = t->prio;
+    n++;
+  }
+  return n;
+}
+
+void SIMRTOS_TaskSetTaskNumber(TaskHandle_t task, UBaseType_t number) {
+  if (task!=NULL) {
+    task->taskNumber = number;
+  }
+}
+
+BaseType_t SIMRTOS_TaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  if (task==NULL) {
+    return pdFAIL;
+  }
+  switch(action) {
+    case eSetBits:                  task->notifyValue |= value; break;
+    case eIncrement:                task->notifyValue++; break;
+    case eSetValueWithOverwrite:    task->notifyValue = value; break;
+    case eSetValueWithoutOverwrite:
+      if (task->notifyPending) {
+        return pdFAIL;
+      }
+      task->notifyValue = value;
+      break;
+    case eNoAction:
+    default:
+      break;
+  }
+  task->notifyPending = TRUE;
+  WakeWaiters(task);
+  return pdPASS;
+}
+
+BaseType_t SIMRTOS_TaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *valueP, TickType_t ticksToWait) {
+  struct SIMRTOS_Task *task = SIMRTOS_Running;
+  TickType_t timeout = TimeoutTick(ticksToWait);
+  BaseType_t res;
+
+  if (task==NULL) {
+    return pdFAIL;
+  }
+  if (!task->notifyPending) {
+    task->notifyValue &= ~clearOnEntry;
+    while (!task->notifyPending && (timeout==portMAX_DELAY || SIMRTOS_TickCount<timeout)) {
+      Block(timeout, task);
+    }
+  }
+  if (valueP!=NULL) {
+    *valueP = task->notifyValue;
+  }
+  res = task->notifyPending ? pdTRUE : pdFALSE;
+  if (res==pdTRUE) {
+    task->notifyValue &= ~clearOnExit;
+    task->notifyPending = FALSE;
+  }
+  return res;
+}
+
+uint32_t SIMRTOS_TaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+  struct SIMRTOS_Task *task = SIMRTOS_Running;
+  TickType_t timeout = TimeoutTick(ticksToWait);
+  uint32_t value;
+
+  if (task==NULL) {
+    return 0;
+  }
+  while (task->notifyValue==0 && (timeout==portMAX_DELAY || SIMRTOS_TickCount<timeout)) {
+    Block(timeout, task);
+  }
+  value = task->notifyValue;
+  if (value!=0) {
+    task->notifyValue = clearOnExit ? 0 : value-1;
+  }
+  task->notifyPending = FALSE;
+  return value;
+}
+
+QueueHandle_t SIMRTOS_QueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  struct SIMRTOS_Queue *q;
+
+  q = calloc(1, sizeof(*q));
+  if (q==NULL) {
+    return NULL;
+  }
+  q->length = length;
+  q->itemSize = itemSize;
+  if (itemSize>0) {
+    q->buf = calloc(length, itemSize);
+    if (q->buf==NULL) {
+      free(q);
+      return NULL;
+    }
+  }
+  return q;
+}
+
+void SIMRTOS_QueueDelete(QueueHandle_t queue) {
+  if (queue!=NULL) {
+    free(queue->buf);
+    free(queue);
+  }
+}
+
+BaseType_t SIMRTOS_QueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait, bool toFront) {
+  TickType_t timeout = TimeoutTick(ticksToWait);
+  UBaseType_t idx;
+
+  for(;;) { /* breaks */
+    if (queue->count<queue->length) {
+      break;
+    }
+    if (SIMRTOS_Running==NULL || (timeout!=portMAX_DELAY && SIMRTOS_TickCount>=timeout)) {
+      return errQUEUE_FULL;
+    }
+    Block(timeout, queue);
+  }
+  if (toFront) {
+    queue->head = (queue->head+queue->length-1)%queue->length;
+    idx = queue->head;
+  } else {
+    idx = (queue->head+queue->count)%queue->length;
+  }
+  if (queue->itemSize>0) {
+    memcpy(&queue->buf[idx*queue->itemSize], item, queue->itemSize);
+  }
+  queue->count++;
+  WakeWaiters(queue);
+  return pdPASS;
+}
+
+BaseType_t SIMRTOS_QueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait, bool peek) {
+  TickType_t timeout = TimeoutTick(ticksToWait);
+
+  for(;;) { /* breaks */
+    if (queue->count>0) {
+      break;
+    }
+    if (SIMRTOS_Running==NULL || (timeout!=portMAX_DELAY && SIMRTOS_TickCount>=timeout)) {
+      return pdFAIL;
+    }
+    Block(timeout, queue);
+  }
+  if (queue->itemSize>0) {
+    memcpy(item, &queue->buf[queue->head*queue->itemSize], queue->itemSize);
+  }
+  if (!peek) {
+    queue->head = (queue->head+1)%queue->length;
+    queue->count--;
+    WakeWaiters(queue);
+  }
+  return pdPASS;
+}
+
+UBaseType_t SIMRTOS_QueueMessagesWaiting(QueueHandle_t queue) {
+  return queue->count;
+}
+
+void SIMRTOS_QueueAddToRegistry(QueueHandle_t queue, const char *name) {
+  if (queue!=NULL) {
+    queue->name = name;
+  }
+}
+
+QueueHandle_t SIMRTOS_SemaphoreCreateMutex(void) {
+  QueueHandle_t sem;
+
+  sem = SIMRTOS_QueueCreate(1, 0);
+  if (sem!=NULL) {
+    (void)SIMRTOS_QueueSend(sem, NULL, 0, FALSE); /* a mutex is created available */
+  }
+  return sem;
+}
+
+QueueHandle_t SIMRTOS_SemaphoreCreateBinary(void) {
+  return SIMRTOS_QueueCreate(1, 0);
+}
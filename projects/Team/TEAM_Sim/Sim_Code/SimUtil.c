@@ -0,0 +1,308 @@
+/**
+ * \file
+ * \brief Host implementation of the console and utility components, see CLS1.h and UTIL1.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#include "CLS1.h"
+#include "UTIL1.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CLS1_HELP_SEMICOLON_POS    26 /* column of the ';' in help texts */
+#define CLS1_STATUS_SEMICOLON_POS  13 /* column of the ':' in status texts */
+
+/* ------------------------------------- UTIL1 ------------------------------------- */
+int16_t UTIL1_strcmp(const char *str1, const char *str2) {
+  return (int16_t)strcmp(str1, str2);
+}
+
+int16_t UTIL1_strncmp(const char *str1, const char *str2, size_t size) {
+  return (int16_t)strncmp(str1, str2, size);
+}
+
+void UTIL1_strcpy(uint8_t *dst, size_t dstSize, const unsigned char *src) {
+  if (dstSize==0) {
+    return;
+  }
+  dstSize--; /* for the terminating zero */
+  while (dstSize>0 && *src!='\0') {
+    *dst++ = *src++;
+    dstSize--;
+  }
+  *dst = '\0';
+}
+
+void UTIL1_strcat(uint8_t *dst, size_t dstSize, const unsigned char *src) {
+  size_t len = strlen((char*)dst);
+
+  if (len<dstSize) {
+    UTIL1_strcpy(dst+len, dstSize-len, src);
+  }
+}
+
+void UTIL1_chcat(uint8_t *dst, size_t dstSize, uint8_t ch) {
+  unsigned char buf[2];
+
+  buf[0] = ch;
+  buf[1] = '\0';
+  UTIL1_strcat(dst, dstSize, buf);
+}
+
+static void Format(uint8_t *dst, size_t dstSize, const char *fmt, long val) {
+  char buf[24];
+
+  (void)snprintf(buf, sizeof(buf), fmt, val);
+  UTIL1_strcpy(dst, dstSize, (unsigned char*)buf);
+}
+
+void UTIL1_Num8uToStr(uint8_t *dst, size_t dstSize, uint8_t val)   { Format(dst, dstSize, "%ld", val); }
+void UTIL1_Num16uToStr(uint8_t *dst, size_t dstSize, uint16_t val) { Format(dst, dstSize, "%ld", val); }
+void UTIL1_Num16sToStr(uint8_t *dst, size_t dstSize, int16_t val)  { Format(dst, dstSize, "%ld", val); }
+void UTIL1_Num32uToStr(uint8_t *dst, size_t dstSize, uint32_t val) { Format(dst, dstSize, "%ld", (long)val); }
+void UTIL1_Num32sToStr(uint8_t *dst, size_t dstSize, int32_t val)  { Format(dst, dstSize, "%ld", val); }
+
+void UTIL1_Num16sToStrFormatted(uint8_t *dst, size_t dstSize, int16_t val, char fill, uint8_t nofFill) {
+  char buf[24];
+  size_t len;
+
+  (void)snprintf(buf, sizeof(buf), "%d", val);
+  dst[0] = '\0';
+  for(len=strlen(buf); len<nofFill; len++) {
+    UTIL1_chcat(dst, dstSize, (uint8_t)fill);
+  }
+  UTIL1_strcat(dst, dstSize, (unsigned char*)buf);
+}
+
+static void CatFormat(uint8_t *dst, size_t dstSize, const char *fmt, long val) {
+  char buf[24];
+
+  (void)snprintf(buf, sizeof(buf), fmt, val);
+  UTIL1_strcat(dst, dstSize, (unsigned char*)buf);
+}
+
+void UTIL1_strcatNum8u(uint8_t *dst, size_t dstSize, uint8_t val)    { CatFormat(dst, dstSize, "%ld", val); }
+void UTIL1_strcatNum8s(uint8_t *dst, size_t dstSize, int8_t val)     { CatFormat(dst, dstSize, "%ld", val); }
+void UTIL1_strcatNum16u(uint8_t *dst, size_t dstSize, uint16_t val)  { CatFormat(dst, dstSize, "%ld", val); }
+void UTIL1_strcatNum16s(uint8_t *dst, size_t dstSize, int16_t val)   { CatFormat(dst, dstSize, "%ld", val); }
+void UTIL1_strcatNum32u(uint8_t *dst, size_t dstSize, uint32_t val)  { CatFormat(dst, dstSize, "%ld", (long)val); }
+void UTIL1_strcatNum32s(uint8_t *dst, size_t dstSize, int32_t val)   { CatFormat(dst, dstSize, "%ld", val); }
+
+void UTIL1_strcatNum16uFormatted(uint8_t *dst, size_t dstSize, uint16_t val, char fill, uint8_t nofFill) {
+  char buf[24];
+  size_t len;
+
+  (void)snprintf(buf, sizeof(buf), "%u", val);
+  for(len=strlen(buf); len<nofFill; len++) {
+    UTIL1_chcat(dst, dstSize, (uint8_t)fill);
+  }
+  UTIL1_strcat(dst, dstSize, (unsigned char*)buf);
+}
+void UTIL1_strcatNum8Hex(uint8_t *dst, size_t dstSize, uint8_t val)  { CatFormat(dst, dstSize, "%02lX", val); }
+void UTIL1_strcatNum16Hex(uint8_t *dst, size_t dstSize, uint16_t val) { CatFormat(dst, dstSize, "%04lX", val); }
+void UTIL1_strcatNum32Hex(uint8_t *dst, size_t dstSize, uint32_t val) { CatFormat(dst, dstSize, "%08lX", (long)val); }
+
+/* scans an optionally signed decimal number, skipping leading spaces */
+static uint8_t ScanDecimal(const unsigned char **str, bool allowSign, long minVal, long maxVal, long *val) {
+  const unsigned char *p = *str;
+  bool neg = FALSE;
+  long v = 0;
+  int nofDigits = 0;
+
+  while (*p==' ') {
+    p++;
+  }
+  if (allowSign && (*p=='-' || *p=='+')) {
+    neg = *p=='-';
+    p++;
+  }
+  while (*p>='0' && *p<='9') {
+    v = v*10+(*p-'0');
+    if (v>maxVal+1) {
+      return ERR_OVERFLOW;
+    }
+    p++;
+    nofDigits++;
+  }
+  if (nofDigits==0) {
+    return ERR_FAILED;
+  }
+  if (neg) {
+    v = -v;
+  }
+  if (v<minVal || v>maxVal) {
+    return ERR_OVERFLOW;
+  }
+  *val = v;
+  *str = p;
+  return ERR_OK;
+}
+
+uint8_t UTIL1_ScanDecimal8uNumber(const unsigned char **str, uint8_t *val) {
+  long v;
+  uint8_t res = ScanDecimal(str, FALSE, 0, 0xff, &v);
+
+  if (res==ERR_OK) {
+    *val = (uint8_t)v;
+  }
+  return res;
+}
+
+uint8_t UTIL1_ScanDecimal16uNumber(const unsigned char **str, uint16_t *val) {
+  long v;
+  uint8_t res = ScanDecimal(str, FALSE, 0, 0xffff, &v);
+
+  if (res==ERR_OK) {
+    *val = (uint16_t)v;
+  }
+  return res;
+}
+
+uint8_t UTIL1_ScanDecimal32uNumber(const unsigned char **str, uint32_t *val) {
+  long v;
+  uint8_t res = ScanDecimal(str, FALSE, 0, 0xffffffffL, &v);
+
+  if (res==ERR_OK) {
+    *val = (uint32_t)v;
+  }
+  return res;
+}
+
+uint8_t UTIL1_ScanDecimal8sNumber(const unsigned char **str, int8_t *val) {
+  long v;
+  uint8_t res = ScanDecimal(str, TRUE, -128, 127, &v);
+
+  if (res==ERR_OK) {
+    *val = (int8_t)v;
+  }
+  return res;
+}
+
+uint8_t UTIL1_ScanDecimal16sNumber(const unsigned char **str, int16_t *val) {
+  long v;
+  uint8_t res = ScanDecimal(str, TRUE, -32768, 32767, &v);
+
+  if (res==ERR_OK) {
+    *val = (int16_t)v;
+  }
+  return res;
+}
+
+uint8_t UTIL1_ScanDecimal32sNumber(const unsigned char **str, int32_t *val) {
+  long v;
+  uint8_t res = ScanDecimal(str, TRUE, -2147483647L-1, 2147483647L, &v);
+
+  if (res==ERR_OK) {
+    *val = (int32_t)v;
+  }
+  return res;
+}
+
+uint8_t UTIL1_xatoi(const unsigned char **str, int32_t *res) {
+  const unsigned char *p = *str;
+  unsigned long val = 0;
+  unsigned base = 10, digit;
+  bool neg = FALSE;
+  int nofDigits = 0;
+
+  while (*p==' ') {
+    p++;
+  }
+  if (*p=='-') {
+    neg = TRUE;
+    p++;
+  }
+  if (p[0]=='0' && (p[1]=='x' || p[1]=='X')) {
+    base = 16;
+    p += 2;
+  } else if (p[0]=='0' && (p[1]=='b' || p[1]=='B')) {
+    base = 2;
+    p += 2;
+  }
+  for(;;) {
+    if (*p>='0' && *p<='9') {
+      digit = *p-'0';
+    } else if (*p>='a' && *p<='f') {
+      digit = *p-'a'+10;
+    } else if (*p>='A' && *p<='F') {
+      digit = *p-'A'+10;
+    } else {
+      break;
+    }
+    if (digit>=base) {
+      return ERR_FAILED;
+    }
+    val = val*base+digit;
+    p++;
+    nofDigits++;
+  }
+  if (nofDigits==0 || (*p!='\0' && *p!=' ')) {
+    return ERR_FAILED;
+  }
+  *res = neg ? -(int32_t)val : (int32_t)val;
+  *str = p;
+  return ERR_OK;
+}
+
+/* ------------------------------------- CLS1 ------------------------------------- */
+void CLS1_SendCh(uint8_t ch, CLS1_StdIO_OutErr_FctType io) {
+  if (io!=NULL) {
+    io(ch);
+  }
+}
+
+void CLS1_SendStr(const uint8_t *str, CLS1_StdIO_OutErr_FctType io) {
+  while (*str!='\0') {
+    CLS1_SendCh(*str++, io);
+  }
+}
+
+static void SendPadded(const uint8_t *str, size_t column, CLS1_StdIO_OutErr_FctType io) {
+  size_t len = strlen((const char*)str);
+
+  CLS1_SendStr(str, io);
+  while (len<column) {
+    CLS1_SendCh(' ', io);
+    len++;
+  }
+}
+
+void CLS1_SendHelpStr(const uint8_t *strCmd, const uint8_t *strHelp, CLS1_StdIO_OutErr_FctType io) {
+  SendPadded(strCmd, CLS1_HELP_SEMICOLON_POS, io);
+  CLS1_SendStr((const uint8_t*)"; ", io);
+  CLS1_SendStr(strHelp, io);
+}
+
+void CLS1_SendStatusStr(const uint8_t *strItem, const uint8_t *strStatus, CLS1_StdIO_OutErr_FctType io) {
+  SendPadded(strItem, CLS1_STATUS_SEMICOLON_POS, io);
+  CLS1_SendStr((const uint8_t*)": ", io);
+  CLS1_SendStr(strStatus, io);
+}
+
+static void SendNum(long val, CLS1_StdIO_OutErr_FctType io) {
+  char buf[24];
+
+  (void)snprintf(buf, sizeof(buf), "%ld", val);
+  CLS1_SendStr((uint8_t*)buf, io);
+}
+
+void CLS1_SendNum8u(uint8_t val, CLS1_StdIO_OutErr_FctType io)   { SendNum(val, io); }
+void CLS1_SendNum16u(uint16_t val, CLS1_StdIO_OutErr_FctType io) { SendNum(val, io); }
+void CLS1_SendNum16s(int16_t val, CLS1_StdIO_OutErr_FctType io)  { SendNum(val, io); }
+void CLS1_SendNum32u(uint32_t val, CLS1_StdIO_OutErr_FctType io) { SendNum((long)val, io); }
+void CLS1_SendNum32s(int32_t val, CLS1_StdIO_OutErr_FctType io)  { SendNum(val, io); }
+
+uint8_t CLS1_IterateTable(const uint8_t *cmd, bool *handled, CLS1_ConstStdIOType *io, const CLS1_ParseCommandCallback *parserTable) {
+  uint8_t res = ERR_OK;
+
+  while (*parserTable!=NULL) {
+    if ((*parserTable)(cmd, handled, io)!=ERR_OK) {
+      res = ERR_FAILED;
+    }
+    if (*handled && UTIL1_strcmp((const char*)cmd, CLS1_CMD_HELP)!=0 && UTIL1_strcmp((const char*)cmd, CLS1_CMD_STATUS)!=0) {
+      break; /* help and status go to all parsers, the other commands only to the first one handling it */
+    }
+    parserTable++;
+  }
+  return res;
+}
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the TofCE1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef TOFCE1_H_
+#define TOFCE1_H_
+
+#include "SimHw.h"
+
+#endif /* TOFCE1_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the TofCE2 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef TOFCE2_H_
+#define TOFCE2_H_
+
+#include "SimHw.h"
+
+#endif /* TOFCE2_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the TofCE3 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef TOFCE3_H_
+#define TOFCE3_H_
+
+#include "SimHw.h"
+
+#endif /* TOFCE3_H_ */
@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the TofCE4 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef TOFCE4_H_
+#define TOFCE4_H_
+
+#include "SimHw.h"
+
+#endif /* TOFCE4_H_ */
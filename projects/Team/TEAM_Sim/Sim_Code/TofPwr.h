@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host emulation of the TofPwr component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef TOFPWR_H_
+#define TOFPWR_H_
+
+#include "SimHw.h"
+
+#endif /* TOFPWR_H_ */
@@ -0,0 +1,44 @@
+/**
+ * \file
+ * \brief Host replacement of the utility component (subset used by the robot modules).
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef UTIL1_H_
+#define UTIL1_H_
+
+#include "PE_Types.h"
+
+int16_t UTIL1_strcmp(const char *str1, const char *str2);
+int16_t UTIL1_strncmp(const char *str1, const char *str2, size_t size);
+void UTIL1_strcpy(uint8_t *dst, size_t dstSize, const unsigned char *src);
+void UTIL1_strcat(uint8_t *dst, size_t dstSize, const unsigned char *src);
+void UTIL1_chcat(uint8_t *dst, size_t dstSize, uint8_t ch);
+
+void UTIL1_Num8uToStr(uint8_t *dst, size_t dstSize, uint8_t val);
+void UTIL1_Num16uToStr(uint8_t *dst, size_t dstSize, uint16_t val);
+void UTIL1_Num16sToStr(uint8_t *dst, size_t dstSize, int16_t val);
+void UTIL1_Num32uToStr(uint8_t *dst, size_t dstSize, uint32_t val);
+void UTIL1_Num32sToStr(uint8_t *dst, size_t dstSize, int32_t val);
+void UTIL1_Num16sToStrFormatted(uint8_t *dst, size_t dstSize, int16_t val, char fill, uint8_t nofFill);
+
+void UTIL1_strcatNum8u(uint8_t *dst, size_t dstSize, uint8_t val);
+void UTIL1_strcatNum8s(uint8_t *dst, size_t dstSize, int8_t val);
+void UTIL1_strcatNum16u(uint8_t *dst, size_t dstSize, uint16_t val);
+void UTIL1_strcatNum16s(uint8_t *dst, size_t dstSize, int16_t val);
+void UTIL1_strcatNum32u(uint8_t *dst, size_t dstSize, uint32_t val);
+void UTIL1_strcatNum32s(uint8_t *dst, size_t dstSize, int32_t val);
+void UTIL1_strcatNum16uFormatted(uint8_t *dst, size_t dstSize, uint16_t val, char fill, uint8_t nofFill);
+void UTIL1_strcatNum8Hex(uint8_t *dst, size_t dstSize, uint8_t val);
+void UTIL1_strcatNum16Hex(uint8_t *dst, size_t dstSize, uint16_t val);
+void UTIL1_strcatNum32Hex(uint8_t *dst, size_t dstSize, uint32_t val);
+
+uint8_t UTIL1_ScanDecimal8uNumber(const unsigned char **str, uint8_t *val);
+uint8_t UTIL1_ScanDecimal16uNumber(const unsigned char **str, uint16_t *val);
+uint8_t UTIL1_ScanDecimal32uNumber(const unsigned char **str, uint32_t *val);
+uint8_t UTIL1_ScanDecimal8sNumber(const unsigned char **str, int8_t *val);
+uint8_t UTIL1_ScanDecimal16sNumber(const unsigned char **str, int16_t *val);
+uint8_t UTIL1_ScanDecimal32sNumber(const unsigned char **str, int32_t *val);
+uint8_t UTIL1_xatoi(const unsigned char **str, int32_t *res);
+
+#endif /* UTIL1_H_ */
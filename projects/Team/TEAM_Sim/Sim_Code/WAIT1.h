@@ -0,0 +1,13 @@
+/**
+ * \file
+ * \brief Host emulation of the WAIT1 component, see SimHw.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef WAIT1_H_
+#define WAIT1_H_
+
+#include "SimHw.h"
+#include "FRTOS1.h" /* as the component: WAIT1_WaitOSms() uses the RTOS */
+
+#endif /* WAIT1_H_ */
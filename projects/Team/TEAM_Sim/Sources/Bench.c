@@ -0,0 +1,52 @@
+/**
+ * \file
+ * \brief Host benchmarks and stress tests of single modules, see Bench.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#include "Platform.h"
+#include "Bench.h"
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  const char *name;
+  uint8_t (*run)(FILE *out);
+  const char *descr;
+} BENCH_Desc;
+
+static const BENCH_Desc BENCH_List[] = {
+#if PL_CONFIG_HAS_MEM_POOL
+  {"mpool", BENCH_MemPool, "memory pools against heap_4: failures, fragmentation, allocation time"},
+#endif
+#if PL_CONFIG_HAS_TIME_SYNC
+  {"tsync", BENCH_TimeSync, "clock synchronisation of two nodes with drifting clocks and a lossy link"},
+#endif
+#if PL_CONFIG_HAS_LCD_MENU
+  {"lcd",   BENCH_Lcd, "LCD menu and status screens: full redraw against dirty rectangles, bytes per frame and fps"},
+#endif
+};
+
+uint64_t BENCH_NowNs(void) {
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec*1000000000ULL+(uint64_t)ts.tv_nsec;
+}
+
+uint8_t BENCH_Run(const char *name, FILE *out) {
+  size_t i;
+
+  for(i=0;i<sizeof(BENCH_List)/sizeof(BENCH_List[0]);i++) {
+    if (strcmp(name, BENCH_List[i].name)==0) {
+      return BENCH_List[i].run(out);
+    }
+  }
+  if (strcmp(name, "list")!=0) {
+    (void)fprintf(out, "unknown benchmark '%s'\n", name);
+  }
+  for(i=0;i<sizeof(BENCH_List)/sizeof(BENCH_List[0]);i++) {
+    (void)fprintf(out, "  %-8s %s\n", BENCH_List[i].name, BENCH_List[i].descr);
+  }
+  return strcmp(name, "list")==0 ? ERR_OK : ERR_NOTAVAIL;
+}
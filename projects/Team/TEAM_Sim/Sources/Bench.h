@@ -0,0 +1,48 @@
+/**
+ * \file
+ * \brief Interface of the host benchmarks and stress tests of single modules.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Some modules of TEAM_Common are measured on the host without the world model: 'sim -b <name>'
+ * runs one of them, prints the results and exits with EXIT_FAILURE if a check has failed.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include "PE_Types.h"
+#include <stdio.h>
+
+/*!
+ * \brief Stress test of the memory pools (MemPool.c) against the heap_4 allocation scheme of FreeRTOS.
+ * \param out Where the results are printed.
+ * \return ERR_OK, ERR_FAILED if a block has been corrupted or a pool operation failed unexpectedly.
+ */
+uint8_t BENCH_MemPool(FILE *out);
+
+/*!
+ * \brief Test of the clock synchronisation estimator (TimeSync.c) with two drifting clocks and a lossy link.
+ * \param out Where the results are printed.
+ * \return ERR_OK, ERR_FAILED if the error of the shared time has exceeded its bound or the limit.
+ */
+uint8_t BENCH_TimeSync(FILE *out);
+
+/*!
+ * \brief Comparison of the full redraw with the dirty rectangles of LCDDirty.c, for the LCD menu and a status screen.
+ * \param out Where the results are printed.
+ * \return ERR_OK, ERR_FAILED if the display has not shown the drawn content or the dirty rectangles transferred more.
+ */
+uint8_t BENCH_Lcd(FILE *out);
+
+/*! \brief Returns a monotonic host time in nanoseconds, for the timing of the benchmarks */
+uint64_t BENCH_NowNs(void);
+
+/*!
+ * \brief Runs a benchmark.
+ * \param name Name of the benchmark, 'list' prints the available ones.
+ * \param out Where the results are printed.
+ * \return ERR_OK, ERR_FAILED if a check has failed, ERR_NOTAVAIL if there is no such benchmark.
+ */
+uint8_t BENCH_Run(const char *name, FILE *out);
+
+#endif /* BENCH_H_ */
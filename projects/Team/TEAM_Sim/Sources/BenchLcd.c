@@ -0,0 +1,304 @@
+/**
+ * \file
+ * \brief Comparison of the full LCD redraw with the dirty rectangles, see Bench.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * LCDMenu.c and LCDDirty.c run unchanged on the display of SimLcd.h, with a menu table like the one of LCD.c.
+ * Two screens are measured:
+ *   menu:   a fixed sequence of key presses, navigating through all groups, scrolling and editing values,
+ *   status: the live values of the robot (battery, ToF, link loss and round trip time) refreshed every
+ *           second, as the LCD task does, with values changing like on the remote.
+ * For the full redraw the view is invalidated before each event, so every draw clears and repaints the
+ * display and transfers the whole frame buffer, as before the dirty rectangles. After each event the
+ * controller RAM has to match the frame buffer.
+ * The frame rate is limited by the serial transfer to the display: fps is the rate the transfers of an
+ * average frame allow at LCD_BENCH_SPI_HZ. The draw time is the time on the host, for comparison only.
+ */
+
+#include "Platform.h"
+#include "Bench.h"
+#if PL_CONFIG_HAS_LCD_MENU
+#include "LCDMenu.h"
+#include "LCDDirty.h"
+#include "SimLcd.h"
+#include <string.h>
+
+#define LCD_BENCH_SPI_HZ        4000000 /* maximum serial clock of the PCD8544 */
+#define LCD_BENCH_MENU_ROUNDS   100     /* repetitions of the key sequence */
+#define LCD_BENCH_STATUS_S      600     /* simulated time of the status screen, one refresh per second */
+
+typedef enum {
+  LCD_BENCH_ID_NONE = LCDMENU_ID_NONE,
+  LCD_BENCH_ID_GENERAL,
+  LCD_BENCH_ID_BACKLIGHT,
+  LCD_BENCH_ID_VALUE,
+  LCD_BENCH_ID_ROBOT,
+  LCD_BENCH_ID_PID,
+  LCD_BENCH_ID_P,
+  LCD_BENCH_ID_I,
+  LCD_BENCH_ID_D,
+  LCD_BENCH_ID_W,
+  LCD_BENCH_ID_START_STOP,
+  LCD_BENCH_ID_LAPS,
+  LCD_BENCH_ID_LAP_LAST,
+  LCD_BENCH_ID_LAP_BEST,
+  LCD_BENCH_ID_STATUS,
+  LCD_BENCH_ID_BATT,
+  LCD_BENCH_ID_TOF,
+  LCD_BENCH_ID_LOSS,
+  LCD_BENCH_ID_RTT,
+  LCD_BENCH_ID_CHANNEL,
+  LCD_BENCH_ID_NOF
+} LCD_BenchId;
+
+static struct {
+  bool backlight;
+  int values[LCD_BENCH_ID_NOF]; /* editable values */
+  uint16_t battCv;
+  uint8_t tofMm[4];
+  uint8_t lossPercent;
+  uint16_t rttMs;
+  uint8_t laps;
+  uint32_t lastMs, bestMs;
+  uint8_t texts[LCD_BENCH_ID_NOF][24]; /* texts of the items, valid until the next GET_TEXT */
+  uint32_t seed;
+} LCD_Bench;
+
+static uint32_t LCD_BenchRand(uint32_t range) {
+  LCD_Bench.seed = LCD_Bench.seed*1664525UL+1013904223UL;
+  return (LCD_Bench.seed>>8)%range;
+}
+
+static LCDMenu_StatusFlags LCD_BenchValueHandler(const struct LCDMenu_MenuItem_ *item, LCDMenu_EventType event, void **dataP) {
+  static const char *const names[LCD_BENCH_ID_NOF] = {
+    [LCD_BENCH_ID_VALUE]="Val", [LCD_BENCH_ID_P]="P", [LCD_BENCH_ID_I]="I", [LCD_BENCH_ID_D]="D", [LCD_BENCH_ID_W]="W"
+  };
+  uint8_t *buf = LCD_Bench.texts[item->id];
+  int *value = &LCD_Bench.values[item->id];
+
+  if (event==LCDMENU_EVENT_GET_TEXT && dataP!=NULL) {
+    (void)snprintf((char*)buf, sizeof(LCD_Bench.texts[0]), "%s: %d", names[item->id], *value);
+    *dataP = buf;
+  } else if (event==LCDMENU_EVENT_GET_EDIT_TEXT && dataP!=NULL) {
+    (void)snprintf((char*)buf, sizeof(LCD_Bench.texts[0]), "[-] %d [+]", *value);
+    *dataP = buf;
+  } else if (event==LCDMENU_EVENT_INCREMENT) {
+    (*value)++;
+  } else if (event==LCDMENU_EVENT_DECREMENT) {
+    (*value)--;
+  } else {
+    return LCDMENU_STATUS_FLAGS_NONE;
+  }
+  return LCDMENU_STATUS_FLAGS_HANDLED|LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
+}
+
+static LCDMenu_StatusFlags LCD_BenchBacklightHandler(const struct LCDMenu_MenuItem_ *item, LCDMenu_EventType event, void **dataP) {
+  (void)item;
+  if (event==LCDMENU_EVENT_GET_TEXT && dataP!=NULL) {
+    *dataP = LCD_Bench.backlight ? "Backlight is ON" : "Backlight is OFF";
+  } else if (event==LCDMENU_EVENT_ENTER) {
+    LCD_Bench.backlight = !LCD_Bench.backlight;
+  } else {
+    return LCDMENU_STATUS_FLAGS_NONE;
+  }
+  return LCDMENU_STATUS_FLAGS_HANDLED|LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
+}
+
+/* texts of the live items, in the formats of LCD.c, RadioLink.c and LapTime.c */
+static LCDMenu_StatusFlags LCD_BenchLiveHandler(const struct LCDMenu_MenuItem_ *item, LCDMenu_EventType event, void **dataP) {
+  char *buf = (char*)LCD_Bench.texts[item->id];
+  size_t size = sizeof(LCD_Bench.texts[0]);
+
+  if (event==LCDMENU_EVENT_REFRESH) {
+    return LCDMENU_STATUS_FLAGS_HANDLED; /* the model has updated the values */
+  }
+  if (event!=LCDMENU_EVENT_GET_TEXT || dataP==NULL) {
+    return LCDMENU_STATUS_FLAGS_NONE;
+  }
+  switch(item->id) {
+    case LCD_BENCH_ID_START_STOP: (void)snprintf(buf, size, "Start/Stop"); break;
+    case LCD_BENCH_ID_BATT:       (void)snprintf(buf, size, "Batt: %u.%02uV", LCD_Bench.battCv/100U, LCD_Bench.battCv%100U); break;
+    case LCD_BENCH_ID_TOF:        (void)snprintf(buf, size, "D:%02X:%02X:%02X:%02X", LCD_Bench.tofMm[0], LCD_Bench.tofMm[1], LCD_Bench.tofMm[2], LCD_Bench.tofMm[3]); break;
+    case LCD_BENCH_ID_LOSS:       (void)snprintf(buf, size, "Loss:%u%% %s", LCD_Bench.lossPercent, LCD_Bench.lossPercent<5 ? "good" : "fair"); break;
+    case LCD_BENCH_ID_RTT:        (void)snprintf(buf, size, "RTT:%ums R0.%02u", LCD_Bench.rttMs, LCD_Bench.lossPercent); break;
+    case LCD_BENCH_ID_LAP_LAST:   (void)snprintf(buf, size, "L%u %u.%03u", LCD_Bench.laps, LCD_Bench.lastMs/1000U, LCD_Bench.lastMs%1000U); break;
+    case LCD_BENCH_ID_LAP_BEST:   (void)snprintf(buf, size, "B%u.%03u", LCD_Bench.bestMs/1000U, LCD_Bench.bestMs%1000U); break;
+    default: buf[0] = '\0'; break;
+  }
+  *dataP = buf;
+  return LCDMENU_STATUS_FLAGS_HANDLED|LCDMENU_STATUS_FLAGS_UPDATE_VIEW;
+}
+
+static const LCDMenu_MenuItem LCD_BenchMenus[] =
+{/* id,                      grp, pos, up,                    down,                  text,      callback,                  flags */
+  {LCD_BENCH_ID_GENERAL,       0,   0, LCD_BENCH_ID_NONE,     LCD_BENCH_ID_BACKLIGHT,  "General", NULL,                      LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_BACKLIGHT,     1,   0, LCD_BENCH_ID_GENERAL,  LCD_BENCH_ID_NONE,       NULL,      LCD_BenchBacklightHandler, LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_VALUE,         1,   1, LCD_BENCH_ID_GENERAL,  LCD_BENCH_ID_NONE,       NULL,      LCD_BenchValueHandler,     LCDMENU_MENU_FLAGS_EDITABLE},
+  {LCD_BENCH_ID_ROBOT,         0,   1, LCD_BENCH_ID_NONE,     LCD_BENCH_ID_PID,        "Robot",   NULL,                      LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_PID,           2,   0, LCD_BENCH_ID_ROBOT,    LCD_BENCH_ID_P,          "PID",     NULL,                      LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_START_STOP,    2,   1, LCD_BENCH_ID_ROBOT,    LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_P,             3,   0, LCD_BENCH_ID_PID,      LCD_BENCH_ID_NONE,       NULL,      LCD_BenchValueHandler,     LCDMENU_MENU_FLAGS_EDITABLE},
+  {LCD_BENCH_ID_I,             3,   1, LCD_BENCH_ID_PID,      LCD_BENCH_ID_NONE,       NULL,      LCD_BenchValueHandler,     LCDMENU_MENU_FLAGS_EDITABLE},
+  {LCD_BENCH_ID_D,             3,   2, LCD_BENCH_ID_PID,      LCD_BENCH_ID_NONE,       NULL,      LCD_BenchValueHandler,     LCDMENU_MENU_FLAGS_EDITABLE},
+  {LCD_BENCH_ID_W,             3,   3, LCD_BENCH_ID_PID,      LCD_BENCH_ID_NONE,       NULL,      LCD_BenchValueHandler,     LCDMENU_MENU_FLAGS_EDITABLE},
+  {LCD_BENCH_ID_LAPS,          0,   2, LCD_BENCH_ID_NONE,     LCD_BENCH_ID_LAP_LAST,   "Laps",    NULL,                      LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_LAP_LAST,      4,   0, LCD_BENCH_ID_LAPS,     LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_LIVE},
+  {LCD_BENCH_ID_LAP_BEST,      4,   1, LCD_BENCH_ID_LAPS,     LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_LIVE},
+  {LCD_BENCH_ID_STATUS,        0,   3, LCD_BENCH_ID_NONE,     LCD_BENCH_ID_BATT,       "Status",  NULL,                      LCDMENU_MENU_FLAGS_NONE},
+  {LCD_BENCH_ID_BATT,          5,   0, LCD_BENCH_ID_STATUS,   LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_LIVE},
+  {LCD_BENCH_ID_TOF,           5,   1, LCD_BENCH_ID_STATUS,   LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_LIVE},
+  {LCD_BENCH_ID_LOSS,          5,   2, LCD_BENCH_ID_STATUS,   LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_LIVE},
+  {LCD_BENCH_ID_RTT,           5,   3, LCD_BENCH_ID_STATUS,   LCD_BENCH_ID_NONE,       NULL,      LCD_BenchLiveHandler,      LCDMENU_MENU_FLAGS_LIVE},
+  {LCD_BENCH_ID_CHANNEL,       5,   4, LCD_BENCH_ID_STATUS,   LCD_BENCH_ID_NONE,       "Channel 5", NULL,                    LCDMENU_MENU_FLAGS_NONE}, /* fifth line: scroll bar */
+};
+
+/* navigation through all groups: scrolling, toggling, editing values */
+static const LCDMenu_EventType LCD_BenchKeys[] = {
+  LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP,
+  LCDMENU_EVENT_RIGHT, LCDMENU_EVENT_ENTER, LCDMENU_EVENT_ENTER, LCDMENU_EVENT_DOWN,              /* General: backlight */
+  LCDMENU_EVENT_ENTER, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_ENTER, /* edit value */
+  LCDMENU_EVENT_LEFT, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_RIGHT, LCDMENU_EVENT_RIGHT,                /* Robot, PID */
+  LCDMENU_EVENT_DOWN, LCDMENU_EVENT_ENTER, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_ENTER, /* edit I */
+  LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP,
+  LCDMENU_EVENT_LEFT, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_UP, LCDMENU_EVENT_LEFT,
+  LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_RIGHT, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_UP, LCDMENU_EVENT_LEFT, /* Laps */
+  LCDMENU_EVENT_DOWN, LCDMENU_EVENT_RIGHT, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, LCDMENU_EVENT_DOWN, /* Status, scrolling */
+  LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_LEFT,
+  LCDMENU_EVENT_UP, LCDMENU_EVENT_UP, LCDMENU_EVENT_UP,
+};
+
+typedef struct {
+  uint32_t nofEvents;  /* key presses or refreshes */
+  uint32_t nofFrames;  /* events which have transferred data */
+  uint32_t nofBytes;   /* data and command bytes */
+  uint64_t drawNs;     /* host time of the events */
+  bool upToDate;       /* display has shown the frame buffer after every event */
+} LCD_BenchResult;
+
+static void LCD_BenchInit(void) {
+  memset(&LCD_Bench, 0, sizeof(LCD_Bench));
+  LCD_Bench.backlight = TRUE;
+  LCD_Bench.battCv = 784;
+  LCD_Bench.tofMm[0] = 0x40;
+  LCD_Bench.tofMm[1] = 0x80;
+  LCD_Bench.rttMs = 12;
+  LCD_Bench.bestMs = 9876;
+  LCD_Bench.seed = 1;
+  SIMLCD_Reset();
+  LCDDIRTY_Init();
+  LCDMenu_Init();
+  (void)LCDMenu_InitMenu(LCD_BenchMenus, sizeof(LCD_BenchMenus)/sizeof(LCD_BenchMenus[0]), LCD_BENCH_ID_GENERAL);
+  LCDMenu_OnEvent(LCDMENU_EVENT_DRAW, NULL);
+}
+
+/* one key press or refresh: full redraw or dirty rectangles */
+static void LCD_BenchEvent(LCD_BenchResult *res, bool full, LCDMenu_EventType event) {
+  SIMLCD_Transfers before, after;
+  uint64_t t;
+
+  SIMLCD_GetTransfers(&before);
+  t = BENCH_NowNs();
+  if (full) {
+    LCDMenu_InvalidateView();
+  }
+  if (event==LCDMENU_EVENT_REFRESH) {
+    (void)LCDMenu_Refresh();
+  } else {
+    LCDMenu_OnEvent(event, NULL);
+  }
+  res->drawNs += BENCH_NowNs()-t;
+  SIMLCD_GetTransfers(&after);
+  res->nofEvents++;
+  if (after.nofBytes!=before.nofBytes) {
+    res->nofFrames++;
+    res->nofBytes += (after.nofBytes+after.nofCmdBytes)-(before.nofBytes+before.nofCmdBytes);
+  }
+  if (!SIMLCD_IsDisplayUpToDate()) {
+    res->upToDate = FALSE;
+  }
+}
+
+static void LCD_BenchMenu(LCD_BenchResult *res, bool full) {
+  size_t i;
+  int r;
+
+  LCD_BenchInit();
+  for(r=0;r<LCD_BENCH_MENU_ROUNDS;r++) {
+    for(i=0;i<sizeof(LCD_BenchKeys)/sizeof(LCD_BenchKeys[0]);i++) {
+      LCD_BenchEvent(res, full, LCD_BenchKeys[i]);
+    }
+  }
+}
+
+static void LCD_BenchStatus(LCD_BenchResult *res, bool full) {
+  LCD_BenchResult nav;
+  int s, i;
+
+  LCD_BenchInit();
+  memset(&nav, 0, sizeof(nav));
+  nav.upToDate = TRUE;
+  for(i=0;i<3;i++) { /* to the status group, not measured */
+    LCD_BenchEvent(&nav, FALSE, LCDMENU_EVENT_DOWN);
+  }
+  LCD_BenchEvent(&nav, FALSE, LCDMENU_EVENT_RIGHT);
+  for(s=0;s<LCD_BENCH_STATUS_S;s++) {
+    /* the robot values of the last second */
+    if (s%20==0) {
+      LCD_Bench.battCv--; /* discharging */
+    }
+    for(i=0;i<4;i++) { /* ToF ranges change while the robot moves */
+      if (LCD_BenchRand(2)==0) {
+        LCD_Bench.tofMm[i] = (uint8_t)LCD_BenchRand(256);
+      }
+    }
+    if (s%10==0) {
+      LCD_Bench.lossPercent = (uint8_t)LCD_BenchRand(8);
+    }
+    LCD_Bench.rttMs = (uint16_t)(8+LCD_BenchRand(12));
+    LCD_BenchEvent(res, full, LCDMENU_EVENT_REFRESH);
+  }
+  res->upToDate = res->upToDate && nav.upToDate;
+}
+
+static void LCD_BenchPrint(FILE *out, const char *screen, const char *mode, const LCD_BenchResult *res, const LCD_BenchResult *full) {
+  double bytesPerFrame = res->nofFrames>0 ? (double)res->nofBytes/res->nofFrames : 0.0;
+  double bytesPerEvent = res->nofEvents>0 ? (double)res->nofBytes/res->nofEvents : 0.0;
+
+  (void)fprintf(out, "%-7s %-6s %7u %7u %8.1f %8.1f %7.2f %7.0f %8.0f %7.1f%% %s\n",
+      screen, mode, (unsigned)res->nofEvents, (unsigned)res->nofFrames, bytesPerFrame, bytesPerEvent,
+      bytesPerFrame*8*1000.0/LCD_BENCH_SPI_HZ, bytesPerFrame>0 ? LCD_BENCH_SPI_HZ/(bytesPerFrame*8) : 0.0,
+      res->nofEvents>0 ? (double)res->drawNs/res->nofEvents : 0.0,
+      full->nofBytes>0 ? 100.0*res->nofBytes/full->nofBytes : 0.0, res->upToDate ? "ok" : "STALE");
+}
+
+uint8_t BENCH_Lcd(FILE *out) {
+  static const char *const screens[] = {"menu", "status"};
+  LCD_BenchResult full, dirty;
+  uint8_t res = ERR_OK;
+  int i;
+
+  (void)fprintf(out, "84x48 display, %u.%u MHz SPI, %u rounds of %u keys, %u s of status refreshes\n\n",
+      (unsigned)(LCD_BENCH_SPI_HZ/1000000), (unsigned)(LCD_BENCH_SPI_HZ%1000000/100000), (unsigned)LCD_BENCH_MENU_ROUNDS,
+      (unsigned)(sizeof(LCD_BenchKeys)/sizeof(LCD_BenchKeys[0])), (unsigned)LCD_BENCH_STATUS_S);
+  (void)fprintf(out, "screen  mode    events  frames  B/frame  B/event  ms/frm     fps  draw ns   bytes  display\n");
+  for(i=0;i<2;i++) {
+    memset(&full, 0, sizeof(full));
+    memset(&dirty, 0, sizeof(dirty));
+    full.upToDate = dirty.upToDate = TRUE;
+    if (i==0) {
+      LCD_BenchMenu(&full, TRUE);
+      LCD_BenchMenu(&dirty, FALSE);
+    } else {
+      LCD_BenchStatus(&full, TRUE);
+      LCD_BenchStatus(&dirty, FALSE);
+    }
+    LCD_BenchPrint(out, screens[i], "full", &full, &full);
+    LCD_BenchPrint(out, screens[i], "dirty", &dirty, &full);
+    if (!full.upToDate || !dirty.upToDate || dirty.nofBytes>full.nofBytes) {
+      res = ERR_FAILED;
+    }
+  }
+  (void)fprintf(out, "%s\n", res==ERR_OK ? "passed" : "FAILED");
+  return res;
+}
+#endif /* PL_CONFIG_HAS_LCD_MENU */
@@ -0,0 +1,331 @@
+/**
+ * \file
+ * \brief Stress test of the memory pools against the heap_4 allocation scheme, see Bench.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The FreeRTOS sources are generated by Processor Expert and are not part of the host build, so
+ * heap_4 is modelled here: first fit in a free list sorted by address, splitting of larger blocks,
+ * merging of neighbouring free blocks on free, 8 byte alignment and the 8 byte block header of the
+ * Cortex-M4 (offsets instead of pointers, to have the header size of the target).
+ * Both allocators get the same sequence of shell message sizes (1..96 bytes, see ShellQueue.c) and
+ * the same RAM, the messages are freed in random order. A second run fills the heap of the robot
+ * with small blocks and frees every other one, the worst case for the first fit search.
+ */
+
+#include "Platform.h"
+#include "Bench.h"
+#if PL_CONFIG_HAS_MEM_POOL
+#include "MemPool.h"
+#include <string.h>
+
+#define BENCH_MP_STEPS        1000000 /* random allocations and frees */
+#define BENCH_MP_MAX_MSGS     16      /* messages allocated at the same time, at most */
+#define BENCH_MP_POOL_RAM     960     /* RAM of the pools in MemPool.c, the heap gets the same */
+#define BENCH_MP_ROBOT_HEAP   16000   /* configTOTAL_HEAP_SIZE of the robot */
+#define BENCH_MP_REPEAT       1000    /* repetitions of the worst case request, for a measurable time */
+#define BENCH_MP_HIST_NS      4096    /* range of the histogram of the allocation times: the maximum on the host is a preemption */
+
+#define BENCH_HEAP_ALIGN      8
+#define BENCH_HEAP_HDR        8       /* BlockLink_t of the target: next pointer and size */
+#define BENCH_HEAP_MIN_BLOCK  (2*BENCH_HEAP_HDR) /* heapMINIMUM_BLOCK_SIZE */
+#define BENCH_HEAP_NONE       0xffffffffUL
+
+typedef struct {
+  uint32_t next; /* offset of the next free block, BENCH_HEAP_NONE at the end of the list */
+  uint32_t size; /* size of the block including the header */
+} BENCH_HeapLink;
+
+static uint64_t BENCH_HeapMem[BENCH_MP_ROBOT_HEAP/sizeof(uint64_t)];
+static uint32_t BENCH_HeapFirst; /* first free block */
+static uint32_t BENCH_HeapFree;  /* free bytes, including the headers of the free blocks */
+
+static BENCH_HeapLink *BENCH_HeapBlock(uint32_t ofs) {
+  return (BENCH_HeapLink*)((uint8_t*)BENCH_HeapMem+ofs);
+}
+
+static void BENCH_HeapInit(uint32_t size) {
+  size -= BENCH_HEAP_HDR; /* pxEnd at the end of the heap */
+  BENCH_HeapFirst = 0;
+  BENCH_HeapBlock(0)->next = BENCH_HEAP_NONE;
+  BENCH_HeapBlock(0)->size = size;
+  BENCH_HeapFree = size;
+}
+
+/* prvInsertBlockIntoFreeList(): inserts the block sorted by address, merges it with its neighbours */
+static void BENCH_HeapInsert(uint32_t blk, unsigned *steps) {
+  uint32_t prev = BENCH_HEAP_NONE, next = BENCH_HeapFirst;
+
+  while (next!=BENCH_HEAP_NONE && next<blk) {
+    prev = next;
+    next = BENCH_HeapBlock(next)->next;
+    (*steps)++;
+  }
+  if (prev!=BENCH_HEAP_NONE && prev+BENCH_HeapBlock(prev)->size==blk) { /* merge with the block before */
+    BENCH_HeapBlock(prev)->size += BENCH_HeapBlock(blk)->size;
+    blk = prev;
+  }
+  if (next!=BENCH_HEAP_NONE && blk+BENCH_HeapBlock(blk)->size==next) { /* merge with the block after */
+    BENCH_HeapBlock(blk)->size += BENCH_HeapBlock(next)->size;
+    BENCH_HeapBlock(blk)->next = BENCH_HeapBlock(next)->next;
+  } else {
+    BENCH_HeapBlock(blk)->next = next;
+  }
+  if (blk!=prev) {
+    if (prev==BENCH_HEAP_NONE) {
+      BENCH_HeapFirst = blk;
+    } else {
+      BENCH_HeapBlock(prev)->next = blk;
+    }
+  }
+}
+
+/* pvPortMalloc(), steps counts the free blocks visited */
+static void *BENCH_HeapAlloc(size_t size, unsigned *steps) {
+  uint32_t wanted, prev = BENCH_HEAP_NONE, blk = BENCH_HeapFirst, rest;
+
+  wanted = (uint32_t)((size+BENCH_HEAP_HDR+BENCH_HEAP_ALIGN-1)&~(size_t)(BENCH_HEAP_ALIGN-1));
+  while (blk!=BENCH_HEAP_NONE && BENCH_HeapBlock(blk)->size<wanted) {
+    prev = blk;
+    blk = BENCH_HeapBlock(blk)->next;
+    (*steps)++;
+  }
+  if (blk==BENCH_HEAP_NONE) {
+    return NULL;
+  }
+  (*steps)++;
+  if (prev==BENCH_HEAP_NONE) {
+    BENCH_HeapFirst = BENCH_HeapBlock(blk)->next;
+  } else {
+    BENCH_HeapBlock(prev)->next = BENCH_HeapBlock(blk)->next;
+  }
+  if (BENCH_HeapBlock(blk)->size-wanted>BENCH_HEAP_MIN_BLOCK) { /* split, the rest goes back to the free list */
+    rest = blk+wanted;
+    BENCH_HeapBlock(rest)->size = BENCH_HeapBlock(blk)->size-wanted;
+    BENCH_HeapBlock(blk)->size = wanted;
+    BENCH_HeapInsert(rest, steps);
+  }
+  BENCH_HeapFree -= BENCH_HeapBlock(blk)->size;
+  return (uint8_t*)BENCH_HeapMem+blk+BENCH_HEAP_HDR;
+}
+
+/* vPortFree() */
+static void BENCH_HeapFreeBlock(void *p, unsigned *steps) {
+  uint32_t blk = (uint32_t)((uint8_t*)p-(uint8_t*)BENCH_HeapMem)-BENCH_HEAP_HDR;
+
+  BENCH_HeapFree += BENCH_HeapBlock(blk)->size;
+  BENCH_HeapInsert(blk, steps);
+}
+
+static uint32_t BENCH_HeapLargest(void) {
+  uint32_t blk, largest = 0;
+
+  for(blk=BENCH_HeapFirst;blk!=BENCH_HEAP_NONE;blk=BENCH_HeapBlock(blk)->next) {
+    if (BENCH_HeapBlock(blk)->size>largest) {
+      largest = BENCH_HeapBlock(blk)->size;
+    }
+  }
+  return largest;
+}
+
+typedef enum {
+  BENCH_ALLOC_POOL,
+  BENCH_ALLOC_HEAP
+} BENCH_Allocator;
+
+typedef struct {
+  uint32_t nofAllocs, nofFails;
+  uint32_t nofFragFails;  /* heap: failed although enough bytes were free */
+  double maxFrag;         /* heap: largest 1-largest/free block seen at a failure */
+  uint64_t sumNs;         /* allocation time */
+  uint32_t histNs[BENCH_MP_HIST_NS+1]; /* allocations per ns, the last entry counts the longer ones */
+  unsigned maxSteps;      /* heap: free blocks visited in an allocation or free */
+} BENCH_Result;
+
+static uint32_t BENCH_Seed;
+
+static uint32_t BENCH_Rand(void) {
+  BENCH_Seed = BENCH_Seed*1664525UL+1013904223UL;
+  return BENCH_Seed>>8;
+}
+
+static void *BENCH_Alloc(BENCH_Allocator a, size_t size, unsigned *steps) {
+  return a==BENCH_ALLOC_POOL ? MPOOL_Alloc(size) : BENCH_HeapAlloc(size, steps);
+}
+
+static uint8_t BENCH_Free(BENCH_Allocator a, void *p, unsigned *steps) {
+  if (a==BENCH_ALLOC_POOL) {
+    return MPOOL_Free(p);
+  }
+  BENCH_HeapFreeBlock(p, steps);
+  return ERR_OK;
+}
+
+/* random messages, freed in random order; checks that no block overlaps another one */
+static uint8_t BENCH_Stress(BENCH_Allocator a, BENCH_Result *res) {
+  void *msgs[BENCH_MP_MAX_MSGS];
+  size_t sizes[BENCH_MP_MAX_MSGS], size;
+  uint8_t fill[BENCH_MP_MAX_MSGS];
+  int nofMsgs = 0, i, k;
+  unsigned steps;
+  uint64_t t;
+  uint32_t largest, wanted;
+  uint8_t *p, res8 = ERR_OK;
+
+  memset(res, 0, sizeof(*res));
+  BENCH_Seed = 1; /* same sequence for both allocators */
+  MPOOL_Init();
+  BENCH_HeapInit(BENCH_MP_POOL_RAM);
+  for(i=0;i<BENCH_MP_STEPS;i++) {
+    if (nofMsgs==0 || (nofMsgs<BENCH_MP_MAX_MSGS && (BENCH_Rand()%100)<55)) {
+      size = (BENCH_Rand()%100)<60 ? 1+BENCH_Rand()%48 : 49+BENCH_Rand()%48; /* mostly short lines */
+      steps = 0;
+      t = BENCH_NowNs();
+      p = BENCH_Alloc(a, size, &steps);
+      t = BENCH_NowNs()-t;
+      res->sumNs += t;
+      res->histNs[t<BENCH_MP_HIST_NS ? t : BENCH_MP_HIST_NS]++;
+      if (steps>res->maxSteps) {
+        res->maxSteps = steps;
+      }
+      res->nofAllocs++;
+      if (p==NULL) {
+        res->nofFails++;
+        wanted = (uint32_t)((size+BENCH_HEAP_HDR+BENCH_HEAP_ALIGN-1)&~(size_t)(BENCH_HEAP_ALIGN-1));
+        if (a==BENCH_ALLOC_HEAP && BENCH_HeapFree>=wanted) {
+          res->nofFragFails++;
+          largest = BENCH_HeapLargest();
+          if (1.0-(double)largest/BENCH_HeapFree>res->maxFrag) {
+            res->maxFrag = 1.0-(double)largest/BENCH_HeapFree;
+          }
+        }
+        continue;
+      }
+      fill[nofMsgs] = (uint8_t)i;
+      memset(p, fill[nofMsgs], size);
+      msgs[nofMsgs] = p;
+      sizes[nofMsgs] = size;
+      nofMsgs++;
+    } else {
+      k = (int)(BENCH_Rand()%(uint32_t)nofMsgs);
+      p = msgs[k];
+      for(size=0;size<sizes[k];size++) {
+        if (p[size]!=fill[k]) {
+          res8 = ERR_FAILED; /* overwritten by another block */
+          break;
+        }
+      }
+      steps = 0;
+      if (BENCH_Free(a, p, &steps)!=ERR_OK) {
+        res8 = ERR_FAILED;
+      }
+      if (steps>res->maxSteps) {
+        res->maxSteps = steps;
+      }
+      nofMsgs--;
+      msgs[k] = msgs[nofMsgs];
+      sizes[k] = sizes[nofMsgs];
+      fill[k] = fill[nofMsgs];
+    }
+  }
+  while (nofMsgs>0) {
+    nofMsgs--;
+    steps = 0;
+    if (BENCH_Free(a, msgs[nofMsgs], &steps)!=ERR_OK) {
+      res8 = ERR_FAILED;
+    }
+  }
+  if (a==BENCH_ALLOC_POOL && (MPOOL_Free(msgs[0])!=ERR_FAILED)) { /* double free has to be detected */
+    res8 = ERR_FAILED;
+  }
+  return res8;
+}
+
+/* fills the memory with the smallest blocks, frees every other one, then times a request for the largest message */
+static void BENCH_WorstCase(BENCH_Allocator a, uint64_t *ns, unsigned *steps) {
+  static void *blocks[BENCH_MP_ROBOT_HEAP/BENCH_HEAP_MIN_BLOCK];
+  int nofBlocks = 0, i;
+  unsigned dummy = 0;
+  void *p;
+  uint64_t t;
+
+  MPOOL_Init();
+  BENCH_HeapInit(BENCH_MP_ROBOT_HEAP);
+  while (nofBlocks<(int)(sizeof(blocks)/sizeof(blocks[0])) && (p = BENCH_Alloc(a, 1, &dummy))!=NULL) {
+    blocks[nofBlocks++] = p;
+  }
+  for(i=0;i<nofBlocks;i+=2) {
+    (void)BENCH_Free(a, blocks[i], &dummy);
+  }
+  *steps = 0;
+  t = BENCH_NowNs();
+  for(i=0;i<BENCH_MP_REPEAT;i++) {
+    dummy = 0;
+    p = BENCH_Alloc(a, MPOOL_GetMaxBlockSize(), &dummy);
+    if (p!=NULL) {
+      (void)BENCH_Free(a, p, &dummy);
+    }
+    if (dummy>*steps) {
+      *steps = dummy;
+    }
+  }
+  *ns = (BENCH_NowNs()-t)/BENCH_MP_REPEAT;
+}
+
+/* allocation time not exceeded by 99.9% of the allocations */
+static unsigned BENCH_Percentile(const BENCH_Result *res) {
+  uint32_t n = 0;
+  unsigned ns;
+
+  for(ns=0;ns<BENCH_MP_HIST_NS;ns++) {
+    n += res->histNs[ns];
+    if (n>=res->nofAllocs-res->nofAllocs/1000) {
+      break;
+    }
+  }
+  return ns;
+}
+
+static void BENCH_PrintResult(FILE *out, const char *name, const BENCH_Result *res, bool isHeap) {
+  (void)fprintf(out, "%-8s %8u %8u", name, (unsigned)res->nofAllocs, (unsigned)res->nofFails);
+  if (isHeap) {
+    (void)fprintf(out, " %10u %8.2f", (unsigned)res->nofFragFails, res->maxFrag);
+  } else {
+    (void)fprintf(out, " %10s %8s", "-", "-");
+  }
+  (void)fprintf(out, " %8.0f %8u", (double)res->sumNs/res->nofAllocs, BENCH_Percentile(res));
+  if (isHeap) {
+    (void)fprintf(out, " %9u\n", res->maxSteps);
+  } else {
+    (void)fprintf(out, " %9s\n", "-");
+  }
+}
+
+uint8_t BENCH_MemPool(FILE *out) {
+  BENCH_Result pool, heap;
+  uint64_t poolNs, heapNs;
+  unsigned poolSteps, heapSteps;
+  uint8_t res = ERR_OK;
+
+  if (BENCH_Stress(BENCH_ALLOC_POOL, &pool)!=ERR_OK) {
+    (void)fprintf(out, "FAILED: memory pool block corrupted or free failed\n");
+    res = ERR_FAILED;
+  }
+  if (BENCH_Stress(BENCH_ALLOC_HEAP, &heap)!=ERR_OK) {
+    (void)fprintf(out, "FAILED: heap block corrupted\n");
+    res = ERR_FAILED;
+  }
+  (void)fprintf(out, "stress: %u steps, up to %u messages of 1..%u bytes freed in random order, %u bytes of RAM\n",
+      (unsigned)BENCH_MP_STEPS, (unsigned)BENCH_MP_MAX_MSGS, (unsigned)MPOOL_GetMaxBlockSize(), (unsigned)BENCH_MP_POOL_RAM);
+  (void)fprintf(out, "\nalloc      allocs    fails frag fails max frag   avg ns 99.9%% ns max steps\n");
+  BENCH_PrintResult(out, "pools", &pool, FALSE);
+  BENCH_PrintResult(out, "heap_4", &heap, TRUE);
+  BENCH_WorstCase(BENCH_ALLOC_POOL, &poolNs, &poolSteps);
+  BENCH_WorstCase(BENCH_ALLOC_HEAP, &heapNs, &heapSteps);
+  (void)fprintf(out, "\nworst case: %u byte request, memory filled with 1 byte blocks and every other one freed\n",
+      (unsigned)MPOOL_GetMaxBlockSize());
+  (void)fprintf(out, "pools    %8u ns (constant: one free list per size class)\n", (unsigned)poolNs);
+  (void)fprintf(out, "heap_4   %8u ns, %u free blocks visited in a %u byte heap\n", (unsigned)heapNs, heapSteps, (unsigned)BENCH_MP_ROBOT_HEAP);
+  MPOOL_Init(); /* all blocks free again */
+  return res;
+}
+#endif /* PL_CONFIG_HAS_MEM_POOL */
@@ -0,0 +1,139 @@
+/**
+ * \file
+ * \brief Test of the clock synchronisation estimator with two simulated nodes, see Bench.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The master and the client have free running microsecond clocks with a constant drift against the
+ * true time and start with arbitrary values (the client close to the 32bit wrap around). The client
+ * sends its requests like TSYNC_Process(), every second until the drift is known and every 4 s
+ * afterwards. Requests and responses get lost with the given probability, the one way delays are a
+ * base latency plus jitter, mostly short but sometimes long (radio retries, scheduling of the radio
+ * task), independent in both directions.
+ * Every 10 ms the shared time of the client is compared with the master clock: the error has to be
+ * within the error bound of TSYNC_EstimatorToShared(), and once the drift is known it has to stay
+ * below the limit of the case.
+ */
+
+#include "Platform.h"
+#include "Bench.h"
+#if PL_CONFIG_HAS_TIME_SYNC
+#include "TimeSync.h"
+#include <math.h>
+
+#define TSYNC_BENCH_RUN_S         (2*3600) /* run time, longer than the 71 minutes of a 32bit us clock */
+#define TSYNC_BENCH_CHECK_US      10000    /* period of the checks */
+#define TSYNC_BENCH_PERIOD_US     1000000  /* request period until the drift is known */
+#define TSYNC_BENCH_PERIOD_SLOW_US 4000000 /* request period afterwards */
+#define TSYNC_BENCH_BASE_US       400      /* one way latency of the radio */
+#define TSYNC_BENCH_SHORT_US      500      /* jitter of most messages */
+
+typedef struct {
+  double masterPpm, clientPpm; /* drift of the clocks against the true time */
+  int lossPercent;             /* probability that a request or a response is lost */
+  int longPercent;             /* probability of a long delay */
+  double longUs;               /* maximum of a long delay */
+  double maxErrUs;             /* error limit once the drift is known */
+} TSYNC_BenchCase;
+
+static const TSYNC_BenchCase TSYNC_BenchCases[] = {
+  {  0.0,   50.0,  0, 10,  5000.0,  500.0},
+  { 30.0, -120.0, 20, 20, 20000.0,  500.0},
+  {-80.0,  200.0, 50, 30, 40000.0,  500.0},
+  { 15.0,   15.0, 80, 50, 60000.0, 2000.0}, /* same drift, very lossy link with long delays */
+};
+
+static uint32_t TSYNC_BenchSeed;
+
+static double TSYNC_BenchRand(void) { /* 0..1 */
+  TSYNC_BenchSeed = TSYNC_BenchSeed*1664525UL+1013904223UL;
+  return (double)(TSYNC_BenchSeed>>8)/16777216.0;
+}
+
+/* value of a clock at the true time, wraps around like the 32bit clocks of the nodes */
+static uint32_t TSYNC_BenchClock(double trueUs, double ppm, double startUs) {
+  return (uint32_t)(uint64_t)fmod(startUs+trueUs*(1.0+ppm*1e-6), 4294967296.0);
+}
+
+static double TSYNC_BenchDelay(const TSYNC_BenchCase *c) {
+  if (TSYNC_BenchRand()*100<c->longPercent) {
+    return TSYNC_BENCH_BASE_US+TSYNC_BenchRand()*c->longUs;
+  }
+  return TSYNC_BENCH_BASE_US+TSYNC_BenchRand()*TSYNC_BENCH_SHORT_US;
+}
+
+static uint8_t TSYNC_BenchRun(const TSYNC_BenchCase *c, FILE *out) {
+  static const double masterStart = 123456789.0, clientStart = 4294967296.0-30e6; /* client wraps after 30 s */
+  TSYNC_Estimator est;
+  double t, nextReq = 0, tReq, tResp, syncS = -1, driftS = -1, maxErr = 0, maxBound = 0, err;
+  uint32_t t1, t2, t3, t4, shared, errUs, nofUsed = 0, nofRejected = 0, nofLost = 0, nofViolations = 0;
+  double trueDriftPpb = ((1.0+c->masterPpm*1e-6)/(1.0+c->clientPpm*1e-6)-1.0)*1e9;
+  uint8_t res = ERR_OK;
+
+  TSYNC_BenchSeed = 1;
+  TSYNC_EstimatorReset(&est);
+  for(t=0;t<TSYNC_BENCH_RUN_S*1e6;t+=TSYNC_BENCH_CHECK_US) {
+    if (t>=nextReq) { /* request of the client */
+      nextReq = t+(est.haveDrift ? TSYNC_BENCH_PERIOD_SLOW_US : TSYNC_BENCH_PERIOD_US);
+      if (TSYNC_BenchRand()*100<c->lossPercent || TSYNC_BenchRand()*100<c->lossPercent) {
+        nofLost++; /* request or response lost */
+      } else {
+        t1 = TSYNC_BenchClock(t, c->clientPpm, clientStart);
+        tReq = t+TSYNC_BenchDelay(c);
+        t2 = TSYNC_BenchClock(tReq, c->masterPpm, masterStart);
+        tResp = tReq+100+TSYNC_BenchRand()*1900; /* processing on the master */
+        t3 = TSYNC_BenchClock(tResp, c->masterPpm, masterStart);
+        t4 = TSYNC_BenchClock(tResp+TSYNC_BenchDelay(c), c->clientPpm, clientStart);
+        if (TSYNC_EstimatorAddSample(&est, t1, t2, t3, t4)==ERR_OK) {
+          nofUsed++;
+        } else {
+          nofRejected++;
+        }
+        if (syncS<0 && est.synced) {
+          syncS = t/1e6;
+        }
+        if (driftS<0 && est.haveDrift) {
+          driftS = t/1e6;
+        }
+      }
+    }
+    if (TSYNC_EstimatorToShared(&est, TSYNC_BenchClock(t, c->clientPpm, clientStart), &shared, &errUs)) {
+      err = fabs((double)(int32_t)(shared-TSYNC_BenchClock(t, c->masterPpm, masterStart)));
+      if (err>errUs) {
+        nofViolations++; /* outside of the error bound */
+      }
+      if (est.haveDrift) {
+        if (err>maxErr) {
+          maxErr = err;
+        }
+        if (errUs>maxBound) {
+          maxBound = errUs;
+        }
+      }
+    }
+  }
+  (void)fprintf(out, "%7.0f %7.0f %5d%% %5.0f %6u %5u %5u %6.0f %6.0f %9.0f %8.0f %7.0f %6.0f %8.0f %6u\n",
+      c->masterPpm, c->clientPpm, c->lossPercent, c->longUs/1000, (unsigned)nofUsed, (unsigned)nofRejected, (unsigned)nofLost,
+      syncS, driftS, trueDriftPpb, (double)est.driftPpb-trueDriftPpb, maxErr, c->maxErrUs, maxBound, (unsigned)nofViolations);
+  if (nofViolations>0 || driftS<0 || maxErr>c->maxErrUs) {
+    res = ERR_FAILED;
+  }
+  return res;
+}
+
+uint8_t BENCH_TimeSync(FILE *out) {
+  size_t i;
+  uint8_t res = ERR_OK;
+
+  (void)fprintf(out, "two nodes for %u s, check every %u ms: error within the bound, below the limit once the drift is known\n\n",
+      (unsigned)TSYNC_BENCH_RUN_S, (unsigned)(TSYNC_BENCH_CHECK_US/1000));
+  (void)fprintf(out, "master  client   loss  long   used  rej.  lost   sync  drift  drift ppb  est err max err  limit    bound viol.\n");
+  (void)fprintf(out, "   ppm     ppm          ms                          s      s                    ppb      us     us       us\n");
+  for(i=0;i<sizeof(TSYNC_BenchCases)/sizeof(TSYNC_BenchCases[0]);i++) {
+    if (TSYNC_BenchRun(&TSYNC_BenchCases[i], out)!=ERR_OK) {
+      res = ERR_FAILED;
+    }
+  }
+  (void)fprintf(out, "%s\n", res==ERR_OK ? "passed" : "FAILED");
+  return res;
+}
+#endif /* PL_CONFIG_HAS_TIME_SYNC */
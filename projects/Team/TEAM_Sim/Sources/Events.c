@@ -0,0 +1,36 @@
+/**
+ * \file
+ * \brief Simulator events, called by the RTOS emulation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#include "Platform.h"
+#include "FRTOS1.h"
+#include "SimHw.h"
+#include "Sim.h"
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  #include "Tacho.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+#endif
+
+void FRTOS1_vApplicationTickHook(void) {
+  /* Called for every RTOS tick: the model runs first, so the encoder sample sees the new positions */
+  TickType_t tick = xTaskGetTickCount();
+
+  SIMHW_OnTick(tick);
+  SIM_Step(tick);
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  TACHO_Sample();
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  CTRL_OnTimerInterrupt(); /* TI1 on the robot, it has the same 1 ms period as the tick */
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_OnTick();
+#endif
+}
@@ -0,0 +1,158 @@
+/**
+ * \file
+ * \brief Replay of recorded runs, see Replay.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The frames are played on the RTOS tick timebase: frame n is active from (time of frame n - time of
+ * frame 0) after REPLAY_Start(). The reflectance values change in steps, as on the robot where the
+ * reflectance task measures every 10 ms. The encoder counts are interpolated, because the tacho
+ * samples them every tick.
+ */
+
+#include "Replay.h"
+#include "SimHw.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_NOF_TOF  4 /* ToF ranges per frame: front, rear, left, right */
+
+typedef struct {
+  uint32_t timeMs;
+  uint16_t ir[REPLAY_NOF_IR];
+  int32_t enc[2];
+  int16_t tof[REPLAY_NOF_TOF];
+} REPLAY_Frame;
+
+/* recorded ToF column for each CE slot, -1 if not fitted: the sumo robot has the right sensor on CE1 and the left one on CE3, see Distance.c */
+static const int REPLAY_TofColumn[SIMHW_NOF_TOF] = {3, -1, 2, -1};
+
+static REPLAY_Frame *REPLAY_Frames = NULL;
+static int REPLAY_Count = 0;
+static int REPLAY_Cur = 0;
+static uint32_t REPLAY_RefCntHz = RefCnt_CNT_INP_FREQ_U_0;
+static uint16_t REPLAY_CalibMin[REPLAY_NOF_IR], REPLAY_CalibMax[REPLAY_NOF_IR];
+static bool REPLAY_Started = FALSE;
+static uint32_t REPLAY_StartTick;
+static double REPLAY_FrameFraction; /* position between the current and the next frame, for the interpolation */
+
+static bool ParseValues(const char *str, uint16_t *vals) {
+  return sscanf(str, "%hu %hu %hu %hu %hu %hu", &vals[0], &vals[1], &vals[2], &vals[3], &vals[4], &vals[5])==REPLAY_NOF_IR;
+}
+
+uint8_t REPLAY_Load(const char *fileName) {
+  FILE *f;
+  char line[256];
+  REPLAY_Frame fr, *p;
+  int size = 0;
+  bool haveCalib = FALSE;
+
+  f = fopen(fileName, "r");
+  if (f==NULL) {
+    return ERR_FAILED;
+  }
+  free(REPLAY_Frames);
+  REPLAY_Frames = NULL;
+  REPLAY_Count = 0;
+  while (fgets(line, sizeof(line), f)!=NULL) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (strncmp(line, "# refcnt_hz ", sizeof("# refcnt_hz ")-1)==0) {
+      REPLAY_RefCntHz = (uint32_t)strtoul(line+sizeof("# refcnt_hz ")-1, NULL, 10);
+    } else if (strncmp(line, "# calib_min ", sizeof("# calib_min ")-1)==0) {
+      haveCalib = ParseValues(line+sizeof("# calib_min ")-1, REPLAY_CalibMin);
+    } else if (strncmp(line, "# calib_max ", sizeof("# calib_max ")-1)==0) {
+      haveCalib = haveCalib && ParseValues(line+sizeof("# calib_max ")-1, REPLAY_CalibMax);
+    } else if (sscanf(line, "%u,%hu,%hu,%hu,%hu,%hu,%hu,%d,%d,%hd,%hd,%hd,%hd",
+        &fr.timeMs, &fr.ir[0], &fr.ir[1], &fr.ir[2], &fr.ir[3], &fr.ir[4], &fr.ir[5],
+        &fr.enc[0], &fr.enc[1], &fr.tof[0], &fr.tof[1], &fr.tof[2], &fr.tof[3])==13) {
+      if (REPLAY_Count>0 && fr.timeMs<=REPLAY_Frames[REPLAY_Count-1].timeMs) {
+        continue; /* time has to increase (e.g. a second dump in the same log) */
+      }
+      if (REPLAY_Count==size) {
+        size = size==0 ? 256 : 2*size;
+        p = realloc(REPLAY_Frames, size*sizeof(REPLAY_Frame));
+        if (p==NULL) {
+          break;
+        }
+        REPLAY_Frames = p;
+      }
+      REPLAY_Frames[REPLAY_Count++] = fr;
+    }
+  }
+  (void)fclose(f);
+  if (REPLAY_Count==0 || !haveCalib || REPLAY_RefCntHz==0) {
+    REPLAY_Count = 0;
+    return ERR_FAILED;
+  }
+  REPLAY_Cur = 0;
+  REPLAY_Started = FALSE;
+  REPLAY_FrameFraction = 0.0;
+  return ERR_OK;
+}
+
+bool REPLAY_IsActive(void) {
+  return REPLAY_Count>0;
+}
+
+int REPLAY_NofFrames(void) {
+  return REPLAY_Count;
+}
+
+void REPLAY_GetCalibration(uint16_t *minVals, uint16_t *maxVals) {
+  memcpy(minVals, REPLAY_CalibMin, sizeof(REPLAY_CalibMin));
+  memcpy(maxVals, REPLAY_CalibMax, sizeof(REPLAY_CalibMax));
+}
+
+void REPLAY_Start(uint32_t tick) {
+  REPLAY_StartTick = tick;
+  REPLAY_Started = TRUE;
+  REPLAY_Cur = 0;
+  REPLAY_FrameFraction = 0.0;
+}
+
+bool REPLAY_Step(uint32_t tick) {
+  uint32_t t;
+  const REPLAY_Frame *cur, *next;
+
+  if (!REPLAY_Started || REPLAY_Count==0) {
+    return TRUE;
+  }
+  t = REPLAY_Frames[0].timeMs+(tick-REPLAY_StartTick);
+  while (REPLAY_Cur+1<REPLAY_Count && REPLAY_Frames[REPLAY_Cur+1].timeMs<=t) {
+    REPLAY_Cur++;
+  }
+  if (REPLAY_Cur+1>=REPLAY_Count) {
+    REPLAY_FrameFraction = 0.0;
+    return t<=REPLAY_Frames[REPLAY_Cur].timeMs; /* ends after the last frame */
+  }
+  cur = &REPLAY_Frames[REPLAY_Cur];
+  next = cur+1;
+  REPLAY_FrameFraction = (double)(t-cur->timeMs)/(next->timeMs-cur->timeMs);
+  return TRUE;
+}
+
+int REPLAY_CurrentFrame(void) {
+  return REPLAY_Cur;
+}
+
+uint32_t REPLAY_GetIrDischargeNs(uint8_t sensor) {
+  return (uint32_t)(((uint64_t)REPLAY_Frames[REPLAY_Cur].ir[sensor]*1000000000ULL)/REPLAY_RefCntHz);
+}
+
+double REPLAY_GetEncoderCounts(uint8_t motor) {
+  const REPLAY_Frame *cur = &REPLAY_Frames[REPLAY_Cur];
+
+  if (REPLAY_Cur+1>=REPLAY_Count) {
+    return cur->enc[motor];
+  }
+  return cur->enc[motor]+REPLAY_FrameFraction*(cur[1].enc[motor]-cur->enc[motor]);
+}
+
+int REPLAY_GetTofRangeMm(uint8_t slot) {
+  int col = REPLAY_TofColumn[slot];
+
+  if (col<0) {
+    return SIM_TOF_NOT_FITTED;
+  }
+  return REPLAY_Frames[REPLAY_Cur].tof[col]; /* -1: no target */
+}
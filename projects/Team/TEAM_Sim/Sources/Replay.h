@@ -0,0 +1,67 @@
+/**
+ * \file
+ * \brief Interface of the replay of recorded runs.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Loads the output of 'rec dump' (see Recorder.h) and feeds the recorded frames into the hardware
+ * emulation instead of the world model: the reflectance discharge times, encoder counts and ToF ranges
+ * come from the frames, the motor outputs have no effect. The robot code runs unchanged, so the
+ * outputs of different versions of the estimators and controllers can be compared for the same inputs.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "PE_Types.h"
+
+#define REPLAY_NOF_IR   6 /* reflectance values per frame */
+
+/*!
+ * \brief Loads a recording.
+ * \param fileName Path of the file with the output of 'rec dump', other lines (e.g. of a terminal log) are ignored.
+ * \return ERR_OK if at least one frame has been loaded.
+ */
+uint8_t REPLAY_Load(const char *fileName);
+
+/*! \brief Returns TRUE if a recording is loaded: the sensor values come from the frames */
+bool REPLAY_IsActive(void);
+
+/*! \brief Returns the number of loaded frames */
+int REPLAY_NofFrames(void);
+
+/*!
+ * \brief Returns the reflectance calibration of the recording.
+ * \param minVals Array of REPLAY_NOF_IR entries for the minimum (white) values.
+ * \param maxVals Array of REPLAY_NOF_IR entries for the maximum (black) values.
+ */
+void REPLAY_GetCalibration(uint16_t *minVals, uint16_t *maxVals);
+
+/*!
+ * \brief Starts playing the frames: the first frame is played at this tick, until then the first frame is held.
+ * \param tick Current tick count.
+ */
+void REPLAY_Start(uint32_t tick);
+
+/*!
+ * \brief Advances to the frame of the tick, called every tick.
+ * \param tick Current tick count.
+ * \return FALSE if the replay has ended (all frames played).
+ */
+bool REPLAY_Step(uint32_t tick);
+
+/*! \brief Returns the index of the current frame */
+int REPLAY_CurrentFrame(void);
+
+/*! \brief Returns the recorded discharge time of a reflectance sensor, in ns */
+uint32_t REPLAY_GetIrDischargeNs(uint8_t sensor);
+
+/*! \brief Returns the recorded encoder counts, interpolated between the frames */
+double REPLAY_GetEncoderCounts(uint8_t motor);
+
+/*!
+ * \brief Returns the recorded range of the ToF sensor on a CE slot.
+ * \return Range in mm, <0 if no target, SIM_TOF_NOT_FITTED if the robot has no sensor on the slot.
+ */
+int REPLAY_GetTofRangeMm(uint8_t slot);
+
+#endif /* REPLAY_H_ */
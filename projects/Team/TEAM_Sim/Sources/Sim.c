@@ -0,0 +1,845 @@
+/**
+ * \file
+ * \brief Robot and world model of the simulator.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The model runs in the tick hook with a fixed integration step of SIM_SUBSTEPS per tick.
+ * Tracking error: distance of the sensor array center to the line center, looked up in a map which
+ * is computed with a chamfer distance transform of the floor bitmap, so it works for PGM tracks too.
+ */
+
+#include "Sim.h"
+#include "SimHw.h"
+#include "Replay.h"
+#include "UTIL1.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_SUBSTEPS       4     /* integration steps per tick */
+#define SIM_DT             (0.001/SIM_SUBSTEPS)
+#define SIM_G              9.81
+#define SIM_IR_SPOT_M      0.002 /* radius of the floor spot seen by a reflectance sensor */
+#define SIM_TOF_CONE_DEG   12.0  /* half angle of the ToF emitter cone */
+#define SIM_TOF_NOF_RAYS   5     /* rays cast over the cone */
+#define SIM_ROBOT_RADIUS_M 0.05  /* robot body radius for collisions */
+#define SIM_MARGIN_M       0.3   /* floor around a track */
+#define SIM_LAP_MIN_M      1.0   /* distance to drive before the start line counts again */
+#define SIM_LAP_GATE_M     0.15  /* half width of the start line */
+#define SIM_ARENA_BORDER_M 0.025 /* white border of the arena */
+#define SIM_CALIB_SWEEP_M  0.04  /* calibration sweep to each side of the line */
+
+volatile bool SIM_Stop = FALSE;
+bool SIM_Verbose = FALSE;
+
+/* parameters, changed with "sim <name> <value>" */
+typedef struct {
+  const char *name;
+  double val;
+  const char *help;
+} SIM_Param;
+
+typedef enum {
+  P_VMAX, P_TAU, P_ROTOR, P_MASS, P_INERTIA, P_BASE, P_CHI, P_MU, P_STIFF, P_ROLL, P_COUNTS,
+  P_IRFWD, P_IRPITCH, P_IRWHITE, P_IRBLACK, P_IRNOISE, P_LINE, P_RES, P_LOST,
+  P_ARENA, P_OPPX, P_OPPY, P_OPPR, P_OPPMU, P_OPPMASS, P_TOFNOISE,
+  P_STARTX, P_STARTY, P_STARTDEG, P_SEED, P_MOTINV, P_ENCINV,
+  P_NOF_PARAMS
+} SIM_ParamId;
+
+static SIM_Param SIM_Params[P_NOF_PARAMS] = {
+  [P_VMAX]    = {"vmax",     1.0,     "track speed at 100% PWM without load (m/s)"},
+  [P_TAU]     = {"tau",      0.05,    "motor time constant (s)"},
+  [P_ROTOR]   = {"rotor",    1.0,     "motor and gear inertia as mass on the track (kg)"},
+  [P_MASS]    = {"mass",     0.5,     "robot mass (kg)"},
+  [P_INERTIA] = {"inertia",  0.0008,  "robot yaw inertia (kg m^2)"},
+  [P_BASE]    = {"base",     0.085,   "distance between the tracks (m)"},
+  [P_CHI]     = {"chi",      1.4,     "skid steering factor: effective/geometric track distance"},
+  [P_MU]      = {"mu",       0.8,     "track friction coefficient"},
+  [P_STIFF]   = {"stiff",    40.0,    "track slip stiffness (N per m/s)"},
+  [P_ROLL]    = {"roll",     0.5,     "rolling resistance (1/s)"},
+  [P_COUNTS]  = {"counts",   7350.0,  "quadrature counts per meter of track"},
+  [P_IRFWD]   = {"irfwd",    0.045,   "reflectance array ahead of the robot center (m)"},
+  [P_IRPITCH] = {"irpitch",  0.0095,  "distance between the reflectance sensors (m)"},
+  [P_IRWHITE] = {"irwhite",  150.0,   "discharge time on white (us)"},
+  [P_IRBLACK] = {"irblack",  1100.0,  "discharge time on black (us)"},
+  [P_IRNOISE] = {"irnoise",  0.03,    "relative noise of the discharge time"},
+  [P_LINE]    = {"line",     0.019,   "line width (m)"},
+  [P_RES]     = {"res",      0.001,   "floor bitmap resolution, for tracks and PGM files (m/pixel)"},
+  [P_LOST]    = {"lost",     0.15,    "tracking error which ends a line following run (m)"},
+  [P_ARENA]   = {"arena",    0.385,   "sumo arena radius (m)"},
+  [P_OPPX]    = {"oppx",     0.2,     "opponent position x (m)"},
+  [P_OPPY]    = {"oppy",     0.0,     "opponent position y (m)"},
+  [P_OPPR]    = {"oppr",     0.05,    "opponent radius (m), 0 for no opponent"},
+  [P_OPPMU]   = {"oppmu",    0.6,     "opponent friction coefficient"},
+  [P_OPPMASS] = {"oppmass",  0.5,     "opponent mass (kg)"},
+  [P_TOFNOISE]= {"tofnoise", 0.003,   "ToF range noise (m)"},
+  [P_STARTX]  = {"startx",   NAN,     "start position x (m), nan for the default"},
+  [P_STARTY]  = {"starty",   NAN,     "start position y (m), nan for the default"},
+  [P_STARTDEG]= {"startdeg", NAN,     "start heading (degree), nan for the default"},
+  [P_SEED]    = {"seed",     1.0,     "random seed"},
+  [P_MOTINV]  = {"motinv",   0.0,     "motor wired reversed: 1 left, 2 right, 3 both"},
+  [P_ENCINV]  = {"encinv",   0.0,     "encoder phases wired swapped: 1 left, 2 right, 3 both"},
+};
+#define PARAM(id)  (SIM_Params[id].val)
+
+/* ToF sensor mounting, one slot for each CE pin */
+typedef struct {
+  bool fitted;
+  double x, y;     /* position relative to the robot center, x forward, y left */
+  double heading;  /* direction relative to the robot heading */
+} SIM_TofMount;
+
+static SIM_TofMount SIM_Tof[SIMHW_NOF_TOF] = {
+  {TRUE,  0.045, -0.030, -5.0*M_PI/180}, /* CE1: front right */
+  {FALSE, 0.0,    0.0,    0.0},           /* CE2 */
+  {TRUE,  0.045,  0.030,  5.0*M_PI/180}, /* CE3: front left */
+  {FALSE, 0.0,    0.0,    0.0},           /* CE4 */
+};
+
+/* world */
+static struct {
+  char name[64];
+  bool isArena;
+  int w, h;          /* bitmap size in pixels */
+  double res;        /* m/pixel */
+  double x0, y0;     /* world position of pixel (0,0) */
+  uint8_t *dark;     /* floor darkness, 0 white, 255 black */
+  float *err;        /* distance to the line center (m), NULL for the arena */
+  double startX, startY, startTheta; /* start of the line (sensor array position) */
+} SIM_World;
+
+/* robot and opponent state */
+static struct {
+  bool held;
+  double x, y, theta;   /* pose of the robot center */
+  double v, omega;      /* body speed and turn rate */
+  double vw[2];         /* track speed driven by the motors */
+  double counts[2];     /* encoder counts */
+  double oppX, oppY;    /* opponent position */
+} SIM_Robot;
+
+static SIM_Metrics SIM_Metric;
+static struct {
+  bool on;
+  uint32_t startTick, lapStartTick, tick;
+  double lastGateS;     /* signed distance to the start line in the last tick */
+  double lapDistance;   /* driven distance since the last lap */
+} SIM_Lap;
+
+static uint32_t SIM_RandState = 1;
+
+/* ------------------------------------ helpers ------------------------------------ */
+static double Rand01(void) {
+  /* xorshift32: deterministic for a given seed, independent of the host C library */
+  SIM_RandState ^= SIM_RandState<<13;
+  SIM_RandState ^= SIM_RandState>>17;
+  SIM_RandState ^= SIM_RandState<<5;
+  return (SIM_RandState+0.5)/4294967296.0;
+}
+
+static double RandGauss(void) {
+  return sqrt(-2.0*log(Rand01()))*cos(2.0*M_PI*Rand01());
+}
+
+static void ToWorld(double fwd, double left, double *x, double *y) {
+  *x = SIM_Robot.x+cos(SIM_Robot.theta)*fwd-sin(SIM_Robot.theta)*left;
+  *y = SIM_Robot.y+sin(SIM_Robot.theta)*fwd+cos(SIM_Robot.theta)*left;
+}
+
+static bool ToPixel(double x, double y, int *px, int *py) {
+  *px = (int)floor((x-SIM_World.x0)/SIM_World.res+0.5);
+  *py = (int)floor((y-SIM_World.y0)/SIM_World.res+0.5);
+  return *px>=0 && *px<SIM_World.w && *py>=0 && *py<SIM_World.h;
+}
+
+/* mean darkness (0..1) of the floor spot around a position */
+static double FloorDarkness(double x, double y, double radius) {
+  int cx, cy, px, py, r, sum = 0, cnt = 0;
+
+  (void)ToPixel(x, y, &cx, &cy);
+  r = (int)(radius/SIM_World.res);
+  for(py=cy-r; py<=cy+r; py++) {
+    for(px=cx-r; px<=cx+r; px++) {
+      if ((px-cx)*(px-cx)+(py-cy)*(py-cy) > r*r) {
+        continue;
+      }
+      if (px>=0 && px<SIM_World.w && py>=0 && py<SIM_World.h) {
+        sum += SIM_World.dark[py*SIM_World.w+px];
+      } /* else: white floor */
+      cnt++;
+    }
+  }
+  return cnt==0 ? 0.0 : (double)sum/(255.0*cnt);
+}
+
+/* ------------------------------------ world ------------------------------------ */
+static void FreeWorld(void) {
+  free(SIM_World.dark);
+  free(SIM_World.err);
+  SIM_World.dark = NULL;
+  SIM_World.err = NULL;
+}
+
+static uint8_t AllocWorld(int w, int h, bool withErrMap) {
+  FreeWorld();
+  SIM_World.w = w;
+  SIM_World.h = h;
+  SIM_World.dark = calloc((size_t)w*h, 1);
+  if (withErrMap) {
+    SIM_World.err = calloc((size_t)w*h, sizeof(float));
+  }
+  if (SIM_World.dark==NULL || (withErrMap && SIM_World.err==NULL)) {
+    FreeWorld();
+    return ERR_FAILED;
+  }
+  return ERR_OK;
+}
+
+/* chamfer 5-7-11 distance transform: distance (in pixels) of each pixel to the nearest pixel with mask==0 */
+static void DistanceTransform(const uint8_t *mask, float *dist, int w, int h) {
+  static const struct { int dx, dy; float d; } fwd[] = {
+    {-1,0,5}, {0,-1,5}, {-1,-1,7}, {1,-1,7}, {-2,-1,11}, {-1,-2,11}, {1,-2,11}, {2,-1,11}
+  };
+  const float inf = 1e9f;
+  int x, y, k, nx, ny;
+  float d;
+
+  for(k=0;k<w*h;k++) {
+    dist[k] = mask[k] ? inf : 0.0f;
+  }
+  for(y=0;y<h;y++) { /* forward pass */
+    for(x=0;x<w;x++) {
+      for(k=0;k<(int)(sizeof(fwd)/sizeof(fwd[0]));k++) {
+        nx = x+fwd[k].dx; ny = y+fwd[k].dy;
+        if (nx>=0 && nx<w && ny>=0) {
+          d = dist[ny*w+nx]+fwd[k].d;
+          if (d<dist[y*w+x]) {
+            dist[y*w+x] = d;
+          }
+        }
+      }
+    }
+  }
+  for(y=h-1;y>=0;y--) { /* backward pass, mirrored neighbours */
+    for(x=w-1;x>=0;x--) {
+      for(k=0;k<(int)(sizeof(fwd)/sizeof(fwd[0]));k++) {
+        nx = x-fwd[k].dx; ny = y-fwd[k].dy;
+        if (nx>=0 && nx<w && ny<h) {
+          d = dist[ny*w+nx]+fwd[k].d;
+          if (d<dist[y*w+x]) {
+            dist[y*w+x] = d;
+          }
+        }
+      }
+    }
+  }
+  for(k=0;k<w*h;k++) {
+    dist[k] /= 5.0f;
+  }
+}
+
+/* computes the distance to the line center of each pixel, assuming a line of constant width */
+static uint8_t ComputeErrMap(void) {
+  int n = SIM_World.w*SIM_World.h, k;
+  uint8_t *mask;
+  float *dIn;
+  double half = PARAM(P_LINE)/2.0, e;
+
+  mask = calloc(n, 1);
+  dIn = malloc(n*sizeof(float));
+  if (mask==NULL || dIn==NULL) {
+    free(mask);
+    free(dIn);
+    return ERR_FAILED;
+  }
+  for(k=0;k<n;k++) {
+    mask[k] = SIM_World.dark[k]<128; /* off the line */
+  }
+  DistanceTransform(mask, SIM_World.err, SIM_World.w, SIM_World.h); /* distance to the line */
+  for(k=0;k<n;k++) {
+    mask[k] = !mask[k];
+  }
+  DistanceTransform(mask, dIn, SIM_World.w, SIM_World.h); /* distance to the line edge, on the line */
+  for(k=0;k<n;k++) {
+    if (SIM_World.dark[k]>=128) {
+      e = half-(dIn[k]-0.5)*SIM_World.res;
+      SIM_World.err[k] = (float)(e<0.0 ? 0.0 : e);
+    } else {
+      SIM_World.err[k] = (float)(half+(SIM_World.err[k]-0.5)*SIM_World.res);
+    }
+  }
+  free(mask);
+  free(dIn);
+  return ERR_OK;
+}
+
+/* center line of the built in tracks, closed polygon */
+static int TrackPoints(const char *name, double (*pts)[2], int maxPts) {
+  int i, n = 0;
+  double t, phi, r, len, s;
+
+  if (strcmp(name, "oval")==0) { /* two 1 m straights, 0.3 m radius */
+    const double L = 1.0, R = 0.3;
+    len = 2*L+2*M_PI*R;
+    for(i=0;i<maxPts;i++) {
+      s = len*i/maxPts;
+      if (s<L/2) {                         { pts[i][0] = s; pts[i][1] = -R; }
+      } else if (s<L/2+M_PI*R) {           phi = (s-L/2)/R; pts[i][0] = L/2+R*sin(phi); pts[i][1] = -R*cos(phi);
+      } else if (s<1.5*L+M_PI*R) {         pts[i][0] = L/2-(s-L/2-M_PI*R); pts[i][1] = R;
+      } else if (s<1.5*L+2*M_PI*R) {       phi = (s-1.5*L-M_PI*R)/R; pts[i][0] = -L/2-R*sin(phi); pts[i][1] = R*cos(phi);
+      } else {                             pts[i][0] = -L/2+(s-1.5*L-2*M_PI*R); pts[i][1] = -R;
+      }
+    }
+    n = maxPts;
+  } else if (strcmp(name, "round")==0) { /* circle with 0.5 m radius */
+    for(i=0;i<maxPts;i++) {
+      phi = 2*M_PI*i/maxPts-M_PI/2;
+      pts[i][0] = 0.5*cos(phi); pts[i][1] = 0.5*sin(phi);
+    }
+    n = maxPts;
+  } else if (strcmp(name, "clover")==0) { /* varying curvature with inward bends */
+    for(i=0;i<maxPts;i++) {
+      phi = 2*M_PI*i/maxPts-M_PI/2;
+      r = 0.55+0.12*cos(3*phi);
+      pts[i][0] = r*cos(phi); pts[i][1] = r*sin(phi);
+    }
+    n = maxPts;
+  } else if (strcmp(name, "square")==0) { /* 1.2 m square with 0.15 m corner radius */
+    const double A = 0.6, R = 0.15, S = 2*(A-R);
+    len = 4*S+2*M_PI*R;
+    for(i=0;i<maxPts;i++) {
+      int side;
+
+      s = len*i/maxPts;
+      side = (int)(s/(S+M_PI*R/2));
+      t = s-side*(S+M_PI*R/2);
+      if (t<S) { /* straight, bottom side goes along +x */
+        pts[i][0] = -S/2+t; pts[i][1] = -A;
+      } else { /* corner */
+        phi = (t-S)/R;
+        pts[i][0] = S/2+R*sin(phi); pts[i][1] = -(A-R)-R*cos(phi);
+      }
+      /* rotate by side*90 degree */
+      for(;side>0;side--) {
+        t = pts[i][0];
+        pts[i][0] = -pts[i][1];
+        pts[i][1] = t;
+      }
+    }
+    n = maxPts;
+  }
+  return n;
+}
+
+static uint8_t LoadTrack(const char *name) {
+  #define SIM_TRACK_NOF_PTS 2000
+  static double pts[SIM_TRACK_NOF_PTS][2];
+  double minX = 1e9, minY = 1e9, maxX = -1e9, maxY = -1e9, res = PARAM(P_RES), half = PARAM(P_LINE)/2.0;
+  double x, y, dx, dy, segLen, s;
+  int n, i, px, py, cx, cy, r;
+
+  n = TrackPoints(name, pts, SIM_TRACK_NOF_PTS);
+  if (n==0) {
+    return ERR_FAILED;
+  }
+  for(i=0;i<n;i++) {
+    minX = fmin(minX, pts[i][0]); maxX = fmax(maxX, pts[i][0]);
+    minY = fmin(minY, pts[i][1]); maxY = fmax(maxY, pts[i][1]);
+  }
+  SIM_World.res = res;
+  SIM_World.x0 = minX-SIM_MARGIN_M;
+  SIM_World.y0 = minY-SIM_MARGIN_M;
+  if (AllocWorld((int)((maxX-minX+2*SIM_MARGIN_M)/res)+1, (int)((maxY-minY+2*SIM_MARGIN_M)/res)+1, TRUE)!=ERR_OK) {
+    return ERR_FAILED;
+  }
+  /* draw the line: stamp discs along the center line */
+  r = (int)(half/res);
+  for(i=0;i<n;i++) {
+    dx = pts[(i+1)%n][0]-pts[i][0];
+    dy = pts[(i+1)%n][1]-pts[i][1];
+    segLen = sqrt(dx*dx+dy*dy);
+    for(s=0; s<segLen; s+=res/2) {
+      x = pts[i][0]+dx*s/segLen;
+      y = pts[i][1]+dy*s/segLen;
+      (void)ToPixel(x, y, &cx, &cy);
+      for(py=cy-r; py<=cy+r; py++) {
+        for(px=cx-r; px<=cx+r; px++) {
+          if ((px-cx)*(px-cx)+(py-cy)*(py-cy)<=r*r && px>=0 && px<SIM_World.w && py>=0 && py<SIM_World.h) {
+            SIM_World.dark[py*SIM_World.w+px] = 255;
+          }
+        }
+      }
+    }
+  }
+  SIM_World.startX = pts[0][0];
+  SIM_World.startY = pts[0][1];
+  SIM_World.startTheta = atan2(pts[1][1]-pts[0][1], pts[1][0]-pts[0][0]);
+  return ComputeErrMap();
+}
+
+static uint8_t LoadPGM(const char *fileName) {
+  FILE *f;
+  int w, h, maxVal, k;
+  uint8_t *row;
+
+  f = fopen(fileName, "rb");
+  if (f==NULL) {
+    return ERR_FAILED;
+  }
+  if (fscanf(f, "P5 %d %d %d", &w, &h, &maxVal)!=3 || w<=0 || h<=0 || maxVal<=0 || maxVal>255) {
+    fclose(f);
+    return ERR_FAILED;
+  }
+  (void)fgetc(f); /* single white space after the header */
+  SIM_World.res = PARAM(P_RES);
+  SIM_World.x0 = 0.0;
+  SIM_World.y0 = 0.0;
+  if (AllocWorld(w, h, TRUE)!=ERR_OK) {
+    fclose(f);
+    return ERR_FAILED;
+  }
+  row = malloc(w);
+  for(k=0;k<h && row!=NULL;k++) {
+    int x;
+
+    if (fread(row, 1, w, f)!=(size_t)w) {
+      break;
+    }
+    for(x=0;x<w;x++) { /* image rows go down, the y axis goes up */
+      SIM_World.dark[(h-1-k)*w+x] = (uint8_t)(255-(row[x]*255)/maxVal);
+    }
+  }
+  free(row);
+  fclose(f);
+  if (k!=h) {
+    return ERR_FAILED;
+  }
+  /* no center line known: start in the middle, set startx/starty/startdeg for the real start */
+  SIM_World.startX = w*SIM_World.res/2;
+  SIM_World.startY = h*SIM_World.res/2;
+  SIM_World.startTheta = 0.0;
+  return ComputeErrMap();
+}
+
+static uint8_t LoadArena(void) {
+  double R = PARAM(P_ARENA), res = PARAM(P_RES), r;
+  int px, py;
+
+  SIM_World.res = res;
+  SIM_World.x0 = -R-SIM_MARGIN_M;
+  SIM_World.y0 = -R-SIM_MARGIN_M;
+  if (AllocWorld((int)(2*(R+SIM_MARGIN_M)/res)+1, (int)(2*(R+SIM_MARGIN_M)/res)+1, FALSE)!=ERR_OK) {
+    return ERR_FAILED;
+  }
+  for(py=0;py<SIM_World.h;py++) {
+    for(px=0;px<SIM_World.w;px++) {
+      r = hypot(SIM_World.x0+px*res, SIM_World.y0+py*res);
+      SIM_World.dark[py*SIM_World.w+px] = r<R-SIM_ARENA_BORDER_M ? 255 : 0; /* black ring with white border */
+    }
+  }
+  SIM_World.startX = -R/2;
+  SIM_World.startY = 0.0;
+  SIM_World.startTheta = 0.0;
+  return ERR_OK;
+}
+
+uint8_t SIM_LoadWorld(const char *name) {
+  uint8_t res;
+  size_t len = strlen(name);
+
+  SIM_World.isArena = FALSE;
+  if (strcmp(name, "arena")==0) {
+    SIM_World.isArena = TRUE;
+    res = LoadArena();
+  } else if (len>4 && strcmp(name+len-4, ".pgm")==0) {
+    res = LoadPGM(name);
+  } else {
+    res = LoadTrack(name);
+  }
+  if (res!=ERR_OK) {
+    return res;
+  }
+  UTIL1_strcpy((uint8_t*)SIM_World.name, sizeof(SIM_World.name), (const unsigned char*)name);
+  if (!isnan(PARAM(P_STARTX))) {
+    SIM_World.startX = PARAM(P_STARTX);
+  }
+  if (!isnan(PARAM(P_STARTY))) {
+    SIM_World.startY = PARAM(P_STARTY);
+  }
+  if (!isnan(PARAM(P_STARTDEG))) {
+    SIM_World.startTheta = PARAM(P_STARTDEG)*M_PI/180;
+  }
+  SIM_Robot.oppX = PARAM(P_OPPX);
+  SIM_Robot.oppY = PARAM(P_OPPY);
+  return ERR_OK;
+}
+
+bool SIM_IsArena(void) {
+  return SIM_World.isArena;
+}
+
+/* ------------------------------------ robot ------------------------------------ */
+void SIM_SetPose(double x, double y, double theta) {
+  SIM_Robot.x = x;
+  SIM_Robot.y = y;
+  SIM_Robot.theta = theta;
+  SIM_Robot.v = 0.0;
+  SIM_Robot.omega = 0.0;
+  SIM_Robot.vw[0] = SIM_Robot.vw[1] = 0.0;
+}
+
+void SIM_GetStartPose(double *x, double *y, double *theta) {
+  *theta = SIM_World.startTheta;
+  if (SIM_World.isArena) {
+    *x = SIM_World.startX;
+    *y = SIM_World.startY;
+  } else { /* start point is the sensor array position */
+    *x = SIM_World.startX-cos(*theta)*PARAM(P_IRFWD);
+    *y = SIM_World.startY-sin(*theta)*PARAM(P_IRFWD);
+  }
+}
+
+void SIM_GetCalibPose(double fraction, double *x, double *y, double *theta) {
+  double d;
+
+  if (SIM_World.isArena) { /* from the black ring over the white border, heading outwards */
+    d = PARAM(P_ARENA)-SIM_ARENA_BORDER_M-PARAM(P_IRFWD)-0.05+0.1*fraction;
+    *x = -d;
+    *y = 0.0;
+    *theta = M_PI;
+  } else { /* sideways across the start of the line */
+    SIM_GetStartPose(x, y, theta);
+    d = SIM_CALIB_SWEEP_M*(2.0*fraction-1.0);
+    *x -= sin(*theta)*d;
+    *y += cos(*theta)*d;
+  }
+}
+
+void SIM_Hold(bool hold) {
+  SIM_Robot.held = hold;
+  if (hold) {
+    SIM_SetPose(SIM_Robot.x, SIM_Robot.y, SIM_Robot.theta);
+  }
+}
+
+/* returns -1 if the wiring parameter has the bit of the motor set */
+static double WiringSign(SIM_ParamId id, uint8_t motor) {
+  return ((unsigned)PARAM(id)&(1u<<motor)) ? -1.0 : 1.0;
+}
+
+double SIM_GetEncoderCounts(uint8_t motor) {
+  if (REPLAY_IsActive()) {
+    return REPLAY_GetEncoderCounts(motor);
+  }
+  return WiringSign(P_ENCINV, motor)*SIM_Robot.counts[motor];
+}
+
+uint32_t SIM_GetIrDischargeNs(uint8_t sensor) {
+  double x, y, dark, us;
+
+  if (REPLAY_IsActive()) {
+    return REPLAY_GetIrDischargeNs(sensor);
+  }
+  ToWorld(PARAM(P_IRFWD), (2.5-sensor)*PARAM(P_IRPITCH), &x, &y); /* IR1 is the left sensor */
+  dark = FloorDarkness(x, y, SIM_IR_SPOT_M);
+  us = PARAM(P_IRWHITE)+(PARAM(P_IRBLACK)-PARAM(P_IRWHITE))*dark;
+  us *= 1.0+PARAM(P_IRNOISE)*RandGauss();
+  return us<10.0 ? 10*1000 : (uint32_t)(us*1000.0);
+}
+
+/* distance along a ray to the opponent, or -1 */
+static double RayToOpponent(double x, double y, double dirX, double dirY) {
+  double ox = SIM_Robot.oppX-x, oy = SIM_Robot.oppY-y, r = PARAM(P_OPPR);
+  double b = ox*dirX+oy*dirY, c = ox*ox+oy*oy-r*r, disc = b*b-c, t;
+
+  if (r<=0.0 || disc<0.0) {
+    return -1.0;
+  }
+  t = b-sqrt(disc);
+  return t>=0.0 ? t : -1.0;
+}
+
+int SIM_GetTofRangeMm(uint8_t slot) {
+  const SIM_TofMount *m = &SIM_Tof[slot];
+  double x, y, dir, d, best = -1.0;
+  int k;
+
+  if (REPLAY_IsActive()) {
+    return REPLAY_GetTofRangeMm(slot);
+  }
+  if (!m->fitted) {
+    return SIM_TOF_NOT_FITTED;
+  }
+  ToWorld(m->x, m->y, &x, &y);
+  for(k=0;k<SIM_TOF_NOF_RAYS;k++) {
+    dir = SIM_Robot.theta+m->heading+SIM_TOF_CONE_DEG*M_PI/180*(2.0*k/(SIM_TOF_NOF_RAYS-1)-1.0);
+    d = RayToOpponent(x, y, cos(dir), sin(dir));
+    if (d>=0.0 && (best<0.0 || d<best)) {
+      best = d;
+    }
+  }
+  if (best<0.0) {
+    return -1; /* no target */
+  }
+  best += PARAM(P_TOFNOISE)*RandGauss();
+  return best<0.0 ? 0 : (int)(best*1000.0);
+}
+
+uint16_t SIM_GetTofAmbient(uint8_t slot) {
+  (void)slot;
+  return 200; /* indoor light */
+}
+
+void SIM_GetRobotUID(KIN1_UID *uid) {
+  /* any robot: the wiring comes from the hardware profile */
+  static const KIN1_UID id = {{0x00,0x17,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x4E,0x45,0x27,0x99,0x10,0x02,0x00,0x06}};
+
+  *uid = id;
+}
+
+static void Integrate(void) {
+  double arm = PARAM(P_CHI)*PARAM(P_BASE)/2.0; /* effective lever of the track forces */
+  double fMax = PARAM(P_MU)*PARAM(P_MASS)*SIM_G/2.0; /* per track */
+  double f[2], vg, slip, fx, nx, ny, d, overlap, fOpp;
+  int i;
+
+  for(i=0;i<2;i++) {
+    vg = SIM_Robot.v+(i==SIMHW_LEFT ? -1.0 : 1.0)*SIM_Robot.omega*arm; /* ground speed under the track */
+    slip = SIM_Robot.vw[i]-vg;
+    f[i] = PARAM(P_STIFF)*slip;
+    if (f[i]>fMax) {
+      f[i] = fMax;
+    } else if (f[i]<-fMax) {
+      f[i] = -fMax;
+    }
+    SIM_Robot.vw[i] += ((WiringSign(P_MOTINV, i)*SIMHW_GetMotorInput(i)*PARAM(P_VMAX)-SIM_Robot.vw[i])/PARAM(P_TAU)-f[i]/PARAM(P_ROTOR))*SIM_DT;
+    SIM_Robot.counts[i] += SIM_Robot.vw[i]*SIM_DT*PARAM(P_COUNTS);
+  }
+  fx = f[0]+f[1];
+  /* contact with the opponent: it resists with its friction and gets pushed away */
+  if (PARAM(P_OPPR)>0.0) {
+    nx = SIM_Robot.oppX-SIM_Robot.x;
+    ny = SIM_Robot.oppY-SIM_Robot.y;
+    d = hypot(nx, ny);
+    overlap = SIM_ROBOT_RADIUS_M+PARAM(P_OPPR)-d;
+    if (overlap>0.0 && d>0.0) {
+      nx /= d; ny /= d;
+      fOpp = PARAM(P_OPPMU)*PARAM(P_OPPMASS)*SIM_G;
+      fx -= fOpp*(nx*cos(SIM_Robot.theta)+ny*sin(SIM_Robot.theta));
+      SIM_Robot.oppX += nx*overlap;
+      SIM_Robot.oppY += ny*overlap;
+    }
+  }
+  SIM_Robot.v += (fx/PARAM(P_MASS)-PARAM(P_ROLL)*SIM_Robot.v)*SIM_DT;
+  SIM_Robot.omega += ((f[1]-f[0])*arm/PARAM(P_INERTIA)-PARAM(P_ROLL)*SIM_Robot.omega)*SIM_DT;
+  SIM_Robot.x += SIM_Robot.v*cos(SIM_Robot.theta)*SIM_DT;
+  SIM_Robot.y += SIM_Robot.v*sin(SIM_Robot.theta)*SIM_DT;
+  SIM_Robot.theta += SIM_Robot.omega*SIM_DT;
+  SIM_Metric.distance += fabs(SIM_Robot.v)*SIM_DT;
+  SIM_Lap.lapDistance += fabs(SIM_Robot.v)*SIM_DT;
+}
+
+/* ------------------------------------ metrics ------------------------------------ */
+void SIM_StartMetrics(void) {
+  memset(&SIM_Metric, 0, sizeof(SIM_Metric));
+  SIM_Lap.on = TRUE;
+  SIM_Lap.startTick = SIM_Lap.tick;
+  SIM_Lap.lapStartTick = SIM_Lap.tick;
+  SIM_Lap.lastGateS = 0.0;
+  SIM_Lap.lapDistance = 0.0;
+  SIM_Stop = FALSE;
+}
+
+const SIM_Metrics *SIM_GetMetrics(void) {
+  return &SIM_Metric;
+}
+
+static void UpdateLineMetrics(void) {
+  double x, y, err, s, lat, hx = cos(SIM_World.startTheta), hy = sin(SIM_World.startTheta);
+  int px, py;
+  uint32_t lapMs;
+
+  ToWorld(PARAM(P_IRFWD), 0.0, &x, &y); /* sensor array center */
+  if (!ToPixel(x, y, &px, &py)) {
+    SIM_Metric.lost = TRUE;
+    return;
+  }
+  err = SIM_World.err[py*SIM_World.w+px];
+  SIM_Metric.errSumSq += err*err;
+  SIM_Metric.nofErrSamples++;
+  if (err>SIM_Metric.errMax) {
+    SIM_Metric.errMax = err;
+  }
+  if (err>PARAM(P_LINE)/2.0) {
+    SIM_Metric.offLineMs++;
+  }
+  if (err>PARAM(P_LOST)) {
+    SIM_Metric.lost = TRUE;
+  }
+  /* lap: crossing the start line in the start direction */
+  s = (x-SIM_World.startX)*hx+(y-SIM_World.startY)*hy;
+  lat = -(x-SIM_World.startX)*hy+(y-SIM_World.startY)*hx;
+  if (SIM_Lap.lastGateS<0.0 && s>=0.0 && fabs(lat)<SIM_LAP_GATE_M && SIM_Lap.lapDistance>SIM_LAP_MIN_M) {
+    lapMs = SIM_Lap.tick-SIM_Lap.lapStartTick;
+    if (SIM_Metric.nofLaps<sizeof(SIM_Metric.lapMs)/sizeof(SIM_Metric.lapMs[0])) {
+      SIM_Metric.lapMs[SIM_Metric.nofLaps] = lapMs;
+    }
+    if (SIM_Metric.bestLapMs==0 || lapMs<SIM_Metric.bestLapMs) {
+      SIM_Metric.bestLapMs = lapMs;
+    }
+    SIM_Metric.nofLaps++;
+    SIM_Lap.lapStartTick = SIM_Lap.tick;
+    SIM_Lap.lapDistance = 0.0;
+  }
+  SIM_Lap.lastGateS = s;
+}
+
+static void UpdateArenaMetrics(void) {
+  double R = PARAM(P_ARENA);
+
+  if (hypot(SIM_Robot.x, SIM_Robot.y)>R) {
+    SIM_Metric.lost = TRUE; /* robot left the arena */
+  }
+  if (PARAM(P_OPPR)>0.0 && !SIM_Metric.opponentOut && hypot(SIM_Robot.oppX, SIM_Robot.oppY)>R) {
+    SIM_Metric.opponentOut = TRUE;
+    SIM_Metric.opponentOutMs = SIM_Metric.timeMs;
+  }
+}
+
+void SIM_Step(uint32_t tick) {
+  int i;
+
+  SIM_Lap.tick = tick;
+  if (REPLAY_IsActive()) { /* sensor values come from the recording, the model is not used */
+    if (!REPLAY_Step(tick)) {
+      SIM_Stop = TRUE;
+    }
+    return;
+  }
+  if (!SIM_Robot.held) {
+    for(i=0;i<SIM_SUBSTEPS;i++) {
+      Integrate();
+    }
+  }
+  if (!SIM_Lap.on || SIM_World.dark==NULL) {
+    return;
+  }
+  SIM_Metric.timeMs = tick-SIM_Lap.startTick;
+  if (SIM_World.isArena) {
+    UpdateArenaMetrics();
+  } else {
+    UpdateLineMetrics();
+  }
+  if (SIM_Metric.lost || SIM_Metric.opponentOut) {
+    SIM_Stop = TRUE;
+  }
+}
+
+/* ------------------------------------ shell ------------------------------------ */
+static void SIM_PrintHelp(const CLS1_StdIOType *io) {
+  int i;
+  uint8_t buf[96];
+
+  CLS1_SendHelpStr((unsigned char*)"sim", (unsigned char*)"Group of simulator model commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  tof <slot> <x> <y> <deg>", (unsigned char*)"Mount a ToF sensor (slot 0..3 is CE1..CE4), position in m\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  tof <slot> none", (unsigned char*)"Remove a ToF sensor\r\n", io->stdOut);
+  for(i=0;i<P_NOF_PARAMS;i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"  ");
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)SIM_Params[i].name);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" <value>");
+    CLS1_SendHelpStr(buf, (unsigned char*)SIM_Params[i].help, io->stdOut);
+    CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+  }
+}
+
+static void SIM_PrintStatus(const CLS1_StdIOType *io) {
+  char buf[96];
+  int i;
+
+  CLS1_SendStatusStr((unsigned char*)"sim", (unsigned char*)"\r\n", io->stdOut);
+  snprintf(buf, sizeof(buf), "%s, %dx%d pixel\r\n", SIM_World.name[0]!='\0' ? SIM_World.name : "none", SIM_World.w, SIM_World.h);
+  CLS1_SendStatusStr((unsigned char*)"  world", (unsigned char*)buf, io->stdOut);
+  snprintf(buf, sizeof(buf), "x %.3f m, y %.3f m, %.1f deg%s\r\n", SIM_Robot.x, SIM_Robot.y, SIM_Robot.theta*180/M_PI, SIM_Robot.held ? " (held)" : "");
+  CLS1_SendStatusStr((unsigned char*)"  pose", (unsigned char*)buf, io->stdOut);
+  snprintf(buf, sizeof(buf), "%.3f m/s, %.2f rad/s, tracks L %.3f R %.3f m/s\r\n", SIM_Robot.v, SIM_Robot.omega, SIM_Robot.vw[0], SIM_Robot.vw[1]);
+  CLS1_SendStatusStr((unsigned char*)"  speed", (unsigned char*)buf, io->stdOut);
+  snprintf(buf, sizeof(buf), "%u ms, %u laps, best %u ms, max err %.1f mm\r\n", (unsigned)SIM_Metric.timeMs, (unsigned)SIM_Metric.nofLaps, (unsigned)SIM_Metric.bestLapMs, SIM_Metric.errMax*1000);
+  CLS1_SendStatusStr((unsigned char*)"  metrics", (unsigned char*)buf, io->stdOut);
+  for(i=0;i<P_NOF_PARAMS;i++) {
+    snprintf(buf, sizeof(buf), "  %s", SIM_Params[i].name);
+    CLS1_SendStatusStr((unsigned char*)buf, (unsigned char*)"", io->stdOut);
+    snprintf(buf, sizeof(buf), "%g\r\n", SIM_Params[i].val);
+    CLS1_SendStr((unsigned char*)buf, io->stdOut);
+  }
+}
+
+static uint8_t ParseTof(const char *args, const CLS1_StdIOType *io) {
+  int slot, n;
+  double x, y, deg;
+  char rest[8];
+
+  if (sscanf(args, "%d %7s", &slot, rest)==2 && strcmp(rest, "none")==0 && slot>=0 && slot<SIMHW_NOF_TOF) {
+    SIM_Tof[slot].fitted = FALSE;
+    return ERR_OK;
+  }
+  n = sscanf(args, "%d %lf %lf %lf", &slot, &x, &y, &deg);
+  if (n!=4 || slot<0 || slot>=SIMHW_NOF_TOF) {
+    CLS1_SendStr((unsigned char*)"*** wrong ToF mounting\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  SIM_Tof[slot].fitted = TRUE;
+  SIM_Tof[slot].x = x;
+  SIM_Tof[slot].y = y;
+  SIM_Tof[slot].heading = deg*M_PI/180;
+  return ERR_OK;
+}
+
+uint8_t SIM_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  const char *p;
+  char *end;
+  size_t len;
+  double val;
+  int i;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"sim help")==0) {
+    SIM_PrintHelp(io);
+    *handled = TRUE;
+    return ERR_OK;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"sim status")==0) {
+    SIM_PrintStatus(io);
+    *handled = TRUE;
+    return ERR_OK;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"sim tof ", sizeof("sim tof ")-1)==0) {
+    *handled = TRUE;
+    return ParseTof((const char*)cmd+sizeof("sim tof ")-1, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"sim ", sizeof("sim ")-1)==0) {
+    p = (const char*)cmd+sizeof("sim ")-1;
+    for(i=0;i<P_NOF_PARAMS;i++) {
+      len = strlen(SIM_Params[i].name);
+      if (strncmp(p, SIM_Params[i].name, len)==0 && p[len]==' ') {
+        val = strtod(p+len+1, &end);
+        if (end==p+len+1) {
+          CLS1_SendStr((unsigned char*)"*** wrong value\r\n", io->stdErr);
+          return ERR_FAILED;
+        }
+        SIM_Params[i].val = val;
+        if (i==P_SEED) {
+          SIM_RandState = (uint32_t)val!=0 ? (uint32_t)val : 1;
+        }
+        *handled = TRUE;
+        return ERR_OK;
+      }
+    }
+  }
+  return ERR_OK;
+}
+
+void SIM_Init(void) {
+  memset(&SIM_Robot, 0, sizeof(SIM_Robot));
+  memset(&SIM_Metric, 0, sizeof(SIM_Metric));
+  memset(&SIM_Lap, 0, sizeof(SIM_Lap));
+  SIM_RandState = (uint32_t)PARAM(P_SEED);
+}
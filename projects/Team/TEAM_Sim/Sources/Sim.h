@@ -0,0 +1,99 @@
+/**
+ * \file
+ * \brief Interface of the robot and world model of the simulator.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The world is a floor bitmap (line track or sumo arena) with optional round obstacles (opponents)
+ * for the ToF sensors. The robot is a tracked differential drive: each track is driven by a motor
+ * with first order dynamics, the ground force of a track is proportional to its slip and limited
+ * by the friction, and the encoders count the track (not the ground) motion.
+ * Units are meters, seconds and radians.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "PE_Types.h"
+#include "CLS1.h"
+
+/*! \brief Metrics of a run, updated every tick */
+typedef struct {
+  uint32_t timeMs;          /*!< simulated time since the start of the run */
+  uint32_t nofLaps;         /*!< number of completed laps */
+  uint32_t lapMs[16];       /*!< lap times of the first laps */
+  uint32_t bestLapMs;       /*!< best lap time, 0 if no lap completed */
+  double errSumSq;          /*!< sum of the squared tracking errors (m^2) */
+  double errMax;            /*!< maximum tracking error (m) */
+  uint32_t nofErrSamples;   /*!< number of tracking error samples */
+  uint32_t offLineMs;       /*!< time with the sensor array not over the line */
+  double distance;          /*!< driven distance of the robot center (m) */
+  bool lost;                /*!< robot lost the line or left the arena: run ended */
+  bool opponentOut;         /*!< opponent pushed out of the arena */
+  uint32_t opponentOutMs;   /*!< time when the opponent has been pushed out */
+} SIM_Metrics;
+
+/*!
+ * \brief Loads the world.
+ * \param name Name of a built in track (oval, round, clover, square), "arena" for a sumo arena or the path of a PGM file (dark pixels are the line).
+ * \return ERR_OK if the world has been loaded.
+ */
+uint8_t SIM_LoadWorld(const char *name);
+
+/*! \brief Returns TRUE if the world is a sumo arena */
+bool SIM_IsArena(void);
+
+/*!
+ * \brief Places the robot, with the track and motor states at rest.
+ * \param x Position of the robot center.
+ * \param y Position of the robot center.
+ * \param theta Heading, 0 is along the x axis.
+ */
+void SIM_SetPose(double x, double y, double theta);
+
+/*! \brief Returns the start pose of the robot (sensor array on the start of the line, or the arena start position) */
+void SIM_GetStartPose(double *x, double *y, double *theta);
+
+/*!
+ * \brief Returns a pose of the calibration sweep, which moves the sensors across the line (or the arena border).
+ * \param fraction Position in the sweep, 0.0 to 1.0.
+ */
+void SIM_GetCalibPose(double fraction, double *x, double *y, double *theta);
+
+/*!
+ * \brief Holds the robot: while held, the motors have no effect and the pose is only changed with SIM_SetPose().
+ * Used to move the robot over the line during the reflectance sensor calibration.
+ * \param hold TRUE to hold the robot, FALSE to release it.
+ */
+void SIM_Hold(bool hold);
+
+/*! \brief Starts the measurement of the metrics (lap timing, tracking error) from the current pose */
+void SIM_StartMetrics(void);
+
+/*! \brief Returns the metrics of the run */
+const SIM_Metrics *SIM_GetMetrics(void);
+
+/*!
+ * \brief Advances the model by one RTOS tick, called from the tick hook.
+ * \param tick Current tick count.
+ */
+void SIM_Step(uint32_t tick);
+
+/*! \brief If set, the shell output goes to stderr */
+extern bool SIM_Verbose;
+
+/*! \brief Set if the run has to end (lost line, left the arena, opponent out), checked by the scheduler */
+extern volatile bool SIM_Stop;
+
+/*!
+ * \brief Shell parser routine for the model parameters ("sim ...").
+ * \param cmd Pointer to command line string.
+ * \param handled Pointer to status if command has been handled. Set to TRUE if command was understood.
+ * \param io Pointer to stdio handle
+ * \return Error code, ERR_OK if everything was ok.
+ */
+uint8_t SIM_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+
+/*! \brief Initializes the model with the default parameters */
+void SIM_Init(void);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,178 @@
+/**
+ * \file
+ * \brief Shell of the simulator: the same command parsers as on the robot, fed from the command line.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Output goes to stderr if verbose mode is on, otherwise it is dropped, so stdout only carries the results.
+ */
+
+#include "Platform.h"
+#include "Shell.h"
+#include "CLS1.h"
+#include "Sim.h"
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
+#include <stdio.h>
+#if PL_CONFIG_HAS_REFLECTANCE
+  #include "Reflectance.h"
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  #include "Motor.h"
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+#endif
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  #include "Tacho.h"
+#endif
+#if PL_CONFIG_HAS_PID
+  #include "Pid.h"
+#endif
+#if PL_CONFIG_HAS_DRIVE
+  #include "Drive.h"
+#endif
+#if PL_CONFIG_HAS_TURN
+  #include "Turn.h"
+#endif
+#if PL_CONFIG_HAS_SUMO
+  #include "Sumo.h"
+#endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  #include "ArenaLoc.h"
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  #include "LineFollow.h"
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  #include "SpeedPlan.h"
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+#endif
+#if PL_HAS_DISTANCE_SENSOR
+  #include "Distance.h"
+#endif
+#if PL_CONFIG_HAS_LINE_MAZE
+  #include "Maze.h"
+#endif
+#if PL_CONFIG_HAS_RECORDER
+  #include "Recorder.h"
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  #include "Obstacle.h"
+#endif
+
+static void SIMSHELL_SendChar(uint8_t ch) {
+  if (SIM_Verbose && ch!='\r') {
+    (void)fputc(ch, stderr);
+  }
+}
+
+static void SIMSHELL_ReadChar(uint8_t *ch) {
+  *ch = '\0'; /* no interactive input */
+}
+
+static bool SIMSHELL_KeyPressed(void) {
+  return FALSE;
+}
+
+static CLS1_ConstStdIOType SIMSHELL_stdio = {
+  .stdIn = SIMSHELL_ReadChar,
+  .stdOut = SIMSHELL_SendChar,
+  .stdErr = SIMSHELL_SendChar,
+  .keyPressed = SIMSHELL_KeyPressed,
+};
+
+static const CLS1_ParseCommandCallback CmdParserTable[] =
+{
+  SIM_ParseCommand, /* model parameters */
+#if PL_CONFIG_HAS_REFLECTANCE
+  REF_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  MOT_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  HWP_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  TACHO_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_PID
+  PID_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_DRIVE
+  DRV_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_TURN
+  TURN_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_SUMO
+  SUMO_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  ALOC_ParseCommand,
+#endif
+#if PL_HAS_DISTANCE_SENSOR
+  DIST_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  LF_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  SPLAN_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  TMAP_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  LAPT_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  CTRL_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LINE_MAZE
+  MAZE_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_RECORDER
+  REC_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  OBST_ParseCommand,
+#endif
+  NULL /* Sentinel */
+};
+
+CLS1_ConstStdIOType *SHELL_GetStdio(void) {
+  return &SIMSHELL_stdio;
+}
+
+void SHELL_ParseCmd(uint8_t *cmd) {
+  bool handled = FALSE;
+
+  (void)CLS1_IterateTable(cmd, &handled, &SIMSHELL_stdio, CmdParserTable);
+  if (!handled) {
+    (void)fprintf(stderr, "*** unknown command '%s'\n", (char*)cmd);
+  }
+}
+
+void SHELL_SendString(unsigned char *msg) {
+  CLS1_SendStr(msg, SIMSHELL_stdio.stdOut);
+}
+
+void SHELL_Init(void) {
+  /* nothing to do: commands are parsed in the context of the caller */
+}
+
+void SHELL_Deinit(void) {
+}
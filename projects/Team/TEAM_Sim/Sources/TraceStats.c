@@ -0,0 +1,294 @@
+/**
+ * \file
+ * \brief Evaluation of RTOS trace streams, see TraceStats.h.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The time stamps wrap around (32bit cycle counter), they are extended to 64bit assuming that two
+ * records are less than one wrap apart. For each user event:
+ *   period: time between two begin records, its standard deviation is the jitter,
+ *   exec:   time from the begin to the end record (including preemptions),
+ *   start:  time from the last RTOS tick to the begin record, the release latency of a tick driven loop.
+ * After dropped records the open intervals are discarded, so a gap does not show up as a long period.
+ */
+
+#include "Platform.h"
+#include "TraceStats.h"
+#if PL_CONFIG_HAS_RTOS_TRACE
+#include "RtosTrace.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TSTAT_MAX_IDS    256 /* ids are 8bit */
+#define TSTAT_NAME_SIZE  16
+
+/*! \brief Running statistics of a time interval, in clock cycles */
+typedef struct {
+  uint32_t n;
+  double sum, sumSq;
+  uint64_t min, max;
+} TSTAT_Stat;
+
+typedef struct {
+  char name[TSTAT_NAME_SIZE];
+  uint64_t begin, lastBegin; /* 0: none */
+  uint32_t nofMarks;
+  TSTAT_Stat period, exec, start;
+} TSTAT_Event;
+
+typedef struct {
+  char name[TSTAT_NAME_SIZE];
+  uint64_t enter;            /* 0: none */
+  uint16_t divider;
+  TSTAT_Stat duration;
+} TSTAT_Isr;
+
+typedef struct {
+  char name[TSTAT_NAME_SIZE];
+  uint32_t nofSwitches;
+  uint64_t cycles;           /* time running */
+} TSTAT_Task;
+
+static TSTAT_Event TSTAT_Events[TSTAT_MAX_IDS];
+static TSTAT_Isr TSTAT_Isrs[TSTAT_MAX_IDS];
+static TSTAT_Task TSTAT_Tasks[TSTAT_MAX_IDS];
+
+static void StatAdd(TSTAT_Stat *s, uint64_t val) {
+  if (s->n==0 || val<s->min) {
+    s->min = val;
+  }
+  if (s->n==0 || val>s->max) {
+    s->max = val;
+  }
+  s->n++;
+  s->sum += (double)val;
+  s->sumSq += (double)val*(double)val;
+}
+
+static double StatAvg(const TSTAT_Stat *s) {
+  return s->n>0 ? s->sum/s->n : 0.0;
+}
+
+static double StatStdDev(const TSTAT_Stat *s) {
+  double avg = StatAvg(s), var;
+
+  if (s->n<2) {
+    return 0.0;
+  }
+  var = s->sumSq/s->n-avg*avg;
+  return var>0.0 ? sqrt(var) : 0.0;
+}
+
+static uint32_t GetU32(const uint8_t *p) {
+  return (uint32_t)p[0]|((uint32_t)p[1]<<8)|((uint32_t)p[2]<<16)|((uint32_t)p[3]<<24);
+}
+
+/* forgets the open intervals, after a gap in the stream */
+static void ResetOpen(void) {
+  int i;
+
+  for(i=0;i<TSTAT_MAX_IDS;i++) {
+    TSTAT_Events[i].begin = TSTAT_Events[i].lastBegin = 0;
+    TSTAT_Isrs[i].enter = 0;
+  }
+}
+
+static void SetName(char *dst, const uint8_t *src, unsigned len) {
+  if (len>TSTAT_NAME_SIZE-1) {
+    len = TSTAT_NAME_SIZE-1;
+  }
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+static void PrintUs(FILE *out, double cycles, double cyclesPerUs) {
+  (void)fprintf(out, " %9.1f", cycles/cyclesPerUs);
+}
+
+uint8_t TSTAT_Analyze(const char *fileName, FILE *out) {
+  FILE *f;
+  uint8_t *buf, *rec;
+  long size;
+  size_t pos, nofRecords = 0;
+  uint32_t raw, lastRaw = 0, clockHz = 0, dropped = 0;
+  uint64_t t, base = 0, first = 0, last = 0, lastTick = 0, taskStart = 0;
+  int curTask = -1, i;
+  unsigned len;
+  double cyclesPerUs;
+  TSTAT_Event *e;
+  TSTAT_Isr *isr;
+
+  f = fopen(fileName, "rb");
+  if (f==NULL) {
+    return ERR_FAILED;
+  }
+  (void)fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  (void)fseek(f, 0, SEEK_SET);
+  buf = malloc(size>0 ? (size_t)size : 1);
+  if (buf==NULL || fread(buf, 1, (size_t)size, f)!=(size_t)size) {
+    free(buf);
+    (void)fclose(f);
+    return ERR_FAILED;
+  }
+  (void)fclose(f);
+  memset(TSTAT_Events, 0, sizeof(TSTAT_Events));
+  memset(TSTAT_Isrs, 0, sizeof(TSTAT_Isrs));
+  memset(TSTAT_Tasks, 0, sizeof(TSTAT_Tasks));
+  for(pos=0; pos+sizeof(RTRC_Record)<=(size_t)size; pos+=sizeof(RTRC_Record)) {
+    rec = &buf[pos];
+    raw = GetU32(rec);
+    if (rec[4]==RTRC_REC_HEADER) {
+      if (rec[5]!=RTRC_FORMAT_VERSION || (rec[6]|(rec[7]<<8))!=RTRC_HEADER_MAGIC) {
+        break; /* not a trace */
+      }
+      clockHz = raw; /* a restart of the trace: same clock, but the intervals are interrupted */
+      ResetOpen();
+      curTask = -1;
+      continue;
+    }
+    if (clockHz==0) {
+      break; /* has to start with a header */
+    }
+    if (rec[4]==RTRC_REC_NAME) {
+      len = rec[6];
+      if (pos+sizeof(RTRC_Record)+len>(size_t)size) {
+        break;
+      }
+      if (rec[7]==RTRC_NAME_TASK) {
+        SetName(TSTAT_Tasks[rec[5]].name, rec+sizeof(RTRC_Record), len);
+      } else if (rec[7]==RTRC_NAME_EVENT) {
+        SetName(TSTAT_Events[rec[5]].name, rec+sizeof(RTRC_Record), len);
+      } else if (rec[7]==RTRC_NAME_ISR) {
+        SetName(TSTAT_Isrs[rec[5]].name, rec+sizeof(RTRC_Record), len);
+      }
+      pos += (len+sizeof(RTRC_Record)-1)/sizeof(RTRC_Record)*sizeof(RTRC_Record); /* skip the name */
+      continue;
+    }
+    if (raw<lastRaw) {
+      base += 0x100000000ULL; /* wrap around */
+    }
+    lastRaw = raw;
+    t = base+raw;
+    if (nofRecords==0) {
+      first = t;
+    }
+    last = t;
+    nofRecords++;
+    switch(rec[4]) {
+      case RTRC_REC_TASK:
+        if (curTask>=0) {
+          TSTAT_Tasks[curTask].cycles += t-taskStart;
+        }
+        curTask = rec[5];
+        taskStart = t;
+        TSTAT_Tasks[curTask].nofSwitches++;
+        break;
+      case RTRC_REC_ISR_ENTER:
+        isr = &TSTAT_Isrs[rec[5]];
+        isr->enter = t;
+        isr->divider = (uint16_t)(rec[6]|(rec[7]<<8));
+        break;
+      case RTRC_REC_ISR_EXIT:
+        isr = &TSTAT_Isrs[rec[5]];
+        if (isr->enter!=0) {
+          StatAdd(&isr->duration, t-isr->enter);
+          isr->enter = 0;
+        }
+        break;
+      case RTRC_REC_USER_BEGIN:
+        e = &TSTAT_Events[rec[5]];
+        if (e->lastBegin!=0) {
+          StatAdd(&e->period, t-e->lastBegin);
+        }
+        if (lastTick!=0) {
+          StatAdd(&e->start, t-lastTick);
+        }
+        e->begin = e->lastBegin = t;
+        break;
+      case RTRC_REC_USER_END:
+        e = &TSTAT_Events[rec[5]];
+        if (e->begin!=0) {
+          StatAdd(&e->exec, t-e->begin);
+          e->begin = 0;
+        }
+        break;
+      case RTRC_REC_USER_MARK:
+        TSTAT_Events[rec[5]].nofMarks++;
+        break;
+      case RTRC_REC_TICK:
+        lastTick = t;
+        break;
+      case RTRC_REC_DROPPED:
+        dropped += (uint32_t)(rec[6]|(rec[7]<<8));
+        ResetOpen();
+        lastTick = 0;
+        curTask = -1; /* the time until the next switch is unknown */
+        break;
+      default:
+        break;
+    }
+  }
+  free(buf);
+  if (clockHz==0) {
+    return ERR_FAILED;
+  }
+  if (curTask>=0) {
+    TSTAT_Tasks[curTask].cycles += last-taskStart;
+  }
+  cyclesPerUs = clockHz/1e6;
+  (void)fprintf(out, "trace %s: %u records, %.1f ms, clock %u Hz, %u dropped\n",
+    fileName, (unsigned)nofRecords, (last-first)/cyclesPerUs/1000.0, (unsigned)clockHz, (unsigned)dropped);
+  (void)fprintf(out, "\nevent           count  period us  jitter us  min us     max us    exec us    exec max   start us   start max\n");
+  for(i=0;i<TSTAT_MAX_IDS;i++) {
+    e = &TSTAT_Events[i];
+    if (e->period.n==0 && e->exec.n==0 && e->nofMarks==0) {
+      continue;
+    }
+    (void)fprintf(out, "%-14s %6u", e->name[0]!='\0' ? e->name : "?", (unsigned)(e->exec.n>0 ? e->exec.n : e->nofMarks));
+    if (e->period.n==0) {
+      (void)fprintf(out, "  (marks)\n");
+      continue;
+    }
+    PrintUs(out, StatAvg(&e->period), cyclesPerUs);
+    PrintUs(out, StatStdDev(&e->period), cyclesPerUs);
+    PrintUs(out, (double)e->period.min, cyclesPerUs);
+    PrintUs(out, (double)e->period.max, cyclesPerUs);
+    PrintUs(out, StatAvg(&e->exec), cyclesPerUs);
+    PrintUs(out, (double)e->exec.max, cyclesPerUs);
+    PrintUs(out, StatAvg(&e->start), cyclesPerUs);
+    PrintUs(out, (double)e->start.max, cyclesPerUs);
+    (void)fprintf(out, "\n");
+  }
+  (void)fprintf(out, "\ninterrupt       count    rate Hz    avg us     max us\n");
+  for(i=0;i<TSTAT_MAX_IDS;i++) {
+    isr = &TSTAT_Isrs[i];
+    if (isr->duration.n==0) {
+      continue;
+    }
+    (void)fprintf(out, "%-14s %6u %10.0f", isr->name[0]!='\0' ? isr->name : "?", (unsigned)(isr->duration.n*isr->divider),
+      last>first ? isr->duration.n*isr->divider*(double)clockHz/(double)(last-first) : 0.0);
+    PrintUs(out, StatAvg(&isr->duration), cyclesPerUs);
+    PrintUs(out, (double)isr->duration.max, cyclesPerUs);
+    (void)fprintf(out, "\n");
+  }
+  (void)fprintf(out, "\ntask          switches   cpu %%\n");
+  for(i=0;i<TSTAT_MAX_IDS;i++) {
+    if (TSTAT_Tasks[i].nofSwitches==0) {
+      continue;
+    }
+    (void)fprintf(out, "%-14s %7u %7.1f\n", TSTAT_Tasks[i].name[0]!='\0' ? TSTAT_Tasks[i].name : "?",
+      (unsigned)TSTAT_Tasks[i].nofSwitches, last>first ? 100.0*TSTAT_Tasks[i].cycles/(double)(last-first) : 0.0);
+  }
+  return ERR_OK;
+}
+
+#else
+
+uint8_t TSTAT_Analyze(const char *fileName, FILE *out) {
+  (void)fileName;
+  (void)fprintf(out, "RTOS trace is disabled in this configuration\n");
+  return ERR_FAILED;
+}
+
+#endif /* PL_CONFIG_HAS_RTOS_TRACE */
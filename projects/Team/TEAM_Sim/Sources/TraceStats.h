@@ -0,0 +1,26 @@
+/**
+ * \file
+ * \brief Interface of the evaluation of RTOS trace streams.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Reads a stream of the RtosTrace module (see RtosTrace.h), as captured from the robot with
+ * JLinkRTTLogger or written by the simulator with -T, and prints the statistics of the control loops:
+ * period and jitter of the user events, their execution time and how long after the RTOS tick they
+ * have started, the duration and rate of the interrupts and the CPU share of the tasks.
+ */
+
+#ifndef TRACESTATS_H_
+#define TRACESTATS_H_
+
+#include "PE_Types.h"
+#include <stdio.h>
+
+/*!
+ * \brief Evaluates a trace stream.
+ * \param fileName Path of the file with the binary stream.
+ * \param out Where the statistics are printed.
+ * \return ERR_OK, ERR_FAILED if the file cannot be read or is not a trace stream.
+ */
+uint8_t TSTAT_Analyze(const char *fileName, FILE *out);
+
+#endif /* TRACESTATS_H_ */
@@ -0,0 +1,617 @@
+/**
+ * \file
+ * \brief Simulator main program: runs the robot modules against the model and prints the metrics.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The robot modules of TEAM_Common are compiled unchanged for the host, with Sim_Code replacing the
+ * Processor Expert components. Build from the TEAM_Sim folder with:
+ *   gcc -O2 -o sim -ISources -ISim_Code -I../TEAM_Common <all .c files of Sources and Sim_Code> \
+ *     ../TEAM_Common/{Motor,Tacho,Pid,Drive,Reflectance,LineFollow,Turn,Maze,Distance,VL6180X,Sumo,Recorder,Obstacle,HwProfile,RtosTrace,ControlLoop,SpeedPlan,TrackMap,ArenaLoc,LapTime,MemPool,TimeSync,LCDDirty,LCDMenu}.c -lpthread -lm
+ *
+ * Usage: sim [options]
+ *   -w <world>    oval (default), round, clover, square, arena or a .pgm file
+ *   -m <mode>     follow (default for tracks), sumo (default for the arena) or idle
+ *   -t <seconds>  simulated run time, default 30
+ *   -l <laps>     end the line following run after this number of laps, default 0 (run time only)
+ *   -c "<cmd>"    shell command executed before the run, e.g. -c "pid fw p 300" or -c "sim mu 0.6"
+ *   -s "<cmd>"    parameter sweep: a shell command with one {from:to:step} range, e.g. -s "pid fw p {100:500:100}".
+ *                 A range has at most 64 values. Several sweeps run all combinations.
+ *   -j <jobs>     number of runs executed in parallel, default 1
+ *   -d <file>     record the run (see Recorder.h) and write the dump to the file, for a single run
+ *   -r <file>     replay a recording (output of 'rec dump') instead of simulating the world, see Replay.h
+ *   -T <file>     stream the RTOS trace of the run into the file (see RtosTrace.h), for a single run
+ *   -a <file>     print the loop, interrupt and task statistics of a trace (of the robot or of -T) and exit
+ *   -b <bench>    run a host benchmark or stress test of a module and exit, see Bench.h ('-b list' shows them)
+ *   -v            verbose: shell output to stderr
+ * Results are printed as one CSV line per run to stdout. A replay prints the outputs of the robot
+ * code (line value, speeds, motor inputs) every 10 ms, to compare versions with diff.
+ */
+
+#include "Platform.h"
+#include "FRTOS1.h"
+#include "Shell.h"
+#include "Sim.h"
+#include "SimHw.h"
+#include "Replay.h"
+#include "TraceStats.h"
+#include "Bench.h"
+#include "UTIL1.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#if PL_CONFIG_HAS_REFLECTANCE
+  #include "Reflectance.h"
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  #include "Motor.h"
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  #include "HwProfile.h"
+#endif
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  #include "Tacho.h"
+#endif
+#if PL_CONFIG_HAS_PID
+  #include "Pid.h"
+#endif
+#if PL_CONFIG_HAS_DRIVE
+  #include "Drive.h"
+#endif
+#if PL_CONFIG_HAS_TURN
+  #include "Turn.h"
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  #include "LineFollow.h"
+#endif
+#if PL_HAS_DISTANCE_SENSOR
+  #include "Distance.h"
+#endif
+#if PL_CONFIG_HAS_SUMO
+  #include "Sumo.h"
+#endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  #include "ArenaLoc.h"
+#endif
+#if PL_CONFIG_HAS_LINE_MAZE
+  #include "Maze.h"
+#endif
+#if PL_CONFIG_HAS_RECORDER
+  #include "Recorder.h"
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  #include "Obstacle.h"
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  #include "RtosTrace.h"
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  #include "SpeedPlan.h"
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  #include "TrackMap.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  #include "LapTime.h"
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  #include "ControlLoop.h"
+#endif
+
+#define MAIN_MAX_CMDS        32
+#define MAIN_MAX_SWEEPS      4
+#define MAIN_MAX_SWEEP_VALS  64
+#define MAIN_MAX_CMD_LEN     128 /* shell command including the terminating zero */
+#define MAIN_RESULT_SIZE     256
+
+typedef enum {
+  MAIN_MODE_DEFAULT,
+  MAIN_MODE_FOLLOW,
+  MAIN_MODE_SUMO,
+  MAIN_MODE_IDLE
+} MAIN_Mode;
+
+typedef struct {
+  char prefix[MAIN_MAX_CMD_LEN], suffix[MAIN_MAX_CMD_LEN];
+  int nofVals;
+  double vals[MAIN_MAX_SWEEP_VALS];
+} MAIN_Sweep;
+
+/* defaults for the line following PID, the robot has them in its configuration (all zero in Pid.c) */
+static const char *const MAIN_DefaultCmds[] = {
+  "pid fw p 1000",
+  "pid fw d 5000",
+  "pid fw w 1000",
+  "pid fw speed 30",
+};
+
+static const char *MAIN_World = "oval";
+static MAIN_Mode MAIN_RunMode = MAIN_MODE_DEFAULT;
+static int MAIN_Seconds = 30;
+static unsigned MAIN_Laps = 0;
+static const char *MAIN_Cmds[MAIN_MAX_CMDS];
+static int MAIN_NofCmds = 0;
+static MAIN_Sweep MAIN_Sweeps[MAIN_MAX_SWEEPS];
+static int MAIN_NofSweeps = 0;
+static const char *MAIN_DumpFile = NULL;
+static const char *MAIN_ReplayFile = NULL;
+static const char *MAIN_TraceFile = NULL;
+
+static void Usage(void) {
+  (void)fprintf(stderr, "usage: sim [-w world] [-m follow|sumo|idle] [-t seconds] [-l laps] [-c cmd]... [-s sweep]... [-j jobs] [-d file] [-r file] [-T file] [-a file] [-b bench] [-v]\n");
+  exit(EXIT_FAILURE);
+}
+
+static void ParseSweep(const char *arg) {
+  MAIN_Sweep *s = &MAIN_Sweeps[MAIN_NofSweeps];
+  const char *open = strchr(arg, '{'), *close = strchr(arg, '}');
+  double from, to, step, v;
+
+  if (MAIN_NofSweeps>=MAIN_MAX_SWEEPS || open==NULL || close==NULL || close<open
+      || sscanf(open+1, "%lf:%lf:%lf", &from, &to, &step)!=3 || step<=0.0
+      || (size_t)(open-arg)+strlen(close+1)>=MAIN_MAX_CMD_LEN) {
+    (void)fprintf(stderr, "wrong sweep '%s'\n", arg);
+    Usage();
+  }
+  (void)snprintf(s->prefix, sizeof(s->prefix), "%.*s", (int)(open-arg), arg);
+  (void)snprintf(s->suffix, sizeof(s->suffix), "%s", close+1);
+  s->nofVals = 0;
+  for(v=from; v<=to+step*1e-6; v+=step) {
+    if (s->nofVals>=MAIN_MAX_SWEEP_VALS) {
+      (void)fprintf(stderr, "wrong sweep '%s': more than %d values\n", arg, MAIN_MAX_SWEEP_VALS);
+      Usage();
+    }
+    s->vals[s->nofVals++] = v;
+  }
+  MAIN_NofSweeps++;
+}
+
+static void ParseCmd(const char *cmd) {
+  uint8_t buf[MAIN_MAX_CMD_LEN];
+
+  UTIL1_strcpy(buf, sizeof(buf), (const unsigned char*)cmd);
+  SHELL_ParseCmd(buf);
+}
+
+static void InitModules(void) {
+  SIM_Init();
+  SHELL_Init();
+#if PL_CONFIG_HAS_RTOS_TRACE
+  RTRC_Init();
+#endif
+#if PL_CONFIG_HAS_REFLECTANCE
+  REF_Init();
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  MOT_Init();
+#endif
+#if PL_CONFIG_HAS_HW_PROFILE
+  HWP_Init();
+#endif
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  TACHO_Init();
+#endif
+#if PL_CONFIG_HAS_PID
+  PID_Init();
+#endif
+#if PL_CONFIG_HAS_DRIVE
+  DRV_Init();
+#endif
+#if PL_CONFIG_HAS_TURN
+  TURN_Init();
+#endif
+#if PL_CONFIG_HAS_LINE_MAZE
+  MAZE_Init();
+#endif
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  LF_Init();
+#endif
+#if PL_CONFIG_HAS_SPEED_PLAN
+  SPLAN_Init();
+#endif
+#if PL_CONFIG_HAS_TRACK_MAP
+  TMAP_Init(); /* after the planner, which plans the profile of a stored map */
+#endif
+#if PL_CONFIG_HAS_LAP_TIME
+  LAPT_Init();
+#endif
+#if PL_CONFIG_HAS_CONTROL_LOOP
+  CTRL_Init();
+#endif
+#if PL_CONFIG_HAS_OBSTACLE_MAP
+  OBST_Init();
+#endif
+#if PL_HAS_DISTANCE_SENSOR
+  DIST_Init();
+#endif
+#if PL_CONFIG_HAS_SUMO
+  SUMO_Init();
+#endif
+#if PL_CONFIG_HAS_ARENA_LOC
+  ALOC_Init();
+#endif
+#if PL_CONFIG_HAS_RECORDER
+  REC_Init();
+#endif
+}
+
+/* applies the default and the command line shell commands */
+static void ApplyCmds(void) {
+  int i;
+
+  for(i=0;i<(int)(sizeof(MAIN_DefaultCmds)/sizeof(MAIN_DefaultCmds[0]));i++) {
+    ParseCmd(MAIN_DefaultCmds[i]);
+  }
+  for(i=0;i<MAIN_NofCmds;i++) {
+    ParseCmd(MAIN_Cmds[i]);
+  }
+}
+
+/* starts line following or sumo */
+static void StartMode(MAIN_Mode mode) {
+  if (mode==MAIN_MODE_FOLLOW) {
+#if PL_CONFIG_HAS_LINE_FOLLOW
+    LF_StartFollowing();
+#endif
+  } else if (mode==MAIN_MODE_SUMO) {
+#if PL_CONFIG_HAS_SUMO
+    SUMO_StartSumo();
+#endif
+  }
+}
+
+/* returns TRUE while line following or sumo is running, as seen by the recorder */
+static bool IsRunning(void) {
+#if PL_CONFIG_HAS_LINE_FOLLOW
+  if (LF_IsFollowing()) {
+    return TRUE;
+  }
+#endif
+#if PL_CONFIG_HAS_SUMO
+  if (SUMO_IsRunningSumo()) {
+    return TRUE;
+  }
+#endif
+  return FALSE;
+}
+
+#if PL_CONFIG_HAS_RECORDER
+static FILE *MAIN_DumpFp;
+
+static void DumpSendChar(uint8_t ch) {
+  if (ch!='\r') {
+    (void)fputc(ch, MAIN_DumpFp);
+  }
+}
+
+/* writes the recording of the run with the 'rec dump' command of the robot */
+static void WriteDump(void) {
+  static CLS1_ConstStdIOType io = { .stdOut = DumpSendChar, .stdErr = DumpSendChar };
+  bool handled = FALSE;
+
+  MAIN_DumpFp = fopen(MAIN_DumpFile, "w");
+  if (MAIN_DumpFp==NULL) {
+    perror(MAIN_DumpFile);
+    return;
+  }
+  (void)REC_ParseCommand((const unsigned char*)"rec dump", &handled, &io);
+  (void)fclose(MAIN_DumpFp);
+}
+#endif
+
+#if PL_CONFIG_HAS_HW_PROFILE
+/* runs a self-test requested with -c "hwp calibrate" from the start pose: it drives the robot, which must not be held */
+static void SelfTest(void) {
+  double x, y, theta;
+  TickType_t end;
+
+  if (!HWP_IsCalibrating()) {
+    return;
+  }
+  SIM_GetStartPose(&x, &y, &theta);
+  SIM_SetPose(x, y, theta);
+  end = xTaskGetTickCount()+10000;
+  while (HWP_IsCalibrating() && xTaskGetTickCount()<end) {
+    SIMRTOS_RunUntil(xTaskGetTickCount()+10, NULL);
+  }
+}
+#endif
+
+/* moves the held robot across the line (or the arena border) while the reflectance sensors calibrate */
+static bool Calibrate(void) {
+#if PL_CONFIG_HAS_REFLECTANCE
+  double x, y, theta;
+  TickType_t end;
+  int i;
+
+  SIM_Hold(TRUE);
+  SIMRTOS_RunUntil(xTaskGetTickCount()+100, NULL); /* let the reflectance task start up */
+  REF_CalibrateStartStop();
+  for(i=0;i<=100;i++) {
+    SIM_GetCalibPose(i/100.0, &x, &y, &theta);
+    SIM_SetPose(x, y, theta);
+    SIMRTOS_RunUntil(xTaskGetTickCount()+10, NULL);
+  }
+  REF_CalibrateStartStop();
+  end = xTaskGetTickCount()+1000;
+  while (!REF_IsReady() && xTaskGetTickCount()<end) {
+    SIMRTOS_RunUntil(xTaskGetTickCount()+10, NULL);
+  }
+  SIM_Hold(FALSE);
+  return REF_IsReady();
+#else
+  return TRUE;
+#endif
+}
+
+/* runs one simulation with the given sweep values, writes the CSV result columns */
+static void RunOnce(const double *sweepVals, char *result, size_t resultSize) {
+  char cmd[MAIN_MAX_CMD_LEN];
+  double x, y, theta;
+  const SIM_Metrics *m;
+  TickType_t end;
+  MAIN_Mode mode;
+  int i;
+
+  InitModules();
+  ApplyCmds();
+  for(i=0;i<MAIN_NofSweeps;i++) {
+    if (snprintf(cmd, sizeof(cmd), "%s%g%s", MAIN_Sweeps[i].prefix, sweepVals[i], MAIN_Sweeps[i].suffix)>=(int)sizeof(cmd)) {
+      (void)snprintf(result, resultSize, "error: sweep command too long");
+      return;
+    }
+    ParseCmd(cmd);
+  }
+  if (SIM_LoadWorld(MAIN_World)!=ERR_OK) {
+    (void)snprintf(result, resultSize, "error: cannot load world '%s'", MAIN_World);
+    return;
+  }
+  mode = MAIN_RunMode;
+  if (mode==MAIN_MODE_DEFAULT) {
+    mode = SIM_IsArena() ? MAIN_MODE_SUMO : MAIN_MODE_FOLLOW;
+  }
+#if PL_CONFIG_HAS_HW_PROFILE
+  SelfTest(); /* before the calibration holds the robot */
+#endif
+  if (!Calibrate()) {
+    (void)snprintf(result, resultSize, "error: reflectance calibration failed");
+    return;
+  }
+  SIM_GetStartPose(&x, &y, &theta);
+  SIM_SetPose(x, y, theta);
+  SIMRTOS_RunUntil(xTaskGetTickCount()+50, NULL); /* settle the filters at the start pose */
+  SIM_StartMetrics();
+#if PL_CONFIG_HAS_RECORDER
+  if (MAIN_DumpFile!=NULL) {
+    REC_Arm(TRUE);
+  }
+#endif
+#if PL_CONFIG_HAS_RTOS_TRACE
+  if (MAIN_TraceFile!=NULL) {
+    RTRC_SetHostFile(MAIN_TraceFile);
+    RTRC_Start();
+  }
+#endif
+  StartMode(mode);
+  end = xTaskGetTickCount()+MAIN_Seconds*1000;
+  while (xTaskGetTickCount()<end && !SIM_Stop) {
+    SIMRTOS_RunUntil(xTaskGetTickCount()+10, &SIM_Stop);
+    if (MAIN_Laps>0 && SIM_GetMetrics()->nofLaps>=MAIN_Laps) {
+      break;
+    }
+  }
+#if PL_CONFIG_HAS_RTOS_TRACE
+  if (MAIN_TraceFile!=NULL) {
+    RTRC_Stop();
+    SIMRTOS_RunUntil(xTaskGetTickCount()+20, NULL); /* the trace task writes the rest and closes the file */
+  }
+#endif
+#if PL_CONFIG_HAS_RECORDER
+  if (MAIN_DumpFile!=NULL) {
+    WriteDump();
+  }
+#endif
+  m = SIM_GetMetrics();
+  if (SIM_IsArena()) {
+    (void)snprintf(result, resultSize, "%u,%u,%u,%.3f,%u",
+      (unsigned)m->timeMs, (unsigned)m->opponentOut, (unsigned)m->opponentOutMs, m->distance, (unsigned)m->lost);
+  } else {
+    (void)snprintf(result, resultSize, "%u,%u,%u,%u,%.2f,%.2f,%.1f,%.3f,%u",
+      (unsigned)m->timeMs, (unsigned)m->nofLaps, (unsigned)m->bestLapMs, (unsigned)(m->nofLaps>0 ? m->lapMs[0] : 0),
+      m->nofErrSamples>0 ? 1000.0*sqrt(m->errSumSq/m->nofErrSamples) : 0.0, 1000.0*m->errMax,
+      m->timeMs>0 ? 100.0*m->offLineMs/m->timeMs : 0.0, m->distance, (unsigned)m->lost);
+  }
+}
+
+/* feeds a recording into the robot modules and prints their outputs every 10 ms */
+static int Replay(void) {
+  uint16_t min[REPLAY_NOF_IR], max[REPLAY_NOF_IR];
+  TickType_t start;
+
+  if (REPLAY_Load(MAIN_ReplayFile)!=ERR_OK) {
+    (void)fprintf(stderr, "cannot load recording '%s'\n", MAIN_ReplayFile);
+    return EXIT_FAILURE;
+  }
+  InitModules();
+  ApplyCmds();
+#if PL_CONFIG_HAS_REFLECTANCE
+  REPLAY_GetCalibration(min, max);
+  REF_SetCalibration(min, max, REPLAY_NOF_IR);
+#endif
+  SIMRTOS_RunUntil(xTaskGetTickCount()+50, NULL); /* settle the filters with the first frame */
+  StartMode(MAIN_RunMode==MAIN_MODE_DEFAULT ? MAIN_MODE_FOLLOW : MAIN_RunMode);
+  /* an armed recording starts when the run is running (sumo waits 5 s after the start): play from there */
+  start = xTaskGetTickCount()+10000;
+  while (!IsRunning() && xTaskGetTickCount()<start) {
+    SIMRTOS_RunUntil(xTaskGetTickCount()+1, NULL);
+  }
+  start = xTaskGetTickCount();
+  REPLAY_Start(start);
+  (void)printf("time_ms,frame,line,line_kind,speed_l,speed_r,motor_l,motor_r\n");
+  while (!SIM_Stop) {
+    SIMRTOS_RunUntil(xTaskGetTickCount()+10, &SIM_Stop);
+    (void)printf("%u,%d", (unsigned)(xTaskGetTickCount()-start), REPLAY_CurrentFrame());
+#if PL_CONFIG_HAS_REFLECTANCE
+    (void)printf(",%u,%d", REF_GetLineValue(), (int)REF_GetLineKind());
+#endif
+#if PL_CONFIG_HAS_MOTOR_TACHO
+    (void)printf(",%d,%d", (int)TACHO_GetSpeed(TRUE), (int)TACHO_GetSpeed(FALSE));
+#endif
+    (void)printf(",%.1f,%.1f\n", 100.0*SIMHW_GetMotorInput(SIMHW_LEFT), 100.0*SIMHW_GetMotorInput(SIMHW_RIGHT));
+  }
+  return EXIT_SUCCESS;
+}
+
+static void PrintHeader(void) {
+  int i;
+
+  (void)printf("run");
+  for(i=0;i<MAIN_NofSweeps;i++) {
+    (void)printf(",\"%s{}%s\"", MAIN_Sweeps[i].prefix, MAIN_Sweeps[i].suffix);
+  }
+  if (strcmp(MAIN_World, "arena")==0) {
+    (void)printf(",time_ms,opponent_out,opponent_out_ms,distance_m,lost\n");
+  } else {
+    (void)printf(",time_ms,laps,best_lap_ms,first_lap_ms,rms_err_mm,max_err_mm,off_line_pct,distance_m,lost\n");
+  }
+}
+
+/* returns the sweep values of a run: combination index to one value of each sweep */
+static void SweepValues(int run, double *vals) {
+  int i;
+
+  for(i=MAIN_NofSweeps-1;i>=0;i--) {
+    vals[i] = MAIN_Sweeps[i].vals[run%MAIN_Sweeps[i].nofVals];
+    run /= MAIN_Sweeps[i].nofVals;
+  }
+}
+
+static void PrintRun(int run, const char *result) {
+  double vals[MAIN_MAX_SWEEPS];
+  int i;
+
+  SweepValues(run, vals);
+  (void)printf("%d", run);
+  for(i=0;i<MAIN_NofSweeps;i++) {
+    (void)printf(",%g", vals[i]);
+  }
+  (void)printf(",%s\n", result);
+  (void)fflush(stdout);
+}
+
+/* runs all combinations in child processes (the RTOS emulation is not re-entrant), jobs at a time */
+static void RunAll(int nofRuns, int jobs) {
+  char (*results)[MAIN_RESULT_SIZE];
+  pid_t *pids;
+  int *fds, next = 0, printed = 0, running = 0, fd[2];
+  ssize_t n;
+
+  results = calloc(nofRuns, sizeof(*results));
+  pids = calloc(nofRuns, sizeof(*pids));
+  fds = calloc(nofRuns, sizeof(*fds));
+  if (results==NULL || pids==NULL || fds==NULL) {
+    (void)fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  while (printed<nofRuns) {
+    while (running<jobs && next<nofRuns) {
+      if (pipe(fd)!=0) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+      }
+      (void)fflush(stdout);
+      pids[next] = fork();
+      if (pids[next]==0) { /* child */
+        double vals[MAIN_MAX_SWEEPS];
+        char result[MAIN_RESULT_SIZE];
+
+        close(fd[0]);
+        SweepValues(next, vals);
+        RunOnce(vals, result, sizeof(result));
+        (void)write(fd[1], result, strlen(result)+1);
+        _exit(EXIT_SUCCESS);
+      }
+      close(fd[1]);
+      fds[next] = fd[0];
+      next++;
+      running++;
+    }
+    /* collect the oldest run, so the output is in order */
+    n = read(fds[printed], results[printed], MAIN_RESULT_SIZE-1);
+    if (n<=0) {
+      (void)snprintf(results[printed], MAIN_RESULT_SIZE, "error: run crashed");
+    }
+    close(fds[printed]);
+    (void)waitpid(pids[printed], NULL, 0);
+    PrintRun(printed, results[printed]);
+    printed++;
+    running--;
+  }
+  free(results);
+  free(pids);
+  free(fds);
+}
+
+int main(int argc, char *argv[]) {
+  int opt, jobs = 1, nofRuns = 1, i;
+
+  while ((opt = getopt(argc, argv, "w:m:t:l:c:s:j:d:r:T:a:b:v"))!=-1) {
+    switch(opt) {
+      case 'w': MAIN_World = optarg; break;
+      case 'm':
+        if (strcmp(optarg, "follow")==0) {
+          MAIN_RunMode = MAIN_MODE_FOLLOW;
+        } else if (strcmp(optarg, "sumo")==0) {
+          MAIN_RunMode = MAIN_MODE_SUMO;
+        } else if (strcmp(optarg, "idle")==0) {
+          MAIN_RunMode = MAIN_MODE_IDLE;
+        } else {
+          Usage();
+        }
+        break;
+      case 't': MAIN_Seconds = atoi(optarg); break;
+      case 'l': MAIN_Laps = (unsigned)atoi(optarg); break;
+      case 'c':
+        if (MAIN_NofCmds>=MAIN_MAX_CMDS || strlen(optarg)>=MAIN_MAX_CMD_LEN) {
+          Usage();
+        }
+        MAIN_Cmds[MAIN_NofCmds++] = optarg;
+        break;
+      case 's': ParseSweep(optarg); break;
+      case 'j': jobs = atoi(optarg); break;
+      case 'd': MAIN_DumpFile = optarg; break;
+      case 'r': MAIN_ReplayFile = optarg; break;
+      case 'T': MAIN_TraceFile = optarg; break;
+      case 'a':
+        if (TSTAT_Analyze(optarg, stdout)!=ERR_OK) {
+          (void)fprintf(stderr, "cannot read trace '%s'\n", optarg);
+          return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+      case 'b':
+        return BENCH_Run(optarg, stdout)==ERR_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+      case 'v': SIM_Verbose = TRUE; break;
+      default: Usage();
+    }
+  }
+  if (jobs<1) {
+    jobs = 1;
+  }
+  for(i=0;i<MAIN_NofSweeps;i++) {
+    nofRuns *= MAIN_Sweeps[i].nofVals;
+  }
+  if (MAIN_ReplayFile!=NULL) {
+    if (nofRuns>1) {
+      Usage(); /* one replay at a time: use -c for the parameters */
+    }
+    return Replay();
+  }
+  if ((MAIN_DumpFile!=NULL || MAIN_TraceFile!=NULL) && nofRuns>1) {
+    Usage(); /* the runs would overwrite the dump or the trace */
+  }
+  PrintHeader();
+  RunAll(nofRuns, jobs);
+  return EXIT_SUCCESS;
+}